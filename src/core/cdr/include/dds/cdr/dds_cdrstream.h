@@ -109,6 +109,23 @@ typedef struct dds_cdrstream_desc_op_seq {
   uint32_t *ops;    /* Marshalling meta data */
 } dds_cdrstream_desc_op_seq_t;
 
+/**
+ * @brief Type-specific implementations of the serializer operations
+ *
+ * These are generated by idlc (option "-f type-serdes") for types that are simple enough,
+ * and are used instead of interpreting the serializer ops. They produce and accept exactly
+ * the same CDR as the interpreter, but only ever write in native endianness. Any of them
+ * may be a null pointer, in which case the interpreter is used for that operation.
+ */
+struct dds_cdrstream_funcs {
+  bool (*write_sample) (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict data);
+  void (*read_sample) (dds_istream_t * __restrict is, void * __restrict data, const struct dds_cdrstream_allocator * __restrict allocator);
+  bool (*normalize) (void * __restrict data, uint32_t size, bool bswap, uint32_t xcdr_version, uint32_t * __restrict actual_size);
+  size_t (*getsize_sample) (const void * __restrict data, uint32_t xcdr_version);
+  bool (*write_key) (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict data); /* key-only sample, definition order */
+  bool (*extract_key_from_data) (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator);
+};
+
 struct dds_cdrstream_desc {
   uint32_t size;    /* Size of type */
   uint32_t align;   /* Alignment of top-level type */
@@ -117,6 +134,7 @@ struct dds_cdrstream_desc {
   dds_cdrstream_desc_op_seq_t ops;
   size_t opt_size_xcdr1;
   size_t opt_size_xcdr2;
+  const struct dds_cdrstream_funcs *funcs; /* Type-specific serializer functions or NULL */
 };
 
 
@@ -150,6 +168,12 @@ DDS_EXPORT void dds_ostreamBE_init (dds_ostreamBE_t * __restrict os, const struc
 /** @component cdr_serializer */
 DDS_EXPORT void dds_ostreamBE_fini (dds_ostreamBE_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator);
 
+/**
+ * @brief Grows the buffer of an output stream so that at least size bytes can be appended
+ * @component cdr_serializer
+ */
+DDS_EXPORT void dds_ostream_grow (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t size);
+
 /** @component cdr_serializer */
 dds_ostream_t dds_ostream_from_buffer(void *buffer, size_t size, uint16_t write_encoding_version);
 
@@ -213,6 +237,21 @@ DDS_EXPORT uint32_t dds_stream_countops (const uint32_t * __restrict ops, uint32
 /** @component cdr_serializer */
 size_t dds_stream_check_optimize (const struct dds_cdrstream_desc * __restrict desc, uint32_t xcdr_version);
 
+/** @brief Maximum nesting depth of a member referenced by a @ref dds_cdrstream_member_path */
+#define DDS_CDRSTREAM_MEMBER_PATH_MAX 8
+
+/**
+ * @brief A (possibly nested) member of a type
+ *
+ * For each level of nesting, the index in the type's serializer ops of the ADR instruction
+ * for the member. Members inherited from a base type are treated as members of the derived
+ * type, and so the ADR instruction for the base type never appears in a path.
+ */
+struct dds_cdrstream_member_path {
+  uint32_t n;
+  uint32_t adr[DDS_CDRSTREAM_MEMBER_PATH_MAX];
+};
+
 /** @component cdr_serializer */
 bool dds_stream_write_key (dds_ostream_t * __restrict os, enum dds_cdr_key_serialization_kind ser_kind, const struct dds_cdrstream_allocator * __restrict allocator, const char * __restrict sample, const struct dds_cdrstream_desc * __restrict desc)
   ddsrt_attribute_warn_unused_result;
@@ -241,6 +280,63 @@ DDS_EXPORT const uint32_t *dds_stream_read (dds_istream_t * __restrict is, char
 /** @component cdr_serializer */
 DDS_EXPORT void dds_stream_read_key (dds_istream_t * __restrict is, char * __restrict sample, const struct dds_cdrstream_allocator * __restrict allocator, const struct dds_cdrstream_desc * __restrict desc);
 
+/**
+ * @brief Find the ADR instruction of a member of an aggregated type
+ *
+ * @param[in] ops        instructions of the aggregated type
+ * @param[in] index      index of the member in declaration order, not counting inherited members
+ *                       (used for final and appendable types)
+ * @param[in] member_id  member id (used for mutable types)
+ * @returns pointer to the ADR instruction, or a null pointer if there is no such member
+ *
+ * @component cdr_serializer
+ */
+DDS_EXPORT const uint32_t *dds_stream_member_adr (const uint32_t * __restrict ops, uint32_t index, uint32_t member_id);
+
+/**
+ * @brief Find the instructions of the base type of an aggregated type
+ *
+ * @param[in] ops  instructions of the aggregated type
+ * @returns pointer to the instructions of the base type, or a null pointer if it has none
+ *
+ * @component cdr_serializer
+ */
+DDS_EXPORT const uint32_t *dds_stream_base_type_ops (const uint32_t * __restrict ops);
+
+/**
+ * @brief Locate members in a serialized sample without deserializing it
+ *
+ * Walks the (normalized) serialized sample, skipping over everything but the members of
+ * interest, and stops as soon as all have been found.
+ *
+ * @param[in] is         input stream positioned at the start of the sample
+ * @param[in] desc       type descriptor
+ * @param[in] nmembers   number of members to locate, at most 64
+ * @param[in] members    the members to locate, all of which must be of a primitive, enum or
+ *                       string type
+ * @param[out] offsets   for each member, the offset in the stream's buffer of the value (for
+ *                       strings: of the length), or UINT32_MAX if not present in the data
+ *
+ * @component cdr_serializer
+ */
+DDS_EXPORT void dds_stream_locate_members (dds_istream_t * __restrict is, const struct dds_cdrstream_desc * __restrict desc, uint32_t nmembers, const struct dds_cdrstream_member_path * __restrict members, uint32_t * __restrict offsets)
+  ddsrt_nonnull_all;
+
+/**
+ * @brief Address of a member in a deserialized sample
+ *
+ * @param[in] sample  the sample
+ * @param[in] desc    type descriptor
+ * @param[in] member  the member
+ * @returns address of the member's value (for an unbounded string: of the pointer to it), or a
+ *   null pointer if it or a member containing it is an optional or external member that is not
+ *   present
+ *
+ * @component cdr_serializer
+ */
+DDS_EXPORT const void *dds_stream_member_address (const void * __restrict sample, const struct dds_cdrstream_desc * __restrict desc, const struct dds_cdrstream_member_path * __restrict member)
+  ddsrt_nonnull_all;
+
 /** @component cdr_serializer */
 DDS_EXPORT size_t dds_stream_print_key (dds_istream_t * __restrict is, const struct dds_cdrstream_desc * __restrict desc, char * __restrict buf, size_t size);
 
@@ -0,0 +1,390 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDS_CDRSTREAM_GEN_H
+#define DDS_CDRSTREAM_GEN_H
+
+#include <string.h>
+#include "dds/ddsrt/bswap.h"
+#include "dds/cdr/dds_cdrstream.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Building blocks for the type-specific serializers generated by idlc with "-f type-serdes"
+   (see struct dds_cdrstream_funcs). These mirror the primitives used by the interpreter of the
+   serializer ops in dds_cdrstream.c and must remain equivalent to those: the generated code
+   and the interpreter are used interchangeably.
+
+   All of these operate in native endianness. The normalize functions assume the input size
+   has been checked against the limit that dds_stream_normalize enforces, so that aligning the
+   offset and adding the size of a primitive can't overflow. */
+
+/** @component cdr_serializer */
+static inline uint32_t dds_stream_gen_align (uint32_t xcdr_version, uint32_t size)
+{
+  /* 8-byte types are aligned to 4 bytes in XCDR2 */
+  return (size > 4 && xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_2) ? 4 : size;
+}
+
+/** @component cdr_serializer */
+static inline unsigned char *dds_stream_gen_os_reserve (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t align, uint32_t size)
+{
+  const uint32_t pad = (align - (os->m_index & (align - 1))) & (align - 1);
+  if (os->m_size < os->m_index + pad + size)
+    dds_ostream_grow (os, allocator, pad + size);
+  for (uint32_t i = 0; i < pad; i++)
+    os->m_buffer[os->m_index++] = 0;
+  unsigned char *dst = os->m_buffer + os->m_index;
+  os->m_index += size;
+  return dst;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_write_prim (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict src, uint32_t size)
+{
+  memcpy (dds_stream_gen_os_reserve (os, allocator, dds_stream_gen_align (os->m_xcdr_version, size), size), src, size);
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_write_bool (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict src)
+{
+  *dds_stream_gen_os_reserve (os, allocator, 1, 1) = (*(const unsigned char *) src != 0);
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_write_array (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict src, uint32_t size, uint32_t num)
+{
+  memcpy (dds_stream_gen_os_reserve (os, allocator, dds_stream_gen_align (os->m_xcdr_version, size), num * size), src, num * size);
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_write_bool_array (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict src, uint32_t num)
+{
+  unsigned char *dst = dds_stream_gen_os_reserve (os, allocator, 1, num);
+  for (uint32_t i = 0; i < num; i++)
+    dst[i] = (((const unsigned char *) src)[i] != 0);
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_write_string (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const char * __restrict val)
+{
+  /* a null pointer is serialized as an empty string */
+  const uint32_t size = val ? (uint32_t) strlen (val) + 1 : 1;
+  dds_stream_gen_write_prim (os, allocator, &size, 4);
+  unsigned char *dst = dds_stream_gen_os_reserve (os, allocator, 1, size);
+  if (val)
+    memcpy (dst, val, size);
+  else
+    dst[0] = 0;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_write_seq (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const dds_sequence_t * __restrict seq, uint32_t size, uint32_t bound, bool is_bool)
+{
+  const uint32_t num = seq->_length;
+  if ((bound && num > bound) || (num > 0 && seq->_buffer == NULL))
+    return false;
+  dds_stream_gen_write_prim (os, allocator, &num, 4);
+  if (num == 0)
+    return true;
+  if (is_bool)
+    dds_stream_gen_write_bool_array (os, allocator, seq->_buffer, num);
+  else
+    dds_stream_gen_write_array (os, allocator, seq->_buffer, size, num);
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_is_align (dds_istream_t * __restrict is, uint32_t size)
+{
+  const uint32_t a = dds_stream_gen_align (is->m_xcdr_version, size);
+  is->m_index = (is->m_index + a - 1) & ~(a - 1);
+}
+
+/** @component cdr_serializer */
+static inline uint32_t dds_stream_gen_read_uint32 (dds_istream_t * __restrict is)
+{
+  uint32_t v;
+  dds_stream_gen_is_align (is, 4);
+  memcpy (&v, is->m_buffer + is->m_index, 4);
+  is->m_index += 4;
+  return v;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_read_array (dds_istream_t * __restrict is, void * __restrict dst, uint32_t size, uint32_t num)
+{
+  dds_stream_gen_is_align (is, size);
+  memcpy (dst, is->m_buffer + is->m_index, num * size);
+  is->m_index += num * size;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_read_prim (dds_istream_t * __restrict is, void * __restrict dst, uint32_t size)
+{
+  dds_stream_gen_read_array (is, dst, size, 1);
+}
+
+/** @component cdr_serializer */
+static inline char *dds_stream_gen_read_string (dds_istream_t * __restrict is, char * __restrict str, const struct dds_cdrstream_allocator * __restrict allocator)
+{
+  const uint32_t length = dds_stream_gen_read_uint32 (is);
+  const void *src = is->m_buffer + is->m_index;
+  is->m_index += length;
+  if (str != NULL)
+  {
+    if (length == 1 && str[0] == '\0')
+      return str;
+    allocator->free (str);
+  }
+  str = allocator->malloc (length);
+  memcpy (str, src, length);
+  return str;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_read_bstring (dds_istream_t * __restrict is, char * __restrict str, uint32_t size)
+{
+  const uint32_t length = dds_stream_gen_read_uint32 (is);
+  memcpy (str, is->m_buffer + is->m_index, length > size ? size : length);
+  if (length > size)
+    str[size - 1] = '\0';
+  is->m_index += length;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_read_seq (dds_istream_t * __restrict is, dds_sequence_t * __restrict seq, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t size)
+{
+  const uint32_t num = dds_stream_gen_read_uint32 (is);
+  if (num == 0)
+  {
+    seq->_length = 0;
+    return;
+  }
+  if (seq->_length > seq->_maximum)
+    seq->_maximum = seq->_length;
+  if (num > seq->_maximum && (seq->_release || seq->_maximum == 0))
+  {
+    allocator->free (seq->_buffer);
+    seq->_buffer = allocator->malloc (num * size);
+    seq->_release = true;
+    seq->_maximum = num;
+  }
+  seq->_length = (num <= seq->_maximum) ? num : seq->_maximum;
+  dds_stream_gen_read_array (is, seq->_buffer, size, seq->_length);
+  is->m_index += (num - seq->_length) * size;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_skip (dds_istream_t * __restrict is, uint32_t size, uint32_t num)
+{
+  dds_stream_gen_is_align (is, size);
+  is->m_index += num * size;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_skip_string (dds_istream_t * __restrict is)
+{
+  const uint32_t length = dds_stream_gen_read_uint32 (is);
+  is->m_index += length;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_skip_seq (dds_istream_t * __restrict is, uint32_t size)
+{
+  const uint32_t num = dds_stream_gen_read_uint32 (is);
+  if (num > 0)
+    dds_stream_gen_skip (is, size, num);
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_copy_prim (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t size)
+{
+  dds_stream_gen_is_align (is, size);
+  dds_stream_gen_write_prim (os, allocator, is->m_buffer + is->m_index, size);
+  is->m_index += size;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_copy_string (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator)
+{
+  const uint32_t length = dds_stream_gen_read_uint32 (is);
+  dds_stream_gen_write_prim (os, allocator, &length, 4);
+  memcpy (dds_stream_gen_os_reserve (os, allocator, 1, length), is->m_buffer + is->m_index, length);
+  is->m_index += length;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_check_align (uint32_t * __restrict off, uint32_t size, uint32_t xcdr_version, uint32_t elem_size, uint32_t num)
+{
+  const uint32_t a = dds_stream_gen_align (xcdr_version, elem_size);
+  const uint32_t off1 = (*off + a - 1) & ~(a - 1);
+  if (size < off1 || (size - off1) / elem_size < num)
+    return false;
+  *off = off1;
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_swap (char * __restrict data, uint32_t size, uint32_t num)
+{
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+  {
+    dds_stream_simd_bswap (data, size, num);
+    return;
+  }
+  switch (size)
+  {
+    case 2:
+      for (uint32_t i = 0; i < num; i++)
+      {
+        uint16_t x;
+        memcpy (&x, data + 2 * i, 2);
+        x = ddsrt_bswap2u (x);
+        memcpy (data + 2 * i, &x, 2);
+      }
+      break;
+    case 4:
+      for (uint32_t i = 0; i < num; i++)
+      {
+        uint32_t x;
+        memcpy (&x, data + 4 * i, 4);
+        x = ddsrt_bswap4u (x);
+        memcpy (data + 4 * i, &x, 4);
+      }
+      break;
+    case 8:
+      for (uint32_t i = 0; i < num; i++)
+      {
+        uint64_t x;
+        memcpy (&x, data + 8 * i, 8);
+        x = ddsrt_bswap8u (x);
+        memcpy (data + 8 * i, &x, 8);
+      }
+      break;
+  }
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_normalize_array (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t xcdr_version, uint32_t elem_size, uint32_t num)
+{
+  if (!dds_stream_gen_check_align (off, size, xcdr_version, elem_size, num))
+    return false;
+  if (bswap && elem_size > 1)
+    dds_stream_gen_swap (data + *off, elem_size, num);
+  *off += num * elem_size;
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_normalize_prim (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t xcdr_version, uint32_t elem_size)
+{
+  return dds_stream_gen_normalize_array (data, off, size, bswap, xcdr_version, elem_size, 1);
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_read_normalize_uint32 (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
+{
+  if (!dds_stream_gen_normalize_prim (data, off, size, bswap, DDSI_RTPS_CDR_ENC_VERSION_2, 4))
+    return false;
+  memcpy (val, data + *off - 4, 4);
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_normalize_bool_array (char * __restrict data, uint32_t * __restrict off, uint32_t size, uint32_t num)
+{
+  /* booleans in structs and arrays get their representation of true corrected */
+  if (size - *off < num)
+    return false;
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+    dds_stream_simd_clamp_bool ((uint8_t *) data + *off, num);
+  else
+  {
+    for (uint32_t i = 0; i < num; i++)
+      if ((unsigned char) data[*off + i] > 1)
+        data[*off + i] = 1;
+  }
+  *off += num;
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_normalize_string (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t maxsz)
+{
+  uint32_t sz;
+  if (!dds_stream_gen_read_normalize_uint32 (&sz, data, off, size, bswap))
+    return false;
+  if (sz == 0 || size - *off < sz || maxsz < sz || data[*off + sz - 1] != 0)
+    return false;
+  *off += sz;
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline bool dds_stream_gen_normalize_seq (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t xcdr_version, uint32_t elem_size, uint32_t bound, bool is_bool)
+{
+  uint32_t num;
+  if (!dds_stream_gen_read_normalize_uint32 (&num, data, off, size, bswap))
+    return false;
+  if (num == 0)
+    return true;
+  if (bound && num > bound)
+    return false;
+  if (!is_bool)
+    return dds_stream_gen_normalize_array (data, off, size, bswap, xcdr_version, elem_size, num);
+  /* booleans in sequences are validated like enums with max value 1 */
+  if (size - *off < num)
+    return false;
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+  {
+    if (!dds_stream_simd_check_max (data + *off, 1, num, false, 1))
+      return false;
+  }
+  else
+  {
+    for (uint32_t i = 0; i < num; i++)
+      if ((unsigned char) data[*off + i] > 1)
+        return false;
+  }
+  *off += num;
+  return true;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_getsize (size_t * __restrict pos, uint32_t xcdr_version, uint32_t size, uint32_t num)
+{
+  const size_t a = dds_stream_gen_align (xcdr_version, size) - 1;
+  *pos = ((*pos + a) & ~a) + num * size;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_getsize_string (size_t * __restrict pos, uint32_t xcdr_version, const char * __restrict val)
+{
+  dds_stream_gen_getsize (pos, xcdr_version, 4, 1);
+  *pos += val ? strlen (val) + 1 : 1;
+}
+
+/** @component cdr_serializer */
+static inline void dds_stream_gen_getsize_seq (size_t * __restrict pos, uint32_t xcdr_version, const dds_sequence_t * __restrict seq, uint32_t size)
+{
+  dds_stream_gen_getsize (pos, xcdr_version, 4, 1);
+  if (seq->_length > 0)
+    dds_stream_gen_getsize (pos, xcdr_version, size, seq->_length);
+}
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDS_CDRSTREAM_GEN_H */
@@ -0,0 +1,108 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDS_CDRSTREAM_SIMD_H
+#define DDS_CDRSTREAM_SIMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "dds/export.h"
+#include "dds/ddsrt/attributes.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Kernels for byte-swapping and validating arrays of primitive values in CDR data, used by the
+   (de)serializer for arrays and sequences of DDS_OP_VAL_{2,4,8}BY, DDS_OP_VAL_BLN, DDS_OP_VAL_ENU
+   and DDS_OP_VAL_BMK. Vectorized implementations are selected at run-time based on the
+   capabilities of the CPU, with a portable fallback.
+
+   None of these require the data to be aligned. Arrays that are shorter than
+   DDS_STREAM_SIMD_MIN_ELEMS are better handled inline by the caller. */
+
+#define DDS_STREAM_SIMD_MIN_ELEMS 16
+
+/** @component cdr_serializer */
+enum dds_stream_simd_isa {
+  DDS_STREAM_SIMD_SCALAR,
+  DDS_STREAM_SIMD_SSSE3,
+  DDS_STREAM_SIMD_AVX2,
+  DDS_STREAM_SIMD_NEON
+};
+
+/**
+ * @brief Returns whether the kernels for the specified instruction set are available
+ * @component cdr_serializer
+ */
+DDS_EXPORT bool dds_stream_simd_supported (enum dds_stream_simd_isa isa);
+
+/**
+ * @brief Returns the instruction set of the kernels currently in use
+ * @component cdr_serializer
+ */
+DDS_EXPORT enum dds_stream_simd_isa dds_stream_simd_get (void);
+
+/**
+ * @brief Selects the kernels to use, intended for testing and benchmarking
+ * @component cdr_serializer
+ *
+ * @param isa   instruction set to use
+ * @returns     true iff supported (if not, the selection is unchanged)
+ */
+DDS_EXPORT bool dds_stream_simd_set (enum dds_stream_simd_isa isa);
+
+/**
+ * @brief Returns the name of an instruction set
+ * @component cdr_serializer
+ */
+DDS_EXPORT const char *dds_stream_simd_name (enum dds_stream_simd_isa isa);
+
+/**
+ * @brief Reverses the byte order of num elements of elem_size (1, 2, 4 or 8) bytes in place
+ * @component cdr_serializer
+ */
+DDS_EXPORT void dds_stream_simd_bswap (void * __restrict buf, uint32_t elem_size, uint32_t num);
+
+/**
+ * @brief Copies num elements of elem_size (1, 2, 4 or 8) bytes, reversing the byte order of each
+ * @component cdr_serializer
+ */
+DDS_EXPORT void dds_stream_simd_bswap_copy (void * __restrict dst, const void * __restrict src, uint32_t elem_size, uint32_t num);
+
+/**
+ * @brief Replaces any value > 1 in an array of booleans by 1
+ * @component cdr_serializer
+ */
+DDS_EXPORT void dds_stream_simd_clamp_bool (uint8_t * __restrict xs, uint32_t num);
+
+/**
+ * @brief Checks that all unsigned elem_size (1, 2 or 4) byte values in an array are <= max
+ * @component cdr_serializer
+ *
+ * If bswap is set, the byte order of the elements is reversed in place before checking.
+ * The contents are undefined if the check fails.
+ */
+DDS_EXPORT bool dds_stream_simd_check_max (void * __restrict buf, uint32_t elem_size, uint32_t num, bool bswap, uint32_t max)
+  ddsrt_attribute_warn_unused_result;
+
+/**
+ * @brief Checks that no value in an array of elem_size (1, 2, 4 or 8) byte bitmasks has bits set outside (bits_h:bits_l)
+ * @component cdr_serializer
+ *
+ * If bswap is set, the byte order of the elements is reversed in place before checking.
+ */
+DDS_EXPORT bool dds_stream_simd_check_bitmask (void * __restrict buf, uint32_t elem_size, uint32_t num, bool bswap, uint32_t bits_h, uint32_t bits_l)
+  ddsrt_attribute_warn_unused_result;
+
+#if defined (__cplusplus)
+}
+#endif
+#endif
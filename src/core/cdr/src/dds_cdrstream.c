@@ -18,6 +18,7 @@
 #include "dds/ddsrt/string.h"
 #include "dds/ddsrt/static_assert.h"
 #include "dds/cdr/dds_cdrstream.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
 #include "dds/ddsc/dds_data_type_properties.h"
 
 #define TOKENPASTE(a, b) a ## b
@@ -175,7 +176,7 @@ static inline align_t dds_cdr_get_align (uint32_t xcdr_version, uint32_t size)
 #undef MK_ALIGN
 }
 
-static void dds_ostream_grow (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t size)
+void dds_ostream_grow (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, uint32_t size)
 {
   uint32_t needed = size + os->m_index;
 
@@ -398,6 +399,11 @@ static uint32_t dds_os_reserve8BE (dds_ostreamBE_t * __restrict os, const struct
 static void dds_stream_swap (void * __restrict vbuf, uint32_t size, uint32_t num)
 {
   assert (size == 1 || size == 2 || size == 4 || size == 8);
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+  {
+    dds_stream_simd_bswap (vbuf, size, num);
+    return;
+  }
   switch (size)
   {
     case 1:
@@ -1474,6 +1480,8 @@ bool dds_stream_write_sampleLE (dds_ostreamLE_t * __restrict os, const struct dd
   if (opt_size && desc->align && (((struct dds_ostream *)os)->m_index % desc->align) == 0) {
     dds_os_put_bytes ((struct dds_ostream *)os, allocator, data, (uint32_t) opt_size);
     res = true;
+  } else if (desc->funcs && desc->funcs->write_sample) {
+    res = desc->funcs->write_sample (&os->x, allocator, data);
   } else {
     res = dds_stream_writeLE (os, allocator, data, desc->ops.ops) != NULL;
   }
@@ -1515,6 +1523,8 @@ bool dds_stream_write_sampleBE (dds_ostreamBE_t * __restrict os, const struct dd
   if (opt_size && desc->align && (((struct dds_ostream *)os)->m_index % desc->align) == 0) {
     dds_os_put_bytes ((struct dds_ostream *)os, allocator, data, (uint32_t) opt_size);
     res = true;
+  } else if (desc->funcs && desc->funcs->write_sample) {
+    res = desc->funcs->write_sample (&os->x, allocator, data);
   } else {
     res = dds_stream_writeBE (os, allocator, data, desc->ops.ops) != NULL;
   }
@@ -1964,6 +1974,8 @@ static size_t dds_stream_getsize_sample_impl (const char * __restrict data, cons
 
 size_t dds_stream_getsize_sample (const char * __restrict data, const struct dds_cdrstream_desc * __restrict desc, uint32_t xcdr_version)
 {
+  if (desc->funcs && desc->funcs->getsize_sample)
+    return desc->funcs->getsize_sample (data, xcdr_version);
   return dds_stream_getsize_sample_impl (data, desc->ops.ops, xcdr_version);
 }
 
@@ -3086,9 +3098,14 @@ static bool normalize_boolarray (char * __restrict data, uint32_t * __restrict o
   if ((*off = check_align_prim_many (*off, size, 0, 0, num)) == UINT32_MAX)
     return false;
   uint8_t * const xs = (uint8_t *) (data + *off);
-  for (uint32_t i = 0; i < num; i++)
-    if (xs[i] > 1)
-      xs[i] = 1;
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+    dds_stream_simd_clamp_bool (xs, num);
+  else
+  {
+    for (uint32_t i = 0; i < num; i++)
+      if (xs[i] > 1)
+        xs[i] = 1;
+  }
   *off += num;
   return true;
 }
@@ -3139,30 +3156,54 @@ static bool normalize_enumarray (char * __restrict data, uint32_t * __restrict o
     case 1: {
       if ((*off = check_align_prim_many (*off, size, 0, 0, num)) == UINT32_MAX)
         return false;
-      uint8_t * const xs = (uint8_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if (xs[i] > max)
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_max (data + *off, 1, num, bswap, max))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint8_t * const xs = (uint8_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if (xs[i] > max)
+            return normalize_error_bool ();
+      }
       *off += num;
       break;
     }
     case 2: {
       if ((*off = check_align_prim_many (*off, size, 1, 1, num)) == UINT32_MAX)
         return false;
-      uint16_t * const xs = (uint16_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if ((uint16_t) (bswap ? (xs[i] = ddsrt_bswap2u (xs[i])) : xs[i]) > max)
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_max (data + *off, 2, num, bswap, max))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint16_t * const xs = (uint16_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if ((uint16_t) (bswap ? (xs[i] = ddsrt_bswap2u (xs[i])) : xs[i]) > max)
+            return normalize_error_bool ();
+      }
       *off += 2 * num;
       break;
     }
     case 4: {
       if ((*off = check_align_prim_many (*off, size, 2, 2, num)) == UINT32_MAX)
         return false;
-      uint32_t * const xs = (uint32_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if ((uint32_t) (bswap ? (xs[i] = ddsrt_bswap4u (xs[i])) : xs[i]) > max)
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_max (data + *off, 4, num, bswap, max))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint32_t * const xs = (uint32_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if ((uint32_t) (bswap ? (xs[i] = ddsrt_bswap4u (xs[i])) : xs[i]) > max)
+            return normalize_error_bool ();
+      }
       *off += 4 * num;
       break;
     }
@@ -3180,47 +3221,79 @@ static bool normalize_bitmaskarray (char * __restrict data, uint32_t * __restric
     case 1: {
       if ((*off = check_align_prim_many (*off, size, 0, 0, num)) == UINT32_MAX)
         return false;
-      uint8_t * const xs = (uint8_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if (!bitmask_value_valid (xs[i], bits_h, bits_l))
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_bitmask (data + *off, 1, num, bswap, bits_h, bits_l))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint8_t * const xs = (uint8_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if (!bitmask_value_valid (xs[i], bits_h, bits_l))
+            return normalize_error_bool ();
+      }
       *off += num;
       break;
     }
     case 2: {
       if ((*off = check_align_prim_many (*off, size, 1, 1, num)) == UINT32_MAX)
         return false;
-      uint16_t * const xs = (uint16_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if (!bitmask_value_valid (bswap ? (xs[i] = ddsrt_bswap2u (xs[i])) : xs[i], bits_h, bits_l))
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_bitmask (data + *off, 2, num, bswap, bits_h, bits_l))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint16_t * const xs = (uint16_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if (!bitmask_value_valid (bswap ? (xs[i] = ddsrt_bswap2u (xs[i])) : xs[i], bits_h, bits_l))
+            return normalize_error_bool ();
+      }
       *off += 2 * num;
       break;
     }
     case 4: {
       if ((*off = check_align_prim_many (*off, size, 2, 2, num)) == UINT32_MAX)
         return false;
-      uint32_t * const xs = (uint32_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
-        if (!bitmask_value_valid (bswap ? (xs[i] = ddsrt_bswap4u (xs[i])) : xs[i], bits_h, bits_l))
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_bitmask (data + *off, 4, num, bswap, bits_h, bits_l))
           return normalize_error_bool ();
+      }
+      else
+      {
+        uint32_t * const xs = (uint32_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
+          if (!bitmask_value_valid (bswap ? (xs[i] = ddsrt_bswap4u (xs[i])) : xs[i], bits_h, bits_l))
+            return normalize_error_bool ();
+      }
       *off += 4 * num;
       break;
     }
     case 8: {
       if ((*off = check_align_prim_many (*off, size, xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_2 ? 2 : 3, 3, num)) == UINT32_MAX)
         return false;
-      uint64_t * const xs = (uint64_t *) (data + *off);
-      for (uint32_t i = 0; i < num; i++)
+      if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+      {
+        if (!dds_stream_simd_check_bitmask (data + *off, 8, num, bswap, bits_h, bits_l))
+          return normalize_error_bool ();
+      }
+      else
       {
-        if (bswap)
+        uint64_t * const xs = (uint64_t *) (data + *off);
+        for (uint32_t i = 0; i < num; i++)
         {
-          uint32_t x = ddsrt_bswap4u (* (uint32_t *) &xs[i]);
-          *(uint32_t *) &xs[i] = ddsrt_bswap4u (* (((uint32_t *) &xs[i]) + 1));
-          *(((uint32_t *) &xs[i]) + 1) = x;
+          if (bswap)
+          {
+            uint32_t x = ddsrt_bswap4u (* (uint32_t *) &xs[i]);
+            *(uint32_t *) &xs[i] = ddsrt_bswap4u (* (((uint32_t *) &xs[i]) + 1));
+            *(((uint32_t *) &xs[i]) + 1) = x;
+          }
+          if (!bitmask_value_valid (xs[i], bits_h, bits_l))
+            return normalize_error_bool ();
         }
-        if (!bitmask_value_valid (xs[i], bits_h, bits_l))
-          return normalize_error_bool ();
       }
       *off += 8 * num;
       break;
@@ -3812,6 +3885,8 @@ bool dds_stream_normalize (void * __restrict data, uint32_t size, bool bswap, ui
     return normalize_error_bool ();
   else if (just_key)
     return stream_normalize_key (data, size, bswap, xcdr_version, desc, actual_size);
+  else if (desc->funcs && desc->funcs->normalize)
+    return desc->funcs->normalize (data, size, bswap, xcdr_version, actual_size);
   else if (!stream_normalize_data_impl (data, &off, size, bswap, xcdr_version, desc->ops.ops, false, CDR_KIND_DATA))
     return false;
   else
@@ -4168,6 +4243,11 @@ static void dds_stream_extract_key_from_key_prim_op (dds_istream_t * __restrict
 static void dds_stream_swap_copy (void * __restrict vdst, const void * __restrict vsrc, uint32_t size, uint32_t num)
 {
   assert (size == 1 || size == 2 || size == 4 || size == 8);
+  if (num >= DDS_STREAM_SIMD_MIN_ELEMS)
+  {
+    dds_stream_simd_bswap_copy (vdst, vsrc, size, num);
+    return;
+  }
   switch (size)
   {
     case 1:
@@ -4401,6 +4481,300 @@ static const uint32_t *dds_stream_extract_key_from_data_skip_adr (dds_istream_t
   return ops;
 }
 
+/*******************************************************************************************
+ **
+ **  Locating members in serialized data, for evaluating filters without deserializing.
+ **
+ *******************************************************************************************/
+
+const uint32_t *dds_stream_member_adr (const uint32_t * __restrict ops, uint32_t index, uint32_t member_id)
+{
+  uint32_t insn;
+  if (DDS_OP (ops[0]) == DDS_OP_PLC)
+  {
+    for (ops++; (insn = *ops) != DDS_OP_RTS; ops += 2)
+    {
+      assert (DDS_OP (insn) == DDS_OP_PLM);
+      if (!(DDS_PLM_FLAGS (insn) & DDS_OP_FLAG_BASE) && ops[1] == member_id)
+        return ops + DDS_OP_ADR_PLM (insn);
+    }
+    return NULL;
+  }
+
+  if (DDS_OP (ops[0]) == DDS_OP_DLC)
+    ops++;
+  while ((insn = *ops) != DDS_OP_RTS)
+  {
+    if (DDS_OP (insn) != DDS_OP_ADR)
+      return NULL;
+    if (!op_type_base (insn) && index-- == 0)
+      return ops;
+    ops = dds_stream_skip_adr (insn, ops);
+  }
+  return NULL;
+}
+
+const uint32_t *dds_stream_base_type_ops (const uint32_t * __restrict ops)
+{
+  uint32_t insn;
+  if (DDS_OP (ops[0]) == DDS_OP_PLC)
+  {
+    for (ops++; (insn = *ops) != DDS_OP_RTS; ops += 2)
+      if (DDS_PLM_FLAGS (insn) & DDS_OP_FLAG_BASE)
+        return ops + DDS_OP_ADR_PLM (insn);
+    return NULL;
+  }
+
+  if (DDS_OP (ops[0]) == DDS_OP_DLC)
+    ops++;
+  insn = ops[0];
+  if (DDS_OP (insn) == DDS_OP_ADR && DDS_OP_TYPE (insn) == DDS_OP_VAL_EXT && op_type_base (insn))
+    return ops + DDS_OP_ADR_JSR (ops[2]);
+  return NULL;
+}
+
+/* Locating stops as soon as all members have been found, leaving the stream and instruction
+   pointers wherever they happen to be at that point.  Bits in "candidates" correspond to the
+   members whose path matches the enclosing members up to "depth". */
+struct locate_members_state {
+  const uint32_t *op0;
+  uint32_t nmembers;
+  const struct dds_cdrstream_member_path *members;
+  uint32_t *offsets;
+  uint64_t remaining;
+};
+
+static const uint32_t *dds_stream_locate_members_impl (dds_istream_t * __restrict is, struct locate_members_state * __restrict st, const uint32_t * __restrict ops, uint32_t depth, uint64_t candidates, bool is_mutable_member);
+
+static const uint32_t *dds_stream_locate_members_skip_adr (dds_istream_t * __restrict is, const uint32_t * __restrict op0, const uint32_t * __restrict ops, uint32_t insn)
+{
+  if (DDS_OP_TYPE (insn) != DDS_OP_VAL_EXT)
+    return dds_stream_extract_key_from_data_skip_adr (is, ops, DDS_OP_TYPE (insn));
+
+  const uint32_t *jsr_ops = ops + DDS_OP_ADR_JSR (ops[2]);
+  const uint32_t jmp = DDS_OP_ADR_JMP (ops[2]);
+  uint32_t remain = UINT32_MAX;
+  if (op_type_base (insn) && jsr_ops[0] == DDS_OP_DLC)
+    jsr_ops++;
+  (void) dds_stream_extract_key_from_data1 (is, NULL, NULL, op0, jsr_ops, false, false, remain, &remain);
+  return ops + (jmp ? jmp : 3);
+}
+
+static const uint32_t *dds_stream_locate_members_adr (uint32_t insn, dds_istream_t * __restrict is, struct locate_members_state * __restrict st, const uint32_t * __restrict ops, uint32_t depth, uint64_t candidates, bool is_mutable_member)
+{
+  assert (DDS_OP (insn) == DDS_OP_ADR);
+  if (!stream_is_member_present (insn, is, is_mutable_member))
+    return dds_stream_skip_adr (insn, ops);
+
+  if (DDS_OP_TYPE (insn) == DDS_OP_VAL_EXT && op_type_base (insn))
+  {
+    /* base type members are serialized as if they are members of the derived type, and so
+       are its members in a path */
+    const uint32_t *jsr_ops = ops + DDS_OP_ADR_JSR (ops[2]);
+    const uint32_t jmp = DDS_OP_ADR_JMP (ops[2]);
+    if (jsr_ops[0] == DDS_OP_DLC)
+      jsr_ops++;
+    (void) dds_stream_locate_members_impl (is, st, jsr_ops, depth, candidates, false);
+    return ops + (jmp ? jmp : 3);
+  }
+
+  const uint32_t adr = (uint32_t) (ops - st->op0);
+  uint64_t match = 0;
+  for (uint32_t i = 0; i < st->nmembers; i++)
+    if ((candidates & (UINT64_C (1) << i)) && st->members[i].adr[depth] == adr)
+      match |= UINT64_C (1) << i;
+  if (match == 0)
+    return dds_stream_locate_members_skip_adr (is, st->op0, ops, insn);
+
+  const enum dds_stream_typecode type = DDS_OP_TYPE (insn);
+  if (type == DDS_OP_VAL_EXT)
+  {
+    const uint32_t jmp = DDS_OP_ADR_JMP (ops[2]);
+    (void) dds_stream_locate_members_impl (is, st, ops + DDS_OP_ADR_JSR (ops[2]), depth + 1, match, false);
+    return ops + (jmp ? jmp : 3);
+  }
+
+  uint32_t size;
+  switch (type)
+  {
+    case DDS_OP_VAL_BLN: case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+      size = get_primitive_size (type);
+      break;
+    case DDS_OP_VAL_ENU:
+      size = DDS_OP_TYPE_SZ (insn);
+      break;
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
+      size = 4;
+      break;
+    default:
+      abort (); /* only primitives, enums and strings can be located */
+      break;
+  }
+  dds_cdr_alignto (is, dds_cdr_get_align (is->m_xcdr_version, size));
+  for (uint32_t i = 0; i < st->nmembers; i++)
+  {
+    if (match & (UINT64_C (1) << i))
+    {
+      assert (st->members[i].n == depth + 1);
+      st->offsets[i] = is->m_index;
+    }
+  }
+  st->remaining &= ~match;
+  return dds_stream_locate_members_skip_adr (is, st->op0, ops, insn);
+}
+
+static const uint32_t *dds_stream_locate_members_delimited (dds_istream_t * __restrict is, struct locate_members_state * __restrict st, const uint32_t * __restrict ops, uint32_t depth, uint64_t candidates)
+{
+  const uint32_t delimited_sz = dds_is_get4 (is), delimited_offs = is->m_index;
+  uint32_t insn;
+  ops++;
+  while ((insn = *ops) != DDS_OP_RTS && st->remaining != 0)
+  {
+    switch (DDS_OP (insn))
+    {
+      case DDS_OP_ADR:
+        /* fields that are not in the serialized data for an appendable type are absent */
+        ops = (is->m_index - delimited_offs < delimited_sz) ? dds_stream_locate_members_adr (insn, is, st, ops, depth, candidates, false) : dds_stream_skip_adr (insn, ops);
+        break;
+      case DDS_OP_JSR:
+        (void) dds_stream_locate_members_impl (is, st, ops + DDS_OP_JUMP (insn), depth, candidates, false);
+        ops++;
+        break;
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_JEQ4: case DDS_OP_KOF: case DDS_OP_DLC: case DDS_OP_PLC: case DDS_OP_PLM:
+        abort ();
+        break;
+    }
+  }
+  is->m_index = delimited_offs + delimited_sz;
+  return ops;
+}
+
+static const uint32_t *dds_stream_locate_members_pl_member (uint32_t m_id, const uint32_t * __restrict ops)
+{
+  uint32_t insn;
+  for (; (insn = *ops) != DDS_OP_RTS; ops += 2)
+  {
+    assert (DDS_OP (insn) == DDS_OP_PLM);
+    const uint32_t *plm_ops = ops + DDS_OP_ADR_PLM (insn);
+    if (DDS_PLM_FLAGS (insn) & DDS_OP_FLAG_BASE)
+    {
+      assert (DDS_OP (plm_ops[0]) == DDS_OP_PLC);
+      const uint32_t *base_plm_ops;
+      if ((base_plm_ops = dds_stream_locate_members_pl_member (m_id, plm_ops + 1)) != NULL)
+        return base_plm_ops;
+    }
+    else if (ops[1] == m_id)
+    {
+      return plm_ops;
+    }
+  }
+  return NULL;
+}
+
+static const uint32_t *dds_stream_locate_members_pl (dds_istream_t * __restrict is, struct locate_members_state * __restrict st, const uint32_t * __restrict ops, uint32_t depth, uint64_t candidates)
+{
+  /* skip PLC op */
+  ops++;
+
+  /* read DHEADER */
+  const uint32_t pl_sz = dds_is_get4 (is), pl_offs = is->m_index;
+  while (is->m_index - pl_offs < pl_sz && st->remaining != 0)
+  {
+    /* read EMHEADER and next_int */
+    const uint32_t em_hdr = dds_is_get4 (is);
+    const uint32_t lc = EMHEADER_LENGTH_CODE (em_hdr), m_id = EMHEADER_MEMBERID (em_hdr);
+    uint32_t msz;
+    switch (lc)
+    {
+      case LENGTH_CODE_1B: case LENGTH_CODE_2B: case LENGTH_CODE_4B: case LENGTH_CODE_8B:
+        msz = 1u << lc;
+        break;
+      case LENGTH_CODE_NEXTINT:
+        msz = dds_is_get4 (is);
+        break;
+      case LENGTH_CODE_ALSO_NEXTINT: case LENGTH_CODE_ALSO_NEXTINT4: case LENGTH_CODE_ALSO_NEXTINT8:
+        /* length is part of serialized data, and does not include its own 4 bytes */
+        msz = dds_is_peek4 (is);
+        if (lc > LENGTH_CODE_ALSO_NEXTINT)
+          msz <<= (lc - 4);
+        msz += 4;
+        break;
+      default:
+        abort ();
+        break;
+    }
+    const uint32_t member_end = is->m_index + msz;
+    const uint32_t *plm_ops;
+    if ((plm_ops = dds_stream_locate_members_pl_member (m_id, ops)) != NULL)
+      (void) dds_stream_locate_members_impl (is, st, plm_ops, depth, candidates, true);
+    is->m_index = member_end;
+  }
+  is->m_index = pl_offs + pl_sz;
+
+  /* skip all PLM-memberid pairs */
+  while (ops[0] != DDS_OP_RTS)
+    ops += 2;
+  return ops;
+}
+
+static const uint32_t *dds_stream_locate_members_impl (dds_istream_t * __restrict is, struct locate_members_state * __restrict st, const uint32_t * __restrict ops, uint32_t depth, uint64_t candidates, bool is_mutable_member)
+{
+  uint32_t insn;
+  while ((insn = *ops) != DDS_OP_RTS && st->remaining != 0)
+  {
+    switch (DDS_OP (insn))
+    {
+      case DDS_OP_ADR:
+        ops = dds_stream_locate_members_adr (insn, is, st, ops, depth, candidates, is_mutable_member);
+        break;
+      case DDS_OP_JSR:
+        (void) dds_stream_locate_members_impl (is, st, ops + DDS_OP_JUMP (insn), depth, candidates, is_mutable_member);
+        ops++;
+        break;
+      case DDS_OP_RTS: case DDS_OP_JEQ: case DDS_OP_JEQ4: case DDS_OP_KOF: case DDS_OP_PLM:
+        abort ();
+        break;
+      case DDS_OP_DLC:
+        assert (is->m_xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_2);
+        ops = dds_stream_locate_members_delimited (is, st, ops, depth, candidates);
+        break;
+      case DDS_OP_PLC:
+        assert (is->m_xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_2);
+        ops = dds_stream_locate_members_pl (is, st, ops, depth, candidates);
+        break;
+    }
+  }
+  return ops;
+}
+
+void dds_stream_locate_members (dds_istream_t * __restrict is, const struct dds_cdrstream_desc * __restrict desc, uint32_t nmembers, const struct dds_cdrstream_member_path * __restrict members, uint32_t * __restrict offsets)
+{
+  assert (nmembers <= 64);
+  const uint64_t all = (nmembers == 64) ? UINT64_MAX : (UINT64_C (1) << nmembers) - 1;
+  struct locate_members_state st = {
+    .op0 = desc->ops.ops, .nmembers = nmembers, .members = members, .offsets = offsets, .remaining = all
+  };
+  for (uint32_t i = 0; i < nmembers; i++)
+    offsets[i] = UINT32_MAX;
+  if (nmembers > 0)
+    (void) dds_stream_locate_members_impl (is, &st, desc->ops.ops, 0, all, false);
+}
+
+const void *dds_stream_member_address (const void * __restrict sample, const struct dds_cdrstream_desc * __restrict desc, const struct dds_cdrstream_member_path * __restrict member)
+{
+  const char *addr = sample;
+  for (uint32_t k = 0; k < member->n; k++)
+  {
+    const uint32_t * const ops = desc->ops.ops + member->adr[k];
+    assert (DDS_OP (ops[0]) == DDS_OP_ADR);
+    /* base types are at offset 0 in the derived type, so they can be ignored */
+    addr += ops[1];
+    if (op_type_external (ops[0]) && (addr = *((const char **) addr)) == NULL)
+      return NULL;
+  }
+  return addr;
+}
+
 /*******************************************************************************************
  **
  **  Read/write of samples and keys -- i.e., DDSI payloads.
@@ -4417,6 +4791,10 @@ void dds_stream_read_sample (dds_istream_t * __restrict is, void * __restrict da
        potential out-of-bounds read */
     dds_is_get_bytes (is, data, (uint32_t) opt_size, 1);
   }
+  else if (desc->funcs && desc->funcs->read_sample)
+  {
+    desc->funcs->read_sample (is, data, allocator);
+  }
   else
   {
     (void) dds_stream_read_impl (is, data, allocator, desc->ops.ops, false, CDR_KIND_DATA, SAMPLE_DATA_INITIALIZED);
@@ -4554,7 +4932,9 @@ static inline void dds_stream_swap_if_needed_insitu (void * __restrict vbuf, uin
 
 // Native endianness
 #define NAME_BYTE_ORDER_EXT
+#define NATIVE_BYTE_ORDER 1
 #include "dds_cdrstream_keys.part.h"
+#undef NATIVE_BYTE_ORDER
 #undef NAME_BYTE_ORDER_EXT
 
 #if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN
@@ -4566,7 +4946,9 @@ static void dds_stream_swap_if_needed_insituBE (void * __restrict vbuf, uint32_t
 
 // Big-endian implementation
 #define NAME_BYTE_ORDER_EXT BE
+#define NATIVE_BYTE_ORDER 0
 #include "dds_cdrstream_keys.part.h"
+#undef NATIVE_BYTE_ORDER
 #undef NAME_BYTE_ORDER_EXT
 
 #else /* if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN */
@@ -5593,9 +5975,11 @@ void dds_cdrstream_desc_init (struct dds_cdrstream_desc *desc, const struct dds_
   memcpy (desc->ops.ops, ops, desc->ops.nops * sizeof (*desc->ops.ops));
 
   /* Get the flagset from the descriptor, except for the key related flags that are calculated
-     using the CDR stream serializer */
-  desc->flagset = flagset & ~DDS_CDR_CALCULATED_FLAGS;
+     using the CDR stream serializer and the flag for the type-specific serializers: those are
+     optional, have to be set by the caller and don't affect the type's representation */
+  desc->flagset = flagset & ~(DDS_CDR_CALCULATED_FLAGS | DDS_TOPIC_TYPE_SERDES);
   desc->flagset |= dds_stream_key_flags (desc, NULL, NULL);
+  desc->funcs = NULL;
 }
 
 void dds_cdrstream_desc_fini (struct dds_cdrstream_desc *desc, const struct dds_cdrstream_allocator * __restrict allocator)
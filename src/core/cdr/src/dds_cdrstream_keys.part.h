@@ -103,7 +103,12 @@ bool dds_stream_write_keyBO (DDS_OSTREAM_T * __restrict os, enum dds_cdr_key_ser
 #ifndef NDEBUG
   const size_t check_start_index = ((dds_ostream_t *)os)->m_index;
 #endif
-  if (desc->flagset & (DDS_TOPIC_KEY_APPENDABLE | DDS_TOPIC_KEY_MUTABLE) && ser_kind == DDS_CDR_KEY_SERIALIZATION_SAMPLE)
+  if (NATIVE_BYTE_ORDER && ser_kind == DDS_CDR_KEY_SERIALIZATION_SAMPLE && desc->funcs && desc->funcs->write_key)
+  {
+    if (!desc->funcs->write_key ((dds_ostream_t *) os, allocator, sample))
+      return false;
+  }
+  else if (desc->flagset & (DDS_TOPIC_KEY_APPENDABLE | DDS_TOPIC_KEY_MUTABLE) && ser_kind == DDS_CDR_KEY_SERIALIZATION_SAMPLE)
   {
     /* For types with key fields in aggregated types with appendable or mutable
        extensibility, write the key CDR using the regular write functions */
@@ -378,7 +383,11 @@ bool dds_stream_extract_keyBO_from_data (dds_istream_t * __restrict is, DDS_OSTR
   if (keys_remaining == 0)
     return ret;
 
-  if (desc->flagset & (DDS_TOPIC_KEY_APPENDABLE | DDS_TOPIC_KEY_MUTABLE))
+  if (NATIVE_BYTE_ORDER && desc->funcs && desc->funcs->extract_key_from_data)
+  {
+    ret = desc->funcs->extract_key_from_data (is, (dds_ostream_t *) os, allocator);
+  }
+  else if (desc->flagset & (DDS_TOPIC_KEY_APPENDABLE | DDS_TOPIC_KEY_MUTABLE))
   {
     /* In case the type or any subtype has non-final extensibility, read the sample
        and write the key-only CDR for this sample */
@@ -0,0 +1,431 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "dds/ddsrt/attributes.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/bswap.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
+
+/* The x86 kernels rely on the GCC/Clang "target" attribute to enable SSSE3 and AVX2 for just those
+   functions and on __builtin_cpu_supports for selecting them at run-time. NEON is part of the
+   baseline wherever __ARM_NEON is defined, so there are no run-time checks for it. */
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define SIMD_X86 1
+#include <immintrin.h>
+#elif defined __ARM_NEON
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+struct simd_kernels {
+  enum dds_stream_simd_isa isa;
+  void (*bswap[3]) (char * __restrict buf, uint32_t num); // 2, 4, 8 bytes
+  void (*bswap_copy[3]) (char * __restrict dst, const char * __restrict src, uint32_t num); // 2, 4, 8 bytes
+  void (*clamp_bool) (uint8_t * __restrict xs, uint32_t num);
+  bool (*check_max[3]) (char * __restrict buf, uint32_t num, bool bswap, uint32_t max); // 1, 2, 4 bytes
+  uint64_t (*or[4]) (char * __restrict buf, uint32_t num, bool bswap); // 1, 2, 4, 8 bytes
+};
+
+#define SIMD_KERNELS_INIT(s) SIMD_KERNELS_INIT1 (s)
+#define SIMD_KERNELS_INIT1(s) { \
+    DDS_STREAM_SIMD_##s, \
+    { bswap2_##s, bswap4_##s, bswap8_##s }, \
+    { bswap_copy2_##s, bswap_copy4_##s, bswap_copy8_##s }, \
+    clamp_bool_##s, \
+    { check_max1_##s, check_max2_##s, check_max4_##s }, \
+    { or1_##s, or2_##s, or4_##s, or8_##s } \
+  }
+
+/* Scalar versions, these also handle the remainder for the vectorized ones */
+
+#define DEF_BSWAP_SCALAR(k, bits) \
+  static void bswap##k##_SCALAR (char * __restrict buf, uint32_t num) \
+  { \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+      uint##bits##_t x; \
+      memcpy (&x, buf + k * i, k); \
+      x = ddsrt_bswap##k##u (x); \
+      memcpy (buf + k * i, &x, k); \
+    } \
+  } \
+  static void bswap_copy##k##_SCALAR (char * __restrict dst, const char * __restrict src, uint32_t num) \
+  { \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+      uint##bits##_t x; \
+      memcpy (&x, src + k * i, k); \
+      x = ddsrt_bswap##k##u (x); \
+      memcpy (dst + k * i, &x, k); \
+    } \
+  }
+
+DEF_BSWAP_SCALAR (2, 16)
+DEF_BSWAP_SCALAR (4, 32)
+DEF_BSWAP_SCALAR (8, 64)
+
+#undef DEF_BSWAP_SCALAR
+
+static void clamp_bool_SCALAR (uint8_t * __restrict xs, uint32_t num)
+{
+  for (uint32_t i = 0; i < num; i++)
+    if (xs[i] > 1)
+      xs[i] = 1;
+}
+
+static bool check_max1_SCALAR (char * __restrict buf, uint32_t num, bool bswap, uint32_t max)
+{
+  (void) bswap;
+  for (uint32_t i = 0; i < num; i++)
+    if ((uint8_t) buf[i] > max)
+      return false;
+  return true;
+}
+
+static uint64_t or1_SCALAR (char * __restrict buf, uint32_t num, bool bswap)
+{
+  (void) bswap;
+  uint8_t v = 0;
+  for (uint32_t i = 0; i < num; i++)
+    v |= (uint8_t) buf[i];
+  return v;
+}
+
+#define DEF_CHECK_SCALAR(k, bits) \
+  static bool check_max##k##_SCALAR (char * __restrict buf, uint32_t num, bool bswap, uint32_t max) \
+  { \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+      uint##bits##_t x; \
+      memcpy (&x, buf + k * i, k); \
+      if (bswap) \
+      { \
+        x = ddsrt_bswap##k##u (x); \
+        memcpy (buf + k * i, &x, k); \
+      } \
+      if (x > max) \
+        return false; \
+    } \
+    return true; \
+  }
+
+#define DEF_OR_SCALAR(k, bits) \
+  static uint64_t or##k##_SCALAR (char * __restrict buf, uint32_t num, bool bswap) \
+  { \
+    uint##bits##_t v = 0; \
+    for (uint32_t i = 0; i < num; i++) \
+    { \
+      uint##bits##_t x; \
+      memcpy (&x, buf + k * i, k); \
+      if (bswap) \
+      { \
+        x = ddsrt_bswap##k##u (x); \
+        memcpy (buf + k * i, &x, k); \
+      } \
+      v |= x; \
+    } \
+    return v; \
+  }
+
+DEF_CHECK_SCALAR (2, 16)
+DEF_CHECK_SCALAR (4, 32)
+DEF_OR_SCALAR (2, 16)
+DEF_OR_SCALAR (4, 32)
+DEF_OR_SCALAR (8, 64)
+
+#undef DEF_OR_SCALAR
+#undef DEF_CHECK_SCALAR
+
+/* Bitwise-or of the elem_size-byte elements contained in v; it doesn't matter in which order the
+   elements are stored in v. */
+static uint64_t fold_or (uint64_t v, uint32_t elem_size)
+{
+  if (elem_size <= 4)
+    v = (v | (v >> 32)) & UINT32_MAX;
+  if (elem_size <= 2)
+    v = (v | (v >> 16)) & UINT16_MAX;
+  if (elem_size <= 1)
+    v = (v | (v >> 8)) & UINT8_MAX;
+  return v;
+}
+
+static const struct simd_kernels kernels_SCALAR = SIMD_KERNELS_INIT (SCALAR);
+
+#if SIMD_X86
+
+#define SIMD_BSWAP2_SHUF 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+#define SIMD_BSWAP4_SHUF 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+#define SIMD_BSWAP8_SHUF 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+
+#define vec_t __m128i
+#define VW 16
+#define SIMD_SUFFIX SSSE3
+#define SIMD_TARGET __attribute__ ((target ("ssse3")))
+#define VLOAD(p) _mm_loadu_si128 ((const __m128i *) (const void *) (p))
+#define VSTORE(p, v) _mm_storeu_si128 ((__m128i *) (void *) (p), (v))
+#define VBSWAP2(v) _mm_shuffle_epi8 ((v), _mm_setr_epi8 (SIMD_BSWAP2_SHUF))
+#define VBSWAP4(v) _mm_shuffle_epi8 ((v), _mm_setr_epi8 (SIMD_BSWAP4_SHUF))
+#define VBSWAP8(v) _mm_shuffle_epi8 ((v), _mm_setr_epi8 (SIMD_BSWAP8_SHUF))
+#define VOR(a, b) _mm_or_si128 ((a), (b))
+#define VZERO _mm_setzero_si128 ()
+#define VSET1_8(x) _mm_set1_epi8 ((char) (x))
+#define VSET1_16(x) _mm_set1_epi16 ((short) (x))
+#define VSET1_32(x) _mm_set1_epi32 ((int) (x))
+#define VMIN_U8(a, b) _mm_min_epu8 ((a), (b))
+#define VEXCESS_U8(x, m) _mm_subs_epu8 ((x), (m))
+#define VEXCESS_U16(x, m) _mm_subs_epu16 ((x), (m))
+#define VEXCESS_U32(x, m) _mm_cmpgt_epi32 (_mm_xor_si128 ((x), _mm_set1_epi32 (INT32_MIN)), _mm_xor_si128 ((m), _mm_set1_epi32 (INT32_MIN)))
+#define VNONZERO(v) (_mm_movemask_epi8 (_mm_cmpeq_epi8 ((v), _mm_setzero_si128 ())) != 0xffff)
+#include "dds_cdrstream_simd.part.h"
+#undef vec_t
+#undef VW
+#undef SIMD_SUFFIX
+#undef SIMD_TARGET
+#undef VLOAD
+#undef VSTORE
+#undef VBSWAP2
+#undef VBSWAP4
+#undef VBSWAP8
+#undef VOR
+#undef VZERO
+#undef VSET1_8
+#undef VSET1_16
+#undef VSET1_32
+#undef VMIN_U8
+#undef VEXCESS_U8
+#undef VEXCESS_U16
+#undef VEXCESS_U32
+#undef VNONZERO
+
+#define vec_t __m256i
+#define VW 32
+#define SIMD_SUFFIX AVX2
+#define SIMD_TARGET __attribute__ ((target ("avx2")))
+#define VLOAD(p) _mm256_loadu_si256 ((const __m256i *) (const void *) (p))
+#define VSTORE(p, v) _mm256_storeu_si256 ((__m256i *) (void *) (p), (v))
+#define VBSWAP2(v) _mm256_shuffle_epi8 ((v), _mm256_setr_epi8 (SIMD_BSWAP2_SHUF, SIMD_BSWAP2_SHUF))
+#define VBSWAP4(v) _mm256_shuffle_epi8 ((v), _mm256_setr_epi8 (SIMD_BSWAP4_SHUF, SIMD_BSWAP4_SHUF))
+#define VBSWAP8(v) _mm256_shuffle_epi8 ((v), _mm256_setr_epi8 (SIMD_BSWAP8_SHUF, SIMD_BSWAP8_SHUF))
+#define VOR(a, b) _mm256_or_si256 ((a), (b))
+#define VZERO _mm256_setzero_si256 ()
+#define VSET1_8(x) _mm256_set1_epi8 ((char) (x))
+#define VSET1_16(x) _mm256_set1_epi16 ((short) (x))
+#define VSET1_32(x) _mm256_set1_epi32 ((int) (x))
+#define VMIN_U8(a, b) _mm256_min_epu8 ((a), (b))
+#define VEXCESS_U8(x, m) _mm256_subs_epu8 ((x), (m))
+#define VEXCESS_U16(x, m) _mm256_subs_epu16 ((x), (m))
+#define VEXCESS_U32(x, m) _mm256_cmpgt_epi32 (_mm256_xor_si256 ((x), _mm256_set1_epi32 (INT32_MIN)), _mm256_xor_si256 ((m), _mm256_set1_epi32 (INT32_MIN)))
+#define VNONZERO(v) (!_mm256_testz_si256 ((v), (v)))
+#include "dds_cdrstream_simd.part.h"
+#undef vec_t
+#undef VW
+#undef SIMD_SUFFIX
+#undef SIMD_TARGET
+#undef VLOAD
+#undef VSTORE
+#undef VBSWAP2
+#undef VBSWAP4
+#undef VBSWAP8
+#undef VOR
+#undef VZERO
+#undef VSET1_8
+#undef VSET1_16
+#undef VSET1_32
+#undef VMIN_U8
+#undef VEXCESS_U8
+#undef VEXCESS_U16
+#undef VEXCESS_U32
+#undef VNONZERO
+
+#elif SIMD_NEON
+
+#define vec_t uint8x16_t
+#define VW 16
+#define SIMD_SUFFIX NEON
+#define SIMD_TARGET
+#define VLOAD(p) vld1q_u8 ((const uint8_t *) (const void *) (p))
+#define VSTORE(p, v) vst1q_u8 ((uint8_t *) (void *) (p), (v))
+#define VBSWAP2(v) vrev16q_u8 (v)
+#define VBSWAP4(v) vrev32q_u8 (v)
+#define VBSWAP8(v) vrev64q_u8 (v)
+#define VOR(a, b) vorrq_u8 ((a), (b))
+#define VZERO vdupq_n_u8 (0)
+#define VSET1_8(x) vdupq_n_u8 ((uint8_t) (x))
+#define VSET1_16(x) vreinterpretq_u8_u16 (vdupq_n_u16 ((uint16_t) (x)))
+#define VSET1_32(x) vreinterpretq_u8_u32 (vdupq_n_u32 ((uint32_t) (x)))
+#define VMIN_U8(a, b) vminq_u8 ((a), (b))
+#define VEXCESS_U8(x, m) vqsubq_u8 ((x), (m))
+#define VEXCESS_U16(x, m) vreinterpretq_u8_u16 (vqsubq_u16 (vreinterpretq_u16_u8 (x), vreinterpretq_u16_u8 (m)))
+#define VEXCESS_U32(x, m) vreinterpretq_u8_u32 (vcgtq_u32 (vreinterpretq_u32_u8 (x), vreinterpretq_u32_u8 (m)))
+#define VNONZERO(v) ((vgetq_lane_u64 (vreinterpretq_u64_u8 (v), 0) | vgetq_lane_u64 (vreinterpretq_u64_u8 (v), 1)) != 0)
+#include "dds_cdrstream_simd.part.h"
+#undef vec_t
+#undef VW
+#undef SIMD_SUFFIX
+#undef SIMD_TARGET
+#undef VLOAD
+#undef VSTORE
+#undef VBSWAP2
+#undef VBSWAP4
+#undef VBSWAP8
+#undef VOR
+#undef VZERO
+#undef VSET1_8
+#undef VSET1_16
+#undef VSET1_32
+#undef VMIN_U8
+#undef VEXCESS_U8
+#undef VEXCESS_U16
+#undef VEXCESS_U32
+#undef VNONZERO
+
+#endif
+
+static const struct simd_kernels *kernels_for_isa (enum dds_stream_simd_isa isa)
+{
+  switch (isa)
+  {
+    case DDS_STREAM_SIMD_SCALAR:
+      return &kernels_SCALAR;
+#if SIMD_X86
+    case DDS_STREAM_SIMD_SSSE3:
+      return __builtin_cpu_supports ("ssse3") ? &kernels_SSSE3 : NULL;
+    case DDS_STREAM_SIMD_AVX2:
+      return __builtin_cpu_supports ("avx2") ? &kernels_AVX2 : NULL;
+#elif SIMD_NEON
+    case DDS_STREAM_SIMD_NEON:
+      return &kernels_NEON;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+static ddsrt_atomic_voidp_t selected_kernels = DDSRT_ATOMIC_VOIDP_INIT (NULL);
+
+static const struct simd_kernels *get_kernels (void)
+{
+  const struct simd_kernels *ks = ddsrt_atomic_ldvoidp (&selected_kernels);
+  if (ks == NULL)
+  {
+    // selection is deterministic, so racing initializations store the same pointer
+    static const enum dds_stream_simd_isa preference[] = { DDS_STREAM_SIMD_AVX2, DDS_STREAM_SIMD_NEON, DDS_STREAM_SIMD_SSSE3 };
+    for (size_t i = 0; ks == NULL && i < sizeof (preference) / sizeof (preference[0]); i++)
+      ks = kernels_for_isa (preference[i]);
+    if (ks == NULL)
+      ks = &kernels_SCALAR;
+    ddsrt_atomic_stvoidp (&selected_kernels, (void *) ks);
+  }
+  return ks;
+}
+
+bool dds_stream_simd_supported (enum dds_stream_simd_isa isa)
+{
+  return kernels_for_isa (isa) != NULL;
+}
+
+enum dds_stream_simd_isa dds_stream_simd_get (void)
+{
+  return get_kernels ()->isa;
+}
+
+bool dds_stream_simd_set (enum dds_stream_simd_isa isa)
+{
+  const struct simd_kernels *ks = kernels_for_isa (isa);
+  if (ks == NULL)
+    return false;
+  ddsrt_atomic_stvoidp (&selected_kernels, (void *) ks);
+  return true;
+}
+
+const char *dds_stream_simd_name (enum dds_stream_simd_isa isa)
+{
+  switch (isa)
+  {
+    case DDS_STREAM_SIMD_SCALAR: return "scalar";
+    case DDS_STREAM_SIMD_SSSE3: return "ssse3";
+    case DDS_STREAM_SIMD_AVX2: return "avx2";
+    case DDS_STREAM_SIMD_NEON: return "neon";
+  }
+  return "?";
+}
+
+void dds_stream_simd_bswap (void * __restrict buf, uint32_t elem_size, uint32_t num)
+{
+  switch (elem_size)
+  {
+    case 1: break;
+    case 2: get_kernels ()->bswap[0] (buf, num); break;
+    case 4: get_kernels ()->bswap[1] (buf, num); break;
+    case 8: get_kernels ()->bswap[2] (buf, num); break;
+    default: assert (0);
+  }
+}
+
+void dds_stream_simd_bswap_copy (void * __restrict dst, const void * __restrict src, uint32_t elem_size, uint32_t num)
+{
+  switch (elem_size)
+  {
+    case 1: memcpy (dst, src, num); break;
+    case 2: get_kernels ()->bswap_copy[0] (dst, src, num); break;
+    case 4: get_kernels ()->bswap_copy[1] (dst, src, num); break;
+    case 8: get_kernels ()->bswap_copy[2] (dst, src, num); break;
+    default: assert (0);
+  }
+}
+
+void dds_stream_simd_clamp_bool (uint8_t * __restrict xs, uint32_t num)
+{
+  get_kernels ()->clamp_bool (xs, num);
+}
+
+bool dds_stream_simd_check_max (void * __restrict buf, uint32_t elem_size, uint32_t num, bool bswap, uint32_t max)
+{
+  const struct simd_kernels *ks = get_kernels ();
+  switch (elem_size)
+  {
+    case 1:
+      return max >= UINT8_MAX || ks->check_max[0] (buf, num, false, max);
+    case 2:
+      if (max < UINT16_MAX)
+        return ks->check_max[1] (buf, num, bswap, max);
+      // no need to check anything if max covers the range, but the data still needs swapping
+      if (bswap)
+        ks->bswap[0] (buf, num);
+      return true;
+    case 4:
+      if (max < UINT32_MAX)
+        return ks->check_max[2] (buf, num, bswap, max);
+      if (bswap)
+        ks->bswap[1] (buf, num);
+      return true;
+    default:
+      assert (0);
+      return false;
+  }
+}
+
+bool dds_stream_simd_check_bitmask (void * __restrict buf, uint32_t elem_size, uint32_t num, bool bswap, uint32_t bits_h, uint32_t bits_l)
+{
+  const struct simd_kernels *ks = get_kernels ();
+  uint64_t v;
+  switch (elem_size)
+  {
+    case 1: v = ks->or[0] (buf, num, false); break;
+    case 2: v = ks->or[1] (buf, num, bswap); break;
+    case 4: v = ks->or[2] (buf, num, bswap); break;
+    case 8: v = ks->or[3] (buf, num, bswap); break;
+    default: assert (0); return false;
+  }
+  return ((v >> 32) & ~bits_h) == 0 && ((uint32_t) v & ~bits_l) == 0;
+}
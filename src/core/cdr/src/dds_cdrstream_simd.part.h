@@ -0,0 +1,157 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+/* Vectorized kernels, instantiated once for each instruction set by dds_cdrstream_simd.c.
+   The includer defines the vector type and the operations on it:
+
+     vec_t             vector type
+     VW                width of vec_t in bytes
+     SIMD_SUFFIX       suffix for the function names
+     SIMD_TARGET       function attribute for enabling the instruction set
+     VLOAD(p)          unaligned load from p
+     VSTORE(p,v)       unaligned store of v at p
+     VBSWAP{2,4,8}(v)  reverses the byte order of each 2, 4 or 8 byte element in v
+     VOR(a,b)          bitwise or
+     VZERO             all bits 0
+     VSET1_{8,16,32}(x)  broadcast x to all 1, 2 or 4 byte elements
+     VMIN_U8(a,b)      minimum of unsigned bytes
+     VEXCESS_U{8,16,32}(x,m)  non-zero in those elements where unsigned x > unsigned m
+     VNONZERO(v)       true iff any bit in v is set
+
+   Each kernel processes whole vectors and leaves the remainder to the scalar version. */
+
+#define SIMD_FN(n) SIMD_FN1 (n, SIMD_SUFFIX)
+#define SIMD_FN1(n, s) SIMD_FN2 (n, s)
+#define SIMD_FN2(n, s) n##_##s
+
+#define SIMD_DEF_BSWAP(k) \
+  SIMD_TARGET static void SIMD_FN (bswap##k) (char * __restrict buf, uint32_t num) \
+  { \
+    const size_t n = k * (size_t) num; \
+    size_t i; \
+    for (i = 0; i + VW <= n; i += VW) \
+      VSTORE (buf + i, VBSWAP##k (VLOAD (buf + i))); \
+    bswap##k##_SCALAR (buf + i, (uint32_t) ((n - i) / k)); \
+  } \
+  SIMD_TARGET static void SIMD_FN (bswap_copy##k) (char * __restrict dst, const char * __restrict src, uint32_t num) \
+  { \
+    const size_t n = k * (size_t) num; \
+    size_t i; \
+    for (i = 0; i + VW <= n; i += VW) \
+      VSTORE (dst + i, VBSWAP##k (VLOAD (src + i))); \
+    bswap_copy##k##_SCALAR (dst + i, src + i, (uint32_t) ((n - i) / k)); \
+  }
+
+SIMD_DEF_BSWAP (2)
+SIMD_DEF_BSWAP (4)
+SIMD_DEF_BSWAP (8)
+
+#undef SIMD_DEF_BSWAP
+
+SIMD_TARGET static void SIMD_FN (clamp_bool) (uint8_t * __restrict xs, uint32_t num)
+{
+  const vec_t one = VSET1_8 (1);
+  size_t i;
+  for (i = 0; i + VW <= num; i += VW)
+    VSTORE (xs + i, VMIN_U8 (VLOAD (xs + i), one));
+  clamp_bool_SCALAR (xs + i, (uint32_t) (num - i));
+}
+
+SIMD_TARGET static bool SIMD_FN (check_max1) (char * __restrict buf, uint32_t num, bool bswap, uint32_t max)
+{
+  const vec_t m = VSET1_8 ((uint8_t) max);
+  vec_t acc = VZERO;
+  size_t i;
+  for (i = 0; i + VW <= num; i += VW)
+    acc = VOR (acc, VEXCESS_U8 (VLOAD (buf + i), m));
+  return !VNONZERO (acc) && check_max1_SCALAR (buf + i, (uint32_t) (num - i), bswap, max);
+}
+
+#define SIMD_DEF_CHECK_MAX(k, bits) \
+  SIMD_TARGET static bool SIMD_FN (check_max##k) (char * __restrict buf, uint32_t num, bool bswap, uint32_t max) \
+  { \
+    const vec_t m = VSET1_##bits ((uint##bits##_t) max); \
+    const size_t n = k * (size_t) num; \
+    vec_t acc = VZERO; \
+    size_t i; \
+    if (bswap) \
+    { \
+      for (i = 0; i + VW <= n; i += VW) \
+      { \
+        const vec_t x = VBSWAP##k (VLOAD (buf + i)); \
+        VSTORE (buf + i, x); \
+        acc = VOR (acc, VEXCESS_U##bits (x, m)); \
+      } \
+    } \
+    else \
+    { \
+      for (i = 0; i + VW <= n; i += VW) \
+        acc = VOR (acc, VEXCESS_U##bits (VLOAD (buf + i), m)); \
+    } \
+    return !VNONZERO (acc) && check_max##k##_SCALAR (buf + i, (uint32_t) ((n - i) / k), bswap, max); \
+  }
+
+SIMD_DEF_CHECK_MAX (2, 16)
+SIMD_DEF_CHECK_MAX (4, 32)
+
+#undef SIMD_DEF_CHECK_MAX
+
+SIMD_TARGET static uint64_t SIMD_FN (reduce_or) (const vec_t *acc)
+{
+  uint64_t lanes[VW / 8], v = 0;
+  VSTORE ((char *) lanes, *acc);
+  for (size_t j = 0; j < VW / 8; j++)
+    v |= lanes[j];
+  return v;
+}
+
+SIMD_TARGET static uint64_t SIMD_FN (or1) (char * __restrict buf, uint32_t num, bool bswap)
+{
+  vec_t acc = VZERO;
+  size_t i;
+  for (i = 0; i + VW <= num; i += VW)
+    acc = VOR (acc, VLOAD (buf + i));
+  return fold_or (SIMD_FN (reduce_or) (&acc), 1) | or1_SCALAR (buf + i, (uint32_t) (num - i), bswap);
+}
+
+#define SIMD_DEF_OR(k) \
+  SIMD_TARGET static uint64_t SIMD_FN (or##k) (char * __restrict buf, uint32_t num, bool bswap) \
+  { \
+    const size_t n = k * (size_t) num; \
+    vec_t acc = VZERO; \
+    size_t i; \
+    if (bswap) \
+    { \
+      for (i = 0; i + VW <= n; i += VW) \
+      { \
+        const vec_t x = VBSWAP##k (VLOAD (buf + i)); \
+        VSTORE (buf + i, x); \
+        acc = VOR (acc, x); \
+      } \
+    } \
+    else \
+    { \
+      for (i = 0; i + VW <= n; i += VW) \
+        acc = VOR (acc, VLOAD (buf + i)); \
+    } \
+    return fold_or (SIMD_FN (reduce_or) (&acc), k) | or##k##_SCALAR (buf + i, (uint32_t) ((n - i) / k), bswap); \
+  }
+
+SIMD_DEF_OR (2)
+SIMD_DEF_OR (4)
+SIMD_DEF_OR (8)
+
+#undef SIMD_DEF_OR
+
+static const struct simd_kernels SIMD_FN (kernels) = SIMD_KERNELS_INIT (SIMD_SUFFIX);
+
+#undef SIMD_FN2
+#undef SIMD_FN1
+#undef SIMD_FN
@@ -1692,6 +1692,58 @@ dds_set_topic_filter_extended(
   dds_entity_t topic,
   const struct dds_topic_filter *filter);
 
+/**
+ * @anchor dds_set_topic_filter_expression
+ * @brief Sets a filter expression on a topic.
+ * @ingroup topic_filter
+ * @component topic
+ * @warning Unstable API
+ *
+ * The expression is a subset of DDS-SQL (the language of the WHERE clause of a
+ * ContentFilteredTopic in the DDS specification) consisting of predicates of the
+ * form "operand op operand", with "op" one of "=", "<>" (or "!="), "<", "<=", ">"
+ * or ">=", "operand [NOT] BETWEEN operand AND operand" and "operand [NOT] LIKE
+ * pattern" combined using AND, OR, NOT and parentheses.  Keywords are
+ * case-insensitive.
+ *
+ * Operands are names of members of a primitive, enumerated or string type (using
+ * "." to refer to members of nested structs), integer, floating-point, boolean
+ * (TRUE, FALSE), character and string literals (in single quotes), names of
+ * enumerators and parameters "%n" (0 <= n < nparams).  At least one of the
+ * operands of a predicate must be a member, which determines how literals and
+ * parameters are interpreted.  String parameters may be written without quotes.
+ * In a LIKE pattern, "%" matches any sequence of characters and "_" any single
+ * character.  A predicate referring to an optional member that is absent is false.
+ *
+ * The expression is evaluated on the serialized representation of the data
+ * whenever possible, so that samples are rejected by a reader before they are
+ * deserialized.  Setting a filter expression replaces any filter function set
+ * using @ref dds_set_topic_filter_extended and vice versa.
+ *
+ * Not thread-safe with respect to data being read/written using readers/writers
+ * using this topic.  Be sure to create a topic entity specific to the reader you
+ * want to filter, then set the filter expression, and only then create the reader.
+ *
+ * @param[in]  topic       The topic on which the content filter is set.
+ * @param[in]  expression  The filter expression, or a null pointer to remove the filter.
+ * @param[in]  nparams     The number of parameters.
+ * @param[in]  params      The parameter values, may be a null pointer if nparams = 0.
+ *
+ * @returns A dds_return_t indicating success or failure.
+ *
+ * @retval DDS_RETCODE_OK  Filter set successfully
+ * @retval DDS_RETCODE_BAD_PARAMETER  The topic handle is invalid, or the expression or one
+ *           of the parameters is invalid
+ * @retval DDS_RETCODE_UNSUPPORTED  The topic's type has no type information, or the
+ *           expression refers to a member that can't be used in a filter
+*/
+DDS_EXPORT dds_return_t
+dds_set_topic_filter_expression(
+  dds_entity_t topic,
+  const char *expression,
+  uint32_t nparams,
+  const char * const *params);
+
 /**
  * @brief Gets the filter for a topic.
  * @ingroup topic_filter
@@ -2453,6 +2505,47 @@ dds_write(dds_entity_t writer, const void *data);
 DDS_EXPORT dds_return_t
 dds_write_flush(dds_entity_t entity);
 
+/**
+ * @brief Start a batch of writes spanning multiple writers
+ * @ingroup writing
+ * @component write_data
+ *
+ * Until the matching call to `dds_end_batch()`, the data written by the calling
+ * thread is not sent immediately, but instead packed in RTPS messages shared by
+ * all writers of the same domain.  This is useful when a thread publishes a
+ * number of small samples on different topics at once, as the samples can then
+ * be sent in one or a few packets instead of one packet per sample.  Other
+ * threads are not affected, and data written locally is still delivered to
+ * local readers immediately.
+ *
+ * Batches may be nested, the data is sent once the outermost batch ends.  The
+ * batch must be ended before deleting the domain any of the writers belongs to,
+ * and before the thread terminates.
+ *
+ * @returns A dds_return_t indicating success or failure.
+ * @retval DDS_RETCODE_OK
+ *             The batch was started.
+ */
+DDS_EXPORT dds_return_t
+dds_begin_batch(void);
+
+/**
+ * @brief End a batch of writes started with `dds_begin_batch()`
+ * @ingroup writing
+ * @component write_data
+ *
+ * Ending the outermost batch of the calling thread sends out all data written
+ * by this thread since the start of the batch.
+ *
+ * @returns A dds_return_t indicating success or failure.
+ * @retval DDS_RETCODE_OK
+ *             The batch was ended.
+ * @retval DDS_RETCODE_PRECONDITION_NOT_MET
+ *             The calling thread has no batch in progress.
+ */
+DDS_EXPORT dds_return_t
+dds_end_batch(void);
+
 /**
  * @brief Write a serialized value of a data instance
  * @ingroup writing
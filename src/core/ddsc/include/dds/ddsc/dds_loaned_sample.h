@@ -69,7 +69,8 @@ typedef struct dds_loaned_sample_ops {
 
 typedef enum dds_loaned_sample_origin_kind {
   DDS_LOAN_ORIGIN_KIND_HEAP,
-  DDS_LOAN_ORIGIN_KIND_PSMX
+  DDS_LOAN_ORIGIN_KIND_PSMX,
+  DDS_LOAN_ORIGIN_KIND_SERDATA //!< aliases the payload of a received sample, read-only
 } dds_loaned_sample_origin_kind_t;
 
 typedef struct dds_loaned_sample_origin {
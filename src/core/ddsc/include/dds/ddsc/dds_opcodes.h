@@ -641,6 +641,13 @@ enum dds_stream_typecode_subtype {
  */
 #define DDS_TOPIC_FIXED_KEY_XCDR2_KEYHASH       (1u << 10)
 
+/**
+ * @anchor DDS_TOPIC_TYPE_SERDES
+ * @ingroup topic_flags
+ * @brief Set if type-specific serializer functions are present in the topic descriptor
+ */
+#define DDS_TOPIC_TYPE_SERDES                   (1u << 11)
+
 /**
  * @anchor DDS_FIXED_KEY_MAX_SIZE
  * @ingroup topic_flags
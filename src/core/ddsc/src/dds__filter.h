@@ -0,0 +1,88 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDS__FILTER_H
+#define DDS__FILTER_H
+
+#include "dds/ddsi/ddsi_sertype.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds__types.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* A compiled DDS-SQL filter expression.  The expression is compiled into a small program
+   operating on a boolean accumulator, where each predicate compares members of the sample
+   to constants or to each other.  Members are located directly in the serialized
+   representation whenever possible, so that samples can be filtered without deserializing
+   them. */
+struct dds_filter_expr;
+
+/**
+ * @brief Compile a filter expression for samples of a type
+ *
+ * @param[out] expr        the compiled expression
+ * @param[in]  sertype     the type, must be a default sertype with type information
+ * @param[in]  expression  the filter expression
+ * @param[in]  nparams     number of parameters
+ * @param[in]  params      values for parameters %0 .. %(nparams-1)
+ *
+ * @retval DDS_RETCODE_OK  success
+ * @retval DDS_RETCODE_BAD_PARAMETER  invalid expression or parameter
+ * @retval DDS_RETCODE_UNSUPPORTED  the type or one of the referenced members can't be filtered on
+ *
+ * @component topic
+ */
+dds_return_t dds_filter_expr_compile (struct dds_filter_expr **expr, const struct ddsi_sertype *sertype, const char *expression, uint32_t nparams, const char * const *params)
+  ddsrt_nonnull ((1, 2, 3));
+
+/** @component topic */
+void dds_filter_expr_free (struct dds_filter_expr *expr);
+
+/** @component topic */
+bool dds_filter_expr_eval_sample (const struct dds_filter_expr *expr, const void *sample)
+  ddsrt_nonnull_all;
+
+/** @component topic */
+bool dds_filter_expr_eval_serdata (const struct dds_filter_expr *expr, const struct ddsi_serdata *serdata)
+  ddsrt_nonnull_all;
+
+/**
+ * @brief Construct the content filter property for advertising a filter expression in discovery
+ *
+ * @param[in] expr        the compiled expression
+ * @param[in] topic_name  name of the topic to which it applies
+ *
+ * @returns a newly allocated content filter property
+ *
+ * @component topic
+ */
+ddsi_content_filter_property_t *dds_filter_expr_content_filter_property (const struct dds_filter_expr *expr, const char *topic_name)
+  ddsrt_nonnull_all;
+
+/** @component topic */
+void dds_filter_content_filter_property_free (ddsi_content_filter_property_t *cfp);
+
+/**
+ * @brief Install the evaluation of filter expressions for remote readers in the domain
+ *
+ * @param[in] dom  the domain, prior to starting DDSI
+ *
+ * @component topic
+ */
+void dds_filter_init_content_filter_interface (struct dds_domain *dom);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDS__FILTER_H */
@@ -25,6 +25,7 @@ struct dds_read_collect_sample_arg {
   dds_sample_info_t *infos; /**< array of sample infos to be filled **/
   struct dds_loan_pool *loan_pool; /**< loan pool to be used for loaned sample administration **/
   struct dds_loan_pool *heap_loan_cache; /**< pool of cached heap loans */
+  bool take; /**< samples are removed from the reader history cache (initially false) */
 };
 
 /** @brief Initialize the sample collector state
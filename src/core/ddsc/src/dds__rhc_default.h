@@ -30,6 +30,14 @@ struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_dom
 /** @component rhc */
 struct dds_rhc *dds_rhc_default_new (struct dds_reader *reader, const struct ddsi_sertype *type);
 
+/** @component rhc
+ *
+ * Creates a default RHC for use as one of the shards of a sharded RHC.  Shards share the
+ * read conditions, so a shard reuses a query condition bit allocated by another shard,
+ * leaves releasing it to the sharded RHC and adds to the triggers instead of setting them.
+ */
+struct dds_rhc *dds_rhc_default_new_shard (struct dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, bool xchecks);
+
 #ifdef DDS_HAS_LIFESPAN
 /** @component rhc */
 ddsrt_mtime_t dds_rhc_default_sample_expired_cb(void *hc, ddsrt_mtime_t tnow);
@@ -0,0 +1,58 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDS__RHC_SHARDED_H
+#define DDS__RHC_SHARDED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct dds_rhc;
+struct dds_reader;
+struct ddsi_sertype;
+struct ddsi_domaingv;
+
+/** @component rhc
+ *
+ * Creates an RHC that spreads the instances over `nshards` default RHCs based on the
+ * instance handle, each with its own lock.  Storing data in different instances and
+ * reading/taking concurrently then mostly touch different locks.
+ *
+ * Instances and samples are counted per shard, so it can not enforce the reader-wide
+ * resource limits max_samples and max_instances.  It also doesn't preserve the order in
+ * which instances became non-empty when reading across instances.
+ */
+struct dds_rhc *dds_rhc_sharded_new_xchecks (struct dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, uint32_t nshards, bool xchecks);
+
+/** @component rhc */
+struct dds_rhc *dds_rhc_sharded_new (struct dds_reader *reader, const struct ddsi_sertype *type, uint32_t nshards);
+
+/** @component rhc
+ *
+ * Returns the number of shards of a sharded RHC
+ */
+uint32_t dds_rhc_sharded_nshards (const struct dds_rhc *rhc);
+
+/** @component rhc
+ *
+ * Returns shard `idx` of a sharded RHC, a default RHC.  Each shard has its own lifespan
+ * and deadline administration, and so expires samples and detects missed deadlines
+ * independently of the others.
+ */
+struct dds_rhc *dds_rhc_sharded_shard (const struct dds_rhc *rhc, uint32_t idx);
+
+#if defined (__cplusplus)
+}
+#endif
+#endif /* DDS__RHC_SHARDED_H */
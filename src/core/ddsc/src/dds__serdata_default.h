@@ -14,7 +14,6 @@
 #include "dds/ddsrt/endian.h"
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsi/ddsi_protocol.h"
-#include "dds/ddsi/ddsi_freelist.h"
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_typelib.h"
 #include "dds/cdr/dds_cdrstream.h"
@@ -44,20 +43,22 @@ extern "C" {
  * defined, and the extensibility is the same as the actual
  * data-type. As a result, the serialized key can have DHEADERS
  * and/or EMHEADERS in case of an appendable or mutable data-type.
+ *
+ * Instances are identified in-process by this serialized key and a
+ * fast 128-bit hash of it, where keys of at most 16 bytes are used
+ * directly instead of hashed. The MD5-based DDSI keyhash is only
+ * computed when it is to be sent (see serdata_default_get_keyhash).
  */
 struct dds_serdata_default_key {
   unsigned buftype : 2;
   unsigned keysize : 30;
+  uint64_t hash[2]; // 128-bit hash of the serialized key or, if it fits, the zero-padded key itself
   union {
     unsigned char stbuf[DDS_FIXED_KEY_MAX_SIZE];
     unsigned char *dynbuf;
   } u;
 };
 
-struct dds_serdatapool {
-  struct ddsi_freelist freelist;
-};
-
 /* Debug builds may want to keep some additional state */
 #ifndef NDEBUG
 #define DDS_SERDATA_DEFAULT_DEBUG_FIELDS \
@@ -75,9 +76,7 @@ struct dds_serdatapool {
   uint32_t pos;                       \
   uint32_t size;                      \
   DDS_SERDATA_DEFAULT_DEBUG_FIELDS    \
-  struct dds_serdata_default_key key; \
-  struct dds_serdatapool *serpool;    \
-  struct dds_serdata_default *next /* in pool->freelist */
+  struct dds_serdata_default_key key
 /* We suppress the zero-array warning (MSVC C4200) here ONLY for MSVC
    and ONLY if it is being compiled as C++ code, as it only causes
    issues there */
@@ -126,7 +125,6 @@ struct dds_sertype_default {
   struct ddsi_sertype c;
   uint16_t encoding_format; /* DDSI_RTPS_CDR_ENC_FORMAT_(PLAIN|DELIMITED|PL) - CDR encoding format for the top-level type in this sertype */
   uint16_t write_encoding_version; /* DDSI_RTPS_CDR_ENC_VERSION_(1|2) - CDR encoding version used for writing data using this sertype */
-  struct dds_serdatapool *serpool;
   struct dds_cdrstream_desc type;
   struct dds_sertype_default_cdr_data typeinfo_ser;
   struct dds_sertype_default_cdr_data typemap_ser;
@@ -140,11 +138,15 @@ extern const struct ddsi_serdata_ops dds_serdata_ops_cdr_nokey;
 extern const struct ddsi_serdata_ops dds_serdata_ops_xcdr2;
 extern const struct ddsi_serdata_ops dds_serdata_ops_xcdr2_nokey;
 
-/** @component typesupport_c */
-struct dds_serdatapool * dds_serdatapool_new (void);
-
-/** @component typesupport_c */
-void dds_serdatapool_free (struct dds_serdatapool * pool);
+/**
+ * @brief Initialize an input stream for reading the serialized representation of a serdata
+ *
+ * The serdata must not be a loan holding the sample in its in-memory representation.
+ *
+ * @component typesupport_c
+ */
+void dds_serdata_default_istream (dds_istream_t * __restrict is, const struct dds_serdata_default * __restrict d)
+  ddsrt_nonnull_all;
 
 /** @component typesupport_c */
 dds_return_t dds_sertype_default_init (const struct dds_domain *domain, struct dds_sertype_default *st, const dds_topic_descriptor_t *desc, uint16_t min_xcdrv, dds_data_representation_id_t data_representation);
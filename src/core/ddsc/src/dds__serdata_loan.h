@@ -0,0 +1,47 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDS__SERDATA_LOAN_H
+#define DDS__SERDATA_LOAN_H
+
+#include "dds__types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct dds_loaned_sample;
+struct ddsi_serdata;
+
+/**
+ * @brief Constructs a loan that aliases the payload of a serdata
+ * @component read_data
+ *
+ * This is possible only for a default serdata of a memcpy-safe type for which the
+ * serialized representation is identical to the in-memory one.  The payload is in
+ * native byte order because it gets normalized on reception.  The loan holds a
+ * reference to the serdata, which is dropped when the loan is freed.
+ *
+ * The loaned sample is writable, so the serdata may not be shared with anything else:
+ * the caller must hold the only reference and drop it once the loan has been made (as
+ * in a take operation), otherwise no loan is constructed.
+ *
+ * @param[in] sd  serdata
+ * @param[out] loaned_sample  the new loan, not touched if none is returned
+ * @returns true iff a loan was constructed
+ */
+bool dds_serdata_loan (struct ddsi_serdata *sd, struct dds_loaned_sample **loaned_sample)
+  ddsrt_nonnull_all;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* DDS__SERDATA_LOAN_H */
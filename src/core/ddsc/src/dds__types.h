@@ -23,6 +23,7 @@
 #endif
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsi/ddsi_builtin_topic_if.h"
+#include "dds/ddsi/ddsi_content_filter_if.h"
 #include "dds/ddsc/dds_psmx.h"
 #include "dds__handles.h"
 #include "dds__loaned_sample.h"
@@ -300,11 +301,9 @@ typedef struct dds_domain {
 #endif
 
   struct ddsi_builtin_topic_interface btif;
+  struct ddsi_content_filter_interface cfif;
   struct ddsi_domaingv gv;
 
-  /* Transmit side: pool for the serializer & transmit messages */
-  struct dds_serdatapool *serpool;
-
   struct dds_psmx_set psmx_instances;
 } dds_domain;
 
@@ -428,6 +427,7 @@ typedef struct dds_topic {
   struct ddsi_sertype *m_stype;
   struct dds_ktopic *m_ktopic; /* refc'd, constant */
   struct dds_topic_filter m_filter;
+  ddsrt_atomic_voidp_t m_filter_expr; /* struct dds_filter_expr *, mutually exclusive with m_filter; read without locking by awake threads, so freed via the gc */
   dds_inconsistent_topic_status_t m_inconsistent_topic_status; /* Status metrics */
 } dds_topic;
 
@@ -439,7 +439,6 @@ typedef struct dds_readcond {
   uint32_t m_sample_states;
   uint32_t m_view_states;
   uint32_t m_instance_states;
-  struct dds_readcond *m_next;
   struct {
     dds_querycondition_filter_fn m_filter;
     dds_querycond_mask_t m_qcmask; /* condition mask in RHC*/
@@ -21,9 +21,29 @@ struct ddsi_domaingv;
 struct whc_writer_info;
 struct dds_writer;
 
-/** @component whc */
+/** @component whc
+ *
+ * Creates the WHC for a writer, selecting the ring-based one when the writer's QoS and
+ * topic permit it and the default one otherwise.
+ */
 struct ddsi_whc *dds_whc_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wrinfo);
 
+/** @component whc */
+struct ddsi_whc *dds_whc_default_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wrinfo);
+
+/** @component whc
+ *
+ * Creates a WHC that keeps the samples in a circular array ordered by sequence number,
+ * which avoids the sequence number hash table and interval tree of the default one.  It
+ * only supports writers of keyless topics with volatile durability and no deadline.  It
+ * handles a lifespan, but is not efficient at it, so it is best used only for writers that
+ * initially have no lifespan.
+ *
+ * @param[in] gv  domain
+ * @param[in] hdepth  KEEP_LAST history depth, 0 for KEEP_ALL
+ */
+struct ddsi_whc *dds_whc_ring_new (struct ddsi_domaingv *gv, uint32_t hdepth);
+
 /** @component whc */
 struct whc_writer_info *dds_whc_make_wrinfo (struct dds_writer *wr, const dds_qos_t *qos);
 
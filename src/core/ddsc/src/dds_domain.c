@@ -14,6 +14,8 @@
 #include "dds/ddsrt/process.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/hopscotch.h"
+#include "dds/ddsrt/slab.h"
+#include "dds/ddsrt/static_assert.h"
 #include "dds/ddsi/ddsi_iid.h"
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/ddsi/ddsi_serdata.h"
@@ -23,6 +25,7 @@
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/ddsi_typelib.h"
 #include "dds/ddsi/ddsi_init.h"
+#include "dds/ddsi/ddsi_statistics.h"
 #include "dds/ddsc/dds_rhc.h"
 #include "dds__init.h"
 #include "dds__domain.h"
@@ -31,17 +34,61 @@
 #include "dds__entity.h"
 #include "dds__serdata_default.h"
 #include "dds__psmx.h"
+#include "dds__statistics.h"
+#include "dds__filter.h"
 
 static dds_return_t dds_domain_free (dds_entity *vdomain);
 
+/* The slab allocator is shared by all domains in the process, its usage is reported for each
+   size class as the number of blocks allocated (in use or cached) and the total number of times
+   a block had to be allocated from the heap */
+#define DOMAIN_STAT_SLAB(sz) \
+  { "slab_" #sz "_blocks", DDS_STAT_KIND_UINT32 }, \
+  { "slab_" #sz "_heap", DDS_STAT_KIND_UINT64 }
+#define DOMAIN_STAT_SLAB_FIRST 2
+
+static const struct dds_stat_keyvalue_descriptor dds_domain_statistics_kv[] = {
+  { "recv_packets", DDS_STAT_KIND_UINT64 },
+  { "recv_reads", DDS_STAT_KIND_UINT64 },
+  DOMAIN_STAT_SLAB (64), DOMAIN_STAT_SLAB (128), DOMAIN_STAT_SLAB (256), DOMAIN_STAT_SLAB (512),
+  DOMAIN_STAT_SLAB (1024), DOMAIN_STAT_SLAB (2048), DOMAIN_STAT_SLAB (4096), DOMAIN_STAT_SLAB (8192),
+  DOMAIN_STAT_SLAB (16384), DOMAIN_STAT_SLAB (32768), DOMAIN_STAT_SLAB (65536)
+};
+#undef DOMAIN_STAT_SLAB
+
+static const struct dds_stat_descriptor dds_domain_statistics_desc = {
+  .count = sizeof (dds_domain_statistics_kv) / sizeof (dds_domain_statistics_kv[0]),
+  .kv = dds_domain_statistics_kv
+};
+
+static struct dds_statistics *dds_domain_create_statistics (const struct dds_entity *entity)
+{
+  return dds_alloc_statistics (entity, &dds_domain_statistics_desc);
+}
+
+static void dds_domain_refresh_statistics (const struct dds_entity *entity, struct dds_statistics *stat)
+{
+  const struct dds_domain *dom = (const struct dds_domain *) entity;
+  ddsrt_slab_class_stats_t slab[DDSRT_SLAB_NCLASSES];
+  DDSRT_STATIC_ASSERT_CODE (sizeof (dds_domain_statistics_kv) / sizeof (dds_domain_statistics_kv[0]) == DOMAIN_STAT_SLAB_FIRST + 2 * DDSRT_SLAB_NCLASSES);
+  ddsi_get_recv_stats (&dom->gv, &stat->kv[0].u.u64, &stat->kv[1].u.u64);
+  ddsrt_slab_get_stats (slab);
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+  {
+    assert (slab[i].size == (size_t) 1 << (DDSRT_SLAB_MIN_SIZE_LG2 + i));
+    stat->kv[DOMAIN_STAT_SLAB_FIRST + 2 * i].u.u32 = slab[i].nblocks;
+    stat->kv[DOMAIN_STAT_SLAB_FIRST + 2 * i + 1].u.u64 = slab[i].nheap;
+  }
+}
+
 const struct dds_entity_deriver dds_entity_deriver_domain = {
   .interrupt = dds_entity_deriver_dummy_interrupt,
   .close = dds_entity_deriver_dummy_close,
   .delete = dds_domain_free,
   .set_qos = dds_entity_deriver_dummy_set_qos,
   .validate_status = dds_entity_deriver_dummy_validate_status,
-  .create_statistics = dds_entity_deriver_dummy_create_statistics,
-  .refresh_statistics = dds_entity_deriver_dummy_refresh_statistics,
+  .create_statistics = dds_domain_create_statistics,
+  .refresh_statistics = dds_domain_refresh_statistics,
   .invoke_cbs_for_pending_events = dds_entity_deriver_dummy_invoke_cbs_for_pending_events
 };
 
@@ -148,8 +195,6 @@ static dds_entity_t dds_domain_init (dds_domain *domain, dds_domainid_t domain_i
     goto fail_ddsi_init;
   }
 
-  domain->serpool = dds_serdatapool_new ();
-
   /* Start monitoring the liveliness of threads if this is the first
      domain to configured to do so. */
   if (domain->gv.config.liveliness_monitoring)
@@ -175,6 +220,7 @@ static dds_entity_t dds_domain_init (dds_domain *domain, dds_domainid_t domain_i
   }
 
   dds__builtin_init (domain);
+  dds_filter_init_content_filter_interface (domain);
 
   if (ddsi_start (&domain->gv) < 0)
   {
@@ -200,7 +246,6 @@ fail_threadmon_start:
   }
 fail_threadmon_new:
   ddsi_fini (&domain->gv);
-  dds_serdatapool_free (domain->serpool);
 fail_ddsi_init:
   for (uint32_t i = 0; i < domain->psmx_instances.length; i++)
   {
@@ -338,8 +383,6 @@ static dds_return_t dds_domain_free (dds_entity *vdomain)
 
   (void) dds_pubsub_message_exchange_fini (domain);
 
-  dds_serdatapool_free (domain->serpool);
-
   /* tearing down the top-level object has more consequences, so it waits until signalled that all
      domains have been removed */
   ddsrt_mutex_lock (&dds_global.m_mutex);
@@ -0,0 +1,1132 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/strtol.h"
+#include "dds/ddsrt/strtod.h"
+#include "dds/ddsi/ddsi_typelib.h"
+#include "dds/cdr/dds_cdrstream.h"
+#include "dds/ddsc/dds_loaned_sample.h"
+#include "dds__filter.h"
+#include "dds__serdata_default.h"
+
+/* Bounded by the number of members dds_stream_locate_members can locate in one pass */
+#define FILTER_MAX_FIELDS 64
+
+/* Bounds the recursion depth of the parser */
+#define FILTER_MAX_DEPTH 64
+
+/* Result of comparing NaN to something */
+#define FILTER_UNORDERED 2
+
+enum filter_vclass {
+  FVC_INT,
+  FVC_UINT,
+  FVC_FLOAT,
+  FVC_STRING
+};
+
+struct filter_value {
+  enum filter_vclass cls;
+  union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    struct {
+      const char *p;
+      uint32_t n;
+    } s;
+  } u;
+};
+
+struct filter_operand {
+  bool is_field;
+  uint32_t field;
+  struct filter_value value;
+};
+
+enum filter_pred_kind {
+  FPK_EQ,
+  FPK_NE,
+  FPK_LT,
+  FPK_LE,
+  FPK_GT,
+  FPK_GE,
+  FPK_BETWEEN, /* a BETWEEN b AND c */
+  FPK_LIKE     /* a LIKE b */
+};
+
+struct filter_pred {
+  enum filter_pred_kind kind;
+  struct filter_operand a, b, c;
+};
+
+/* The program operates on a single boolean accumulator: PRED sets it to the result of a
+   predicate, NOT inverts it and the conditional jumps implement the short-circuit
+   evaluation of AND and OR without touching it. */
+enum filter_opcode {
+  FOP_PRED,
+  FOP_NOT,
+  FOP_JF,
+  FOP_JT
+};
+
+struct filter_insn {
+  enum filter_opcode op;
+  uint32_t arg;
+};
+
+struct dds_filter_expr {
+  const struct ddsi_sertype *sertype;
+  const struct dds_cdrstream_desc *desc;
+  uint32_t nfields;
+  struct dds_cdrstream_member_path *field_paths;
+  uint32_t *field_insns; /* ADR instruction of each field, for its type */
+  uint32_t npreds;
+  struct filter_pred *preds;
+  uint32_t ninsns;
+  struct filter_insn *insns;
+  uint32_t nstrs;
+  char **strs; /* string constants */
+  char *expression; /* source text and parameters, for advertising it in discovery */
+  uint32_t nparams;
+  char **params;
+};
+
+/* Filter class name for DDS-SQL expressions, as defined by the DDS specification */
+#define DDS_FILTER_CLASS_NAME "DDSSQL"
+
+void dds_filter_expr_free (struct dds_filter_expr *expr)
+{
+  if (expr == NULL)
+    return;
+  for (uint32_t i = 0; i < expr->nstrs; i++)
+    ddsrt_free (expr->strs[i]);
+  ddsrt_free (expr->strs);
+  ddsrt_free (expr->field_paths);
+  ddsrt_free (expr->field_insns);
+  ddsrt_free (expr->preds);
+  ddsrt_free (expr->insns);
+  for (uint32_t i = 0; i < expr->nparams; i++)
+    ddsrt_free (expr->params[i]);
+  ddsrt_free (expr->params);
+  ddsrt_free (expr->expression);
+  ddsrt_free (expr);
+}
+
+/*******************************************************************************************
+ **
+ **  Compiling
+ **
+ *******************************************************************************************/
+
+#ifdef DDS_HAS_TYPELIB
+
+enum filter_tok {
+  FT_END,
+  FT_ERROR,
+  FT_IDENT,
+  FT_INT,
+  FT_FLOAT,
+  FT_STRING,
+  FT_PARAM,
+  FT_LPAREN,
+  FT_RPAREN,
+  FT_EQ,
+  FT_NE,
+  FT_LT,
+  FT_LE,
+  FT_GT,
+  FT_GE,
+  FT_AND,
+  FT_OR,
+  FT_NOT,
+  FT_BETWEEN,
+  FT_LIKE,
+  FT_TRUE,
+  FT_FALSE
+};
+
+struct filter_token {
+  enum filter_tok kind;
+  const char *text; /* identifiers and strings (including the quotes) */
+  size_t len;
+  struct filter_value value; /* integers and floats */
+  uint32_t param;
+};
+
+static bool is_digit (char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static bool is_ident_start (char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool is_ident_char (char c)
+{
+  // "." to allow naming nested members
+  return is_ident_start (c) || is_digit (c) || c == '.';
+}
+
+static const char *filter_lex_error (const char *s, struct filter_token *tok)
+{
+  tok->kind = FT_ERROR;
+  return s;
+}
+
+static const char *filter_lex_number (const char *s, struct filter_token *tok)
+{
+  const bool neg = (*s == '-');
+  const char *d = (*s == '-' || *s == '+') ? s + 1 : s;
+  unsigned long long u;
+  char *e;
+  if (d[0] == '0' && (d[1] == 'x' || d[1] == 'X'))
+  {
+    if (ddsrt_strtoull (d + 2, &e, 16, &u) != DDS_RETCODE_OK || e == d + 2)
+      return filter_lex_error (s, tok);
+  }
+  else
+  {
+    char *ef;
+    double f;
+    if (ddsrt_strtoull (d, &e, 10, &u) != DDS_RETCODE_OK)
+      return filter_lex_error (s, tok);
+    if (ddsrt_strtod (s, &ef, &f) == DDS_RETCODE_OK && ef > e)
+    {
+      // a decimal point or an exponent
+      if (is_ident_char (*ef))
+        return filter_lex_error (s, tok);
+      tok->kind = FT_FLOAT;
+      tok->value.cls = FVC_FLOAT;
+      tok->value.u.f = f;
+      return ef;
+    }
+    if (e == d)
+      return filter_lex_error (s, tok);
+  }
+  if (is_ident_char (*e))
+    return filter_lex_error (s, tok);
+  tok->kind = FT_INT;
+  if (!neg && u <= INT64_MAX)
+  {
+    tok->value.cls = FVC_INT;
+    tok->value.u.i = (int64_t) u;
+  }
+  else if (!neg)
+  {
+    tok->value.cls = FVC_UINT;
+    tok->value.u.u = u;
+  }
+  else if (u <= (uint64_t) INT64_MAX + 1)
+  {
+    tok->value.cls = FVC_INT;
+    tok->value.u.i = (u == (uint64_t) INT64_MAX + 1) ? INT64_MIN : -(int64_t) u;
+  }
+  else
+  {
+    return filter_lex_error (s, tok);
+  }
+  return e;
+}
+
+static const char *filter_lex (const char *s, struct filter_token *tok)
+{
+  static const struct { const char *kw; enum filter_tok kind; } keywords[] = {
+    { "AND", FT_AND }, { "OR", FT_OR }, { "NOT", FT_NOT }, { "BETWEEN", FT_BETWEEN },
+    { "LIKE", FT_LIKE }, { "TRUE", FT_TRUE }, { "FALSE", FT_FALSE }
+  };
+  while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r')
+    s++;
+  tok->text = s;
+  tok->len = 0;
+  if (*s == 0)
+  {
+    tok->kind = FT_END;
+    return s;
+  }
+  else if (is_ident_start (*s))
+  {
+    const char *e = s;
+    while (is_ident_char (*e))
+      e++;
+    tok->kind = FT_IDENT;
+    tok->len = (size_t) (e - s);
+    for (size_t i = 0; i < sizeof (keywords) / sizeof (keywords[0]); i++)
+      if (strlen (keywords[i].kw) == tok->len && ddsrt_strncasecmp (s, keywords[i].kw, tok->len) == 0)
+        tok->kind = keywords[i].kind;
+    return e;
+  }
+  else if (*s == '\'')
+  {
+    // a quote in a string is written as two quotes
+    const char *e = s + 1;
+    while (*e != '\'' || e[1] == '\'')
+    {
+      if (*e == 0)
+        return filter_lex_error (s, tok);
+      e += (*e == '\'') ? 2 : 1;
+    }
+    tok->kind = FT_STRING;
+    tok->len = (size_t) (e + 1 - s);
+    return e + 1;
+  }
+  else if (*s == '%')
+  {
+    unsigned long long n;
+    char *e;
+    if (!is_digit (s[1]) || ddsrt_strtoull (s + 1, &e, 10, &n) != DDS_RETCODE_OK || n > 99)
+      return filter_lex_error (s, tok);
+    tok->kind = FT_PARAM;
+    tok->param = (uint32_t) n;
+    return e;
+  }
+  else if (is_digit (*s) || (*s == '.' && is_digit (s[1])) ||
+           ((*s == '-' || *s == '+') && (is_digit (s[1]) || (s[1] == '.' && is_digit (s[2])))))
+  {
+    return filter_lex_number (s, tok);
+  }
+  switch (*s)
+  {
+    case '(': tok->kind = FT_LPAREN; return s + 1;
+    case ')': tok->kind = FT_RPAREN; return s + 1;
+    case '=': tok->kind = FT_EQ; return s + 1;
+    case '<':
+      if (s[1] == '=') { tok->kind = FT_LE; return s + 2; }
+      if (s[1] == '>') { tok->kind = FT_NE; return s + 2; }
+      tok->kind = FT_LT; return s + 1;
+    case '>':
+      if (s[1] == '=') { tok->kind = FT_GE; return s + 2; }
+      tok->kind = FT_GT; return s + 1;
+    case '!':
+      if (s[1] == '=') { tok->kind = FT_NE; return s + 2; }
+      break;
+  }
+  return filter_lex_error (s, tok);
+}
+
+enum filter_raw_kind {
+  FRK_FIELD,
+  FRK_IDENT, /* not a field, so perhaps an enumerator */
+  FRK_NUMBER,
+  FRK_STRING,
+  FRK_PARAM
+};
+
+/* An operand before it has been given a type based on the field it is compared with */
+struct filter_raw_operand {
+  enum filter_raw_kind kind;
+  uint32_t field;
+  const char *text;
+  size_t len;
+  struct filter_value value;
+  uint32_t param;
+};
+
+struct filter_parser {
+  const char *pos;
+  struct filter_token tok;
+  uint32_t depth;
+  struct dds_filter_expr *expr;
+  uint32_t nparams;
+  const char * const *params;
+  const ddsi_typemap_t *typemap;
+  const ddsi_typeid_t *type_id;
+  const struct DDS_XTypes_CompleteEnumeratedType *field_enums[FILTER_MAX_FIELDS];
+  uint32_t maxpreds, maxinsns, maxstrs;
+};
+
+static void filter_next (struct filter_parser *p)
+{
+  p->pos = filter_lex (p->pos, &p->tok);
+}
+
+static bool field_is_string (uint32_t insn)
+{
+  return DDS_OP_TYPE (insn) == DDS_OP_VAL_STR || DDS_OP_TYPE (insn) == DDS_OP_VAL_BST;
+}
+
+static const char *filter_add_string (struct filter_parser *p, const char *s, size_t n, bool unescape)
+{
+  struct dds_filter_expr * const e = p->expr;
+  char *str;
+  if (e->nstrs == p->maxstrs)
+  {
+    p->maxstrs = p->maxstrs ? 2 * p->maxstrs : 4;
+    e->strs = ddsrt_realloc (e->strs, p->maxstrs * sizeof (*e->strs));
+  }
+  str = ddsrt_malloc (n + 1);
+  if (!unescape)
+  {
+    memcpy (str, s, n);
+    str[n] = 0;
+  }
+  else
+  {
+    // strip the quotes, '' -> '
+    size_t j = 0;
+    for (size_t i = 1; i + 1 < n; i++)
+    {
+      str[j++] = s[i];
+      if (s[i] == '\'')
+        i++;
+    }
+    str[j] = 0;
+  }
+  e->strs[e->nstrs++] = str;
+  return str;
+}
+
+static dds_return_t filter_resolve_field (struct filter_parser *p, const char *name, size_t len, uint32_t *field)
+{
+  struct dds_filter_expr * const e = p->expr;
+  struct dds_cdrstream_member_path path;
+  const struct DDS_XTypes_CompleteEnumeratedType *enum_type;
+  char *tmp = ddsrt_strndup (name, len);
+  dds_return_t rc = ddsi_typemap_resolve_member (p->typemap, p->type_id, e->desc->ops.ops, tmp, &path, &enum_type);
+  ddsrt_free (tmp);
+  if (rc != DDS_RETCODE_OK)
+    return rc;
+  for (uint32_t i = 0; i < e->nfields; i++)
+  {
+    if (e->field_paths[i].n == path.n && memcmp (e->field_paths[i].adr, path.adr, path.n * sizeof (path.adr[0])) == 0)
+    {
+      *field = i;
+      return DDS_RETCODE_OK;
+    }
+  }
+  if (e->nfields == FILTER_MAX_FIELDS)
+    return DDS_RETCODE_UNSUPPORTED;
+  e->field_paths[e->nfields] = path;
+  e->field_insns[e->nfields] = e->desc->ops.ops[path.adr[path.n - 1]];
+  p->field_enums[e->nfields] = enum_type;
+  *field = e->nfields++;
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t filter_parse_raw_operand (struct filter_parser *p, struct filter_raw_operand *ro)
+{
+  dds_return_t rc;
+  switch (p->tok.kind)
+  {
+    case FT_IDENT:
+      ro->text = p->tok.text;
+      ro->len = p->tok.len;
+      if ((rc = filter_resolve_field (p, p->tok.text, p->tok.len, &ro->field)) == DDS_RETCODE_OK)
+        ro->kind = FRK_FIELD;
+      else if (rc == DDS_RETCODE_BAD_PARAMETER)
+        ro->kind = FRK_IDENT;
+      else
+        return rc;
+      break;
+    case FT_INT:
+    case FT_FLOAT:
+      ro->kind = FRK_NUMBER;
+      ro->value = p->tok.value;
+      break;
+    case FT_TRUE:
+    case FT_FALSE:
+      ro->kind = FRK_NUMBER;
+      ro->value.cls = FVC_INT;
+      ro->value.u.i = (p->tok.kind == FT_TRUE);
+      break;
+    case FT_STRING:
+      ro->kind = FRK_STRING;
+      ro->text = p->tok.text;
+      ro->len = p->tok.len;
+      break;
+    case FT_PARAM:
+      if (p->tok.param >= p->nparams || p->params[p->tok.param] == NULL)
+        return DDS_RETCODE_BAD_PARAMETER;
+      ro->kind = FRK_PARAM;
+      ro->param = p->tok.param;
+      break;
+    default:
+      return DDS_RETCODE_BAD_PARAMETER;
+  }
+  filter_next (p);
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t filter_make_operand (struct filter_parser *p, struct filter_operand *op, const struct filter_raw_operand *ro, uint32_t field)
+{
+  // field is the field this operand is compared with, unless ro itself is a field
+  const uint32_t insn = p->expr->field_insns[field];
+  op->is_field = false;
+  switch (ro->kind)
+  {
+    case FRK_FIELD:
+      op->is_field = true;
+      op->field = ro->field;
+      return DDS_RETCODE_OK;
+
+    case FRK_PARAM: {
+      // parameters are literals, but strings may be written without quotes
+      const char *text = p->params[ro->param];
+      struct filter_token tok, end;
+      struct filter_raw_operand lit;
+      (void) filter_lex (filter_lex (text, &tok), &end);
+      const bool single = (end.kind == FT_END);
+      if (field_is_string (insn) && !(single && tok.kind == FT_STRING))
+      {
+        op->value.cls = FVC_STRING;
+        op->value.u.s.p = filter_add_string (p, text, strlen (text), false);
+        op->value.u.s.n = (uint32_t) strlen (text);
+        return DDS_RETCODE_OK;
+      }
+      if (!single)
+        return DDS_RETCODE_BAD_PARAMETER;
+      switch (tok.kind)
+      {
+        case FT_IDENT: lit.kind = FRK_IDENT; lit.text = tok.text; lit.len = tok.len; break;
+        case FT_INT: case FT_FLOAT: lit.kind = FRK_NUMBER; lit.value = tok.value; break;
+        case FT_TRUE: case FT_FALSE: lit.kind = FRK_NUMBER; lit.value.cls = FVC_INT; lit.value.u.i = (tok.kind == FT_TRUE); break;
+        case FT_STRING: lit.kind = FRK_STRING; lit.text = tok.text; lit.len = tok.len; break;
+        default: return DDS_RETCODE_BAD_PARAMETER;
+      }
+      return filter_make_operand (p, op, &lit, field);
+    }
+
+    case FRK_STRING: {
+      const char *str = filter_add_string (p, ro->text, ro->len, true);
+      const uint32_t n = (uint32_t) strlen (str);
+      if (field_is_string (insn))
+      {
+        op->value.cls = FVC_STRING;
+        op->value.u.s.p = str;
+        op->value.u.s.n = n;
+        return DDS_RETCODE_OK;
+      }
+      else if (DDS_OP_TYPE (insn) == DDS_OP_VAL_1BY && n == 1)
+      {
+        // character literal
+        op->value.cls = FVC_INT;
+        op->value.u.i = (DDS_OP_FLAGS (insn) & DDS_OP_FLAG_SGN) ? (int64_t) (signed char) str[0] : (int64_t) (unsigned char) str[0];
+        return DDS_RETCODE_OK;
+      }
+      return DDS_RETCODE_BAD_PARAMETER;
+    }
+
+    case FRK_IDENT: {
+      const struct DDS_XTypes_CompleteEnumeratedType *enum_type = p->field_enums[field];
+      if (DDS_OP_TYPE (insn) != DDS_OP_VAL_ENU || enum_type == NULL)
+        return DDS_RETCODE_BAD_PARAMETER;
+      for (uint32_t i = 0; i < enum_type->literal_seq._length; i++)
+      {
+        const struct DDS_XTypes_CompleteEnumeratedLiteral *lit = &enum_type->literal_seq._buffer[i];
+        if (strlen (lit->detail.name) == ro->len && memcmp (lit->detail.name, ro->text, ro->len) == 0)
+        {
+          op->value.cls = FVC_INT;
+          op->value.u.i = lit->common.value;
+          return DDS_RETCODE_OK;
+        }
+      }
+      return DDS_RETCODE_BAD_PARAMETER;
+    }
+
+    case FRK_NUMBER:
+      if (field_is_string (insn))
+        return DDS_RETCODE_BAD_PARAMETER;
+      op->value = ro->value;
+      return DDS_RETCODE_OK;
+  }
+  return DDS_RETCODE_BAD_PARAMETER;
+}
+
+static void filter_emit (struct filter_parser *p, enum filter_opcode op, uint32_t arg)
+{
+  struct dds_filter_expr * const e = p->expr;
+  if (e->ninsns == p->maxinsns)
+  {
+    p->maxinsns = p->maxinsns ? 2 * p->maxinsns : 8;
+    e->insns = ddsrt_realloc (e->insns, p->maxinsns * sizeof (*e->insns));
+  }
+  e->insns[e->ninsns].op = op;
+  e->insns[e->ninsns].arg = arg;
+  e->ninsns++;
+}
+
+static dds_return_t filter_parse_predicate (struct filter_parser *p)
+{
+  struct dds_filter_expr * const e = p->expr;
+  struct filter_raw_operand a, b, c;
+  struct filter_pred pred;
+  bool negate = false;
+  dds_return_t rc;
+
+  if ((rc = filter_parse_raw_operand (p, &a)) != DDS_RETCODE_OK)
+    return rc;
+  if (p->tok.kind == FT_NOT)
+  {
+    negate = true;
+    filter_next (p);
+    if (p->tok.kind != FT_BETWEEN && p->tok.kind != FT_LIKE)
+      return DDS_RETCODE_BAD_PARAMETER;
+  }
+  switch (p->tok.kind)
+  {
+    case FT_EQ: pred.kind = FPK_EQ; break;
+    case FT_NE: pred.kind = FPK_NE; break;
+    case FT_LT: pred.kind = FPK_LT; break;
+    case FT_LE: pred.kind = FPK_LE; break;
+    case FT_GT: pred.kind = FPK_GT; break;
+    case FT_GE: pred.kind = FPK_GE; break;
+    case FT_BETWEEN: pred.kind = FPK_BETWEEN; break;
+    case FT_LIKE: pred.kind = FPK_LIKE; break;
+    default: return DDS_RETCODE_BAD_PARAMETER;
+  }
+  filter_next (p);
+  if ((rc = filter_parse_raw_operand (p, &b)) != DDS_RETCODE_OK)
+    return rc;
+  if (pred.kind == FPK_BETWEEN)
+  {
+    if (p->tok.kind != FT_AND)
+      return DDS_RETCODE_BAD_PARAMETER;
+    filter_next (p);
+    if ((rc = filter_parse_raw_operand (p, &c)) != DDS_RETCODE_OK)
+      return rc;
+  }
+
+  // at least one side must be a field, and that determines the types of the other operands
+  if (a.kind == FRK_FIELD)
+  {
+    if ((rc = filter_make_operand (p, &pred.a, &a, a.field)) != DDS_RETCODE_OK ||
+        (rc = filter_make_operand (p, &pred.b, &b, a.field)) != DDS_RETCODE_OK)
+      return rc;
+    if (pred.kind == FPK_BETWEEN && (rc = filter_make_operand (p, &pred.c, &c, a.field)) != DDS_RETCODE_OK)
+      return rc;
+  }
+  else if (b.kind == FRK_FIELD && pred.kind != FPK_BETWEEN && pred.kind != FPK_LIKE)
+  {
+    if ((rc = filter_make_operand (p, &pred.a, &a, b.field)) != DDS_RETCODE_OK ||
+        (rc = filter_make_operand (p, &pred.b, &b, b.field)) != DDS_RETCODE_OK)
+      return rc;
+  }
+  else
+  {
+    return DDS_RETCODE_BAD_PARAMETER;
+  }
+
+  // comparing strings with numbers is not allowed
+  const struct filter_operand *ops[] = { &pred.a, &pred.b, &pred.c };
+  const bool str = field_is_string (e->field_insns[pred.a.is_field ? pred.a.field : pred.b.field]);
+  for (uint32_t i = 0; i < ((pred.kind == FPK_BETWEEN) ? 3u : 2u); i++)
+  {
+    const bool opstr = ops[i]->is_field ? field_is_string (e->field_insns[ops[i]->field]) : (ops[i]->value.cls == FVC_STRING);
+    if (opstr != str)
+      return DDS_RETCODE_BAD_PARAMETER;
+  }
+  if (pred.kind == FPK_LIKE && (!str || pred.b.is_field))
+    return DDS_RETCODE_BAD_PARAMETER;
+
+  if (e->npreds == p->maxpreds)
+  {
+    p->maxpreds = p->maxpreds ? 2 * p->maxpreds : 4;
+    e->preds = ddsrt_realloc (e->preds, p->maxpreds * sizeof (*e->preds));
+  }
+  e->preds[e->npreds] = pred;
+  filter_emit (p, FOP_PRED, e->npreds++);
+  if (negate)
+    filter_emit (p, FOP_NOT, 0);
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t filter_parse_or (struct filter_parser *p);
+
+static dds_return_t filter_parse_factor (struct filter_parser *p)
+{
+  dds_return_t rc;
+  if (++p->depth > FILTER_MAX_DEPTH)
+    return DDS_RETCODE_BAD_PARAMETER;
+  if (p->tok.kind == FT_NOT)
+  {
+    filter_next (p);
+    if ((rc = filter_parse_factor (p)) == DDS_RETCODE_OK)
+      filter_emit (p, FOP_NOT, 0);
+  }
+  else if (p->tok.kind == FT_LPAREN)
+  {
+    filter_next (p);
+    if ((rc = filter_parse_or (p)) == DDS_RETCODE_OK)
+    {
+      if (p->tok.kind != FT_RPAREN)
+        rc = DDS_RETCODE_BAD_PARAMETER;
+      else
+        filter_next (p);
+    }
+  }
+  else
+  {
+    rc = filter_parse_predicate (p);
+  }
+  p->depth--;
+  return rc;
+}
+
+/* Parses "x (sep x)*", with the jumps for short-circuiting chained through their arguments
+   until the end is known */
+static dds_return_t filter_parse_chain (struct filter_parser *p, enum filter_tok sep, enum filter_opcode jump, dds_return_t (*parse) (struct filter_parser *p))
+{
+  uint32_t chain = UINT32_MAX;
+  dds_return_t rc;
+  if ((rc = parse (p)) != DDS_RETCODE_OK)
+    return rc;
+  while (p->tok.kind == sep)
+  {
+    filter_emit (p, jump, chain);
+    chain = p->expr->ninsns - 1;
+    filter_next (p);
+    if ((rc = parse (p)) != DDS_RETCODE_OK)
+      return rc;
+  }
+  while (chain != UINT32_MAX)
+  {
+    const uint32_t next = p->expr->insns[chain].arg;
+    p->expr->insns[chain].arg = p->expr->ninsns;
+    chain = next;
+  }
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t filter_parse_and (struct filter_parser *p)
+{
+  return filter_parse_chain (p, FT_AND, FOP_JF, filter_parse_factor);
+}
+
+static dds_return_t filter_parse_or (struct filter_parser *p)
+{
+  return filter_parse_chain (p, FT_OR, FOP_JT, filter_parse_and);
+}
+
+dds_return_t dds_filter_expr_compile (struct dds_filter_expr **expr, const struct ddsi_sertype *sertype, const char *expression, uint32_t nparams, const char * const *params)
+{
+  ddsi_typeid_t *type_id;
+  ddsi_typemap_t *typemap;
+  dds_return_t rc;
+
+  if (nparams > 0 && params == NULL)
+    return DDS_RETCODE_BAD_PARAMETER;
+  // members are located using the serializer instructions and resolved by name using the
+  // complete type information
+  if (sertype->ops != &dds_sertype_ops_default)
+    return DDS_RETCODE_UNSUPPORTED;
+  if ((type_id = ddsi_sertype_typeid (sertype, DDSI_TYPEID_KIND_COMPLETE)) == NULL)
+    return DDS_RETCODE_UNSUPPORTED;
+  if ((typemap = ddsi_sertype_typemap (sertype)) == NULL)
+  {
+    ddsi_typeid_fini (type_id);
+    ddsrt_free (type_id);
+    return DDS_RETCODE_UNSUPPORTED;
+  }
+
+  struct dds_filter_expr *e = ddsrt_calloc (1, sizeof (*e));
+  e->sertype = sertype;
+  e->desc = &((const struct dds_sertype_default *) sertype)->type;
+  e->field_paths = ddsrt_malloc (FILTER_MAX_FIELDS * sizeof (*e->field_paths));
+  e->field_insns = ddsrt_malloc (FILTER_MAX_FIELDS * sizeof (*e->field_insns));
+  struct filter_parser p = {
+    .pos = expression, .depth = 0, .expr = e, .nparams = nparams, .params = params,
+    .typemap = typemap, .type_id = type_id, .maxpreds = 0, .maxinsns = 0, .maxstrs = 0
+  };
+  filter_next (&p);
+  if ((rc = filter_parse_or (&p)) == DDS_RETCODE_OK && p.tok.kind != FT_END)
+    rc = DDS_RETCODE_BAD_PARAMETER;
+
+  ddsi_typemap_fini (typemap);
+  ddsrt_free (typemap);
+  ddsi_typeid_fini (type_id);
+  ddsrt_free (type_id);
+  if (rc != DDS_RETCODE_OK)
+  {
+    dds_filter_expr_free (e);
+    return rc;
+  }
+  e->expression = ddsrt_strdup (expression);
+  e->nparams = nparams;
+  e->params = nparams ? ddsrt_malloc (nparams * sizeof (*e->params)) : NULL;
+  for (uint32_t i = 0; i < nparams; i++)
+    e->params[i] = ddsrt_strdup (params[i] ? params[i] : "");
+  *expr = e;
+  return DDS_RETCODE_OK;
+}
+
+#else /* DDS_HAS_TYPELIB */
+
+dds_return_t dds_filter_expr_compile (struct dds_filter_expr **expr, const struct ddsi_sertype *sertype, const char *expression, uint32_t nparams, const char * const *params)
+{
+  (void) expr; (void) sertype; (void) expression; (void) nparams; (void) params;
+  return DDS_RETCODE_UNSUPPORTED;
+}
+
+#endif /* DDS_HAS_TYPELIB */
+
+/*******************************************************************************************
+ **
+ **  Evaluating
+ **
+ *******************************************************************************************/
+
+static double filter_value_to_double (const struct filter_value *v)
+{
+  switch (v->cls)
+  {
+    case FVC_INT: return (double) v->u.i;
+    case FVC_UINT: return (double) v->u.u;
+    case FVC_FLOAT: return v->u.f;
+    case FVC_STRING: break;
+  }
+  assert (0);
+  return 0.0;
+}
+
+static int filter_compare (const struct filter_value *a, const struct filter_value *b)
+{
+  if (a->cls == FVC_STRING)
+  {
+    assert (b->cls == FVC_STRING);
+    const int c = memcmp (a->u.s.p, b->u.s.p, (a->u.s.n < b->u.s.n) ? a->u.s.n : b->u.s.n);
+    if (c != 0)
+      return (c < 0) ? -1 : 1;
+    return (a->u.s.n > b->u.s.n) - (a->u.s.n < b->u.s.n);
+  }
+  else if (a->cls == FVC_FLOAT || b->cls == FVC_FLOAT)
+  {
+    const double x = filter_value_to_double (a), y = filter_value_to_double (b);
+    if (isnan (x) || isnan (y))
+      return FILTER_UNORDERED;
+    return (x > y) - (x < y);
+  }
+  else if (a->cls == FVC_INT && b->cls == FVC_INT)
+    return (a->u.i > b->u.i) - (a->u.i < b->u.i);
+  else if (a->cls == FVC_UINT && b->cls == FVC_UINT)
+    return (a->u.u > b->u.u) - (a->u.u < b->u.u);
+  else if (a->cls == FVC_INT)
+    return (a->u.i < 0) ? -1 : ((uint64_t) a->u.i > b->u.u) - ((uint64_t) a->u.i < b->u.u);
+  else
+    return (b->u.i < 0) ? 1 : (a->u.u > (uint64_t) b->u.i) - (a->u.u < (uint64_t) b->u.i);
+}
+
+static bool filter_like (const char *s, uint32_t n, const char *pat, uint32_t m)
+{
+  // "%" matches any sequence of characters, "_" any single character; backtracking to the
+  // most recent "%" suffices because a later "%" can match anything an earlier one can
+  uint32_t i = 0, j = 0, star_i = 0, star_j = UINT32_MAX;
+  while (i < n)
+  {
+    if (j < m && pat[j] == '%')
+    {
+      star_j = j++;
+      star_i = i;
+    }
+    else if (j < m && (pat[j] == '_' || pat[j] == s[i]))
+    {
+      i++;
+      j++;
+    }
+    else if (star_j != UINT32_MAX)
+    {
+      j = star_j + 1;
+      i = ++star_i;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (j < m && pat[j] == '%')
+    j++;
+  return j == m;
+}
+
+static const struct filter_value *filter_operand_value (const struct filter_operand *op, const struct filter_value *fv, uint64_t present)
+{
+  if (!op->is_field)
+    return &op->value;
+  else if (present & (UINT64_C (1) << op->field))
+    return &fv[op->field];
+  else
+    return NULL;
+}
+
+static bool filter_eval_pred (const struct filter_pred *pred, const struct filter_value *fv, uint64_t present)
+{
+  // a predicate involving a field that is not present (an optional member) is false
+  const struct filter_value *a, *b, *c;
+  int cmp;
+  if ((a = filter_operand_value (&pred->a, fv, present)) == NULL || (b = filter_operand_value (&pred->b, fv, present)) == NULL)
+    return false;
+  switch (pred->kind)
+  {
+    case FPK_EQ: return filter_compare (a, b) == 0;
+    case FPK_NE: return filter_compare (a, b) != 0;
+    case FPK_LT: return filter_compare (a, b) == -1;
+    case FPK_LE: cmp = filter_compare (a, b); return cmp == -1 || cmp == 0;
+    case FPK_GT: return filter_compare (a, b) == 1;
+    case FPK_GE: cmp = filter_compare (a, b); return cmp == 1 || cmp == 0;
+    case FPK_BETWEEN:
+      if ((c = filter_operand_value (&pred->c, fv, present)) == NULL)
+        return false;
+      cmp = filter_compare (a, b);
+      if (cmp != 0 && cmp != 1)
+        return false;
+      cmp = filter_compare (a, c);
+      return cmp == -1 || cmp == 0;
+    case FPK_LIKE:
+      return filter_like (a->u.s.p, a->u.s.n, b->u.s.p, b->u.s.n);
+  }
+  return false;
+}
+
+static bool filter_run (const struct dds_filter_expr *expr, const struct filter_value *fv, uint64_t present)
+{
+  bool acc = false;
+  uint32_t pc = 0;
+  while (pc < expr->ninsns)
+  {
+    const struct filter_insn * const insn = &expr->insns[pc];
+    switch (insn->op)
+    {
+      case FOP_PRED: acc = filter_eval_pred (&expr->preds[insn->arg], fv, present); pc++; break;
+      case FOP_NOT: acc = !acc; pc++; break;
+      case FOP_JF: pc = acc ? pc + 1 : insn->arg; break;
+      case FOP_JT: pc = acc ? insn->arg : pc + 1; break;
+    }
+  }
+  return acc;
+}
+
+static void filter_load_primitive (struct filter_value *v, uint32_t insn, const void *addr, uint32_t size)
+{
+  const bool sgn = (DDS_OP_TYPE (insn) != DDS_OP_VAL_ENU) && (DDS_OP_FLAGS (insn) & DDS_OP_FLAG_SGN);
+  const bool fp = (DDS_OP_TYPE (insn) != DDS_OP_VAL_ENU) && (DDS_OP_FLAGS (insn) & DDS_OP_FLAG_FP);
+  // memcpy because CDR is only aligned to 4 bytes for 8-byte types in XCDR2
+  switch (size)
+  {
+    case 1: { uint8_t x; memcpy (&x, addr, sizeof (x)); if (sgn) { v->cls = FVC_INT; v->u.i = (int8_t) x; } else { v->cls = FVC_UINT; v->u.u = x; } break; }
+    case 2: { uint16_t x; memcpy (&x, addr, sizeof (x)); if (sgn) { v->cls = FVC_INT; v->u.i = (int16_t) x; } else { v->cls = FVC_UINT; v->u.u = x; } break; }
+    case 4: {
+      if (fp) { float x; memcpy (&x, addr, sizeof (x)); v->cls = FVC_FLOAT; v->u.f = x; }
+      else { uint32_t x; memcpy (&x, addr, sizeof (x)); if (sgn) { v->cls = FVC_INT; v->u.i = (int32_t) x; } else { v->cls = FVC_UINT; v->u.u = x; } }
+      break;
+    }
+    case 8: {
+      if (fp) { double x; memcpy (&x, addr, sizeof (x)); v->cls = FVC_FLOAT; v->u.f = x; }
+      else { uint64_t x; memcpy (&x, addr, sizeof (x)); if (sgn) { v->cls = FVC_INT; v->u.i = (int64_t) x; } else { v->cls = FVC_UINT; v->u.u = x; } }
+      break;
+    }
+    default:
+      assert (0);
+  }
+}
+
+static uint32_t filter_primitive_size (uint32_t insn)
+{
+  switch (DDS_OP_TYPE (insn))
+  {
+    case DDS_OP_VAL_BLN: case DDS_OP_VAL_1BY: return 1;
+    case DDS_OP_VAL_2BY: return 2;
+    case DDS_OP_VAL_4BY: return 4;
+    case DDS_OP_VAL_8BY: return 8;
+    default: assert (0); return 0;
+  }
+}
+
+static void filter_load_cdr (struct filter_value *v, uint32_t insn, const unsigned char *addr)
+{
+  switch (DDS_OP_TYPE (insn))
+  {
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
+      // validated on receipt, so the length is within bounds and includes the terminating 0
+      uint32_t len;
+      memcpy (&len, addr, sizeof (len));
+      v->cls = FVC_STRING;
+      v->u.s.p = (const char *) addr + 4;
+      v->u.s.n = (len > 0) ? len - 1 : 0;
+      break;
+    }
+    case DDS_OP_VAL_ENU:
+      filter_load_primitive (v, insn, addr, DDS_OP_TYPE_SZ (insn));
+      break;
+    default:
+      filter_load_primitive (v, insn, addr, filter_primitive_size (insn));
+      break;
+  }
+}
+
+static bool filter_load_sample (struct filter_value *v, uint32_t insn, const void *addr)
+{
+  switch (DDS_OP_TYPE (insn))
+  {
+    case DDS_OP_VAL_STR: {
+      const char *s = *(const char * const *) addr;
+      if (s == NULL)
+      {
+        // a null pointer for a non-optional string is treated as an empty string
+        if (DDS_OP_FLAGS (insn) & DDS_OP_FLAG_OPT)
+          return false;
+        s = "";
+      }
+      v->cls = FVC_STRING;
+      v->u.s.p = s;
+      v->u.s.n = (uint32_t) strlen (s);
+      break;
+    }
+    case DDS_OP_VAL_BST:
+      v->cls = FVC_STRING;
+      v->u.s.p = addr;
+      v->u.s.n = (uint32_t) strlen (addr);
+      break;
+    case DDS_OP_VAL_ENU:
+      // in-memory representation of an enum is always 32 bits
+      filter_load_primitive (v, insn, addr, 4);
+      break;
+    default:
+      filter_load_primitive (v, insn, addr, filter_primitive_size (insn));
+      break;
+  }
+  return true;
+}
+
+bool dds_filter_expr_eval_sample (const struct dds_filter_expr *expr, const void *sample)
+{
+  struct filter_value fv[FILTER_MAX_FIELDS];
+  uint64_t present = 0;
+  for (uint32_t i = 0; i < expr->nfields; i++)
+  {
+    const void *addr = dds_stream_member_address (sample, expr->desc, &expr->field_paths[i]);
+    if (addr != NULL && filter_load_sample (&fv[i], expr->field_insns[i], addr))
+      present |= UINT64_C (1) << i;
+  }
+  return filter_run (expr, fv, present);
+}
+
+static bool filter_eval_cdr (const struct dds_filter_expr *expr, dds_istream_t *is)
+{
+  struct filter_value fv[FILTER_MAX_FIELDS];
+  uint32_t offsets[FILTER_MAX_FIELDS];
+  uint64_t present = 0;
+  dds_stream_locate_members (is, expr->desc, expr->nfields, expr->field_paths, offsets);
+  for (uint32_t i = 0; i < expr->nfields; i++)
+  {
+    if (offsets[i] != UINT32_MAX)
+    {
+      filter_load_cdr (&fv[i], expr->field_insns[i], is->m_buffer + offsets[i]);
+      present |= UINT64_C (1) << i;
+    }
+  }
+  return filter_run (expr, fv, present);
+}
+
+bool dds_filter_expr_eval_serdata (const struct dds_filter_expr *expr, const struct ddsi_serdata *serdata)
+{
+  assert (serdata->kind == SDK_DATA);
+  if (serdata->ops == &dds_serdata_ops_cdr || serdata->ops == &dds_serdata_ops_cdr_nokey ||
+      serdata->ops == &dds_serdata_ops_xcdr2 || serdata->ops == &dds_serdata_ops_xcdr2_nokey)
+  {
+    // derived sertypes (for other data representations) share the instructions
+    const struct dds_serdata_default *d = (const struct dds_serdata_default *) serdata;
+    const struct dds_sertype_default *tp = (const struct dds_sertype_default *) d->c.type;
+    if (tp->type.ops.ops == expr->desc->ops.ops)
+    {
+      if (d->c.loan == NULL || d->c.loan->metadata->sample_state == DDS_LOANED_SAMPLE_STATE_SERIALIZED_DATA)
+      {
+        dds_istream_t is;
+        dds_serdata_default_istream (&is, d);
+        return filter_eval_cdr (expr, &is);
+      }
+      else if (d->c.loan->metadata->sample_state == DDS_LOANED_SAMPLE_STATE_RAW_DATA && tp->c.is_memcpy_safe)
+      {
+        return dds_filter_expr_eval_sample (expr, d->c.loan->sample_ptr);
+      }
+    }
+  }
+
+  // anything else gets deserialized, samples that can't be deserialized are best never accepted
+  void *sample = ddsi_sertype_alloc_sample (expr->sertype);
+  const bool ret = ddsi_serdata_to_sample (serdata, sample, NULL, NULL) && dds_filter_expr_eval_sample (expr, sample);
+  ddsi_sertype_free_sample (expr->sertype, sample, DDS_FREE_ALL);
+  return ret;
+}
+
+/*******************************************************************************************
+ **
+ **  Writer-side filtering
+ **
+ *******************************************************************************************/
+
+ddsi_content_filter_property_t *dds_filter_expr_content_filter_property (const struct dds_filter_expr *expr, const char *topic_name)
+{
+  ddsi_content_filter_property_t *cfp = ddsrt_malloc (sizeof (*cfp));
+  cfp->content_filtered_topic_name = ddsrt_strdup (topic_name);
+  cfp->related_topic_name = ddsrt_strdup (topic_name);
+  cfp->filter_class_name = ddsrt_strdup (DDS_FILTER_CLASS_NAME);
+  cfp->filter_expression = ddsrt_strdup (expr->expression);
+  cfp->expression_parameters.n = expr->nparams;
+  cfp->expression_parameters.strs = expr->nparams ? ddsrt_malloc (expr->nparams * sizeof (*cfp->expression_parameters.strs)) : NULL;
+  for (uint32_t i = 0; i < expr->nparams; i++)
+    cfp->expression_parameters.strs[i] = ddsrt_strdup (expr->params[i]);
+  return cfp;
+}
+
+void dds_filter_content_filter_property_free (ddsi_content_filter_property_t *cfp)
+{
+  if (cfp == NULL)
+    return;
+  for (uint32_t i = 0; i < cfp->expression_parameters.n; i++)
+    ddsrt_free (cfp->expression_parameters.strs[i]);
+  ddsrt_free (cfp->expression_parameters.strs);
+  ddsrt_free (cfp->filter_expression);
+  ddsrt_free (cfp->filter_class_name);
+  ddsrt_free (cfp->related_topic_name);
+  ddsrt_free (cfp->content_filtered_topic_name);
+  ddsrt_free (cfp);
+}
+
+static void *dds_filter_cfif_compile (const struct ddsi_sertype *type, const struct ddsi_content_filter_property *cfp, void *arg)
+{
+  (void) arg;
+  struct dds_filter_expr *expr;
+  // filters of other classes and expressions that can't be evaluated for the writer's type
+  // simply result in everything being sent, the reader still filters the data it receives
+  if (cfp->filter_class_name == NULL || strcmp (cfp->filter_class_name, DDS_FILTER_CLASS_NAME) != 0)
+    return NULL;
+  const char * const *params = (const char * const *) cfp->expression_parameters.strs;
+  if (dds_filter_expr_compile (&expr, type, cfp->filter_expression, cfp->expression_parameters.n, params) != DDS_RETCODE_OK)
+    return NULL;
+  return expr;
+}
+
+static bool dds_filter_cfif_accepts (const void *filter, const struct ddsi_serdata *serdata, void *arg)
+{
+  (void) arg;
+  return dds_filter_expr_eval_serdata (filter, serdata);
+}
+
+static void dds_filter_cfif_free (void *filter, void *arg)
+{
+  (void) arg;
+  dds_filter_expr_free (filter);
+}
+
+void dds_filter_init_content_filter_interface (struct dds_domain *dom)
+{
+  dom->cfif.arg = dom;
+  dom->cfif.compile = dds_filter_cfif_compile;
+  dom->cfif.accepts = dds_filter_cfif_accepts;
+  dom->cfif.free = dds_filter_cfif_free;
+  dom->gv.content_filter_interface = &dom->cfif;
+}
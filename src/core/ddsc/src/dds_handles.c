@@ -14,6 +14,7 @@
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/random.h"
+#include "dds/ddsrt/threads.h"
 #include "dds/ddsrt/hopscotch.h"
 #include "dds/ddsi/ddsi_thread.h"
 #include "dds__handles.h"
@@ -51,11 +52,42 @@ built-in topics:
    reasonable */
 #define MAX_HANDLES (INT32_MAX / 128)
 
+/* Looking up a handle is lock-free (the table is a concurrent hopscotch hash
+   table), which means a lookup may return a link that is concurrently being
+   removed from the table.  Pinning such a link fails because it is marked as
+   closing/pending, but the memory must remain valid until the lookup has
+   finished.  So lookups register themselves in one of two counters selected by
+   the (low bit of the) epoch, and after removing a link, dds_handle_delete
+   advances the epoch and waits until the counters for the previous epoch have
+   drained.  The counters are striped over cache lines, with threads assigned
+   to stripes round-robin, so that threads pinning different entities don't
+   contend on a single cache line.
+
+   The waiting is done without holding handles.lock, so that creating and
+   deleting other handles isn't held up by a slow lookup.  Bucket arrays
+   discarded when the table grows (which happens with handles.lock held) are
+   therefore put on a list and freed after releasing the lock. */
+#define HANDLE_LOOKUP_STRIPES 16
+
+struct dds_handle_lookups {
+  ddsrt_atomic_uint32_t n[2];
+  char pad[DDSI_CACHE_LINE_SIZE - 2 * sizeof (ddsrt_atomic_uint32_t)];
+};
+
+struct handle_gc_buckets {
+  struct handle_gc_buckets *next;
+  void *bs;
+};
+
 struct dds_handle_server {
-  struct ddsrt_hh *ht;
+  struct ddsrt_chh *ht;
   size_t count;
-  ddsrt_mutex_t lock;
+  ddsrt_mutex_t lock; /* protects count and gc_buckets, serializes changes to ht */
   ddsrt_cond_t cond;
+  struct handle_gc_buckets *gc_buckets; /* bucket arrays to be freed once lookups have drained */
+  ddsrt_mutex_t epoch_lock; /* serializes advancing the epoch and waiting for the lookups to drain */
+  ddsrt_atomic_uint32_t epoch;
+  struct dds_handle_lookups lookups[HANDLE_LOOKUP_STRIPES];
 };
 
 static struct dds_handle_server handles;
@@ -74,15 +106,104 @@ static bool handle_equal (const void *va, const void *vb)
   return a->hdl == b->hdl;
 }
 
+static ddsrt_thread_local uint32_t handle_lookup_stripe = UINT32_MAX;
+static ddsrt_atomic_uint32_t handle_lookup_stripe_next = DDSRT_ATOMIC_UINT32_INIT (0);
+
+static ddsrt_atomic_uint32_t *handle_lookup_enter (void)
+{
+  if (handle_lookup_stripe == UINT32_MAX)
+    handle_lookup_stripe = ddsrt_atomic_inc32_ov (&handle_lookup_stripe_next) % HANDLE_LOOKUP_STRIPES;
+  struct dds_handle_lookups * const ls = &handles.lookups[handle_lookup_stripe];
+  ddsrt_atomic_uint32_t *n;
+  uint32_t e;
+  /* the epoch must not have changed between reading it and registering the
+     lookup, else dds_handle_wait_for_lookups may not wait for this one */
+  do {
+    e = ddsrt_atomic_ld32 (&handles.epoch);
+    n = &ls->n[e & 1];
+    ddsrt_atomic_inc32 (n);
+    ddsrt_atomic_fence ();
+    if (ddsrt_atomic_ld32 (&handles.epoch) == e)
+      break;
+    ddsrt_atomic_dec32 (n);
+  } while (1);
+  return n;
+}
+
+static void handle_lookup_leave (ddsrt_atomic_uint32_t *n)
+{
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_dec32 (n);
+}
+
+static void handle_wait_for_lookups (void)
+{
+  /* called after removing a link or bucket array from the table, without
+     holding handles.lock: the lookups of the current epoch are the ones that
+     may have obtained a pointer to it, new lookups can't find it anymore.
+     Serializing the waiting guarantees that the lookups of all earlier
+     epochs have drained already. */
+  ddsrt_mutex_lock (&handles.epoch_lock);
+  ddsrt_atomic_fence ();
+  const uint32_t e = ddsrt_atomic_inc32_ov (&handles.epoch);
+  ddsrt_atomic_fence ();
+  for (uint32_t i = 0; i < HANDLE_LOOKUP_STRIPES; i++)
+  {
+    while (ddsrt_atomic_ld32 (&handles.lookups[i].n[e & 1]) != 0)
+      dds_sleepfor (DDS_USECS (1));
+  }
+  ddsrt_atomic_fence_acq ();
+  ddsrt_mutex_unlock (&handles.epoch_lock);
+}
+
+static void handle_gc_buckets (void *bs, void *arg)
+{
+  /* called when the table is resized, which only happens with handles.lock
+     held (from within dds_handle_create) */
+  (void) arg;
+  struct handle_gc_buckets * const gc = ddsrt_malloc (sizeof (*gc));
+  gc->bs = bs;
+  gc->next = handles.gc_buckets;
+  handles.gc_buckets = gc;
+}
+
+static void handle_unlock_and_gc (bool wait)
+{
+  /* unlocks handles.lock, then frees the bucket arrays discarded while it was
+     held after waiting for the lookups to drain; wait = true forces waiting
+     even if there are no bucket arrays to free */
+  struct handle_gc_buckets *gc = handles.gc_buckets;
+  handles.gc_buckets = NULL;
+  ddsrt_mutex_unlock (&handles.lock);
+  if (gc == NULL && !wait)
+    return;
+  handle_wait_for_lookups ();
+  while (gc != NULL)
+  {
+    struct handle_gc_buckets * const next = gc->next;
+    ddsrt_free (gc->bs);
+    ddsrt_free (gc);
+    gc = next;
+  }
+}
+
 dds_return_t dds_handle_server_init (void)
 {
   /* called with ddsrt's singleton mutex held (see dds_init/fini) */
   if (handles.ht == NULL)
   {
-    handles.ht = ddsrt_hh_new (128, handle_hash, handle_equal);
+    handles.ht = ddsrt_chh_new (128, handle_hash, handle_equal, handle_gc_buckets, NULL);
     handles.count = 0;
+    ddsrt_atomic_st32 (&handles.epoch, 0);
+    for (uint32_t i = 0; i < HANDLE_LOOKUP_STRIPES; i++)
+    {
+      ddsrt_atomic_st32 (&handles.lookups[i].n[0], 0);
+      ddsrt_atomic_st32 (&handles.lookups[i].n[1], 0);
+    }
+    handles.gc_buckets = NULL;
     ddsrt_mutex_init (&handles.lock);
     ddsrt_cond_init (&handles.cond);
+    ddsrt_mutex_init (&handles.epoch_lock);
   }
   return DDS_RETCODE_OK;
 }
@@ -93,8 +214,8 @@ void dds_handle_server_fini (void)
   if (handles.ht != NULL)
   {
 #ifndef NDEBUG
-    struct ddsrt_hh_iter it;
-    for (struct dds_handle_link *link = ddsrt_hh_iter_first (handles.ht, &it); link != NULL; link = ddsrt_hh_iter_next (&it))
+    struct ddsrt_chh_iter it;
+    for (struct dds_handle_link *link = ddsrt_chh_iter_first (handles.ht, &it); link != NULL; link = ddsrt_chh_iter_next (&it))
     {
       uintptr_t cf = ddsrt_atomic_ldptr (&link->cnt_flags);
       DDS_ERROR ("handle %"PRId32" pin %"PRIuPTR" refc %"PRIuPTR"%s%s%s\n", link->hdl,
@@ -104,9 +225,11 @@ void dds_handle_server_fini (void)
                  cf & HDL_FLAG_CLOSING ? " closing" : "",
                  cf & HDL_FLAG_DELETE_DEFERRED ? " delete-deferred" : "");
     }
-    assert (ddsrt_hh_iter_first (handles.ht, &it) == NULL);
+    assert (ddsrt_chh_iter_first (handles.ht, &it) == NULL);
 #endif
-    ddsrt_hh_free (handles.ht);
+    assert (handles.gc_buckets == NULL);
+    ddsrt_chh_free (handles.ht);
+    ddsrt_mutex_destroy (&handles.epoch_lock);
     ddsrt_cond_destroy (&handles.cond);
     ddsrt_mutex_destroy (&handles.lock);
     handles.ht = NULL;
@@ -124,7 +247,7 @@ static dds_handle_t dds_handle_create_int (struct dds_handle_link *link, bool im
     do {
       link->hdl = (int32_t) (ddsrt_random () & INT32_MAX);
     } while (link->hdl == 0 || link->hdl >= DDS_MIN_PSEUDO_HANDLE);
-  } while (!ddsrt_hh_add (handles.ht, link));
+  } while (!ddsrt_chh_add (handles.ht, link));
   return link->hdl;
 }
 
@@ -141,7 +264,7 @@ dds_handle_t dds_handle_create (struct dds_handle_link *link, bool implicit, boo
   {
     handles.count++;
     ret = dds_handle_create_int (link, implicit, allow_children, user_access);
-    ddsrt_mutex_unlock (&handles.lock);
+    handle_unlock_and_gc (false);
     assert (ret > 0);
   }
   return ret;
@@ -163,11 +286,11 @@ dds_return_t dds_handle_register_special (struct dds_handle_link *link, bool imp
     handles.count++;
     ddsrt_atomic_stptr (&link->cnt_flags, HDL_FLAG_PENDING | (implicit ? HDL_FLAG_IMPLICIT : HDL_REFCOUNT_UNIT) | (allow_children ? HDL_FLAG_ALLOW_CHILDREN : 0) | 1u);
     link->hdl = handle;
-    if (ddsrt_hh_add (handles.ht, link))
+    if (ddsrt_chh_add (handles.ht, link))
       ret = handle;
     else
       ret = DDS_RETCODE_BAD_PARAMETER;
-    ddsrt_mutex_unlock (&handles.lock);
+    handle_unlock_and_gc (false);
     assert (ret > 0);
   }
   return ret;
@@ -199,10 +322,12 @@ int32_t dds_handle_delete (struct dds_handle_link *link)
   assert ((cf & HDL_PINCOUNT_MASK) == 1u);
 #endif
   ddsrt_mutex_lock (&handles.lock);
-  ddsrt_hh_remove_present (handles.ht, link);
+  const bool present = ddsrt_chh_remove (handles.ht, link);
+  assert (present);
+  (void) present;
   assert (handles.count > 0);
   handles.count--;
-  ddsrt_mutex_unlock (&handles.lock);
+  handle_unlock_and_gc (true);
   return DDS_RETCODE_OK;
 }
 
@@ -221,8 +346,8 @@ static int32_t dds_handle_pin_int (dds_handle_t hdl, uintptr_t delta, bool from_
   if (handles.ht == NULL)
     return DDS_RETCODE_PRECONDITION_NOT_MET;
 
-  ddsrt_mutex_lock (&handles.lock);
-  *link = ddsrt_hh_lookup (handles.ht, &dummy);
+  ddsrt_atomic_uint32_t * const lookup = handle_lookup_enter ();
+  *link = ddsrt_chh_lookup (handles.ht, &dummy);
   if (*link == NULL)
     rc = DDS_RETCODE_BAD_PARAMETER;
   else
@@ -248,7 +373,7 @@ static int32_t dds_handle_pin_int (dds_handle_t hdl, uintptr_t delta, bool from_
       }
     } while (!ddsrt_atomic_casptr (&(*link)->cnt_flags, cf, cf + delta));
   }
-  ddsrt_mutex_unlock (&handles.lock);
+  handle_lookup_leave (lookup);
   return rc;
 }
 
@@ -277,8 +402,8 @@ int32_t dds_handle_pin_for_delete (dds_handle_t hdl, bool explicit, bool from_us
   if (handles.ht == NULL)
     return DDS_RETCODE_PRECONDITION_NOT_MET;
 
-  ddsrt_mutex_lock (&handles.lock);
-  *link = ddsrt_hh_lookup (handles.ht, &dummy);
+  ddsrt_atomic_uint32_t * const lookup = handle_lookup_enter ();
+  *link = ddsrt_chh_lookup (handles.ht, &dummy);
   if (*link == NULL)
     rc = DDS_RETCODE_BAD_PARAMETER;
   else
@@ -382,14 +507,13 @@ int32_t dds_handle_pin_for_delete (dds_handle_t hdl, bool explicit, bool from_us
       rc = ((cf1 & HDL_REFCOUNT_MASK) == 0 || (cf1 & HDL_FLAG_ALLOW_CHILDREN)) ? DDS_RETCODE_OK : DDS_RETCODE_TRY_AGAIN;
     } while (!ddsrt_atomic_casptr (&(*link)->cnt_flags, cf, cf1));
   }
-  ddsrt_mutex_unlock (&handles.lock);
+  handle_lookup_leave (lookup);
   return rc;
 }
 
 bool dds_handle_drop_childref_and_pin (struct dds_handle_link *link, bool may_delete_parent)
 {
   bool del_parent = false;
-  ddsrt_mutex_lock (&handles.lock);
   uintptr_t cf, cf1;
   do {
     cf = ddsrt_atomic_ldptr (&link->cnt_flags);
@@ -427,7 +551,6 @@ bool dds_handle_drop_childref_and_pin (struct dds_handle_link *link, bool may_de
       }
     }
   } while (!ddsrt_atomic_casptr (&link->cnt_flags, cf, cf1));
-  ddsrt_mutex_unlock (&handles.lock);
   return del_parent;
 }
 
@@ -442,6 +565,17 @@ void dds_handle_repin (struct dds_handle_link *link)
   (void) x;
 }
 
+static void handle_signal_close_wait (void)
+{
+  /* The pin count has dropped to 1 for a closing handle, which is what
+     dds_handle_close_wait is waiting for.  It checks the count with the lock
+     held, so taking the lock here guarantees the wakeup is not lost, and
+     limiting it to this transition keeps the lock out of the hot path. */
+  ddsrt_mutex_lock (&handles.lock);
+  ddsrt_cond_broadcast (&handles.cond);
+  ddsrt_mutex_unlock (&handles.lock);
+}
+
 void dds_handle_unpin (struct dds_handle_link *link)
 {
 #ifndef NDEBUG
@@ -451,12 +585,8 @@ void dds_handle_unpin (struct dds_handle_link *link)
   else
     assert ((cf & HDL_PINCOUNT_MASK) >= 1u);
 #endif
-  ddsrt_mutex_lock (&handles.lock);
   if ((ddsrt_atomic_decptr_nv (&link->cnt_flags) & (HDL_FLAG_CLOSING | HDL_PINCOUNT_MASK)) == (HDL_FLAG_CLOSING | 1u))
-  {
-    ddsrt_cond_broadcast (&handles.cond);
-  }
-  ddsrt_mutex_unlock (&handles.lock);
+    handle_signal_close_wait ();
 }
 
 void dds_handle_add_ref (struct dds_handle_link *link)
@@ -472,12 +602,8 @@ bool dds_handle_drop_ref (struct dds_handle_link *link)
     assert ((old & HDL_REFCOUNT_MASK) > 0);
     new = old - HDL_REFCOUNT_UNIT;
   } while (!ddsrt_atomic_casptr (&link->cnt_flags, old, new));
-  ddsrt_mutex_lock (&handles.lock);
   if ((new & (HDL_FLAG_CLOSING | HDL_PINCOUNT_MASK)) == (HDL_FLAG_CLOSING | 1u))
-  {
-    ddsrt_cond_broadcast (&handles.cond);
-  }
-  ddsrt_mutex_unlock (&handles.lock);
+    handle_signal_close_wait ();
   return ((new & HDL_REFCOUNT_MASK) == 0);
 }
 
@@ -490,12 +616,8 @@ bool dds_handle_unpin_and_drop_ref (struct dds_handle_link *link)
     assert ((old & HDL_PINCOUNT_MASK) > 0);
     new = old - HDL_REFCOUNT_UNIT - 1u;
   } while (!ddsrt_atomic_casptr (&link->cnt_flags, old, new));
-  ddsrt_mutex_lock (&handles.lock);
   if ((new & (HDL_FLAG_CLOSING | HDL_PINCOUNT_MASK)) == (HDL_FLAG_CLOSING | 1u))
-  {
-    ddsrt_cond_broadcast (&handles.cond);
-  }
-  ddsrt_mutex_unlock (&handles.lock);
+    handle_signal_close_wait ();
   return ((new & HDL_REFCOUNT_MASK) == 0);
 }
 
@@ -9,7 +9,7 @@
 // SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
 
 #include <string.h>
-#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/slab.h"
 #include "dds/ddsi/ddsi_sertype.h"
 #include "dds/cdr/dds_cdrstream.h"
 #include "dds__loaned_sample.h"
@@ -20,8 +20,13 @@ typedef struct dds_heap_loan {
   dds_loaned_sample_t c;
   struct dds_psmx_metadata metadata; // pointed to by c.metadata
   const struct ddsi_sertype *m_stype;
+  bool m_inline; // sample_ptr points into this object
 } dds_heap_loan_t;
 
+/* Samples of memcpy-safe types contain no pointers and so can be allocated together with
+   the loan from the slab allocator, in a single block, avoiding heap allocations. */
+#define HEAP_LOAN_INLINE_OFFSET ((sizeof (dds_heap_loan_t) + 15) & ~(size_t) 15)
+
 static void heap_loan_free (dds_loaned_sample_t *loaned_sample)
   ddsrt_nonnull_all;
 
@@ -29,8 +34,8 @@ static void heap_loan_free (dds_loaned_sample_t *loaned_sample)
 {
   dds_heap_loan_t *hl = (dds_heap_loan_t *) loaned_sample;
   assert (hl->c.sample_ptr != NULL);
-  ddsi_sertype_free_sample (hl->m_stype, hl->c.sample_ptr, DDS_FREE_ALL);
-  ddsrt_free (hl);
+  ddsi_sertype_free_sample (hl->m_stype, hl->c.sample_ptr, hl->m_inline ? DDS_FREE_CONTENTS : DDS_FREE_ALL);
+  ddsrt_slab_free (hl);
 }
 
 void dds_heap_loan_reset (struct dds_loaned_sample *loaned_sample)
@@ -49,16 +54,23 @@ dds_return_t dds_heap_loan (const struct ddsi_sertype *type, dds_loaned_sample_s
 {
   assert (sample_state == DDS_LOANED_SAMPLE_STATE_UNITIALIZED || sample_state == DDS_LOANED_SAMPLE_STATE_RAW_KEY || sample_state == DDS_LOANED_SAMPLE_STATE_RAW_DATA);
 
-  dds_heap_loan_t *s = ddsrt_malloc (sizeof (*s));
+  const bool inline_sample = type->is_memcpy_safe;
+  dds_heap_loan_t *s = ddsrt_slab_malloc (inline_sample ? HEAP_LOAN_INLINE_OFFSET + type->sizeof_type : sizeof (*s));
   if (s == NULL)
     return DDS_RETCODE_OUT_OF_RESOURCES;
 
   s->c.metadata = &s->metadata;
   s->c.ops = dds_loan_heap_ops;
   s->m_stype = type;
-  if ((s->c.sample_ptr = ddsi_sertype_alloc_sample (type)) == NULL)
+  s->m_inline = inline_sample;
+  if (inline_sample)
+  {
+    s->c.sample_ptr = (char *) s + HEAP_LOAN_INLINE_OFFSET;
+    ddsi_sertype_zero_sample (type, s->c.sample_ptr);
+  }
+  else if ((s->c.sample_ptr = ddsi_sertype_alloc_sample (type)) == NULL)
   {
-    dds_free (s);
+    ddsrt_slab_free (s);
     return DDS_RETCODE_OUT_OF_RESOURCES;
   }
 
@@ -24,6 +24,7 @@
 #include "dds/ddsc/dds_psmx.h"
 #include "dds__loaned_sample.h"
 #include "dds__heap_loan.h"
+#include "dds__serdata_loan.h"
 
 void dds_read_collect_sample_arg_init (struct dds_read_collect_sample_arg *arg, void **ptrs, dds_sample_info_t *infos, struct dds_loan_pool *loan_pool, struct dds_loan_pool *heap_loan_cache)
 {
@@ -32,6 +33,7 @@ void dds_read_collect_sample_arg_init (struct dds_read_collect_sample_arg *arg,
   arg->infos = infos;
   arg->loan_pool = loan_pool;
   arg->heap_loan_cache = heap_loan_cache;
+  arg->take = false;
 }
 
 dds_return_t dds_read_collect_sample (void *varg, const dds_sample_info_t *si, const struct ddsi_sertype *st, struct ddsi_serdata *sd)
@@ -86,8 +88,23 @@ dds_return_t dds_read_collect_sample_loan (void *varg, const dds_sample_info_t *
   if ((ret = dds_read_collect_sample_loan_zerocopy (arg, si, sd)) <= 0)
     return ret;
 
-  const dds_loaned_sample_state_t state = (si->valid_data ? DDS_LOANED_SAMPLE_STATE_RAW_DATA : DDS_LOANED_SAMPLE_STATE_RAW_KEY);
   dds_loaned_sample_t *ls;
+  if (si->valid_data && arg->take && dds_serdata_loan (sd, &ls))
+  {
+    // no need to deserialize if the payload is laid out exactly like the sample and the
+    // serdata becomes private to the loan once it has been taken
+    if ((ret = dds_loan_pool_add_loan (arg->loan_pool, ls)) != DDS_RETCODE_OK)
+    {
+      dds_loaned_sample_unref (ls);
+      return ret;
+    }
+    arg->ptrs[arg->next_idx] = ls->sample_ptr;
+    arg->infos[arg->next_idx] = *si;
+    arg->next_idx++;
+    return DDS_RETCODE_OK;
+  }
+
+  const dds_loaned_sample_state_t state = (si->valid_data ? DDS_LOANED_SAMPLE_STATE_RAW_DATA : DDS_LOANED_SAMPLE_STATE_RAW_KEY);
   if (arg->heap_loan_cache && (ls = dds_loan_pool_get_loan (arg->heap_loan_cache)) != NULL) {
     // lucky us, we can reuse a cached loaned_sample
   } else if ((ret = dds_heap_loan (st, state, &ls)) == DDS_RETCODE_OK) {
@@ -243,6 +260,7 @@ static dds_return_t dds_read_impl (enum dds_read_impl_common_oper oper, dds_enti
 
   struct dds_read_collect_sample_arg collect_arg;
   dds_read_collect_sample_arg_init (&collect_arg, buf, si, rd->m_loans, rd->m_heap_loan_cache);
+  collect_arg.take = (oper == READ_OPER_TAKE);
   const bool use_loan = (buf[0] == NULL);
   const dds_read_with_collector_fn_t collect_sample = use_loan ? dds_read_collect_sample_loan : dds_read_collect_sample;
   ret = dds_read_impl_common (oper, rd, cond, maxs, mask, hand, collect_sample, &collect_arg);
@@ -34,7 +34,9 @@
 #include "dds__listener.h"
 #include "dds__init.h"
 #include "dds__rhc_default.h"
+#include "dds__rhc_sharded.h"
 #include "dds__topic.h"
+#include "dds__filter.h"
 #include "dds__get_status.h"
 #include "dds__qos.h"
 #include "dds__builtin.h"
@@ -484,6 +486,20 @@ const struct dds_entity_deriver dds_entity_deriver_reader = {
   .invoke_cbs_for_pending_events = dds_reader_invoke_cbs_for_pending_events
 };
 
+static struct dds_rhc *dds_reader_new_rhc (struct dds_reader *rd, const struct ddsi_sertype *type)
+{
+  /* The sharded RHC keeps the counts per shard and therefore can't enforce limits on the
+     total number of samples or instances */
+  const struct ddsi_domaingv *gv = &rd->m_entity.m_domain->gv;
+  const dds_qos_t *rqos = rd->m_entity.m_qos;
+  if (gv->config.rhc_shards > 1 &&
+      rqos->resource_limits.max_samples == DDS_LENGTH_UNLIMITED &&
+      rqos->resource_limits.max_instances == DDS_LENGTH_UNLIMITED)
+    return dds_rhc_sharded_new (rd, type, gv->config.rhc_shards);
+  else
+    return dds_rhc_default_new (rd, type);
+}
+
 static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscriber, dds_entity_t topic, dds_guid_t *guid, const dds_qos_t *qos, const dds_listener_t *listener, struct dds_rhc *rhc)
 {
   dds_subscriber *sub = NULL;
@@ -625,7 +641,7 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
   ddsrt_atomic_or32 (&rd->m_entity.m_status.m_status_and_mask, DDS_DATA_ON_READERS_STATUS << SAM_ENABLED_SHIFT);
   rd->m_sample_rejected_status.last_reason = DDS_NOT_REJECTED;
   rd->m_topic = tp;
-  rd->m_rhc = rhc ? rhc : dds_rhc_default_new (rd, tp->m_stype);
+  rd->m_rhc = rhc ? rhc : dds_reader_new_rhc (rd, tp->m_stype);
   rc = dds_loan_pool_create (&rd->m_loans, 0);
   assert (rc == DDS_RETCODE_OK); // FIXME: can be out of resources
   rc = dds_loan_pool_create (&rd->m_heap_loan_cache, 0);
@@ -669,12 +685,20 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
 
   /* Reader gets the sertype from the topic, as the serdata functions the reader uses are
      not specific for a data representation (the representation can be retrieved from the cdr header) */
-  rc = ddsi_new_reader (&rd->m_rd, &rd->m_entity.m_guid, NULL, pp, tp->m_name, tp->m_stype, rqos, &rd->m_rhc->common.rhc, dds_reader_status_cb, rd, vl_set);
+  /* A filter expression on the topic is advertised so that writers can apply it */
+  ddsi_content_filter_property_t *cfp = NULL;
+  ddsrt_mutex_lock (&tp->m_entity.m_mutex);
+  const struct dds_filter_expr *filter_expr;
+  if ((filter_expr = ddsrt_atomic_ldvoidp (&tp->m_filter_expr)) != NULL)
+    cfp = dds_filter_expr_content_filter_property (filter_expr, tp->m_name);
+  ddsrt_mutex_unlock (&tp->m_entity.m_mutex);
+  rc = ddsi_new_reader (&rd->m_rd, &rd->m_entity.m_guid, NULL, pp, tp->m_name, tp->m_stype, rqos, cfp, &rd->m_rhc->common.rhc, dds_reader_status_cb, rd, vl_set);
   if (rc != DDS_RETCODE_OK)
   {
     /* FIXME: can be out-of-resources at the very least; would leak allocated entity id */
     abort ();
   }
+  dds_filter_content_filter_property_free (cfp);
   dds_psmx_locators_set_free (vl_set);
   ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
 
@@ -25,6 +25,7 @@
 
 #include "dds__entity.h"
 #include "dds__reader.h"
+#include "dds__filter.h"
 #include "dds__loaned_sample.h"
 #include "dds/ddsc/dds_rhc.h"
 #include "dds__rhc_default.h"
@@ -246,7 +247,7 @@ struct rhc_sample {
   uint32_t disposed_gen;       /* snapshot of instance counter at time of insertion */
   uint32_t no_writers_gen;     /* __/ */
 #ifdef DDS_HAS_LIFESPAN
-  struct ddsi_lifespan_fhnode lifespan;  /* fibheap node for lifespan */
+  struct ddsi_lifespan_fhnode lifespan;  /* timer wheel node for lifespan */
   struct rhc_instance *inst;   /* reference to rhc instance */
 #endif
 };
@@ -320,8 +321,10 @@ struct dds_rhc_default {
   const struct ddsi_sertype *type;   /* type description */
   uint32_t history_depth;            /* depth, 1 for KEEP_LAST_1, 2**32-1 for KEEP_ALL */
 
+  bool is_shard;                     /* true if one of the shards of a sharded RHC (see dds_rhc_sharded.c) */
+
   ddsrt_mutex_t lock;
-  dds_readcond * conds;              /* List of associated read conditions */
+  dds_readcond **conds;              /* Array of associated read conditions */
   uint32_t nconds;                   /* Number of associated read conditions */
   uint32_t nqconds;                  /* Number of associated query conditions */
   dds_querycond_mask_t qconds_samplest;  /* Mask of associated query conditions that check the sample state */
@@ -561,7 +564,7 @@ ddsrt_mtime_t dds_rhc_default_deadline_missed_cb(void *hc, ddsrt_mtime_t tnow)
 }
 #endif /* DDS_HAS_DEADLINE_MISSED */
 
-struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, bool xchecks)
+static struct dds_rhc *rhc_default_new_common (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, bool xchecks, bool is_shard)
 {
   struct dds_rhc_default *rhc = ddsrt_malloc (sizeof (*rhc));
   memset (rhc, 0, sizeof (*rhc));
@@ -576,6 +579,7 @@ struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_dom
   rhc->tkmap = gv->m_tkmap;
   rhc->gv = gv;
   rhc->xchecks = xchecks;
+  rhc->is_shard = is_shard;
 
 #ifdef DDS_HAS_LIFESPAN
   ddsi_lifespan_init (gv, &rhc->lifespan, offsetof(struct dds_rhc_default, lifespan), offsetof(struct rhc_sample, lifespan), dds_rhc_default_sample_expired_cb);
@@ -589,6 +593,16 @@ struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_dom
   return &rhc->common;
 }
 
+struct dds_rhc *dds_rhc_default_new_xchecks (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, bool xchecks)
+{
+  return rhc_default_new_common (reader, gv, type, xchecks, false);
+}
+
+struct dds_rhc *dds_rhc_default_new_shard (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, bool xchecks)
+{
+  return rhc_default_new_common (reader, gv, type, xchecks, true);
+}
+
 struct dds_rhc *dds_rhc_default_new (struct dds_reader *reader, const struct ddsi_sertype *type)
 {
   return dds_rhc_default_new_xchecks (reader, &reader->m_entity.m_domain->gv, type, (reader->m_entity.m_domain->gv.config.enabled_xchecks & DDSI_XCHECK_RHC) != 0);
@@ -799,6 +813,7 @@ static void dds_rhc_default_free (struct ddsi_rhc *rhc_common)
   lwregs_fini (&rhc->registrations);
   if (rhc->qcond_eval_samplebuf != NULL)
     ddsi_sertype_free_sample (rhc->type, rhc->qcond_eval_samplebuf, DDS_FREE_ALL);
+  ddsrt_free (rhc->conds);
   ddsrt_mutex_destroy (&rhc->lock);
   ddsrt_free (rhc);
 }
@@ -936,9 +951,12 @@ static bool add_sample (struct dds_rhc_default *rhc, struct rhc_instance *inst,
   s->conds = 0;
   if (rhc->nqconds != 0)
   {
-    for (dds_readcond *rc = rhc->conds; rc != NULL; rc = rc->m_next)
+    for (uint32_t i = 0; i < rhc->nconds; i++)
+    {
+      const dds_readcond *rc = rhc->conds[i];
       if (rc->m_query.m_filter != NULL && eval_predicate_sample (rhc, s->sample, rc->m_query.m_filter))
         s->conds |= rc->m_query.m_qcmask;
+    }
   }
 
   trig_qc->inc_conds_sample = s->conds;
@@ -1035,7 +1053,7 @@ static bool inst_accepts_sample_by_writer_guid (const struct rhc_instance *inst,
   return (inst->wr_iid_islive && inst->wr_iid == wrinfo->iid) || memcmp (&wrinfo->guid, &inst->wr_guid, sizeof (inst->wr_guid)) < 0;
 }
 
-static bool inst_accepts_sample (const struct dds_rhc_default *rhc, const struct rhc_instance *inst, const struct ddsi_writer_info *wrinfo, const struct ddsi_serdata *sample, const bool has_data)
+static bool inst_accepts_sample (const struct dds_rhc_default *rhc, const struct rhc_instance *inst, const struct ddsi_writer_info *wrinfo, const struct ddsi_serdata *sample, const bool has_data, const bool filter_accepts)
 {
   if (rhc->by_source_ordering) {
     /* source ordering, so compare timestamps*/
@@ -1075,7 +1093,7 @@ static bool inst_accepts_sample (const struct dds_rhc_default *rhc, const struct
       return false;
     }
   }
-  if (has_data && !content_filter_accepts (rhc->reader, sample, inst, wrinfo->iid, inst->iid))
+  if (has_data && !(filter_accepts && content_filter_accepts (rhc->reader, sample, inst, wrinfo->iid, inst->iid)))
   {
     return false;
   }
@@ -1430,8 +1448,9 @@ static struct rhc_instance *alloc_new_instance (struct dds_rhc_default *rhc, con
 
   if (rhc->nqconds != 0)
   {
-    for (dds_readcond *c = rhc->conds; c != NULL; c = c->m_next)
+    for (uint32_t i = 0; i < rhc->nconds; i++)
     {
+      const dds_readcond *c = rhc->conds[i];
       assert ((dds_entity_kind (&c->m_entity) == DDS_KIND_COND_READ && c->m_query.m_filter == 0) ||
               (dds_entity_kind (&c->m_entity) == DDS_KIND_COND_QUERY && c->m_query.m_filter != 0));
       if (c->m_query.m_filter && eval_predicate_invsample (rhc, inst, c->m_query.m_filter))
@@ -1441,7 +1460,7 @@ static struct rhc_instance *alloc_new_instance (struct dds_rhc_default *rhc, con
   return inst;
 }
 
-static rhc_store_result_t rhc_store_new_instance (struct rhc_instance **out_inst, struct dds_rhc_default *rhc, const struct ddsi_writer_info *wrinfo, struct ddsi_serdata *sample, struct ddsi_tkmap_instance *tk, const bool has_data, ddsi_status_cb_data_t *cb_data, struct trigger_info_qcond *trig_qc, bool * __restrict nda)
+static rhc_store_result_t rhc_store_new_instance (struct rhc_instance **out_inst, struct dds_rhc_default *rhc, const struct ddsi_writer_info *wrinfo, struct ddsi_serdata *sample, struct ddsi_tkmap_instance *tk, const bool has_data, const bool filter_accepts, ddsi_status_cb_data_t *cb_data, struct trigger_info_qcond *trig_qc, bool * __restrict nda)
 {
   struct rhc_instance *inst;
   int ret;
@@ -1461,7 +1480,7 @@ static rhc_store_result_t rhc_store_new_instance (struct rhc_instance **out_inst
      attribute (rather than a key), an empty instance should be
      instantiated. */
 
-  if (has_data && !content_filter_accepts (rhc->reader, sample, NULL, wrinfo->iid, tk->m_iid))
+  if (has_data && !(filter_accepts && content_filter_accepts (rhc->reader, sample, NULL, wrinfo->iid, tk->m_iid)))
   {
     return RHC_FILTERED;
   }
@@ -1615,6 +1634,12 @@ static bool dds_rhc_default_store (struct ddsi_rhc * __restrict rhc_common, cons
 
   init_trigger_info_qcond (&trig_qc);
 
+  /* A filter expression only looks at the data, so it can be evaluated before locking the
+     RHC, but its verdict must still go through the normal processing so that a rejected
+     sample nonetheless registers the writer */
+  const struct dds_filter_expr *filter_expr = (rhc->reader && has_data) ? ddsrt_atomic_ldvoidp (&rhc->reader->m_topic->m_filter_expr) : NULL;
+  const bool filter_accepts = (filter_expr == NULL) || dds_filter_expr_eval_serdata (filter_expr, sample);
+
   ddsrt_mutex_lock (&rhc->lock);
 
   inst = ddsrt_hh_lookup (rhc->instances, &dummy_instance);
@@ -1632,14 +1657,14 @@ static bool dds_rhc_default_store (struct ddsi_rhc * __restrict rhc_common, cons
     else
     {
       TRACE (" new instance\n");
-      stored = rhc_store_new_instance (&inst, rhc, wrinfo, sample, tk, has_data, &cb_data, &trig_qc, &notify_data_available);
+      stored = rhc_store_new_instance (&inst, rhc, wrinfo, sample, tk, has_data, filter_accepts, &cb_data, &trig_qc, &notify_data_available);
       if (stored != RHC_STORED)
         goto error_or_nochange;
 
       init_trigger_info_cmn_nonmatch (&pre.c);
     }
   }
-  else if (!inst_accepts_sample (rhc, inst, wrinfo, sample, has_data))
+  else if (!inst_accepts_sample (rhc, inst, wrinfo, sample, has_data, filter_accepts))
   {
     /* Rejected samples (and disposes) should still register the writer;
        unregister *must* be processed, or we have a memory leak. (We
@@ -2469,8 +2494,10 @@ static bool dds_rhc_default_add_readcondition (struct dds_rhc *rhc_common, dds_r
 
   assert ((dds_entity_kind (&cond->m_entity) == DDS_KIND_COND_READ && cond->m_query.m_filter == 0) ||
           (dds_entity_kind (&cond->m_entity) == DDS_KIND_COND_QUERY && cond->m_query.m_filter != 0));
-  assert (ddsrt_atomic_ld32 (&cond->m_entity.m_status.m_trigger) == 0);
-  assert (cond->m_query.m_qcmask == 0);
+  /* A shard of a sharded RHC gets the condition after the preceding shards have already
+     allocated a query condition bit and possibly raised the trigger */
+  assert (rhc->is_shard || ddsrt_atomic_ld32 (&cond->m_entity.m_status.m_trigger) == 0);
+  assert (rhc->is_shard || cond->m_query.m_qcmask == 0);
 
   cond->m_qminv = qmask_from_dcpsquery (cond->m_sample_states, cond->m_view_states, cond->m_instance_states);
 
@@ -2480,25 +2507,33 @@ static bool dds_rhc_default_add_readcondition (struct dds_rhc *rhc_common, dds_r
   if (cond->m_query.m_filter != NULL)
   {
     dds_querycond_mask_t avail_qcmask = ~(dds_querycond_mask_t)0;
-    for (dds_readcond *rc = rhc->conds; rc != NULL; rc = rc->m_next)
+    for (uint32_t i = 0; i < rhc->nconds; i++)
     {
+      const dds_readcond *rc = rhc->conds[i];
       assert ((rc->m_query.m_filter == 0 && rc->m_query.m_qcmask == 0) || (rc->m_query.m_filter != 0 && rc->m_query.m_qcmask != 0));
       avail_qcmask &= ~rc->m_query.m_qcmask;
     }
-    if (avail_qcmask == 0)
+    if (cond->m_query.m_qcmask != 0)
+    {
+      /* all shards have the same set of conditions, so the bit allocated by the first one is
+         necessarily available in the others */
+      assert (rhc->is_shard && (avail_qcmask & cond->m_query.m_qcmask) != 0);
+    }
+    else if (avail_qcmask == 0)
     {
       /* no available indices */
       ddsrt_mutex_unlock (&rhc->lock);
       return false;
     }
-
-    /* use the least significant bit set */
-    cond->m_query.m_qcmask = avail_qcmask & (~avail_qcmask + 1);
+    else
+    {
+      /* use the least significant bit set */
+      cond->m_query.m_qcmask = avail_qcmask & (~avail_qcmask + 1);
+    }
   }
 
-  rhc->nconds++;
-  cond->m_next = rhc->conds;
-  rhc->conds = cond;
+  rhc->conds = ddsrt_realloc (rhc->conds, (rhc->nconds + 1) * sizeof (*rhc->conds));
+  rhc->conds[rhc->nconds++] = cond;
 
   uint32_t trigger = 0;
   if (cond->m_query.m_filter == NULL)
@@ -2552,8 +2587,8 @@ static bool dds_rhc_default_add_readcondition (struct dds_rhc *rhc_common, dds_r
 
   if (trigger)
   {
-    ddsrt_atomic_st32 (&cond->m_entity.m_status.m_trigger, trigger);
-    dds_entity_status_signal (&cond->m_entity, DDS_DATA_AVAILABLE_STATUS);
+    if (ddsrt_atomic_add32_ov (&cond->m_entity.m_status.m_trigger, trigger) == 0)
+      dds_entity_status_signal (&cond->m_entity, DDS_DATA_AVAILABLE_STATUS);
   }
 
   TRACE ("add_readcondition(%p, %"PRIx32", %"PRIx32", %"PRIx32") => %p qminv %"PRIx32" ; rhc %"PRIu32" conds\n",
@@ -2567,18 +2602,23 @@ static bool dds_rhc_default_add_readcondition (struct dds_rhc *rhc_common, dds_r
 static void dds_rhc_default_remove_readcondition (struct dds_rhc *rhc_common, dds_readcond *cond)
 {
   struct dds_rhc_default * const rhc = (struct dds_rhc_default *) rhc_common;
-  dds_readcond **ptr;
+  uint32_t i;
   ddsrt_mutex_lock (&rhc->lock);
-  ptr = &rhc->conds;
-  while (*ptr != cond)
-    ptr = &(*ptr)->m_next;
-  *ptr = (*ptr)->m_next;
-  rhc->nconds--;
+  for (i = 0; rhc->conds[i] != cond; i++)
+    assert (i + 1 < rhc->nconds);
+  memmove (&rhc->conds[i], &rhc->conds[i + 1], (rhc->nconds - i - 1) * sizeof (*rhc->conds));
+  if (--rhc->nconds == 0)
+  {
+    ddsrt_free (rhc->conds);
+    rhc->conds = NULL;
+  }
   if (cond->m_query.m_filter)
   {
     rhc->nqconds--;
     rhc->qconds_samplest &= ~cond->m_query.m_qcmask;
-    cond->m_query.m_qcmask = 0;
+    /* the sharded RHC releases the bit once all shards are done with it */
+    if (!rhc->is_shard)
+      cond->m_query.m_qcmask = 0;
     if (rhc->nqconds == 0)
     {
       assert (rhc->qcond_eval_samplebuf != NULL);
@@ -2593,7 +2633,6 @@ static bool update_conditions_locked (struct dds_rhc_default *rhc, bool called_f
 {
   /* Pre: rhc->lock held; returns 1 if triggering required, else 0. */
   bool trigger = false;
-  dds_readcond *iter;
   bool m_pre, m_post;
 
   TRACE ("update_conditions_locked(%p %p) - inst %"PRIu32" nonempty %"PRIu32" disp %"PRIu32" nowr %"PRIu32" new %"PRIu32" samples %"PRIu32" read %"PRIu32"\n",
@@ -2613,19 +2652,16 @@ static bool update_conditions_locked (struct dds_rhc_default *rhc, bool called_f
 #endif
   assert (rhc->n_vsamples >= rhc->n_vread);
 
-  iter = rhc->conds;
-  while (iter)
+  for (uint32_t ci = 0; ci < rhc->nconds; ci++)
   {
+    dds_readcond * const iter = rhc->conds[ci];
     m_pre = ((pre->c.qminst & iter->m_qminv) == 0);
     m_post = ((post->c.qminst & iter->m_qminv) == 0);
 
     /* Fast path out: instance did not and will not match based on instance, view states, so no
        need to evaluate anything else */
     if (!m_pre && !m_post)
-    {
-      iter = iter->m_next;
       continue;
-    }
 
     /* FIXME: use bitmask? */
     switch (iter->m_sample_states)
@@ -2786,7 +2822,6 @@ static bool update_conditions_locked (struct dds_rhc_default *rhc, bool called_f
       dds_entity_status_signal (&iter->m_entity, DDS_DATA_AVAILABLE_STATUS);
     }
     TRACE ("\n");
-    iter = iter->m_next;
   }
   return trigger;
 }
@@ -2859,14 +2894,14 @@ static bool rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_con
   dds_querycond_mask_t enabled_qcmask = 0;
   struct rhc_instance *inst;
   struct ddsrt_hh_iter iter;
-  dds_readcond *rciter;
   uint32_t i;
 
   for (i = 0; i < CHECK_MAX_CONDS; i++)
     cond_match_count[i] = 0;
 
-  for (rciter = rhc->conds; rciter; rciter = rciter->m_next)
+  for (i = 0; i < rhc->nconds; i++)
   {
+    const dds_readcond *rciter = rhc->conds[i];
     assert ((dds_entity_kind (&rciter->m_entity) == DDS_KIND_COND_READ && rciter->m_query.m_filter == 0) ||
             (dds_entity_kind (&rciter->m_entity) == DDS_KIND_COND_QUERY && rciter->m_query.m_filter != 0));
     assert ((rciter->m_query.m_filter != 0) == (rciter->m_query.m_qcmask != 0));
@@ -2928,9 +2963,9 @@ static bool rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_con
         dds_querycond_mask_t qcmask;
         untyped_to_clean_invsample (rhc->type, inst->tk->m_sample, rhc->qcond_eval_samplebuf, 0, 0);
         qcmask = 0;
-        for (rciter = rhc->conds; rciter; rciter = rciter->m_next)
-          if (rciter->m_query.m_filter != 0 && rciter->m_query.m_filter (rhc->qcond_eval_samplebuf))
-            qcmask |= rciter->m_query.m_qcmask;
+        for (i = 0; i < rhc->nconds; i++)
+          if (rhc->conds[i]->m_query.m_filter != 0 && rhc->conds[i]->m_query.m_filter (rhc->qcond_eval_samplebuf))
+            qcmask |= rhc->conds[i]->m_query.m_qcmask;
         assert ((inst->conds & enabled_qcmask) == qcmask);
         if (inst->latest)
         {
@@ -2939,17 +2974,18 @@ static bool rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_con
             // Follow error handling choices made in eval_predicate_sample()
             const bool asifmatch = !ddsi_serdata_to_sample (sample->sample, rhc->qcond_eval_samplebuf, NULL, NULL);
             qcmask = 0;
-            for (rciter = rhc->conds; rciter; rciter = rciter->m_next)
-              if (rciter->m_query.m_filter != 0 && (asifmatch || rciter->m_query.m_filter (rhc->qcond_eval_samplebuf)))
-                qcmask |= rciter->m_query.m_qcmask;
+            for (i = 0; i < rhc->nconds; i++)
+              if (rhc->conds[i]->m_query.m_filter != 0 && (asifmatch || rhc->conds[i]->m_query.m_filter (rhc->qcond_eval_samplebuf)))
+                qcmask |= rhc->conds[i]->m_query.m_qcmask;
             assert ((sample->conds & enabled_qcmask) == qcmask);
             sample = sample->next;
           } while (sample != end);
         }
       }
 
-      for (i = 0, rciter = rhc->conds; rciter && i < ncheck; i++, rciter = rciter->m_next)
+      for (i = 0; i < ncheck; i++)
       {
+        const dds_readcond *rciter = rhc->conds[i];
         if (!rhc_get_cond_trigger (inst, rciter))
           ;
         else if (rciter->m_query.m_filter == 0)
@@ -2981,10 +3017,11 @@ static bool rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_con
   assert (rhc->n_invsamples == n_invsamples);
   assert (rhc->n_invread == n_invread);
 
-  if (check_conds)
+  /* the triggers of a sharded RHC are the sums over all shards */
+  if (check_conds && !rhc->is_shard)
   {
-    for (i = 0, rciter = rhc->conds; rciter && i < ncheck; i++, rciter = rciter->m_next)
-      assert (cond_match_count[i] == ddsrt_atomic_ld32 (&rciter->m_entity.m_status.m_trigger));
+    for (i = 0; i < ncheck; i++)
+      assert (cond_match_count[i] == ddsrt_atomic_ld32 (&rhc->conds[i]->m_entity.m_status.m_trigger));
   }
 
   if (rhc->n_nonempty_instances == 0)
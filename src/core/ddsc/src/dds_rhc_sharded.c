@@ -0,0 +1,252 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <string.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/atomics.h"
+
+#include "dds__entity.h"
+#include "dds__reader.h"
+#include "dds/ddsc/dds_rhc.h"
+#include "dds__rhc_default.h"
+#include "dds__rhc_sharded.h"
+#include "dds/ddsi/ddsi_tkmap.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+
+/* SHARDED RHC
+   ===========
+
+   A thin layer over a number of default RHCs ("shards"), each with its own lock, that
+   routes every instance to a fixed shard based on its instance handle.  Store operations
+   only lock the shard of the instance, so samples for different instances arriving on
+   different threads no longer contend for a single lock, and neither do they contend
+   with an application reading or taking data from instances in another shard.
+
+   Operations concerning all instances are performed shard-by-shard.  For read/take
+   that means the result is not a snapshot of the entire reader history, but that is
+   not guaranteed by the default RHC either once max_samples is less than the number of
+   available samples.
+
+   Read conditions are attached to all shards.  The triggers are counters that are
+   updated atomically by the shards, so the value is the sum over the shards.  The query
+   condition bit is allocated by the first shard; because conditions are added and
+   removed in the same order for all shards, the other shards necessarily find the
+   same bit available. */
+
+struct dds_rhc_sharded {
+  struct dds_rhc common;
+  ddsrt_atomic_uint32_t next_shard;  /* first shard to visit for reading/taking all instances */
+  ddsrt_mutex_t conds_lock;          /* serialises adding/removing read conditions */
+  uint32_t nshards;
+  struct dds_rhc *shards[];
+};
+
+enum rhc_sharded_readtake_oper {
+  RHC_SHARDED_PEEK,
+  RHC_SHARDED_READ,
+  RHC_SHARDED_TAKE
+};
+
+static const struct dds_rhc_ops dds_rhc_sharded_ops;
+
+static struct dds_rhc *shard_for_iid (const struct dds_rhc_sharded *rhc, uint64_t iid)
+{
+  /* Instance handles are approximately uniformly distributed, but the default RHC uses
+     the low-order bits for its hash table, so use the high-order ones here */
+  return rhc->shards[(uint32_t) (iid >> 32) % rhc->nshards];
+}
+
+struct dds_rhc *dds_rhc_sharded_new_xchecks (dds_reader *reader, struct ddsi_domaingv *gv, const struct ddsi_sertype *type, uint32_t nshards, bool xchecks)
+{
+  assert (nshards > 0);
+  struct dds_rhc_sharded *rhc = ddsrt_malloc (sizeof (*rhc) + nshards * sizeof (rhc->shards[0]));
+  rhc->common.common.ops = &dds_rhc_sharded_ops;
+  ddsrt_atomic_st32 (&rhc->next_shard, 0);
+  ddsrt_mutex_init (&rhc->conds_lock);
+  rhc->nshards = nshards;
+  for (uint32_t i = 0; i < nshards; i++)
+    rhc->shards[i] = dds_rhc_default_new_shard (reader, gv, type, xchecks);
+  return &rhc->common;
+}
+
+struct dds_rhc *dds_rhc_sharded_new (dds_reader *reader, const struct ddsi_sertype *type, uint32_t nshards)
+{
+  struct ddsi_domaingv * const gv = &reader->m_entity.m_domain->gv;
+  return dds_rhc_sharded_new_xchecks (reader, gv, type, nshards, (gv->config.enabled_xchecks & DDSI_XCHECK_RHC) != 0);
+}
+
+uint32_t dds_rhc_sharded_nshards (const struct dds_rhc *rhc_common)
+{
+  const struct dds_rhc_sharded * const rhc = (const struct dds_rhc_sharded *) rhc_common;
+  assert (rhc->common.common.ops == &dds_rhc_sharded_ops);
+  return rhc->nshards;
+}
+
+struct dds_rhc *dds_rhc_sharded_shard (const struct dds_rhc *rhc_common, uint32_t idx)
+{
+  const struct dds_rhc_sharded * const rhc = (const struct dds_rhc_sharded *) rhc_common;
+  assert (rhc->common.common.ops == &dds_rhc_sharded_ops);
+  assert (idx < rhc->nshards);
+  return rhc->shards[idx];
+}
+
+static dds_return_t dds_rhc_sharded_associate (struct dds_rhc *rhc_common, dds_reader *reader, const struct ddsi_sertype *type, struct ddsi_tkmap *tkmap)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  dds_return_t ret = DDS_RETCODE_OK;
+  for (uint32_t i = 0; i < rhc->nshards && ret == DDS_RETCODE_OK; i++)
+    ret = dds_rhc_associate (rhc->shards[i], reader, type, tkmap);
+  return ret;
+}
+
+static bool dds_rhc_sharded_store (struct ddsi_rhc * __restrict rhc_common, const struct ddsi_writer_info * __restrict wrinfo, struct ddsi_serdata * __restrict sample, struct ddsi_tkmap_instance * __restrict tk)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  return dds_rhc_store (shard_for_iid (rhc, tk->m_iid), wrinfo, sample, tk);
+}
+
+static void dds_rhc_sharded_unregister_wr (struct ddsi_rhc * __restrict rhc_common, const struct ddsi_writer_info * __restrict wrinfo)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    dds_rhc_unregister_wr (rhc->shards[i], wrinfo);
+}
+
+static void dds_rhc_sharded_relinquish_ownership (struct ddsi_rhc * __restrict rhc_common, const uint64_t wr_iid)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    dds_rhc_relinquish_ownership (rhc->shards[i], wr_iid);
+}
+
+static void dds_rhc_sharded_set_qos (struct ddsi_rhc *rhc_common, const dds_qos_t *qos)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    dds_rhc_set_qos (rhc->shards[i], qos);
+}
+
+static void dds_rhc_sharded_free (struct ddsi_rhc *rhc_common)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    dds_rhc_free (rhc->shards[i]);
+  ddsrt_mutex_destroy (&rhc->conds_lock);
+  ddsrt_free (rhc);
+}
+
+static int32_t shard_readtake (enum rhc_sharded_readtake_oper oper, struct dds_rhc *shard, int32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond, dds_read_with_collector_fn_t collect_sample, void *collect_sample_arg)
+{
+  switch (oper)
+  {
+    case RHC_SHARDED_PEEK:
+      return dds_rhc_peek (shard, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+    case RHC_SHARDED_READ:
+      return dds_rhc_read (shard, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+    case RHC_SHARDED_TAKE:
+      return dds_rhc_take (shard, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+  }
+  return DDS_RETCODE_ERROR;
+}
+
+static int32_t rhc_sharded_readtake (enum rhc_sharded_readtake_oper oper, struct dds_rhc_sharded *rhc, int32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond, dds_read_with_collector_fn_t collect_sample, void *collect_sample_arg)
+{
+  if (handle)
+    return shard_readtake (oper, shard_for_iid (rhc, handle), max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+
+  /* Rotating the starting point avoids always returning data from the first shards if the
+     application reads/takes fewer samples at a time than are available */
+  const uint32_t first = ddsrt_atomic_inc32_ov (&rhc->next_shard) % rhc->nshards;
+  int32_t n = 0;
+  for (uint32_t i = 0; i < rhc->nshards && n < max_samples; i++)
+  {
+    struct dds_rhc * const shard = rhc->shards[(first + i) % rhc->nshards];
+    const int32_t m = shard_readtake (oper, shard, max_samples - n, mask, 0, cond, collect_sample, collect_sample_arg);
+    if (m < 0)
+      return (n == 0) ? m : n;
+    n += m;
+  }
+  return n;
+}
+
+static int32_t dds_rhc_sharded_peek (struct dds_rhc *rhc_common, int32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond, dds_read_with_collector_fn_t collect_sample, void *collect_sample_arg)
+{
+  return rhc_sharded_readtake (RHC_SHARDED_PEEK, (struct dds_rhc_sharded *) rhc_common, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+}
+
+static int32_t dds_rhc_sharded_read (struct dds_rhc *rhc_common, int32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond, dds_read_with_collector_fn_t collect_sample, void *collect_sample_arg)
+{
+  return rhc_sharded_readtake (RHC_SHARDED_READ, (struct dds_rhc_sharded *) rhc_common, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+}
+
+static int32_t dds_rhc_sharded_take (struct dds_rhc *rhc_common, int32_t max_samples, uint32_t mask, dds_instance_handle_t handle, dds_readcond *cond, dds_read_with_collector_fn_t collect_sample, void *collect_sample_arg)
+{
+  return rhc_sharded_readtake (RHC_SHARDED_TAKE, (struct dds_rhc_sharded *) rhc_common, max_samples, mask, handle, cond, collect_sample, collect_sample_arg);
+}
+
+static bool dds_rhc_sharded_add_readcondition (struct dds_rhc *rhc_common, dds_readcond *cond)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  bool ok;
+  ddsrt_mutex_lock (&rhc->conds_lock);
+  /* only the first shard can fail, by running out of query condition bits */
+  if ((ok = dds_rhc_add_readcondition (rhc->shards[0], cond)))
+  {
+    for (uint32_t i = 1; i < rhc->nshards; i++)
+    {
+      const bool ok1 = dds_rhc_add_readcondition (rhc->shards[i], cond);
+      assert (ok1);
+      (void) ok1;
+    }
+  }
+  ddsrt_mutex_unlock (&rhc->conds_lock);
+  return ok;
+}
+
+static void dds_rhc_sharded_remove_readcondition (struct dds_rhc *rhc_common, dds_readcond *cond)
+{
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  ddsrt_mutex_lock (&rhc->conds_lock);
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    dds_rhc_remove_readcondition (rhc->shards[i], cond);
+  if (cond->m_query.m_filter)
+    cond->m_query.m_qcmask = 0;
+  ddsrt_mutex_unlock (&rhc->conds_lock);
+}
+
+static uint32_t dds_rhc_sharded_lock_samples (struct dds_rhc *rhc_common)
+{
+  /* Same semantics as the default RHC: the shards that have samples remain locked */
+  struct dds_rhc_sharded * const rhc = (struct dds_rhc_sharded *) rhc_common;
+  uint32_t no = 0;
+  for (uint32_t i = 0; i < rhc->nshards; i++)
+    no += rhc->shards[i]->common.ops->lock_samples (rhc->shards[i]);
+  return no;
+}
+
+static const struct dds_rhc_ops dds_rhc_sharded_ops = {
+  .rhc_ops = {
+    .store = dds_rhc_sharded_store,
+    .unregister_wr = dds_rhc_sharded_unregister_wr,
+    .relinquish_ownership = dds_rhc_sharded_relinquish_ownership,
+    .set_qos = dds_rhc_sharded_set_qos,
+    .free = dds_rhc_sharded_free
+  },
+  .peek = dds_rhc_sharded_peek,
+  .read = dds_rhc_sharded_read,
+  .take = dds_rhc_sharded_take,
+  .add_readcondition = dds_rhc_sharded_add_readcondition,
+  .remove_readcondition = dds_rhc_sharded_remove_readcondition,
+  .lock_samples = dds_rhc_sharded_lock_samples,
+  .associate = dds_rhc_sharded_associate
+};
@@ -17,7 +17,7 @@
 #include "dds/ddsrt/log.h"
 #include "dds/ddsrt/md5.h"
 #include "dds/ddsrt/mh3.h"
-#include "dds/ddsi/ddsi_freelist.h"
+#include "dds/ddsrt/slab.h"
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/cdr/dds_cdrstream.h"
 #include "dds/ddsi/ddsi_radmin.h" /* sampleinfo */
@@ -65,12 +65,6 @@
 */
 
 
-/* 8k entries in the freelist seems to be roughly the amount needed to send
-   minimum-size (well, 4 bytes) samples as fast as possible over loopback
-   while using large messages -- actually, it stands to reason that this would
-   be the same as the WHC node pool size */
-#define MAX_POOL_SIZE 8192
-#define MAX_SIZE_FOR_POOL 256
 #define DEFAULT_NEW_SIZE 128
 #define CHUNK_SIZE 128
 
@@ -83,28 +77,11 @@ static int ispowerof2_size (size_t x)
 }
 #endif
 
-struct dds_serdatapool * dds_serdatapool_new (void)
-{
-  struct dds_serdatapool * pool;
-  pool = ddsrt_malloc (sizeof (*pool));
-  ddsi_freelist_init (&pool->freelist, MAX_POOL_SIZE, offsetof (struct dds_serdata_default, next));
-  return pool;
-}
-
-static void serdata_free_wrap (void *elem)
-{
-#ifndef NDEBUG
-  struct dds_serdata_default *d = elem;
-  assert(ddsrt_atomic_ld32(&d->c.refc) == 0);
-#endif
-  dds_free(elem);
-}
-
-void dds_serdatapool_free (struct dds_serdatapool * pool)
-{
-  ddsi_freelist_fini (&pool->freelist, serdata_free_wrap);
-  ddsrt_free (pool);
-}
+/* Serdata, including the serialized key if it is not of a bounded size, are allocated from
+   the slab allocator so that writing and receiving bounded types doesn't involve the heap. The
+   serialized data is written directly into the serdata and so the stream needs to use it as
+   well. */
+static const struct dds_cdrstream_allocator serdata_allocator = { ddsrt_slab_malloc, ddsrt_slab_realloc, ddsrt_slab_free };
 
 static size_t alignup_size (size_t x, size_t a)
 {
@@ -119,7 +96,7 @@ static void *serdata_default_append (struct dds_serdata_default **d, size_t n)
   if ((*d)->pos + n > (*d)->size)
   {
     size_t size1 = alignup_size ((*d)->pos + n, CHUNK_SIZE);
-    *d = ddsrt_realloc (*d, offsetof (struct dds_serdata_default, data) + size1);
+    *d = ddsrt_slab_realloc (*d, offsetof (struct dds_serdata_default, data) + size1);
     (*d)->size = (uint32_t)size1;
   }
   assert ((*d)->pos + n <= (*d)->size);
@@ -140,10 +117,35 @@ static const unsigned char *serdata_default_keybuf(const struct dds_serdata_defa
   return (d->key.buftype == KEYBUFTYPE_STATIC) ? d->key.u.stbuf : d->key.u.dynbuf;
 }
 
+static uint32_t hash_small_key (const uint64_t k[2])
+{
+  // finalizer of MurmurHash3_x64_128 applied to both halves
+  uint64_t h = k[0] ^ (k[1] * UINT64_C (0x9e3779b97f4a7c15));
+  h ^= h >> 33;
+  h *= UINT64_C (0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  h *= UINT64_C (0xc4ceb9fe1a85ec53);
+  h ^= h >> 33;
+  return (uint32_t) h;
+}
+
 static struct ddsi_serdata *fix_serdata_default(struct dds_serdata_default *d, uint32_t basehash)
 {
   assert (d->key.keysize > 0); // we use a different function for implementing the keyless case
-  d->c.hash = ddsrt_mh3 (serdata_default_keybuf(d), d->key.keysize, basehash); // FIXME: or the full buffer, regardless of actual size?
+  // The 128-bit hash is independent of the type so that eqkey can use it to compare keys of different
+  // (but compatible) types, the type is mixed into the 32-bit hash used for the hash tables
+  if (d->key.keysize <= sizeof (d->key.hash))
+  {
+    // Small keys (e.g., a single 32- or 64-bit integer) are used as-is, that makes eqkey trivial
+    d->key.hash[0] = d->key.hash[1] = 0;
+    memcpy (d->key.hash, serdata_default_keybuf(d), d->key.keysize);
+    d->c.hash = hash_small_key (d->key.hash) ^ basehash;
+  }
+  else
+  {
+    ddsrt_mh3_128 (serdata_default_keybuf(d), d->key.keysize, 0, d->key.hash);
+    d->c.hash = (uint32_t) (d->key.hash[0] ^ (d->key.hash[0] >> 32)) ^ basehash;
+  }
   return &d->c;
 }
 
@@ -164,7 +166,10 @@ static bool serdata_default_eqkey(const struct ddsi_serdata *acmn, const struct
   const struct dds_serdata_default *a = (const struct dds_serdata_default *)acmn;
   const struct dds_serdata_default *b = (const struct dds_serdata_default *)bcmn;
   assert (a->key.buftype != KEYBUFTYPE_UNSET && b->key.buftype != KEYBUFTYPE_UNSET);
-  return a->key.keysize == b->key.keysize && memcmp (serdata_default_keybuf(a), serdata_default_keybuf(b), a->key.keysize) == 0;
+  if (a->key.keysize != b->key.keysize || a->key.hash[0] != b->key.hash[0] || a->key.hash[1] != b->key.hash[1])
+    return false;
+  // small keys are stored in the hash, large ones need to be compared
+  return a->key.keysize <= sizeof (a->key.hash) || memcmp (serdata_default_keybuf(a), serdata_default_keybuf(b), a->key.keysize) == 0;
 }
 
 static bool serdata_default_eqkey_nokey (const struct ddsi_serdata *acmn, const struct ddsi_serdata *bcmn)
@@ -179,11 +184,10 @@ static void serdata_default_free(struct ddsi_serdata *dcmn)
   assert (ddsrt_atomic_ld32 (&d->c.refc) == 0);
 
   if (d->key.buftype == KEYBUFTYPE_DYNALLOC)
-    ddsrt_free (d->key.u.dynbuf);
+    ddsrt_slab_free (d->key.u.dynbuf);
   if (d->c.loan)
     dds_loaned_sample_unref (d->c.loan);
-  if (d->size > MAX_SIZE_FOR_POOL || !ddsi_freelist_push (&d->serpool->freelist, d))
-    dds_free (d);
+  ddsrt_slab_free (d);
 }
 
 static void serdata_default_init(struct dds_serdata_default *d, const struct dds_sertype_default *tp, enum ddsi_serdata_kind kind, uint32_t xcdr_version)
@@ -202,21 +206,12 @@ static void serdata_default_init(struct dds_serdata_default *d, const struct dds
   d->key.keysize = 0;
 }
 
-static struct dds_serdata_default *serdata_default_allocnew (struct dds_serdatapool *serpool, uint32_t init_size)
-{
-  struct dds_serdata_default *d = ddsrt_malloc (offsetof (struct dds_serdata_default, data) + init_size);
-  d->size = init_size;
-  d->serpool = serpool;
-  return d;
-}
-
 static struct dds_serdata_default *serdata_default_new_size (const struct dds_sertype_default *tp, enum ddsi_serdata_kind kind, uint32_t size, uint32_t xcdr_version)
 {
   struct dds_serdata_default *d;
-  if (size <= MAX_SIZE_FOR_POOL && (d = ddsi_freelist_pop (&tp->serpool->freelist)) != NULL)
-    ddsrt_atomic_st32 (&d->c.refc, 1);
-  else if ((d = serdata_default_allocnew (tp->serpool, size)) == NULL)
+  if ((d = ddsrt_slab_malloc (offsetof (struct dds_serdata_default, data) + size)) == NULL)
     return NULL;
+  d->size = size;
   serdata_default_init (d, tp, kind, xcdr_version);
   return d;
 }
@@ -297,7 +292,7 @@ static bool gen_serdata_key (const struct dds_sertype_default *type, struct dds_
   {
     // Force the key in the serdata object to be serialized in XCDR2 format
     dds_ostream_t os;
-    dds_ostream_init (&os, &dds_cdrstream_default_allocator, 0, DDSI_RTPS_CDR_ENC_VERSION_2);
+    dds_ostream_init (&os, &serdata_allocator, 0, DDSI_RTPS_CDR_ENC_VERSION_2);
     if (is_topic_fixed_key(desc->flagset, DDSI_RTPS_CDR_ENC_VERSION_2))
     {
       // FIXME: there are more cases where we don't have to allocate memory
@@ -307,17 +302,17 @@ static bool gen_serdata_key (const struct dds_sertype_default *type, struct dds_
     switch (input_kind)
     {
       case GSKIK_SAMPLE:
-        if (!dds_stream_write_key (&os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &dds_cdrstream_default_allocator, input, &type->type))
+        if (!dds_stream_write_key (&os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &serdata_allocator, input, &type->type))
           return false;
         break;
       case GSKIK_CDRSAMPLE:
-        if (!dds_stream_extract_key_from_data (input, &os, &dds_cdrstream_default_allocator, &type->type))
+        if (!dds_stream_extract_key_from_data (input, &os, &serdata_allocator, &type->type))
           return false;
         break;
       case GSKIK_CDRKEY:
         assert (is);
         assert (is->m_xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_1);
-        dds_stream_extract_key_from_key (is, &os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &dds_cdrstream_default_allocator, &type->type);
+        dds_stream_extract_key_from_key (is, &os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &serdata_allocator, &type->type);
         break;
     }
     assert (os.m_index < (1u << 30));
@@ -327,7 +322,7 @@ static bool gen_serdata_key (const struct dds_sertype_default *type, struct dds_
     else
     {
       kh->buftype = KEYBUFTYPE_DYNALLOC;
-      kh->u.dynbuf = ddsrt_realloc (os.m_buffer, os.m_index); // don't waste bytes FIXME: maybe should be willing to waste a little
+      kh->u.dynbuf = os.m_buffer; // shrinking it would only waste time, as it mostly wouldn't change the size class
     }
   }
   return true;
@@ -514,7 +509,7 @@ static struct ddsi_serdata *serdata_default_from_keyhash_cdr_nokey (const struct
   return fix_serdata_default_nokey(d, tp->c.serdata_basehash);
 }
 
-static void istream_from_serdata_default (dds_istream_t * __restrict s, const struct dds_serdata_default * __restrict d)
+void dds_serdata_default_istream (dds_istream_t * __restrict s, const struct dds_serdata_default * __restrict d)
 {
   if (d->c.loan != NULL &&
       (d->c.loan->metadata->sample_state == DDS_LOANED_SAMPLE_STATE_SERIALIZED_KEY ||
@@ -554,7 +549,7 @@ static void ostream_from_serdata_default (dds_ostream_t * __restrict s, const st
 static void ostream_add_to_serdata_default (dds_ostream_t * __restrict s, struct dds_serdata_default ** __restrict d)
 {
   /* DDSI requires 4 byte alignment */
-  const uint32_t pad = dds_cdr_alignto4_clear_and_resize (s, &dds_cdrstream_default_allocator, s->m_xcdr_version);
+  const uint32_t pad = dds_cdr_alignto4_clear_and_resize (s, &serdata_allocator, s->m_xcdr_version);
   assert (pad <= 3);
 
   /* Reset data pointer as stream may have reallocated */
@@ -580,7 +575,7 @@ static struct dds_serdata_default *serdata_default_from_sample_cdr_common (const
       ostream_add_to_serdata_default (&os, &d);
       break;
     case SDK_KEY: {
-      const bool ok = dds_stream_write_key (&os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &dds_cdrstream_default_allocator, sample, &tp->type);
+      const bool ok = dds_stream_write_key (&os, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &serdata_allocator, sample, &tp->type);
       ostream_add_to_serdata_default (&os, &d);
       if (!ok)
         goto error;
@@ -612,7 +607,7 @@ static struct dds_serdata_default *serdata_default_from_sample_cdr_common (const
       break;
     }
     case SDK_DATA: {
-      const bool ok = dds_stream_write_sample (&os, &dds_cdrstream_default_allocator, sample, &tp->type);
+      const bool ok = dds_stream_write_sample (&os, &serdata_allocator, sample, &tp->type);
       // `os` aliased what was in `d`, but was changed and may have moved.
       // `d` therefore needs to be updated even when write_sample failed.
       ostream_add_to_serdata_default (&os, &d);
@@ -681,6 +676,8 @@ static struct ddsi_serdata *serdata_default_to_untyped (const struct ddsi_serdat
     serdata_default_append_blob (&d_tl, d->key.keysize, serdata_default_keybuf (d));
     d_tl->key.buftype = KEYBUFTYPE_DYNALIAS;
     d_tl->key.keysize = d->key.keysize;
+    d_tl->key.hash[0] = d->key.hash[0];
+    d_tl->key.hash[1] = d->key.hash[1];
     d_tl->key.u.dynbuf = (unsigned char *) d_tl->data;
   }
   else
@@ -732,7 +729,7 @@ static bool serdata_default_to_sample_cdr (const struct ddsi_serdata *serdata_co
   else
   {
     assert (DDSI_RTPS_CDR_ENC_IS_NATIVE (d->hdr.identifier));
-    istream_from_serdata_default (&is, d);
+    dds_serdata_default_istream (&is, d);
     if (d->c.kind == SDK_KEY)
       dds_stream_read_key (&is, sample, &dds_cdrstream_default_allocator, &tp->type);
     else
@@ -777,7 +774,7 @@ static size_t serdata_default_print_cdr (const struct ddsi_sertype *sertype_comm
   }
   else
   {
-    istream_from_serdata_default (&is, d);
+    dds_serdata_default_istream (&is, d);
     if (d->c.kind == SDK_KEY)
       return dds_stream_print_key (&is, &tp->type, buf, size);
     else
@@ -0,0 +1,85 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+#include "dds/ddsrt/slab.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_sertype.h"
+#include "dds/cdr/dds_cdrstream.h"
+#include "dds__loaned_sample.h"
+#include "dds__serdata_default.h"
+#include "dds__serdata_loan.h"
+
+typedef struct dds_serdata_loan {
+  dds_loaned_sample_t c;
+  struct dds_psmx_metadata metadata; // pointed to by c.metadata
+  struct ddsi_serdata *m_serdata;
+} dds_serdata_loan_t;
+
+static void serdata_loan_free (dds_loaned_sample_t *loaned_sample)
+  ddsrt_nonnull_all;
+
+static void serdata_loan_free (dds_loaned_sample_t *loaned_sample)
+{
+  dds_serdata_loan_t *sl = (dds_serdata_loan_t *) loaned_sample;
+  ddsi_serdata_unref (sl->m_serdata);
+  ddsrt_slab_free (sl);
+}
+
+const dds_loaned_sample_ops_t dds_loan_serdata_ops = {
+  .free = serdata_loan_free
+};
+
+static bool serdata_is_sample_layout (const struct dds_serdata_default *d)
+{
+  const struct dds_sertype_default *tp = (const struct dds_sertype_default *) d->c.type;
+  if (tp == NULL || tp->c.ops != &dds_sertype_ops_default || !tp->c.is_memcpy_safe)
+    return false;
+  if (d->c.kind != SDK_DATA || d->c.loan != NULL)
+    return false;
+  assert (DDSI_RTPS_CDR_ENC_IS_NATIVE (d->hdr.identifier));
+  const uint32_t xcdr_version = ddsi_sertype_enc_id_xcdr_version (d->hdr.identifier);
+  const size_t opt_size = (xcdr_version == DDSI_RTPS_CDR_ENC_VERSION_1) ? tp->type.opt_size_xcdr1 : tp->type.opt_size_xcdr2;
+  if (opt_size == 0 || tp->type.align == 0 || ((uintptr_t) d->data % tp->type.align) != 0)
+    return false;
+  // The CDR representation may omit trailing padding of the C struct, but the application
+  // is handed a pointer to a complete object, so the buffer must be large enough to cover
+  // that padding as well.
+  const uint32_t pad = ddsrt_fromBE2u (d->hdr.options) & DDS_CDR_HDR_PADDING_MASK;
+  return d->pos - pad >= opt_size && d->size >= tp->c.sizeof_type;
+}
+
+bool dds_serdata_loan (struct ddsi_serdata *sd, struct dds_loaned_sample **loaned_sample)
+{
+  struct dds_serdata_default * const d = (struct dds_serdata_default *) sd;
+  if (!serdata_is_sample_layout (d))
+    return false;
+  // The application gets a writable pointer, so aliasing the payload is only allowed if
+  // nothing else can observe it: the caller's reference must be the only one.  Anyone
+  // else acquiring a reference must go through the caller, so this can't change under
+  // our feet.
+  if (ddsrt_atomic_ld32 (&sd->refc) != 1)
+    return false;
+
+  dds_serdata_loan_t * const s = ddsrt_slab_malloc (sizeof (*s));
+  s->c.metadata = &s->metadata;
+  s->c.ops = dds_loan_serdata_ops;
+  s->c.sample_ptr = d->data;
+  s->m_serdata = ddsi_serdata_ref (sd);
+  memset (&s->metadata, 0, sizeof (s->metadata));
+  s->metadata.sample_state = DDS_LOANED_SAMPLE_STATE_RAW_DATA;
+  s->metadata.cdr_identifier = DDSI_RTPS_SAMPLE_NATIVE;
+  s->metadata.sample_size = sd->type->sizeof_type;
+  s->c.loan_origin.origin_kind = DDS_LOAN_ORIGIN_KIND_SERDATA;
+  s->c.loan_origin.psmx_endpoint = NULL;
+  ddsrt_atomic_st32 (&s->c.refc, 1);
+  *loaned_sample = &s->c;
+  return true;
+}
@@ -18,6 +18,7 @@
 #include "dds/ddsrt/string.h"
 #include "dds/ddsrt/hopscotch.h"
 #include "dds__topic.h"
+#include "dds__filter.h"
 #include "dds__listener.h"
 #include "dds__participant.h"
 #include "dds__init.h"
@@ -33,6 +34,7 @@
 #include "dds/ddsi/ddsi_iid.h"
 #include "dds/ddsi/ddsi_plist.h"
 #include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_gc.h"
 #include "dds/ddsi/ddsi_security_omg.h"
 #include "dds/ddsi/ddsi_typebuilder.h"
 #include "dds/ddsc/dds_internal_api.h"
@@ -232,6 +234,7 @@ static void dds_topic_close (dds_entity *e)
 #ifdef DDS_HAS_TYPELIB
   ddsi_type_unref_sertype (&e->m_domain->gv, tp->m_stype);
 #endif
+  dds_filter_expr_free (ddsrt_atomic_ldvoidp (&tp->m_filter_expr));
   dds_free (tp->m_name);
 
   ddsrt_mutex_lock (&pp->m_entity.m_mutex);
@@ -939,6 +942,92 @@ dds_entity_t dds_find_topic_scoped (dds_find_scope_t scope, dds_entity_t partici
   return dds_find_topic_impl (scope, participant, name, NULL, timeout);
 }
 
+static void dds_topic_advertise_filter_reader (dds_topic *t, dds_reader *rd)
+{
+  /* Takes the filter from the topic only now, so that the last one set is also the last one
+     advertised when the filter is set concurrently */
+  ddsi_content_filter_property_t *cfp = NULL;
+  ddsrt_mutex_lock (&t->m_entity.m_mutex);
+  const struct dds_filter_expr *filter_expr;
+  if ((filter_expr = ddsrt_atomic_ldvoidp (&t->m_filter_expr)) != NULL)
+    cfp = dds_filter_expr_content_filter_property (filter_expr, t->m_name);
+  ddsrt_mutex_unlock (&t->m_entity.m_mutex);
+
+  struct ddsi_domaingv * const gv = &t->m_entity.m_domain->gv;
+  struct ddsi_reader *ddsi_rd;
+  ddsi_thread_state_awake (ddsi_lookup_thread_state (), gv);
+  if ((ddsi_rd = ddsi_entidx_lookup_reader_guid (gv->entity_index, &rd->m_entity.m_guid)) != NULL)
+    ddsi_update_reader_content_filter (ddsi_rd, cfp);
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+  dds_filter_content_filter_property_free (cfp);
+}
+
+static void dds_topic_advertise_filter_subscriber (dds_topic *t, dds_entity *sub)
+{
+  dds_instance_handle_t last_iid = 0;
+  dds_entity *rd;
+  ddsrt_mutex_lock (&sub->m_mutex);
+  while ((rd = ddsrt_avl_lookup_succ (&dds_entity_children_td, &sub->m_children, &last_iid)) != NULL)
+  {
+    dds_entity *x;
+    last_iid = rd->m_iid;
+    if (dds_entity_pin (rd->m_hdllink.hdl, &x) < 0)
+      continue;
+    ddsrt_mutex_unlock (&sub->m_mutex);
+    if (dds_entity_kind (x) == DDS_KIND_READER && ((dds_reader *) x)->m_topic == t)
+      dds_topic_advertise_filter_reader (t, (dds_reader *) x);
+    dds_entity_unpin (x);
+    ddsrt_mutex_lock (&sub->m_mutex);
+  }
+  ddsrt_mutex_unlock (&sub->m_mutex);
+}
+
+static void dds_topic_advertise_filter (dds_topic *t)
+{
+  /* Readers advertise the filter expression of their topic in discovery, so changing the
+     filter requires updating the discovery data of the existing readers of this topic.  The
+     topic is pinned, no locks are held. */
+  dds_entity * const pp = t->m_entity.m_parent;
+  dds_instance_handle_t last_iid = 0;
+  dds_entity *c;
+  assert (dds_entity_kind (pp) == DDS_KIND_PARTICIPANT);
+  ddsrt_mutex_lock (&pp->m_mutex);
+  while ((c = ddsrt_avl_lookup_succ (&dds_entity_children_td, &pp->m_children, &last_iid)) != NULL)
+  {
+    dds_entity *x;
+    last_iid = c->m_iid;
+    if (dds_entity_kind (c) != DDS_KIND_SUBSCRIBER || dds_entity_pin (c->m_hdllink.hdl, &x) < 0)
+      continue;
+    ddsrt_mutex_unlock (&pp->m_mutex);
+    dds_topic_advertise_filter_subscriber (t, x);
+    dds_entity_unpin (x);
+    ddsrt_mutex_lock (&pp->m_mutex);
+  }
+  ddsrt_mutex_unlock (&pp->m_mutex);
+}
+
+static void gc_filter_expr (struct ddsi_gcreq *gcreq)
+{
+  dds_filter_expr_free (ddsi_gcreq_get_arg (gcreq));
+  ddsi_gcreq_free (gcreq);
+}
+
+static bool dds_topic_replace_filter_expr (dds_topic *t, struct dds_filter_expr *expr)
+{
+  /* Readers and writers evaluate the expression without holding any locks but while awake,
+     so the old one can only be freed once all threads that might be using it have made
+     progress.  Returns whether the filter expression changed. */
+  struct dds_filter_expr * const old = ddsrt_atomic_ldvoidp (&t->m_filter_expr);
+  ddsrt_atomic_stvoidp (&t->m_filter_expr, expr);
+  if (old != NULL)
+  {
+    struct ddsi_gcreq *gcreq = ddsi_gcreq_new (t->m_entity.m_domain->gv.gcreq_queue, gc_filter_expr);
+    ddsi_gcreq_set_arg (gcreq, old);
+    ddsi_gcreq_enqueue (gcreq);
+  }
+  return (old != NULL || expr != NULL);
+}
+
 dds_return_t dds_set_topic_filter_extended (dds_entity_t topic, const struct dds_topic_filter *filter)
 {
   struct dds_topic_filter f;
@@ -981,7 +1070,36 @@ dds_return_t dds_set_topic_filter_extended (dds_entity_t topic, const struct dds
   if ((rc = dds_topic_lock (topic, &t)) != DDS_RETCODE_OK)
     return rc;
   t->m_filter = f;
-  dds_topic_unlock (t);
+  const bool had_filter_expr = dds_topic_replace_filter_expr (t, NULL);
+  ddsrt_mutex_unlock (&t->m_entity.m_mutex);
+  if (had_filter_expr)
+    dds_topic_advertise_filter (t);
+  dds_entity_unpin (&t->m_entity);
+  return DDS_RETCODE_OK;
+}
+
+dds_return_t dds_set_topic_filter_expression (dds_entity_t topic, const char *expression, uint32_t nparams, const char * const *params)
+{
+  struct dds_filter_expr *expr = NULL;
+  dds_topic *t;
+  dds_return_t rc;
+
+  if ((rc = dds_topic_lock (topic, &t)) != DDS_RETCODE_OK)
+    return rc;
+  if (expression != NULL && (rc = dds_filter_expr_compile (&expr, t->m_stype, expression, nparams, params)) != DDS_RETCODE_OK)
+  {
+    dds_topic_unlock (t);
+    return rc;
+  }
+  // an expression replaces a filter function and vice versa
+  t->m_filter.mode = DDS_TOPIC_FILTER_NONE;
+  t->m_filter.f.sample = NULL;
+  t->m_filter.arg = NULL;
+  const bool changed = dds_topic_replace_filter_expr (t, expr);
+  ddsrt_mutex_unlock (&t->m_entity.m_mutex);
+  if (changed)
+    dds_topic_advertise_filter (t);
+  dds_entity_unpin (&t->m_entity);
   return DDS_RETCODE_OK;
 }
 
@@ -1149,4 +1267,6 @@ void dds_cdrstream_desc_from_topic_desc (struct dds_cdrstream_desc *desc, const
   memset (desc, 0, sizeof (*desc));
   dds_cdrstream_desc_init (desc, &dds_cdrstream_default_allocator, topic_desc->m_size, topic_desc->m_align, topic_desc->m_flagset,
       topic_desc->m_ops, topic_desc->m_keys, topic_desc->m_nkeys);
+  if (topic_desc->m_flagset & DDS_TOPIC_TYPE_SERDES)
+    desc->funcs = topic_desc->m_funcs;
 }
@@ -51,9 +51,10 @@ struct dds_whc_default_node {
   ddsrt_mtime_t last_rexmit_ts;
   uint32_t rexmit_count;
 #ifdef DDS_HAS_LIFESPAN
-  struct ddsi_lifespan_fhnode lifespan; /* fibheap node for lifespan */
+  struct ddsi_lifespan_fhnode lifespan; /* timer wheel node for lifespan */
 #endif
   struct ddsi_serdata *serdata;
+  struct ddsi_serdata *xmit_serdata; /* NULL if not (yet) constructed */
 };
 DDSRT_STATIC_ASSERT (offsetof (struct dds_whc_default_node, common) == 0);
 
@@ -87,6 +88,8 @@ struct whc_writer_info {
   dds_writer * writer; /* can be NULL, eg in case of whc for built-in writers */
   unsigned is_transient_local: 1;
   unsigned has_deadline: 1;
+  unsigned has_lifespan: 1;
+  unsigned is_keyless: 1;
   uint32_t hdepth; /* 0 = unlimited */
   uint32_t tldepth; /* 0 = disabled/unlimited (no need to maintain an index if KEEP_ALL <=> is_transient_local + tldepth=0) */
   uint32_t idxdepth; /* = max (hdepth, tldepth) */
@@ -366,7 +369,8 @@ static struct dds_whc_default_node *whc_findkey (const struct whc_impl *whc, con
     return NULL;
   else
   {
-    assert (n->hist[n->headidx]);
+    /* the latest sample may already have been dropped (e.g., once acknowledged by all
+       readers of a volatile writer) while the instance is still known */
     return n->hist[n->headidx];
   }
 }
@@ -428,6 +432,12 @@ struct whc_writer_info *dds_whc_make_wrinfo (struct dds_writer *wr, const dds_qo
   wrinfo->writer = wr;
   wrinfo->is_transient_local = (qos->durability.kind == DDS_DURABILITY_TRANSIENT_LOCAL);
   wrinfo->has_deadline = (qos->deadline.deadline != DDS_INFINITY);
+#ifdef DDS_HAS_LIFESPAN
+  wrinfo->has_lifespan = (qos->lifespan.duration != DDS_INFINITY);
+#else
+  wrinfo->has_lifespan = 0;
+#endif
+  wrinfo->is_keyless = (wr != NULL && !wr->m_topic->m_stype->has_key);
   wrinfo->hdepth = (qos->history.kind == DDS_HISTORY_KEEP_ALL) ? 0 : (unsigned) qos->history.depth;
   if (!wrinfo->is_transient_local)
     wrinfo->tldepth = 0;
@@ -443,6 +453,14 @@ void dds_whc_free_wrinfo (struct whc_writer_info *info)
 }
 
 struct ddsi_whc *dds_whc_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wrinfo)
+{
+  if (wrinfo->is_keyless && !wrinfo->is_transient_local && !wrinfo->has_deadline && !wrinfo->has_lifespan)
+    return dds_whc_ring_new (gv, wrinfo->hdepth);
+  else
+    return dds_whc_default_new (gv, wrinfo);
+}
+
+struct ddsi_whc *dds_whc_default_new (struct ddsi_domaingv *gv, const struct whc_writer_info *wrinfo)
 {
   size_t sample_overhead = 80; /* INFO_TS, DATA (estimate), inline QoS */
   struct whc_impl *whc;
@@ -501,6 +519,8 @@ struct ddsi_whc *dds_whc_new (struct ddsi_domaingv *gv, const struct whc_writer_
 static void free_whc_node_contents (struct dds_whc_default_node *whcn)
 {
   ddsi_serdata_unref (whcn->serdata);
+  if (whcn->xmit_serdata)
+    ddsi_serdata_unref (whcn->xmit_serdata);
 }
 
 static void whc_default_free (struct ddsi_whc *whc_generic)
@@ -1124,6 +1144,7 @@ static struct dds_whc_default_node *whc_default_insert_seq (struct whc_impl *whc
   newn->last_rexmit_ts.v = 0;
   newn->rexmit_count = 0;
   newn->serdata = ddsi_serdata_ref (serdata);
+  newn->xmit_serdata = NULL;
   newn->next_seq = NULL;
   newn->prev_seq = whc->maxseq_node;
   if (newn->prev_seq)
@@ -1339,6 +1360,7 @@ static void make_borrowed_sample (struct ddsi_whc_borrowed_sample *sample, struc
   whcn->borrowed = 1;
   sample->seq = whcn->common.seq;
   sample->serdata = whcn->serdata;
+  sample->xmit_serdata = whcn->xmit_serdata;
   sample->unacked = whcn->unacked;
   sample->rexmit_count = whcn->rexmit_count;
   sample->last_rexmit_ts = whcn->last_rexmit_ts;
@@ -1385,11 +1407,15 @@ static void return_sample_locked (struct whc_impl *whc, struct ddsi_whc_borrowed
   {
     /* data no longer present in WHC */
     ddsi_serdata_unref (sample->serdata);
+    if (sample->xmit_serdata)
+      ddsi_serdata_unref (sample->xmit_serdata);
   }
   else
   {
     assert (whcn->borrowed);
+    assert (whcn->xmit_serdata == NULL || whcn->xmit_serdata == sample->xmit_serdata);
     whcn->borrowed = 0;
+    whcn->xmit_serdata = sample->xmit_serdata;
     if (update_retransmit_info)
     {
       whcn->rexmit_count = sample->rexmit_count;
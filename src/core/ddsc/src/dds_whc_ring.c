@@ -0,0 +1,560 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/misc.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_unused.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_protocol.h"
+#include "dds__whc.h"
+
+/* WHC for writers of keyless topics with volatile durability, no deadline and no
+ * lifespan.  With only a single instance the contents are simply the samples in sequence
+ * number order, which is kept in a circular array indexed by "seq - seq of first entry".
+ *
+ * Deleting a sample from the middle (because of a KEEP_LAST history) leaves a hole in the
+ * array, as do gaps in the sequence numbers: in those cases looking up a sequence number
+ * falls back to a binary search.  Holes are trimmed from both ends, so the first and the
+ * last entry are always present if the WHC is not empty.
+ *
+ * The samples that are part of the KEEP_LAST history of the instance have "in_hist" set.
+ * An unregister removes all samples from the history, which is why there can be older
+ * samples that are not in it.
+ *
+ * The lifespan QoS can be changed after creating the writer.  Instead of using a timer,
+ * expired samples are dropped whenever the WHC is touched: on inserting, processing an
+ * acknowledgement and borrowing samples, so that expired data never gets retransmitted.
+ * Expiry times are not ordered (reducing the lifespan makes a later sample expire before
+ * an earlier one), so this scans all entries, but only once the earliest expiry time of
+ * any sample in the WHC has been reached. */
+
+struct whc_ring_entry {
+  ddsi_seqno_t seq;
+  struct ddsi_serdata *serdata; /* NULL if deleted */
+  struct ddsi_serdata *xmit_serdata; /* NULL if not (yet) constructed */
+  size_t size;
+  ddsrt_mtime_t exp;
+  ddsrt_mtime_t last_rexmit_ts;
+  uint32_t rexmit_count;
+  unsigned unacked: 1; /* counted in whc::unacked_bytes iff 1 */
+  unsigned borrowed: 1; /* at most one can borrow it at any time */
+  unsigned in_hist: 1; /* part of the KEEP_LAST history */
+};
+
+struct whc_ring {
+  struct ddsi_whc common;
+  ddsrt_mutex_t lock;
+  struct ddsi_domaingv *gv;
+  uint32_t hdepth; /* 0 = unlimited */
+  uint32_t size; /* number of slots in ring, power of 2 */
+  uint32_t first; /* index of first entry */
+  uint32_t n; /* number of entries in use, including deleted ones */
+  uint32_t seq_size; /* number of samples */
+  uint32_t hist_count; /* number of samples with in_hist set */
+  size_t unacked_bytes;
+  size_t sample_overhead;
+  uint32_t fragment_size;
+  ddsi_seqno_t max_drop_seq;
+  ddsrt_mtime_t min_exp; /* lower bound on expiry times of samples present */
+  struct whc_ring_entry *ring;
+};
+
+struct whc_ring_sample_iter {
+  struct ddsi_whc_sample_iter_base c;
+  bool first;
+};
+
+/* check that our definition of whc_sample_iter fits in the type that callers allocate */
+DDSRT_STATIC_ASSERT (sizeof (struct whc_ring_sample_iter) <= sizeof (struct ddsi_whc_sample_iter));
+
+#define WHC_RING_INITIAL_SIZE 32
+
+#define TRACE(...) DDS_CLOG (DDS_LC_WHC, &whc->gv->logconfig, __VA_ARGS__)
+
+static struct whc_ring_entry *whc_ring_at (const struct whc_ring *whc, uint32_t i)
+{
+  assert (i < whc->n);
+  return &whc->ring[(whc->first + i) & (whc->size - 1)];
+}
+
+static void check_whc_ring (const struct whc_ring *whc)
+{
+  assert (whc->n <= whc->size);
+  assert (whc->seq_size <= whc->n);
+  assert ((whc->n == 0) == (whc->seq_size == 0));
+  assert (whc->hist_count <= whc->seq_size);
+  assert (whc->hdepth == 0 || whc->hist_count <= whc->hdepth);
+  if (whc->n > 0)
+  {
+    assert (whc_ring_at (whc, 0)->serdata != NULL);
+    assert (whc_ring_at (whc, whc->n - 1)->serdata != NULL);
+  }
+}
+
+/* Returns the index of the first entry with a sequence number >= seq, whc->n if there is
+   none; deleted entries are included */
+static uint32_t whc_ring_lower_bound (const struct whc_ring *whc, ddsi_seqno_t seq)
+{
+  if (whc->n == 0 || seq <= whc_ring_at (whc, 0)->seq)
+    return 0;
+  else if (seq > whc_ring_at (whc, whc->n - 1)->seq)
+    return whc->n;
+  const ddsi_seqno_t off = seq - whc_ring_at (whc, 0)->seq;
+  if (off < whc->n && whc_ring_at (whc, (uint32_t) off)->seq == seq)
+    return (uint32_t) off; /* no gaps */
+  uint32_t lo = 0, hi = whc->n;
+  while (lo < hi)
+  {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (whc_ring_at (whc, mid)->seq < seq)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static struct whc_ring_entry *whc_ring_findseq (const struct whc_ring *whc, ddsi_seqno_t seq)
+{
+  const uint32_t i = whc_ring_lower_bound (whc, seq);
+  struct whc_ring_entry *e;
+  if (i == whc->n || (e = whc_ring_at (whc, i))->seq != seq || e->serdata == NULL)
+    return NULL;
+  return e;
+}
+
+static struct whc_ring_entry *whc_ring_find_nextseq (const struct whc_ring *whc, ddsi_seqno_t seq)
+{
+  for (uint32_t i = whc_ring_lower_bound (whc, seq + 1); i < whc->n; i++)
+  {
+    struct whc_ring_entry * const e = whc_ring_at (whc, i);
+    if (e->serdata != NULL)
+      return e;
+  }
+  return NULL;
+}
+
+static void whc_ring_trim (struct whc_ring *whc)
+{
+  while (whc->n > 0 && whc_ring_at (whc, 0)->serdata == NULL)
+  {
+    whc->first = (whc->first + 1) & (whc->size - 1);
+    whc->n--;
+  }
+  while (whc->n > 0 && whc_ring_at (whc, whc->n - 1)->serdata == NULL)
+    whc->n--;
+  if (whc->n == 0)
+    whc->first = 0;
+}
+
+static void whc_ring_delete_one (struct whc_ring *whc, struct whc_ring_entry *e)
+{
+  assert (e->serdata != NULL);
+  if (e->unacked)
+  {
+    assert (whc->unacked_bytes >= e->size);
+    whc->unacked_bytes -= e->size;
+  }
+  if (e->in_hist)
+  {
+    assert (whc->hist_count > 0);
+    whc->hist_count--;
+  }
+  /* A borrowed sample is released when it is returned */
+  if (!e->borrowed)
+  {
+    ddsi_serdata_unref (e->serdata);
+    if (e->xmit_serdata)
+      ddsi_serdata_unref (e->xmit_serdata);
+  }
+  e->serdata = NULL;
+  e->xmit_serdata = NULL;
+  e->unacked = 0;
+  e->borrowed = 0;
+  e->in_hist = 0;
+  whc->seq_size--;
+}
+
+static void whc_ring_grow (struct whc_ring *whc)
+{
+  const uint32_t newsize = 2 * whc->size;
+  struct whc_ring_entry *newring = ddsrt_malloc (newsize * sizeof (*newring));
+  const uint32_t n1 = (whc->size - whc->first < whc->n) ? whc->size - whc->first : whc->n;
+  memcpy (newring, whc->ring + whc->first, n1 * sizeof (*newring));
+  memcpy (newring + n1, whc->ring, (whc->n - n1) * sizeof (*newring));
+  ddsrt_free (whc->ring);
+  whc->ring = newring;
+  whc->size = newsize;
+  whc->first = 0;
+}
+
+static void get_state_locked (const struct whc_ring *whc, struct ddsi_whc_state *st)
+{
+  if (whc->n == 0)
+  {
+    st->min_seq = st->max_seq = 0;
+    st->unacked_bytes = 0;
+  }
+  else
+  {
+    st->min_seq = whc_ring_at (whc, 0)->seq;
+    st->max_seq = whc_ring_at (whc, whc->n - 1)->seq;
+    st->unacked_bytes = whc->unacked_bytes;
+  }
+}
+
+static void whc_ring_get_state (const struct ddsi_whc *whc_generic, struct ddsi_whc_state *st)
+{
+  const struct whc_ring * const whc = (const struct whc_ring *) whc_generic;
+  ddsrt_mutex_lock ((ddsrt_mutex_t *) &whc->lock);
+  check_whc_ring (whc);
+  get_state_locked (whc, st);
+  ddsrt_mutex_unlock ((ddsrt_mutex_t *) &whc->lock);
+}
+
+static ddsi_seqno_t whc_ring_next_seq (const struct ddsi_whc *whc_generic, ddsi_seqno_t seq)
+{
+  const struct whc_ring * const whc = (const struct whc_ring *) whc_generic;
+  const struct whc_ring_entry *e;
+  ddsi_seqno_t nseq;
+  ddsrt_mutex_lock ((ddsrt_mutex_t *) &whc->lock);
+  check_whc_ring (whc);
+  if ((e = whc_ring_find_nextseq (whc, seq)) == NULL)
+    nseq = DDSI_MAX_SEQ_NUMBER;
+  else
+    nseq = e->seq;
+  ddsrt_mutex_unlock ((ddsrt_mutex_t *) &whc->lock);
+  return nseq;
+}
+
+static uint32_t whc_ring_drop_expired (struct whc_ring *whc)
+{
+  uint32_t ndropped = 0;
+  if (whc->min_exp.v == DDSRT_MTIME_NEVER.v)
+    return 0;
+  const ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+  if (tnow.v < whc->min_exp.v)
+    return 0;
+  ddsrt_mtime_t min_exp = DDSRT_MTIME_NEVER;
+  for (uint32_t i = 0; i < whc->n; i++)
+  {
+    struct whc_ring_entry * const e = whc_ring_at (whc, i);
+    if (e->serdata == NULL)
+      continue;
+    else if (e->exp.v <= tnow.v)
+    {
+      TRACE ("  expired %"PRIu64"\n", e->seq);
+      whc_ring_delete_one (whc, e);
+      ndropped++;
+    }
+    else if (e->exp.v < min_exp.v)
+    {
+      min_exp = e->exp;
+    }
+  }
+  whc_ring_trim (whc);
+  whc->min_exp = min_exp;
+  return ndropped;
+}
+
+static uint32_t whc_ring_remove_acked_messages (struct ddsi_whc *whc_generic, ddsi_seqno_t max_drop_seq, struct ddsi_whc_state *whcst, struct ddsi_whc_node **deferred_free_list)
+{
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  uint32_t ndropped = 0;
+  ddsrt_mutex_lock (&whc->lock);
+  assert (max_drop_seq < DDSI_MAX_SEQ_NUMBER);
+  assert (max_drop_seq >= whc->max_drop_seq);
+  check_whc_ring (whc);
+  TRACE ("whc_ring_remove_acked_messages(%p max_drop_seq %"PRIu64")\n", (void *) whc, max_drop_seq);
+
+  /* Volatile, so everything that has been acknowledged can go, and the entries are
+     ordered on sequence number */
+  while (whc->n > 0 && whc_ring_at (whc, 0)->seq <= max_drop_seq)
+  {
+    whc_ring_delete_one (whc, whc_ring_at (whc, 0));
+    whc_ring_trim (whc);
+    ndropped++;
+  }
+  ndropped += whc_ring_drop_expired (whc);
+  whc->max_drop_seq = max_drop_seq;
+  *deferred_free_list = NULL;
+  get_state_locked (whc, whcst);
+  ddsrt_mutex_unlock (&whc->lock);
+  return ndropped;
+}
+
+static void whc_ring_free_deferred_free_list (struct ddsi_whc *whc_generic, struct ddsi_whc_node *deferred_free_list)
+{
+  (void) whc_generic;
+  assert (deferred_free_list == NULL);
+  (void) deferred_free_list;
+}
+
+static size_t whc_ring_sample_size (const struct whc_ring *whc, const struct ddsi_serdata *serdata)
+{
+  size_t sz = ddsi_serdata_size (serdata);
+  return sz + ((sz + whc->fragment_size - 1) / whc->fragment_size) * whc->sample_overhead;
+}
+
+static int whc_ring_insert (struct ddsi_whc *whc_generic, ddsi_seqno_t max_drop_seq, ddsi_seqno_t seq, ddsrt_mtime_t exp, struct ddsi_serdata *serdata, struct ddsi_tkmap_instance *tk)
+{
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  DDSRT_UNUSED_ARG (tk);
+
+  ddsrt_mutex_lock (&whc->lock);
+  check_whc_ring (whc);
+  TRACE ("whc_ring_insert(%p max_drop_seq %"PRIu64" seq %"PRIu64" serdata %p)\n", (void *) whc, max_drop_seq, seq, (void *) serdata);
+  assert (max_drop_seq < DDSI_MAX_SEQ_NUMBER);
+  assert (max_drop_seq >= whc->max_drop_seq);
+  assert (whc->n == 0 || seq > whc_ring_at (whc, whc->n - 1)->seq);
+
+  (void) whc_ring_drop_expired (whc);
+  if (whc->n == whc->size)
+    whc_ring_grow (whc);
+  whc->n++;
+  struct whc_ring_entry * const newe = whc_ring_at (whc, whc->n - 1);
+  newe->seq = seq;
+  newe->serdata = ddsi_serdata_ref (serdata);
+  newe->xmit_serdata = NULL;
+  newe->size = whc_ring_sample_size (whc, serdata);
+  newe->exp = exp;
+  if (exp.v < whc->min_exp.v)
+    whc->min_exp = exp;
+  newe->last_rexmit_ts.v = 0;
+  newe->rexmit_count = 0;
+  newe->unacked = (seq > max_drop_seq);
+  newe->borrowed = 0;
+  newe->in_hist = 0;
+  if (newe->unacked)
+    whc->unacked_bytes += newe->size;
+  whc->seq_size++;
+
+  /* Empty data (such as commit messages) is not part of the history */
+  if (serdata->kind == SDK_EMPTY)
+    ;
+  else if (serdata->statusinfo & DDSI_STATUSINFO_UNREGISTER)
+  {
+    /* Unregistering the instance removes all samples from the history, acknowledged ones
+       are of no further use */
+    for (uint32_t i = 0; whc->hist_count > 0 && i < whc->n - 1; i++)
+    {
+      struct whc_ring_entry * const e = whc_ring_at (whc, i);
+      if (!e->in_hist)
+        continue;
+      if (e->seq <= max_drop_seq)
+        whc_ring_delete_one (whc, e);
+      else
+      {
+        e->in_hist = 0;
+        whc->hist_count--;
+      }
+    }
+    if (seq <= max_drop_seq)
+      whc_ring_delete_one (whc, newe);
+    whc_ring_trim (whc);
+  }
+  else if (whc->hdepth > 0)
+  {
+    newe->in_hist = 1;
+    if (++whc->hist_count > whc->hdepth)
+    {
+      /* Samples not in the history can only precede the oldest one in it, other than
+         empty ones, and so this usually stops at the first entry */
+      uint32_t i = 0;
+      while (!whc_ring_at (whc, i)->in_hist)
+        i++;
+      TRACE ("  prune %"PRIu64"\n", whc_ring_at (whc, i)->seq);
+      whc_ring_delete_one (whc, whc_ring_at (whc, i));
+      whc_ring_trim (whc);
+    }
+  }
+  ddsrt_mutex_unlock (&whc->lock);
+  return 0;
+}
+
+static void make_borrowed_sample (struct ddsi_whc_borrowed_sample *sample, struct whc_ring_entry *e)
+{
+  assert (!e->borrowed);
+  e->borrowed = 1;
+  sample->seq = e->seq;
+  sample->serdata = e->serdata;
+  sample->xmit_serdata = e->xmit_serdata;
+  sample->unacked = e->unacked;
+  sample->rexmit_count = e->rexmit_count;
+  sample->last_rexmit_ts = e->last_rexmit_ts;
+}
+
+static bool whc_ring_borrow_sample (const struct ddsi_whc *whc_generic, ddsi_seqno_t seq, struct ddsi_whc_borrowed_sample *sample)
+{
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  struct whc_ring_entry *e;
+  bool found;
+  ddsrt_mutex_lock (&whc->lock);
+  (void) whc_ring_drop_expired (whc);
+  if ((e = whc_ring_findseq (whc, seq)) == NULL)
+    found = false;
+  else
+  {
+    make_borrowed_sample (sample, e);
+    found = true;
+  }
+  ddsrt_mutex_unlock (&whc->lock);
+  return found;
+}
+
+static bool whc_ring_borrow_sample_key (const struct ddsi_whc *whc_generic, const struct ddsi_serdata *serdata_key, struct ddsi_whc_borrowed_sample *sample)
+{
+  /* Keyless, so any key matches the one instance, the latest sample of which is the most
+     recent one in the history */
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  bool found = false;
+  (void) serdata_key;
+  ddsrt_mutex_lock (&whc->lock);
+  (void) whc_ring_drop_expired (whc);
+  for (uint32_t i = whc->n; whc->hist_count > 0 && i > 0; i--)
+  {
+    struct whc_ring_entry * const e = whc_ring_at (whc, i - 1);
+    if (e->in_hist)
+    {
+      make_borrowed_sample (sample, e);
+      found = true;
+      break;
+    }
+  }
+  ddsrt_mutex_unlock (&whc->lock);
+  return found;
+}
+
+static void return_sample_locked (struct whc_ring *whc, struct ddsi_whc_borrowed_sample *sample, bool update_retransmit_info)
+{
+  struct whc_ring_entry *e;
+  if ((e = whc_ring_findseq (whc, sample->seq)) == NULL)
+  {
+    /* data no longer present in WHC */
+    ddsi_serdata_unref (sample->serdata);
+    if (sample->xmit_serdata)
+      ddsi_serdata_unref (sample->xmit_serdata);
+  }
+  else
+  {
+    assert (e->borrowed);
+    assert (e->xmit_serdata == NULL || e->xmit_serdata == sample->xmit_serdata);
+    e->borrowed = 0;
+    e->xmit_serdata = sample->xmit_serdata;
+    if (update_retransmit_info)
+    {
+      e->rexmit_count = sample->rexmit_count;
+      e->last_rexmit_ts = sample->last_rexmit_ts;
+    }
+  }
+}
+
+static void whc_ring_return_sample (struct ddsi_whc *whc_generic, struct ddsi_whc_borrowed_sample *sample, bool update_retransmit_info)
+{
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  ddsrt_mutex_lock (&whc->lock);
+  return_sample_locked (whc, sample, update_retransmit_info);
+  ddsrt_mutex_unlock (&whc->lock);
+}
+
+static void whc_ring_sample_iter_init (const struct ddsi_whc *whc_generic, struct ddsi_whc_sample_iter *opaque_it)
+{
+  struct whc_ring_sample_iter *it = (struct whc_ring_sample_iter *) opaque_it;
+  it->c.whc = (struct ddsi_whc *) whc_generic;
+  it->first = true;
+}
+
+static bool whc_ring_sample_iter_borrow_next (struct ddsi_whc_sample_iter *opaque_it, struct ddsi_whc_borrowed_sample *sample)
+{
+  struct whc_ring_sample_iter * const it = (struct whc_ring_sample_iter *) opaque_it;
+  struct whc_ring * const whc = (struct whc_ring *) it->c.whc;
+  struct whc_ring_entry *e;
+  ddsi_seqno_t seq;
+  bool valid;
+  ddsrt_mutex_lock (&whc->lock);
+  check_whc_ring (whc);
+  if (!it->first)
+  {
+    seq = sample->seq;
+    return_sample_locked (whc, sample, false);
+  }
+  else
+  {
+    it->first = false;
+    seq = 0;
+  }
+  (void) whc_ring_drop_expired (whc);
+  if ((e = whc_ring_find_nextseq (whc, seq)) == NULL)
+    valid = false;
+  else
+  {
+    make_borrowed_sample (sample, e);
+    valid = true;
+  }
+  ddsrt_mutex_unlock (&whc->lock);
+  return valid;
+}
+
+static void whc_ring_free (struct ddsi_whc *whc_generic)
+{
+  struct whc_ring * const whc = (struct whc_ring *) whc_generic;
+  check_whc_ring (whc);
+  for (uint32_t i = 0; i < whc->n; i++)
+  {
+    struct whc_ring_entry * const e = whc_ring_at (whc, i);
+    if (e->serdata)
+      ddsi_serdata_unref (e->serdata);
+    if (e->xmit_serdata)
+      ddsi_serdata_unref (e->xmit_serdata);
+  }
+  ddsrt_free (whc->ring);
+  ddsrt_mutex_destroy (&whc->lock);
+  ddsrt_free (whc);
+}
+
+static const struct ddsi_whc_ops whc_ring_ops = {
+  .insert = whc_ring_insert,
+  .remove_acked_messages = whc_ring_remove_acked_messages,
+  .free_deferred_free_list = whc_ring_free_deferred_free_list,
+  .get_state = whc_ring_get_state,
+  .next_seq = whc_ring_next_seq,
+  .borrow_sample = whc_ring_borrow_sample,
+  .borrow_sample_key = whc_ring_borrow_sample_key,
+  .return_sample = whc_ring_return_sample,
+  .sample_iter_init = whc_ring_sample_iter_init,
+  .sample_iter_borrow_next = whc_ring_sample_iter_borrow_next,
+  .free = whc_ring_free
+};
+
+struct ddsi_whc *dds_whc_ring_new (struct ddsi_domaingv *gv, uint32_t hdepth)
+{
+  struct whc_ring *whc = ddsrt_malloc (sizeof (*whc));
+  whc->common.ops = &whc_ring_ops;
+  ddsrt_mutex_init (&whc->lock);
+  whc->gv = gv;
+  whc->hdepth = hdepth;
+  whc->size = WHC_RING_INITIAL_SIZE;
+  whc->first = 0;
+  whc->n = 0;
+  whc->seq_size = 0;
+  whc->hist_count = 0;
+  whc->unacked_bytes = 0;
+  whc->sample_overhead = 80; /* INFO_TS, DATA (estimate), inline QoS */
+  whc->fragment_size = gv->config.fragment_size;
+  whc->max_drop_seq = 0;
+  whc->min_exp = DDSRT_MTIME_NEVER;
+  whc->ring = ddsrt_malloc (whc->size * sizeof (*whc->ring));
+  return &whc->common;
+}
@@ -10,6 +10,7 @@
 
 #include <assert.h>
 #include <string.h>
+#include "dds/ddsrt/heap.h"
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/ddsi/ddsi_thread.h"
 #include "dds/ddsi/ddsi_xmsg.h"
@@ -27,6 +28,7 @@
 #include "dds/ddsi/ddsi_addrset.h"
 #include "dds__heap_loan.h"
 #include "dds__writer.h"
+#include "dds__filter.h"
 #include "dds__write.h"
 #include "dds__loaned_sample.h"
 #include "dds__psmx.h"
@@ -34,6 +36,86 @@
 struct ddsi_serdata_plain { struct ddsi_serdata p; };
 struct ddsi_serdata_any   { struct ddsi_serdata a; };
 
+/* Writes done between dds_begin_batch and dds_end_batch use a packer owned by
+   the thread (one per domain) instead of the writer's, so that data from
+   different writers ends up in the same RTPS messages */
+struct dds_write_batch_xpack {
+  struct dds_write_batch_xpack *next;
+  struct ddsi_domaingv *gv;
+  struct ddsi_xpack *xp;
+};
+
+struct dds_write_batch {
+  uint32_t depth;
+  struct dds_write_batch_xpack *xps;
+};
+
+static ddsrt_thread_local struct dds_write_batch write_batch;
+
+static struct ddsi_xpack *dds_write_batch_lookup_xpack (const struct ddsi_domaingv *gv)
+{
+  for (struct dds_write_batch_xpack *bxp = write_batch.xps; bxp != NULL; bxp = bxp->next)
+    if (bxp->gv == gv)
+      return bxp->xp;
+  return NULL;
+}
+
+static struct ddsi_xpack *dds_write_batch_xpack (struct ddsi_domaingv *gv)
+{
+  struct dds_write_batch_xpack *bxp;
+  struct ddsi_xpack *xp;
+  if ((xp = dds_write_batch_lookup_xpack (gv)) != NULL)
+    return xp;
+  bxp = ddsrt_malloc (sizeof (*bxp));
+  bxp->gv = gv;
+  bxp->xp = ddsi_xpack_new (gv, false);
+  bxp->next = write_batch.xps;
+  write_batch.xps = bxp;
+  return bxp->xp;
+}
+
+static struct ddsi_xpack *dds_writer_xpack (dds_writer *wr, bool *flush)
+{
+  if (write_batch.depth > 0)
+  {
+    *flush = false;
+    return dds_write_batch_xpack (&wr->m_entity.m_domain->gv);
+  }
+  else
+  {
+    /* Flush out write unless configured to batch */
+    *flush = !wr->whc_batch;
+    return wr->m_xp;
+  }
+}
+
+dds_return_t dds_begin_batch (void)
+{
+  write_batch.depth++;
+  return DDS_RETCODE_OK;
+}
+
+dds_return_t dds_end_batch (void)
+{
+  if (write_batch.depth == 0)
+    return DDS_RETCODE_PRECONDITION_NOT_MET;
+  if (--write_batch.depth == 0)
+  {
+    struct ddsi_thread_state * const thrst = ddsi_lookup_thread_state ();
+    struct dds_write_batch_xpack *bxp;
+    while ((bxp = write_batch.xps) != NULL)
+    {
+      write_batch.xps = bxp->next;
+      ddsi_thread_state_awake (thrst, bxp->gv);
+      ddsi_xpack_send (bxp->xp, true);
+      ddsi_xpack_free (bxp->xp);
+      ddsi_thread_state_asleep (thrst);
+      ddsrt_free (bxp);
+    }
+  }
+  return DDS_RETCODE_OK;
+}
+
 dds_return_t dds_write (dds_entity_t writer, const void *data)
 {
   dds_return_t ret;
@@ -66,7 +148,9 @@ dds_return_t dds_writecdr (dds_entity_t writer, struct ddsi_serdata *serdata)
   }
   serdata->statusinfo = 0;
   serdata->timestamp.v = dds_time ();
-  ret = dds_writecdr_impl (wr, wr->m_xp, serdata, !wr->whc_batch);
+  bool flush;
+  struct ddsi_xpack * const xp = dds_writer_xpack (wr, &flush);
+  ret = dds_writecdr_impl (wr, xp, serdata, flush);
   dds_writer_unlock (wr);
   return ret;
 }
@@ -86,7 +170,9 @@ dds_return_t dds_forwardcdr (dds_entity_t writer, struct ddsi_serdata *serdata)
     dds_writer_unlock (wr);
     return DDS_RETCODE_ERROR;
   }
-  ret = dds_writecdr_impl (wr, wr->m_xp, serdata, !wr->whc_batch);
+  bool flush;
+  struct ddsi_xpack * const xp = dds_writer_xpack (wr, &flush);
+  ret = dds_writecdr_impl (wr, xp, serdata, flush);
   dds_writer_unlock (wr);
   return ret;
 }
@@ -400,7 +486,12 @@ static dds_return_t dds_writecdr_impl_common (struct dds_writer *wr, struct ddsi
 static bool evaluate_topic_filter (const dds_writer *wr, const void *data, enum ddsi_serdata_kind sdkind)
 {
   // false if data rejected by filter
-  if (wr->m_topic->m_filter.mode == DDS_TOPIC_FILTER_NONE || sdkind == SDK_KEY)
+  if (sdkind == SDK_KEY)
+    return true;
+  const struct dds_filter_expr *filter_expr;
+  if ((filter_expr = ddsrt_atomic_ldvoidp (&wr->m_topic->m_filter_expr)) != NULL)
+    return dds_filter_expr_eval_sample (filter_expr, data);
+  if (wr->m_topic->m_filter.mode == DDS_TOPIC_FILTER_NONE)
     return true;
 
   const struct dds_topic_filter *f = &wr->m_topic->m_filter;
@@ -436,12 +527,13 @@ static dds_return_t dds_write_impl_deliver_via_ddsi (struct ddsi_thread_state *
 
   struct ddsi_tkmap_instance *tk = ddsi_tkmap_lookup_instance_ref (wr->m_entity.m_domain->gv.m_tkmap, d);
 
+  bool flush;
+  struct ddsi_xpack * const xp = dds_writer_xpack (wr, &flush);
   (void) ddsi_serdata_ref(d);
-  ret = ddsi_write_sample_gc (ts, wr->m_xp, ddsi_wr, d, tk);
+  ret = ddsi_write_sample_gc (ts, xp, ddsi_wr, d, tk);
   if (ret >= 0) {
-    /* Flush out write unless configured to batch */
-    if (!wr->whc_batch)
-      ddsi_xpack_send (wr->m_xp, false);
+    if (flush)
+      ddsi_xpack_send (xp, false);
     ret = DDS_RETCODE_OK;
   } else if (ret != DDS_RETCODE_TIMEOUT) {
     ret = DDS_RETCODE_ERROR;
@@ -627,6 +719,10 @@ static dds_return_t dds_write_impl_psmxloan_serdata (struct dds_writer *wr, cons
           }
         }
         return DDS_RETCODE_OK;
+      case DDS_LOAN_ORIGIN_KIND_SERDATA:
+        // only ever handed out by readers
+        assert (0);
+        break;
     }
     return DDS_RETCODE_ERROR;
   }
@@ -680,8 +776,13 @@ dds_return_t dds_write_impl (dds_writer *wr, const void *data, dds_time_t timest
      ((action & DDS_WR_UNREGISTER_BIT) ? DDSI_STATUSINFO_UNREGISTER : 0));
   int ret = DDS_RETCODE_OK;
 
+  // awake while evaluating the filter, because a filter expression may be replaced concurrently
+  ddsi_thread_state_awake (thrst, &wr->m_entity.m_domain->gv);
   if (!evaluate_topic_filter (wr, data, sdkind))
+  {
+    ddsi_thread_state_asleep (thrst);
     return DDS_RETCODE_OK;
+  }
 
   // I. psmx loan => assert (psmx && is_memcpy_safe)
   //   a. psmx only
@@ -715,7 +816,6 @@ dds_return_t dds_write_impl (dds_writer *wr, const void *data, dds_time_t timest
   //       - deliver serdata
   //   c. no psmx
   //     - ddsi_serdata_from_sample, deliver serdata
-  ddsi_thread_state_awake (thrst, &wr->m_entity.m_domain->gv);
   struct ddsi_serdata *serdata;
   struct dds_loaned_sample *psmx_loan;
   if ((ret = dds_write_impl_psmxloan_serdata (wr, data, sdkind, timestamp, statusinfo, &psmx_loan, &serdata)) == DDS_RETCODE_OK)
@@ -744,9 +844,22 @@ dds_return_t dds_writecdr_impl (dds_writer *wr, struct ddsi_xpack *xp, struct dd
 
 void dds_write_flush_impl (dds_writer *wr)
 {
+  /* flushing a publisher or participant visits all its writers, most of which
+     typically have nothing pending (and queueing an empty pack in async mode
+     isn't free) */
   ddsrt_mutex_lock (&wr->m_entity.m_mutex);
-  ddsi_xpack_send (wr->m_xp, true);
+  if (!ddsi_xpack_is_empty (wr->m_xp))
+    ddsi_xpack_send (wr->m_xp, true);
   ddsrt_mutex_unlock (&wr->m_entity.m_mutex);
+  /* a batch is private to the thread, so this can only be the calling thread's */
+  struct ddsi_xpack *bxp;
+  if (write_batch.depth > 0 && (bxp = dds_write_batch_lookup_xpack (&wr->m_entity.m_domain->gv)) != NULL && !ddsi_xpack_is_empty (bxp))
+  {
+    struct ddsi_thread_state * const thrst = ddsi_lookup_thread_state ();
+    ddsi_thread_state_awake (thrst, &wr->m_entity.m_domain->gv);
+    ddsi_xpack_send (bxp, true);
+    ddsi_thread_state_asleep (thrst);
+  }
 }
 
 dds_return_t dds_writecdr_local_orphan_impl (struct ddsi_local_orphan_writer *lowr, struct ddsi_serdata *d)
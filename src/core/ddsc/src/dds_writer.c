@@ -269,7 +269,16 @@ static const struct dds_stat_keyvalue_descriptor dds_writer_statistics_kv[] = {
   { "rexmit_bytes", DDS_STAT_KIND_UINT64 },
   { "throttle_count", DDS_STAT_KIND_UINT32 },
   { "time_throttle", DDS_STAT_KIND_UINT64 },
-  { "time_rexmit", DDS_STAT_KIND_UINT64 }
+  { "time_rexmit", DDS_STAT_KIND_UINT64 },
+  { "pacing_rate", DDS_STAT_KIND_UINT64 },
+  { "pacing_achieved_rate", DDS_STAT_KIND_UINT64 },
+  { "pacing_backoff_count", DDS_STAT_KIND_UINT32 },
+  { "time_paced", DDS_STAT_KIND_UINT64 },
+  { "addrset_rebuild_count", DDS_STAT_KIND_UINT32 },
+  { "addrset_update_count", DDS_STAT_KIND_UINT32 },
+  { "time_addrset", DDS_STAT_KIND_UINT64 },
+  { "content_filtered_readers", DDS_STAT_KIND_UINT32 },
+  { "content_filter_skipped", DDS_STAT_KIND_UINT64 }
 };
 
 static const struct dds_stat_descriptor dds_writer_statistics_desc = {
@@ -286,7 +295,12 @@ static void dds_writer_refresh_statistics (const struct dds_entity *entity, stru
 {
   const struct dds_writer *wr = (const struct dds_writer *) entity;
   if (wr->m_wr)
+  {
     ddsi_get_writer_stats (wr->m_wr, &stat->kv[0].u.u64, &stat->kv[1].u.u32, &stat->kv[2].u.u64, &stat->kv[3].u.u64);
+    ddsi_get_writer_pacing_stats (wr->m_wr, &stat->kv[4].u.u64, &stat->kv[5].u.u64, &stat->kv[6].u.u32, &stat->kv[7].u.u64);
+    ddsi_get_writer_addrset_stats (wr->m_wr, &stat->kv[8].u.u32, &stat->kv[9].u.u32, &stat->kv[10].u.u64);
+    ddsi_get_writer_content_filter_stats (wr->m_wr, &stat->kv[11].u.u32, &stat->kv[12].u.u64);
+  }
 }
 
 const struct dds_entity_deriver dds_entity_deriver_writer = {
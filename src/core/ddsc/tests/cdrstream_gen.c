@@ -0,0 +1,335 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "CUnit/Test.h"
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsc/dds_public_impl.h"
+#include "dds/cdr/dds_cdrstream.h"
+#include "CdrStreamGen.h"
+
+/* The type-specific serializers generated by idlc ("-f type-serdes") must be equivalent
+   to the interpreter of the serializer instructions. These tests check that by comparing
+   the output of both for random samples and (mutations of) their serialized forms. */
+
+#define N_ITERS 200
+
+static ddsrt_prng_t prng;
+
+static uint32_t rnd (uint32_t n)
+{
+  return ddsrt_prng_random (&prng) % n;
+}
+
+static void rnd_bytes (void *dst, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    ((unsigned char *) dst)[i] = (unsigned char) rnd (256);
+}
+
+static void rnd_bools (bool *dst, size_t n)
+{
+  // not only 0 and 1: the serializer should write anything != 0 as true
+  for (size_t i = 0; i < n; i++)
+    memset (&dst[i], (int) rnd (3), 1);
+}
+
+static void rnd_string (char **dst)
+{
+  // null pointers are serialized as empty strings
+  if (rnd (8) == 0)
+    *dst = NULL;
+  else
+  {
+    const uint32_t len = rnd (10);
+    *dst = dds_alloc (len + 1);
+    for (uint32_t i = 0; i < len; i++)
+      (*dst)[i] = (char) ('a' + rnd (26));
+    (*dst)[len] = 0;
+  }
+}
+
+static void rnd_bstring (char *dst, uint32_t size)
+{
+  const uint32_t len = rnd (size);
+  for (uint32_t i = 0; i < len; i++)
+    dst[i] = (char) ('a' + rnd (26));
+  dst[len] = 0;
+}
+
+static void rnd_seq (void *vseq, uint32_t elem_size, uint32_t max_length, bool bools)
+{
+  dds_sequence_t *seq = vseq;
+  seq->_length = seq->_maximum = rnd (max_length + 1);
+  seq->_buffer = seq->_length ? dds_alloc (seq->_length * elem_size) : NULL;
+  seq->_release = true;
+  if (bools)
+    rnd_bools ((bool *) seq->_buffer, seq->_length);
+  else
+    rnd_bytes (seq->_buffer, seq->_length * elem_size);
+}
+
+static void fill_inner (CdrStreamGen_inner *s)
+{
+  rnd_bytes (&s->k, sizeof (s->k));
+  rnd_string (&s->s);
+  rnd_seq (&s->d, sizeof (double), 5, false);
+  rnd_bools (&s->b, 1);
+}
+
+static void fill_t1 (void *vs)
+{
+  CdrStreamGen_t1 *s = vs;
+  rnd_bytes (&s->id, sizeof (s->id));
+  rnd_bools (&s->b, 1);
+  rnd_bytes (&s->c, sizeof (s->c));
+  rnd_bytes (&s->o, sizeof (s->o));
+  rnd_bytes (&s->sh, sizeof (s->sh));
+  rnd_bstring (s->name, sizeof (s->name));
+  rnd_bytes (s->x, sizeof (s->x));
+  rnd_bools (s->ba, 3);
+  // one longer than the bound, so that writing sometimes fails
+  rnd_seq (&s->sb, sizeof (bool), 5, true);
+  fill_inner (&s->n);
+  rnd_bytes (&s->y, sizeof (s->y));
+  rnd_string (&s->u);
+  rnd_seq (&s->ss, sizeof (int16_t), 5, false);
+  rnd_bytes (&s->ull, sizeof (s->ull));
+  rnd_bytes (&s->f, sizeof (s->f));
+}
+
+static void fill_t2 (void *vs)
+{
+  CdrStreamGen_t2 *s = vs;
+  rnd_bytes (&s->o, sizeof (s->o));
+  fill_inner (&s->n);
+  rnd_string (&s->k);
+  rnd_seq (&s->i8, sizeof (int8_t), 3, false);
+}
+
+static void fill_t3 (void *vs)
+{
+  CdrStreamGen_t3 *s = vs;
+  rnd_bytes (&s->c, sizeof (s->c));
+  fill_inner (&s->n);
+}
+
+static void fill_t4 (void *vs)
+{
+  CdrStreamGen_t4 *s = vs;
+  fill_inner (&s->n);
+  rnd_bytes (&s->x, sizeof (s->x));
+}
+
+static void *new_sample (const struct dds_cdrstream_desc *desc, void (*fill) (void *), const ddsrt_prng_t *state)
+{
+  void *s = ddsrt_calloc (1, desc->size);
+  if (fill)
+  {
+    prng = *state;
+    fill (s);
+  }
+  return s;
+}
+
+static void free_sample (void *s, const struct dds_cdrstream_desc *desc)
+{
+  dds_stream_free_sample (s, &dds_cdrstream_default_allocator, desc->ops.ops);
+  ddsrt_free (s);
+}
+
+static void check_equal_os (const dds_ostream_t *os_gen, const dds_ostream_t *os_int)
+{
+  CU_ASSERT_FATAL (os_gen->m_index == os_int->m_index);
+  CU_ASSERT_FATAL (memcmp (os_gen->m_buffer, os_int->m_buffer, os_gen->m_index) == 0);
+}
+
+static void check_normalize (const dds_ostream_t *os, bool bswap, uint32_t size, const struct dds_cdrstream_desc *desc_gen, const struct dds_cdrstream_desc *desc_int)
+{
+  unsigned char *buf_gen = ddsrt_memdup (os->m_buffer, os->m_index);
+  unsigned char *buf_int = ddsrt_memdup (os->m_buffer, os->m_index);
+  uint32_t act_gen = 0, act_int = 0;
+  const bool ret_gen = dds_stream_normalize (buf_gen, size, bswap, os->m_xcdr_version, desc_gen, false, &act_gen);
+  const bool ret_int = dds_stream_normalize (buf_int, size, bswap, os->m_xcdr_version, desc_int, false, &act_int);
+  CU_ASSERT_FATAL (ret_gen == ret_int);
+  if (ret_gen)
+  {
+    CU_ASSERT_FATAL (act_gen == act_int);
+    CU_ASSERT_FATAL (memcmp (buf_gen, buf_int, size) == 0);
+  }
+  ddsrt_free (buf_gen);
+  ddsrt_free (buf_int);
+}
+
+static void check_read (const dds_ostream_t *os, const struct dds_cdrstream_desc *desc_gen, const struct dds_cdrstream_desc *desc_int, void (*fill) (void *))
+{
+  // reading into an initialized sample reuses strings and sequence buffers, the behaviour
+  // of that depends on the state of the sample, so start from identical random samples
+  const ddsrt_prng_t state = prng;
+  void *s_gen = new_sample (desc_int, fill, &state);
+  void *s_int = new_sample (desc_int, fill, &state);
+  dds_istream_t is_gen, is_int;
+  dds_istream_init (&is_gen, os->m_index, os->m_buffer, os->m_xcdr_version);
+  dds_istream_init (&is_int, os->m_index, os->m_buffer, os->m_xcdr_version);
+  dds_stream_read_sample (&is_gen, s_gen, &dds_cdrstream_default_allocator, desc_gen);
+  dds_stream_read_sample (&is_int, s_int, &dds_cdrstream_default_allocator, desc_int);
+  CU_ASSERT_FATAL (is_gen.m_index == is_int.m_index);
+
+  // the samples are equal if their serialized forms are, the interpreter's output
+  // must be equal to the original input
+  dds_ostream_t os_gen, os_int;
+  dds_ostream_init (&os_gen, &dds_cdrstream_default_allocator, 0, os->m_xcdr_version);
+  dds_ostream_init (&os_int, &dds_cdrstream_default_allocator, 0, os->m_xcdr_version);
+  CU_ASSERT_FATAL (dds_stream_write_sample (&os_gen, &dds_cdrstream_default_allocator, s_gen, desc_int));
+  CU_ASSERT_FATAL (dds_stream_write_sample (&os_int, &dds_cdrstream_default_allocator, s_int, desc_int));
+  check_equal_os (&os_gen, &os_int);
+  check_equal_os (&os_int, os);
+  dds_ostream_fini (&os_gen, &dds_cdrstream_default_allocator);
+  dds_ostream_fini (&os_int, &dds_cdrstream_default_allocator);
+  free_sample (s_gen, desc_int);
+  free_sample (s_int, desc_int);
+}
+
+static void check_keys (const dds_ostream_t *os, const void *sample, const struct dds_cdrstream_desc *desc_gen, const struct dds_cdrstream_desc *desc_int)
+{
+  for (uint32_t xcdrv = DDSI_RTPS_CDR_ENC_VERSION_1; xcdrv <= DDSI_RTPS_CDR_ENC_VERSION_2; xcdrv++)
+  {
+    dds_ostream_t os_gen, os_int;
+    dds_ostream_init (&os_gen, &dds_cdrstream_default_allocator, 0, xcdrv);
+    dds_ostream_init (&os_int, &dds_cdrstream_default_allocator, 0, xcdrv);
+    CU_ASSERT_FATAL (dds_stream_write_key (&os_gen, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &dds_cdrstream_default_allocator, sample, desc_gen));
+    CU_ASSERT_FATAL (dds_stream_write_key (&os_int, DDS_CDR_KEY_SERIALIZATION_SAMPLE, &dds_cdrstream_default_allocator, sample, desc_int));
+    check_equal_os (&os_gen, &os_int);
+    dds_ostream_fini (&os_gen, &dds_cdrstream_default_allocator);
+    dds_ostream_fini (&os_int, &dds_cdrstream_default_allocator);
+
+    dds_istream_t is_gen, is_int;
+    dds_istream_init (&is_gen, os->m_index, os->m_buffer, os->m_xcdr_version);
+    dds_istream_init (&is_int, os->m_index, os->m_buffer, os->m_xcdr_version);
+    dds_ostream_init (&os_gen, &dds_cdrstream_default_allocator, 0, xcdrv);
+    dds_ostream_init (&os_int, &dds_cdrstream_default_allocator, 0, xcdrv);
+    CU_ASSERT_FATAL (dds_stream_extract_key_from_data (&is_gen, &os_gen, &dds_cdrstream_default_allocator, desc_gen));
+    CU_ASSERT_FATAL (dds_stream_extract_key_from_data (&is_int, &os_int, &dds_cdrstream_default_allocator, desc_int));
+    check_equal_os (&os_gen, &os_int);
+    dds_ostream_fini (&os_gen, &dds_cdrstream_default_allocator);
+    dds_ostream_fini (&os_int, &dds_cdrstream_default_allocator);
+  }
+}
+
+static void check_type (const dds_topic_descriptor_t *topic_desc, void (*fill) (void *), bool gen_keys)
+{
+  struct dds_cdrstream_desc desc_gen, desc_int;
+  dds_cdrstream_desc_from_topic_desc (&desc_gen, topic_desc);
+  dds_cdrstream_desc_from_topic_desc (&desc_int, topic_desc);
+  desc_int.funcs = NULL;
+  CU_ASSERT_FATAL (desc_gen.funcs != NULL);
+  CU_ASSERT_FATAL ((desc_gen.funcs->write_key != NULL) == gen_keys);
+  CU_ASSERT_FATAL ((desc_gen.funcs->extract_key_from_data != NULL) == gen_keys);
+  // the generated functions do not affect the type's flags
+  CU_ASSERT_FATAL (desc_gen.flagset == desc_int.flagset);
+
+  ddsrt_prng_init_simple (&prng, 12345);
+  uint32_t n_written = 0;
+  for (int iter = 0; iter < N_ITERS; iter++)
+  {
+    for (uint32_t xcdrv = DDSI_RTPS_CDR_ENC_VERSION_1; xcdrv <= DDSI_RTPS_CDR_ENC_VERSION_2; xcdrv++)
+    {
+      const ddsrt_prng_t state = prng;
+      void *sample = new_sample (&desc_int, fill, &state);
+
+      dds_ostream_t os_gen, os_int;
+      dds_ostream_init (&os_gen, &dds_cdrstream_default_allocator, 0, xcdrv);
+      dds_ostream_init (&os_int, &dds_cdrstream_default_allocator, 0, xcdrv);
+      const bool ret_gen = dds_stream_write_sample (&os_gen, &dds_cdrstream_default_allocator, sample, &desc_gen);
+      const bool ret_int = dds_stream_write_sample (&os_int, &dds_cdrstream_default_allocator, sample, &desc_int);
+      CU_ASSERT_FATAL (ret_gen == ret_int);
+      if (ret_gen)
+      {
+        n_written++;
+        check_equal_os (&os_gen, &os_int);
+        CU_ASSERT_FATAL (dds_stream_getsize_sample (sample, &desc_gen, xcdrv) == os_int.m_index);
+        CU_ASSERT_FATAL (dds_stream_getsize_sample (sample, &desc_int, xcdrv) == os_int.m_index);
+
+        // normalizing valid input, including big-endian input, and truncated input
+        check_normalize (&os_int, false, os_int.m_index, &desc_gen, &desc_int);
+        dds_ostreamBE_t osBE;
+        dds_ostreamBE_init (&osBE, &dds_cdrstream_default_allocator, 0, xcdrv);
+        CU_ASSERT_FATAL (dds_stream_write_sampleBE (&osBE, &dds_cdrstream_default_allocator, sample, &desc_int));
+        check_normalize (&osBE.x, (DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN), osBE.x.m_index, &desc_gen, &desc_int);
+        dds_ostreamBE_fini (&osBE, &dds_cdrstream_default_allocator);
+        for (uint32_t size = 0; size < os_int.m_index; size++)
+          check_normalize (&os_int, false, size, &desc_gen, &desc_int);
+
+        // normalizing corrupted input: random bytes and small values in place of lengths
+        for (int m = 0; m < 20; m++)
+        {
+          dds_ostream_t os_mut = os_int;
+          os_mut.m_buffer = ddsrt_memdup (os_int.m_buffer, os_int.m_index);
+          for (uint32_t n = 1 + rnd (3); n > 0; n--)
+            os_mut.m_buffer[rnd (os_mut.m_index)] = (unsigned char) rnd (256);
+          if (os_mut.m_index >= 4 && rnd (2))
+          {
+            const uint32_t v = rnd (4);
+            memcpy (os_mut.m_buffer + (rnd (os_mut.m_index - 3) & ~3u), &v, sizeof (v));
+          }
+          check_normalize (&os_mut, rnd (2), os_mut.m_index, &desc_gen, &desc_int);
+          ddsrt_free (os_mut.m_buffer);
+        }
+
+        check_read (&os_int, &desc_gen, &desc_int, (iter % 2) ? fill : NULL);
+        if (desc_int.keys.nkeys > 0)
+          check_keys (&os_int, sample, &desc_gen, &desc_int);
+      }
+      dds_ostream_fini (&os_gen, &dds_cdrstream_default_allocator);
+      dds_ostream_fini (&os_int, &dds_cdrstream_default_allocator);
+      free_sample (sample, &desc_int);
+    }
+  }
+  // most samples should be valid
+  CU_ASSERT (n_written > N_ITERS);
+  dds_cdrstream_desc_fini (&desc_gen, &dds_cdrstream_default_allocator);
+  dds_cdrstream_desc_fini (&desc_int, &dds_cdrstream_default_allocator);
+}
+
+CU_Test (ddsc_cdrstream_gen, all_types)
+{
+  check_type (&CdrStreamGen_t1_desc, fill_t1, true);
+}
+
+CU_Test (ddsc_cdrstream_gen, key_after_nested)
+{
+  check_type (&CdrStreamGen_t2_desc, fill_t2, true);
+}
+
+CU_Test (ddsc_cdrstream_gen, no_keys)
+{
+  check_type (&CdrStreamGen_t3_desc, fill_t3, false);
+}
+
+CU_Test (ddsc_cdrstream_gen, nested_key)
+{
+  check_type (&CdrStreamGen_t4_desc, fill_t4, false);
+}
+
+CU_Test (ddsc_cdrstream_gen, unsupported)
+{
+  CU_ASSERT (!(CdrStreamGen_t5_desc.m_flagset & DDS_TOPIC_TYPE_SERDES));
+  CU_ASSERT (!(CdrStreamGen_t6_desc.m_flagset & DDS_TOPIC_TYPE_SERDES));
+  CU_ASSERT (CdrStreamGen_t1_desc.m_flagset & DDS_TOPIC_TYPE_SERDES);
+
+  struct dds_cdrstream_desc desc;
+  dds_cdrstream_desc_from_topic_desc (&desc, &CdrStreamGen_t5_desc);
+  CU_ASSERT (desc.funcs == NULL);
+  dds_cdrstream_desc_fini (&desc, &dds_cdrstream_default_allocator);
+}
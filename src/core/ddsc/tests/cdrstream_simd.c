@@ -0,0 +1,221 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CUnit/Test.h"
+#include "dds/ddsrt/random.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
+
+/* The vectorized kernels for byte-swapping and validating primitive arrays must behave
+   exactly like a simple loop, for every instruction set supported by the machine, any
+   length (covering both the vectorized part and the remainder) and any alignment. */
+
+#define MAX_NUM 100
+#define MAX_MISALIGN 8
+
+static ddsrt_prng_t prng;
+
+static uint32_t rnd (uint32_t n)
+{
+  return ddsrt_prng_random (&prng) % n;
+}
+
+static uint64_t rnd64 (void)
+{
+  return ((uint64_t) ddsrt_prng_random (&prng) << 32) | ddsrt_prng_random (&prng);
+}
+
+static void rnd_bytes (unsigned char *dst, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    dst[i] = (unsigned char) rnd (256);
+}
+
+static uint64_t get_elem (const unsigned char *buf, uint32_t elem_size, uint32_t i)
+{
+  switch (elem_size)
+  {
+    case 1: return buf[i];
+    case 2: { uint16_t x; memcpy (&x, buf + 2 * i, 2); return x; }
+    case 4: { uint32_t x; memcpy (&x, buf + 4 * i, 4); return x; }
+    default: { uint64_t x; memcpy (&x, buf + 8 * i, 8); return x; }
+  }
+}
+
+static void put_elem (unsigned char *buf, uint32_t elem_size, uint32_t i, uint64_t v)
+{
+  switch (elem_size)
+  {
+    case 1: buf[i] = (uint8_t) v; break;
+    case 2: { uint16_t x = (uint16_t) v; memcpy (buf + 2 * i, &x, 2); break; }
+    case 4: { uint32_t x = (uint32_t) v; memcpy (buf + 4 * i, &x, 4); break; }
+    default: memcpy (buf + 8 * i, &v, 8); break;
+  }
+}
+
+static void ref_bswap (unsigned char *buf, uint32_t elem_size, uint32_t num)
+{
+  for (uint32_t i = 0; i < num; i++)
+  {
+    for (uint32_t j = 0; j < elem_size / 2; j++)
+    {
+      const unsigned char t = buf[i * elem_size + j];
+      buf[i * elem_size + j] = buf[i * elem_size + elem_size - 1 - j];
+      buf[i * elem_size + elem_size - 1 - j] = t;
+    }
+  }
+}
+
+typedef void (*test_fn_t) (uint32_t num, uint32_t misalign);
+
+static void for_all_isas (test_fn_t fn)
+{
+  const enum dds_stream_simd_isa isa0 = dds_stream_simd_get ();
+  static const enum dds_stream_simd_isa isas[] = { DDS_STREAM_SIMD_SCALAR, DDS_STREAM_SIMD_SSSE3, DDS_STREAM_SIMD_AVX2, DDS_STREAM_SIMD_NEON };
+  ddsrt_prng_init_simple (&prng, 12345);
+  for (size_t k = 0; k < sizeof (isas) / sizeof (isas[0]); k++)
+  {
+    if (!dds_stream_simd_supported (isas[k]))
+      continue;
+    printf ("%s\n", dds_stream_simd_name (isas[k]));
+    CU_ASSERT_FATAL (dds_stream_simd_set (isas[k]));
+    CU_ASSERT_FATAL (dds_stream_simd_get () == isas[k]);
+    for (uint32_t num = 0; num <= MAX_NUM; num++)
+      for (uint32_t misalign = 0; misalign < MAX_MISALIGN; misalign++)
+        fn (num, misalign);
+  }
+  CU_ASSERT_FATAL (dds_stream_simd_set (isa0));
+}
+
+static const uint32_t elem_sizes[] = { 1, 2, 4, 8 };
+
+static void test_bswap (uint32_t num, uint32_t misalign)
+{
+  // one guard byte on either side to catch out-of-bounds writes
+  unsigned char buf[8 * MAX_NUM + MAX_MISALIGN + 2], ref[sizeof (buf)], src[sizeof (buf)];
+  for (size_t k = 0; k < sizeof (elem_sizes) / sizeof (elem_sizes[0]); k++)
+  {
+    const uint32_t elem_size = elem_sizes[k];
+    rnd_bytes (buf, sizeof (buf));
+    memcpy (ref, buf, sizeof (buf));
+    memcpy (src, buf, sizeof (buf));
+    ref_bswap (ref + 1 + misalign, elem_size, num);
+    dds_stream_simd_bswap (buf + 1 + misalign, elem_size, num);
+    CU_ASSERT_FATAL (memcmp (buf, ref, sizeof (buf)) == 0);
+
+    rnd_bytes (buf, sizeof (buf));
+    memcpy (ref, buf, sizeof (buf));
+    memcpy (ref + 1 + misalign, src + 1, elem_size * num);
+    ref_bswap (ref + 1 + misalign, elem_size, num);
+    dds_stream_simd_bswap_copy (buf + 1 + misalign, src + 1, elem_size, num);
+    CU_ASSERT_FATAL (memcmp (buf, ref, sizeof (buf)) == 0);
+  }
+}
+
+static void test_clamp_bool (uint32_t num, uint32_t misalign)
+{
+  unsigned char buf[MAX_NUM + MAX_MISALIGN + 2], ref[sizeof (buf)];
+  rnd_bytes (buf, sizeof (buf));
+  // mostly valid values, as is to be expected in practice
+  for (uint32_t i = 0; i < num; i++)
+    if (rnd (4) != 0)
+      buf[1 + misalign + i] &= 1;
+  memcpy (ref, buf, sizeof (buf));
+  for (uint32_t i = 0; i < num; i++)
+    if (ref[1 + misalign + i] > 1)
+      ref[1 + misalign + i] = 1;
+  dds_stream_simd_clamp_bool (buf + 1 + misalign, num);
+  CU_ASSERT_FATAL (memcmp (buf, ref, sizeof (buf)) == 0);
+}
+
+static void test_check_max (uint32_t num, uint32_t misalign)
+{
+  unsigned char buf[4 * MAX_NUM + MAX_MISALIGN + 2], ref[sizeof (buf)];
+  for (size_t k = 0; k < 3; k++)
+  {
+    const uint32_t elem_size = elem_sizes[k];
+    const uint64_t type_max = (elem_size == 4) ? UINT32_MAX : (1u << (8 * elem_size)) - 1;
+    const uint32_t maxs[] = { 0, 1, (uint32_t) rnd (100), (uint32_t) (rnd64 () & type_max), (uint32_t) type_max - 1, (uint32_t) type_max, UINT32_MAX };
+    for (size_t m = 0; m < sizeof (maxs) / sizeof (maxs[0]); m++)
+    {
+      const uint32_t max = maxs[m];
+      const bool bswap = rnd (2);
+      const bool violate = num > 0 && max < type_max && rnd (2);
+      rnd_bytes (buf, sizeof (buf));
+      unsigned char * const xs = buf + 1 + misalign;
+      for (uint32_t i = 0; i < num; i++)
+        put_elem (xs, elem_size, i, rnd64 () % ((uint64_t) max + 1));
+      if (violate)
+        put_elem (xs, elem_size, rnd (num), max + 1 + rnd64 () % (type_max - max));
+      memcpy (ref, buf, sizeof (buf));
+      if (bswap)
+        ref_bswap (buf + 1 + misalign, elem_size, num);
+      const bool ok = dds_stream_simd_check_max (xs, elem_size, num, bswap, max);
+      CU_ASSERT_FATAL (ok == !violate);
+      if (ok)
+        CU_ASSERT_FATAL (memcmp (buf, ref, sizeof (buf)) == 0);
+    }
+  }
+}
+
+static void test_check_bitmask (uint32_t num, uint32_t misalign)
+{
+  unsigned char buf[8 * MAX_NUM + MAX_MISALIGN + 2], ref[sizeof (buf)];
+  for (size_t k = 0; k < sizeof (elem_sizes) / sizeof (elem_sizes[0]); k++)
+  {
+    const uint32_t elem_size = elem_sizes[k];
+    const uint64_t type_mask = (elem_size == 8) ? UINT64_MAX : ((uint64_t) 1 << (8 * elem_size)) - 1;
+    const uint64_t mask = rnd64 () & type_mask;
+    const bool bswap = rnd (2);
+    const bool violate = num > 0 && mask != type_mask && rnd (2);
+    rnd_bytes (buf, sizeof (buf));
+    unsigned char * const xs = buf + 1 + misalign;
+    for (uint32_t i = 0; i < num; i++)
+      put_elem (xs, elem_size, i, rnd64 () & mask);
+    if (violate)
+    {
+      // set one of the bits outside the mask in one of the elements
+      uint32_t bit;
+      do {
+        bit = rnd (8 * elem_size);
+      } while (mask & ((uint64_t) 1 << bit));
+      const uint32_t i = rnd (num);
+      put_elem (xs, elem_size, i, get_elem (xs, elem_size, i) | ((uint64_t) 1 << bit));
+    }
+    memcpy (ref, buf, sizeof (buf));
+    if (bswap)
+      ref_bswap (buf + 1 + misalign, elem_size, num);
+    const bool ok = dds_stream_simd_check_bitmask (xs, elem_size, num, bswap, (uint32_t) (mask >> 32), (uint32_t) mask);
+    CU_ASSERT_FATAL (ok == !violate);
+    CU_ASSERT_FATAL (memcmp (buf, ref, sizeof (buf)) == 0);
+  }
+}
+
+CU_Test (ddsc_cdrstream_simd, bswap)
+{
+  for_all_isas (test_bswap);
+}
+
+CU_Test (ddsc_cdrstream_simd, clamp_bool)
+{
+  for_all_isas (test_clamp_bool);
+}
+
+CU_Test (ddsc_cdrstream_simd, check_max)
+{
+  for_all_isas (test_check_max);
+}
+
+CU_Test (ddsc_cdrstream_simd, check_bitmask)
+{
+  for_all_isas (test_check_bitmask);
+}
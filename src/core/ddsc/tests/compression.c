@@ -0,0 +1,232 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "dds/ddsi/ddsi_proxy_endpoint.h"
+#include "ddsi__whc.h"
+#include "ddsi__compression.h"
+#include "dds__entity.h"
+#include "dds__writer.h"
+
+#include "test_common.h"
+#include "RoundTrip.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_COMPRESSION(codec) "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Compression><Codec>" codec "</Codec></Compression>"
+
+#define SAMPLE_SIZE 100000
+
+static dds_entity_t dom_pub, dom_sub, pp_pub, pp_sub, tp_pub, tp_sub, rd;
+
+static void compression_init (const char *codec_pub)
+{
+  char *conf_pub = ddsrt_expand_envvars (codec_pub, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_COMPRESSION (""), DDS_DOMAINID_SUB);
+  dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_compression", topicname, sizeof (topicname));
+  tp_pub = dds_create_topic (pp_pub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  tp_sub = dds_create_topic (pp_sub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_delete_qos (qos);
+}
+
+static void compression_fini (void)
+{
+  dds_delete (dom_sub);
+  dds_delete (dom_pub);
+}
+
+static dds_entity_t create_writer (const char *threshold)
+{
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  // transient-local so that the WHC retains the samples for inspection and late-joining
+  // readers, keep-all so that a lost fragment can't result in a sample getting lost
+  dds_qset_durability (qos, DDS_DURABILITY_TRANSIENT_LOCAL);
+  dds_qset_durability_service (qos, 0, DDS_HISTORY_KEEP_ALL, 0, DDS_LENGTH_UNLIMITED, DDS_LENGTH_UNLIMITED, DDS_LENGTH_UNLIMITED);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  if (threshold)
+    dds_qset_prop (qos, "cyclonedds.compression.threshold", threshold);
+  const dds_entity_t wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  const dds_time_t tmatch = dds_time () + DDS_SECS (10);
+  dds_publication_matched_status_t pst;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+  return wr;
+}
+
+static void fill_sample (RoundTripModule_DataType *sample, int32_t s)
+{
+  for (uint32_t i = 0; i < SAMPLE_SIZE; i++)
+    sample->payload._buffer[i] = (uint8_t) ((i / 64) + (uint32_t) s);
+}
+
+static void take_and_check (dds_entity_t reader, int32_t nsamples)
+{
+  RoundTripModule_DataType sample;
+  sample.payload._buffer = ddsrt_malloc (SAMPLE_SIZE);
+  int32_t ntaken = 0, n = 0;
+  void *raw[1] = { NULL };
+  dds_sample_info_t si;
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (ntaken < nsamples && dds_time () < tend && (n = dds_take (reader, raw, &si, 1, 1)) >= 0)
+  {
+    if (n == 0)
+    {
+      dds_sleepfor (DDS_MSECS (10));
+      continue;
+    }
+    const RoundTripModule_DataType *rs = raw[0];
+    CU_ASSERT_FATAL (rs->payload._length == SAMPLE_SIZE);
+    fill_sample (&sample, ntaken);
+    CU_ASSERT_FATAL (memcmp (rs->payload._buffer, sample.payload._buffer, SAMPLE_SIZE) == 0);
+    (void) dds_return_loan (reader, raw, n);
+    ntaken++;
+  }
+  CU_ASSERT_FATAL (n >= 0);
+  CU_ASSERT_FATAL (ntaken == nsamples);
+  CU_ASSERT_FATAL (dds_take (reader, raw, &si, 1, 1) == 0);
+  ddsrt_free (sample.payload._buffer);
+}
+
+struct sizes {
+  uint32_t whc;       // size of the payload in the WHC
+  uint32_t xmit;      // size of the payload as sent to all readers
+  uint32_t xmit_none; // size of the payload as sent to a reader that can't decompress it
+  bool cached;        // payload as sent to all readers was kept in the WHC when written
+};
+
+static struct sizes write_and_check (dds_entity_t wr, int32_t nsamples)
+{
+  RoundTripModule_DataType sample;
+  sample.payload._length = sample.payload._maximum = SAMPLE_SIZE;
+  sample.payload._buffer = ddsrt_malloc (SAMPLE_SIZE);
+  sample.payload._release = false;
+  for (int32_t s = 0; s < nsamples; s++)
+  {
+    fill_sample (&sample, s);
+    dds_return_t rc = dds_write (wr, &sample);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  ddsrt_free (sample.payload._buffer);
+  dds_return_t rc = dds_wait_for_acks (wr, DDS_SECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  take_and_check (rd, nsamples);
+
+  struct dds_entity *x;
+  rc = dds_entity_pin (wr, &x);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  struct ddsi_writer * const ddsi_wr = ((struct dds_writer *) x)->m_wr;
+  struct ddsi_whc_borrowed_sample bs;
+  struct ddsi_proxy_reader prd_none;
+  memset (&prd_none, 0, sizeof (prd_none));
+  struct sizes sizes;
+  ddsrt_mutex_lock (&ddsi_wr->e.lock);
+  CU_ASSERT_FATAL (ddsi_whc_borrow_sample (ddsi_wr->whc, ddsi_wr->seq, &bs));
+  sizes.whc = ddsi_serdata_size (bs.serdata);
+  struct ddsi_serdata * const cached = bs.xmit_serdata;
+  struct ddsi_serdata *xmit = ddsi_writer_serdata_for_xmit (ddsi_wr, bs.serdata, &bs.xmit_serdata, NULL);
+  sizes.xmit = ddsi_serdata_size (xmit);
+  sizes.cached = (cached != NULL && xmit == cached);
+  ddsi_serdata_unref (xmit);
+  xmit = ddsi_writer_serdata_for_xmit (ddsi_wr, bs.serdata, &bs.xmit_serdata, &prd_none);
+  sizes.xmit_none = ddsi_serdata_size (xmit);
+  ddsi_serdata_unref (xmit);
+  ddsi_whc_return_sample (ddsi_wr->whc, &bs, false);
+  ddsrt_mutex_unlock (&ddsi_wr->e.lock);
+  dds_entity_unpin (x);
+  return sizes;
+}
+
+CU_Test (ddsc_compression, builtin, .timeout = 30)
+{
+  compression_init (DDS_CONFIG_COMPRESSION ("lz"));
+  const struct sizes sizes = write_and_check (create_writer (NULL), 10);
+  CU_ASSERT (sizes.xmit < SAMPLE_SIZE / 10);
+  // compressed once, when written, and (re)transmits reuse it
+  CU_ASSERT (sizes.cached);
+  // the WHC holds the original, for readers that can't decompress it
+  CU_ASSERT (sizes.whc > SAMPLE_SIZE);
+  CU_ASSERT (sizes.xmit_none == sizes.whc);
+  compression_fini ();
+}
+
+CU_Test (ddsc_compression, late_joining_reader, .timeout = 30)
+{
+  compression_init (DDS_CONFIG_COMPRESSION ("lz"));
+  const dds_entity_t wr = create_writer (NULL);
+  (void) write_and_check (wr, 5);
+
+  // historical data is retransmitted from the WHC, and so is compressed when sent
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_durability (qos, DDS_DURABILITY_TRANSIENT_LOCAL);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd2 = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd2 > 0);
+  dds_delete_qos (qos);
+  take_and_check (rd2, 5);
+  compression_fini ();
+}
+
+CU_Test (ddsc_compression, disabled, .timeout = 30)
+{
+  compression_init (DDS_CONFIG_COMPRESSION (""));
+  const struct sizes sizes = write_and_check (create_writer (NULL), 3);
+  CU_ASSERT (sizes.xmit > SAMPLE_SIZE);
+  compression_fini ();
+}
+
+CU_Test (ddsc_compression, threshold, .timeout = 30)
+{
+  compression_init (DDS_CONFIG_COMPRESSION ("lz"));
+  const struct sizes sizes = write_and_check (create_writer ("1000000"), 3);
+  CU_ASSERT (sizes.xmit > SAMPLE_SIZE);
+  compression_fini ();
+}
+
+CU_Test (ddsc_compression, plugin_missing)
+{
+  char *conf = ddsrt_expand_envvars (DDS_CONFIG_COMPRESSION ("nonexistent"), DDS_DOMAINID_PUB);
+  const dds_entity_t dom = dds_create_domain (DDS_DOMAINID_PUB, conf);
+  ddsrt_free (conf);
+  CU_ASSERT_FATAL (dom < 0);
+}
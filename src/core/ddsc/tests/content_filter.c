@@ -0,0 +1,231 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+
+#include "test_common.h"
+#include "Space.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_CF "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+
+static dds_entity_t dom_pub, dom_sub, tp_sub, rd, wr;
+static struct dds_statistics *wrstat;
+
+static void content_filter_init (void)
+{
+  char *conf_pub = ddsrt_expand_envvars (DDS_CONFIG_CF, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_CF, DDS_DOMAINID_SUB);
+  dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  tp_sub = dds_create_topic (pp_sub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  // the reader's filter is set before creating it, so it is included in the initial discovery data
+  dds_return_t rc = dds_set_topic_filter_expression (tp_sub, "long_1 = 3", 0, NULL);
+  CU_ASSERT_FATAL (rc == 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+  sync_reader_writer (pp_sub, rd, pp_pub, wr);
+
+  wrstat = dds_create_statistics (wr);
+  CU_ASSERT_FATAL (wrstat != NULL);
+}
+
+static void content_filter_fini (void)
+{
+  dds_delete_statistics (wrstat);
+  dds_return_t rc = dds_delete (dom_pub);
+  CU_ASSERT_FATAL (rc == 0);
+  rc = dds_delete (dom_sub);
+  CU_ASSERT_FATAL (rc == 0);
+}
+
+static uint64_t get_stat (const char *name)
+{
+  dds_return_t rc = dds_refresh_statistics (wrstat);
+  CU_ASSERT_FATAL (rc == 0);
+  const struct dds_stat_keyvalue *kv = dds_lookup_statistic (wrstat, name);
+  CU_ASSERT_FATAL (kv != NULL);
+  return (kv->kind == DDS_STAT_KIND_UINT32) ? kv->u.u32 : kv->u.u64;
+}
+
+static void wait_for_filtered_readers (uint64_t n)
+{
+  // the filter is part of the discovery data of the reader, so changing it is asynchronous
+  dds_time_t tend = dds_time () + DDS_SECS (5);
+  while (get_stat ("content_filtered_readers") != n && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (get_stat ("content_filtered_readers") == n);
+}
+
+static void wait_for_matched (uint32_t n)
+{
+  dds_time_t tend = dds_time () + DDS_SECS (5);
+  dds_publication_matched_status_t st;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &st)) == 0 && st.current_count != n && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0 && st.current_count == n);
+}
+
+static void write_range (int32_t start, int32_t n)
+{
+  for (int32_t i = start; i < start + n; i++)
+  {
+    Space_Type1 s = { .long_1 = i % 10, .long_2 = i, .long_3 = 0 };
+    dds_return_t rc = dds_write (wr, &s);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+  // the reader only acknowledges everything if the skipped samples are properly accounted for
+  dds_return_t rc = dds_wait_for_acks (wr, DDS_SECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+}
+
+static uint32_t take_all (int32_t *long_2s, uint32_t max)
+{
+  void *raw[100] = { NULL };
+  dds_sample_info_t si[100];
+  uint32_t n = 0;
+  int32_t rc;
+  CU_ASSERT_FATAL (max <= 100);
+  while ((rc = dds_take (rd, raw, si, 100, 100)) > 0)
+  {
+    for (int32_t i = 0; i < rc; i++)
+    {
+      CU_ASSERT_FATAL (si[i].valid_data);
+      CU_ASSERT_FATAL (n < max);
+      long_2s[n++] = ((const Space_Type1 *) raw[i])->long_2;
+    }
+    (void) dds_return_loan (rd, raw, rc);
+  }
+  CU_ASSERT_FATAL (rc == 0);
+  return n;
+}
+
+CU_Test (ddsc_content_filter, writer_side, .init = content_filter_init, .fini = content_filter_fini, .timeout = 30)
+{
+  wait_for_filtered_readers (1);
+
+  // only 1 in 10 samples is accepted by the reader, the others shouldn't even be sent
+  write_range (0, 100);
+  CU_ASSERT (get_stat ("content_filter_skipped") == 90);
+  int32_t long_2s[100];
+  uint32_t n = take_all (long_2s, 100);
+  CU_ASSERT_FATAL (n == 10);
+  for (uint32_t i = 0; i < n; i++)
+    CU_ASSERT (long_2s[i] == 3 + 10 * (int32_t) i);
+
+  // changing the filter is propagated to the writer
+  const char *params[] = { "5" };
+  dds_return_t rc = dds_set_topic_filter_expression (tp_sub, "long_1 = %0 OR long_2 < 0", 1, params);
+  CU_ASSERT_FATAL (rc == 0);
+  dds_time_t tend = dds_time () + DDS_SECS (5);
+  uint64_t skipped, new_skipped;
+  do {
+    // there is no way of telling when the writer has the new filter, so write until it is in use;
+    // while the old one is still in use, the reader discards 103 and the writer doesn't send 105
+    skipped = get_stat ("content_filter_skipped");
+    write_range (100, 10);
+    new_skipped = get_stat ("content_filter_skipped");
+    n = take_all (long_2s, 100);
+    CU_ASSERT_FATAL (n <= 1);
+  } while (!(n == 1 && long_2s[0] == 105 && new_skipped == skipped + 9) && dds_time () < tend);
+  CU_ASSERT_FATAL (n == 1 && long_2s[0] == 105);
+  CU_ASSERT (new_skipped == skipped + 9);
+
+  // without a filter, everything is sent
+  rc = dds_set_topic_filter_expression (tp_sub, NULL, 0, NULL);
+  CU_ASSERT_FATAL (rc == 0);
+  wait_for_filtered_readers (0);
+  skipped = get_stat ("content_filter_skipped");
+  write_range (200, 10);
+  CU_ASSERT (get_stat ("content_filter_skipped") == skipped);
+  n = take_all (long_2s, 100);
+  CU_ASSERT_FATAL (n == 10);
+  for (uint32_t i = 0; i < n; i++)
+    CU_ASSERT (long_2s[i] == 200 + (int32_t) i);
+}
+
+CU_Test (ddsc_content_filter, late_joining_reader, .init = content_filter_init, .fini = content_filter_fini, .timeout = 30)
+{
+  wait_for_filtered_readers (1);
+
+  // a second, unfiltered reader on the same host means all data must go to that host
+  const dds_entity_t pp_sub2 = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub2 > 0);
+  char topicname[100];
+  dds_return_t rc = dds_get_name (tp_sub, topicname, sizeof (topicname));
+  CU_ASSERT_FATAL (rc > 0);
+  const dds_entity_t tp_sub2 = dds_create_topic (pp_sub2, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub2 > 0);
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd2 = dds_create_reader (pp_sub2, tp_sub2, qos, NULL);
+  CU_ASSERT_FATAL (rd2 > 0);
+  dds_delete_qos (qos);
+  wait_for_matched (2);
+  dds_time_t tend = dds_time () + DDS_SECS (5);
+  dds_subscription_matched_status_t st;
+  while ((rc = dds_get_subscription_matched_status (rd2, &st)) == 0 && st.current_count != 1 && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0 && st.current_count == 1);
+
+  write_range (0, 20);
+  CU_ASSERT (get_stat ("content_filter_skipped") == 0);
+  int32_t long_2s[100];
+  uint32_t n = take_all (long_2s, 100);
+  CU_ASSERT_FATAL (n == 2);
+  CU_ASSERT (long_2s[0] == 3 && long_2s[1] == 13);
+  void *raw[100] = { NULL };
+  dds_sample_info_t si[100];
+  int32_t n2 = dds_take (rd2, raw, si, 100, 100);
+  CU_ASSERT (n2 == 20);
+  if (n2 > 0)
+    (void) dds_return_loan (rd2, raw, n2);
+
+  // once the unfiltered reader is gone, rejected samples are no longer sent
+  rc = dds_delete (rd2);
+  CU_ASSERT_FATAL (rc == 0);
+  wait_for_matched (1);
+  write_range (20, 10);
+  CU_ASSERT (get_stat ("content_filter_skipped") == 9);
+  n = take_all (long_2s, 100);
+  CU_ASSERT_FATAL (n == 1);
+  CU_ASSERT (long_2s[0] == 23);
+}
@@ -0,0 +1,181 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds__entity.h"
+
+#include "test_common.h"
+#include "Space.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_NO_PORT_GAIN "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+// Priority threshold ensures the data is delivered via the delivery queues
+#define DDS_CONFIG_DQUEUES "<Internal><DeliveryQueueThreads>4</DeliveryQueueThreads><SynchronousDeliveryPriorityThreshold>1</SynchronousDeliveryPriorityThreshold></Internal>"
+
+#define NWRITERS 8
+#define NSAMPLES 200
+
+// sync_reader_writer only really waits for the first writer because the reader's
+// subscription matched status remains set
+static void wait_for_all_matched (dds_entity_t rd, const dds_entity_t wr[NWRITERS])
+{
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  dds_subscription_matched_status_t st;
+  dds_return_t rc;
+  while ((rc = dds_get_subscription_matched_status (rd, &st)) == DDS_RETCODE_OK && st.current_count < NWRITERS && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && st.current_count == NWRITERS);
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    dds_publication_matched_status_t pst;
+    while ((rc = dds_get_publication_matched_status (wr[i], &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tend)
+      dds_sleepfor (DDS_MSECS (10));
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+  }
+}
+
+// a reader catching up with a newly discovered writer may receive the first samples
+// out of order, so write and take one sample from each writer before starting the real
+// test; once it has been acknowledged the reader is known to be in sync
+static void wait_for_all_in_sync (dds_entity_t rd, const dds_entity_t wr[NWRITERS])
+{
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    const Space_Type1 sample = { .long_1 = i, .long_2 = -1, .long_3 = 0 };
+    dds_return_t rc = dds_write (wr[i], &sample);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    dds_return_t rc = dds_wait_for_acks (wr[i], DDS_SECS (10));
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  int ntaken = 0;
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (ntaken < NWRITERS && dds_time () < tend)
+  {
+    void *raw[NWRITERS] = { NULL };
+    dds_sample_info_t si[NWRITERS];
+    int32_t n = dds_take (rd, raw, si, NWRITERS, NWRITERS);
+    CU_ASSERT_FATAL (n >= 0);
+    for (int32_t j = 0; j < n; j++)
+      CU_ASSERT_FATAL (((const Space_Type1 *) raw[j])->long_2 == -1);
+    (void) dds_return_loan (rd, raw, n);
+    ntaken += n;
+    if (n == 0)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  CU_ASSERT_FATAL (ntaken == NWRITERS);
+}
+
+CU_Test (ddsc_delivery_queues, per_writer_order, .timeout = 30)
+{
+  char *conf_pub = ddsrt_expand_envvars (DDS_CONFIG_NO_PORT_GAIN, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_NO_PORT_GAIN "," DDS_CONFIG_DQUEUES, DDS_DOMAINID_SUB);
+  const dds_entity_t dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  const dds_entity_t dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  dds_free (conf_pub);
+  dds_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  {
+    struct dds_entity *x;
+    dds_return_t rc = dds_entity_pin (pp_sub, &x);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+    CU_ASSERT (x->m_domain->gv.n_user_dqueues == 4);
+    dds_entity_unpin (x);
+  }
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_delivery_queues", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_entity_t wr[NWRITERS];
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    wr[i] = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+    CU_ASSERT_FATAL (wr[i] > 0);
+    sync_reader_writer (pp_sub, rd, pp_pub, wr[i]);
+  }
+  dds_delete_qos (qos);
+  wait_for_all_matched (rd, wr);
+  wait_for_all_in_sync (rd, wr);
+
+  // interleave the writers so that the samples of all of them are in flight at
+  // the same time, each writer writing its own instance
+  for (int32_t s = 0; s < NSAMPLES; s++)
+  {
+    for (int i = 0; i < NWRITERS; i++)
+    {
+      const Space_Type1 sample = { .long_1 = i, .long_2 = s, .long_3 = 0 };
+      dds_return_t rc = dds_write (wr[i], &sample);
+      CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+    }
+  }
+
+  int32_t next[NWRITERS] = { 0 };
+  int nreceived = 0;
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (nreceived < NWRITERS * NSAMPLES && dds_time () < tend)
+  {
+    void *raw[10] = { NULL };
+    dds_sample_info_t si[10];
+    int32_t n = dds_take (rd, raw, si, 10, 10);
+    CU_ASSERT_FATAL (n >= 0);
+    for (int32_t j = 0; j < n; j++)
+    {
+      const Space_Type1 *sample = raw[j];
+      CU_ASSERT_FATAL (si[j].valid_data);
+      CU_ASSERT_FATAL (sample->long_1 >= 0 && sample->long_1 < NWRITERS);
+      // samples of a single writer must arrive in order and without gaps
+      CU_ASSERT_FATAL (sample->long_2 == next[sample->long_1]);
+      next[sample->long_1]++;
+      nreceived++;
+    }
+    (void) dds_return_loan (rd, raw, n);
+    if (n == 0)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  CU_ASSERT (nreceived == NWRITERS * NSAMPLES);
+
+  dds_delete (dom_sub);
+  dds_delete (dom_pub);
+}
+
+CU_Test (ddsc_delivery_queues, thread_count_range)
+{
+  const char *configs[] = {
+    "<Internal><DeliveryQueueThreads>0</DeliveryQueueThreads></Internal>",
+    "<Internal><DeliveryQueueThreads>65</DeliveryQueueThreads></Internal>",
+    "<Internal><DeliveryQueueThreads>4294967295</DeliveryQueueThreads></Internal>",
+    NULL
+  };
+  for (int i = 0; configs[i]; i++)
+    CU_ASSERT_FATAL (dds_create_domain (DDS_DOMAINID_SUB, configs[i]) < 0);
+}
@@ -0,0 +1,128 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+
+#include "test_common.h"
+#include "RoundTrip.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+// 5% loss on the publishing side only; with the default fragment and message sizes
+// a 100kB sample is sent as 8 DATA_FRAGs, parity per 2 turns that into 4 groups of 3
+#define DDS_CONFIG_FEC_PUB "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Internal><FragmentParityGroupSize>2</FragmentParityGroupSize><Test><XmitLossiness>50</XmitLossiness></Test></Internal>"
+#define DDS_CONFIG_FEC_SUB "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+
+#define NSAMPLES 200
+#define SAMPLE_SIZE 100000
+
+static unsigned char payload_byte (int32_t s, uint32_t i)
+{
+  return (unsigned char) ((uint32_t) s * 31 + i * 7);
+}
+
+CU_Test (ddsc_fec, best_effort_lossy, .timeout = 60)
+{
+  char *conf_pub = ddsrt_expand_envvars (DDS_CONFIG_FEC_PUB, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_FEC_SUB, DDS_DOMAINID_SUB);
+  const dds_entity_t dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  const dds_entity_t dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_fec", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  // discovery is reliable, so it completes despite the loss
+  const dds_time_t tmatch = dds_time () + DDS_SECS (10);
+  dds_publication_matched_status_t pst;
+  dds_subscription_matched_status_t sst;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+  while ((rc = dds_get_subscription_matched_status (rd, &sst)) == DDS_RETCODE_OK && sst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && sst.current_count == 1);
+
+  RoundTripModule_DataType sample;
+  sample.payload._length = sample.payload._maximum = SAMPLE_SIZE;
+  sample.payload._buffer = ddsrt_malloc (SAMPLE_SIZE);
+  sample.payload._release = false;
+  for (int32_t s = 0; s < NSAMPLES; s++)
+  {
+    for (uint32_t i = 0; i < SAMPLE_SIZE; i++)
+      sample.payload._buffer[i] = payload_byte (s, i);
+    rc = dds_write (wr, &sample);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+    // don't overrun the socket receive buffer
+    dds_sleepfor (DDS_MSECS (5));
+  }
+  ddsrt_free (sample.payload._buffer);
+
+  // identify samples by their contents, any reconstructed block must be correct
+  int nreceived = 0;
+  dds_time_t tlast = dds_time ();
+  while (nreceived < NSAMPLES && dds_time () < tlast + DDS_SECS (1))
+  {
+    void *raw[1] = { NULL };
+    dds_sample_info_t si;
+    const int32_t n = dds_take (rd, raw, &si, 1, 1);
+    CU_ASSERT_FATAL (n >= 0);
+    if (n == 0)
+    {
+      dds_sleepfor (DDS_MSECS (10));
+      continue;
+    }
+    const RoundTripModule_DataType *rs = raw[0];
+    CU_ASSERT_FATAL (si.valid_data);
+    CU_ASSERT_FATAL (rs->payload._length == SAMPLE_SIZE);
+    int32_t s = 0;
+    while (s < NSAMPLES && rs->payload._buffer[0] != payload_byte (s, 0))
+      s++;
+    for (uint32_t i = 0; i < SAMPLE_SIZE; i++)
+      CU_ASSERT_FATAL (rs->payload._buffer[i] == payload_byte (s, i));
+    (void) dds_return_loan (rd, raw, n);
+    nreceived++;
+    tlast = dds_time ();
+  }
+
+  // without parity, only 0.95^8 = 66% of the samples would make it; with it, a
+  // sample is lost only if two packets of a group are, and >97% should arrive
+  printf ("received %d of %d\n", nreceived, NSAMPLES);
+  CU_ASSERT (nreceived >= 85 * NSAMPLES / 100);
+
+  dds_delete (dom_sub);
+  dds_delete (dom_pub);
+}
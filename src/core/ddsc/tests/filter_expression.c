@@ -0,0 +1,379 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/threads.h"
+
+#include "test_common.h"
+#include "XSpaceNoTypeInfo.h"
+#include "FilterExpr.h"
+
+#define MAXSAMPLES 8
+
+struct filter_case {
+  const char *expr;
+  uint32_t nparams;
+  const char *params[2];
+  uint32_t expected; // bitmask of ids of samples that pass
+};
+
+static const FilterExpr_Final final_samples[] = {
+  { .id = 0, .s = 0, .ull = 0, .d = 0.0, .b = false, .c = 'a', .color = FilterExpr_RED, .name = (char *) "", .label = "l0", .pos = { 0, 0 } },
+  { .id = 1, .s = -5, .ull = 1, .d = -1.5, .b = true, .c = 'b', .color = FilterExpr_GREEN, .name = (char *) "alice", .label = "l1", .pos = { 1, 2 } },
+  { .id = 2, .s = 10, .ull = UINT64_MAX, .d = 2.5, .b = true, .c = 'c', .color = FilterExpr_BLUE, .name = (char *) "bob", .label = "l2", .pos = { -1, 5 } },
+  { .id = 3, .s = 3, .ull = 1000, .d = 3.0, .b = false, .c = 'x', .color = FilterExpr_RED, .name = (char *) "carol", .label = "l3", .pos = { 3, 3 } },
+  { .id = 4, .s = 7, .ull = 5, .d = 4.0, .b = true, .c = 'y', .color = FilterExpr_GREEN, .name = (char *) "it's", .label = "l4", .pos = { 10, -10 } },
+  { .id = 5, .s = 100, .ull = UINT64_C (18446744073709551000), .d = 1e10, .b = false, .c = 'z', .color = FilterExpr_BLUE, .name = (char *) "alfred", .label = "l5", .pos = { 7, 7 } }
+};
+
+static const struct filter_case final_cases[] = {
+  { "id = 3", 0, { NULL }, 0x08 },
+  { "s < 0", 0, { NULL }, 0x02 },
+  { "s >= 7", 0, { NULL }, 0x34 },
+  { "-5 = s", 0, { NULL }, 0x02 },
+  { "s between 0 and 7", 0, { NULL }, 0x19 },
+  { "s NOT BETWEEN 0 AND 7", 0, { NULL }, 0x26 },
+  { "ull > 1000", 0, { NULL }, 0x24 },
+  { "ull = 18446744073709551615", 0, { NULL }, 0x04 },
+  { "ull = 0xffffffffffffffff", 0, { NULL }, 0x04 },
+  { "ull > -1", 0, { NULL }, 0x3f },
+  { "d > 2.5", 0, { NULL }, 0x38 },
+  { "d <= 2", 0, { NULL }, 0x03 },
+  { "d = 3", 0, { NULL }, 0x08 },
+  { "d >= 1e9", 0, { NULL }, 0x20 },
+  { "b = TRUE", 0, { NULL }, 0x16 },
+  { "b = false", 0, { NULL }, 0x29 },
+  { "c = 'x'", 0, { NULL }, 0x08 },
+  { "c > 'b'", 0, { NULL }, 0x3c },
+  { "color = GREEN", 0, { NULL }, 0x12 },
+  { "color <> RED", 0, { NULL }, 0x36 },
+  { "color > GREEN", 0, { NULL }, 0x24 },
+  { "color = 2", 0, { NULL }, 0x24 },
+  { "name = 'bob'", 0, { NULL }, 0x04 },
+  { "name = 'it''s'", 0, { NULL }, 0x10 },
+  { "name = ''", 0, { NULL }, 0x01 },
+  { "name LIKE 'al%'", 0, { NULL }, 0x22 },
+  { "name LIKE '%o%'", 0, { NULL }, 0x0c },
+  { "name LIKE '___'", 0, { NULL }, 0x04 },
+  { "name LIKE '%r%d'", 0, { NULL }, 0x20 },
+  { "name NOT LIKE '%'", 0, { NULL }, 0x00 },
+  { "name > 'b'", 0, { NULL }, 0x1c },
+  { "label = 'l3'", 0, { NULL }, 0x08 },
+  { "pos.x = pos.y", 0, { NULL }, 0x29 },
+  { "pos.x > 0 AND pos.y > 0", 0, { NULL }, 0x2a },
+  { "NOT (pos.x > 0 OR pos.y > 0)", 0, { NULL }, 0x01 },
+  { "id = 1 OR id = 2 AND s > 5", 0, { NULL }, 0x06 },
+  { "(id = 1 OR id = 2) AND s > 5", 0, { NULL }, 0x04 },
+  { "not id < 3 and not id > 4", 0, { NULL }, 0x18 },
+  { "id = 0 OR id = 1 OR id = 2 OR (id > 3 AND NOT (id = 5))", 0, { NULL }, 0x17 },
+  { "s = %0", 1, { "10" }, 0x04 },
+  { "name = %0", 1, { "carol" }, 0x08 },
+  { "name = %0", 1, { "'carol'" }, 0x08 },
+  { "color = %1 OR id = %0", 2, { "0", "BLUE" }, 0x25 },
+  { "d > %0", 1, { "-1.5" }, 0x3d }
+};
+
+static const int32_t opt_5 = 5, opt_10 = 10;
+
+static const FilterExpr_Mutable mutable_samples[] = {
+  { .id = 0, .opt = NULL, .optstr = (char *) "x", .name = (char *) "n0", .pos = { 0, 0 }, .f = 0.0f },
+  { .id = 1, .opt = (int32_t *) &opt_5, .optstr = NULL, .name = (char *) "n1", .pos = { 1, 2 }, .f = 0.5f },
+  { .id = 2, .opt = NULL, .optstr = (char *) "y", .name = (char *) "n2", .pos = { 2, 4 }, .f = 1.0f },
+  { .id = 3, .opt = (int32_t *) &opt_10, .optstr = NULL, .name = (char *) "n3", .pos = { 3, 6 }, .f = 1.5f }
+};
+
+static const struct filter_case mutable_cases[] = {
+  { "opt = 5", 0, { NULL }, 0x02 },
+  { "opt <> 5", 0, { NULL }, 0x08 },
+  { "NOT opt = 5", 0, { NULL }, 0x0d },
+  { "optstr = 'y'", 0, { NULL }, 0x04 },
+  { "optstr LIKE '%'", 0, { NULL }, 0x05 },
+  { "name LIKE 'n_'", 0, { NULL }, 0x0f },
+  { "pos.y = 4", 0, { NULL }, 0x04 },
+  { "f >= 1.0", 0, { NULL }, 0x0c },
+  { "id > 1 AND opt > 0", 0, { NULL }, 0x08 }
+};
+
+static const FilterExpr_Derived derived_samples[] = {
+  { .parent = { .id = 0, .value = 1 }, .name = (char *) "x" },
+  { .parent = { .id = 1, .value = 2 }, .name = (char *) "y" },
+  { .parent = { .id = 2, .value = 3 }, .name = (char *) "z" }
+};
+
+static const struct filter_case derived_cases[] = {
+  { "value = 3", 0, { NULL }, 0x04 },
+  { "name = 'y' OR value < 2", 0, { NULL }, 0x03 }
+};
+
+static uint32_t run_filter (dds_entity_t pp, const dds_topic_descriptor_t *desc, const void *samples, size_t sample_size, uint32_t nsamples, const struct filter_case *fc, bool writer_side)
+{
+  char topicname[100];
+  dds_return_t rc;
+  create_unique_topic_name ("ddsc_filter_expression", topicname, sizeof (topicname));
+  const dds_entity_t tp_rd = dds_create_topic (pp, desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_rd > 0);
+  const dds_entity_t tp_wr = dds_create_topic (pp, desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_wr > 0);
+  rc = dds_set_topic_filter_expression (writer_side ? tp_wr : tp_rd, fc->expr, fc->nparams, fc->params);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd = dds_create_reader (pp, tp_rd, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp, tp_wr, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  // delivery to a local reader is synchronous
+  for (uint32_t i = 0; i < nsamples; i++)
+  {
+    rc = dds_write (wr, (const char *) samples + i * sample_size);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  void *raw[MAXSAMPLES] = { NULL };
+  dds_sample_info_t si[MAXSAMPLES];
+  const int32_t n = dds_take (rd, raw, si, MAXSAMPLES, MAXSAMPLES);
+  CU_ASSERT_FATAL (n >= 0);
+  uint32_t mask = 0;
+  for (int32_t i = 0; i < n; i++)
+  {
+    // the key is the first member in all types
+    CU_ASSERT_FATAL (si[i].valid_data);
+    mask |= 1u << *(const int32_t *) raw[i];
+  }
+  rc = dds_return_loan (rd, raw, n);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  rc = dds_delete (rd);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_delete (wr);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_delete (tp_rd);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_delete (tp_wr);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  return mask;
+}
+
+static void run_cases (const dds_topic_descriptor_t *desc, const void *samples, size_t sample_size, uint32_t nsamples, const struct filter_case *cases, size_t ncases)
+{
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  for (size_t i = 0; i < ncases; i++)
+  {
+    // reader side evaluates on the serialized data, writer side on the sample
+    for (int writer_side = 0; writer_side <= 1; writer_side++)
+    {
+      const uint32_t mask = run_filter (pp, desc, samples, sample_size, nsamples, &cases[i], writer_side);
+      printf ("%s (%s): expected %"PRIx32" got %"PRIx32"\n", cases[i].expr, writer_side ? "writer" : "reader", cases[i].expected, mask);
+      CU_ASSERT (mask == cases[i].expected);
+    }
+  }
+  dds_return_t rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+}
+
+CU_Test(ddsc_filter_expression, final)
+{
+  run_cases (&FilterExpr_Final_desc, final_samples, sizeof (final_samples[0]), sizeof (final_samples) / sizeof (final_samples[0]), final_cases, sizeof (final_cases) / sizeof (final_cases[0]));
+}
+
+CU_Test(ddsc_filter_expression, mutable)
+{
+  run_cases (&FilterExpr_Mutable_desc, mutable_samples, sizeof (mutable_samples[0]), sizeof (mutable_samples) / sizeof (mutable_samples[0]), mutable_cases, sizeof (mutable_cases) / sizeof (mutable_cases[0]));
+}
+
+CU_Test(ddsc_filter_expression, inheritance)
+{
+  run_cases (&FilterExpr_Derived_desc, derived_samples, sizeof (derived_samples[0]), sizeof (derived_samples) / sizeof (derived_samples[0]), derived_cases, sizeof (derived_cases) / sizeof (derived_cases[0]));
+}
+
+CU_Test(ddsc_filter_expression, invalid)
+{
+  static const struct {
+    const char *expr;
+    uint32_t nparams;
+    const char *params[1];
+    dds_return_t rc;
+  } cases[] = {
+    { "", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id =", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id == 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = 1 AND", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "(id = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = 1)", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = 1 garbage", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = 1x", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id BETWEEN 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id NOT = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "name = 'unterminated", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "nosuch = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "1 = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "name = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "name = id", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "s = 'abc'", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "color = PURPLE", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "name LIKE label", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "s LIKE 'a'", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "'a' LIKE name", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "pos.z = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id.x = 1", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = %0", 0, { NULL }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = %0", 1, { "abc" }, DDS_RETCODE_BAD_PARAMETER },
+    { "id = %0", 1, { "1 2" }, DDS_RETCODE_BAD_PARAMETER },
+    { "pos = 1", 0, { NULL }, DDS_RETCODE_UNSUPPORTED }
+  };
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_filter_expression", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &FilterExpr_Final_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  dds_return_t rc;
+  for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++)
+  {
+    rc = dds_set_topic_filter_expression (tp, cases[i].expr, cases[i].nparams, cases[i].params);
+    printf ("%s: expected %d got %d\n", cases[i].expr, (int) cases[i].rc, (int) rc);
+    CU_ASSERT (rc == cases[i].rc);
+  }
+  rc = dds_set_topic_filter_expression (tp, NULL, 0, NULL);
+  CU_ASSERT (rc == DDS_RETCODE_OK);
+  rc = dds_set_topic_filter_expression (pp, "id = 1", 0, NULL);
+  CU_ASSERT (rc == DDS_RETCODE_ILLEGAL_OPERATION);
+
+  // names can't be resolved without type information
+  create_unique_topic_name ("ddsc_filter_expression", topicname, sizeof (topicname));
+  const dds_entity_t tp_noti = dds_create_topic (pp, &XSpaceNoTypeInfo_t1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_noti > 0);
+  rc = dds_set_topic_filter_expression (tp_noti, "long_1 = 1", 0, NULL);
+  CU_ASSERT (rc == DDS_RETCODE_UNSUPPORTED);
+
+  rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+}
+
+static bool accept_all (const void *sample, void *arg)
+{
+  (void) sample; (void) arg;
+  return true;
+}
+
+CU_Test(ddsc_filter_expression, replace)
+{
+  // a filter function replaces an expression and vice versa
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_filter_expression", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &FilterExpr_Final_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  const dds_entity_t rd = dds_create_reader (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+
+  dds_return_t rc;
+  rc = dds_set_topic_filter_and_arg (tp, accept_all, NULL);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_set_topic_filter_expression (tp, "id = 1", 0, NULL);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  struct dds_topic_filter f;
+  rc = dds_get_topic_filter_extended (tp, &f);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  CU_ASSERT (f.mode == DDS_TOPIC_FILTER_NONE);
+  // id = 0 rejected at the writer, 1 accepted by both
+  for (int32_t i = 0; i < 2; i++)
+  {
+    rc = dds_write (wr, &final_samples[i]);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  void *raw[MAXSAMPLES] = { NULL };
+  dds_sample_info_t si[MAXSAMPLES];
+  int32_t n = dds_take (rd, raw, si, MAXSAMPLES, MAXSAMPLES);
+  CU_ASSERT_FATAL (n == 1);
+  CU_ASSERT (((const FilterExpr_Final *) raw[0])->id == 1);
+  rc = dds_return_loan (rd, raw, n);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  rc = dds_set_topic_filter_and_arg (tp, accept_all, NULL);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_write (wr, &final_samples[2]);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  n = dds_take (rd, raw, si, MAXSAMPLES, MAXSAMPLES);
+  CU_ASSERT_FATAL (n == 1);
+  CU_ASSERT (((const FilterExpr_Final *) raw[0])->id == 2);
+  rc = dds_return_loan (rd, raw, n);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+}
+
+struct concurrent_writer_arg {
+  dds_entity_t wr;
+  ddsrt_atomic_uint32_t stop;
+};
+
+static uint32_t concurrent_writer (void *varg)
+{
+  struct concurrent_writer_arg * const arg = varg;
+  uint32_t i = 0;
+  while (!ddsrt_atomic_ld32 (&arg->stop))
+  {
+    dds_return_t rc = dds_write (arg->wr, &final_samples[i++ % 3]);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  return 0;
+}
+
+CU_Test(ddsc_filter_expression, concurrent_replace)
+{
+  // the writer and the reader evaluate the expression without locking the topic, so
+  // replacing it while writing must not free it while it is in use
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_filter_expression", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &FilterExpr_Final_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_history (qos, DDS_HISTORY_KEEP_LAST, 1);
+  const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_delete_qos (qos);
+  struct concurrent_writer_arg arg = { .stop = DDSRT_ATOMIC_UINT32_INIT (0) };
+  arg.wr = dds_create_writer (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (arg.wr > 0);
+
+  ddsrt_threadattr_t tattr;
+  ddsrt_thread_t tid;
+  ddsrt_threadattr_init (&tattr);
+  dds_return_t rc = ddsrt_thread_create (&tid, "fexpr_wr", &tattr, concurrent_writer, &arg);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  static const char *exprs[] = { "id = 1", "id = 2 OR name LIKE 'a%'", NULL };
+  for (uint32_t i = 0; i < 1000; i++)
+  {
+    rc = dds_set_topic_filter_expression (tp, exprs[i % 3], 0, NULL);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  ddsrt_atomic_st32 (&arg.stop, 1);
+  rc = ddsrt_thread_join (tid, NULL);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+}
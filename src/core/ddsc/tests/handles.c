@@ -0,0 +1,113 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/threads.h"
+#include "dds__handles.h"
+
+#include "test_common.h"
+
+#define NSLOTS 3000
+#define NPINNERS 4
+#define NROUNDS 5
+
+struct pinner_arg {
+  ddsrt_atomic_uint32_t *slots;
+  ddsrt_atomic_uint32_t stop;
+  ddsrt_atomic_uint32_t npinned;
+};
+
+static uint32_t pinner (void *varg)
+{
+  struct pinner_arg * const arg = varg;
+  uint32_t npinned = 0;
+  while (!ddsrt_atomic_ld32 (&arg->stop))
+  {
+    const dds_handle_t hdl = (dds_handle_t) ddsrt_atomic_ld32 (&arg->slots[ddsrt_random () % NSLOTS]);
+    struct dds_handle_link *link;
+    if (hdl == 0 || dds_handle_pin (hdl, &link) != DDS_RETCODE_OK)
+      continue;
+    // the handle may have been deleted and reissued, but the link must be alive and match
+    CU_ASSERT_FATAL (link->hdl == hdl);
+    dds_handle_unpin (link);
+    npinned++;
+  }
+  ddsrt_atomic_add32 (&arg->npinned, npinned);
+  return 0;
+}
+
+CU_Test(ddsc_handles, concurrent_pin_delete_resize)
+{
+  // Lookups are lock-free, so links and bucket arrays discarded when the table grows
+  // must remain valid until all lookups that may have found them have completed; with
+  // ASan, a violation shows up as a use-after-free.
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+
+  struct dds_handle_link **links = ddsrt_malloc (NSLOTS * sizeof (*links));
+  struct pinner_arg arg = { .stop = DDSRT_ATOMIC_UINT32_INIT (0), .npinned = DDSRT_ATOMIC_UINT32_INIT (0) };
+  arg.slots = ddsrt_malloc (NSLOTS * sizeof (*arg.slots));
+  for (uint32_t i = 0; i < NSLOTS; i++)
+    ddsrt_atomic_st32 (&arg.slots[i], 0);
+
+  ddsrt_thread_t tids[NPINNERS];
+  ddsrt_threadattr_t tattr;
+  ddsrt_threadattr_init (&tattr);
+  for (uint32_t i = 0; i < NPINNERS; i++)
+  {
+    dds_return_t rc = ddsrt_thread_create (&tids[i], "pinner", &tattr, pinner, &arg);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+
+  for (uint32_t r = 0; r < NROUNDS; r++)
+  {
+    // creating this many handles grows the table several times
+    for (uint32_t i = 0; i < NSLOTS; i++)
+    {
+      links[i] = ddsrt_malloc (sizeof (*links[i]));
+      memset (links[i], 0, sizeof (*links[i]));
+      const dds_handle_t hdl = dds_handle_create (links[i], false, false, true);
+      CU_ASSERT_FATAL (hdl > 0);
+      dds_handle_unpend (links[i]);
+      ddsrt_atomic_st32 (&arg.slots[i], (uint32_t) hdl);
+    }
+    // deleting them while the pinners are still trying to use them
+    for (uint32_t i = 0; i < NSLOTS; i++)
+    {
+      struct dds_handle_link *link;
+      int32_t rc = dds_handle_pin_for_delete ((dds_handle_t) ddsrt_atomic_ld32 (&arg.slots[i]), true, false, &link);
+      CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && link == links[i]);
+      dds_handle_close_wait (link);
+      rc = dds_handle_delete (link);
+      CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+      ddsrt_free (link);
+      if (i % 2)
+        ddsrt_atomic_st32 (&arg.slots[i], 0);
+    }
+  }
+
+  ddsrt_atomic_st32 (&arg.stop, 1);
+  for (uint32_t i = 0; i < NPINNERS; i++)
+  {
+    dds_return_t rc = ddsrt_thread_join (tids[i], NULL);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  CU_ASSERT (ddsrt_atomic_ld32 (&arg.npinned) > 0);
+  ddsrt_free (arg.slots);
+  ddsrt_free (links);
+
+  dds_return_t rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+}
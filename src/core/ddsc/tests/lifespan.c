@@ -12,6 +12,8 @@
 #include <limits.h>
 
 #include "dds/dds.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/process.h"
 #include "dds/ddsrt/threads.h"
 #include "dds/ddsi/ddsi_entity_index.h"
@@ -149,3 +151,70 @@ CU_Test(ddsc_lifespan, basic, .init=ddsi_lifespan_init, .fini=ddsi_lifespan_fini
 
   dds_delete_qos(qos);
 }
+
+#define SHARDED_NINST 16
+
+CU_Test(ddsc_lifespan, sharded_reader)
+{
+  // the shards of a sharded reader history each expire samples and detect missed
+  // deadlines themselves, check that it works for instances spread over all shards
+  char *conf = ddsrt_expand_envvars ("${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Internal><ReaderHistoryShards>4</ReaderHistoryShards></Internal>", 0);
+  const dds_entity_t dom = dds_create_domain (0, conf);
+  CU_ASSERT_FATAL (dom > 0);
+  ddsrt_free (conf);
+  const dds_entity_t pp = dds_create_participant (0, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char name[100];
+  const dds_entity_t tp = dds_create_topic (pp, &Space_Type1_desc, create_unique_topic_name ("ddsc_lifespan_sharded", name, sizeof (name)), NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_deadline (qos, DDS_MSECS (100));
+  const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_qset_lifespan (qos, DDS_MSECS (300));
+  const dds_entity_t wr = dds_create_writer (pp, tp, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  for (int32_t i = 0; i < SHARDED_NINST; i++)
+  {
+    dds_return_t ret = dds_write (wr, &(Space_Type1){ i, 0, 0 });
+    CU_ASSERT_EQUAL_FATAL (ret, DDS_RETCODE_OK);
+  }
+  void *raw[SHARDED_NINST] = { NULL };
+  dds_sample_info_t si[SHARDED_NINST];
+  int32_t n = dds_read (rd, raw, si, SHARDED_NINST, SHARDED_NINST);
+  CU_ASSERT_EQUAL_FATAL (n, SHARDED_NINST);
+  (void) dds_return_loan (rd, raw, n);
+
+  // lifespan expiry removes all samples from all shards
+  const dds_time_t tend = dds_time () + DDS_SECS (5);
+  while ((n = dds_read (rd, raw, si, SHARDED_NINST, SHARDED_NINST)) > 0 && dds_time () < tend)
+  {
+    (void) dds_return_loan (rd, raw, n);
+    dds_sleepfor (DDS_MSECS (50));
+  }
+  CU_ASSERT_EQUAL_FATAL (n, 0);
+
+  // each instance missed its deadline at least once by now
+  dds_requested_deadline_missed_status_t dstatus;
+  dds_return_t ret = dds_get_requested_deadline_missed_status (rd, &dstatus);
+  CU_ASSERT_EQUAL_FATAL (ret, DDS_RETCODE_OK);
+  CU_ASSERT (dstatus.total_count >= SHARDED_NINST);
+
+  ret = dds_delete (dom);
+  CU_ASSERT_EQUAL_FATAL (ret, DDS_RETCODE_OK);
+}
+
+CU_Test(ddsc_lifespan, sharded_reader_shard_count_range)
+{
+  const char *configs[] = {
+    "<Internal><ReaderHistoryShards>0</ReaderHistoryShards></Internal>",
+    "<Internal><ReaderHistoryShards>65</ReaderHistoryShards></Internal>",
+    "<Internal><ReaderHistoryShards>4294967295</ReaderHistoryShards></Internal>",
+    NULL
+  };
+  for (int i = 0; configs[i]; i++)
+    CU_ASSERT_FATAL (dds_create_domain (0, configs[i]) < 0);
+}
@@ -10,6 +10,10 @@
 
 #include <stdio.h>
 #include "dds/dds.h"
+#include "dds/ddsrt/bswap.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_protocol.h"
 #include "test_common.h"
 #include "build_options.h"
 
@@ -341,3 +345,119 @@ CU_Test (ddsc_loan, read_cleanup, .init = create_entities, .fini = delete_entiti
   CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
 }
 
+
+CU_Test (ddsc_loan, serdata_zerocopy)
+{
+  char topicname[100];
+  create_unique_topic_name ("ddsc_loan_serdata_zerocopy", topicname, sizeof topicname);
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, 0);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t tp = dds_create_topic (pp, &Space_Type1_desc, topicname, qos, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  const dds_entity_t wr = dds_create_writer (pp, tp, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_delete_qos (qos);
+
+  dds_return_t result;
+  result = dds_write (wr, &(Space_Type1){ 1, 2, 3 });
+  CU_ASSERT_FATAL (result == 0);
+
+  /* Space_Type1 is memcpy-safe, but the sample remains in the reader after a read and
+     the application may modify the loan, so each read must yield a private copy */
+  void *ptrs1[2] = { NULL }, *ptrs2[2] = { NULL };
+  dds_sample_info_t si[2];
+  int32_t n1 = dds_read (rd, ptrs1, si, 2, 2);
+  CU_ASSERT_FATAL (n1 == 1);
+  CU_ASSERT_FATAL (si[0].valid_data);
+  Space_Type1 *s = ptrs1[0];
+  CU_ASSERT (s->long_1 == 1 && s->long_2 == 2 && s->long_3 == 3);
+  s->long_1 = 7;
+  int32_t n2 = dds_read (rd, ptrs2, si, 2, 2);
+  CU_ASSERT_FATAL (n2 == 1);
+  CU_ASSERT_FATAL (ptrs1[0] != ptrs2[0]);
+  s = ptrs2[0];
+  CU_ASSERT (s->long_1 == 1 && s->long_2 == 2 && s->long_3 == 3);
+  result = dds_return_loan (rd, ptrs2, n2);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+  result = dds_return_loan (rd, ptrs1, n1);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+
+  /* a take leaves the loan as the sole owner of the serdata, so that may alias it */
+  n1 = dds_take (rd, ptrs1, si, 2, 2);
+  CU_ASSERT_FATAL (n1 == 1);
+  s = ptrs1[0];
+  CU_ASSERT (s->long_1 == 1 && s->long_2 == 2 && s->long_3 == 3);
+  s->long_1 = 7;
+  result = dds_return_loan (rd, ptrs1, n1);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+
+  /* but not if another reader received the same serdata */
+  const dds_entity_t rd2 = dds_create_reader (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (rd2 > 0);
+  result = dds_write (wr, &(Space_Type1){ 1, 2, 3 });
+  CU_ASSERT_FATAL (result == 0);
+  n1 = dds_take (rd, ptrs1, si, 2, 2);
+  CU_ASSERT_FATAL (n1 == 1);
+  s = ptrs1[0];
+  s->long_1 = 7;
+  n2 = dds_take (rd2, ptrs2, si, 2, 2);
+  CU_ASSERT_FATAL (n2 == 1);
+  CU_ASSERT_FATAL (ptrs1[0] != ptrs2[0]);
+  s = ptrs2[0];
+  CU_ASSERT (s->long_1 == 1 && s->long_2 == 2 && s->long_3 == 3);
+  result = dds_return_loan (rd2, ptrs2, n2);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+  result = dds_return_loan (rd, ptrs1, n1);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+  result = dds_delete (rd2);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+
+  /* data in the non-native byte order gets swapped on reception, and so can still
+     be loaned out without deserializing it */
+  struct ddsi_sertype *st;
+  result = dds_get_entity_sertype (wr, (const struct ddsi_sertype **) &st);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+  const uint16_t swapped_id = DDSI_RTPS_CDR_ENC_IS_NATIVE (DDSI_RTPS_CDR_BE) ? DDSI_RTPS_CDR_LE : DDSI_RTPS_CDR_BE;
+  struct { uint16_t id, options; uint32_t v[3]; } cdr = {
+    swapped_id, 0, { ddsrt_bswap4u (4), ddsrt_bswap4u (5), ddsrt_bswap4u (6) }
+  };
+  ddsrt_iovec_t iov = { .iov_base = &cdr, .iov_len = sizeof (cdr) };
+  struct ddsi_serdata *sd = ddsi_serdata_from_ser_iov (st, SDK_DATA, 1, &iov, iov.iov_len);
+  CU_ASSERT_FATAL (sd != NULL);
+  result = dds_writecdr (wr, sd);
+  CU_ASSERT_FATAL (result == 0);
+  n1 = dds_take (rd, ptrs1, si, 2, 2);
+  CU_ASSERT_FATAL (n1 == 1);
+  s = ptrs1[0];
+  CU_ASSERT (s->long_1 == 4 && s->long_2 == 5 && s->long_3 == 6);
+  result = dds_return_loan (rd, ptrs1, n1);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+
+  /* types that need deserializing get a separate copy for each read */
+  create_unique_topic_name ("ddsc_loan_serdata_zerocopy", topicname, sizeof topicname);
+  const dds_entity_t tp_rt = dds_create_topic (pp, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_rt > 0);
+  const dds_entity_t wr_rt = dds_create_writer (pp, tp_rt, NULL, NULL);
+  CU_ASSERT_FATAL (wr_rt > 0);
+  const dds_entity_t rd_rt = dds_create_reader (pp, tp_rt, NULL, NULL);
+  CU_ASSERT_FATAL (rd_rt > 0);
+  result = dds_write (wr_rt, &(RoundTripModule_DataType){ .payload = { ._length = 1, ._buffer = (uint8_t[]) { 'a' } } });
+  CU_ASSERT_FATAL (result == 0);
+  n1 = dds_read (rd_rt, ptrs1, si, 2, 2);
+  CU_ASSERT_FATAL (n1 == 1);
+  n2 = dds_read (rd_rt, ptrs2, si, 2, 2);
+  CU_ASSERT_FATAL (n2 == 1);
+  CU_ASSERT (ptrs1[0] != ptrs2[0]);
+  result = dds_return_loan (rd_rt, ptrs2, n2);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+  result = dds_return_loan (rd_rt, ptrs1, n1);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+
+  result = dds_delete (pp);
+  CU_ASSERT_FATAL (result == DDS_RETCODE_OK);
+}
@@ -0,0 +1,156 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+
+#include "test_common.h"
+#include "RoundTrip.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_PACING_PUB(rates, test) "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Internal><Pacing>" rates "</Pacing><Test>" test "</Test></Internal>"
+#define DDS_CONFIG_PACING_SUB "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+
+#define SAMPLE_SIZE 100000
+
+static dds_entity_t dom_pub, dom_sub, wr, rd;
+
+static void pacing_init (const char *config_pub)
+{
+  char *conf_pub = ddsrt_expand_envvars (config_pub, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_PACING_SUB, DDS_DOMAINID_SUB);
+  dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_pacing", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  const dds_time_t tmatch = dds_time () + DDS_SECS (10);
+  dds_publication_matched_status_t pst;
+  dds_subscription_matched_status_t sst;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+  while ((rc = dds_get_subscription_matched_status (rd, &sst)) == DDS_RETCODE_OK && sst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && sst.current_count == 1);
+}
+
+static void pacing_fini (void)
+{
+  dds_delete (dom_sub);
+  dds_delete (dom_pub);
+}
+
+static void write_and_take (int32_t nsamples)
+{
+  RoundTripModule_DataType sample;
+  sample.payload._length = sample.payload._maximum = SAMPLE_SIZE;
+  sample.payload._buffer = ddsrt_malloc (SAMPLE_SIZE);
+  sample.payload._release = false;
+  memset (sample.payload._buffer, 0xa5, SAMPLE_SIZE);
+  for (int32_t s = 0; s < nsamples; s++)
+  {
+    dds_return_t rc = dds_write (wr, &sample);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  ddsrt_free (sample.payload._buffer);
+
+  dds_return_t rc = dds_wait_for_acks (wr, DDS_SECS (30));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  int32_t ntaken = 0, n;
+  void *raw[1] = { NULL };
+  dds_sample_info_t si;
+  while ((n = dds_take (rd, raw, &si, 1, 1)) > 0)
+  {
+    (void) dds_return_loan (rd, raw, n);
+    ntaken++;
+  }
+  CU_ASSERT_FATAL (n == 0);
+  CU_ASSERT (ntaken == nsamples);
+}
+
+CU_Test (ddsc_pacing, rate_limit, .timeout = 30)
+{
+  // 1 MB is 1048576 bytes, keeping the minimum equal to the maximum means the rate doesn't change
+  pacing_init (DDS_CONFIG_PACING_PUB ("<MaxRate>1MB</MaxRate><MinRate>1MB</MinRate><BurstSize>64kB</BurstSize>", ""));
+  struct dds_statistics *stat = dds_create_statistics (wr);
+  CU_ASSERT_FATAL (stat != NULL);
+  const struct dds_stat_keyvalue *rate = dds_lookup_statistic (stat, "pacing_rate");
+  const struct dds_stat_keyvalue *achieved = dds_lookup_statistic (stat, "pacing_achieved_rate");
+  const struct dds_stat_keyvalue *time_paced = dds_lookup_statistic (stat, "time_paced");
+  CU_ASSERT_FATAL (rate != NULL && achieved != NULL && time_paced != NULL);
+  CU_ASSERT_FATAL (dds_lookup_statistic (stat, "pacing_backoff_count") != NULL);
+
+  // 2MB of data written as fast as possible takes about 2s
+  const dds_time_t tstart = dds_time ();
+  write_and_take (20);
+  const dds_duration_t dt = dds_time () - tstart;
+  printf ("20 x %d bytes in %.3fs\n", SAMPLE_SIZE, (double) dt / 1e9);
+  CU_ASSERT (dt >= DDS_MSECS (1500));
+
+  dds_return_t rc = dds_refresh_statistics (stat);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  printf ("rate %"PRIu64" achieved %"PRIu64" paced %"PRIu64"ns\n", rate->u.u64, achieved->u.u64, time_paced->u.u64);
+  CU_ASSERT (rate->u.u64 == 1048576);
+  // samples are counted when they start waiting, the burst allows some slack as well
+  CU_ASSERT (achieved->u.u64 > 0 && achieved->u.u64 <= 1048576 + 65536 + 2 * SAMPLE_SIZE);
+  CU_ASSERT (time_paced->u.u64 >= DDS_MSECS (1000));
+  dds_delete_statistics (stat);
+  pacing_fini ();
+}
+
+CU_Test (ddsc_pacing, backoff, .timeout = 60)
+{
+  // 10% packet loss on the publishing side causes retransmit requests, each of which
+  // should halve the rate at most once per round-trip time
+  pacing_init (DDS_CONFIG_PACING_PUB ("<MaxRate>10MB</MaxRate>", "<XmitLossiness>100</XmitLossiness>"));
+  struct dds_statistics *stat = dds_create_statistics (wr);
+  CU_ASSERT_FATAL (stat != NULL);
+  write_and_take (50);
+  dds_return_t rc = dds_refresh_statistics (stat);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  const struct dds_stat_keyvalue *backoffs = dds_lookup_statistic (stat, "pacing_backoff_count");
+  const struct dds_stat_keyvalue *rexmit = dds_lookup_statistic (stat, "rexmit_bytes");
+  CU_ASSERT_FATAL (backoffs != NULL && rexmit != NULL);
+  printf ("backoffs %"PRIu32" rexmit_bytes %"PRIu64"\n", backoffs->u.u32, rexmit->u.u64);
+  CU_ASSERT (rexmit->u.u64 > 0);
+  CU_ASSERT (backoffs->u.u32 > 0);
+  dds_delete_statistics (stat);
+  pacing_fini ();
+}
@@ -496,3 +496,84 @@ CU_Test(ddsc_qosmatch, basic)
   rc = dds_delete (sub_dom);
   CU_ASSERT_FATAL (rc == 0);
 }
+
+static dds_entity_t create_in_partitions (dds_entity_t pp, dds_entity_t tp, bool isrd, const char * const *ps)
+{
+  uint32_t n = 0;
+  while (ps[n])
+    n++;
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_partition (qos, n, (const char **) ps);
+  const dds_entity_t grp = isrd ? dds_create_subscriber (pp, qos, NULL) : dds_create_publisher (pp, qos, NULL);
+  CU_ASSERT_FATAL (grp > 0);
+  dds_delete_qos (qos);
+  const dds_entity_t ep = isrd ? dds_create_reader (grp, tp, NULL, NULL) : dds_create_writer (grp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (ep > 0);
+  return ep;
+}
+
+CU_Test(ddsc_qosmatch, partitions)
+{
+  /* Endpoint matching only considers endpoints with a partition name in common
+     and those with a wildcard partition, check that it still gets all the corner
+     cases right, in both creation orders.  Local matching is synchronous, so the
+     result can be checked immediately. */
+  static const struct {
+    const char *wr[4];
+    const char *rd[4];
+    bool match;
+  } cases[] = {
+    { { NULL }, { NULL }, true },
+    { { "", NULL }, { NULL }, true },
+    { { "a", NULL }, { NULL }, false },
+    { { "*", NULL }, { NULL }, true },
+    { { "a", NULL }, { "a", NULL }, true },
+    { { "a", "a", NULL }, { "a", NULL }, true },
+    { { "a", "b", NULL }, { "c", "b", NULL }, true },
+    { { "a", "b", NULL }, { "c", "d", NULL }, false },
+    { { "a*", NULL }, { "ab", NULL }, true },
+    { { "ab", NULL }, { "a?", NULL }, true },
+    { { "a*", NULL }, { "a*", NULL }, false },
+    { { "a*", NULL }, { "b", NULL }, false },
+    { { "x", "a*", NULL }, { "ab", "y", NULL }, true },
+    { { "b*", "c", NULL }, { "x", "c", NULL }, true }
+  };
+  char topicname[100];
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++)
+  {
+    for (int rdfirst = 0; rdfirst <= 1; rdfirst++)
+    {
+      create_unique_topic_name ("ddsc_qosmatch_partitions", topicname, sizeof topicname);
+      const dds_entity_t tp = dds_create_topic (pp, &RWData_Msg_desc, topicname, NULL, NULL);
+      CU_ASSERT_FATAL (tp > 0);
+      dds_entity_t rd = 0, wr;
+      if (rdfirst)
+        rd = create_in_partitions (pp, tp, true, cases[i].rd);
+      wr = create_in_partitions (pp, tp, false, cases[i].wr);
+      if (!rdfirst)
+        rd = create_in_partitions (pp, tp, true, cases[i].rd);
+
+      printf ("case %zu rdfirst %d match %d\n", i, rdfirst, (int) cases[i].match);
+      dds_return_t rc = dds_get_matched_subscriptions (wr, NULL, 0);
+      CU_ASSERT_FATAL (rc == (int) cases[i].match);
+      rc = dds_get_matched_publications (rd, NULL, 0);
+      CU_ASSERT_FATAL (rc == (int) cases[i].match);
+
+      /* disjoint partitions are not an incompatibility */
+      dds_offered_incompatible_qos_status_t oiq;
+      dds_requested_incompatible_qos_status_t riq;
+      rc = dds_get_offered_incompatible_qos_status (wr, &oiq);
+      CU_ASSERT_FATAL (rc == 0);
+      rc = dds_get_requested_incompatible_qos_status (rd, &riq);
+      CU_ASSERT_FATAL (rc == 0);
+      CU_ASSERT_FATAL (oiq.total_count == 0 && riq.total_count == 0);
+
+      rc = dds_delete (tp);
+      CU_ASSERT_FATAL (rc == 0);
+    }
+  }
+  dds_return_t rc = dds_delete (pp);
+  CU_ASSERT_FATAL (rc == 0);
+}
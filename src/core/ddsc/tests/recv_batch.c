@@ -0,0 +1,159 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "ddsi__tran.h"
+
+#include "test_common.h"
+#include "test_util.h"
+
+#define MAXSZ 300
+
+static dds_entity_t pp;
+static struct ddsi_tran_conn *rdconn, *wrconn;
+static ddsi_locator_t rdloc;
+static ddsrt_atomic_uint32_t ntruncated;
+
+static void logger (void *ptr, const dds_log_data_t *data)
+{
+  (void) ptr;
+  if (strstr (data->message, "truncated") != NULL)
+    ddsrt_atomic_inc32 (&ntruncated);
+}
+
+static bool recv_batch_init (void)
+{
+  pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  struct ddsi_domaingv * const gv = get_domaingv (pp);
+  if (gv->config.transport_selector != DDSI_TRANS_UDP)
+  {
+    printf ("skipping test: not using UDPv4 transport\n");
+    dds_delete (pp);
+    return false;
+  }
+
+  const struct ddsi_tran_qos rdqos = { .m_purpose = DDSI_TRAN_QOS_RECV_UC, .m_diffserv = 0, .m_interface = NULL };
+  dds_return_t rc = ddsi_factory_create_conn (&rdconn, gv->m_factory, DDSI_TRAN_RANDOM_PORT_NUMBER, &rdqos);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  if (rdconn->m_read_multi_fn == 0)
+  {
+    printf ("skipping test: no recvmmsg\n");
+    ddsi_conn_free (rdconn);
+    dds_delete (pp);
+    return false;
+  }
+  CU_ASSERT_FATAL (ddsi_conn_locator (rdconn, &rdloc) == 0);
+  const struct ddsi_tran_qos wrqos = { .m_purpose = DDSI_TRAN_QOS_XMIT_UC, .m_diffserv = 0, .m_interface = &gv->interfaces[0] };
+  rc = ddsi_factory_create_conn (&wrconn, gv->m_factory, DDSI_TRAN_RANDOM_PORT_NUMBER, &wrqos);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  ddsrt_atomic_st32 (&ntruncated, 0);
+  dds_set_log_sink (&logger, NULL);
+  return true;
+}
+
+static void recv_batch_fini (void)
+{
+  dds_set_log_sink (NULL, NULL);
+  ddsi_conn_free (wrconn);
+  ddsi_conn_free (rdconn);
+  dds_delete (pp);
+}
+
+static void send_packets (uint32_t first, uint32_t n, uint32_t size)
+{
+  // packet i is size + i bytes long and filled with i
+  unsigned char buf[MAXSZ];
+  DDSI_DECL_TRAN_WRITE_MSGFRAGS_PTR (msgfrags, 1);
+  for (uint32_t i = first; i < first + n; i++)
+  {
+    assert (size + i <= sizeof (buf));
+    memset (buf, (int) i, size + i);
+    msgfrags->niov = 1;
+    msgfrags->iov[0].iov_base = buf;
+    msgfrags->iov[0].iov_len = (ddsrt_iov_len_t) (size + i);
+    const ssize_t nsent = ddsi_conn_write (wrconn, &rdloc, msgfrags, 0);
+    CU_ASSERT_FATAL (nsent == (ssize_t) (size + i));
+  }
+}
+
+static int read_packets (struct ddsi_tran_read_msg *msgs, unsigned char (*bufs)[MAXSZ], uint32_t n, size_t len)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    memset (bufs[i], 0xee, MAXSZ);
+    msgs[i].buf = bufs[i];
+    msgs[i].len = len;
+    msgs[i].sz = -1;
+  }
+  return ddsi_conn_read_multi (rdconn, msgs, n);
+}
+
+static void check_packet (const struct ddsi_tran_read_msg *msg, uint32_t i, size_t expsize)
+{
+  CU_ASSERT_FATAL (msg->sz == (ssize_t) expsize);
+  for (size_t k = 0; k < expsize; k++)
+    CU_ASSERT_FATAL (msg->buf[k] == (unsigned char) i);
+  // nothing beyond the packet (or the buffer size) may be touched
+  CU_ASSERT_FATAL (msg->buf[expsize] == 0xee);
+  CU_ASSERT_FATAL (msg->pktinfo.src.kind == DDSI_LOCATOR_KIND_UDPv4);
+}
+
+CU_Test (ddsc_recv_batch, several_and_partial)
+{
+  if (!recv_batch_init ())
+    return;
+  struct ddsi_tran_read_msg msgs[4];
+  unsigned char bufs[4][MAXSZ];
+
+  // 10 packets read 4 at a time: two full batches, then a partial one
+  send_packets (0, 10, 100);
+  uint32_t next = 0;
+  const int exp[] = { 4, 4, 2 };
+  for (int r = 0; r < 3; r++)
+  {
+    const int n = read_packets (msgs, bufs, 4, MAXSZ - 1);
+    CU_ASSERT_FATAL (n == exp[r]);
+    for (int i = 0; i < n; i++, next++)
+      check_packet (&msgs[i], next, 100 + next);
+    // buffers beyond those filled are left alone
+    for (int i = n; i < 4; i++)
+      CU_ASSERT_FATAL (msgs[i].sz == -1 && bufs[i][0] == 0xee);
+  }
+  CU_ASSERT (ddsrt_atomic_ld32 (&ntruncated) == 0);
+  recv_batch_fini ();
+}
+
+CU_Test (ddsc_recv_batch, truncated)
+{
+  if (!recv_batch_init ())
+    return;
+  struct ddsi_tran_read_msg msgs[4];
+  unsigned char bufs[4][MAXSZ];
+
+  // packets 0 and 2 fit the 150 byte buffers, packet 1 doesn't: it is truncated
+  // (and a warning logged) without affecting its neighbours
+  send_packets (0, 1, 100);
+  send_packets (1, 1, 199);
+  send_packets (2, 1, 100);
+  const int n = read_packets (msgs, bufs, 4, 150);
+  CU_ASSERT_FATAL (n == 3);
+  check_packet (&msgs[0], 0, 100);
+  check_packet (&msgs[1], 1, 150);
+  check_packet (&msgs[2], 2, 102);
+  CU_ASSERT (ddsrt_atomic_ld32 (&ntruncated) == 1);
+  recv_batch_fini ();
+}
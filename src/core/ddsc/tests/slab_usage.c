@@ -0,0 +1,127 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/slab.h"
+
+#include "test_common.h"
+#include "Space.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_SLAB "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+
+static uint64_t slab_heap_allocs (const struct dds_statistics *stat)
+{
+  uint64_t n = 0;
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+  {
+    char name[32];
+    snprintf (name, sizeof (name), "slab_%u_heap", (unsigned) (DDSRT_SLAB_MIN_SIZE << i));
+    const struct dds_stat_keyvalue *kv = dds_lookup_statistic (stat, name);
+    CU_ASSERT_FATAL (kv != NULL);
+    n += kv->u.u64;
+    snprintf (name, sizeof (name), "slab_%u_blocks", (unsigned) (DDSRT_SLAB_MIN_SIZE << i));
+    CU_ASSERT_FATAL (dds_lookup_statistic (stat, name) != NULL);
+  }
+  return n;
+}
+
+static void write_take (dds_entity_t wr, dds_entity_t rd, dds_entity_t ws, int32_t i)
+{
+  Space_Type1 s = { .long_1 = i % 10, .long_2 = i, .long_3 = 0 };
+  dds_return_t rc = dds_write (wr, &s);
+  CU_ASSERT_FATAL (rc == 0);
+  void *raw = &s;
+  dds_sample_info_t si;
+  do {
+    rc = dds_waitset_wait (ws, NULL, 0, DDS_SECS (5));
+    CU_ASSERT_FATAL (rc > 0);
+  } while ((rc = dds_take (rd, &raw, &si, 1, 1)) == 0);
+  CU_ASSERT_FATAL (rc == 1);
+  CU_ASSERT_FATAL (s.long_2 == i);
+}
+
+CU_Test(ddsc_slab, steady_state, .timeout = 30)
+{
+  // Writing and taking a bounded type in a loop, over the network, should not require
+  // allocating any new blocks once everything has warmed up.  Other threads may still
+  // allocate occasionally (e.g., discovery), so it suffices if one round is clean.
+  char *conf_pub = ddsrt_expand_envvars (DDS_CONFIG_SLAB, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_SLAB, DDS_DOMAINID_SUB);
+  const dds_entity_t dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  const dds_entity_t dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_slab", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_LAST, 1);
+  const dds_entity_t rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+  sync_reader_writer (pp_sub, rd, pp_pub, wr);
+
+  dds_return_t rc = dds_set_status_mask (rd, DDS_DATA_AVAILABLE_STATUS);
+  CU_ASSERT_FATAL (rc == 0);
+  const dds_entity_t ws = dds_create_waitset (pp_sub);
+  CU_ASSERT_FATAL (ws > 0);
+  rc = dds_waitset_attach (ws, rd, 0);
+  CU_ASSERT_FATAL (rc == 0);
+
+  struct dds_statistics *stat = dds_create_statistics (dom_pub);
+  CU_ASSERT_FATAL (stat != NULL);
+
+  int32_t i = 0;
+  for (; i < 1000; i++)
+    write_take (wr, rd, ws, i);
+  bool clean = false;
+  for (int round = 0; round < 10 && !clean; round++)
+  {
+    rc = dds_refresh_statistics (stat);
+    CU_ASSERT_FATAL (rc == 0);
+    const uint64_t n0 = slab_heap_allocs (stat);
+    CU_ASSERT_FATAL (n0 > 0); // warming up must have involved the allocator
+    for (int32_t j = 0; j < 500; j++, i++)
+      write_take (wr, rd, ws, i);
+    rc = dds_refresh_statistics (stat);
+    CU_ASSERT_FATAL (rc == 0);
+    const uint64_t n1 = slab_heap_allocs (stat);
+    printf ("round %d: %"PRIu64" heap allocations\n", round, n1 - n0);
+    clean = (n1 == n0);
+  }
+  CU_ASSERT (clean);
+
+  dds_delete_statistics (stat);
+  rc = dds_delete (dom_pub);
+  CU_ASSERT_FATAL (rc == 0);
+  rc = dds_delete (dom_sub);
+  CU_ASSERT_FATAL (rc == 0);
+}
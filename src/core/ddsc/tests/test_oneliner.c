@@ -1464,6 +1464,22 @@ static void dowriteflush (struct oneliner_ctx *ctx)
     error_dds (ctx, ret, "flush: failed");
 }
 
+static void dobatch (struct oneliner_ctx *ctx)
+{
+  dds_return_t ret;
+  mprintf (ctx, "begin batch\n");
+  if ((ret = dds_begin_batch ()) != 0)
+    error_dds (ctx, ret, "batch: failed");
+}
+
+static void doendbatch (struct oneliner_ctx *ctx)
+{
+  dds_return_t ret;
+  mprintf (ctx, "end batch\n");
+  if ((ret = dds_end_batch ()) != 0)
+    error_dds (ctx, ret, "endbatch: failed");
+}
+
 static int checkstatus (struct oneliner_ctx *ctx, int ll, int ent, struct oneliner_lex *argl, const void *status)
 {
   assert (lldesc[ll].desc != NULL);
@@ -1980,6 +1996,8 @@ static void dispatchcmd (struct oneliner_ctx *ctx)
     { "dispfail",   dodispfail },
     { "unregfail",  dounregfail },
     { "flush",      dowriteflush },
+    { "batch",      dobatch },
+    { "endbatch",   doendbatch },
     { "take",       dotake },
     { "read",       doread },
     { "deaf",       dodeaf },
@@ -78,6 +78,11 @@
  *
  *                       Invokes dds_write_flush on entity
  *
+ *               | batch
+ *               | endbatch
+ *
+ *                       Invokes dds_begin_batch/dds_end_batch
+ *
  *               | READ-LIKE ENTITY-NAME
  *               | READ-LIKE(A,B) ENTITY-NAME
  *               | READ-LIKE[!]{[S1[,S2[,S3...]][,...]} ENTITY-NAME
@@ -15,10 +15,14 @@
 #include "dds/ddsrt/process.h"
 #include "dds/ddsrt/threads.h"
 #include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/random.h"
 #include "dds/ddsi/ddsi_entity_index.h"
 #include "dds/ddsi/ddsi_entity.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_tkmap.h"
 #include "ddsi__whc.h"
 #include "dds__entity.h"
+#include "dds__whc.h"
 
 #include "test_common.h"
 
@@ -300,3 +304,223 @@ CU_Test(ddsc_whc, check_end_state, .init=whc_init, .fini=whc_fini, .timeout=30)
 #undef BE
 #undef KA
 #undef KL
+
+static void check_whc_equal (const struct ddsi_whc *a, const struct ddsi_whc *b)
+{
+  struct ddsi_whc_state sta, stb;
+  ddsi_whc_get_state (a, &sta);
+  ddsi_whc_get_state (b, &stb);
+  CU_ASSERT_FATAL (sta.min_seq == stb.min_seq);
+  CU_ASSERT_FATAL (sta.max_seq == stb.max_seq);
+  CU_ASSERT_FATAL (sta.unacked_bytes == stb.unacked_bytes);
+
+  struct ddsi_whc_sample_iter ita, itb;
+  struct ddsi_whc_borrowed_sample sa, sb;
+  bool va, vb;
+  ddsi_whc_sample_iter_init (a, &ita);
+  ddsi_whc_sample_iter_init (b, &itb);
+  do {
+    va = ddsi_whc_sample_iter_borrow_next (&ita, &sa);
+    vb = ddsi_whc_sample_iter_borrow_next (&itb, &sb);
+    CU_ASSERT_FATAL (va == vb);
+    if (va)
+    {
+      CU_ASSERT_FATAL (sa.seq == sb.seq);
+      CU_ASSERT_FATAL (sa.serdata == sb.serdata);
+      CU_ASSERT_FATAL (sa.unacked == sb.unacked);
+      CU_ASSERT_FATAL (ddsi_whc_next_seq (a, sa.seq - 1) == sa.seq);
+      CU_ASSERT_FATAL (ddsi_whc_next_seq (b, sb.seq - 1) == sb.seq);
+    }
+  } while (va);
+}
+
+static void whc_insert_both (struct ddsi_whc *whcs[2], struct ddsi_domaingv *gv, ddsi_seqno_t max_drop_seq, ddsi_seqno_t seq, struct ddsi_serdata *sd)
+{
+  struct ddsi_tkmap_instance *tk = ddsi_tkmap_lookup_instance_ref (gv->m_tkmap, sd);
+  for (int i = 0; i < 2; i++)
+  {
+    int ret = ddsi_whc_insert (whcs[i], max_drop_seq, seq, DDSRT_MTIME_NEVER, sd, tk);
+    CU_ASSERT_FATAL (ret == 0);
+  }
+  ddsi_tkmap_instance_unref (gv->m_tkmap, tk);
+  ddsi_serdata_unref (sd);
+}
+
+/* The WHC used for writers of keyless volatile topics must behave the same as the
+   default one does in that case */
+CU_Test(ddsc_whc, ring_vs_default, .init=whc_init, .fini=whc_fini, .timeout=30)
+{
+  char name[100];
+  create_unique_topic_name ("ddsc_whc_ring_vs_default", name, sizeof name);
+  dds_entity_t topic = dds_create_topic (g_participant, &Space_Type3_desc, name, NULL, NULL);
+  CU_ASSERT_FATAL (topic > 0);
+  const struct ddsi_sertype *st;
+  dds_return_t ret = dds_get_entity_sertype (topic, &st);
+  CU_ASSERT_FATAL (ret == DDS_RETCODE_OK);
+
+  const int32_t depths[] = { 0, 1, 3 };
+  for (size_t d = 0; d < sizeof (depths) / sizeof (depths[0]); d++)
+  {
+    dds_qset_durability (g_qos, DDS_DURABILITY_VOLATILE);
+    dds_qset_reliability (g_qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+    dds_qset_history (g_qos, depths[d] == 0 ? DDS_HISTORY_KEEP_ALL : DDS_HISTORY_KEEP_LAST, depths[d]);
+    dds_qset_deadline (g_qos, DDS_INFINITY);
+    dds_entity_t writer = dds_create_writer (g_publisher, topic, g_qos, NULL);
+    CU_ASSERT_FATAL (writer > 0);
+
+    struct dds_entity *x;
+    ret = dds_entity_pin (writer, &x);
+    CU_ASSERT_FATAL (ret == 0);
+    struct ddsi_domaingv * const gv = &x->m_domain->gv;
+    struct whc_writer_info *wrinfo = dds_whc_make_wrinfo ((struct dds_writer *) x, x->m_qos);
+    struct ddsi_whc *whcs[2] = { dds_whc_new (gv, wrinfo), dds_whc_default_new (gv, wrinfo) };
+    dds_whc_free_wrinfo (wrinfo);
+    // the writer itself must use the specialized one
+    CU_ASSERT_FATAL (whcs[0]->ops != whcs[1]->ops);
+    CU_ASSERT_FATAL (((struct dds_writer *) x)->m_whc->ops == whcs[0]->ops);
+
+    ddsi_thread_state_awake (ddsi_lookup_thread_state (), gv);
+    ddsrt_prng_t prng;
+    ddsrt_prng_init_simple (&prng, (uint32_t) d + 1);
+    ddsi_seqno_t seq = 0, max_drop_seq = 0;
+    for (int iter = 0; iter < 5000; iter++)
+    {
+      const uint32_t r = ddsrt_prng_random (&prng) % 100;
+      struct ddsi_whc_state whcst;
+      ddsi_whc_get_state (whcs[0], &whcst);
+      if (r < 50)
+      {
+        // gaps in sequence numbers occur when there are no reliable readers, in which case
+        // the WHC is empty
+        seq += 1 + ((whcst.max_seq == 0 && r < 5) ? ddsrt_prng_random (&prng) % 10 : 0);
+        Space_Type3 sample = { (int32_t) seq, 0, 0 };
+        whc_insert_both (whcs, gv, max_drop_seq, seq, ddsi_serdata_from_sample (st, SDK_DATA, &sample));
+      }
+      else if (r < 55)
+      {
+        Space_Type3 sample = { 0, 0, 0 };
+        struct ddsi_serdata *sd = ddsi_serdata_from_sample (st, SDK_KEY, &sample);
+        sd->statusinfo = DDSI_STATUSINFO_UNREGISTER;
+        whc_insert_both (whcs, gv, max_drop_seq, ++seq, sd);
+      }
+      else if (r < 80)
+      {
+        if (seq > max_drop_seq)
+          max_drop_seq += 1 + ddsrt_prng_random (&prng) % (uint32_t) (seq - max_drop_seq);
+        struct ddsi_whc_node *dfl[2];
+        struct ddsi_whc_state st2[2];
+        for (int i = 0; i < 2; i++)
+        {
+          (void) ddsi_whc_remove_acked_messages (whcs[i], max_drop_seq, &st2[i], &dfl[i]);
+          ddsi_whc_free_deferred_free_list (whcs[i], dfl[i]);
+        }
+        CU_ASSERT_FATAL (st2[0].min_seq == st2[1].min_seq && st2[0].max_seq == st2[1].max_seq);
+      }
+      else if (r < 95)
+      {
+        const ddsi_seqno_t s = (seq == 0) ? 0 : 1 + ddsrt_prng_random (&prng) % (uint32_t) seq;
+        struct ddsi_whc_borrowed_sample bs[2];
+        bool found[2];
+        for (int i = 0; i < 2; i++)
+          found[i] = ddsi_whc_borrow_sample (whcs[i], s, &bs[i]);
+        CU_ASSERT_FATAL (found[0] == found[1]);
+        if (found[0])
+        {
+          CU_ASSERT_FATAL (bs[0].serdata == bs[1].serdata && bs[0].unacked == bs[1].unacked);
+          // retransmit info must be retained
+          CU_ASSERT_FATAL (bs[0].rexmit_count == bs[1].rexmit_count);
+          for (int i = 0; i < 2; i++)
+          {
+            bs[i].rexmit_count++;
+            ddsi_whc_return_sample (whcs[i], &bs[i], true);
+          }
+        }
+      }
+      else if (depths[d] > 0)
+      {
+        // the default WHC has no history to look up the latest sample in for KEEP_ALL
+        Space_Type3 sample = { 0, 0, 0 };
+        struct ddsi_serdata *sd = ddsi_serdata_from_sample (st, SDK_KEY, &sample);
+        struct ddsi_whc_borrowed_sample bs[2];
+        bool found[2];
+        for (int i = 0; i < 2; i++)
+          found[i] = ddsi_whc_borrow_sample_key (whcs[i], sd, &bs[i]);
+        CU_ASSERT_FATAL (found[0] == found[1]);
+        if (found[0])
+        {
+          CU_ASSERT_FATAL (bs[0].seq == bs[1].seq);
+          for (int i = 0; i < 2; i++)
+            ddsi_whc_return_sample (whcs[i], &bs[i], false);
+        }
+        ddsi_serdata_unref (sd);
+      }
+      check_whc_equal (whcs[0], whcs[1]);
+    }
+    ddsi_whc_free (whcs[0]);
+    ddsi_whc_free (whcs[1]);
+    ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+
+    dds_entity_unpin (x);
+    dds_delete (writer);
+  }
+  dds_delete (topic);
+}
+
+/* Reducing the lifespan of a writer can make a later sample expire before an earlier
+   one, expired samples must never be available for retransmitting */
+CU_Test(ddsc_whc, ring_lifespan_reduced, .init=whc_init, .fini=whc_fini, .timeout=30)
+{
+  char name[100];
+  create_unique_topic_name ("ddsc_whc_ring_lifespan_reduced", name, sizeof name);
+  dds_entity_t topic = dds_create_topic (g_participant, &Space_Type3_desc, name, NULL, NULL);
+  CU_ASSERT_FATAL (topic > 0);
+  const struct ddsi_sertype *st;
+  dds_return_t ret = dds_get_entity_sertype (topic, &st);
+  CU_ASSERT_FATAL (ret == DDS_RETCODE_OK);
+  dds_entity_t writer = dds_create_writer (g_publisher, topic, NULL, NULL);
+  CU_ASSERT_FATAL (writer > 0);
+  struct dds_entity *x;
+  ret = dds_entity_pin (writer, &x);
+  CU_ASSERT_FATAL (ret == 0);
+  struct ddsi_domaingv * const gv = &x->m_domain->gv;
+  struct ddsi_whc *whc = dds_whc_ring_new (gv, 0);
+
+  ddsi_thread_state_awake (ddsi_lookup_thread_state (), gv);
+  const ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+  const ddsrt_mtime_t exps[] = { ddsrt_mtime_add_duration (tnow, DDS_SECS (100)), tnow, ddsrt_mtime_add_duration (tnow, DDS_SECS (100)) };
+  for (ddsi_seqno_t seq = 1; seq <= 3; seq++)
+  {
+    Space_Type3 sample = { (int32_t) seq, 0, 0 };
+    struct ddsi_serdata *sd = ddsi_serdata_from_sample (st, SDK_DATA, &sample);
+    struct ddsi_tkmap_instance *tk = ddsi_tkmap_lookup_instance_ref (gv->m_tkmap, sd);
+    ret = ddsi_whc_insert (whc, 0, seq, exps[seq - 1], sd, tk);
+    CU_ASSERT_FATAL (ret == 0);
+    ddsi_tkmap_instance_unref (gv->m_tkmap, tk);
+    ddsi_serdata_unref (sd);
+  }
+
+  // the expired one sits between unexpired ones
+  struct ddsi_whc_borrowed_sample bs;
+  CU_ASSERT_FATAL (!ddsi_whc_borrow_sample (whc, 2, &bs));
+  for (ddsi_seqno_t seq = 1; seq <= 3; seq += 2)
+  {
+    CU_ASSERT_FATAL (ddsi_whc_borrow_sample (whc, seq, &bs));
+    ddsi_whc_return_sample (whc, &bs, false);
+  }
+  struct ddsi_whc_sample_iter it;
+  ddsi_seqno_t seen = 0;
+  ddsi_whc_sample_iter_init (whc, &it);
+  while (ddsi_whc_sample_iter_borrow_next (&it, &bs))
+  {
+    CU_ASSERT_FATAL (bs.seq != 2);
+    seen++;
+  }
+  CU_ASSERT_FATAL (seen == 2);
+  CU_ASSERT_FATAL (ddsi_whc_next_seq (whc, 1) == 3);
+
+  ddsi_whc_free (whc);
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+  dds_entity_unpin (x);
+  dds_delete (writer);
+  dds_delete (topic);
+}
@@ -321,6 +321,45 @@ CU_Test(ddsc_write, batch_flush)
   }
 }
 
+CU_Test(ddsc_write, batch_scope)
+{
+  static const struct { const char *begin; const char *end; } x[] = {
+    { "batch", "endbatch" },
+    // nothing goes out until the outermost batch ends
+    { "batch batch", "endbatch sleep 0.2 take{} r' endbatch" },
+  };
+  for (size_t i = 0; i < sizeof (x) / sizeof (x[0]); i++)
+  {
+    char *prog = NULL;
+    // same setup as batch_flush, but with writers that don't batch themselves
+    ddsrt_asprintf (&prog,
+      "pm w(r=r) "
+      "sm da r(r=r) "
+      "?pm w "
+      "sm da r'(r=r) "
+      "?pm w ?sm r' "
+      "pm x(r=r) "
+      "?sm r' ?ack w ?ack x "
+      "setflags(s) w setflags(s) x "
+      // writes from both writers are held back until the end of the batch,
+      // local delivery is not affected
+      "%s "
+      "  wr w 0 wr x 1 "
+      "  take{(0,0,0),(1,0,0)} r "
+      "  sleep 0.2 take{} r' "
+      "%s "
+      "  take{} r "
+      "  take!{(0,0,0),(1,0,0)} r' "
+      // without a batch, writes go out immediately
+      "wr w 2 take!{(2,0,0)} r'",
+      x[i].begin, x[i].end);
+    int result = test_oneliner_no_shm (prog);
+    ddsrt_free (prog);
+    CU_ASSERT_FATAL (result > 0);
+  }
+  CU_ASSERT_EQUAL (dds_end_batch (), DDS_RETCODE_PRECONDITION_NOT_MET);
+}
+
 CU_Test(ddsc_write, async_one_unrel_sample)
 {
   // Avoid shared memory because we need the debugging tricks in DDSI
@@ -0,0 +1,179 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_entity_index.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "dds/ddsi/ddsi_proxy_endpoint.h"
+#include "ddsi__xevent.h"
+#include "dds__entity.h"
+#include "dds__types.h"
+
+#include "test_common.h"
+#include "Space.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_XEVQS "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Internal><TimedEventThreads>4</TimedEventThreads></Internal>"
+
+#define NWRITERS 8
+#define NSAMPLES 100
+
+// sync_reader_writer only really waits for the first writer because the reader's
+// subscription matched status remains set
+static void wait_for_all_matched (dds_entity_t rd, const dds_entity_t wr[NWRITERS])
+{
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  dds_subscription_matched_status_t st;
+  dds_return_t rc;
+  while ((rc = dds_get_subscription_matched_status (rd, &st)) == DDS_RETCODE_OK && st.current_count < NWRITERS && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && st.current_count == NWRITERS);
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    dds_publication_matched_status_t pst;
+    while ((rc = dds_get_publication_matched_status (wr[i], &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tend)
+      dds_sleepfor (DDS_MSECS (10));
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+  }
+}
+
+static bool is_endpoint_xeventq (const struct ddsi_domaingv *gv, const struct ddsi_xeventq *evq)
+{
+  for (uint32_t i = 0; i < gv->n_endpoint_xevents; i++)
+    if (gv->endpoint_xevents[i] == evq)
+      return true;
+  return false;
+}
+
+CU_Test (ddsc_xevent_queues, per_writer_queue, .timeout = 30)
+{
+  char *conf_pub = ddsrt_expand_envvars (DDS_CONFIG_XEVQS, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_XEVQS, DDS_DOMAINID_SUB);
+  const dds_entity_t dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  const dds_entity_t dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  dds_free (conf_pub);
+  dds_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_xevent_queues", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &Space_Type1_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_entity_t wr[NWRITERS];
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    wr[i] = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+    CU_ASSERT_FATAL (wr[i] > 0);
+    sync_reader_writer (pp_sub, rd, pp_pub, wr[i]);
+  }
+  dds_delete_qos (qos);
+  wait_for_all_matched (rd, wr);
+
+  // writers and the corresponding proxy writers must be bound to the queue that
+  // belongs to their GUID, built-in writers are always on the main queue
+  struct dds_entity *x_rd;
+  dds_return_t rc = dds_entity_pin (rd, &x_rd);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  struct ddsi_domaingv * const gv_sub = &x_rd->m_domain->gv;
+  CU_ASSERT_FATAL (gv_sub->n_endpoint_xevents == 4);
+  ddsi_thread_state_awake (ddsi_lookup_thread_state (), gv_sub);
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    struct dds_entity *x;
+    rc = dds_entity_pin (wr[i], &x);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+    struct ddsi_domaingv * const gv_pub = &x->m_domain->gv;
+    const struct ddsi_writer *ddsi_wr = ((struct dds_writer *) x)->m_wr;
+    CU_ASSERT_FATAL (ddsi_wr->evq == ddsi_xeventq_for_endpoint (gv_pub, &x->m_guid));
+    CU_ASSERT_FATAL (is_endpoint_xeventq (gv_pub, ddsi_wr->evq));
+    const struct ddsi_proxy_writer *pwr = ddsi_entidx_lookup_proxy_writer_guid (gv_sub->entity_index, &x->m_guid);
+    CU_ASSERT_FATAL (pwr != NULL);
+    CU_ASSERT_FATAL (pwr->evq == ddsi_xeventq_for_endpoint (gv_sub, &x->m_guid));
+    CU_ASSERT_FATAL (is_endpoint_xeventq (gv_sub, pwr->evq));
+    dds_entity_unpin (x);
+  }
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+  dds_entity_unpin (x_rd);
+
+  // heartbeats and acknacks of the writers are handled by different threads,
+  // but the reliable protocol must still complete for all of them
+  for (int32_t s = 0; s < NSAMPLES; s++)
+  {
+    for (int i = 0; i < NWRITERS; i++)
+    {
+      const Space_Type1 sample = { .long_1 = i, .long_2 = s, .long_3 = 0 };
+      rc = dds_write (wr[i], &sample);
+      CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+    }
+  }
+  for (int i = 0; i < NWRITERS; i++)
+  {
+    rc = dds_wait_for_acks (wr[i], DDS_SECS (10));
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+
+  int32_t next[NWRITERS] = { 0 };
+  int nreceived = 0;
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (nreceived < NWRITERS * NSAMPLES && dds_time () < tend)
+  {
+    void *raw[10] = { NULL };
+    dds_sample_info_t si[10];
+    const int32_t n = dds_take (rd, raw, si, 10, 10);
+    CU_ASSERT_FATAL (n >= 0);
+    for (int32_t j = 0; j < n; j++)
+    {
+      const Space_Type1 *sample = raw[j];
+      CU_ASSERT_FATAL (si[j].valid_data);
+      CU_ASSERT_FATAL (sample->long_1 >= 0 && sample->long_1 < NWRITERS);
+      CU_ASSERT_FATAL (sample->long_2 == next[sample->long_1]);
+      next[sample->long_1]++;
+      nreceived++;
+    }
+    (void) dds_return_loan (rd, raw, n);
+    if (n == 0)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  CU_ASSERT (nreceived == NWRITERS * NSAMPLES);
+
+  dds_delete (dom_sub);
+  dds_delete (dom_pub);
+}
+
+CU_Test (ddsc_xevent_queues, thread_count_range)
+{
+  const char *configs[] = {
+    "<Internal><TimedEventThreads>0</TimedEventThreads></Internal>",
+    "<Internal><TimedEventThreads>65</TimedEventThreads></Internal>",
+    "<Internal><TimedEventThreads>4294967295</TimedEventThreads></Internal>",
+    NULL
+  };
+  for (int i = 0; configs[i]; i++)
+    CU_ASSERT_FATAL (dds_create_domain (DDS_DOMAINID_SUB, configs[i]) < 0);
+}
@@ -0,0 +1,189 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/io.h"
+#include "dds/ddsrt/process.h"
+#include "dds/ddsrt/sync.h"
+
+#include "test_common.h"
+#include "RoundTrip.h"
+
+#define DDS_DOMAINID_PUB 0
+#define DDS_DOMAINID_SUB 1
+#define DDS_CONFIG_XMIT_BATCH_PUB(extra) "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Internal><TransmitBatchSize>16</TransmitBatchSize></Internal><Tracing><Category>trace</Category>" extra "</Tracing>"
+#define DDS_CONFIG_XMIT_BATCH_SUB "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery>"
+
+#define SAMPLE_SIZE 100000
+#define NSAMPLES 20
+
+struct logger_arg {
+  ddsrt_mutex_t lock;
+  uint32_t max_train; // largest number of packets sent in one batch
+};
+
+static void logger (void *ptr, const dds_log_data_t *data)
+{
+  struct logger_arg * const arg = ptr;
+  const char *s;
+  unsigned npkts;
+  if (data->domid != DDS_DOMAINID_PUB || (s = strstr (data->message, "ddsi_xpack_send ")) == NULL)
+    return;
+  if (sscanf (s, "ddsi_xpack_send %u packets:", &npkts) == 1)
+  {
+    ddsrt_mutex_lock (&arg->lock);
+    if (npkts > arg->max_train)
+      arg->max_train = npkts;
+    ddsrt_mutex_unlock (&arg->lock);
+  }
+}
+
+static uint32_t write_and_take (const char *config_pub)
+{
+  struct logger_arg larg = { .max_train = 0 };
+  ddsrt_mutex_init (&larg.lock);
+  dds_set_trace_sink (&logger, &larg);
+
+  char *conf_pub = ddsrt_expand_envvars (config_pub, DDS_DOMAINID_PUB);
+  char *conf_sub = ddsrt_expand_envvars (DDS_CONFIG_XMIT_BATCH_SUB, DDS_DOMAINID_SUB);
+  const dds_entity_t dom_pub = dds_create_domain (DDS_DOMAINID_PUB, conf_pub);
+  CU_ASSERT_FATAL (dom_pub > 0);
+  const dds_entity_t dom_sub = dds_create_domain (DDS_DOMAINID_SUB, conf_sub);
+  CU_ASSERT_FATAL (dom_sub > 0);
+  ddsrt_free (conf_pub);
+  ddsrt_free (conf_sub);
+
+  const dds_entity_t pp_pub = dds_create_participant (DDS_DOMAINID_PUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_pub > 0);
+  const dds_entity_t pp_sub = dds_create_participant (DDS_DOMAINID_SUB, NULL, NULL);
+  CU_ASSERT_FATAL (pp_sub > 0);
+
+  char topicname[100];
+  create_unique_topic_name ("ddsc_xmit_batch", topicname, sizeof (topicname));
+  const dds_entity_t tp_pub = dds_create_topic (pp_pub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_pub > 0);
+  const dds_entity_t tp_sub = dds_create_topic (pp_sub, &RoundTripModule_DataType_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp_sub > 0);
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (10));
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t rd = dds_create_reader (pp_sub, tp_sub, qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp_pub, tp_pub, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  const dds_time_t tmatch = dds_time () + DDS_SECS (10);
+  dds_publication_matched_status_t pst;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pst)) == DDS_RETCODE_OK && pst.current_count < 1 && dds_time () < tmatch)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK && pst.current_count == 1);
+
+  // large samples are sent as many equal-sized packets, which get batched
+  RoundTripModule_DataType sample;
+  sample.payload._length = sample.payload._maximum = SAMPLE_SIZE;
+  sample.payload._buffer = ddsrt_malloc (SAMPLE_SIZE);
+  sample.payload._release = false;
+  for (int32_t s = 0; s < NSAMPLES; s++)
+  {
+    memset (sample.payload._buffer, (unsigned char) s, SAMPLE_SIZE);
+    rc = dds_write (wr, &sample);
+    CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  }
+  rc = dds_wait_for_acks (wr, DDS_SECS (10));
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+
+  int32_t ntaken = 0, n = 0;
+  void *raw[1] = { NULL };
+  dds_sample_info_t si;
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (ntaken < NSAMPLES && dds_time () < tend && (n = dds_take (rd, raw, &si, 1, 1)) >= 0)
+  {
+    if (n == 0)
+    {
+      dds_sleepfor (DDS_MSECS (10));
+      continue;
+    }
+    const RoundTripModule_DataType *rs = raw[0];
+    CU_ASSERT_FATAL (rs->payload._length == SAMPLE_SIZE);
+    memset (sample.payload._buffer, (unsigned char) ntaken, SAMPLE_SIZE);
+    CU_ASSERT_FATAL (memcmp (rs->payload._buffer, sample.payload._buffer, SAMPLE_SIZE) == 0);
+    (void) dds_return_loan (rd, raw, n);
+    ntaken++;
+  }
+  CU_ASSERT_FATAL (ntaken == NSAMPLES);
+  ddsrt_free (sample.payload._buffer);
+
+  rc = dds_delete (dom_sub);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  rc = dds_delete (dom_pub);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  dds_set_trace_sink (NULL, NULL);
+  ddsrt_mutex_destroy (&larg.lock);
+  return larg.max_train;
+}
+
+CU_Test (ddsc_xmit_batch, basic, .timeout = 30)
+{
+  const uint32_t max_train = write_and_take (DDS_CONFIG_XMIT_BATCH_PUB (""));
+  CU_ASSERT (max_train > 1);
+}
+
+static uint16_t be16 (const unsigned char *p)
+{
+  return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+CU_Test (ddsc_xmit_batch, pcap, .timeout = 30)
+{
+  // packets sent in a batch must each be written to the capture file
+  char pcapfile[64], *config;
+  (void) snprintf (pcapfile, sizeof (pcapfile), "ddsc_xmit_batch_%"PRIdPID".pcap", ddsrt_getpid ());
+  (void) ddsrt_asprintf (&config, DDS_CONFIG_XMIT_BATCH_PUB ("<PacketCaptureFile>%s</PacketCaptureFile>"), pcapfile);
+  const uint32_t max_train = write_and_take (config);
+  ddsrt_free (config);
+  CU_ASSERT (max_train > 1);
+
+  FILE *fp = fopen (pcapfile, "rb");
+  CU_ASSERT_FATAL (fp != NULL);
+  unsigned char filehdr[24];
+  CU_ASSERT_FATAL (fread (filehdr, sizeof (filehdr), 1, fp) == 1);
+  uint32_t magic, incl_len;
+  memcpy (&magic, filehdr, sizeof (magic));
+  CU_ASSERT_FATAL (magic == 0xa1b2c3d4);
+  unsigned char rechdr[16], pkt[70000];
+  size_t nsent = 0, sent_bytes = 0;
+  while (fread (rechdr, sizeof (rechdr), 1, fp) == 1)
+  {
+    memcpy (&incl_len, rechdr + 8, sizeof (incl_len));
+    CU_ASSERT_FATAL (incl_len >= 28 && incl_len <= sizeof (pkt));
+    CU_ASSERT_FATAL (fread (pkt, incl_len, 1, fp) == 1);
+    // IPv4 header (20 bytes), UDP header (8 bytes), RTPS message; TTL 255 means sent
+    CU_ASSERT_FATAL (be16 (pkt + 2) == incl_len);
+    CU_ASSERT_FATAL (be16 (pkt + 24) == incl_len - 20);
+    if (pkt[8] == 255)
+    {
+      CU_ASSERT_FATAL (memcmp (pkt + 28, "RTPS", 4) == 0);
+      nsent++;
+      sent_bytes += incl_len - 28;
+    }
+  }
+  fclose (fp);
+  (void) remove (pcapfile);
+  CU_ASSERT (nsent > (size_t) max_train);
+  CU_ASSERT (sent_bytes > NSAMPLES * SAMPLE_SIZE);
+}
@@ -47,13 +47,20 @@ void ddsi_config_init_default (struct ddsi_config *cfg)
   cfg->lease_duration = INT64_C (10000000000);
   cfg->tracefile = "cyclonedds.log";
   cfg->pcap_file = "";
+  cfg->compression_codec = "";
+  cfg->compression_library = "";
+  cfg->compression_config = "";
+  cfg->compression_threshold = UINT32_C (1024);
   cfg->delivery_queue_maxsamples = UINT32_C (256);
+  cfg->delivery_queue_threads = UINT32_C (1);
+  cfg->timed_event_threads = UINT32_C (1);
   cfg->primary_reorder_maxsamples = UINT32_C (128);
   cfg->secondary_reorder_maxsamples = UINT32_C (128);
   cfg->defrag_unreliable_maxsamples = UINT32_C (4);
   cfg->defrag_reliable_maxsamples = UINT32_C (16);
   cfg->besmode = INT32_C (1);
   cfg->synchronous_delivery_latency_bound = INT64_C (9223372036854775807);
+  cfg->rhc_shards = UINT32_C (1);
   cfg->retransmit_merging_period = INT64_C (5000000);
   cfg->const_hb_intv_sched = INT64_C (100000000);
   cfg->const_hb_intv_min = INT64_C (5000000);
@@ -62,6 +69,7 @@ void ddsi_config_init_default (struct ddsi_config *cfg)
   cfg->max_queued_rexmit_bytes = UINT32_C (524288);
   cfg->max_queued_rexmit_msgs = UINT32_C (200);
   cfg->writer_linger_duration = INT64_C (1000000000);
+  cfg->writer_addrset_recompute_delay = INT64_C (100000000);
   cfg->socket_rcvbuf_size.min.isdefault = 1;
   cfg->socket_rcvbuf_size.max.isdefault = 1;
   cfg->socket_sndbuf_size.min.isdefault = 0;
@@ -77,11 +85,18 @@ void ddsi_config_init_default (struct ddsi_config *cfg)
   cfg->monitor_port = INT32_C (-1);
   cfg->prioritize_retransmit = INT32_C (1);
   cfg->recv_thread_stop_maxretries = UINT32_C (4294967295);
+  cfg->n_recv_threads_uc = UINT32_C (1);
+  cfg->recv_batch_size = UINT32_C (1);
+  cfg->xmit_batch_size = UINT32_C (1);
   cfg->whc_lowwater_mark = UINT32_C (1024);
   cfg->whc_highwater_mark = UINT32_C (512000);
   cfg->whc_init_highwater_mark.isdefault = 0;
   cfg->whc_init_highwater_mark.value = UINT32_C (30720);
   cfg->whc_adaptive = INT32_C (1);
+  cfg->pacing_min_rate = UINT32_C (65536);
+  cfg->pacing_increase = UINT32_C (65536);
+  cfg->pacing_burst_size = UINT32_C (65536);
+  cfg->pacing_rtt = INT64_C (10000000);
   cfg->max_rexmit_burst_size = UINT32_C (1048576);
   cfg->init_transmit_extra_pct = UINT32_C (4294967295);
   cfg->max_frags_in_rexmit_of_sample = UINT32_C (1);
@@ -101,10 +116,10 @@ void ddsi_config_init_default (struct ddsi_config *cfg)
   cfg->ssl_min_version.minor = 3;
 #endif /* DDS_HAS_TCP_TLS */
 }
-/* generated from ddsi_config.h[dbf9996a8b49da8e7cb4b62ab157ba80a073cd81] */
+/* generated from ddsi_config.h[f0551d3801118aa53a6dc312fedf4b9ad3be29d4] */
 /* generated from ddsi__cfgunits.h[bd22f0c0ed210501d0ecd3b07c992eca549ef5aa] */
-/* generated from ddsi__cfgelems.h[a8b3ad5170f4e86fd7c1f29c5677c332930ea6a4] */
-/* generated from ddsi_config.c[94a98ea7709bca260c9cfb5cf43396b0d5e3c953] */
+/* generated from ddsi__cfgelems.h[722f6c3de246adab3b0e726489c8ca68743e74d5] */
+/* generated from ddsi_config.c[61790f1a97126d00f3cf9d660baf5ca9bd31ef2d] */
 /* generated from _confgen.h[9554f1d72645c0b8bb66ffbfbc3c0fb664fc1a43] */
 /* generated from _confgen.c[86c631048046ed4e14c46dba40e5253b50a748fe] */
 /* generated from generate_rnc.c[b50e4b7ab1d04b2bc1d361a0811247c337b74934] */
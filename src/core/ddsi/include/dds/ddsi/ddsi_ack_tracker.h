@@ -0,0 +1,40 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI_ACK_TRACKER_H
+#define DDSI_ACK_TRACKER_H
+
+#include <stdint.h>
+#include "dds/features.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_ack_group;
+
+/// @brief Acknowledgement state of the matched proxy readers of a writer (protected by the writer lock)
+///
+/// The readers are grouped by the sequence number they acknowledged, the groups are kept in
+/// a list sorted by sequence number. Readers tend to acknowledge the same sequence numbers,
+/// so there are few groups and moving a reader from one group to another is cheap, while the
+/// minimum and maximum acknowledged sequence numbers are available in constant time.
+struct ddsi_ack_tracker {
+  struct ddsi_ack_group *head;  ///< Group with the lowest sequence number
+  struct ddsi_ack_group *tail;  ///< Group with the highest sequence number
+  struct ddsi_ack_group *freelist; ///< Unused groups for reuse
+  uint32_t n_not_replied;       ///< Number of readers that have not replied to a heartbeat
+};
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI_ACK_TRACKER_H */
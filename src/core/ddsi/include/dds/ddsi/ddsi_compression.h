@@ -0,0 +1,97 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI_COMPRESSION_H
+#define DDSI_COMPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dds/ddsrt/retcode.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/** @brief Identifier of the built-in codec, plugins must use a different one */
+#define DDSI_COMPRESSION_CODEC_LZ 1u
+
+/** @brief Largest codec identifier, identifiers are advertised in discovery as a 32-bit mask */
+#define DDSI_COMPRESSION_CODEC_ID_MAX 31u
+
+struct ddsi_compression_codec;
+
+/**
+ * @brief Worst-case size of the compressed representation of `size` bytes
+ *
+ * @param[in] codec  the codec
+ * @param[in] size   size of the input
+ * @returns the size of the output buffer that @ref ddsi_compression_compress_fn_t requires
+ */
+typedef size_t (*ddsi_compression_bound_fn_t) (const struct ddsi_compression_codec *codec, size_t size);
+
+/**
+ * @brief Compress a buffer
+ *
+ * @param[in] codec  the codec
+ * @param[out] dst   output buffer of at least bound(srcsize) bytes
+ * @param[in] src    input
+ * @param[in] srcsize size of the input
+ * @returns the size of the compressed data, 0 if it could not be compressed
+ */
+typedef size_t (*ddsi_compression_compress_fn_t) (const struct ddsi_compression_codec *codec, void *dst, const void *src, size_t srcsize);
+
+/**
+ * @brief Decompress a buffer
+ *
+ * The input is received from the network and must therefore be treated as untrusted.
+ *
+ * @param[in] codec  the codec
+ * @param[out] dst   output buffer
+ * @param[in] dstsize size of the output, i.e., the original size of the data
+ * @param[in] src    compressed data
+ * @param[in] srcsize size of the compressed data
+ * @returns true iff the input decompressed to exactly `dstsize` bytes
+ */
+typedef bool (*ddsi_compression_decompress_fn_t) (const struct ddsi_compression_codec *codec, void *dst, size_t dstsize, const void *src, size_t srcsize);
+
+/** @brief Release all resources held by the codec, including the codec itself */
+typedef void (*ddsi_compression_fini_fn_t) (struct ddsi_compression_codec *codec);
+
+/**
+ * @brief Interface implemented by a compression codec
+ *
+ * The built-in codec implements this interface, a plugin library provides one by exporting
+ * a function `<codec name>_create_compression_codec` of type @ref ddsi_compression_create_fn.
+ * The functions may be called concurrently from multiple threads.
+ */
+struct ddsi_compression_codec {
+  uint32_t id;                  ///< Identifier in the payload and discovery, at most @ref DDSI_COMPRESSION_CODEC_ID_MAX
+  const char *name;             ///< Name of the codec
+  ddsi_compression_bound_fn_t bound;
+  ddsi_compression_compress_fn_t compress;
+  ddsi_compression_decompress_fn_t decompress;
+  ddsi_compression_fini_fn_t fini;
+};
+
+/**
+ * @brief Function a codec plugin library exports for creating a codec
+ *
+ * @param[out] codec  the new codec
+ * @param[in] config  configuration string from Compression/Config
+ * @returns DDS_RETCODE_OK on success, an error code otherwise
+ */
+typedef dds_return_t (*ddsi_compression_create_fn) (struct ddsi_compression_codec **codec, const char *config);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI_COMPRESSION_H */
@@ -322,11 +322,16 @@ struct ddsi_config
   int prioritize_retransmit;
   enum ddsi_boolean_default multiple_recv_threads;
   unsigned recv_thread_stop_maxretries;
+  uint32_t n_recv_threads_uc;
+  uint32_t recv_batch_size;
+  uint32_t xmit_batch_size;
 
   unsigned primary_reorder_maxsamples;
   unsigned secondary_reorder_maxsamples;
 
   unsigned delivery_queue_maxsamples;
+  uint32_t delivery_queue_threads;
+  uint32_t timed_event_threads;
 
   uint16_t fragment_size;
   uint32_t max_msg_size;
@@ -376,10 +381,12 @@ struct ddsi_config
   int xmit_lossiness;           /**<< fraction of packets to drop on xmit, in units of 1e-3 */
   uint32_t rmsg_chunk_size;          /**<< size of a chunk in the receive buffer */
   uint32_t rbuf_size;                /* << size of a single receiver buffer */
+  uint32_t rbuf_slabs;               /* << max. cached slabs per receive thread, 0 = use receive buffers */
   enum ddsi_besmode besmode;
   int meas_hb_to_ack_latency;
   int synchronous_delivery_priority_threshold;
   int64_t synchronous_delivery_latency_bound;
+  uint32_t rhc_shards;
 
   /* Write cache */
 
@@ -389,12 +396,20 @@ struct ddsi_config
   struct ddsi_config_maybe_uint32 whc_init_highwater_mark;
   int whc_adaptive;
 
+  uint32_t pacing_max_rate;
+  uint32_t pacing_min_rate;
+  uint32_t pacing_increase;
+  uint32_t pacing_burst_size;
+  int64_t pacing_rtt;
+
   unsigned defrag_unreliable_maxsamples;
   unsigned defrag_reliable_maxsamples;
+  uint32_t fragment_parity_group_size;
   unsigned accelerate_rexmit_block_size;
   int64_t responsiveness_timeout;
   uint32_t max_participants;
   int64_t writer_linger_duration;
+  int64_t writer_addrset_recompute_delay;
   int multicast_ttl;
   struct ddsi_config_socket_buf_size socket_rcvbuf_size;
   struct ddsi_config_socket_buf_size socket_sndbuf_size;
@@ -411,6 +426,12 @@ struct ddsi_config
   uint32_t max_sample_size;
   int extended_packet_info;
 
+  /* payload compression */
+  char *compression_codec;
+  char *compression_library;
+  char *compression_config;
+  uint32_t compression_threshold;
+
   /* compability options */
   enum ddsi_standards_conformance standards_conformance;
   int explicitly_publish_qos_set_to_default;
@@ -0,0 +1,56 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI_CONTENT_FILTER_IF_H
+#define DDSI_CONTENT_FILTER_IF_H
+
+#include <stdbool.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_sertype;
+struct ddsi_serdata;
+struct ddsi_content_filter_property;
+
+/* Interface for evaluating the content filters advertised by remote readers on the writer
+   side.  The DDSI layer itself has no way of interpreting filter expressions, so these
+   are provided by the layer above it. */
+struct ddsi_content_filter_interface {
+  void *arg;
+
+  /* returns a filter for samples of "type", or NULL if the filter can't be evaluated
+     by the writer (in which case it sends everything) */
+  void * (*compile) (const struct ddsi_sertype *type, const struct ddsi_content_filter_property *cfp, void *arg);
+  bool (*accepts) (const void *filter, const struct ddsi_serdata *serdata, void *arg);
+  void (*free) (void *filter, void *arg);
+};
+
+/** @component content_filter_if */
+inline void *ddsi_content_filter_compile (const struct ddsi_content_filter_interface *cfif, const struct ddsi_sertype *type, const struct ddsi_content_filter_property *cfp) {
+  return (cfif && cfp) ? cfif->compile (type, cfp, cfif->arg) : NULL;
+}
+
+/** @component content_filter_if */
+inline bool ddsi_content_filter_accepts (const struct ddsi_content_filter_interface *cfif, const void *filter, const struct ddsi_serdata *serdata) {
+  return filter ? cfif->accepts (filter, serdata, cfif->arg) : true;
+}
+
+/** @component content_filter_if */
+inline void ddsi_content_filter_free (const struct ddsi_content_filter_interface *cfif, void *filter) {
+  if (filter) cfif->free (filter, cfif->arg);
+}
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
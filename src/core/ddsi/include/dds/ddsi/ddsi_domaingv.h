@@ -20,6 +20,7 @@
 #include "dds/ddsrt/sockets.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsrt/random.h"
 
@@ -32,7 +33,6 @@
 extern "C" {
 #endif
 
-struct ddsi_xmsgpool;
 struct ddsi_dqueue;
 struct ddsi_reorder;
 struct ddsi_defrag;
@@ -46,6 +46,8 @@ struct ddsi_tran_listener;
 struct ddsi_tran_factory;
 struct ddsi_debug_monitor;
 struct ddsi_tkmap;
+struct ddsi_compression;
+struct ddsi_content_filter_interface;
 struct dds_security_context;
 struct dds_security_match_index;
 struct ddsi_hsadmin;
@@ -77,11 +79,20 @@ struct ddsi_recv_thread_arg {
     struct {
       const ddsi_locator_t *loc;
       struct ddsi_tran_conn *conn;
+      /* Waitset containing just conn, for sockets sharing a port with
+         other sockets: a packet sent to loc to wake the thread would
+         not necessarily arrive at conn (NULL if not needed) */
+      struct ddsi_sock_waitset *ws;
     } single;
     struct {
       struct ddsi_sock_waitset *ws;
     } many;
   } u;
+  /* Number of packets received and number of read calls needed to
+     receive them, the difference is a measure of the effect of
+     batched receives.  Only updated by the receive thread itself. */
+  ddsrt_atomic_uint64_t npackets;
+  ddsrt_atomic_uint64_t nreads;
 };
 
 struct ddsi_deleted_participants_admin;
@@ -103,12 +114,18 @@ struct ddsi_domaingv {
   /* Timed events admin */
   struct ddsi_xeventq *xevents;
 
+  /* Timed event queues for heartbeats, ACKNACKs and retransmits of
+     application writers and proxy writers, each of these is assigned to
+     one of them based on its GUID; [0] is xevents */
+  uint32_t n_endpoint_xevents;
+  struct ddsi_xeventq **endpoint_xevents;
+
   /* Queue for garbage collection requests */
   struct ddsi_gcreq_queue *gcreq_queue;
 
   /* Lease junk */
   ddsrt_mutex_t leaseheap_lock;
-  ddsrt_fibheap_t leaseheap;
+  ddsrt_timerwheel_t leasewheel;
 
   /* Transport factories & selected factory */
   struct ddsi_tran_factory *ddsi_tran_factories;
@@ -124,6 +141,12 @@ struct ddsi_domaingv {
   struct ddsi_tran_conn * disc_conn_uc;
   struct ddsi_tran_conn * data_conn_uc;
 
+  /* Additional sockets bound to the same port as data_conn_uc when the
+     unicast data port is served by multiple receive threads */
+#define MAX_UC_RECV_THREADS 8
+  uint32_t n_data_conn_uc_shared;
+  struct ddsi_tran_conn * data_conn_uc_shared[MAX_UC_RECV_THREADS - 1];
+
   /* Connection used for all output (for connectionless transports), this
      used to simply be data_conn_uc, but:
 
@@ -213,7 +236,7 @@ struct ddsi_domaingv {
      trigger socket.) Receive buffer pool is per receive thread,
      it is only a global variable because it needs to be freed way later
      than the receive thread itself terminates */
-#define MAX_RECV_THREADS 3
+#define MAX_RECV_THREADS (2 + MAX_UC_RECV_THREADS)
   uint32_t n_recv_threads;
   struct recv_thread {
     const char *name;
@@ -268,11 +291,11 @@ struct ddsi_domaingv {
   uint32_t networkQueueId;
   struct ddsi_thread_state *channel_reader_thrst;
 
-  /* Application data gets its own delivery queue */
-  struct ddsi_dqueue *user_dqueue;
+  /* Application data gets its own delivery queues, each proxy writer
+     is assigned to one of them based on its GUID */
+  uint32_t n_user_dqueues;
+  struct ddsi_dqueue **user_dqueues;
 
-  /* Transmit side: pool for transmit queue*/
-  struct ddsi_xmsgpool *xmsgpool;
   struct ddsi_sertype *spdp_type; /* key = participant GUID */
   struct ddsi_sertype *sedp_reader_type; /* key = endpoint GUID */
   struct ddsi_sertype *sedp_writer_type; /* key = endpoint GUID */
@@ -305,8 +328,14 @@ struct ddsi_domaingv {
   FILE *pcap_fp;
   ddsrt_mutex_t pcap_lock;
 
+  /* Payload compression codecs */
+  struct ddsi_compression *compression;
+
   struct ddsi_builtin_topic_interface *builtin_topic_interface;
 
+  /* Evaluation of content filters of remote readers, NULL if not available */
+  struct ddsi_content_filter_interface *content_filter_interface;
+
   struct ddsi_mcgroup_membership *mship;
 
   ddsrt_mutex_t sertypes_lock;
@@ -317,6 +346,8 @@ struct ddsi_domaingv {
   ddsrt_avl_tree_t typelib;
   ddsrt_avl_tree_t typedeps;
   ddsrt_avl_tree_t typedeps_reverse;
+  ddsrt_avl_tree_t type_assignable;
+  ddsrt_avl_tree_t type_assignable_reverse;
   ddsrt_cond_t typelib_resolved_cond;
 #endif
 #ifdef DDS_HAS_TOPIC_DISCOVERY
@@ -17,6 +17,8 @@
 #include "dds/ddsrt/fibheap.h"
 #include "dds/ddsi/ddsi_entity.h"
 #include "dds/ddsi/ddsi_hbcontrol.h"
+#include "dds/ddsi/ddsi_pacing.h"
+#include "dds/ddsi/ddsi_ack_tracker.h"
 #include "dds/dds.h"
 
 #if defined (__cplusplus)
@@ -25,6 +27,7 @@ extern "C" {
 
 struct ddsi_participant;
 struct ddsi_type_pair;
+struct ddsi_content_filter_property;
 struct ddsi_writer_info;
 struct ddsi_entity_common;
 struct ddsi_endpoint_common;
@@ -80,6 +83,7 @@ struct ddsi_writer
   ddsi_count_t hbfragcount; /* last hb frag seq number */
   int throttling; /* non-zero when some thread is waiting for the WHC to shrink */
   struct ddsi_hbcontrol hbcontrol; /* controls heartbeat timing, piggybacking */
+  struct ddsi_pacing pacing; /* rate-based congestion control, rate = 0 if not paced */
   struct dds_qos *xqos;
   enum ddsi_writer_state state;
   unsigned reliable: 1; /* iff 1, writer is reliable <=> heartbeat_xevent != NULL */
@@ -92,6 +96,7 @@ struct ddsi_writer
   unsigned test_suppress_heartbeat : 1; /* iff 1, the writer suppresses all periodic heartbeats */
   unsigned test_suppress_flush_on_sync_heartbeat : 1; /* iff 1, the writer never flushes because of a piggy-backed heartbeat */
   unsigned test_drop_outgoing_data : 1; /* iff 1, the writer drops outgoing data, forcing the readers to request a retransmit */
+  unsigned addrset_dirty: 1; /* iff 1, "as" was updated incrementally and a full recomputation is pending */
 #ifdef DDSRT_HAVE_SSM
   unsigned supports_ssm: 1;
   struct ddsi_addrset *ssm_as;
@@ -100,6 +105,7 @@ struct ddsi_writer
   const struct ddsi_sertype * type; /* type of the data written by this writer */
   struct ddsi_addrset *as; /* set of addresses to publish to */
   struct ddsi_xevent *heartbeat_xevent; /* timed event for "periodically" publishing heartbeats when unack'd data present, NULL <=> unreliable */
+  struct ddsi_xevent *addrset_xevent; /* timed event for the delayed full recomputation of "as" */
   struct ddsi_ldur_fhnode *lease_duration; /* fibheap node to keep lease duration for this writer, NULL in case of automatic liveliness with inifite duration  */
   struct ddsi_whc *whc; /* WHC tracking history, T-L durability service history + samples by sequence number for retransmit */
   uint32_t whc_low, whc_high; /* watermarks for WHC in bytes (counting only unack'd data) */
@@ -108,10 +114,17 @@ struct ddsi_writer
   ddsrt_etime_t t_whc_high_upd; /* time "whc_high" was last updated for controlled ramp-up of throughput */
   uint32_t init_burst_size_limit; /* derived from reader's receive_buffer_size */
   uint32_t rexmit_burst_size_limit; /* derived from reader's receive_buffer_size */
+  uint32_t min_receive_buffer_size; /* smallest receive_buffer_size of the readers, UINT32_MAX if none */
   uint32_t num_readers; /* total number of matching PROXY readers */
   uint32_t num_reliable_readers; /* number of matching reliable PROXY readers */
   uint32_t num_readers_requesting_keyhash; /* also +1 for protected keys and config override for generating keyhash */
+  uint32_t num_readers_accepting_compression; /* number of matching PROXY readers that can decode compression_codec */
+  uint32_t num_content_filtered_readers; /* number of matching PROXY readers with a content filter evaluated by the writer */
+  const struct ddsi_compression_codec *compression_codec; /* codec for compressing payloads, NULL if disabled */
+  uint32_t compression_threshold; /* samples smaller than this are never compressed */
   ddsrt_avl_tree_t readers; /* all matching PROXY readers, see struct ddsi_wr_prd_match */
+  struct ddsi_ack_tracker ack_tracker; /* acknowledgement state of "readers" */
+  ddsrt_avl_tree_t cf_dests; /* destinations of "readers" for content filtering, see struct ddsi_wr_cf_dest; empty iff num_content_filtered_readers = 0 */
   ddsrt_avl_tree_t local_readers; /* all matching LOCAL readers, see struct ddsi_wr_rd_match */
 #ifdef DDS_HAS_NETWORK_PARTITIONS
   const struct ddsi_config_networkpartition_listelem *network_partition;
@@ -125,6 +138,10 @@ struct ddsi_writer
   uint64_t rexmit_bytes; /* cum bytes queued for retransmit */
   uint64_t time_throttled; /* cum time in throttled state */
   uint64_t time_retransmit; /* cum time in retransmitting state */
+  uint32_t addrset_rebuild_count; /* cum full computations of "as" */
+  uint32_t addrset_update_count; /* cum incremental updates of "as" */
+  uint64_t time_addrset; /* cum time spent computing "as" */
+  uint64_t content_filter_skipped; /* cum samples not sent because no matched reader accepted them */
   struct ddsi_xeventq *evq; /* timed event queue to be used by this writer */
   struct ddsi_local_reader_ary rdary; /* LOCAL readers for fast-pathing; if not fast-pathed, fall back to scanning local_readers */
   struct ddsi_lease *lease; /* for liveliness administration (writer can only become inactive when using manual liveliness) */
@@ -157,6 +174,7 @@ struct ddsi_reader
   struct ddsi_networkpartition_address *mc_as;
 #endif
   const struct ddsi_sertype * type; /* type of the data read by this reader */
+  struct ddsi_content_filter_property *content_filter; /* content filter advertised in discovery, NULL if none */
   uint32_t num_writers; /* total number of matching PROXY writers */
   ddsrt_avl_tree_t writers; /* all matching PROXY writers, see struct ddsi_rd_pwr_match */
   ddsrt_avl_tree_t local_writers; /* all matching LOCAL writers, see struct ddsi_rd_wr_match */
@@ -223,11 +241,20 @@ struct ddsi_reader *ddsi_writer_next_in_sync_reader (struct ddsi_entity_index *e
 dds_return_t ddsi_generate_reader_guid (struct ddsi_guid *rdguid, struct ddsi_participant *participant, const struct ddsi_sertype *sertype);
 
 /** @component ddsi_endpoint */
-dds_return_t ddsi_new_reader (struct ddsi_reader **rd_out, const struct ddsi_guid *guid, const struct ddsi_guid *group_guid, struct ddsi_participant *pp, const char *topic_name, const struct ddsi_sertype *type, const struct dds_qos *xqos, struct ddsi_rhc *rhc, ddsi_status_cb_t status_cb, void * status_entity, struct ddsi_psmx_locators_set *psmx_locators);
+dds_return_t ddsi_new_reader (struct ddsi_reader **rd_out, const struct ddsi_guid *guid, const struct ddsi_guid *group_guid, struct ddsi_participant *pp, const char *topic_name, const struct ddsi_sertype *type, const struct dds_qos *xqos, const struct ddsi_content_filter_property *content_filter, struct ddsi_rhc *rhc, ddsi_status_cb_t status_cb, void * status_entity, struct ddsi_psmx_locators_set *psmx_locators);
 
 /** @component ddsi_endpoint */
 void ddsi_update_reader_qos (struct ddsi_reader *rd, const struct dds_qos *xqos);
 
+/**
+ * @brief Replaces the content filter a reader advertises in discovery
+ * @component ddsi_endpoint
+ *
+ * @param[in] rd              the reader
+ * @param[in] content_filter  the new content filter (copied), NULL to remove it
+ */
+void ddsi_update_reader_content_filter (struct ddsi_reader *rd, const struct ddsi_content_filter_property *content_filter);
+
 /** @component ddsi_endpoint */
 dds_return_t ddsi_delete_reader (struct ddsi_domaingv *gv, const struct ddsi_guid *guid);
 
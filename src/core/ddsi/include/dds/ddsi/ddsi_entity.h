@@ -28,6 +28,7 @@ struct ddsi_rsample_info;
 struct ddsi_rdata;
 struct ddsi_tkmap_instance;
 struct ddsi_local_reader_ary;
+struct ddsi_match_index_node;
 
 enum ddsi_entity_kind {
   DDSI_EK_PARTICIPANT,
@@ -69,6 +70,14 @@ struct ddsi_entity_common {
   struct ddsi_domaingv *gv;
   ddsrt_avl_node_t all_entities_avlnode;
 
+  /* Endpoints are also in the entity index once for each distinct
+     non-wildcard partition and once more if they have any wildcard
+     partitions.  The nodes are owned by the entity so that they
+     remain valid during enumeration for as long as the entity
+     itself is. */
+  struct ddsi_match_index_node *match_index_nodes;
+  uint32_t n_match_index_nodes;
+
   /* QoS changes always lock the entity itself, and additionally
      (and within the scope of the entity lock) acquire qos_lock
      while manipulating the QoS.  So any thread that needs to read
@@ -13,6 +13,7 @@
 
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
 #include "dds/ddsrt/time.h"
 
 #if defined (__cplusplus)
@@ -22,7 +23,7 @@ extern "C" {
 struct ddsi_entity_common;
 
 struct ddsi_lease {
-  ddsrt_fibheap_node_t heapnode;
+  ddsrt_timerwheel_node_t twnode;
   ddsrt_fibheap_node_t pp_heapnode;
   ddsrt_etime_t tsched;         /* access guarded by leaseheap_lock */
   ddsrt_atomic_uint64_t tend;   /* really an ddsrt_etime_t */
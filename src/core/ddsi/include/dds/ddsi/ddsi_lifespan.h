@@ -11,7 +11,7 @@
 #ifndef DDSI_LIFESPAN_H
 #define DDSI_LIFESPAN_H
 
-#include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
 #include "dds/ddsrt/time.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 
@@ -22,7 +22,7 @@ extern "C" {
 typedef ddsrt_mtime_t (*ddsi_sample_expired_cb_t)(void *hc, ddsrt_mtime_t tnow);
 
 struct ddsi_lifespan_adm {
-  ddsrt_fibheap_t ls_exp_heap;              /* heap for sample expiration (lifespan) */
+  ddsrt_timerwheel_t ls_exp_tw;             /* timer wheel for sample expiration (lifespan) */
   struct ddsi_xevent *evt;                       /* xevent that triggers for sample with earliest expiration */
   ddsi_sample_expired_cb_t sample_expired_cb;    /* callback for expired sample; this cb can use ddsi_lifespan_next_expired_locked to get next expired sample */
   size_t fh_offset;                         /* offset of lifespan_adm element in whc or rhc */
@@ -30,7 +30,7 @@ struct ddsi_lifespan_adm {
 };
 
 struct ddsi_lifespan_fhnode {
-  ddsrt_fibheap_node_t heapnode;
+  ddsrt_timerwheel_node_t twnode;
   ddsrt_mtime_t t_expire;
 };
 
@@ -38,10 +38,10 @@ struct ddsi_lifespan_fhnode {
 void ddsi_lifespan_init (const struct ddsi_domaingv *gv, struct ddsi_lifespan_adm *lifespan_adm, size_t fh_offset, size_t fh_node_offset, ddsi_sample_expired_cb_t sample_expired_cb);
 
 /** @component lifespan_qos */
-void ddsi_lifespan_fini (const struct ddsi_lifespan_adm *lifespan_adm);
+void ddsi_lifespan_fini (struct ddsi_lifespan_adm *lifespan_adm);
 
 /** @component lifespan_qos */
-ddsrt_mtime_t ddsi_lifespan_next_expired_locked (const struct ddsi_lifespan_adm *lifespan_adm, ddsrt_mtime_t tnow, void **sample);
+ddsrt_mtime_t ddsi_lifespan_next_expired_locked (struct ddsi_lifespan_adm *lifespan_adm, ddsrt_mtime_t tnow, void **sample);
 
 /** @component lifespan_qos */
 void ddsi_lifespan_register_sample_real (struct ddsi_lifespan_adm *lifespan_adm, struct ddsi_lifespan_fhnode *node);
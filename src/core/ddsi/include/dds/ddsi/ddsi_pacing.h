@@ -0,0 +1,46 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI_PACING_H
+#define DDSI_PACING_H
+
+#include "dds/features.h"
+#include "dds/ddsrt/time.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/// @brief Sender-side pacing state of a reliable writer (protected by the writer lock)
+///
+/// New data is paced by a token bucket that fills at the current rate. The rate itself is
+/// adjusted additive-increase/multiplicative-decrease style using the ACKNACKs received
+/// from the readers, at most once per round-trip time. The WHC watermarks still apply on
+/// top of this.
+struct ddsi_pacing {
+  uint64_t rate;              ///< Current rate in bytes/s, 0 if the writer is not paced
+  double tokens;              ///< Bytes that may be sent without waiting, negative when in debt
+  ddsrt_mtime_t t_refill;     ///< Time at which the tokens were last updated
+  ddsrt_mtime_t t_adjust;     ///< Time of the most recent rate adjustment
+  ddsrt_mtime_t t_backoff;    ///< Time of the most recent rate decrease
+  int64_t rtt;                ///< Round-trip time, minimum interval between rate adjustments
+  int waiting;                ///< Number of threads waiting for tokens
+  uint32_t backoff_count;     ///< Number of times the rate was decreased
+  uint64_t time_paced;        ///< Total time spent waiting for tokens (ns)
+  ddsrt_mtime_t t_window;     ///< Start of the current window for measuring the achieved rate
+  uint64_t window_bytes;      ///< Bytes written in the current window
+  uint64_t achieved_rate;     ///< Rate achieved in the most recently completed window (bytes/s)
+};
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI_PACING_H */
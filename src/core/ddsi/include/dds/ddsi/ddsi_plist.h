@@ -101,6 +101,15 @@ typedef struct ddsi_adlink_participant_version_info
   char *internals;
 } ddsi_adlink_participant_version_info_t;
 
+typedef struct ddsi_content_filter_property
+{
+  char *content_filtered_topic_name;
+  char *related_topic_name;
+  char *filter_class_name;
+  char *filter_expression;
+  ddsi_stringseq_t expression_parameters;
+} ddsi_content_filter_property_t;
+
 typedef struct ddsi_plist {
   uint64_t present;
   uint64_t aliased;
@@ -119,7 +128,7 @@ typedef struct ddsi_plist {
   unsigned char expects_inline_qos;
   ddsi_count_t participant_manual_liveliness_count;
   uint32_t participant_builtin_endpoints;
-  /* ddsi_content_filter_property_t content_filter_property; */
+  ddsi_content_filter_property_t content_filter_property;
   ddsi_guid_t participant_guid;
   ddsi_guid_t endpoint_guid;
   ddsi_guid_t group_guid;
@@ -149,6 +158,8 @@ typedef struct ddsi_plist {
   uint32_t cyclone_receive_buffer_size;
   unsigned char cyclone_requests_keyhash;
   unsigned char cyclone_redundant_networking;
+  uint32_t cyclone_accepted_compression;
+  uint32_t cyclone_writer_compression;
 } ddsi_plist_t;
 
 /**
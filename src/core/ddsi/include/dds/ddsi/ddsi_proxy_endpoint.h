@@ -29,6 +29,7 @@ struct ddsi_writer;
 struct dds_qos;
 struct ddsi_addrset;
 struct ddsi_serdata;
+struct ddsi_content_filter_property;
 
 struct ddsi_proxy_endpoint_common
 {
@@ -75,6 +76,7 @@ struct ddsi_proxy_writer {
 #endif
   unsigned local_psmx: 1; /* whether this is a proxy writer for a local PSMX */
   uint32_t alive_vclock; /* virtual clock counting transitions between alive/not-alive */
+  uint32_t compression_codecs; /* bitmask of compression codec ids the writer may use, 0 if it never compresses */
   struct ddsi_defrag *defrag; /* defragmenter for this proxy writer; FIXME: perhaps shouldn't be for historical data */
   struct ddsi_reorder *reorder; /* message reordering for this proxy writer, out-of-sync readers can have their own, see pwr_rd_match */
   struct ddsi_dqueue *dqueue; /* delivery queue for asynchronous delivery (historical data is always delivered asynchronously) */
@@ -99,6 +101,8 @@ struct ddsi_proxy_reader {
   unsigned local_psmx: 1; /*whether this is a proxy reader for a local PSMX*/
   ddsrt_avl_tree_t writers; /* matching LOCAL writers */
   uint32_t receive_buffer_size; /* assumed receive buffer size inherited from proxypp */
+  uint32_t accepted_compression; /* bitmask of compression codec ids the reader can decode */
+  struct ddsi_content_filter_property *content_filter; /* content filter advertised by the reader, NULL if none */
   ddsi_filter_fn_t filter;
 };
 
@@ -19,13 +19,26 @@ extern "C" {
 
 struct ddsi_reader;
 struct ddsi_writer;
+struct ddsi_domaingv;
 
 /** @component ddsi_statistics */
 void ddsi_get_writer_stats (struct ddsi_writer *wr, uint64_t * __restrict rexmit_bytes, uint32_t * __restrict throttle_count, uint64_t * __restrict time_throttled, uint64_t * __restrict time_retransmit);
 
+/** @component ddsi_statistics */
+void ddsi_get_writer_pacing_stats (struct ddsi_writer *wr, uint64_t * __restrict rate, uint64_t * __restrict achieved_rate, uint32_t * __restrict backoff_count, uint64_t * __restrict time_paced);
+
+/** @component ddsi_statistics */
+void ddsi_get_writer_addrset_stats (struct ddsi_writer *wr, uint32_t * __restrict rebuild_count, uint32_t * __restrict update_count, uint64_t * __restrict time_addrset);
+
+/** @component ddsi_statistics */
+void ddsi_get_writer_content_filter_stats (struct ddsi_writer *wr, uint32_t * __restrict num_filtered_readers, uint64_t * __restrict skipped);
+
 /** @component ddsi_statistics */
 void ddsi_get_reader_stats (struct ddsi_reader *rd, uint64_t * __restrict discarded_bytes);
 
+/** @component ddsi_statistics */
+void ddsi_get_recv_stats (const struct ddsi_domaingv *gv, uint64_t * __restrict packets, uint64_t * __restrict reads);
+
 #if defined (__cplusplus)
 }
 #endif
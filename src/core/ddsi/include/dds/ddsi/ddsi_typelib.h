@@ -91,6 +91,25 @@ DDS_EXPORT bool ddsi_typemap_equal (const ddsi_typemap_t *a, const ddsi_typemap_
 /** @component type_system */
 DDS_EXPORT const char * ddsi_typemap_get_type_name (const ddsi_typemap_t *typemap, const ddsi_typeid_t *type_id);
 
+/**
+ * @brief Resolve a (possibly nested) member of a type by name
+ *
+ * @param[in] typemap  type map containing the complete type objects of the type and its dependencies
+ * @param[in] type_id  complete type identifier of the (struct) type
+ * @param[in] ops      serializer instructions of the type
+ * @param[in] name     name of the member, using "." to separate the names of nested members
+ * @param[out] path    the member's location in the instructions
+ * @param[out] enum_type  set to the enumerated type if the member is an enum, else to a null pointer
+ *
+ * @retval DDS_RETCODE_OK  the member is of a primitive, enum or string type
+ * @retval DDS_RETCODE_BAD_PARAMETER  no such member
+ * @retval DDS_RETCODE_UNSUPPORTED  the member is of a type other than a primitive, enum or string type,
+ *   or is nested too deeply
+ *
+ * @component type_system
+ */
+DDS_EXPORT dds_return_t ddsi_typemap_resolve_member (const ddsi_typemap_t *typemap, const ddsi_typeid_t *type_id, const uint32_t *ops, const char *name, struct dds_cdrstream_member_path *path, const struct DDS_XTypes_CompleteEnumeratedType **enum_type);
+
 /** @component type_system */
 dds_return_t ddsi_type_ref_local (struct ddsi_domaingv *gv, struct ddsi_type **type, const struct ddsi_sertype *sertype, ddsi_typeid_kind_t kind);
 
@@ -33,6 +33,7 @@ struct ddsi_whc_node {
 struct ddsi_whc_borrowed_sample {
   ddsi_seqno_t seq;
   struct ddsi_serdata *serdata;
+  struct ddsi_serdata *xmit_serdata; /* representation on the wire if constructed, e.g. compressed; the borrower may set it if NULL and the WHC owns it once returned */
   bool unacked;
   ddsrt_mtime_t last_rexmit_ts;
   unsigned rexmit_count;
@@ -31,6 +31,9 @@ DDS_EXPORT void ddsi_xpack_free (struct ddsi_xpack *xp);
 /** @component rtps_msg */
 DDS_EXPORT void ddsi_xpack_send (struct ddsi_xpack *xp, bool immediately /* unused */);
 
+/** @component rtps_msg */
+DDS_EXPORT bool ddsi_xpack_is_empty (const struct ddsi_xpack *xp);
+
 /** @component rtps_msg */
 void ddsi_xpack_sendq_init (struct ddsi_domaingv *gv);
 
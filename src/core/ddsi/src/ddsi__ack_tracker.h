@@ -0,0 +1,88 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI__ACK_TRACKER_H
+#define DDSI__ACK_TRACKER_H
+
+#include <stdbool.h>
+#include "dds/features.h"
+#include "dds/ddsi/ddsi_ack_tracker.h"
+#include "ddsi__protocol.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_wr_prd_match;
+
+/** @component writer_ack_tracking */
+void ddsi_ack_tracker_init (struct ddsi_ack_tracker *tr);
+
+/**
+ * @brief Free all memory of the tracker, all readers must have been removed
+ * @component writer_ack_tracking
+ */
+void ddsi_ack_tracker_fini (struct ddsi_ack_tracker *tr);
+
+/**
+ * @brief Add a reader based on its "seq" and "has_replied_to_hb" fields
+ * @component writer_ack_tracking
+ */
+void ddsi_ack_tracker_insert (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m);
+
+/** @component writer_ack_tracking */
+void ddsi_ack_tracker_remove (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m);
+
+/**
+ * @brief Update the acknowledged sequence number and heartbeat state of a reader
+ * @component writer_ack_tracking
+ *
+ * This is the only way the "seq" and "has_replied_to_hb" fields of a reader may be changed
+ * once it has been added to the tracker. Moving a reader forward costs time proportional to
+ * the number of distinct sequence numbers acknowledged by other readers that it passes.
+ *
+ * @param[in,out] tr       tracker
+ * @param[in,out] m        reader
+ * @param[in] seq          new acknowledged sequence number, DDSI_MAX_SEQ_NUMBER for a reader that is ignored
+ * @param[in] has_replied  new value of "has_replied_to_hb"
+ */
+void ddsi_ack_tracker_update (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m, ddsi_seqno_t seq, bool has_replied);
+
+/**
+ * @brief Lowest sequence number acknowledged by any reader
+ * @component writer_ack_tracking
+ * @returns the sequence number or DDSI_MAX_SEQ_NUMBER if all readers are ignored
+ */
+ddsi_seqno_t ddsi_ack_tracker_min_seq (const struct ddsi_ack_tracker *tr);
+
+/**
+ * @brief Highest sequence number acknowledged by any reader
+ * @component writer_ack_tracking
+ * @returns the sequence number or 0 if all readers are ignored
+ */
+ddsi_seqno_t ddsi_ack_tracker_max_seq (const struct ddsi_ack_tracker *tr);
+
+/**
+ * @brief Number of readers that replied to a heartbeat and acknowledged the highest sequence number
+ * @component writer_ack_tracking
+ */
+uint32_t ddsi_ack_tracker_num_at_max_seq (const struct ddsi_ack_tracker *tr);
+
+/**
+ * @brief Whether all readers have replied to a heartbeat
+ * @component writer_ack_tracking
+ */
+bool ddsi_ack_tracker_all_replied (const struct ddsi_ack_tracker *tr);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI__ACK_TRACKER_H */
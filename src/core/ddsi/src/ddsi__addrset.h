@@ -38,6 +38,10 @@ typedef ssize_t (*ddsi_addrset_forone_fun_t) (const ddsi_xlocator_t *loc, void *
 void ddsi_add_xlocator_to_addrset (const struct ddsi_domaingv *gv, struct ddsi_addrset *as, const ddsi_xlocator_t *loc)
   ddsrt_nonnull_all;
 
+/** @component locators */
+bool ddsi_addrset_contains_xlocator (const struct ddsi_domaingv *gv, const struct ddsi_addrset *as, const ddsi_xlocator_t *loc)
+  ddsrt_nonnull_all;
+
 /** @component locators */
 void ddsi_remove_from_addrset (const struct ddsi_domaingv *gv, struct ddsi_addrset *as, const ddsi_xlocator_t *loc)
   ddsrt_nonnull_all;
@@ -1024,6 +1024,50 @@ static struct cfgelem internal_watermarks_cfgelems[] = {
   END_MARKER
 };
 
+static struct cfgelem internal_pacing_cfgelems[] = {
+  STRING("MaxRate", NULL, 1, "0 B",
+    MEMBER(pacing_max_rate),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the maximum rate at which a reliable writer "
+      "transmits new data, expressed in bytes per second. Writers start out "
+      "at this rate, back off multiplicatively when readers request "
+      "retransmits and increase the rate additively again when they don't. "
+      "0 disables pacing, leaving only the WHC watermarks for flow-control.</p>"),
+    UNIT("memsize")),
+  STRING("MinRate", NULL, 1, "64 kB",
+    MEMBER(pacing_min_rate),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the rate, in bytes per second, below which "
+      "a paced writer never backs off.</p>"),
+    UNIT("memsize")),
+  STRING("AdditiveIncrease", NULL, 1, "64 kB",
+    MEMBER(pacing_increase),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the amount, in bytes per second, by which the "
+      "rate of a paced writer increases for every round-trip time without "
+      "retransmit requests.</p>"),
+    UNIT("memsize")),
+  STRING("BurstSize", NULL, 1, "64 kB",
+    MEMBER(pacing_burst_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the amount of data a paced writer may send "
+      "back-to-back after having been idle.</p>"),
+    UNIT("memsize")),
+  STRING("RoundTripTime", NULL, 1, "10 ms",
+    MEMBER(pacing_rtt),
+    FUNCTIONS(0, uf_duration_us_1s, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This element sets the round-trip time assumed for adjusting the "
+      "rate of a paced writer. The measured heartbeat-to-acknowledgement "
+      "latency is used instead if MeasureHbToAckLatency is enabled.</p>"),
+    UNIT("duration")),
+  END_MARKER
+};
+
 static struct cfgelem internal_burstsize_cfgelems[] = {
   STRING("MaxRexmit", NULL, 1, "1 MiB",
     MEMBER(max_rexmit_burst_size),
@@ -1215,6 +1259,33 @@ static struct cfgelem internal_cfgelems[] = {
       "expressed in samples. Once a delivery queue is full, incoming samples "
       "destined for that queue are dropped until space becomes available "
       "again.</p>")),
+  INT("DeliveryQueueThreads", NULL, 1, "1",
+    MEMBER(delivery_queue_threads),
+    FUNCTIONS(0, uf_pos_uint_64, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of delivery queues (each served by "
+      "its own thread) for asynchronously delivering application data to "
+      "the readers. Each remote writer is assigned to one of these queues "
+      "based on a hash of its GUID, so the data of any one writer is always "
+      "delivered in order, while deserialising and storing the data of "
+      "different writers can proceed in parallel. Each queue is limited to "
+      "DeliveryQueueMaxSamples samples. The delivery queue for discovery "
+      "data is not affected by this setting. The valid range is 1 to "
+      "64.</p>"),
+    RANGE("1;64")),
+  INT("TimedEventThreads", NULL, 1, "1",
+    MEMBER(timed_event_threads),
+    FUNCTIONS(0, uf_pos_uint_64, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of timed-event queues (each served "
+      "by its own thread) used for sending heartbeats, acknowledgements and "
+      "retransmits of application writers and readers. Each writer and each "
+      "remote writer is assigned to one of these queues based on a hash of "
+      "its GUID. Discovery and all other timed events are always handled by "
+      "the first queue. The limits set by MaxQueuedRexmitBytes and "
+      "MaxQueuedRexmitMessages apply to each queue individually. The valid "
+      "range is 1 to 64.</p>"),
+    RANGE("1;64")),
   INT("PrimaryReorderMaxSamples", NULL, 1, "128",
     MEMBER(primary_reorder_maxsamples),
     FUNCTIONS(0, uf_uint, 0, pf_uint),
@@ -1246,6 +1317,18 @@ static struct cfgelem internal_cfgelems[] = {
       "defragmented simultaneously for a reliable writer. This has to be "
       "large enough to handle retransmissions of historical data in addition "
       "to new samples.</p>")),
+  INT("FragmentParityGroupSize", NULL, 1, "0",
+    MEMBER(fragment_parity_group_size),
+    FUNCTIONS(0, uf_uint, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element enables forward error correction for fragmented "
+      "samples published by best-effort writers. After every group of this "
+      "many DATA_FRAG submessages of a sample, a vendor-specific submessage "
+      "containing the XOR of the group is sent, allowing a Cyclone DDS reader "
+      "to reconstruct one lost DATA_FRAG per group without retransmits. The "
+      "cost is one additional submessage per group, so smaller groups "
+      "tolerate more loss at a higher overhead. The default of 0 disables "
+      "it; readers always make use of the parity when it is present.</p>")),
   ENUM("BuiltinEndpointSet", NULL, 1, "writers",
     MEMBER(besmode),
     FUNCTIONS(0, uf_besmode, 0, pf_besmode),
@@ -1293,6 +1376,19 @@ static struct cfgelem internal_cfgelems[] = {
       "asynchronously through delivery queues. This reduces latency at the "
       "expense of aggregate bandwidth.</p>"),
     UNIT("duration_inf")),
+  INT("ReaderHistoryShards", NULL, 1, "1",
+    MEMBER(rhc_shards),
+    FUNCTIONS(0, uf_pos_uint_64, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of independently locked shards over "
+      "which the instances in the history of a reader are spread. With more "
+      "than one shard, data for different instances can be stored "
+      "concurrently by multiple delivery threads while the application "
+      "reads or takes data. It only applies to readers without limits on "
+      "the total number of samples and instances in the resource limits "
+      "QoS, other readers always use a single shard. The valid range is 1 "
+      "to 64.</p>"),
+    RANGE("1;64")),
   INT("MaxParticipants", NULL, 1, "0",
     MEMBER(max_participants),
     FUNCTIONS(0, uf_natint, 0, pf_int),
@@ -1367,6 +1463,18 @@ static struct cfgelem internal_cfgelems[] = {
       "deletion of a reliable writer with unacknowledged data in its history "
       "will be postponed to provide proper reliable transmission.<p>"),
     UNIT("duration")),
+  STRING("WriterAddressSetRecomputeDelay", NULL, 1, "100 ms",
+    MEMBER(writer_addrset_recompute_delay),
+    FUNCTIONS(0, uf_duration_ms_1hr, 0, pf_duration),
+    DESCRIPTION(
+      "<p>This setting controls how long after a change in the set of "
+      "matching readers a writer recomputes the optimal set of addresses to "
+      "send its data to. In the meantime, new readers are added to the "
+      "existing set without reconsidering the choices made for the other "
+      "readers, and removed readers are left in it. This way a burst of "
+      "discovery activity doesn't require a full recomputation for every "
+      "reader. 0 means the addresses are recomputed on every change.</p>"),
+    UNIT("duration")),
   MOVED("MinimumSocketReceiveBufferSize", "CycloneDDS/Domain/Internal/SocketReceiveBufferSize[@min]"),
   MOVED("MinimumSocketSendBufferSize", "CycloneDDS/Domain/Internal/SocketSendBufferSize[@min]"),
   GROUP("SocketReceiveBufferSize", NULL, sock_rcvbuf_size_attrs, 1,
@@ -1565,6 +1673,45 @@ static struct cfgelem internal_cfgelems[] = {
     "transport (e.g., UDP) and ManySocketsMode not set to single (the "
     "default).</p>"),
     VALUES("false","true","default")),
+  INT("UnicastReceiveThreads", NULL, 1, "1",
+    MEMBER(n_recv_threads_uc),
+    FUNCTIONS(0, uf_pos_uint, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of threads receiving data on the "
+      "unicast data port when MultipleReceiveThreads is enabled and "
+      "ManySocketsMode is set to single. With more than one, each thread "
+      "gets a socket of its own bound to the same port (using SO_REUSEPORT) "
+      "and the kernel spreads the incoming packets over these sockets based "
+      "on the source address, so that the packets from any one sender are "
+      "still processed in order. The check for whether the port is already "
+      "in use by another process is done before enabling port sharing, but "
+      "it can not entirely exclude the possibility of another process using "
+      "the same port simultaneously. Values larger than 8 are treated as "
+      "8.</p>")),
+  INT("ReceiveBatchSize", NULL, 1, "1",
+    MEMBER(recv_batch_size),
+    FUNCTIONS(0, uf_pos_uint, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the maximum number of packets a receive thread "
+      "reads from a socket in a single system call, where the platform "
+      "supports it (currently Linux, using recvmmsg). Reading a batch of "
+      "packets reduces the system call overhead at high packet rates. Each "
+      "packet in a batch requires ReceiveBufferChunkSize bytes in a receive "
+      "buffer, and so the batch size is also limited by Sizing/ReceiveBufferSize. "
+      "Values larger than 64 are treated as 64.</p>")),
+  INT("TransmitBatchSize", NULL, 1, "1",
+    MEMBER(xmit_batch_size),
+    FUNCTIONS(0, uf_pos_uint, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the maximum number of consecutive packets to the "
+      "same destinations that are held back and then sent in a single system "
+      "call, where the platform supports it (currently Linux, using sendmmsg). "
+      "Any value greater than 1 also makes the sending of a packet to many "
+      "destinations use a single system call per network interface. Runs of "
+      "equal-sized packets to a single destination are passed to the kernel as "
+      "a single packet to be segmented (UDP GSO) if the kernel supports it. "
+      "Batching is not used for packets that are encoded for security. Values "
+      "larger than 64 are treated as 64.</p>")),
   GROUP("ControlTopic", control_topic_cfgelems, control_topic_cfgattrs, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -1580,6 +1727,10 @@ static struct cfgelem internal_cfgelems[] = {
     NOMEMBER,
     NOFUNCTIONS,
     DESCRIPTION("<p>Watermarks for flow-control.</p>")),
+  GROUP("Pacing", internal_pacing_cfgelems, NULL, 1,
+    NOMEMBER,
+    NOFUNCTIONS,
+    DESCRIPTION("<p>Rate-based congestion control for reliable writers.</p>")),
   GROUP("BurstSize", internal_burstsize_cfgelems, NULL, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -1608,6 +1759,47 @@ static struct cfgelem internal_cfgelems[] = {
   END_MARKER
 };
 
+static struct cfgelem compression_cfgelems[] = {
+  STRING("Codec", NULL, 1, "",
+    MEMBER(compression_codec),
+    FUNCTIONS(0, uf_string, ff_free, pf_string),
+    DESCRIPTION(
+      "<p>This element specifies the codec writers use to compress the "
+      "serialized samples they publish. The empty string disables "
+      "compression, \"lz\" selects the built-in codec and any other name "
+      "refers to a codec loaded from a plugin library. A writer only "
+      "compresses the data it sends if all readers it is sent to have "
+      "advertised support for the codec during discovery, it retains the "
+      "uncompressed data for retransmits and late-joining readers. Readers "
+      "always accept the built-in codec and the one loaded from a plugin.</p>"
+    )),
+  STRING("Library", NULL, 1, "",
+    MEMBER(compression_library),
+    FUNCTIONS(0, uf_string, ff_free, pf_string),
+    DESCRIPTION(
+      "<p>This element specifies the library implementing a codec other than "
+      "the built-in one. It defaults to the name of the codec. The library must "
+      "export a function &lt;Codec&gt;_create_compression_codec.</p>"
+    )),
+  STRING("Config", NULL, 1, "",
+    MEMBER(compression_config),
+    FUNCTIONS(0, uf_string, ff_free, pf_string),
+    DESCRIPTION(
+      "<p>This element specifies a configuration string that is passed "
+      "uninterpreted to the codec plugin.</p>"
+    )),
+  STRING("Threshold", NULL, 1, "1 kB",
+    MEMBER(compression_threshold),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the size of the serialized sample below "
+      "which samples are sent uncompressed. It can be overridden per topic or "
+      "writer using the \"cyclonedds.compression.threshold\" property "
+      "QoS.</p>"),
+    UNIT("memsize")),
+  END_MARKER
+};
+
 static struct cfgelem sizing_cfgelems[] = {
   STRING("ReceiveBufferSize", NULL, 1, "1 MiB",
     MEMBER(rbuf_size),
@@ -1628,6 +1820,20 @@ static struct cfgelem sizing_cfgelems[] = {
       "shrunk immediately after processing a message or freed "
       "straightaway.</p>"),
     UNIT("memsize")),
+  INT("ReceiveBufferSlabs", NULL, 1, "0",
+    MEMBER(rbuf_slabs),
+    FUNCTIONS(0, uf_uint, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element selects how receive threads allocate memory for "
+      "incoming messages. If 0, messages are allocated consecutively in "
+      "receive buffers of Sizing/ReceiveBufferSize, and a receive buffer is "
+      "freed once all messages in it have been freed. Otherwise, each message "
+      "gets a slab of memory of its own, the size of which is a little more "
+      "than Sizing/ReceiveBufferChunkSize, and each receive thread keeps up "
+      "to this many free slabs for reuse. Slabs limit the memory retained by "
+      "messages waiting in a delivery queue to those messages themselves, "
+      "at the cost of not shrinking the memory allocated to a message after "
+      "processing it.</p>")),
   END_MARKER
 };
 
@@ -2212,6 +2418,13 @@ static struct cfgelem domain_cfgelems[] = {
       "that is written into the tracing log by the DDSI service. This is "
       "useful to track the DDSI service during application development.</p>"
     )),
+  GROUP("Compression", compression_cfgelems, NULL, 1,
+    NOMEMBER,
+    NOFUNCTIONS,
+    DESCRIPTION(
+      "<p>The Compression element allows you to specify how the serialized "
+      "samples of application writers are compressed.</p>"
+    )),
   GROUP("Internal|Unsupported", internal_cfgelems, NULL, 1,
     NOMEMBER,
     NOFUNCTIONS,
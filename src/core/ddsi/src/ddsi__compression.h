@@ -0,0 +1,139 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI__COMPRESSION_H
+#define DDSI__COMPRESSION_H
+
+#include "dds/features.h"
+#include "dds/ddsi/ddsi_compression.h"
+#include "dds/ddsi/ddsi_serdata.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_domaingv;
+struct ddsi_writer;
+struct ddsi_proxy_reader;
+struct ddsi_rdata;
+struct dds_qos;
+
+/** @brief First byte of a compressed payload, never a valid first byte of an encoding identifier */
+#define DDSI_COMPRESSION_MARKER 0x80
+
+/** @brief Size of the header preceding the compressed data in the payload */
+#define DDSI_COMPRESSION_HDR_SIZE 12
+
+/** @component compression */
+dds_return_t ddsi_compression_init (struct ddsi_domaingv *gv);
+
+/** @component compression */
+void ddsi_compression_fini (struct ddsi_domaingv *gv);
+
+/**
+ * @brief Set of codecs readers in this domain can decode
+ * @component compression
+ *
+ * @param[in] gv  domain
+ * @returns bitmask with bit `id` set for each supported codec
+ */
+uint32_t ddsi_compression_accepted (const struct ddsi_domaingv *gv);
+
+/**
+ * @brief Codec and threshold for a new writer
+ * @component compression
+ *
+ * @param[in] gv          domain
+ * @param[in] xqos        writer QoS, the "cyclonedds.compression.threshold" property overrides the configured threshold
+ * @param[out] threshold  minimum size of samples to compress
+ * @returns the codec or NULL if the writer should not compress its data
+ */
+const struct ddsi_compression_codec *ddsi_compression_codec_for_writer (const struct ddsi_domaingv *gv, const struct dds_qos *xqos, uint32_t *threshold);
+
+/**
+ * @brief Whether a proxy reader can decode the data of the writer
+ * @component compression
+ */
+bool ddsi_writer_compression_accepted_by (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd);
+
+/**
+ * @brief Construct a compressed version of a serdata
+ * @component compression
+ *
+ * The result is a serdata with the same key, kind, type and timestamps that serializes to the
+ * compressed payload. All other operations are forwarded to the original.
+ *
+ * @param[in] codec  the codec
+ * @param[in] sd     serdata to compress
+ * @returns a new reference to a compressed serdata, or NULL if compressing did not reduce the size
+ */
+struct ddsi_serdata *ddsi_compress_serdata (const struct ddsi_compression_codec *codec, struct ddsi_serdata *sd)
+  ddsrt_nonnull_all;
+
+/**
+ * @brief The serdata to transmit to some or all of the matched readers of a writer
+ * @component compression
+ *
+ * The WHC always holds the uncompressed serdata, the compressed version is constructed
+ * the first time it is needed and kept in `*compressed`, normally the `xmit_serdata` of
+ * the borrowed WHC sample, so that a sample is compressed only once regardless of the
+ * number of (re)transmits. The payload is only sent compressed if all readers that it is
+ * sent to can decode it: the one proxy reader `prd` for a directed (re)transmit, all
+ * matched proxy readers otherwise.
+ *
+ * @param[in] wr             writer, wr->e.lock must be held
+ * @param[in] sd             serdata taken from the WHC
+ * @param[in,out] compressed NULL or the result of compressing `sd` earlier (`sd` itself if that didn't reduce the size)
+ * @param[in] prd            destination for a directed (re)transmit, NULL for a multicast one
+ * @returns a new reference to the compressed serdata or to `sd`
+ */
+struct ddsi_serdata *ddsi_writer_serdata_for_xmit (const struct ddsi_writer *wr, struct ddsi_serdata *sd, struct ddsi_serdata **compressed, const struct ddsi_proxy_reader *prd)
+  ddsrt_nonnull ((1, 2, 3));
+
+/**
+ * @brief Whether a received payload is compressed
+ * @component compression
+ *
+ * @param[in] codecs     codecs the proxy writer announced in discovery
+ * @param[in] fragchain  received payload
+ * @param[in] size       size of the received payload
+ * @returns true iff the payload is in the compressed format with one of `codecs`
+ */
+bool ddsi_payload_is_compressed (uint32_t codecs, const struct ddsi_rdata *fragchain, uint32_t size)
+  ddsrt_nonnull ((2));
+
+/**
+ * @brief Construct a serdata from a received compressed payload
+ * @component compression
+ *
+ * @param[in] gv         domain
+ * @param[in] type       sertype of the reader
+ * @param[in] kind       serdata kind
+ * @param[in] fragchain  received payload
+ * @param[in] size       size of the received payload
+ * @returns a new serdata or NULL if the payload was malformed or used an unknown codec
+ */
+struct ddsi_serdata *ddsi_decompress_serdata (const struct ddsi_domaingv *gv, const struct ddsi_sertype *type, enum ddsi_serdata_kind kind, const struct ddsi_rdata *fragchain, uint32_t size)
+  ddsrt_nonnull_all;
+
+/** @component compression */
+size_t ddsi_compression_lz_bound (size_t size);
+
+/** @component compression */
+size_t ddsi_compression_lz_compress (void *dst, const void *src, size_t srcsize);
+
+/** @component compression */
+bool ddsi_compression_lz_decompress (void *dst, size_t dstsize, const void *src, size_t srcsize);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI__COMPRESSION_H */
@@ -0,0 +1,137 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI__CONTENT_FILTER_H
+#define DDSI__CONTENT_FILTER_H
+
+#include <stdbool.h>
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_content_filter_if.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_writer;
+struct ddsi_proxy_reader;
+struct ddsi_wr_prd_match;
+struct ddsi_serdata;
+struct ddsi_addrset;
+
+/* Writer-side content filtering
+
+   Readers advertise their content filters in discovery and writers that can evaluate them
+   only send a sample to the readers that accept it.  Readers that don't accept it are told
+   so using a GAP, so they don't have to request a retransmit.
+
+   A GAP always affects all readers in a receiving domain instance because they share the
+   reordering administration of the proxy writer.  The readers are therefore grouped by the
+   address of their preferred unicast locator (ignoring the port number, which means all
+   readers on a machine end up in the same group) and the filters are evaluated for the
+   group as a whole: a sample is sent to the group if any of the readers in it accepts it
+   and only if none does, it is skipped and the readers in the group get a GAP instead.
+   The groups only exist as long as at least one matched reader has a content filter. */
+
+/** @component content_filter */
+ddsi_content_filter_property_t *ddsi_content_filter_property_dup (const ddsi_content_filter_property_t *cfp)
+  ddsrt_nonnull_all;
+
+/** @component content_filter */
+void ddsi_content_filter_property_free (ddsi_content_filter_property_t *cfp);
+
+/** @component content_filter */
+bool ddsi_content_filter_property_equal (const ddsi_content_filter_property_t *a, const ddsi_content_filter_property_t *b);
+
+/**
+ * @brief Initialize the content filter administration of a new writer
+ * @component content_filter
+ *
+ * @param[in] wr   writer
+ */
+void ddsi_writer_content_filter_init (struct ddsi_writer *wr);
+
+/**
+ * @brief Account for a newly matched proxy reader
+ * @component content_filter
+ *
+ * @param[in] wr   writer, lock must be held and "m" must already be in its set of readers
+ * @param[in] m    match, "content_filter" must be initialized
+ * @param[in] prd  the proxy reader
+ */
+void ddsi_writer_content_filter_add_reader (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m, const struct ddsi_proxy_reader *prd);
+
+/**
+ * @brief Account for a proxy reader that is no longer matched
+ * @component content_filter
+ *
+ * @param[in] wr   writer, lock must be held and "m" must already be removed from its set of readers
+ * @param[in] m    match
+ */
+void ddsi_writer_content_filter_remove_reader (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m);
+
+/**
+ * @brief Replace the filter of a matched proxy reader
+ * @component content_filter
+ *
+ * @param[in] wr      writer, lock must be held
+ * @param[in] m       match
+ * @param[in] filter  new writer-side filter (as returned by `ddsi_content_filter_compile`), ownership is transferred
+ */
+void ddsi_writer_content_filter_set (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m, void *filter);
+
+/**
+ * @brief Recompute the reader groups, e.g., after address changes of the readers
+ * @component content_filter
+ *
+ * @param[in] wr   writer, lock must be held
+ */
+void ddsi_writer_content_filter_rebuild (struct ddsi_writer *wr);
+
+/**
+ * @brief Determine where a new sample must be sent
+ * @component content_filter
+ *
+ * Evaluates the filters, updates the administration of what was sent to which reader and
+ * queues GAPs for readers that skipped samples in the meantime.
+ *
+ * @param[in] wr       writer, lock must be held and `num_content_filtered_readers` > 0
+ * @param[in] seq      sequence number of the sample
+ * @param[in] serdata  the sample
+ *
+ * @returns a new reference to the address set to send the sample to, or NULL if no reader accepts it
+ */
+struct ddsi_addrset *ddsi_writer_content_filter_select (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata);
+
+/**
+ * @brief Determine whether a sample requested by a reader should be retransmitted
+ * @component content_filter
+ *
+ * @param[in] wr       writer, lock must be held
+ * @param[in] m        match of the reader requesting the sample
+ * @param[in] seq      sequence number of the sample
+ * @param[in] serdata  the sample
+ *
+ * @returns true if it must be retransmitted, false if the reader should get a GAP
+ */
+bool ddsi_writer_content_filter_rexmit (const struct ddsi_writer *wr, const struct ddsi_wr_prd_match *m, ddsi_seqno_t seq, struct ddsi_serdata *serdata);
+
+/**
+ * @brief Free the content filter administration of a writer that is being deleted
+ * @component content_filter
+ *
+ * @param[in] wr   writer, no longer matched with any proxy reader
+ */
+void ddsi_writer_content_filter_fini (struct ddsi_writer *wr);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI__CONTENT_FILTER_H */
@@ -27,6 +27,7 @@ struct ddsi_type_pair;
 struct ddsi_entity_common;
 struct ddsi_endpoint_common;
 struct ddsi_alive_state;
+struct ddsi_proxy_reader;
 struct dds_qos;
 
 struct ddsi_ldur_fhnode {
@@ -53,6 +54,14 @@ inline void ddsi_writer_update_seq_xmit (struct ddsi_writer *wr, ddsi_seqno_t nv
 /** @component ddsi_endpoint */
 bool ddsi_is_local_orphan_endpoint (const struct ddsi_entity_common *e);
 
+/**
+ * @component ddsi_endpoint
+ *
+ * @param e a reader, writer, proxy reader or proxy writer
+ * @returns the QoS of the endpoint, NULL for other kinds of entities
+ */
+const dds_qos_t *ddsi_endpoint_xqos (const struct ddsi_entity_common *e);
+
 /** @component ddsi_endpoint */
 int ddsi_is_keyed_endpoint_entityid (ddsi_entityid_t id);
 
@@ -86,9 +95,35 @@ dds_return_t ddsi_delete_writer_nolinger (struct ddsi_domaingv *gv, const struct
 /** @component ddsi_endpoint */
 void ddsi_writer_get_alive_state (struct ddsi_writer *wr, struct ddsi_alive_state *st);
 
-/** @component ddsi_endpoint */
+/**
+ * @brief Fully recomputes the address set of a writer
+ * @component ddsi_endpoint
+ */
 void ddsi_rebuild_writer_addrset (struct ddsi_writer *wr);
 
+/**
+ * @brief Updates the address set of a writer for a newly matched reader
+ * @component ddsi_endpoint
+ *
+ * Adds addresses for the reader if needed, the full recomputation happens once
+ * the configured WriterAddressSetRecomputeDelay has passed.
+ *
+ * @param[in] wr   writer, lock must be held and reader must already be in its set of readers
+ * @param[in] prd  newly matched proxy reader
+ */
+void ddsi_writer_addrset_add_reader (struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd);
+
+/**
+ * @brief Updates the address set of a writer after a reader has been removed
+ * @component ddsi_endpoint
+ *
+ * Leaves the address set as it is, the full recomputation happens once the
+ * configured WriterAddressSetRecomputeDelay has passed.
+ *
+ * @param[in] wr   writer, lock must be held and reader must already have been removed
+ */
+void ddsi_writer_addrset_remove_reader (struct ddsi_writer *wr);
+
 /** @component ddsi_endpoint */
 void ddsi_writer_set_alive_may_unlock (struct ddsi_writer *wr, bool notify);
 
@@ -31,6 +31,7 @@ struct ddsi_proxy_writer;
 struct ddsi_proxy_reader;
 struct ddsi_alive_state;
 struct ddsi_generic_proxy_endpoint;
+struct ddsi_wr_cf_dest;
 
 struct ddsi_bestab {
   unsigned besflag;
@@ -92,15 +93,13 @@ struct ddsi_wr_prd_match {
   ddsi_guid_t prd_guid; /* guid of the proxy reader */
   unsigned assumed_in_sync: 1; /* set to 1 upon receipt of ack not nack'ing msgs */
   unsigned has_replied_to_hb: 1; /* we must keep sending HBs until all readers have this set */
-  unsigned all_have_replied_to_hb: 1; /* true iff 'has_replied_to_hb' for all readers in subtree */
   unsigned is_reliable: 1; /* true iff reliable proxy reader */
   unsigned via_psmx: 1; /* true iff there is a common psmx locator */
-  ddsi_seqno_t min_seq; /* smallest ack'd seq nr in subtree */
-  ddsi_seqno_t max_seq; /* sort-of highest ack'd seq nr in subtree (see augment function) */
-  ddsi_seqno_t seq; /* highest acknowledged seq nr */
+  ddsi_seqno_t seq; /* highest acknowledged seq nr, only to be changed via the writer's ack tracker */
   ddsi_seqno_t last_seq; /* highest seq send to this reader used when filter is applied */
-  uint32_t num_reliable_readers_where_seq_equals_max;
-  ddsi_guid_t arbitrary_unacked_reader;
+  void *content_filter; /* writer-side form of the reader's content filter, NULL if none */
+  struct ddsi_wr_cf_dest *cf_dest; /* destination shared with other readers, non-NULL iff writer->num_content_filtered_readers > 0 and not via PSMX */
+  struct ddsi_ack_group *ack_group; /* group in writer's ack tracker, NULL iff seq = DDSI_MAX_SEQ_NUMBER */
   ddsi_count_t prev_acknack; /* latest accepted acknack sequence number */
   ddsi_count_t prev_nackfrag; /* latest accepted nackfrag sequence number */
   ddsrt_etime_t t_acknack_accepted; /* (local) time an acknack was last accepted */
@@ -43,6 +43,25 @@ struct ddsi_match_entities_range_key {
 #endif
 };
 
+/* Node in the (kind, topic, partition, guid) index used for matching, a NULL
+   partition stands for the list of endpoints having wildcard partitions */
+struct ddsi_match_index_node {
+  ddsrt_avl_node_t avlnode;
+  struct ddsi_entity_common *entity;
+  const char *topic;
+  const char *partition;
+};
+
+struct ddsi_entity_enum_partition {
+  struct ddsi_entity_index *entidx;
+  struct ddsi_match_index_node *cur;
+  struct ddsi_entity_common max_entity;
+  struct ddsi_match_index_node max;
+#ifndef NDEBUG
+  ddsi_vtime_t vtime;
+#endif
+};
+
 struct ddsi_entity_enum_participant { struct ddsi_entity_enum st; };
 struct ddsi_entity_enum_writer { struct ddsi_entity_enum st; };
 struct ddsi_entity_enum_reader { struct ddsi_entity_enum st; };
@@ -103,6 +122,29 @@ void ddsi_entidx_enum_init_topic_w_prefix (struct ddsi_entity_enum *st, const st
 /** @component entity_index */
 void *ddsi_entidx_enum_next_max (struct ddsi_entity_enum *st, const struct ddsi_match_entities_range_key *max) ddsrt_nonnull_all;
 
+/**
+ * @component entity_index
+ * @brief Enumerates the endpoints of a kind and topic that are in the specified partition
+ *
+ * Only endpoints that list the partition by name are visited, the ones that have any
+ * wildcard partition can be enumerated by passing a null pointer as partition.  The
+ * default partition is indexed as "".  Like the other enumerators, this may visit
+ * entities that are in the process of being deleted.
+ *
+ * @param[out] st  enumerator state
+ * @param[in] ei  entity index
+ * @param[in] kind  endpoint kind
+ * @param[in] topic  topic name
+ * @param[in] partition  partition name or NULL for endpoints with wildcard partitions
+ */
+void ddsi_entidx_enum_partition_init (struct ddsi_entity_enum_partition *st, const struct ddsi_entity_index *ei, enum ddsi_entity_kind kind, const char *topic, const char *partition) ddsrt_nonnull ((1, 2, 4));
+
+/** @component entity_index */
+void *ddsi_entidx_enum_partition_next (struct ddsi_entity_enum_partition *st) ddsrt_nonnull_all;
+
+/** @component entity_index */
+void ddsi_entidx_enum_partition_fini (struct ddsi_entity_enum_partition *st) ddsrt_nonnull_all;
+
 
 /** @component entity_index */
 void ddsi_entidx_enum_writer_init (struct ddsi_entity_enum_writer *st, const struct ddsi_entity_index *ei) ddsrt_nonnull_all;
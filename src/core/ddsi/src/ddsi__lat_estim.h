@@ -27,7 +27,10 @@ void ddsi_lat_estim_fini (struct ddsi_lat_estim *le);
 /** @component latency_estim */
 void ddsi_lat_estim_update (struct ddsi_lat_estim *le, int64_t est);
 
-/** @component latency_estim */
+/**
+ * @brief Smoothed latency estimate in microseconds, 0 if none available yet
+ * @component latency_estim
+ */
 double ddsi_lat_estim_current (const struct ddsi_lat_estim *le);
 
 /** @component latency_estim */
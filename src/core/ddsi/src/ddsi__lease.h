@@ -23,9 +23,6 @@ extern "C" {
 struct ddsi_entity_common;
 struct ddsi_domaingv; /* FIXME: make a special for the lease admin */
 
-/** @component lease_handling */
-int ddsi_compare_lease_tsched (const void *va, const void *vb);
-
 /** @component lease_handling */
 int ddsi_compare_lease_tdur (const void *va, const void *vb);
 
@@ -68,6 +68,9 @@ int ddsi_guid_eq (const struct ddsi_guid *a, const struct ddsi_guid *b);
 /** @component misc */
 int ddsi_patmatch (const char *pat, const char *str);
 
+/** @component misc */
+bool ddsi_is_wildcard_partition (const char *str);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -0,0 +1,60 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSI__PACING_H
+#define DDSI__PACING_H
+
+#include "dds/features.h"
+#include "dds/ddsi/ddsi_pacing.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_config;
+
+/** @component outgoing_rtps */
+void ddsi_pacing_init (struct ddsi_pacing *p, const struct ddsi_config *config, bool enable, ddsrt_mtime_t tnow);
+
+/**
+ * @brief Take tokens for sending a sample of the given size
+ * @component outgoing_rtps
+ *
+ * @param[in,out] p       pacing state
+ * @param[in] config      configuration for the burst size
+ * @param[in] size        size of the sample in bytes
+ * @param[in] tnow        current time
+ * @returns the time in ns the caller must wait before sending, 0 if it may send immediately
+ */
+int64_t ddsi_pacing_take (struct ddsi_pacing *p, const struct ddsi_config *config, uint32_t size, ddsrt_mtime_t tnow);
+
+/**
+ * @brief Adjust the rate based on an ACKNACK
+ * @component outgoing_rtps
+ *
+ * @param[in,out] p       pacing state
+ * @param[in] config      configuration for the rate limits
+ * @param[in] nack        whether the ACKNACK requested a retransmit
+ * @param[in] tnow        current time
+ * @returns true iff the rate was decreased
+ */
+bool ddsi_pacing_note_acknack (struct ddsi_pacing *p, const struct ddsi_config *config, bool nack, ddsrt_mtime_t tnow);
+
+/** @component outgoing_rtps */
+void ddsi_pacing_note_rtt (struct ddsi_pacing *p, int64_t rtt);
+
+/** @component outgoing_rtps */
+uint64_t ddsi_pacing_achieved_rate (const struct ddsi_pacing *p, ddsrt_mtime_t tnow);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI__PACING_H */
@@ -369,6 +369,8 @@ typedef union ddsi_rtps_submessage {
 #define DDSI_PID_CYCLONE_TOPIC_GUID                  (DDSI_PID_VENDORSPECIFIC_FLAG | 0x1bu)
 #define DDSI_PID_CYCLONE_REQUESTS_KEYHASH            (DDSI_PID_VENDORSPECIFIC_FLAG | 0x1cu)
 #define DDSI_PID_CYCLONE_REDUNDANT_NETWORKING        (DDSI_PID_VENDORSPECIFIC_FLAG | 0x1du)
+#define DDSI_PID_CYCLONE_ACCEPTED_COMPRESSION        (DDSI_PID_VENDORSPECIFIC_FLAG | 0x1eu)
+#define DDSI_PID_CYCLONE_WRITER_COMPRESSION          (DDSI_PID_VENDORSPECIFIC_FLAG | 0x1fu)
 
 
 #if defined (__cplusplus)
@@ -122,6 +122,22 @@ enum ddsi_defrag_nackmap_result {
 /** @component receive_buffers */
 struct ddsi_rbufpool *ddsi_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size);
 
+/**
+ * @brief Creates a receive buffer pool that allocates each rmsg in a slab of its own
+ * @component receive_buffers
+ *
+ * A slab has room for a single rmsg of max_rmsg_size bytes, so an rmsg that
+ * is kept alive (e.g., because it is in a delivery queue) does not keep a
+ * whole receive buffer alive.  Slabs that become free are retained by the
+ * pool for reuse, by any thread, up to max_cached_slabs of them.
+ *
+ * @param logcfg            logging configuration
+ * @param max_rmsg_size     maximum size of an rmsg (ReceiveBufferChunkSize)
+ * @param max_cached_slabs  maximum number of free slabs retained, > 0
+ * @return pool, or NULL on allocation failure
+ */
+struct ddsi_rbufpool *ddsi_rbufpool_new_slab (const struct ddsrt_log_cfg *logcfg, uint32_t max_rmsg_size, uint32_t max_cached_slabs);
+
 /** @component receive_buffers */
 void ddsi_rbufpool_setowner (struct ddsi_rbufpool *rbp, ddsrt_thread_t tid);
 
@@ -131,6 +147,31 @@ void ddsi_rbufpool_free (struct ddsi_rbufpool *rbp);
 /** @component receive_buffers */
 struct ddsi_rmsg *ddsi_rmsg_new (struct ddsi_rbufpool *rbufpool);
 
+/**
+ * @brief Allocates up to n rmsgs for receiving a batch of packets at once
+ * @component receive_buffers
+ *
+ * The rmsgs are allocated consecutively in the current receive buffer, each
+ * with the full ReceiveBufferChunkSize, and so the number of rmsgs is limited
+ * by the space available in a receive buffer.  Each must be processed and
+ * committed as if allocated by @ref ddsi_rmsg_new, in order, and once all have
+ * been committed, @ref ddsi_rmsg_batch_done must be called.
+ *
+ * @param rbufpool  receive buffer pool, must be owned by the calling thread
+ * @param n         maximum number of rmsgs to allocate
+ * @param rmsgs     array of at least n entries receiving the rmsgs
+ * @return number of rmsgs allocated, 0 on allocation failure
+ */
+uint32_t ddsi_rmsg_new_batch (struct ddsi_rbufpool *rbufpool, uint32_t n, struct ddsi_rmsg **rmsgs);
+
+/**
+ * @brief Releases the unused space of a batch allocated with @ref ddsi_rmsg_new_batch
+ * @component receive_buffers
+ *
+ * @param rbufpool  receive buffer pool, must be owned by the calling thread
+ */
+void ddsi_rmsg_batch_done (struct ddsi_rbufpool *rbufpool);
+
 /** @component receive_buffers */
 void ddsi_rmsg_setsize (struct ddsi_rmsg *rmsg, uint32_t size);
 
@@ -168,6 +209,27 @@ struct ddsi_rsample *ddsi_defrag_rsample (struct ddsi_defrag *defrag, struct dds
 /** @component receive_buffers */
 void ddsi_defrag_notegap (struct ddsi_defrag *defrag, ddsi_seqno_t min, ddsi_seqno_t maxp1);
 
+/**
+ * @brief Reconstruct a missing block of a sample from XOR parity
+ * @component receive_buffers
+ *
+ * The parity is the XOR of nblocks consecutive blocks of blocksize bytes starting at
+ * offset begin in sample seq, where the last block of the sample may be shorter and is
+ * zero-padded.  If exactly one of those blocks is missing in the defragmenter, the data
+ * of the others is XOR-ed into parity so that it ends up containing the missing block.
+ *
+ * @param[in] defrag defragmenter
+ * @param[in] seq sequence number of the sample
+ * @param[in] begin offset of first block covered by the parity
+ * @param[in] blocksize size of the blocks
+ * @param[in] nblocks number of blocks covered by the parity
+ * @param[in,out] parity parity data, on success the data of the missing block
+ * @param[in] paritysize number of bytes in parity
+ * @param[out] recovered index of the recovered block, in [0,nblocks)
+ * @return true iff a block was recovered
+ */
+bool ddsi_defrag_fec_recover (const struct ddsi_defrag *defrag, ddsi_seqno_t seq, uint32_t begin, uint32_t blocksize, uint32_t nblocks, unsigned char *parity, uint32_t paritysize, uint32_t *recovered);
+
 /** @component receive_buffers */
 enum ddsi_defrag_nackmap_result ddsi_defrag_nackmap (struct ddsi_defrag *defrag, ddsi_seqno_t seq, uint32_t maxfragnum, struct ddsi_fragment_number_set_header *map, uint32_t *mapbits, uint32_t maxsz);
 
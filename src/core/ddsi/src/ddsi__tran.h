@@ -91,6 +91,7 @@ enum ddsi_tran_qos_purpose {
   DDSI_TRAN_QOS_XMIT_UC, ///< will send unicast only
   DDSI_TRAN_QOS_XMIT_MC, ///< may send unicast or multicast
   DDSI_TRAN_QOS_RECV_UC, ///< will be used for receiving unicast
+  DDSI_TRAN_QOS_RECV_UC_SHARED, ///< will be used for receiving unicast on a port shared with other sockets of this process
   DDSI_TRAN_QOS_RECV_MC  ///< will be used for receiving multicast
 };
 
@@ -101,9 +102,33 @@ struct ddsi_network_packet_info {
   uint32_t if_index;      ///< Interface over which packet was received, 0 if unknown
 };
 
+/// @brief Maximum number of packets that can be read in a single call to @ref ddsi_conn_read_multi
+#define DDSI_TRAN_READ_MULTI_MAX 64
+
+/// @brief Buffer for one of the packets read by @ref ddsi_conn_read_multi
+struct ddsi_tran_read_msg {
+  unsigned char *buf;     ///< Buffer to read the packet into
+  size_t len;             ///< Size of the buffer
+  ssize_t sz;             ///< Size of the packet received (output)
+  struct ddsi_network_packet_info pktinfo; ///< Packet info (output)
+};
+
+/// @brief Maximum number of packets that can be written in a single call to @ref ddsi_conn_write_multi
+#define DDSI_TRAN_WRITE_MULTI_MAX 64
+
+/// @brief One of the packets written by @ref ddsi_conn_write_multi
+struct ddsi_tran_write_msg {
+  const ddsi_locator_t *dst;  ///< Destination address
+  const ddsrt_iovec_t *iov;   ///< Contents of the packet
+  size_t niov;                ///< Number of entries in iov
+  size_t len;                 ///< Size of the packet (sum of iov lengths)
+};
+
 /* Function pointer types */
 typedef ssize_t (*ddsi_tran_read_fn_t) (struct ddsi_tran_conn *, unsigned char *, size_t, bool, struct ddsi_network_packet_info *pktinfo);
+typedef int (*ddsi_tran_read_multi_fn_t) (struct ddsi_tran_conn *, struct ddsi_tran_read_msg *, uint32_t);
 typedef ssize_t (*ddsi_tran_write_fn_t) (struct ddsi_tran_conn *, const ddsi_locator_t *, const ddsi_tran_write_msgfrags_t *, uint32_t);
+typedef uint32_t (*ddsi_tran_write_multi_fn_t) (struct ddsi_tran_conn *, const struct ddsi_tran_write_msg *, uint32_t, uint32_t);
 typedef int (*ddsi_tran_locator_fn_t) (struct ddsi_tran_factory *, struct ddsi_tran_base *, ddsi_locator_t *);
 typedef bool (*ddsi_tran_supports_fn_t) (const struct ddsi_tran_factory *, int32_t);
 typedef ddsrt_socket_t (*ddsi_tran_handle_fn_t) (struct ddsi_tran_base *);
@@ -176,7 +201,9 @@ struct ddsi_tran_conn
   /* Functions */
 
   ddsi_tran_read_fn_t m_read_fn;
+  ddsi_tran_read_multi_fn_t m_read_multi_fn; /* optional, NULL if not supported */
   ddsi_tran_write_fn_t m_write_fn;
+  ddsi_tran_write_multi_fn_t m_write_multi_fn; /* optional, NULL if not supported */
   ddsi_tran_peer_locator_fn_t m_peer_locator_fn;
   ddsi_tran_disable_multiplexing_fn_t m_disable_multiplexing_fn;
   ddsi_tran_locator_fn_t m_locator_fn;
@@ -392,11 +419,48 @@ inline ssize_t ddsi_conn_write (struct ddsi_tran_conn * conn, const ddsi_locator
   return conn->m_closed ? -1 : (conn->m_write_fn) (conn, dst, msgfrags, flags);
 }
 
+/**
+ * @brief Writes a batch of packets to a connectionless connection
+ * @component transport
+ *
+ * Equivalent to writing each of the packets in turn, but with fewer system
+ * calls.  Consecutive packets of equal size to the same destination may be
+ * handed to the network stack as a single super-packet that is segmented in
+ * the stack (UDP GSO).  Only available if the transport supports it, i.e., if
+ * m_write_multi_fn is not a null pointer.
+ *
+ * @param conn   connection to write to
+ * @param msgs   packets to write
+ * @param nmsgs  number of entries in msgs, at most DDSI_TRAN_WRITE_MULTI_MAX
+ * @param flags  as for @ref ddsi_conn_write
+ * @return number of packets successfully written
+ */
+inline uint32_t ddsi_conn_write_multi (struct ddsi_tran_conn * conn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs, uint32_t flags) {
+  return conn->m_closed ? 0 : conn->m_write_multi_fn (conn, msgs, nmsgs, flags);
+}
+
 /** @component transport */
 inline ssize_t ddsi_conn_read (struct ddsi_tran_conn * conn, unsigned char * buf, size_t len, bool allow_spurious, struct ddsi_network_packet_info *pktinfo) {
   return conn->m_closed ? -1 : conn->m_read_fn (conn, buf, len, allow_spurious, pktinfo);
 }
 
+/**
+ * @brief Reads a batch of packets from a connectionless connection
+ * @component transport
+ *
+ * Blocks until at least one packet is available, then reads as many as are
+ * available without blocking, up to nmsgs.  Only available if the transport
+ * supports it, i.e., if m_read_multi_fn is not a null pointer.
+ *
+ * @param conn   connection to read from
+ * @param msgs   array of buffers to read the packets into
+ * @param nmsgs  number of entries in msgs, at most DDSI_TRAN_READ_MULTI_MAX
+ * @return number of packets read (msgs[0 .. n-1] are valid), < 0 on error
+ */
+inline int ddsi_conn_read_multi (struct ddsi_tran_conn * conn, struct ddsi_tran_read_msg *msgs, uint32_t nmsgs) {
+  return conn->m_closed ? -1 : conn->m_read_multi_fn (conn, msgs, nmsgs);
+}
+
 /** @component transport */
 bool ddsi_conn_peer_locator (struct ddsi_tran_conn * conn, ddsi_locator_t * loc);
 
@@ -29,6 +29,8 @@ extern "C" {
 extern const ddsrt_avl_treedef_t ddsi_typelib_treedef;
 extern const ddsrt_avl_treedef_t ddsi_typedeps_treedef;
 extern const ddsrt_avl_treedef_t ddsi_typedeps_reverse_treedef;
+extern const ddsrt_avl_treedef_t ddsi_type_assignable_treedef;
+extern const ddsrt_avl_treedef_t ddsi_type_assignable_reverse_treedef;
 
 struct ddsi_domaingv;
 struct ddsi_sertype;
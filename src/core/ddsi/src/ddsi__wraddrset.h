@@ -20,10 +20,33 @@ extern "C" {
 #endif
 
 struct ddsi_writer;
+struct ddsi_proxy_reader;
 
 /** @component locators */
 struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr);
 
+/**
+ * @brief Computes the address set of a writer after adding a reader without reconsidering
+ * the choices made for the readers that are already covered by the writer's address set
+ * @component locators
+ *
+ * @param[in] wr   writer, lock must be held and reader must already be in its set of readers
+ * @param[in] prd  newly matched proxy reader
+ * @returns a new reference to an address set that covers all matched readers
+ */
+struct ddsi_addrset *ddsi_compute_writer_addrset_add_reader (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd);
+
+/**
+ * @brief Computes the address set a writer uses to reach a single reader, for sending
+ * data to a subset of the readers
+ * @component locators
+ *
+ * @param[in] wr   writer, lock must be held and reader must already be in its set of readers
+ * @param[in] prd  proxy reader
+ * @returns a new reference to an address set that covers the reader
+ */
+struct ddsi_addrset *ddsi_compute_writer_addrset_reader (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -58,6 +58,21 @@ dds_return_t ddsi_xeventq_start (struct ddsi_xeventq *evq, const char *name); /*
 /** @component timed_events */
 void ddsi_xeventq_stop (struct ddsi_xeventq *evq);
 
+/**
+ * @component timed_events
+ *
+ * Returns the event queue to use for the heartbeats, ACKNACKs and retransmits of
+ * a writer or proxy writer.  The assignment is fixed for a GUID, so all of the
+ * protocol messages of a single writer are handled by one thread.  Built-in
+ * endpoints are all on the main queue, so that the relative timing of the
+ * discovery traffic is not affected by the load of application writers.
+ *
+ * @param gv the domain
+ * @param guid GUID of the (proxy) writer
+ * @returns the main event queue or one of the endpoint event queues of the domain
+ */
+struct ddsi_xeventq *ddsi_xeventq_for_endpoint (const struct ddsi_domaingv *gv, const struct ddsi_guid *guid);
+
 /** @component timed_events */
 void ddsi_qxev_msg (struct ddsi_xeventq *evq, struct ddsi_xmsg *msg);
 
@@ -30,7 +30,6 @@ struct ddsi_proxy_reader;
 struct ddsi_proxy_writer;
 struct ddsi_writer;
 struct ddsi_participant;
-struct ddsi_xmsgpool;
 struct ddsi_xmsg;
 struct ddsi_xpack;
 struct ddsi_plist_sample;
@@ -46,31 +45,22 @@ enum ddsi_xmsg_kind {
   DDSI_XMSG_KIND_DATA_REXMIT_NOMERGE
 };
 
-/** @component rtps_submsg */
-struct ddsi_xmsgpool *ddsi_xmsgpool_new (void)
-  ddsrt_attribute_warn_unused_result;
-
-/** @component rtps_submsg */
-void ddsi_xmsgpool_free (struct ddsi_xmsgpool *pool)
-  ddsrt_nonnull_all;
-
 /**
- * @brief Allocates a new xmsg from the pool
+ * @brief Allocates a new xmsg
  * @component rtps_submsg
  *
  * if expected_size is NOT exceeded, no reallocs will be performed,
  * else the address of the xmsg may change because of reallocing
  * when appending to it.
  *
- * @param pool          message pool
  * @param src_guid      source guid
  * @param pp            participant
  * @param expected_size expected message size
  * @param kind          the xmsg kind
  * @return struct ddsi_xmsg*
  */
-struct ddsi_xmsg *ddsi_xmsg_new (struct ddsi_xmsgpool *pool, const ddsi_guid_t *src_guid, struct ddsi_participant *pp, size_t expected_size, enum ddsi_xmsg_kind kind)
-  ddsrt_nonnull ((1, 2)) ddsrt_attribute_warn_unused_result;
+struct ddsi_xmsg *ddsi_xmsg_new (const ddsi_guid_t *src_guid, struct ddsi_participant *pp, size_t expected_size, enum ddsi_xmsg_kind kind)
+  ddsrt_nonnull ((1)) ddsrt_attribute_warn_unused_result;
 
 /**
  * @brief For sending to a particular destination (participant)
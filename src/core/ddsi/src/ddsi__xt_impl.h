@@ -275,6 +275,15 @@ struct ddsi_type_dep {
   bool from_type_info;          // entry was added based on a dependent type in the type-info, requires unref of the dependent type on deletion
 };
 
+struct ddsi_type_assignable {
+  ddsrt_avl_node_t rd_avl_node;
+  ddsrt_avl_node_t wr_avl_node;
+  ddsi_typeid_t rd_type_id;     // reader type used in the assignability check
+  ddsi_typeid_t wr_type_id;     // writer type used in the assignability check
+  dds_type_consistency_enforcement_qospolicy_t tce;
+  bool assignable;              // outcome of the check, only cached for resolved types
+};
+
 struct ddsi_type {
   struct xt_type xt;                            /* wrapper for XTypes type id/obj */
   struct ddsi_domaingv *gv;
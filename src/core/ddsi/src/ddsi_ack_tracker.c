@@ -0,0 +1,190 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "ddsi__ack_tracker.h"
+#include "ddsi__endpoint_match.h"
+
+struct ddsi_ack_group {
+  struct ddsi_ack_group *prev, *next;
+  ddsi_seqno_t seq;       /* sequence number acknowledged by all readers in this group */
+  uint32_t count;         /* number of readers in this group */
+  uint32_t count_replied; /* number of readers in this group that replied to a heartbeat */
+};
+
+void ddsi_ack_tracker_init (struct ddsi_ack_tracker *tr)
+{
+  tr->head = tr->tail = NULL;
+  tr->freelist = NULL;
+  tr->n_not_replied = 0;
+}
+
+static void free_list (struct ddsi_ack_group *g)
+{
+  while (g)
+  {
+    struct ddsi_ack_group *next = g->next;
+    ddsrt_free (g);
+    g = next;
+  }
+}
+
+void ddsi_ack_tracker_fini (struct ddsi_ack_tracker *tr)
+{
+  assert (tr->head == NULL && tr->n_not_replied == 0);
+  free_list (tr->head);
+  free_list (tr->freelist);
+}
+
+static struct ddsi_ack_group *new_group (struct ddsi_ack_tracker *tr, ddsi_seqno_t seq, struct ddsi_ack_group *prev, struct ddsi_ack_group *next)
+{
+  struct ddsi_ack_group *g;
+  if ((g = tr->freelist) != NULL)
+    tr->freelist = g->next;
+  else
+    g = ddsrt_malloc (sizeof (*g));
+  g->seq = seq;
+  g->count = 0;
+  g->count_replied = 0;
+  g->prev = prev;
+  g->next = next;
+  if (prev)
+    prev->next = g;
+  else
+    tr->head = g;
+  if (next)
+    next->prev = g;
+  else
+    tr->tail = g;
+  return g;
+}
+
+static void join_group (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m, struct ddsi_ack_group *hint)
+{
+  const ddsi_seqno_t seq = m->seq;
+  struct ddsi_ack_group *g = hint ? hint : tr->head;
+  assert (seq < DDSI_MAX_SEQ_NUMBER);
+  // acks usually move forward by a little, so scanning from the old position visits few groups
+  if (g == NULL)
+    g = new_group (tr, seq, NULL, NULL);
+  else if (g->seq > seq)
+  {
+    while (g->prev && g->prev->seq >= seq)
+      g = g->prev;
+    if (g->seq != seq)
+      g = new_group (tr, seq, g->prev, g);
+  }
+  else
+  {
+    while (g->next && g->next->seq <= seq)
+      g = g->next;
+    if (g->seq != seq)
+      g = new_group (tr, seq, g, g->next);
+  }
+  g->count++;
+  if (m->has_replied_to_hb)
+    g->count_replied++;
+  m->ack_group = g;
+}
+
+static struct ddsi_ack_group *leave_group (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m)
+{
+  struct ddsi_ack_group * const g = m->ack_group;
+  assert (g && g->seq == m->seq && g->count > 0);
+  m->ack_group = NULL;
+  if (m->has_replied_to_hb)
+    g->count_replied--;
+  if (--g->count > 0)
+    return g;
+  struct ddsi_ack_group * const prev = g->prev;
+  if (prev)
+    prev->next = g->next;
+  else
+    tr->head = g->next;
+  if (g->next)
+    g->next->prev = prev;
+  else
+    tr->tail = prev;
+  g->next = tr->freelist;
+  tr->freelist = g;
+  return prev;
+}
+
+void ddsi_ack_tracker_insert (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m)
+{
+  if (!m->has_replied_to_hb)
+    tr->n_not_replied++;
+  // new readers usually start at the writer's current sequence number
+  m->ack_group = NULL;
+  if (m->seq < DDSI_MAX_SEQ_NUMBER)
+    join_group (tr, m, tr->tail);
+}
+
+void ddsi_ack_tracker_remove (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m)
+{
+  if (!m->has_replied_to_hb)
+    tr->n_not_replied--;
+  if (m->seq < DDSI_MAX_SEQ_NUMBER)
+    (void) leave_group (tr, m);
+}
+
+void ddsi_ack_tracker_update (struct ddsi_ack_tracker *tr, struct ddsi_wr_prd_match *m, ddsi_seqno_t seq, bool has_replied)
+{
+  if (m->has_replied_to_hb != has_replied)
+  {
+    if (has_replied)
+      tr->n_not_replied--;
+    else
+      tr->n_not_replied++;
+  }
+  if (seq == m->seq)
+  {
+    if (m->ack_group && m->has_replied_to_hb != has_replied)
+    {
+      if (has_replied)
+        m->ack_group->count_replied++;
+      else
+        m->ack_group->count_replied--;
+    }
+    m->has_replied_to_hb = has_replied;
+    return;
+  }
+
+  struct ddsi_ack_group *hint = tr->tail;
+  if (m->seq < DDSI_MAX_SEQ_NUMBER)
+    hint = leave_group (tr, m);
+  m->seq = seq;
+  m->has_replied_to_hb = has_replied;
+  if (seq < DDSI_MAX_SEQ_NUMBER)
+    join_group (tr, m, hint);
+}
+
+ddsi_seqno_t ddsi_ack_tracker_min_seq (const struct ddsi_ack_tracker *tr)
+{
+  return tr->head ? tr->head->seq : DDSI_MAX_SEQ_NUMBER;
+}
+
+ddsi_seqno_t ddsi_ack_tracker_max_seq (const struct ddsi_ack_tracker *tr)
+{
+  return tr->tail ? tr->tail->seq : 0;
+}
+
+uint32_t ddsi_ack_tracker_num_at_max_seq (const struct ddsi_ack_tracker *tr)
+{
+  return (tr->tail && tr->tail->seq > 0) ? tr->tail->count_replied : 0;
+}
+
+bool ddsi_ack_tracker_all_replied (const struct ddsi_ack_tracker *tr)
+{
+  return tr->n_not_replied == 0;
+}
@@ -275,6 +275,16 @@ void ddsi_remove_from_addrset (const struct ddsi_domaingv *gv, struct ddsi_addrs
   UNLOCK (as);
 }
 
+bool ddsi_addrset_contains_xlocator (const struct ddsi_domaingv *gv, const struct ddsi_addrset *as, const ddsi_xlocator_t *loc)
+{
+  const ddsrt_avl_ctree_t *tree = ddsi_is_mcaddr (gv, &loc->c) ? &as->mcaddrs : &as->ucaddrs;
+  bool found;
+  LOCK (as);
+  found = (ddsrt_avl_clookup (&addrset_treedef, tree, loc) != NULL);
+  UNLOCK (as);
+  return found;
+}
+
 void ddsi_copy_addrset_into_addrset_uc (const struct ddsi_domaingv *gv, struct ddsi_addrset *as, const struct ddsi_addrset *asadd)
 {
   struct ddsi_addrset_node *n;
@@ -0,0 +1,548 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <string.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/dynlib.h"
+#include "dds/ddsrt/bswap.h"
+#include "dds/ddsrt/strtol.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "dds/ddsi/ddsi_proxy_endpoint.h"
+#include "dds/ddsi/ddsi_radmin.h"
+#include "dds/ddsi/ddsi_log.h"
+#include "ddsi__compression.h"
+#include "ddsi__xqos.h"
+#include "ddsi__sysdeps.h"
+
+#define COMPRESSION_THRESHOLD_PROP "cyclonedds.compression.threshold"
+
+struct ddsi_compression {
+  const struct ddsi_compression_codec *writer_codec; // NULL if writers don't compress
+  struct ddsi_compression_codec *plugin;
+  ddsrt_dynlib_t plugin_handle;
+};
+
+/* Built-in codec: a simple LZ77 variant in the style of LZ4, it favours speed over ratio.
+   The compressed data is a sequence of (literals, match) pairs:
+
+   - token: high nibble is the number of literals, low nibble the match length - 4, a
+     nibble of 15 is followed by bytes that add to it up to and including the first one
+     that is not 255
+   - literals
+   - 2-byte little-endian offset of the match (backwards from the current position)
+
+   The final pair has only literals, the end of the input marks its end. */
+
+#define LZ_HASH_BITS 12
+#define LZ_MINMATCH 4
+#define LZ_MAX_OFFSET 65535
+
+static uint32_t lz_read32 (const unsigned char *p)
+{
+  uint32_t v;
+  memcpy (&v, p, sizeof (v));
+  return v;
+}
+
+static uint32_t lz_hash (uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static unsigned char *lz_put_length (unsigned char *op, size_t len)
+{
+  while (len >= 255)
+  {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (unsigned char) len;
+  return op;
+}
+
+static unsigned char *lz_put_literals (unsigned char *op, const unsigned char *lit, size_t nlit, size_t mlen)
+{
+  const size_t mcode = (mlen >= LZ_MINMATCH) ? mlen - LZ_MINMATCH : 0;
+  *op++ = (unsigned char) (((nlit < 15 ? nlit : 15) << 4) | (mcode < 15 ? mcode : 15));
+  if (nlit >= 15)
+    op = lz_put_length (op, nlit - 15);
+  memcpy (op, lit, nlit);
+  return op + nlit;
+}
+
+size_t ddsi_compression_lz_bound (size_t size)
+{
+  return size + size / 255 + 16;
+}
+
+size_t ddsi_compression_lz_compress (void *vdst, const void *vsrc, size_t srcsize)
+{
+  const unsigned char * const src = vsrc;
+  const unsigned char * const iend = src + srcsize;
+  const unsigned char *ip = src, *anchor = src;
+  unsigned char * const dst = vdst;
+  unsigned char * const oend = dst + ddsi_compression_lz_bound (srcsize);
+  unsigned char *op = dst;
+  uint32_t table[1u << LZ_HASH_BITS];
+
+  if (srcsize > UINT32_MAX)
+    return 0;
+  memset (table, 0, sizeof (table));
+  while (ip + LZ_MINMATCH <= iend)
+  {
+    const uint32_t seq = lz_read32 (ip);
+    const uint32_t h = lz_hash (seq);
+    const unsigned char *ref = src + table[h];
+    table[h] = (uint32_t) (ip - src);
+    if (ref >= ip || ip - ref > LZ_MAX_OFFSET || lz_read32 (ref) != seq)
+    {
+      ip++;
+      continue;
+    }
+
+    const unsigned char *mp = ip + LZ_MINMATCH, *rp = ref + LZ_MINMATCH;
+    while (mp < iend && *mp == *rp)
+      mp++, rp++;
+    const size_t nlit = (size_t) (ip - anchor), mlen = (size_t) (mp - ip);
+    // token, literal length, literals, offset, match length
+    if ((size_t) (oend - op) < 1 + nlit / 255 + 1 + nlit + 2 + mlen / 255 + 1)
+      return 0;
+    op = lz_put_literals (op, anchor, nlit, mlen);
+    const size_t off = (size_t) (ip - ref);
+    *op++ = (unsigned char) (off & 0xff);
+    *op++ = (unsigned char) (off >> 8);
+    if (mlen - LZ_MINMATCH >= 15)
+      op = lz_put_length (op, mlen - LZ_MINMATCH - 15);
+    ip = anchor = mp;
+    // the tail of the match is a good candidate for the next one
+    if (ip + LZ_MINMATCH <= iend)
+      table[lz_hash (lz_read32 (ip - 2))] = (uint32_t) (ip - 2 - src);
+  }
+
+  const size_t nlit = (size_t) (iend - anchor);
+  if ((size_t) (oend - op) < 1 + nlit / 255 + 1 + nlit)
+    return 0;
+  op = lz_put_literals (op, anchor, nlit, 0);
+  return (size_t) (op - dst);
+}
+
+static bool lz_get_length (const unsigned char **ip, const unsigned char *iend, size_t *len)
+{
+  unsigned char b;
+  do {
+    if (*ip == iend || *len > SIZE_MAX - 255)
+      return false;
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return true;
+}
+
+bool ddsi_compression_lz_decompress (void *vdst, size_t dstsize, const void *vsrc, size_t srcsize)
+{
+  const unsigned char *ip = vsrc;
+  const unsigned char * const iend = ip + srcsize;
+  unsigned char * const dst = vdst;
+  unsigned char * const oend = dst + dstsize;
+  unsigned char *op = dst;
+
+  while (ip < iend)
+  {
+    const unsigned token = *ip++;
+    size_t len = token >> 4;
+    if (len == 15 && !lz_get_length (&ip, iend, &len))
+      return false;
+    if (len > (size_t) (iend - ip) || len > (size_t) (oend - op))
+      return false;
+    memcpy (op, ip, len);
+    ip += len;
+    op += len;
+    if (ip == iend)
+      break;
+
+    if (iend - ip < 2)
+      return false;
+    const size_t off = (size_t) ip[0] | ((size_t) ip[1] << 8);
+    ip += 2;
+    if (off == 0 || off > (size_t) (op - dst))
+      return false;
+    len = token & 15;
+    if (len == 15 && !lz_get_length (&ip, iend, &len))
+      return false;
+    len += LZ_MINMATCH;
+    if (len > (size_t) (oend - op))
+      return false;
+    // source and destination may overlap, which is how runs are encoded
+    const unsigned char *ref = op - off;
+    while (len--)
+      *op++ = *ref++;
+  }
+  return op == oend;
+}
+
+static size_t lz_codec_bound (const struct ddsi_compression_codec *codec, size_t size)
+{
+  (void) codec;
+  return ddsi_compression_lz_bound (size);
+}
+
+static size_t lz_codec_compress (const struct ddsi_compression_codec *codec, void *dst, const void *src, size_t srcsize)
+{
+  (void) codec;
+  return ddsi_compression_lz_compress (dst, src, srcsize);
+}
+
+static bool lz_codec_decompress (const struct ddsi_compression_codec *codec, void *dst, size_t dstsize, const void *src, size_t srcsize)
+{
+  (void) codec;
+  return ddsi_compression_lz_decompress (dst, dstsize, src, srcsize);
+}
+
+static const struct ddsi_compression_codec lz_codec = {
+  .id = DDSI_COMPRESSION_CODEC_LZ,
+  .name = "lz",
+  .bound = lz_codec_bound,
+  .compress = lz_codec_compress,
+  .decompress = lz_codec_decompress,
+  .fini = 0
+};
+
+static dds_return_t load_plugin (struct ddsi_domaingv *gv, struct ddsi_compression *comp)
+{
+  const char *codec_name = gv->config.compression_codec;
+  const char *lib_name = (gv->config.compression_library && *gv->config.compression_library) ? gv->config.compression_library : codec_name;
+  ddsi_compression_create_fn creator;
+  char load_fn[100];
+  dds_return_t ret;
+
+  if ((ret = ddsrt_dlopen (lib_name, true, &comp->plugin_handle)) != DDS_RETCODE_OK)
+  {
+    char buf[256];
+    (void) ddsrt_dlerror (buf, sizeof (buf));
+    GVERROR ("Failed to load compression library '%s' with error \"%s\".\n", lib_name, buf);
+    return ret;
+  }
+  (void) snprintf (load_fn, sizeof (load_fn), "%s_create_compression_codec", codec_name);
+  if ((ret = ddsrt_dlsym (comp->plugin_handle, load_fn, (void **) &creator)) != DDS_RETCODE_OK)
+  {
+    GVERROR ("Failed to initialize compression codec '%s', could not load init function '%s'.\n", codec_name, load_fn);
+    goto err;
+  }
+  if ((ret = creator (&comp->plugin, gv->config.compression_config ? gv->config.compression_config : "")) != DDS_RETCODE_OK)
+  {
+    GVERROR ("Failed to initialize compression codec '%s'.\n", codec_name);
+    goto err;
+  }
+  if (comp->plugin->id == DDSI_COMPRESSION_CODEC_LZ || comp->plugin->id > DDSI_COMPRESSION_CODEC_ID_MAX)
+  {
+    GVERROR ("Compression codec '%s' uses invalid id %"PRIu32".\n", codec_name, comp->plugin->id);
+    if (comp->plugin->fini)
+      comp->plugin->fini (comp->plugin);
+    comp->plugin = NULL;
+    ret = DDS_RETCODE_BAD_PARAMETER;
+    goto err;
+  }
+  return DDS_RETCODE_OK;
+
+err:
+  (void) ddsrt_dlclose (comp->plugin_handle);
+  return ret;
+}
+
+dds_return_t ddsi_compression_init (struct ddsi_domaingv *gv)
+{
+  struct ddsi_compression *comp = ddsrt_malloc (sizeof (*comp));
+  comp->writer_codec = NULL;
+  comp->plugin = NULL;
+  if (gv->config.compression_codec == NULL || *gv->config.compression_codec == '\0')
+    ; // readers can still decode the built-in one
+  else if (strcmp (gv->config.compression_codec, lz_codec.name) == 0)
+    comp->writer_codec = &lz_codec;
+  else
+  {
+    dds_return_t ret;
+    if ((ret = load_plugin (gv, comp)) != DDS_RETCODE_OK)
+    {
+      ddsrt_free (comp);
+      return ret;
+    }
+    comp->writer_codec = comp->plugin;
+  }
+  if (comp->writer_codec)
+    GVLOG (DDS_LC_CONFIG, "compression: codec %s (id %"PRIu32") threshold %"PRIu32"\n", comp->writer_codec->name, comp->writer_codec->id, gv->config.compression_threshold);
+  gv->compression = comp;
+  return DDS_RETCODE_OK;
+}
+
+void ddsi_compression_fini (struct ddsi_domaingv *gv)
+{
+  struct ddsi_compression * const comp = gv->compression;
+  if (comp->plugin)
+  {
+    if (comp->plugin->fini)
+      comp->plugin->fini (comp->plugin);
+    (void) ddsrt_dlclose (comp->plugin_handle);
+  }
+  ddsrt_free (comp);
+  gv->compression = NULL;
+}
+
+uint32_t ddsi_compression_accepted (const struct ddsi_domaingv *gv)
+{
+  uint32_t mask = 1u << DDSI_COMPRESSION_CODEC_LZ;
+  if (gv->compression->plugin)
+    mask |= 1u << gv->compression->plugin->id;
+  return mask;
+}
+
+static const struct ddsi_compression_codec *lookup_codec (const struct ddsi_domaingv *gv, uint32_t id)
+{
+  if (id == DDSI_COMPRESSION_CODEC_LZ)
+    return &lz_codec;
+  else if (gv->compression->plugin && gv->compression->plugin->id == id)
+    return gv->compression->plugin;
+  else
+    return NULL;
+}
+
+const struct ddsi_compression_codec *ddsi_compression_codec_for_writer (const struct ddsi_domaingv *gv, const struct dds_qos *xqos, uint32_t *threshold)
+{
+  const char *value;
+  *threshold = gv->config.compression_threshold;
+  if (gv->compression->writer_codec == NULL)
+    return NULL;
+  if (ddsi_xqos_find_prop (xqos, COMPRESSION_THRESHOLD_PROP, &value))
+  {
+    unsigned long long v;
+    char *endp;
+    if (ddsrt_strtoull (value, &endp, 0, &v) == DDS_RETCODE_OK && *endp == '\0' && v <= UINT32_MAX)
+      *threshold = (uint32_t) v;
+    else
+      GVWARNING ("ignoring invalid value \"%s\" for property %s\n", value, COMPRESSION_THRESHOLD_PROP);
+  }
+  return gv->compression->writer_codec;
+}
+
+bool ddsi_writer_compression_accepted_by (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd)
+{
+  return wr->compression_codec != NULL && (prd->accepted_compression & (1u << wr->compression_codec->id)) != 0;
+}
+
+/* A compressed serdata is a wrapper around the original one that only differs in its
+   serialized representation. It is constructed for (re)transmitting a sample from the WHC,
+   everything else is forwarded to the original. */
+
+struct ddsi_serdata_compressed {
+  struct ddsi_serdata c;
+  struct ddsi_serdata *orig;
+  uint32_t size;
+  unsigned char data[];
+};
+
+static const struct ddsi_serdata_ops ddsi_serdata_ops_compressed;
+
+static struct ddsi_serdata *unwrap (const struct ddsi_serdata *sd)
+{
+  if (sd->ops == &ddsi_serdata_ops_compressed)
+    return ((const struct ddsi_serdata_compressed *) sd)->orig;
+  return (struct ddsi_serdata *) sd;
+}
+
+static bool serdata_compressed_eqkey (const struct ddsi_serdata *a, const struct ddsi_serdata *b)
+{
+  const struct ddsi_serdata *ua = unwrap (a), *ub = unwrap (b);
+  return ua->ops->eqkey (ua, ub);
+}
+
+static uint32_t serdata_compressed_get_size (const struct ddsi_serdata *d)
+{
+  return ((const struct ddsi_serdata_compressed *) d)->size;
+}
+
+static void serdata_compressed_free (struct ddsi_serdata *d)
+{
+  struct ddsi_serdata_compressed *cd = (struct ddsi_serdata_compressed *) d;
+  ddsi_serdata_unref (cd->orig);
+  ddsrt_free (cd);
+}
+
+static void serdata_compressed_to_ser (const struct ddsi_serdata *d, size_t off, size_t sz, void *buf)
+{
+  const struct ddsi_serdata_compressed *cd = (const struct ddsi_serdata_compressed *) d;
+  assert (off + sz <= cd->size);
+  memcpy (buf, cd->data + off, sz);
+}
+
+static struct ddsi_serdata *serdata_compressed_to_ser_ref (const struct ddsi_serdata *d, size_t off, size_t sz, ddsrt_iovec_t *ref)
+{
+  const struct ddsi_serdata_compressed *cd = (const struct ddsi_serdata_compressed *) d;
+  assert (off + sz <= cd->size);
+  ref->iov_base = (unsigned char *) cd->data + off;
+  ref->iov_len = (ddsrt_iov_len_t) sz;
+  return ddsi_serdata_ref (d);
+}
+
+static void serdata_compressed_to_ser_unref (struct ddsi_serdata *d, const ddsrt_iovec_t *ref)
+{
+  (void) ref;
+  ddsi_serdata_unref (d);
+}
+
+static bool serdata_compressed_to_sample (const struct ddsi_serdata *d, void *sample, void **bufptr, void *buflim)
+{
+  return ddsi_serdata_to_sample (unwrap (d), sample, bufptr, buflim);
+}
+
+static struct ddsi_serdata *serdata_compressed_to_untyped (const struct ddsi_serdata *d)
+{
+  return ddsi_serdata_to_untyped (unwrap (d));
+}
+
+static size_t serdata_compressed_print (const struct ddsi_sertype *type, const struct ddsi_serdata *d, char *buf, size_t size)
+{
+  (void) type;
+  return ddsi_serdata_print (unwrap (d), buf, size);
+}
+
+static void serdata_compressed_get_keyhash (const struct ddsi_serdata *d, struct ddsi_keyhash *buf, bool force_md5)
+{
+  ddsi_serdata_get_keyhash (unwrap (d), buf, force_md5);
+}
+
+static const struct ddsi_serdata_ops ddsi_serdata_ops_compressed = {
+  .eqkey = serdata_compressed_eqkey,
+  .get_size = serdata_compressed_get_size,
+  .from_ser = 0,
+  .from_ser_iov = 0,
+  .from_keyhash = 0,
+  .from_sample = 0,
+  .to_ser = serdata_compressed_to_ser,
+  .to_ser_ref = serdata_compressed_to_ser_ref,
+  .to_ser_unref = serdata_compressed_to_ser_unref,
+  .to_sample = serdata_compressed_to_sample,
+  .to_untyped = serdata_compressed_to_untyped,
+  .untyped_to_sample = 0,
+  .free = serdata_compressed_free,
+  .print = serdata_compressed_print,
+  .get_keyhash = serdata_compressed_get_keyhash,
+  .from_loaned_sample = 0,
+  .from_psmx = 0
+};
+
+struct ddsi_serdata *ddsi_compress_serdata (const struct ddsi_compression_codec *codec, struct ddsi_serdata *sd)
+{
+  const uint32_t size = ddsi_serdata_size (sd);
+  if (size < 4 || sd->ops == &ddsi_serdata_ops_compressed)
+    return NULL;
+
+  // payload layout: marker, codec id, 2 bytes options with the padding in the low 2 bits,
+  // the original encoding header, the uncompressed size (big-endian), compressed data
+  const size_t bound = codec->bound (codec, size - 4);
+  struct ddsi_serdata_compressed *cd = ddsrt_malloc (sizeof (*cd) + DDSI_COMPRESSION_HDR_SIZE + bound + 3);
+  ddsrt_iovec_t iov;
+  struct ddsi_serdata * const ref = ddsi_serdata_to_ser_ref (sd, 0, size, &iov);
+  const unsigned char *orig = iov.iov_base;
+  const size_t csize = codec->compress (codec, cd->data + DDSI_COMPRESSION_HDR_SIZE, orig + 4, size - 4);
+  if (csize == 0 || csize + DDSI_COMPRESSION_HDR_SIZE + 3 >= size)
+  {
+    ddsi_serdata_to_ser_unref (ref, &iov);
+    ddsrt_free (cd);
+    return NULL;
+  }
+  const uint32_t pad = (uint32_t) ((4 - (csize % 4)) % 4);
+  cd->data[0] = DDSI_COMPRESSION_MARKER;
+  cd->data[1] = (unsigned char) codec->id;
+  cd->data[2] = 0;
+  cd->data[3] = (unsigned char) pad;
+  memcpy (cd->data + 4, orig, 4);
+  const uint32_t usize_be = ddsrt_toBE4u (size);
+  memcpy (cd->data + 8, &usize_be, 4);
+  memset (cd->data + DDSI_COMPRESSION_HDR_SIZE + csize, 0, pad);
+  ddsi_serdata_to_ser_unref (ref, &iov);
+
+  ddsi_serdata_init (&cd->c, sd->type, sd->kind);
+  cd->c.ops = &ddsi_serdata_ops_compressed;
+  cd->c.hash = sd->hash;
+  cd->c.timestamp = sd->timestamp;
+  cd->c.statusinfo = sd->statusinfo;
+  cd->c.twrite = sd->twrite;
+  cd->orig = ddsi_serdata_ref (sd);
+  cd->size = (uint32_t) (DDSI_COMPRESSION_HDR_SIZE + csize + pad);
+  return &cd->c;
+}
+
+struct ddsi_serdata *ddsi_writer_serdata_for_xmit (const struct ddsi_writer *wr, struct ddsi_serdata *sd, struct ddsi_serdata **compressed, const struct ddsi_proxy_reader *prd)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  if (wr->compression_codec == NULL || sd->kind != SDK_DATA || ddsi_serdata_size (sd) < wr->compression_threshold)
+    return ddsi_serdata_ref (sd);
+  if (prd ? !ddsi_writer_compression_accepted_by (wr, prd) : (wr->num_readers == 0 || wr->num_readers_accepting_compression != wr->num_readers))
+    return ddsi_serdata_ref (sd);
+  // reusing the result means fragments of a retransmit match those sent before; an
+  // incompressible sample is remembered as itself so it isn't tried again either
+  if (*compressed == NULL && (*compressed = ddsi_compress_serdata (wr->compression_codec, sd)) == NULL)
+    *compressed = ddsi_serdata_ref (sd);
+  assert (unwrap (*compressed) == sd);
+  return ddsi_serdata_ref (*compressed);
+}
+
+bool ddsi_payload_is_compressed (uint32_t codecs, const struct ddsi_rdata *fragchain, uint32_t size)
+{
+  // the first byte of a compressed payload is never valid in an uncompressed one, but
+  // that doesn't hold for non-Cyclone writers and a future standardised encoding, so
+  // only writers that announced they compress get their payload interpreted this way
+  if (codecs == 0 || size < DDSI_COMPRESSION_HDR_SIZE || fragchain->maxp1 < 2)
+    return false;
+  const unsigned char *payload = DDSI_RMSG_PAYLOADOFF (fragchain->rmsg, DDSI_RDATA_PAYLOAD_OFF (fragchain));
+  return payload[0] == DDSI_COMPRESSION_MARKER && payload[1] <= DDSI_COMPRESSION_CODEC_ID_MAX && (codecs & (1u << payload[1])) != 0;
+}
+
+struct ddsi_serdata *ddsi_decompress_serdata (const struct ddsi_domaingv *gv, const struct ddsi_sertype *type, enum ddsi_serdata_kind kind, const struct ddsi_rdata *fragchain, uint32_t size)
+{
+  struct ddsi_serdata *sd = NULL;
+  unsigned char *cbuf, *ubuf;
+  uint32_t off = 0;
+
+  assert (fragchain->min == 0);
+  cbuf = ddsrt_malloc (size);
+  for (const struct ddsi_rdata *frag = fragchain; frag != NULL; frag = frag->nextfrag)
+  {
+    assert (frag->min <= off);
+    assert (frag->maxp1 <= size);
+    if (frag->maxp1 > off)
+    {
+      const unsigned char *payload = DDSI_RMSG_PAYLOADOFF (frag->rmsg, DDSI_RDATA_PAYLOAD_OFF (frag));
+      memcpy (cbuf + off, payload + off - frag->min, frag->maxp1 - off);
+      off = frag->maxp1;
+    }
+  }
+
+  const struct ddsi_compression_codec *codec;
+  uint32_t usize_be, usize;
+  const uint32_t pad = cbuf[3] & 3;
+  memcpy (&usize_be, cbuf + 8, 4);
+  usize = ddsrt_fromBE4u (usize_be);
+  if (off != size || (codec = lookup_codec (gv, cbuf[1])) == NULL || usize < 4 || usize > gv->config.max_sample_size || size - DDSI_COMPRESSION_HDR_SIZE < pad)
+    goto err_hdr;
+  ubuf = ddsrt_malloc (usize);
+  memcpy (ubuf, cbuf + 4, 4);
+  if (codec->decompress (codec, ubuf + 4, usize - 4, cbuf + DDSI_COMPRESSION_HDR_SIZE, size - DDSI_COMPRESSION_HDR_SIZE - pad))
+  {
+    const ddsrt_iovec_t iov = { .iov_base = ubuf, .iov_len = (ddsrt_iov_len_t) usize };
+    sd = ddsi_serdata_from_ser_iov (type, kind, 1, &iov, usize);
+  }
+  ddsrt_free (ubuf);
+err_hdr:
+  ddsrt_free (cbuf);
+  return sd;
+}
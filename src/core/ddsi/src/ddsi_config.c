@@ -163,6 +163,7 @@ DUPF(uint32);
 DU(natint);
 DU(natint_255);
 DU(pos_uint);
+DU(pos_uint_64);
 DUPF(participantIndex);
 DU(dyn_port);
 DUPF(memsize);
@@ -1424,16 +1425,26 @@ static enum update_result uf_uint (struct ddsi_cfgst *cfgst, void *parent, struc
   return URES_SUCCESS;
 }
 
-static enum update_result uf_pos_uint (struct ddsi_cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
+static enum update_result uf_uint_min_max (struct ddsi_cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value, uint32_t min, uint32_t max)
 {
   uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
   int64_t x;
-  if (uf_int64_unit (cfgst, &x, value, NULL, 1, 1, UINT32_MAX) != URES_SUCCESS)
+  if (uf_int64_unit (cfgst, &x, value, NULL, 1, min, max) != URES_SUCCESS)
     return URES_ERROR;
   *elem = (uint32_t) x;
   return URES_SUCCESS;
 }
 
+static enum update_result uf_pos_uint (struct ddsi_cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  return uf_uint_min_max (cfgst, parent, cfgelem, first, value, 1, UINT32_MAX);
+}
+
+static enum update_result uf_pos_uint_64 (struct ddsi_cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  return uf_uint_min_max (cfgst, parent, cfgelem, first, value, 1, 64);
+}
+
 static void pf_uint (struct ddsi_cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, uint32_t sources)
 {
   uint32_t const * const p = cfg_address (cfgst, parent, cfgelem);
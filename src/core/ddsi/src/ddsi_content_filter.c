@@ -0,0 +1,342 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/avl.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "dds/ddsi/ddsi_proxy_endpoint.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "ddsi__content_filter.h"
+#include "ddsi__endpoint_match.h"
+#include "ddsi__entity_index.h"
+#include "ddsi__addrset.h"
+#include "ddsi__wraddrset.h"
+#include "ddsi__receive.h"
+#include "ddsi__xevent.h"
+#include "ddsi__plist.h"
+#include "ddsi__sysdeps.h"
+
+extern inline void *ddsi_content_filter_compile (const struct ddsi_content_filter_interface *cfif, const struct ddsi_sertype *type, const struct ddsi_content_filter_property *cfp);
+extern inline bool ddsi_content_filter_accepts (const struct ddsi_content_filter_interface *cfif, const void *filter, const struct ddsi_serdata *serdata);
+extern inline void ddsi_content_filter_free (const struct ddsi_content_filter_interface *cfif, void *filter);
+
+struct ddsi_wr_cf_dest {
+  ddsrt_avl_node_t avlnode;
+  ddsi_locator_t loc; /* kind + address of the preferred unicast locator of the readers, port 0 */
+  uint32_t refc; /* number of matched readers with this destination */
+  bool accepts; /* whether some reader accepts the sample currently being written */
+  struct ddsi_addrset *as; /* addresses covering all readers with this destination */
+};
+
+static int compare_locators_vwrap (const void *va, const void *vb)
+{
+  return ddsi_compare_locators (va, vb);
+}
+
+static const ddsrt_avl_treedef_t wr_cf_dests_treedef =
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_wr_cf_dest, avlnode), offsetof (struct ddsi_wr_cf_dest, loc), compare_locators_vwrap, 0);
+
+static void cfp_to_plist (ddsi_plist_t *ps, const ddsi_content_filter_property_t *cfp, bool aliased)
+{
+  ddsi_plist_init_empty (ps);
+  ps->present = PP_CONTENT_FILTER_PROPERTY;
+  ps->aliased = aliased ? PP_CONTENT_FILTER_PROPERTY : 0;
+  ps->content_filter_property = *cfp;
+}
+
+ddsi_content_filter_property_t *ddsi_content_filter_property_dup (const ddsi_content_filter_property_t *cfp)
+{
+  ddsi_plist_t src, dst;
+  cfp_to_plist (&src, cfp, true);
+  ddsi_plist_init_empty (&dst);
+  ddsi_plist_mergein_missing (&dst, &src, PP_CONTENT_FILTER_PROPERTY, 0);
+  assert (dst.aliased == 0);
+  ddsi_content_filter_property_t *x = ddsrt_malloc (sizeof (*x));
+  *x = dst.content_filter_property;
+  return x;
+}
+
+void ddsi_content_filter_property_free (ddsi_content_filter_property_t *cfp)
+{
+  if (cfp == NULL)
+    return;
+  ddsi_plist_t ps;
+  cfp_to_plist (&ps, cfp, false);
+  ddsi_plist_fini (&ps);
+  ddsrt_free (cfp);
+}
+
+bool ddsi_content_filter_property_equal (const ddsi_content_filter_property_t *a, const ddsi_content_filter_property_t *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+  ddsi_plist_t x, y;
+  uint64_t pdelta, qdelta;
+  cfp_to_plist (&x, a, true);
+  cfp_to_plist (&y, b, true);
+  ddsi_plist_delta (&pdelta, &qdelta, &x, &y, PP_CONTENT_FILTER_PROPERTY, 0);
+  return pdelta == 0;
+}
+
+void ddsi_writer_content_filter_init (struct ddsi_writer *wr)
+{
+  wr->num_content_filtered_readers = 0;
+  ddsrt_avl_init (&wr_cf_dests_treedef, &wr->cf_dests);
+}
+
+static void free_dest (void *vd)
+{
+  struct ddsi_wr_cf_dest *d = vd;
+  ddsi_unref_addrset (d->as);
+  ddsrt_free (d);
+}
+
+static void attach_dest (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m, const struct ddsi_proxy_reader *prd)
+{
+  // data for readers reached via PSMX doesn't go over the network, and so these readers
+  // don't have a destination
+  m->cf_dest = NULL;
+  if (m->via_psmx)
+    return;
+
+  ddsi_locator_t loc = prd->c.loc_uc.c;
+  loc.port = 0;
+  ddsrt_avl_ipath_t path;
+  struct ddsi_wr_cf_dest *d;
+  if ((d = ddsrt_avl_lookup_ipath (&wr_cf_dests_treedef, &wr->cf_dests, &loc, &path)) == NULL)
+  {
+    d = ddsrt_malloc (sizeof (*d));
+    d->loc = loc;
+    d->refc = 0;
+    d->accepts = false;
+    d->as = ddsi_new_addrset ();
+    ddsrt_avl_insert_ipath (&wr_cf_dests_treedef, &wr->cf_dests, d, &path);
+  }
+  struct ddsi_addrset *rdas = ddsi_compute_writer_addrset_reader (wr, prd);
+  ddsi_copy_addrset_into_addrset (wr->e.gv, d->as, rdas);
+  ddsi_unref_addrset (rdas);
+  d->refc++;
+  m->cf_dest = d;
+}
+
+static void detach_dest (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m)
+{
+  // the addresses of the reader remain in the address set until the next rebuild, that
+  // only means some packets may be sent unnecessarily
+  struct ddsi_wr_cf_dest * const d = m->cf_dest;
+  if (d == NULL)
+    return;
+  m->cf_dest = NULL;
+  if (--d->refc == 0)
+  {
+    ddsrt_avl_delete (&wr_cf_dests_treedef, &wr->cf_dests, d);
+    free_dest (d);
+  }
+}
+
+static void build_dests (struct ddsi_writer *wr)
+{
+  ddsrt_avl_iter_t it;
+  assert (ddsrt_avl_is_empty (&wr->cf_dests));
+  for (struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    struct ddsi_proxy_reader *prd;
+    // a proxy reader that can't be found is being deleted, there's no need to send it anything
+    if ((prd = ddsi_entidx_lookup_proxy_reader_guid (wr->e.gv->entity_index, &m->prd_guid)) == NULL)
+      m->cf_dest = NULL;
+    else
+      attach_dest (wr, m, prd);
+  }
+}
+
+static void teardown_dests (struct ddsi_writer *wr)
+{
+  ddsrt_avl_iter_t it;
+  for (struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+    m->cf_dest = NULL;
+  ddsrt_avl_free (&wr_cf_dests_treedef, &wr->cf_dests, free_dest);
+}
+
+static void activate (struct ddsi_writer *wr)
+{
+  // Nothing has been skipped for any reader so far, but the samples written before might
+  // well be rejected by the filters, so they need to be evaluated on retransmit requests
+  ddsrt_avl_iter_t it;
+  ELOGDISC (wr, "writer "PGUIDFMT": content filtering enabled\n", PGUID (wr->e.guid));
+  build_dests (wr);
+  for (struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+    m->last_seq = wr->seq;
+}
+
+static void deactivate (struct ddsi_writer *wr)
+{
+  ELOGDISC (wr, "writer "PGUIDFMT": content filtering disabled\n", PGUID (wr->e.guid));
+  teardown_dests (wr);
+}
+
+void ddsi_writer_content_filter_add_reader (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m, const struct ddsi_proxy_reader *prd)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  m->cf_dest = NULL;
+  if (m->content_filter && wr->num_content_filtered_readers++ == 0)
+    activate (wr);
+  else if (wr->num_content_filtered_readers > 0)
+  {
+    attach_dest (wr, m, prd);
+    m->last_seq = wr->seq;
+  }
+}
+
+void ddsi_writer_content_filter_remove_reader (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  detach_dest (wr, m);
+  if (m->content_filter && --wr->num_content_filtered_readers == 0)
+    deactivate (wr);
+}
+
+void ddsi_writer_content_filter_set (struct ddsi_writer *wr, struct ddsi_wr_prd_match *m, void *filter)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  void * const old = m->content_filter;
+  m->content_filter = filter;
+  if (old == NULL && filter != NULL && wr->num_content_filtered_readers++ == 0)
+    activate (wr);
+  else if (old != NULL && filter == NULL && --wr->num_content_filtered_readers == 0)
+    deactivate (wr);
+  ddsi_content_filter_free (wr->e.gv->content_filter_interface, old);
+}
+
+void ddsi_writer_content_filter_rebuild (struct ddsi_writer *wr)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  if (wr->num_content_filtered_readers == 0)
+    return;
+  teardown_dests (wr);
+  build_dests (wr);
+}
+
+void ddsi_writer_content_filter_fini (struct ddsi_writer *wr)
+{
+  ddsrt_avl_free (&wr_cf_dests_treedef, &wr->cf_dests, free_dest);
+}
+
+static void queue_gap (struct ddsi_writer *wr, const struct ddsi_wr_prd_match *m, ddsi_seqno_t start, ddsi_seqno_t end)
+{
+  struct ddsi_proxy_reader *prd;
+  struct ddsi_gap_info gi;
+  struct ddsi_xmsg *gap;
+  if ((prd = ddsi_entidx_lookup_proxy_reader_guid (wr->e.gv->entity_index, &m->prd_guid)) == NULL)
+    return;
+  ddsi_gap_info_init (&gi);
+  gi.gapstart = start;
+  gi.gapend = end;
+  if ((gap = ddsi_gap_info_create_gap (wr, prd, &gi)) != NULL)
+    ddsi_qxev_msg (wr->evq, gap);
+}
+
+struct ddsi_addrset *ddsi_writer_content_filter_select (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata)
+{
+  const struct ddsi_content_filter_interface * const cfif = wr->e.gv->content_filter_interface;
+  ddsrt_avl_iter_t it;
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  assert (wr->num_content_filtered_readers > 0);
+
+  // only the data can be filtered, anything else is of interest to all readers
+  const bool filter = (serdata->kind == SDK_DATA);
+  struct ddsi_wr_cf_dest *d, *last_accepting = NULL;
+  uint32_t ndests = 0, naccept = 0;
+  for (d = ddsrt_avl_iter_first (&wr_cf_dests_treedef, &wr->cf_dests, &it); d; d = ddsrt_avl_iter_next (&it))
+  {
+    d->accepts = !filter;
+    ndests++;
+  }
+  if (!filter)
+    naccept = ndests;
+  else
+  {
+    struct ddsi_wr_prd_match *m;
+    for (m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m && naccept < ndests; m = ddsrt_avl_iter_next (&it))
+    {
+      if (m->cf_dest && !m->cf_dest->accepts && ddsi_content_filter_accepts (cfif, m->content_filter, serdata))
+      {
+        m->cf_dest->accepts = true;
+        last_accepting = m->cf_dest;
+        naccept++;
+      }
+    }
+  }
+
+  struct ddsi_addrset *as;
+  if (naccept == 0 && ndests > 0)
+    return NULL;
+  else if (naccept == ndests || (2 * naccept > ndests && !ddsi_addrset_empty_mc (wr->as)))
+  {
+    // when sending it to a majority of the destinations and multicast is in use, sending
+    // it to everyone is cheaper than sending it to each of them
+    for (d = ddsrt_avl_iter_first (&wr_cf_dests_treedef, &wr->cf_dests, &it); d; d = ddsrt_avl_iter_next (&it))
+      d->accepts = true;
+    as = ddsi_ref_addrset (wr->as);
+  }
+  else if (naccept == 1)
+  {
+    as = ddsi_ref_addrset (last_accepting->as);
+  }
+  else
+  {
+    as = ddsi_new_addrset ();
+    for (d = ddsrt_avl_iter_first (&wr_cf_dests_treedef, &wr->cf_dests, &it); d; d = ddsrt_avl_iter_next (&it))
+      if (d->accepts)
+        ddsi_copy_addrset_into_addrset (wr->e.gv, as, d->as);
+  }
+
+  // Readers in a destination that gets the sample are told about the samples they didn't
+  // get in the meantime, so they can deliver this one without first having to ask for a
+  // retransmit of those
+  for (struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    if (m->cf_dest == NULL || !m->cf_dest->accepts)
+      continue;
+    if (m->is_reliable && m->last_seq + 1 < seq)
+      queue_gap (wr, m, m->last_seq + 1, seq);
+    m->last_seq = seq;
+  }
+  return as;
+}
+
+bool ddsi_writer_content_filter_rexmit (const struct ddsi_writer *wr, const struct ddsi_wr_prd_match *m, ddsi_seqno_t seq, struct ddsi_serdata *serdata)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  if (m->cf_dest == NULL || serdata->kind != SDK_DATA)
+    return true;
+  else if (seq > m->last_seq)
+  {
+    // skipped when it was written because no reader with this destination accepted it
+    return false;
+  }
+  else
+  {
+    // either sent because some reader with the same destination accepted it, or skipped
+    // (though not necessarily accepted by any of the current readers), or it predates
+    // the content filtering
+    const struct ddsi_content_filter_interface * const cfif = wr->e.gv->content_filter_interface;
+    ddsrt_avl_iter_t it;
+    for (const struct ddsi_wr_prd_match *m1 = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m1; m1 = ddsrt_avl_iter_next (&it))
+    {
+      if (m1->cf_dest == m->cf_dest && ddsi_content_filter_accepts (cfif, m1->content_filter, serdata))
+        return true;
+    }
+    return false;
+  }
+}
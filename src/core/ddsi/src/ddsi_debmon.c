@@ -378,6 +378,15 @@ static void print_writer (struct st *st, void *varg)
   cpfku32 (st, "throttle_count", w->throttle_count);
   cpfku64 (st, "time_throttled", w->time_throttled);
   cpfku64 (st, "time_retransmit", w->time_retransmit);
+  if (w->pacing.rate > 0)
+  {
+    cpfku64 (st, "pacing_rate", w->pacing.rate);
+    cpfku32 (st, "pacing_backoff_count", w->pacing.backoff_count);
+    cpfku64 (st, "time_paced", w->pacing.time_paced);
+  }
+  cpfku32 (st, "addrset_rebuild_count", w->addrset_rebuild_count);
+  cpfku32 (st, "addrset_update_count", w->addrset_update_count);
+  cpfku64 (st, "time_addrset", w->time_addrset);
 
   cpfkseq (st, "as", print_addrset, w->as);
   cpfkseq (st, "local_readers", print_writer_rdseq, w);
@@ -17,6 +17,7 @@
 #include "dds/version.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
+#include "dds/ddsrt/mh3.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "ddsi__discovery.h"
 #include "ddsi__discovery_addrset.h"
@@ -35,6 +36,8 @@
 #include "ddsi__vendor.h"
 #include "ddsi__xqos.h"
 #include "ddsi__addrset.h"
+#include "ddsi__xevent.h"
+#include "ddsi__compression.h"
 
 struct add_locator_to_ps_arg {
   struct ddsi_domaingv *gv;
@@ -182,6 +185,28 @@ static int sedp_write_endpoint_impl
         ps.present |= PP_CYCLONE_REQUESTS_KEYHASH;
         ps.cyclone_requests_keyhash = 1u;
       }
+      ps.present |= PP_CYCLONE_ACCEPTED_COMPRESSION;
+      ps.cyclone_accepted_compression = ddsi_compression_accepted (gv);
+      if (rd->content_filter)
+      {
+        /* an aliased sequence still owns its array, so make a proper copy */
+        ddsi_plist_t cf;
+        ddsi_plist_init_empty (&cf);
+        cf.present = cf.aliased = PP_CONTENT_FILTER_PROPERTY;
+        cf.content_filter_property = *rd->content_filter;
+        ddsi_plist_mergein_missing (&ps, &cf, PP_CONTENT_FILTER_PROPERTY, 0);
+      }
+    }
+    else
+    {
+      const struct ddsi_writer *wr = ddsi_entidx_lookup_writer_guid (gv->entity_index, guid);
+      assert (wr);
+      if (wr->compression_codec)
+      {
+        /* readers only treat a payload as compressed if the writer announced it */
+        ps.present |= PP_CYCLONE_WRITER_COMPRESSION;
+        ps.cyclone_writer_compression = 1u << wr->compression_codec->id;
+      }
     }
 
 #ifdef DDSRT_HAVE_SSM
@@ -440,6 +465,16 @@ struct ddsi_addrset *ddsi_get_endpoint_addrset (const struct ddsi_domaingv *gv,
   return as;
 }
 
+static struct ddsi_dqueue *user_dqueue_for_proxy_writer (const struct ddsi_domaingv *gv, const ddsi_guid_t *guid)
+{
+  /* Fixed assignment to a queue guarantees in-order delivery of the data of
+     a writer, the hash spreads the writers over the available queues */
+  if (gv->n_user_dqueues == 1)
+    return gv->user_dqueues[0];
+  const uint32_t h = ddsrt_mh3 (guid, sizeof (*guid), 0);
+  return gv->user_dqueues[h % gv->n_user_dqueues];
+}
+
 void ddsi_handle_sedp_alive_endpoint (const struct ddsi_receiver_state *rst, ddsi_seqno_t seq, ddsi_plist_t *datap /* note: potentially modifies datap */, ddsi_sedp_kind_t sedp_kind, const ddsi_guid_prefix_t *src_guid_prefix, ddsi_vendorid_t vendorid, ddsrt_wctime_t timestamp)
 {
 #define E(msg, lbl) do { GVLOGDISC (msg); goto lbl; } while (0)
@@ -565,13 +600,13 @@ void ddsi_handle_sedp_alive_endpoint (const struct ddsi_receiver_state *rst, dds
         struct ddsi_proxy_writer *proxy_writer;
         /* not supposed to get here for built-in ones, so can determine the channel based on the transport priority */
         assert (!ddsi_is_builtin_entityid (datap->endpoint_guid.entityid, vendorid));
-        ddsi_new_proxy_writer (&proxy_writer, gv, &ppguid, &datap->endpoint_guid, as, datap, gv->user_dqueue, gv->xevents, timestamp, seq);
+        ddsi_new_proxy_writer (&proxy_writer, gv, &ppguid, &datap->endpoint_guid, as, datap, user_dqueue_for_proxy_writer (gv, &datap->endpoint_guid), ddsi_xeventq_for_endpoint (gv, &datap->endpoint_guid), timestamp, seq);
       }
     }
     else
     {
       if (prd)
-        ddsi_update_proxy_reader (prd, seq, as, xqos, timestamp);
+        ddsi_update_proxy_reader (prd, seq, as, xqos, (datap->present & PP_CONTENT_FILTER_PROPERTY) ? &datap->content_filter_property : NULL, timestamp);
       else
       {
         struct ddsi_proxy_reader *proxy_reader;
@@ -45,15 +45,18 @@
 #include "ddsi__vendor.h"
 #include "ddsi__xqos.h"
 #include "ddsi__hbcontrol.h"
+#include "ddsi__pacing.h"
+#include "ddsi__compression.h"
+#include "ddsi__ack_tracker.h"
 #include "ddsi__lease.h"
+#include "ddsi__content_filter.h"
 #include "dds/dds.h"
 #include "dds__types.h"
 
 static dds_return_t delete_writer_nolinger_locked (struct ddsi_writer *wr);
-static void augment_wr_prd_match (void *vnode, const void *vleft, const void *vright);
 
 const ddsrt_avl_treedef_t ddsi_wr_readers_treedef =
-  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_wr_prd_match, avlnode), offsetof (struct ddsi_wr_prd_match, prd_guid), ddsi_compare_guid, augment_wr_prd_match);
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_wr_prd_match, avlnode), offsetof (struct ddsi_wr_prd_match, prd_guid), ddsi_compare_guid, 0);
 const ddsrt_avl_treedef_t ddsi_wr_local_readers_treedef =
   DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_wr_rd_match, avlnode), offsetof (struct ddsi_wr_rd_match, rd_guid), ddsi_compare_guid, 0);
 const ddsrt_avl_treedef_t ddsi_rd_writers_treedef =
@@ -93,6 +96,25 @@ bool ddsi_is_local_orphan_endpoint (const struct ddsi_entity_common *e)
           ddsi_is_builtin_endpoint (e->guid.entityid, DDSI_VENDORID_ECLIPSE));
 }
 
+const dds_qos_t *ddsi_endpoint_xqos (const struct ddsi_entity_common *e)
+{
+  switch (e->kind)
+  {
+    case DDSI_EK_WRITER:
+      return ((const struct ddsi_writer *) e)->xqos;
+    case DDSI_EK_READER:
+      return ((const struct ddsi_reader *) e)->xqos;
+    case DDSI_EK_PROXY_WRITER:
+    case DDSI_EK_PROXY_READER:
+      return ((const struct ddsi_generic_proxy_endpoint *) e)->c.xqos;
+    case DDSI_EK_PARTICIPANT:
+    case DDSI_EK_PROXY_PARTICIPANT:
+    case DDSI_EK_TOPIC:
+      break;
+  }
+  return NULL;
+}
+
 int ddsi_is_writer_entityid (ddsi_entityid_t id)
 {
   switch (id.u & DDSI_ENTITYID_KIND_MASK)
@@ -171,22 +193,8 @@ static uint32_t get_min_receive_buffer_size (struct ddsi_writer *wr)
   return min_receive_buffer_size;
 }
 
-void ddsi_rebuild_writer_addrset (struct ddsi_writer *wr)
+static void writer_set_burst_size_limits (struct ddsi_writer *wr)
 {
-  /* FIXME: way too inefficient in this form:
-     - it gets computed for every change
-     - in many cases the set of addresses from the readers
-       is identical, so we could cache the results */
-
-  /* only one operation at a time */
-  ASSERT_MUTEX_HELD (&wr->e.lock);
-
-  /* swap in new address set; this simple procedure is ok as long as
-     wr->as is never accessed without the wr->e.lock held */
-  struct ddsi_addrset * const oldas = wr->as;
-  wr->as = ddsi_compute_writer_addrset (wr);
-  ddsi_unref_addrset (oldas);
-
   /* Computing burst size limit here is a bit of a hack; but anyway ...
      try to limit bursts of retransmits to 67% of the smallest receive
      buffer, and those of initial transmissions to that + overshoot%.
@@ -197,7 +205,7 @@ void ddsi_rebuild_writer_addrset (struct ddsi_writer *wr)
      - the way things are now: the retransmits will be sent unicast,
        so if there are multiple receivers, that'll blow up things by
        a non-trivial amount */
-  const uint32_t min_receive_buffer_size = get_min_receive_buffer_size (wr);
+  const uint32_t min_receive_buffer_size = wr->min_receive_buffer_size;
   wr->rexmit_burst_size_limit = min_receive_buffer_size - min_receive_buffer_size / 3;
   if (wr->rexmit_burst_size_limit < 1024)
     wr->rexmit_burst_size_limit = 1024;
@@ -213,12 +221,110 @@ void ddsi_rebuild_writer_addrset (struct ddsi_writer *wr)
     wr->init_burst_size_limit = wr->rexmit_burst_size_limit;
   else
     wr->init_burst_size_limit = (uint32_t) limit64;
+}
+
+static void writer_account_addrset_time (struct ddsi_writer *wr, ddsrt_mtime_t t0)
+{
+  const ddsrt_mtime_t t1 = ddsrt_time_monotonic ();
+  if (t1.v > t0.v)
+    wr->time_addrset += (uint64_t) (t1.v - t0.v);
+}
+
+void ddsi_rebuild_writer_addrset (struct ddsi_writer *wr)
+{
+  /* FIXME: in many cases the set of addresses from the readers is
+     identical, so we could cache the results */
+
+  /* only one operation at a time */
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+
+  /* swap in new address set; this simple procedure is ok as long as
+     wr->as is never accessed without the wr->e.lock held */
+  struct ddsi_addrset * const oldas = wr->as;
+  wr->as = ddsi_compute_writer_addrset (wr);
+  ddsi_unref_addrset (oldas);
+
+  wr->min_receive_buffer_size = get_min_receive_buffer_size (wr);
+  writer_set_burst_size_limits (wr);
+  wr->addrset_dirty = 0;
+  wr->addrset_rebuild_count++;
+  ddsi_writer_content_filter_rebuild (wr);
+  writer_account_addrset_time (wr, t0);
 
   ELOGDISC (wr, "ddsi_rebuild_writer_addrset("PGUIDFMT"):", PGUID (wr->e.guid));
   ddsi_log_addrset(wr->e.gv, DDS_LC_DISCOVERY, "", wr->as);
   ELOGDISC (wr, " (burst size %"PRIu32" rexmit %"PRIu32")\n", wr->init_burst_size_limit, wr->rexmit_burst_size_limit);
 }
 
+static void writer_schedule_addrset_rebuild (struct ddsi_writer *wr)
+{
+  /* Rescheduling only if earlier means a continuous stream of changes still
+     results in a full computation at least once every recompute delay */
+  wr->addrset_dirty = 1;
+  (void) ddsi_resched_xevent_if_earlier (wr->addrset_xevent, ddsrt_mtime_add_duration (ddsrt_time_monotonic (), wr->e.gv->config.writer_addrset_recompute_delay));
+}
+
+void ddsi_writer_addrset_add_reader (struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  /* For the first reader there is nothing to gain by doing it incrementally */
+  if (wr->e.gv->config.writer_addrset_recompute_delay == 0 || wr->num_readers <= 1)
+  {
+    ddsi_rebuild_writer_addrset (wr);
+    return;
+  }
+
+  const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+  struct ddsi_addrset * const oldas = wr->as;
+  wr->as = ddsi_compute_writer_addrset_add_reader (wr, prd);
+  ddsi_unref_addrset (oldas);
+  if (prd->receive_buffer_size < wr->min_receive_buffer_size)
+  {
+    wr->min_receive_buffer_size = prd->receive_buffer_size;
+    writer_set_burst_size_limits (wr);
+  }
+  wr->addrset_update_count++;
+  writer_account_addrset_time (wr, t0);
+  writer_schedule_addrset_rebuild (wr);
+
+  ELOGDISC (wr, "ddsi_writer_addrset_add_reader("PGUIDFMT", "PGUIDFMT"):", PGUID (wr->e.guid), PGUID (prd->e.guid));
+  ddsi_log_addrset(wr->e.gv, DDS_LC_DISCOVERY, "", wr->as);
+  ELOGDISC (wr, " (burst size %"PRIu32" rexmit %"PRIu32")\n", wr->init_burst_size_limit, wr->rexmit_burst_size_limit);
+}
+
+void ddsi_writer_addrset_remove_reader (struct ddsi_writer *wr)
+{
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  if (wr->e.gv->config.writer_addrset_recompute_delay == 0 || wr->num_readers == 0)
+  {
+    ddsi_rebuild_writer_addrset (wr);
+    return;
+  }
+
+  /* The current address set still reaches all remaining readers, it just may
+     be sending to more addresses than necessary until the full computation.
+     Similarly, the burst size limits can only be too conservative. */
+  wr->addrset_update_count++;
+  writer_schedule_addrset_rebuild (wr);
+}
+
+struct ddsi_writer_addrset_xevent_cb_arg {
+  ddsi_guid_t wr_guid;
+};
+
+static void ddsi_writer_addrset_xevent_cb (struct ddsi_domaingv *gv, UNUSED_ARG (struct ddsi_xevent *ev), UNUSED_ARG (struct ddsi_xpack *xp), void *varg, UNUSED_ARG (ddsrt_mtime_t tnow))
+{
+  struct ddsi_writer_addrset_xevent_cb_arg const * const arg = varg;
+  struct ddsi_writer *wr;
+  if ((wr = ddsi_entidx_lookup_writer_guid (gv->entity_index, &arg->wr_guid)) == NULL)
+    return;
+  ddsrt_mutex_lock (&wr->e.lock);
+  if (wr->addrset_dirty)
+    ddsi_rebuild_writer_addrset (wr);
+  ddsrt_mutex_unlock (&wr->e.lock);
+}
+
 #ifdef DDSRT_HAVE_SSM
 static bool nwpart_includes_ssm_enabled_interfaces (const struct ddsi_domaingv *gv, const struct ddsi_config_networkpartition_listelem *np)
   ddsrt_nonnull ((1));
@@ -520,111 +626,12 @@ static void endpoint_common_fini (struct ddsi_entity_common *e, struct ddsi_endp
   ddsi_entity_common_fini (e);
 }
 
-static void augment_wr_prd_match (void *vnode, const void *vleft, const void *vright)
-{
-  struct ddsi_wr_prd_match *n = vnode;
-  const struct ddsi_wr_prd_match *left = vleft;
-  const struct ddsi_wr_prd_match *right = vright;
-  ddsi_seqno_t min_seq, max_seq;
-  int have_replied = n->has_replied_to_hb;
-
-  /* note: this means min <= seq, but not min <= max nor seq <= max!
-     note: this guarantees max < DDSI_MAX_SEQ_NUMBER, which by induction
-     guarantees {left,right}.max < DDSI_MAX_SEQ_NUMBER note: this treats a
-     reader that has not yet replied to a heartbeat as a demoted
-     one */
-  min_seq = n->seq;
-  max_seq = (n->seq < DDSI_MAX_SEQ_NUMBER) ? n->seq : 0;
-
-  /* 1. Compute {min,max} & have_replied. */
-  if (left)
-  {
-    if (left->min_seq < min_seq)
-      min_seq = left->min_seq;
-    if (left->max_seq > max_seq)
-      max_seq = left->max_seq;
-    have_replied = have_replied && left->all_have_replied_to_hb;
-  }
-  if (right)
-  {
-    if (right->min_seq < min_seq)
-      min_seq = right->min_seq;
-    if (right->max_seq > max_seq)
-      max_seq = right->max_seq;
-    have_replied = have_replied && right->all_have_replied_to_hb;
-  }
-  n->min_seq = min_seq;
-  n->max_seq = max_seq;
-  n->all_have_replied_to_hb = have_replied ? 1 : 0;
-
-  /* 2. Compute num_reliable_readers_where_seq_equals_max */
-  if (max_seq == 0)
-  {
-    /* excludes demoted & best-effort readers; note that max == 0
-       cannot happen if {left,right}.max > 0 */
-    n->num_reliable_readers_where_seq_equals_max = 0;
-  }
-  else
-  {
-    /* if demoted or best-effort, seq != max */
-    n->num_reliable_readers_where_seq_equals_max =
-      (n->seq == max_seq && n->has_replied_to_hb);
-    if (left && left->max_seq == max_seq)
-      n->num_reliable_readers_where_seq_equals_max +=
-        left->num_reliable_readers_where_seq_equals_max;
-    if (right && right->max_seq == max_seq)
-      n->num_reliable_readers_where_seq_equals_max +=
-        right->num_reliable_readers_where_seq_equals_max;
-  }
-
-  /* 3. Compute arbitrary unacked reader */
-  /* 3a: maybe this reader is itself a candidate */
-  if (n->seq < max_seq)
-  {
-    /* seq < max cannot be true for a best-effort reader or a demoted */
-    n->arbitrary_unacked_reader = n->prd_guid;
-  }
-  else if (n->is_reliable && (n->seq == DDSI_MAX_SEQ_NUMBER || n->seq == 0 || !n->has_replied_to_hb))
-  {
-    /* demoted readers and reliable readers that have not yet replied to a heartbeat are candidates */
-    n->arbitrary_unacked_reader = n->prd_guid;
-  }
-  /* 3b: maybe we can inherit from the children */
-  else if (left && left->arbitrary_unacked_reader.entityid.u != DDSI_ENTITYID_UNKNOWN)
-  {
-    n->arbitrary_unacked_reader = left->arbitrary_unacked_reader;
-  }
-  else if (right && right->arbitrary_unacked_reader.entityid.u != DDSI_ENTITYID_UNKNOWN)
-  {
-    n->arbitrary_unacked_reader = right->arbitrary_unacked_reader;
-  }
-  /* 3c: else it may be that we can now determine one of our children
-     is actually a candidate */
-  else if (left && left->max_seq != 0 && left->max_seq < max_seq)
-  {
-    n->arbitrary_unacked_reader = left->prd_guid;
-  }
-  else if (right && right->max_seq != 0 && right->max_seq < max_seq)
-  {
-    n->arbitrary_unacked_reader = right->prd_guid;
-  }
-  /* 3d: else no candidate in entire subtree */
-  else
-  {
-    n->arbitrary_unacked_reader.entityid.u = DDSI_ENTITYID_UNKNOWN;
-  }
-}
-
-
 /* WRITER ----------------------------------------------------------- */
 
 ddsi_seqno_t ddsi_writer_max_drop_seq (const struct ddsi_writer *wr)
 {
-  const struct ddsi_wr_prd_match *n;
-  if (ddsrt_avl_is_empty (&wr->readers))
-    return wr->seq;
-  n = ddsrt_avl_root_non_empty (&ddsi_wr_readers_treedef, &wr->readers);
-  return (n->min_seq == DDSI_MAX_SEQ_NUMBER) ? wr->seq : n->min_seq;
+  const ddsi_seqno_t min_seq = ddsi_ack_tracker_min_seq (&wr->ack_tracker);
+  return (min_seq == DDSI_MAX_SEQ_NUMBER) ? wr->seq : min_seq;
 }
 
 int ddsi_writer_must_have_hb_scheduled (const struct ddsi_writer *wr, const struct ddsi_whc_state *whcst)
@@ -640,7 +647,7 @@ int ddsi_writer_must_have_hb_scheduled (const struct ddsi_writer *wr, const stru
        heartbeats in the absence of data. */
     return 0;
   }
-  else if (!((const struct ddsi_wr_prd_match *) ddsrt_avl_root_non_empty (&ddsi_wr_readers_treedef, &wr->readers))->all_have_replied_to_hb)
+  else if (!ddsi_ack_tracker_all_replied (&wr->ack_tracker))
   {
     /* Labouring under the belief that heartbeats must be sent
        regardless of ack state */
@@ -799,6 +806,7 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
   wr->num_readers = 0;
   wr->num_reliable_readers = 0;
   wr->num_readers_requesting_keyhash = 0;
+  wr->num_readers_accepting_compression = 0;
   wr->num_acks_received = 0;
   wr->num_nacks_received = 0;
   wr->throttle_count = 0;
@@ -815,9 +823,15 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
   wr->test_suppress_heartbeat = 0;
   wr->test_suppress_flush_on_sync_heartbeat = 0;
   wr->test_drop_outgoing_data = 0;
+  wr->addrset_dirty = 0;
   wr->alive_vclock = 0;
   wr->init_burst_size_limit = UINT32_MAX - UINT16_MAX;
   wr->rexmit_burst_size_limit = UINT32_MAX - UINT16_MAX;
+  wr->min_receive_buffer_size = UINT32_MAX;
+  wr->addrset_rebuild_count = 0;
+  wr->addrset_update_count = 0;
+  wr->time_addrset = 0;
+  wr->content_filter_skipped = 0;
 
   wr->status_cb = status_cb;
   wr->status_cb_entity = status_entity;
@@ -839,6 +853,14 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
 
   assert (wr->xqos->present & DDSI_QP_RELIABILITY);
   wr->reliable = (wr->xqos->reliability.kind != DDS_RELIABILITY_BEST_EFFORT);
+  ddsi_pacing_init (&wr->pacing, &gv->config, wr->reliable && !ddsi_is_builtin_entityid (wr->e.guid.entityid, DDSI_VENDORID_ECLIPSE), ddsrt_time_monotonic ());
+  if (!ddsi_is_builtin_entityid (wr->e.guid.entityid, DDSI_VENDORID_ECLIPSE))
+    wr->compression_codec = ddsi_compression_codec_for_writer (gv, wr->xqos, &wr->compression_threshold);
+  else
+  {
+    wr->compression_codec = NULL;
+    wr->compression_threshold = 0;
+  }
   assert (wr->xqos->present & DDSI_QP_DURABILITY);
 #ifdef DDS_HAS_TYPE_DISCOVERY
   if (ddsi_is_builtin_entityid (wr->e.guid.entityid, DDSI_VENDORID_ECLIPSE) &&
@@ -911,7 +933,7 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
   }
 #endif
 
-  wr->evq = gv->xevents;
+  wr->evq = ddsi_xeventq_for_endpoint (gv, &wr->e.guid);
 
   /* heartbeat event will be deleted when the handler can't find a
      writer for it in the hash table. NEVER => won't ever be
@@ -925,6 +947,12 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
     wr->heartbeat_xevent = ddsi_qxev_callback (wr->evq, DDSRT_MTIME_NEVER, ddsi_heartbeat_xevent_cb, &arg, sizeof (arg), false);
   }
 
+  /* scheduled whenever the address set is updated incrementally */
+  {
+    struct ddsi_writer_addrset_xevent_cb_arg arg = {.wr_guid = wr->e.guid };
+    wr->addrset_xevent = ddsi_qxev_callback (wr->evq, DDSRT_MTIME_NEVER, ddsi_writer_addrset_xevent_cb, &arg, sizeof (arg), false);
+  }
+
   assert (wr->xqos->present & DDSI_QP_LIVELINESS);
   if (wr->xqos->liveliness.lease_duration != DDS_INFINITY)
   {
@@ -955,6 +983,8 @@ static void ddsi_new_writer_guid_common_init (struct ddsi_writer *wr, const char
 
   /* Connection admin */
   ddsrt_avl_init (&ddsi_wr_readers_treedef, &wr->readers);
+  ddsi_ack_tracker_init (&wr->ack_tracker);
+  ddsi_writer_content_filter_init (wr);
   ddsrt_avl_init (&ddsi_wr_local_readers_treedef, &wr->local_readers);
 
   ddsi_local_reader_ary_init (&wr->rdary);
@@ -1100,13 +1130,14 @@ static void gc_delete_writer (struct ddsi_gcreq *gcreq)
 
   /* We now allow GC while blocked on a full WHC, but we still don't allow deleting a writer while blocked on it. The writer's state must be DELETING by the time we get here, and that means the transmit path is no longer blocked. It doesn't imply that the write thread is no longer in throttle_writer(), just that if it is, it will soon return from there. Therefore, block until it isn't throttling anymore. We can safely lock the writer, as we're on the separate GC thread. */
   assert (wr->state == WRST_DELETING);
-  assert (!wr->throttling);
+  assert (!wr->throttling && !wr->pacing.waiting);
 
   if (wr->heartbeat_xevent)
   {
     wr->hbcontrol.tsched = DDSRT_MTIME_NEVER;
     ddsi_delete_xevent (wr->heartbeat_xevent);
   }
+  ddsi_delete_xevent (wr->addrset_xevent);
 
   /* Tear down connections -- no proxy reader can be adding/removing
       us now, because we can't be found via entity_index anymore.  We
@@ -1116,9 +1147,12 @@ static void gc_delete_writer (struct ddsi_gcreq *gcreq)
   {
     struct ddsi_wr_prd_match *m = ddsrt_avl_root_non_empty (&ddsi_wr_readers_treedef, &wr->readers);
     ddsrt_avl_delete (&ddsi_wr_readers_treedef, &wr->readers, m);
+    ddsi_ack_tracker_remove (&wr->ack_tracker, m);
     ddsi_proxy_reader_drop_connection (&m->prd_guid, wr);
     ddsi_free_wr_prd_match (wr->e.gv, &wr->e.guid, m);
   }
+  ddsi_ack_tracker_fini (&wr->ack_tracker);
+  ddsi_writer_content_filter_fini (wr);
   while (!ddsrt_avl_is_empty (&wr->local_readers))
   {
     struct ddsi_wr_rd_match *m = ddsrt_avl_root_non_empty (&ddsi_wr_local_readers_treedef, &wr->local_readers);
@@ -1166,7 +1200,7 @@ static void gc_delete_writer_throttlewait (struct ddsi_gcreq *gcreq)
   /* We now allow GC while blocked on a full WHC, but we still don't allow deleting a writer while blocked on it. The writer's state must be DELETING by the time we get here, and that means the transmit path is no longer blocked. It doesn't imply that the write thread is no longer in throttle_writer(), just that if it is, it will soon return from there. Therefore, block until it isn't throttling anymore. We can safely lock the writer, as we're on the separate GC thread. */
   assert (wr->state == WRST_DELETING);
   ddsrt_mutex_lock (&wr->e.lock);
-  while (wr->throttling)
+  while (wr->throttling || wr->pacing.waiting)
     ddsrt_cond_wait (&wr->throttle_cond, &wr->e.lock);
   ddsrt_mutex_unlock (&wr->e.lock);
   ddsi_gcreq_requeue (gcreq, gc_delete_writer);
@@ -1174,7 +1208,7 @@ static void gc_delete_writer_throttlewait (struct ddsi_gcreq *gcreq)
 
 static int gcreq_writer (struct ddsi_writer *wr)
 {
-  struct ddsi_gcreq *gcreq = ddsi_gcreq_new (wr->e.gv->gcreq_queue, wr->throttling ? gc_delete_writer_throttlewait : gc_delete_writer);
+  struct ddsi_gcreq *gcreq = ddsi_gcreq_new (wr->e.gv->gcreq_queue, (wr->throttling || wr->pacing.waiting) ? gc_delete_writer_throttlewait : gc_delete_writer);
   gcreq->arg = wr;
   ddsi_gcreq_enqueue (gcreq);
   return 0;
@@ -1473,7 +1507,7 @@ static void reader_init_network_partition (struct ddsi_reader *rd)
 }
 #endif /* DDS_HAS_NETWORK_PARTITIONS */
 
-dds_return_t ddsi_new_reader (struct ddsi_reader **rd_out, const struct ddsi_guid *guid, const struct ddsi_guid *group_guid, struct ddsi_participant *pp, const char *topic_name, const struct ddsi_sertype *type, const struct dds_qos *xqos, struct ddsi_rhc *rhc, ddsi_status_cb_t status_cb, void * status_entity, struct ddsi_psmx_locators_set *psmx_locators)
+dds_return_t ddsi_new_reader (struct ddsi_reader **rd_out, const struct ddsi_guid *guid, const struct ddsi_guid *group_guid, struct ddsi_participant *pp, const char *topic_name, const struct ddsi_sertype *type, const struct dds_qos *xqos, const struct ddsi_content_filter_property *content_filter, struct ddsi_rhc *rhc, ddsi_status_cb_t status_cb, void * status_entity, struct ddsi_psmx_locators_set *psmx_locators)
 {
   /* see ddsi_new_writer for commenets */
 
@@ -1518,6 +1552,7 @@ dds_return_t ddsi_new_reader (struct ddsi_reader **rd_out, const struct ddsi_gui
   rd->handle_as_transient_local = (rd->xqos->durability.kind == DDS_DURABILITY_TRANSIENT_LOCAL) ||
                                   (rd->e.guid.entityid.u == DDSI_ENTITYID_P2P_BUILTIN_PARTICIPANT_VOLATILE_SECURE_READER);
   rd->type = ddsi_sertype_ref (type);
+  rd->content_filter = content_filter ? ddsi_content_filter_property_dup (content_filter) : NULL;
   rd->request_keyhash = rd->type->request_keyhash;
   rd->init_acknack_count = 1;
   rd->num_writers = 0;
@@ -1610,6 +1645,7 @@ static void gc_delete_reader (struct ddsi_gcreq *gcreq)
     (rd->status_cb) (rd->status_cb_entity, NULL);
   }
   ddsi_sertype_unref ((struct ddsi_sertype *) rd->type);
+  ddsi_content_filter_property_free (rd->content_filter);
 
   ddsi_xqos_fini (rd->xqos);
   ddsrt_free (rd->xqos);
@@ -1649,6 +1685,18 @@ void ddsi_update_reader_qos (struct ddsi_reader *rd, const struct dds_qos *xqos)
   ddsrt_mutex_unlock (&rd->e.lock);
 }
 
+void ddsi_update_reader_content_filter (struct ddsi_reader *rd, const struct ddsi_content_filter_property *content_filter)
+{
+  ddsrt_mutex_lock (&rd->e.lock);
+  if (!ddsi_content_filter_property_equal (rd->content_filter, content_filter))
+  {
+    ddsi_content_filter_property_free (rd->content_filter);
+    rd->content_filter = content_filter ? ddsi_content_filter_property_dup (content_filter) : NULL;
+    ddsi_sedp_write_reader (rd);
+  }
+  ddsrt_mutex_unlock (&rd->e.lock);
+}
+
 struct ddsi_reader *ddsi_writer_first_in_sync_reader (struct ddsi_entity_index *entity_index, struct ddsi_entity_common *wrcmn, ddsrt_avl_iter_t *it)
 {
   assert (wrcmn->kind == DDSI_EK_WRITER);
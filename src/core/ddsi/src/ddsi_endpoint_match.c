@@ -33,6 +33,10 @@
 #include "ddsi__vendor.h"
 #include "ddsi__lat_estim.h"
 #include "ddsi__acknack.h"
+#include "ddsi__misc.h"
+#include "ddsi__compression.h"
+#include "ddsi__ack_tracker.h"
+#include "ddsi__content_filter.h"
 #ifdef DDS_HAS_TYPE_DISCOVERY
 #include "ddsi__typelookup.h"
 #endif
@@ -142,8 +146,9 @@ static ddsi_entityid_t builtin_entityid_match (ddsi_entityid_t x)
 static void writer_qos_mismatch (struct ddsi_writer * wr, dds_qos_policy_id_t reason)
 {
   /* When the reason is DDS_INVALID_QOS_POLICY_ID, it means that we compared
-   * readers/writers from different topics: ignore that. */
-  if (reason != DDS_INVALID_QOS_POLICY_ID && wr->status_cb)
+   * readers/writers from different topics: ignore that.  Non-overlapping
+   * partitions are an intentional non-match, not an incompatibility. */
+  if (reason != DDS_INVALID_QOS_POLICY_ID && reason != DDS_PARTITION_QOS_POLICY_ID && wr->status_cb)
   {
     ddsi_status_cb_data_t data;
     data.raw_status_id = (int) DDS_OFFERED_INCOMPATIBLE_QOS_STATUS_ID;
@@ -155,8 +160,9 @@ static void writer_qos_mismatch (struct ddsi_writer * wr, dds_qos_policy_id_t re
 static void reader_qos_mismatch (struct ddsi_reader * rd, dds_qos_policy_id_t reason)
 {
   /* When the reason is DDS_INVALID_QOS_POLICY_ID, it means that we compared
-   * readers/writers from different topics: ignore that. */
-  if (reason != DDS_INVALID_QOS_POLICY_ID && rd->status_cb)
+   * readers/writers from different topics: ignore that.  Non-overlapping
+   * partitions are an intentional non-match, not an incompatibility. */
+  if (reason != DDS_INVALID_QOS_POLICY_ID && reason != DDS_PARTITION_QOS_POLICY_ID && rd->status_cb)
   {
     ddsi_status_cb_data_t data;
     data.raw_status_id = (int) DDS_REQUESTED_INCOMPATIBLE_QOS_STATUS_ID;
@@ -507,6 +513,70 @@ static const char *entity_topic_name (const struct ddsi_entity_common *e)
   return "";
 }
 
+static uint32_t endpoint_partitions (const struct ddsi_entity_common *e, char * const **strs)
+{
+  /* Partitions can't be changed after creating an endpoint, so no need to lock
+     the QoS.  The default partition is represented by "" in the match index. */
+  static char * const default_partition[] = { "" };
+  const dds_qos_t *xqos = ddsi_endpoint_xqos (e);
+  assert (xqos != NULL);
+  if (!(xqos->present & DDSI_QP_PARTITION) || xqos->partition.n == 0)
+  {
+    *strs = default_partition;
+    return 1;
+  }
+  *strs = xqos->partition.strs;
+  return xqos->partition.n;
+}
+
+static bool has_wildcard_partition (uint32_t n, char * const *strs)
+{
+  for (uint32_t i = 0; i < n; i++)
+    if (ddsi_is_wildcard_partition (strs[i]))
+      return true;
+  return false;
+}
+
+static bool has_partition_in (const struct ddsi_entity_common *e, uint32_t n, char * const *strs)
+{
+  char * const *estrs;
+  const uint32_t en = endpoint_partitions (e, &estrs);
+  for (uint32_t i = 0; i < en; i++)
+    for (uint32_t j = 0; j < n; j++)
+      if (strcmp (estrs[i], strs[j]) == 0)
+        return true;
+  return false;
+}
+
+static void generic_do_match_partitions (struct ddsi_entity_common *e, enum ddsi_entity_kind mkind, const char *tp, uint32_t np, char * const *ps, ddsrt_mtime_t tnow, bool local)
+{
+  /* Without wildcards in e's partitions, the only candidates that can match are the
+     ones with a partition name in common with e and the ones with a wildcard of their
+     own.  Those are all in the match index, but some may occur in several of the lists,
+     and those are skipped after the first time they're encountered.  (Visiting them
+     more than once is harmless, but not necessarily cheap.) */
+  struct ddsi_entity_index const * const entidx = e->gv->entity_index;
+  struct ddsi_entity_enum_partition it;
+  struct ddsi_entity_common *em;
+  for (uint32_t i = 0; i < np; i++)
+  {
+    ddsi_entidx_enum_partition_init (&it, entidx, mkind, tp, ps[i]);
+    while ((em = ddsi_entidx_enum_partition_next (&it)) != NULL)
+    {
+      if (!has_partition_in (em, i, ps))
+        generic_do_match_connect (e, em, tnow, local);
+    }
+    ddsi_entidx_enum_partition_fini (&it);
+  }
+  ddsi_entidx_enum_partition_init (&it, entidx, mkind, tp, NULL);
+  while ((em = ddsi_entidx_enum_partition_next (&it)) != NULL)
+  {
+    if (!has_partition_in (em, np, ps))
+      generic_do_match_connect (e, em, tnow, local);
+  }
+  ddsi_entidx_enum_partition_fini (&it);
+}
+
 static void generic_do_match (struct ddsi_entity_common *e, ddsrt_mtime_t tnow, bool local)
 {
   static const struct { const char *full; const char *full_us; const char *abbrev; } kindstr[] = {
@@ -530,20 +600,33 @@ static void generic_do_match (struct ddsi_entity_common *e, ddsrt_mtime_t tnow,
        otherwise need to be treated as normal readers */
     struct ddsi_match_entities_range_key max;
     const char *tp = entity_topic_name (e);
-    EELOGDISC (e, "match_%s_with_%ss(%s "PGUIDFMT") scanning all %ss%s%s\n",
-               kindstr[e->kind].full_us, kindstr[mkind].full_us,
-               kindstr[e->kind].abbrev, PGUID (e->guid),
-               kindstr[mkind].abbrev,
-               tp ? " of topic " : "", tp ? tp : "");
+    char * const *ps;
+    const uint32_t np = endpoint_partitions (e, &ps);
     /* Note: we visit at least all proxies that existed when we called
        init (with the -- possible -- exception of ones that were
        deleted between our calling init and our reaching it while
        enumerating), but we may visit a single proxy reader multiple
        times. */
-    ddsi_entidx_enum_init_topic (&it, entidx, mkind, tp, &max);
-    while ((em = ddsi_entidx_enum_next_max (&it, &max)) != NULL)
-      generic_do_match_connect (e, em, tnow, local);
-    ddsi_entidx_enum_fini (&it);
+    if (!has_wildcard_partition (np, ps))
+    {
+      EELOGDISC (e, "match_%s_with_%ss(%s "PGUIDFMT") scanning %ss of topic %s in %"PRIu32" partition(s)\n",
+                 kindstr[e->kind].full_us, kindstr[mkind].full_us,
+                 kindstr[e->kind].abbrev, PGUID (e->guid),
+                 kindstr[mkind].abbrev, tp, np);
+      generic_do_match_partitions (e, mkind, tp, np, ps, tnow, local);
+    }
+    else
+    {
+      EELOGDISC (e, "match_%s_with_%ss(%s "PGUIDFMT") scanning all %ss%s%s\n",
+                 kindstr[e->kind].full_us, kindstr[mkind].full_us,
+                 kindstr[e->kind].abbrev, PGUID (e->guid),
+                 kindstr[mkind].abbrev,
+                 tp ? " of topic " : "", tp ? tp : "");
+      ddsi_entidx_enum_init_topic (&it, entidx, mkind, tp, &max);
+      while ((em = ddsi_entidx_enum_next_max (&it, &max)) != NULL)
+        generic_do_match_connect (e, em, tnow, local);
+      ddsi_entidx_enum_fini (&it);
+    }
   }
   else if (!local)
   {
@@ -613,6 +696,7 @@ void ddsi_free_wr_prd_match (const struct ddsi_domaingv *gv, const ddsi_guid_t *
     (void) gv;
     (void) wr_guid;
 #endif
+    ddsi_content_filter_free (gv->content_filter_interface, m->content_filter);
     ddsi_lat_estim_fini (&m->hb_to_ack_latency);
     ddsrt_free (m);
   }
@@ -756,7 +840,6 @@ void ddsi_writer_add_connection (struct ddsi_writer *wr, struct ddsi_proxy_reade
   m->assumed_in_sync = (wr->e.gv->config.retransmit_merging == DDSI_REXMIT_MERGE_ALWAYS);
   m->via_psmx = connected_via_psmx (&wr->e, &prd->e);
   m->has_replied_to_hb = !m->is_reliable || m->via_psmx;
-  m->all_have_replied_to_hb = 0;
   m->non_responsive_count = 0;
   m->rexmit_requests = 0;
 #ifdef DDS_HAS_SECURITY
@@ -782,6 +865,9 @@ void ddsi_writer_add_connection (struct ddsi_writer *wr, struct ddsi_proxy_reade
   {
     pretend_everything_acked = false;
   }
+  /* Content filters are of no use for readers reached via PSMX because the data is
+     published only once anyway */
+  m->content_filter = m->via_psmx ? NULL : ddsi_content_filter_compile (wr->e.gv->content_filter_interface, wr->type, prd->content_filter);
   ddsrt_mutex_unlock (&prd->e.lock);
   m->prev_acknack = 0;
   m->prev_nackfrag = 0;
@@ -801,6 +887,7 @@ void ddsi_writer_add_connection (struct ddsi_writer *wr, struct ddsi_proxy_reade
     ELOGDISC (wr, "  ddsi_writer_add_connection(wr "PGUIDFMT" prd "PGUIDFMT") - already connected\n",
               PGUID (wr->e.guid), PGUID (prd->e.guid));
     ddsrt_mutex_unlock (&wr->e.lock);
+    ddsi_content_filter_free (wr->e.gv->content_filter_interface, m->content_filter);
     ddsi_lat_estim_fini (&m->hb_to_ack_latency);
     ddsrt_free (m);
   }
@@ -809,10 +896,13 @@ void ddsi_writer_add_connection (struct ddsi_writer *wr, struct ddsi_proxy_reade
     ELOGDISC (wr, "  ddsi_writer_add_connection(wr "PGUIDFMT" prd "PGUIDFMT") - ack seq %"PRIu64"\n",
               PGUID (wr->e.guid), PGUID (prd->e.guid), m->seq);
     ddsrt_avl_insert_ipath (&ddsi_wr_readers_treedef, &wr->readers, m, &path);
+    ddsi_ack_tracker_insert (&wr->ack_tracker, m);
     wr->num_readers++;
     wr->num_reliable_readers += m->is_reliable;
     wr->num_readers_requesting_keyhash += prd->requests_keyhash ? 1 : 0;
-    ddsi_rebuild_writer_addrset (wr);
+    wr->num_readers_accepting_compression += ddsi_writer_compression_accepted_by (wr, prd) ? 1 : 0;
+    ddsi_writer_content_filter_add_reader (wr, m, prd);
+    ddsi_writer_addrset_add_reader (wr, prd);
     ddsrt_mutex_unlock (&wr->e.lock);
 
     if (wr->status_cb)
@@ -1219,10 +1309,13 @@ void ddsi_writer_drop_connection (const struct ddsi_guid *wr_guid, const struct
     {
       struct ddsi_whc_state whcst;
       ddsrt_avl_delete (&ddsi_wr_readers_treedef, &wr->readers, m);
+      ddsi_ack_tracker_remove (&wr->ack_tracker, m);
       wr->num_readers--;
       wr->num_reliable_readers -= m->is_reliable;
       wr->num_readers_requesting_keyhash -= prd->requests_keyhash ? 1 : 0;
-      ddsi_rebuild_writer_addrset (wr);
+      wr->num_readers_accepting_compression -= ddsi_writer_compression_accepted_by (wr, prd) ? 1 : 0;
+      ddsi_writer_content_filter_remove_reader (wr, m);
+      ddsi_writer_addrset_remove_reader (wr);
       ddsi_remove_acked_messages (wr, &whcst, &deferred_free_list);
     }
 
@@ -13,6 +13,7 @@
 #include <stddef.h>
 
 #include "dds/ddsrt/avl.h"
+#include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/string.h"
 #include "dds/ddsi/ddsi_proxy_participant.h"
 #include "dds/ddsi/ddsi_builtin_topic_if.h"
@@ -66,6 +67,8 @@ void ddsi_entity_common_init (struct ddsi_entity_common *e, struct ddsi_domaingv
   e->tupdate = tcreate;
   e->onlylocal = onlylocal;
   e->gv = gv;
+  e->match_index_nodes = NULL;
+  e->n_match_index_nodes = 0;
   ddsrt_mutex_init (&e->lock);
   ddsrt_mutex_init (&e->qos_lock);
   if (ddsi_builtintopic_is_visible (gv->builtin_topic_interface, guid, vendorid))
@@ -85,6 +88,7 @@ void ddsi_entity_common_fini (struct ddsi_entity_common *e)
 {
   if (e->tk)
     ddsi_tkmap_instance_unref (e->gv->m_tkmap, e->tk);
+  ddsrt_free (e->match_index_nodes);
   ddsrt_mutex_destroy (&e->qos_lock);
   ddsrt_mutex_destroy (&e->lock);
 }
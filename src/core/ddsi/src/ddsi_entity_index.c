@@ -28,11 +28,13 @@
 #include "ddsi__gc.h"
 #include "ddsi__topic.h"
 #include "ddsi__vendor.h"
+#include "ddsi__misc.h"
 
 struct ddsi_entity_index {
   struct ddsrt_chh *guid_hash;
   ddsrt_mutex_t all_entities_lock;
   ddsrt_avl_tree_t all_entities;
+  ddsrt_avl_tree_t match_index;
 };
 
 static const uint64_t unihashconsts[] = {
@@ -46,6 +48,10 @@ static int all_entities_compare (const void *va, const void *vb);
 static const ddsrt_avl_treedef_t all_entities_treedef =
   DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_entity_common, all_entities_avlnode), 0, all_entities_compare, 0);
 
+static int match_index_compare (const void *va, const void *vb);
+static const ddsrt_avl_treedef_t match_index_treedef =
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_match_index_node, avlnode), 0, match_index_compare, 0);
+
 static uint32_t hash_entity_guid (const struct ddsi_entity_common *c)
 {
   return
@@ -140,6 +146,66 @@ static int all_entities_compare (const void *va, const void *vb)
     return memcmp (&a->guid, &b->guid, sizeof (a->guid));
 }
 
+static int match_index_compare (const void *va, const void *vb)
+{
+  const struct ddsi_match_index_node *a = va;
+  const struct ddsi_match_index_node *b = vb;
+  int cmpres;
+
+  if (a->entity->kind != b->entity->kind)
+    return (int) a->entity->kind - (int) b->entity->kind;
+  if ((cmpres = strcmp (a->topic, b->topic)) != 0)
+    return cmpres;
+  if (a->partition == NULL || b->partition == NULL)
+  {
+    /* the wildcard list sorts before all partition names */
+    if (a->partition != b->partition)
+      return (a->partition == NULL) ? -1 : 1;
+  }
+  else if ((cmpres = strcmp (a->partition, b->partition)) != 0)
+  {
+    return cmpres;
+  }
+  return memcmp (&a->entity->guid, &b->entity->guid, sizeof (a->entity->guid));
+}
+
+static void make_match_index_nodes (struct ddsi_entity_common *e)
+{
+  /* One node for each distinct partition name, one node for the wildcard list if
+     there is any wildcard, and no partitions at all means the default partition.
+     Topic name and partitions can't be changed once created, so the nodes can
+     refer to the strings in the QoS object directly. */
+  const dds_qos_t *xqos;
+  if ((xqos = ddsi_endpoint_xqos (e)) == NULL)
+    return;
+  assert ((xqos->present & DDSI_QP_TOPIC_NAME) && xqos->topic_name);
+  assert (e->match_index_nodes == NULL);
+  const uint32_t np = (xqos->present & DDSI_QP_PARTITION) ? xqos->partition.n : 0;
+  struct ddsi_match_index_node *ns = ddsrt_malloc ((np + 1) * sizeof (*ns));
+  uint32_t n = 0;
+  bool wildcards = false;
+  if (np == 0)
+    ns[n++] = (struct ddsi_match_index_node) { .entity = e, .topic = xqos->topic_name, .partition = "" };
+  for (uint32_t i = 0; i < np; i++)
+  {
+    const char *p = xqos->partition.strs[i];
+    uint32_t j;
+    if (ddsi_is_wildcard_partition (p))
+    {
+      wildcards = true;
+      continue;
+    }
+    for (j = 0; j < n && strcmp (ns[j].partition, p) != 0; j++)
+      ;
+    if (j == n)
+      ns[n++] = (struct ddsi_match_index_node) { .entity = e, .topic = xqos->topic_name, .partition = p };
+  }
+  if (wildcards)
+    ns[n++] = (struct ddsi_match_index_node) { .entity = e, .topic = xqos->topic_name, .partition = NULL };
+  e->match_index_nodes = ns;
+  e->n_match_index_nodes = n;
+}
+
 static void match_endpoint_range (enum ddsi_entity_kind kind, const char *tp, struct ddsi_match_entities_range_key *min, struct ddsi_match_entities_range_key *max)
 {
   /* looking for entities of kind KIND; initialize fake entities such that they are
@@ -243,12 +309,14 @@ struct ddsi_entity_index *ddsi_entity_index_new (struct ddsi_domaingv *gv)
   } else {
     ddsrt_mutex_init (&entidx->all_entities_lock);
     ddsrt_avl_init (&all_entities_treedef, &entidx->all_entities);
+    ddsrt_avl_init (&match_index_treedef, &entidx->match_index);
     return entidx;
   }
 }
 
 void ddsi_entity_index_free (struct ddsi_entity_index *entidx)
 {
+  ddsrt_avl_free (&match_index_treedef, &entidx->match_index, 0);
   ddsrt_avl_free (&all_entities_treedef, &entidx->all_entities, 0);
   ddsrt_mutex_destroy (&entidx->all_entities_lock);
   ddsrt_chh_free (entidx->guid_hash);
@@ -261,6 +329,8 @@ static void add_to_all_entities (struct ddsi_entity_index *ei, struct ddsi_entit
   ddsrt_mutex_lock (&ei->all_entities_lock);
   assert (ddsrt_avl_lookup (&all_entities_treedef, &ei->all_entities, e) == NULL);
   ddsrt_avl_insert (&all_entities_treedef, &ei->all_entities, e);
+  for (uint32_t i = 0; i < e->n_match_index_nodes; i++)
+    ddsrt_avl_insert (&match_index_treedef, &ei->match_index, &e->match_index_nodes[i]);
   ddsrt_mutex_unlock (&ei->all_entities_lock);
 }
 
@@ -269,6 +339,8 @@ static void remove_from_all_entities (struct ddsi_entity_index *ei, struct ddsi_
   ddsrt_mutex_lock (&ei->all_entities_lock);
   assert (ddsrt_avl_lookup (&all_entities_treedef, &ei->all_entities, e) != NULL);
   ddsrt_avl_delete (&all_entities_treedef, &ei->all_entities, e);
+  for (uint32_t i = 0; i < e->n_match_index_nodes; i++)
+    ddsrt_avl_delete (&match_index_treedef, &ei->match_index, &e->match_index_nodes[i]);
   ddsrt_mutex_unlock (&ei->all_entities_lock);
 }
 
@@ -278,6 +350,7 @@ static void entity_index_insert (struct ddsi_entity_index *ei, struct ddsi_entit
   x = ddsrt_chh_add (ei->guid_hash, e);
   (void)x;
   assert (x);
+  make_match_index_nodes (e);
   add_to_all_entities (ei, e);
 }
 
@@ -523,6 +596,50 @@ void *ddsi_entidx_enum_next_max (struct ddsi_entity_enum *st, const struct ddsi_
   return res;
 }
 
+void ddsi_entidx_enum_partition_init (struct ddsi_entity_enum_partition *st, const struct ddsi_entity_index *ei, enum ddsi_entity_kind kind, const char *topic, const char *partition)
+{
+  assert (kind == DDSI_EK_READER || kind == DDSI_EK_WRITER || kind == DDSI_EK_PROXY_READER || kind == DDSI_EK_PROXY_WRITER);
+  struct ddsi_entity_common min_entity;
+  struct ddsi_match_index_node min;
+#ifndef NDEBUG
+  assert (ddsi_thread_is_awake ());
+  st->vtime = ddsrt_atomic_ld32 (&ddsi_lookup_thread_state ()->vtime);
+#endif
+  st->entidx = (struct ddsi_entity_index *) ei;
+  min_entity.kind = st->max_entity.kind = kind;
+  memset (&min_entity.guid, 0x00, sizeof (min_entity.guid));
+  memset (&st->max_entity.guid, 0xff, sizeof (st->max_entity.guid));
+  min = (struct ddsi_match_index_node) { .entity = &min_entity, .topic = topic, .partition = partition };
+  st->max = (struct ddsi_match_index_node) { .entity = &st->max_entity, .topic = topic, .partition = partition };
+  ddsrt_mutex_lock (&st->entidx->all_entities_lock);
+  st->cur = ddsrt_avl_lookup_succ_eq (&match_index_treedef, &st->entidx->match_index, &min);
+  ddsrt_mutex_unlock (&st->entidx->all_entities_lock);
+  if (st->cur && match_index_compare (st->cur, &st->max) > 0)
+    st->cur = NULL;
+}
+
+void *ddsi_entidx_enum_partition_next (struct ddsi_entity_enum_partition *st)
+{
+  /* same reasoning as for ddsi_entidx_enum_next: the node is owned by the
+     entity and the entity can't have been freed yet */
+  assert (ddsrt_atomic_ld32 (&ddsi_lookup_thread_state ()->vtime) == st->vtime);
+  struct ddsi_match_index_node * const res = st->cur;
+  if (res == NULL)
+    return NULL;
+  ddsrt_mutex_lock (&st->entidx->all_entities_lock);
+  st->cur = ddsrt_avl_lookup_succ (&match_index_treedef, &st->entidx->match_index, res);
+  ddsrt_mutex_unlock (&st->entidx->all_entities_lock);
+  if (st->cur && match_index_compare (st->cur, &st->max) > 0)
+    st->cur = NULL;
+  return res->entity;
+}
+
+void ddsi_entidx_enum_partition_fini (struct ddsi_entity_enum_partition *st)
+{
+  assert (ddsrt_atomic_ld32 (&ddsi_lookup_thread_state ()->vtime) == st->vtime);
+  (void) st;
+}
+
 struct ddsi_writer *ddsi_entidx_enum_writer_next (struct ddsi_entity_enum_writer *st)
 {
   DDSRT_STATIC_ASSERT (offsetof (struct ddsi_writer, e) == 0);
@@ -27,10 +27,21 @@
 #include "ddsi__endpoint.h"
 #include "ddsi__endpoint_match.h"
 #include "ddsi__protocol.h"
+#include "ddsi__ack_tracker.h"
 
-static const struct ddsi_wr_prd_match *root_rdmatch (const struct ddsi_writer *wr)
+static const ddsi_guid_t *arbitrary_unacked_reader (const struct ddsi_writer *wr)
 {
-  return ddsrt_avl_root (&ddsi_wr_readers_treedef, &wr->readers);
+  /* Linear in the number of readers, but only used when there is exactly one
+     unacked reader, so other readers are likely to be done soon and there is
+     no need to track it on every acknowledgement */
+  const ddsi_seqno_t max_seq = ddsi_ack_tracker_max_seq (&wr->ack_tracker);
+  ddsrt_avl_iter_t it;
+  for (const struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    if (m->is_reliable && !(m->seq == max_seq && m->has_replied_to_hb))
+      return &m->prd_guid;
+  }
+  return NULL;
 }
 
 void ddsi_writer_hbcontrol_init (struct ddsi_hbcontrol *hbc)
@@ -121,7 +132,7 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_create_heartbeat (struct ddsi_writer *wr
   ASSERT_MUTEX_HELD (&wr->e.lock);
   assert (wr->reliable);
 
-  if ((msg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
+  if ((msg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
     /* out of memory at worst slows down traffic */
     return NULL;
 
@@ -134,7 +145,7 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_create_heartbeat (struct ddsi_writer *wr
        reliable writer. */
     prd_guid = NULL;
   }
-  else if (wr->seq != root_rdmatch (wr)->max_seq)
+  else if (wr->seq != ddsi_ack_tracker_max_seq (&wr->ack_tracker))
   {
     /* If the writer is ahead of its readers, multicast. Couldn't care
        less about the pessimal cases such as multicasting when there
@@ -144,16 +155,13 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_create_heartbeat (struct ddsi_writer *wr
   }
   else
   {
-    const uint32_t n_unacked = wr->num_reliable_readers - root_rdmatch (wr)->num_reliable_readers_where_seq_equals_max;
-    if (n_unacked == 0)
+    const uint32_t n_unacked = wr->num_reliable_readers - ddsi_ack_tracker_num_at_max_seq (&wr->ack_tracker);
+    if (n_unacked != 1)
       prd_guid = NULL;
     else
     {
-      assert (root_rdmatch (wr)->arbitrary_unacked_reader.entityid.u != DDSI_ENTITYID_UNKNOWN);
-      if (n_unacked > 1)
-        prd_guid = NULL;
-      else
-        prd_guid = &(root_rdmatch (wr)->arbitrary_unacked_reader);
+      prd_guid = arbitrary_unacked_reader (wr);
+      assert (prd_guid != NULL);
     }
   }
 
@@ -171,9 +179,9 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_create_heartbeat (struct ddsi_writer *wr
   {
     ETRACE (wr, "(rel-prd %"PRId32" seq-eq-max %"PRId32" seq %"PRIu64" maxseq %"PRIu64")\n",
             wr->num_reliable_readers,
-            (int32_t) root_rdmatch (wr)->num_reliable_readers_where_seq_equals_max,
+            (int32_t) ddsi_ack_tracker_num_at_max_seq (&wr->ack_tracker),
             wr->seq,
-            root_rdmatch (wr)->max_seq);
+            ddsi_ack_tracker_max_seq (&wr->ack_tracker));
   }
 
   if (prd_guid == NULL)
@@ -312,8 +320,8 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_piggyback (struct ddsi_writer *wr, const
               PGUID (wr->e.guid),
               *hbansreq != DDSI_HBC_ACK_REQ_NO ? "" : " final",
               (hbc->tsched.v == DDS_NEVER) ? INFINITY : (double) (hbc->tsched.v - tnow.v) / 1e9,
-              root_rdmatch (wr)->min_seq,
-              root_rdmatch (wr)->all_have_replied_to_hb ? "" : "!",
+              ddsi_ack_tracker_min_seq (&wr->ack_tracker),
+              ddsi_ack_tracker_all_replied (&wr->ack_tracker) ? "" : "!",
               whcst->max_seq, ddsi_writer_read_seq_xmit(wr));
     }
   }
@@ -324,13 +332,12 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_piggyback (struct ddsi_writer *wr, const
 #ifdef DDS_HAS_SECURITY
 struct ddsi_xmsg *ddsi_writer_hbcontrol_p2p(struct ddsi_writer *wr, const struct ddsi_whc_state *whcst, enum ddsi_hbcontrol_ack_required hbansreq, struct ddsi_proxy_reader *prd)
 {
-  struct ddsi_domaingv const * const gv = wr->e.gv;
   struct ddsi_xmsg *msg;
 
   ASSERT_MUTEX_HELD (&wr->e.lock);
   assert (wr->reliable);
 
-  if ((msg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
+  if ((msg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
     return NULL;
 
   ETRACE (wr, "writer_hbcontrol_p2p: wr "PGUIDFMT" unicasting to prd "PGUIDFMT" ", PGUID (wr->e.guid), PGUID (prd->e.guid));
@@ -342,9 +349,9 @@ struct ddsi_xmsg *ddsi_writer_hbcontrol_p2p(struct ddsi_writer *wr, const struct
   {
     ETRACE (wr, "(rel-prd %d seq-eq-max %d seq %"PRIu64" maxseq %"PRIu64")\n",
             wr->num_reliable_readers,
-            (int32_t) root_rdmatch (wr)->num_reliable_readers_where_seq_equals_max,
+            (int32_t) ddsi_ack_tracker_num_at_max_seq (&wr->ack_tracker),
             wr->seq,
-            root_rdmatch (wr)->max_seq);
+            ddsi_ack_tracker_max_seq (&wr->ack_tracker));
   }
 
   /* set the destination explicitly to the unicast destination and the fourth
@@ -509,8 +516,8 @@ static void send_heartbeat_to_all_readers (struct ddsi_xpack *xp, struct ddsi_xe
       ETRACE (wr, "heartbeat(wr "PGUIDFMT") suppressed, resched in %g s (min-ack %"PRIu64"%s, avail-seq %"PRIu64", xmit %"PRIu64")\n",
               PGUID (wr->e.guid),
               (t_next.v == DDS_NEVER) ? INFINITY : (double)(t_next.v - tnow.v) / 1e9,
-              ((struct ddsi_wr_prd_match *) ddsrt_avl_root (&ddsi_wr_readers_treedef, &wr->readers))->min_seq,
-              ((struct ddsi_wr_prd_match *) ddsrt_avl_root (&ddsi_wr_readers_treedef, &wr->readers))->all_have_replied_to_hb ? "" : "!",
+              ddsi_ack_tracker_min_seq (&wr->ack_tracker),
+              ddsi_ack_tracker_all_replied (&wr->ack_tracker) ? "" : "!",
               whcst.max_seq,
               ddsi_writer_read_seq_xmit(wr));
     }
@@ -581,8 +588,8 @@ void ddsi_heartbeat_xevent_cb (struct ddsi_domaingv *gv, struct ddsi_xevent *ev,
              hbansreq != DDSI_HBC_ACK_REQ_NO ? "" : " final",
              msg ? "sent" : "suppressed",
              (t_next.v == DDS_NEVER) ? INFINITY : (double)(t_next.v - tnow.v) / 1e9,
-             ((struct ddsi_wr_prd_match *) ddsrt_avl_root_non_empty (&ddsi_wr_readers_treedef, &wr->readers))->min_seq,
-             ((struct ddsi_wr_prd_match *) ddsrt_avl_root_non_empty (&ddsi_wr_readers_treedef, &wr->readers))->all_have_replied_to_hb ? "" : "!",
+             ddsi_ack_tracker_min_seq (&wr->ack_tracker),
+             ddsi_ack_tracker_all_replied (&wr->ack_tracker) ? "" : "!",
              whcst.max_seq, ddsi_writer_read_seq_xmit (wr));
   }
   (void) ddsi_resched_xevent_if_earlier (ev, t_next);
@@ -46,6 +46,7 @@
 #include "ddsi__xmsg.h"
 #include "ddsi__receive.h"
 #include "ddsi__pcap.h"
+#include "ddsi__compression.h"
 #include "ddsi__debmon.h"
 #include "ddsi__pmd.h"
 #include "ddsi__typelookup.h"
@@ -82,6 +83,58 @@ enum make_uc_sockets_ret {
   MUSRET_ERROR          /* generic error, no use continuing */
 };
 
+static bool use_multiple_receive_threads (const struct ddsi_config *cfg);
+
+static uint32_t n_uc_data_recv_threads (const struct ddsi_domaingv *gv)
+{
+  /* Only if the unicast data port gets a dedicated receive thread in
+     setup_and_start_recv_threads */
+  if (!gv->m_factory->m_connless || gv->config.many_sockets_mode != DDSI_MSM_SINGLE_UNICAST || !use_multiple_receive_threads (&gv->config))
+    return 1;
+  else if (gv->config.n_recv_threads_uc > MAX_UC_RECV_THREADS)
+    return MAX_UC_RECV_THREADS;
+  else
+    return gv->config.n_recv_threads_uc;
+}
+
+static void free_shared_uc_data_conns (struct ddsi_domaingv *gv)
+{
+  for (uint32_t i = 0; i < gv->n_data_conn_uc_shared; i++)
+    ddsi_conn_free (gv->data_conn_uc_shared[i]);
+  gv->n_data_conn_uc_shared = 0;
+}
+
+static dds_return_t share_uc_data_port (struct ddsi_domaingv *gv, uint32_t nconns)
+{
+  /* Having been able to create data_conn_uc without enabling port reuse
+     proves that no one else is using the port, and so we can now replace
+     it by nconns sockets bound to the same port, with reuse enabled.  Of
+     course someone else could grab the port in between. */
+  const struct ddsi_tran_qos qos = { .m_purpose = DDSI_TRAN_QOS_RECV_UC_SHARED, .m_diffserv = 0, .m_interface = NULL };
+  const uint32_t port = ddsi_conn_port (gv->data_conn_uc);
+  dds_return_t rc;
+  ddsi_conn_free (gv->data_conn_uc);
+  if ((rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, port, &qos)) != DDS_RETCODE_OK)
+  {
+    gv->data_conn_uc = NULL;
+    return rc;
+  }
+  assert (gv->n_data_conn_uc_shared == 0);
+  while (gv->n_data_conn_uc_shared + 1 < nconns)
+  {
+    if ((rc = ddsi_factory_create_conn (&gv->data_conn_uc_shared[gv->n_data_conn_uc_shared], gv->m_factory, port, &qos)) != DDS_RETCODE_OK)
+    {
+      free_shared_uc_data_conns (gv);
+      ddsi_conn_free (gv->data_conn_uc);
+      gv->data_conn_uc = NULL;
+      return rc;
+    }
+    gv->n_data_conn_uc_shared++;
+  }
+  GVLOG (DDS_LC_CONFIG, "unicast data port %"PRIu32" shared by %"PRIu32" sockets\n", port, nconns);
+  return DDS_RETCODE_OK;
+}
+
 static enum make_uc_sockets_ret make_uc_sockets (struct ddsi_domaingv *gv, uint32_t * pdisc, uint32_t * pdata, int ppid)
 {
   dds_return_t rc;
@@ -121,6 +174,9 @@ static enum make_uc_sockets_ret make_uc_sockets (struct ddsi_domaingv *gv, uint3
     rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, *pdata, &qos);
     if (rc != DDS_RETCODE_OK)
       goto fail_data;
+    const uint32_t nconns = n_uc_data_recv_threads (gv);
+    if (nconns > 1 && (rc = share_uc_data_port (gv, nconns)) != DDS_RETCODE_OK)
+      goto fail_data;
   }
   ddsi_conn_locator (gv->disc_conn_uc, &gv->loc_meta_uc);
   ddsi_conn_locator (gv->data_conn_uc, &gv->loc_default_uc);
@@ -888,6 +944,9 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
     gv->recv_threads[i].arg.gv = gv;
     gv->recv_threads[i].arg.u.single.loc = NULL;
     gv->recv_threads[i].arg.u.single.conn = NULL;
+    gv->recv_threads[i].arg.u.single.ws = NULL;
+    ddsrt_atomic_st64 (&gv->recv_threads[i].arg.npackets, 0);
+    ddsrt_atomic_st64 (&gv->recv_threads[i].arg.nreads, 0);
   }
 
   /* First thread always uses a waitset and gobbles up all sockets not handled by dedicated threads - FIXME: DDSI_MSM_NO_UNICAST mode with UDP probably doesn't even need this one to use a waitset */
@@ -912,13 +971,26 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
     }
     if (gv->config.many_sockets_mode == DDSI_MSM_SINGLE_UNICAST)
     {
-      /* No per-participant sockets => handle data unicasts on a separate thread as well */
-      gv->recv_threads[gv->n_recv_threads].name = "recvUC";
-      gv->recv_threads[gv->n_recv_threads].arg.mode = DDSI_RTM_SINGLE;
-      gv->recv_threads[gv->n_recv_threads].arg.u.single.conn = gv->data_conn_uc;
-      gv->recv_threads[gv->n_recv_threads].arg.u.single.loc = &gv->loc_default_uc;
-      ddsi_conn_disable_multiplexing (gv->data_conn_uc);
-      gv->n_recv_threads++;
+      /* No per-participant sockets => handle data unicasts on a separate thread as well,
+         or on one thread per socket if the port is shared by multiple sockets */
+      static const char *uc_names[MAX_UC_RECV_THREADS] = {
+        "recvUC", "recvUC1", "recvUC2", "recvUC3", "recvUC4", "recvUC5", "recvUC6", "recvUC7"
+      };
+      for (uint32_t k = 0; k <= gv->n_data_conn_uc_shared; k++)
+      {
+        struct recv_thread * const rt = &gv->recv_threads[gv->n_recv_threads++];
+        rt->name = uc_names[k];
+        rt->arg.mode = DDSI_RTM_SINGLE;
+        rt->arg.u.single.conn = (k == 0) ? gv->data_conn_uc : gv->data_conn_uc_shared[k - 1];
+        rt->arg.u.single.loc = &gv->loc_default_uc;
+        if (gv->n_data_conn_uc_shared == 0)
+          ddsi_conn_disable_multiplexing (rt->arg.u.single.conn);
+        else if ((rt->arg.u.single.ws = ddsi_sock_waitset_new ()) == NULL || ddsi_sock_waitset_add (rt->arg.u.single.ws, rt->arg.u.single.conn) < 0)
+        {
+          GVERROR ("rtps_init: can't allocate sock waitset for thread %s\n", rt->name);
+          goto fail;
+        }
+      }
     }
   }
   assert (gv->n_recv_threads <= MAX_RECV_THREADS);
@@ -929,7 +1001,11 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
     /* We create the rbufpool for the receive thread, and so we'll
        become the initial owner thread. The receive thread will change
        it before it does anything with it. */
-    if ((gv->recv_threads[i].arg.rbpool = ddsi_rbufpool_new (&gv->logconfig, gv->config.rbuf_size, gv->config.rmsg_chunk_size)) == NULL)
+    if (gv->config.rbuf_slabs > 0)
+      gv->recv_threads[i].arg.rbpool = ddsi_rbufpool_new_slab (&gv->logconfig, gv->config.rmsg_chunk_size, gv->config.rbuf_slabs);
+    else
+      gv->recv_threads[i].arg.rbpool = ddsi_rbufpool_new (&gv->logconfig, gv->config.rbuf_size, gv->config.rmsg_chunk_size);
+    if (gv->recv_threads[i].arg.rbpool == NULL)
     {
       GVERROR ("rtps_init: can't allocate receive buffer pool for thread %s\n", gv->recv_threads[i].name);
       goto fail;
@@ -958,6 +1034,8 @@ fail:
   {
     if (gv->recv_threads[i].arg.mode == DDSI_RTM_MANY && gv->recv_threads[i].arg.u.many.ws)
       ddsi_sock_waitset_free (gv->recv_threads[i].arg.u.many.ws);
+    else if (gv->recv_threads[i].arg.mode == DDSI_RTM_SINGLE && gv->recv_threads[i].arg.u.single.ws)
+      ddsi_sock_waitset_free (gv->recv_threads[i].arg.u.single.ws);
     if (gv->recv_threads[i].arg.rbpool)
       ddsi_rbufpool_free (gv->recv_threads[i].arg.rbpool);
   }
@@ -1023,6 +1101,7 @@ static void free_conns (struct ddsi_domaingv *gv)
         cs[j] = NULL;
     ddsi_conn_free (cs[i]);
   }
+  free_shared_uc_data_conns (gv);
 }
 
 static int create_vnet_interface_for_psmx (struct ddsi_domaingv *gv, const char *psmx_instance_name, const ddsi_locator_t locator, bool mc_capable)
@@ -1133,6 +1212,7 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
 
   gv->disc_conn_uc = NULL;
   gv->data_conn_uc = NULL;
+  gv->n_data_conn_uc_shared = 0;
   gv->disc_conn_mc = NULL;
   gv->data_conn_mc = NULL;
   for (size_t i = 0; i < MAX_XMIT_CONNS; i++)
@@ -1161,6 +1241,9 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
     reset_deaf_mute_time = ddsrt_mtime_add_duration (ddsrt_time_monotonic (), gv->config.initial_deaf_mute_reset);
   }
 
+  if (ddsi_compression_init (gv) != DDS_RETCODE_OK)
+    goto err_compression;
+
   /* Initialize UDP or TCP transport and resolve factory */
   switch (gv->config.transport_selector)
   {
@@ -1298,8 +1381,6 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
 #endif
   }
 
-  gv->xmsgpool = ddsi_xmsgpool_new ();
-
   // copy default participant plist into one that is used for this domain's participants
   // a plain copy is safe because it doesn't alias anything
   gv->default_local_xqos_pp = ddsi_default_qos_participant;
@@ -1360,6 +1441,8 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
   ddsrt_avl_init (&ddsi_typelib_treedef, &gv->typelib);
   ddsrt_avl_init (&ddsi_typedeps_treedef, &gv->typedeps);
   ddsrt_avl_init (&ddsi_typedeps_reverse_treedef, &gv->typedeps_reverse);
+  ddsrt_avl_init (&ddsi_type_assignable_treedef, &gv->type_assignable);
+  ddsrt_avl_init (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse);
 #endif
   ddsrt_mutex_init (&gv->new_topic_lock);
   ddsrt_cond_init (&gv->new_topic_cond);
@@ -1604,6 +1687,11 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
 
   /* Create event queues */
   gv->xevents = ddsi_xeventq_new (gv, gv->config.max_queued_rexmit_bytes, gv->config.max_queued_rexmit_msgs);
+  gv->n_endpoint_xevents = gv->config.timed_event_threads;
+  gv->endpoint_xevents = ddsrt_malloc (gv->n_endpoint_xevents * sizeof (*gv->endpoint_xevents));
+  gv->endpoint_xevents[0] = gv->xevents;
+  for (uint32_t i = 1; i < gv->n_endpoint_xevents; i++)
+    gv->endpoint_xevents[i] = ddsi_xeventq_new (gv, gv->config.max_queued_rexmit_bytes, gv->config.max_queued_rexmit_msgs);
 
 #ifdef DDS_HAS_SECURITY
   ddsi_omg_security_init (gv);
@@ -1622,7 +1710,17 @@ int ddsi_init (struct ddsi_domaingv *gv, struct ddsi_psmx_instance_locators *psm
   ddsrt_mutex_init (&gv->sendq_running_lock);
 
   gv->builtins_dqueue = ddsi_dqueue_new ("builtins", gv, gv->config.delivery_queue_maxsamples, ddsi_builtins_dqueue_handler, NULL);
-  gv->user_dqueue = ddsi_dqueue_new ("user", gv, gv->config.delivery_queue_maxsamples, ddsi_user_dqueue_handler, NULL);
+  gv->n_user_dqueues = gv->config.delivery_queue_threads;
+  gv->user_dqueues = ddsrt_malloc (gv->n_user_dqueues * sizeof (*gv->user_dqueues));
+  for (uint32_t i = 0; i < gv->n_user_dqueues; i++)
+  {
+    char name[16];
+    if (i == 0)
+      (void) snprintf (name, sizeof (name), "user");
+    else
+      (void) snprintf (name, sizeof (name), "user%"PRIu32, i);
+    gv->user_dqueues[i] = ddsi_dqueue_new (name, gv, gv->config.delivery_queue_maxsamples, ddsi_user_dqueue_handler, NULL);
+  }
 
   if (reset_deaf_mute_time.v < DDS_NEVER)
     ddsi_qxev_callback (gv->xevents, reset_deaf_mute_time, reset_deaf_mute, NULL, 0, true);
@@ -1680,6 +1778,8 @@ err_unicast_sockets:
   ddsrt_avl_free (&ddsi_typelib_treedef, &gv->typelib, 0);
   ddsrt_avl_free (&ddsi_typedeps_treedef, &gv->typedeps, 0);
   ddsrt_avl_free (&ddsi_typedeps_reverse_treedef, &gv->typedeps_reverse, 0);
+  ddsrt_avl_free (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse, 0);
+  ddsrt_avl_free (&ddsi_type_assignable_treedef, &gv->type_assignable, 0);
   ddsrt_mutex_destroy (&gv->typelib_lock);
   ddsrt_cond_destroy (&gv->typelib_resolved_cond);
 #endif
@@ -1697,8 +1797,6 @@ err_unicast_sockets:
   ddsi_xqos_fini (&gv->builtin_endpoint_xqos_rd);
   ddsi_xqos_fini (&gv->spdp_endpoint_xqos);
   ddsi_xqos_fini (&gv->default_local_xqos_pp);
-
-  ddsi_xmsgpool_free (gv->xmsgpool);
 err_set_ext_address:
   while (gv->recvips)
   {
@@ -1713,6 +1811,8 @@ err_gather_nwif:
     ddsrt_free (gv->interfaces[i].name);
   ddsi_tran_factories_fini (gv);
 err_udp_tcp_init:
+  ddsi_compression_fini (gv);
+err_compression:
   return -1;
 }
 
@@ -1721,14 +1821,27 @@ int ddsi_start (struct ddsi_domaingv *gv)
   ddsi_gcreq_queue_start (gv->gcreq_queue);
 
   ddsi_dqueue_start (gv->builtins_dqueue);
-  ddsi_dqueue_start (gv->user_dqueue);
+  for (uint32_t i = 0; i < gv->n_user_dqueues; i++)
+    ddsi_dqueue_start (gv->user_dqueues[i]);
 
   if (ddsi_xeventq_start (gv->xevents, NULL) < 0)
     return -1;
+  for (uint32_t i = 1; i < gv->n_endpoint_xevents; i++)
+  {
+    char name[16];
+    (void) snprintf (name, sizeof (name), "%"PRIu32, i);
+    if (ddsi_xeventq_start (gv->endpoint_xevents[i], name) < 0)
+    {
+      while (i-- > 0)
+        ddsi_xeventq_stop (gv->endpoint_xevents[i]);
+      return -1;
+    }
+  }
 
   if (gv->config.transport_selector != DDSI_TRANS_NONE && setup_and_start_recv_threads (gv) < 0)
   {
-    ddsi_xeventq_stop (gv->xevents);
+    for (uint32_t i = 0; i < gv->n_endpoint_xevents; i++)
+      ddsi_xeventq_stop (gv->endpoint_xevents[i]);
     return -1;
   }
   if (gv->listener)
@@ -1801,7 +1914,8 @@ void ddsi_stop (struct ddsi_domaingv *gv)
     ddsi_listener_free(gv->listener);
   }
 
-  ddsi_xeventq_stop (gv->xevents);
+  for (uint32_t i = 0; i < gv->n_endpoint_xevents; i++)
+    ddsi_xeventq_stop (gv->endpoint_xevents[i]);
 
   /* Send a bubble through the delivery queue for built-ins, so that any
      pending proxy participant discovery is finished before we start
@@ -1933,12 +2047,17 @@ void ddsi_fini (struct ddsi_domaingv *gv)
      has ended, so now we can drain the delivery queues to end up with
      the expected reference counts all over the radmin thingummies. */
   ddsi_dqueue_free (gv->builtins_dqueue);
-  ddsi_dqueue_free (gv->user_dqueue);
+  for (uint32_t i = 0; i < gv->n_user_dqueues; i++)
+    ddsi_dqueue_free (gv->user_dqueues[i]);
+  ddsrt_free (gv->user_dqueues);
 
 #ifdef DDS_HAS_SECURITY
   ddsi_omg_security_deinit (gv->security_context);
 #endif
 
+  for (uint32_t i = 1; i < gv->n_endpoint_xevents; i++)
+    ddsi_xeventq_free (gv->endpoint_xevents[i]);
+  ddsrt_free (gv->endpoint_xevents);
   ddsi_xeventq_free (gv->xevents);
 
   // if sendq thread is started
@@ -1973,10 +2092,13 @@ void ddsi_fini (struct ddsi_domaingv *gv)
   {
     if (gv->recv_threads[i].arg.mode == DDSI_RTM_MANY)
       ddsi_sock_waitset_free (gv->recv_threads[i].arg.u.many.ws);
+    else if (gv->recv_threads[i].arg.u.single.ws)
+      ddsi_sock_waitset_free (gv->recv_threads[i].arg.u.single.ws);
     ddsi_rbufpool_free (gv->recv_threads[i].arg.rbpool);
   }
 
   ddsi_tkmap_free (gv->m_tkmap);
+  ddsi_compression_fini (gv);
   ddsi_entity_index_free (gv->entity_index);
   gv->entity_index = NULL;
   ddsi_deleted_participants_admin_free (gv->deleted_participants);
@@ -2002,11 +2124,14 @@ void ddsi_fini (struct ddsi_domaingv *gv)
     assert(ddsrt_avl_is_empty(&gv->typelib));
     assert(ddsrt_avl_is_empty(&gv->typedeps));
     assert(ddsrt_avl_is_empty(&gv->typedeps_reverse));
+    assert(ddsrt_avl_is_empty(&gv->type_assignable));
   }
 #endif
   ddsrt_avl_free (&ddsi_typelib_treedef, &gv->typelib, 0);
   ddsrt_avl_free (&ddsi_typedeps_treedef, &gv->typedeps, 0);
   ddsrt_avl_free (&ddsi_typedeps_reverse_treedef, &gv->typedeps_reverse, 0);
+  ddsrt_avl_free (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse, 0);
+  ddsrt_avl_free (&ddsi_type_assignable_treedef, &gv->type_assignable, 0);
   ddsrt_mutex_destroy (&gv->typelib_lock);
 #endif /* DDS_HAS_TYPELIB */
 #ifndef NDEBUG
@@ -2048,6 +2173,5 @@ void ddsi_fini (struct ddsi_domaingv *gv)
   for (int i = 0; i < (int) gv->n_interfaces; i++)
     ddsrt_free (gv->interfaces[i].name);
 
-  ddsi_xmsgpool_free (gv->xmsgpool);
   GVLOG (DDS_LC_CONFIG, "Finis.\n");
 }
@@ -76,8 +76,8 @@ int ddsi_lat_estim_log (uint32_t logcat, const struct ddsrt_log_cfg *logcfg, con
   }
 }
 
-#if 0 /* not implemented yet */
 double ddsi_lat_estim_current (const struct ddsi_lat_estim *le)
 {
+  /* 0 until the median window has been filled once */
+  return le->smoothed;
 }
-#endif
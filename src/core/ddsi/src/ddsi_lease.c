@@ -14,7 +14,7 @@
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/sync.h"
-#include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
 #include "dds/ddsi/ddsi_log.h"
 #include "dds/ddsi/ddsi_plist.h"
 #include "dds/ddsi/ddsi_unused.h"
@@ -39,20 +39,11 @@
    != 0 -- and note that it had better be 2's complement machine! */
 #define TSCHED_NOT_ON_HEAP INT64_MIN
 
-const ddsrt_fibheap_def_t lease_fhdef = DDSRT_FIBHEAPDEF_INITIALIZER (offsetof (struct ddsi_lease, heapnode), ddsi_compare_lease_tsched);
-
 static void force_lease_check (struct ddsi_gcreq_queue *gcreq_queue)
 {
   ddsi_gcreq_enqueue (ddsi_gcreq_new (gcreq_queue, ddsi_gcreq_free));
 }
 
-int ddsi_compare_lease_tsched (const void *va, const void *vb)
-{
-  const struct ddsi_lease *a = va;
-  const struct ddsi_lease *b = vb;
-  return (a->tsched.v == b->tsched.v) ? 0 : (a->tsched.v < b->tsched.v) ? -1 : 1;
-}
-
 int ddsi_compare_lease_tdur (const void *va, const void *vb)
 {
   const struct ddsi_lease *a = va;
@@ -63,12 +54,12 @@ int ddsi_compare_lease_tdur (const void *va, const void *vb)
 void ddsi_lease_management_init (struct ddsi_domaingv *gv)
 {
   ddsrt_mutex_init (&gv->leaseheap_lock);
-  ddsrt_fibheap_init (&lease_fhdef, &gv->leaseheap);
+  ddsrt_timerwheel_init (&gv->leasewheel);
 }
 
 void ddsi_lease_management_term (struct ddsi_domaingv *gv)
 {
-  assert (ddsrt_fibheap_min (&lease_fhdef, &gv->leaseheap) == NULL);
+  ddsrt_timerwheel_fini (&gv->leasewheel);
   ddsrt_mutex_destroy (&gv->leaseheap_lock);
 }
 
@@ -109,7 +100,7 @@ void ddsi_lease_register (struct ddsi_lease *l) /* FIXME: make lease admin struc
   if (tend != DDS_NEVER)
   {
     l->tsched.v = tend;
-    ddsrt_fibheap_insert (&lease_fhdef, &gv->leaseheap, l);
+    (void) ddsrt_timerwheel_insert (&gv->leasewheel, &l->twnode, l->tsched.v);
   }
   ddsrt_mutex_unlock (&gv->leaseheap_lock);
 
@@ -124,7 +115,7 @@ void ddsi_lease_unregister (struct ddsi_lease *l)
   ddsrt_mutex_lock (&gv->leaseheap_lock);
   if (l->tsched.v != TSCHED_NOT_ON_HEAP)
   {
-    ddsrt_fibheap_delete (&lease_fhdef, &gv->leaseheap, l);
+    ddsrt_timerwheel_delete (&gv->leasewheel, &l->twnode);
     l->tsched.v = TSCHED_NOT_ON_HEAP;
   }
   ddsrt_mutex_unlock (&gv->leaseheap_lock);
@@ -189,7 +180,8 @@ void ddsi_lease_set_expiry (struct ddsi_lease *l, ddsrt_etime_t when)
     /* moved forward and currently scheduled (by virtue of
        TSCHED_NOT_ON_HEAP == INT64_MIN) */
     l->tsched = when;
-    ddsrt_fibheap_decrease_key (&lease_fhdef, &gv->leaseheap, l);
+    ddsrt_timerwheel_delete (&gv->leasewheel, &l->twnode);
+    (void) ddsrt_timerwheel_insert (&gv->leasewheel, &l->twnode, l->tsched.v);
     trace_lease_renew (l, "earlier ", when);
     trigger = true;
   }
@@ -197,7 +189,7 @@ void ddsi_lease_set_expiry (struct ddsi_lease *l, ddsrt_etime_t when)
   {
     /* not currently scheduled, with a finite new expiry time */
     l->tsched = when;
-    ddsrt_fibheap_insert (&lease_fhdef, &gv->leaseheap, l);
+    (void) ddsrt_timerwheel_insert (&gv->leasewheel, &l->twnode, l->tsched.v);
     trace_lease_renew (l, "insert ", when);
     trigger = true;
   }
@@ -210,16 +202,16 @@ void ddsi_lease_set_expiry (struct ddsi_lease *l, ddsrt_etime_t when)
 
 int64_t ddsi_check_and_handle_lease_expiration (struct ddsi_domaingv *gv, ddsrt_etime_t tnowE)
 {
-  struct ddsi_lease *l;
-  int64_t delay;
+  ddsrt_timerwheel_node_t *twnode;
+  int64_t delay, tnext;
   ddsrt_mutex_lock (&gv->leaseheap_lock);
-  while ((l = ddsrt_fibheap_min (&lease_fhdef, &gv->leaseheap)) != NULL && l->tsched.v <= tnowE.v)
+  while ((twnode = ddsrt_timerwheel_extract_expired (&gv->leasewheel, tnowE.v)) != NULL)
   {
+    struct ddsi_lease * const l = (struct ddsi_lease *) ((char *) twnode - offsetof (struct ddsi_lease, twnode));
     ddsi_guid_t g = l->entity->guid;
     enum ddsi_entity_kind k = l->entity->kind;
 
-    assert (l->tsched.v != TSCHED_NOT_ON_HEAP);
-    ddsrt_fibheap_extract_min (&lease_fhdef, &gv->leaseheap);
+    assert (l->tsched.v != TSCHED_NOT_ON_HEAP && l->tsched.v <= tnowE.v);
     /* only possible concurrent action is to move tend into the future (renew_lease),
        all other operations occur with leaseheap_lock held */
     int64_t tend = (int64_t) ddsrt_atomic_ld64 (&l->tend);
@@ -230,7 +222,7 @@ int64_t ddsi_check_and_handle_lease_expiration (struct ddsi_domaingv *gv, ddsrt_
         l->tsched.v = TSCHED_NOT_ON_HEAP;
       } else {
         l->tsched.v = tend;
-        ddsrt_fibheap_insert (&lease_fhdef, &gv->leaseheap, l);
+        (void) ddsrt_timerwheel_insert (&gv->leasewheel, &l->twnode, l->tsched.v);
       }
       continue;
     }
@@ -270,7 +262,7 @@ int64_t ddsi_check_and_handle_lease_expiration (struct ddsi_domaingv *gv, ddsrt_
       {
         GVLOGDISC ("but postponing because privileged pp "PGUIDFMT" is still live\n", PGUID (proxypp->privileged_pp_guid));
         l->tsched = ddsrt_etime_add_duration (tnowE, DDS_MSECS (200));
-        ddsrt_fibheap_insert (&lease_fhdef, &gv->leaseheap, l);
+        (void) ddsrt_timerwheel_insert (&gv->leasewheel, &l->twnode, l->tsched.v);
         continue;
       }
     }
@@ -299,7 +291,10 @@ int64_t ddsi_check_and_handle_lease_expiration (struct ddsi_domaingv *gv, ddsrt_
     ddsrt_mutex_lock (&gv->leaseheap_lock);
   }
 
-  delay = (l == NULL) ? DDS_INFINITY : (l->tsched.v - tnowE.v);
+  /* the wheel may return a time at which nothing expires yet, that merely causes
+     an early wake-up */
+  tnext = ddsrt_timerwheel_next (&gv->leasewheel);
+  delay = (tnext == INT64_MAX) ? DDS_INFINITY : (tnext - tnowE.v);
   ddsrt_mutex_unlock (&gv->leaseheap_lock);
   return delay;
 }
@@ -11,19 +11,10 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include "dds/ddsrt/heap.h"
-#include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
 #include "dds/ddsi/ddsi_lifespan.h"
 #include "ddsi__xevent.h"
 
-static int compare_lifespan_texp (const void *va, const void *vb)
-{
-  const struct ddsi_lifespan_fhnode *a = va;
-  const struct ddsi_lifespan_fhnode *b = vb;
-  return (a->t_expire.v == b->t_expire.v) ? 0 : (a->t_expire.v < b->t_expire.v) ? -1 : 1;
-}
-
-const ddsrt_fibheap_def_t lifespan_fhdef = DDSRT_FIBHEAPDEF_INITIALIZER(offsetof (struct ddsi_lifespan_fhnode, heapnode), compare_lifespan_texp);
-
 struct lifespan_rhc_node_exp_arg {
   struct ddsi_lifespan_adm *lifespan_adm;
 };
@@ -39,24 +30,24 @@ static void lifespan_rhc_node_exp (struct ddsi_domaingv *gv, struct ddsi_xevent
 }
 
 
-/* Gets the sample from the fibheap in lifespan admin that was expired first. If no more
- * expired samples exist in the fibheap, the expiry time (ddsrt_mtime_t) for the next sample to
- * expire is returned. If the fibheap contains no more samples, DDSRT_MTIME_NEVER is returned */
-ddsrt_mtime_t ddsi_lifespan_next_expired_locked (const struct ddsi_lifespan_adm *lifespan_adm, ddsrt_mtime_t tnow, void **sample)
+/* Gets a sample from the timer wheel in lifespan admin that has expired. If no more expired
+ * samples exist in the timer wheel, a time at or before which the next sample expires is
+ * returned. If the timer wheel contains no more samples, DDSRT_MTIME_NEVER is returned */
+ddsrt_mtime_t ddsi_lifespan_next_expired_locked (struct ddsi_lifespan_adm *lifespan_adm, ddsrt_mtime_t tnow, void **sample)
 {
-  struct ddsi_lifespan_fhnode *node;
-  if ((node = ddsrt_fibheap_min(&lifespan_fhdef, &lifespan_adm->ls_exp_heap)) != NULL && node->t_expire.v <= tnow.v)
+  ddsrt_timerwheel_node_t *twnode;
+  if ((twnode = ddsrt_timerwheel_peek_expired (&lifespan_adm->ls_exp_tw, tnow.v)) != NULL)
   {
-    *sample = (char *)node - lifespan_adm->fhn_offset;
+    *sample = (char *)twnode - offsetof (struct ddsi_lifespan_fhnode, twnode) - lifespan_adm->fhn_offset;
     return (ddsrt_mtime_t) { 0 };
   }
   *sample = NULL;
-  return (node != NULL) ? node->t_expire : DDSRT_MTIME_NEVER;
+  return (ddsrt_mtime_t) { ddsrt_timerwheel_next (&lifespan_adm->ls_exp_tw) };
 }
 
 void ddsi_lifespan_init (const struct ddsi_domaingv *gv, struct ddsi_lifespan_adm *lifespan_adm, size_t fh_offset, size_t fh_node_offset, ddsi_sample_expired_cb_t sample_expired_cb)
 {
-  ddsrt_fibheap_init (&lifespan_fhdef, &lifespan_adm->ls_exp_heap);
+  ddsrt_timerwheel_init (&lifespan_adm->ls_exp_tw);
   struct lifespan_rhc_node_exp_arg arg = { .lifespan_adm = lifespan_adm };
   lifespan_adm->evt = ddsi_qxev_callback (gv->xevents, DDSRT_MTIME_NEVER, lifespan_rhc_node_exp, &arg, sizeof (arg), true);
   lifespan_adm->sample_expired_cb = sample_expired_cb;
@@ -64,18 +55,19 @@ void ddsi_lifespan_init (const struct ddsi_domaingv *gv, struct ddsi_lifespan_ad
   lifespan_adm->fhn_offset = fh_node_offset;
 }
 
-void ddsi_lifespan_fini (const struct ddsi_lifespan_adm *lifespan_adm)
+void ddsi_lifespan_fini (struct ddsi_lifespan_adm *lifespan_adm)
 {
-  assert (ddsrt_fibheap_min (&lifespan_fhdef, &lifespan_adm->ls_exp_heap) == NULL);
+  assert (ddsrt_timerwheel_empty (&lifespan_adm->ls_exp_tw));
   ddsi_delete_xevent (lifespan_adm->evt);
+  ddsrt_timerwheel_fini (&lifespan_adm->ls_exp_tw);
 }
 
 extern inline void ddsi_lifespan_register_sample_locked (struct ddsi_lifespan_adm *lifespan_adm, struct ddsi_lifespan_fhnode *node);
 
 void ddsi_lifespan_register_sample_real (struct ddsi_lifespan_adm *lifespan_adm, struct ddsi_lifespan_fhnode *node)
 {
-  ddsrt_fibheap_insert(&lifespan_fhdef, &lifespan_adm->ls_exp_heap, node);
-  ddsi_resched_xevent_if_earlier (lifespan_adm->evt, node->t_expire);
+  const int64_t tdue = ddsrt_timerwheel_insert (&lifespan_adm->ls_exp_tw, &node->twnode, node->t_expire.v);
+  ddsi_resched_xevent_if_earlier (lifespan_adm->evt, (ddsrt_mtime_t) { tdue });
 }
 
 extern inline void ddsi_lifespan_unregister_sample_locked (struct ddsi_lifespan_adm *lifespan_adm, struct ddsi_lifespan_fhnode *node);
@@ -85,6 +77,6 @@ void ddsi_lifespan_unregister_sample_real (struct ddsi_lifespan_adm *lifespan_ad
   /* Updating the scheduled event with the new shortest expiry
    * is not required, because the event will be rescheduled when
    * this removed node expires. Only remove the node from the
-   * lifespan heap */
-  ddsrt_fibheap_delete(&lifespan_fhdef, &lifespan_adm->ls_exp_heap, node);
+   * lifespan timer wheel */
+  ddsrt_timerwheel_delete (&lifespan_adm->ls_exp_tw, &node->twnode);
 }
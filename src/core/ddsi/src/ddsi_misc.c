@@ -84,3 +84,7 @@ int ddsi_patmatch (const char *pat, const char *str)
   return *str == 0;
 }
 
+bool ddsi_is_wildcard_partition (const char *str)
+{
+  return strchr (str, '*') || strchr (str, '?');
+}
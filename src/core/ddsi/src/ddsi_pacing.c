@@ -0,0 +1,102 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+
+#include "dds/ddsi/ddsi_config.h"
+#include "ddsi__pacing.h"
+
+#define PACING_WINDOW DDS_SECS (1)
+
+void ddsi_pacing_init (struct ddsi_pacing *p, const struct ddsi_config *config, bool enable, ddsrt_mtime_t tnow)
+{
+  p->rate = enable ? config->pacing_max_rate : 0;
+  p->tokens = (double) config->pacing_burst_size;
+  p->t_refill = tnow;
+  p->t_adjust = tnow;
+  p->t_backoff.v = 0; // first loss should always count
+  p->rtt = config->pacing_rtt;
+  p->waiting = 0;
+  p->backoff_count = 0;
+  p->time_paced = 0;
+  p->t_window = tnow;
+  p->window_bytes = 0;
+  p->achieved_rate = 0;
+}
+
+int64_t ddsi_pacing_take (struct ddsi_pacing *p, const struct ddsi_config *config, uint32_t size, ddsrt_mtime_t tnow)
+{
+  assert (p->rate > 0);
+  if (tnow.v > p->t_refill.v)
+  {
+    // tokens may be negative because a previous writer is still waiting for its turn, it
+    // should be paid off before handing out new ones
+    p->tokens += (double) p->rate * (double) (tnow.v - p->t_refill.v) * 1e-9;
+    if (p->tokens > (double) config->pacing_burst_size)
+      p->tokens = (double) config->pacing_burst_size;
+    p->t_refill = tnow;
+  }
+  p->tokens -= (double) size;
+
+  if (tnow.v - p->t_window.v >= PACING_WINDOW)
+  {
+    p->achieved_rate = (uint64_t) ((double) p->window_bytes * 1e9 / (double) (tnow.v - p->t_window.v));
+    p->window_bytes = 0;
+    p->t_window = tnow;
+  }
+  p->window_bytes += size;
+
+  if (p->tokens >= 0.0)
+    return 0;
+  return (int64_t) (-p->tokens * 1e9 / (double) p->rate);
+}
+
+bool ddsi_pacing_note_acknack (struct ddsi_pacing *p, const struct ddsi_config *config, bool nack, ddsrt_mtime_t tnow)
+{
+  assert (p->rate > 0);
+  if (nack)
+  {
+    // all losses in a round-trip are presumably caused by the same burst, an
+    // increase in the meantime shouldn't result in backing off again
+    if (tnow.v - p->t_backoff.v < p->rtt)
+      return false;
+    p->rate /= 2;
+    if (p->rate < config->pacing_min_rate)
+      p->rate = config->pacing_min_rate;
+    // a minimum rate of 0 would disable pacing altogether
+    if (p->rate == 0)
+      p->rate = 1;
+    p->backoff_count++;
+    p->t_backoff = p->t_adjust = tnow;
+    return true;
+  }
+  else if (tnow.v - p->t_adjust.v >= p->rtt)
+  {
+    p->rate += config->pacing_increase;
+    if (p->rate > config->pacing_max_rate)
+      p->rate = config->pacing_max_rate;
+    p->t_adjust = tnow;
+  }
+  return false;
+}
+
+void ddsi_pacing_note_rtt (struct ddsi_pacing *p, int64_t rtt)
+{
+  if (rtt > 0)
+    p->rtt = rtt;
+}
+
+uint64_t ddsi_pacing_achieved_rate (const struct ddsi_pacing *p, ddsrt_mtime_t tnow)
+{
+  // a writer that stopped writing would otherwise report its last rate indefinitely
+  if (tnow.v - p->t_window.v >= PACING_WINDOW)
+    return (uint64_t) ((double) p->window_bytes * 1e9 / (double) (tnow.v - p->t_window.v));
+  return p->achieved_rate;
+}
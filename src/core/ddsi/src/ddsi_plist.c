@@ -2052,6 +2052,7 @@ static const struct piddesc piddesc_omg[] = {
   PP  (EXPECTS_INLINE_QOS,                  expects_inline_qos, Xb),
   PP  (PARTICIPANT_MANUAL_LIVELINESS_COUNT, participant_manual_liveliness_count, Xi),
   PP  (PARTICIPANT_BUILTIN_ENDPOINTS,       participant_builtin_endpoints, Xu),
+  PP  (CONTENT_FILTER_PROPERTY,             content_filter_property, XS, XS, XS, XS, XQ, XS, XSTOP),
   PPV (PARTICIPANT_GUID,                    participant_guid, XG),
   PPV (GROUP_GUID,                          group_guid, XG),
   PP  (BUILTIN_ENDPOINT_SET,                builtin_endpoint_set, Xu),
@@ -2128,6 +2129,8 @@ static const struct piddesc piddesc_eclipse[] = {
   PP  (CYCLONE_RECEIVE_BUFFER_SIZE,      cyclone_receive_buffer_size, Xu),
   PP  (CYCLONE_REQUESTS_KEYHASH,         cyclone_requests_keyhash, Xb),
   PP  (CYCLONE_REDUNDANT_NETWORKING,     cyclone_redundant_networking, Xb),
+  PP  (CYCLONE_ACCEPTED_COMPRESSION,     cyclone_accepted_compression, Xu),
+  PP  (CYCLONE_WRITER_COMPRESSION,       cyclone_writer_compression, Xu),
   { DDSI_PID_SENTINEL, 0, 0, NULL, 0, 0, { .desc = { XSTOP } }, 0 }
 };
 
@@ -2200,7 +2203,7 @@ struct piddesc_index {
 #endif
 
 static const struct piddesc *piddesc_omg_index[DEFAULT_OMG_PIDS_ARRAY_SIZE + SECURITY_OMG_PIDS_ARRAY_SIZE];
-static const struct piddesc *piddesc_eclipse_index[30];
+static const struct piddesc *piddesc_eclipse_index[32];
 static const struct piddesc *piddesc_adlink_index[17];
 
 #define INDEX_ANY(vendorid_, tab_) [vendorid_] = { \
@@ -2226,11 +2229,11 @@ static const struct piddesc_index piddesc_vendor_index[] = {
    initialized by ddsi_plist_init_tables; will assert when
    table too small or too large */
 #ifdef DDS_HAS_TYPELIB
+static const struct piddesc *piddesc_unalias[20 + SECURITY_PROC_ARRAY_SIZE];
+static const struct piddesc *piddesc_fini[20 + SECURITY_PROC_ARRAY_SIZE];
+#else
 static const struct piddesc *piddesc_unalias[19 + SECURITY_PROC_ARRAY_SIZE];
 static const struct piddesc *piddesc_fini[19 + SECURITY_PROC_ARRAY_SIZE];
-#else
-static const struct piddesc *piddesc_unalias[18 + SECURITY_PROC_ARRAY_SIZE];
-static const struct piddesc *piddesc_fini[18 + SECURITY_PROC_ARRAY_SIZE];
 #endif
 static uint64_t plist_fini_mask, qos_fini_mask;
 static ddsrt_once_t table_init_control = DDSRT_ONCE_INIT;
@@ -31,6 +31,8 @@
 #include "ddsi__proxy_participant.h"
 #include "ddsi__typelib.h"
 #include "ddsi__lease.h"
+#include "ddsi__ack_tracker.h"
+#include "ddsi__content_filter.h"
 
 const ddsrt_avl_treedef_t ddsi_pwr_readers_treedef =
   DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_pwr_rd_match, avlnode), offsetof (struct ddsi_pwr_rd_match, rd_guid), ddsi_compare_guid, 0);
@@ -226,10 +228,11 @@ void ddsi_send_entityid_to_prd (struct ddsi_proxy_reader *prd, const ddsi_guid_t
   if (!gv->m_factory->m_connless)
   {
     GVTRACE ("  ddsi_send_entityid_to_prd (%"PRIx32":%"PRIx32":%"PRIx32")\n", PGUIDPREFIX (guid->prefix));
-    struct ddsi_xmsg *msg = ddsi_xmsg_new (gv->xmsgpool, guid, NULL, sizeof (ddsi_rtps_entityid_t), DDSI_XMSG_KIND_CONTROL);
+    struct ddsi_xmsg *msg = ddsi_xmsg_new (guid, NULL, sizeof (ddsi_rtps_entityid_t), DDSI_XMSG_KIND_CONTROL);
     ddsi_xmsg_setdst_prd (msg, prd);
     ddsi_xmsg_add_entityid (msg);
-    ddsi_qxev_msg (gv->xevents, msg);
+    /* same queue as the data of the writer, so it identifies the connection first */
+    ddsi_qxev_msg (ddsi_xeventq_for_endpoint (gv, guid), msg);
   }
 }
 
@@ -240,10 +243,11 @@ void ddsi_send_entityid_to_pwr (struct ddsi_proxy_writer *pwr, const ddsi_guid_t
   if (!gv->m_factory->m_connless)
   {
     GVTRACE ("  ddsi_send_entityid_to_pwr (%"PRIx32":%"PRIx32":%"PRIx32")\n", PGUIDPREFIX (guid->prefix));
-    struct ddsi_xmsg *msg = ddsi_xmsg_new (gv->xmsgpool, guid, NULL, sizeof (ddsi_rtps_entityid_t), DDSI_XMSG_KIND_CONTROL);
+    struct ddsi_xmsg *msg = ddsi_xmsg_new (guid, NULL, sizeof (ddsi_rtps_entityid_t), DDSI_XMSG_KIND_CONTROL);
     ddsi_xmsg_setdst_pwr (msg, pwr);
     ddsi_xmsg_add_entityid (msg);
-    ddsi_qxev_msg (gv->xevents, msg);
+    /* same queue as the ACKNACKs of the reader */
+    ddsi_qxev_msg (pwr->evq, msg);
   }
 }
 
@@ -297,6 +301,7 @@ int ddsi_new_proxy_writer (struct ddsi_proxy_writer **proxy_writer, struct ddsi_
   pwr->alive = 1;
   pwr->alive_vclock = 0;
   pwr->filtered = 0;
+  pwr->compression_codecs = (plist->present & PP_CYCLONE_WRITER_COMPRESSION) ? plist->cyclone_writer_compression : 0;
   ddsrt_atomic_st32 (&pwr->next_deliv_seq_lowword, 1);
   if (ddsi_is_builtin_entityid (pwr->e.guid.entityid, pwr->c.vendor)) {
     /* The DDSI built-in proxy writers always deliver
@@ -642,6 +647,8 @@ int ddsi_new_proxy_reader (struct ddsi_proxy_reader **proxy_reader, struct ddsi_
   prd->is_fict_trans_reader = 0;
   prd->receive_buffer_size = proxypp->receive_buffer_size;
   prd->requests_keyhash = (plist->present & PP_CYCLONE_REQUESTS_KEYHASH) && plist->cyclone_requests_keyhash;
+  prd->accepted_compression = (plist->present & PP_CYCLONE_ACCEPTED_COMPRESSION) ? plist->cyclone_accepted_compression : 0;
+  prd->content_filter = (plist->present & PP_CONTENT_FILTER_PROPERTY) ? ddsi_content_filter_property_dup (&plist->content_filter_property) : NULL;
   if (plist->present & PP_CYCLONE_REDUNDANT_NETWORKING)
     prd->redundant_networking = (plist->cyclone_redundant_networking != 0);
   else
@@ -669,7 +676,7 @@ int ddsi_new_proxy_reader (struct ddsi_proxy_reader **proxy_reader, struct ddsi_
   return DDS_RETCODE_OK;
 }
 
-void ddsi_update_proxy_reader (struct ddsi_proxy_reader *prd, ddsi_seqno_t seq, struct ddsi_addrset *as, const struct dds_qos *xqos, ddsrt_wctime_t timestamp)
+void ddsi_update_proxy_reader (struct ddsi_proxy_reader *prd, ddsi_seqno_t seq, struct ddsi_addrset *as, const struct dds_qos *xqos, const struct ddsi_content_filter_property *content_filter, ddsrt_wctime_t timestamp)
 {
   struct ddsi_prd_wr_match * m;
   ddsi_guid_t wrguid;
@@ -679,6 +686,7 @@ void ddsi_update_proxy_reader (struct ddsi_proxy_reader *prd, ddsi_seqno_t seq,
   ddsrt_mutex_lock (&prd->e.lock);
   if (seq > prd->c.seq)
   {
+    bool addrset_changed = false, content_filter_changed = false;
     prd->c.seq = seq;
     if (! ddsi_addrset_eq_onesidederr (prd->c.as, as))
     {
@@ -687,8 +695,18 @@ void ddsi_update_proxy_reader (struct ddsi_proxy_reader *prd, ddsi_seqno_t seq,
       ddsi_unref_addrset (prd->c.as);
       ddsi_ref_addrset (as);
       prd->c.as = as;
+      addrset_changed = true;
+    }
+    if (! ddsi_content_filter_property_equal (prd->content_filter, content_filter))
+    {
+      ddsi_content_filter_property_free (prd->content_filter);
+      prd->content_filter = content_filter ? ddsi_content_filter_property_dup (content_filter) : NULL;
+      content_filter_changed = true;
+    }
 
-      /* Rebuild writer endpoints */
+    if (addrset_changed || content_filter_changed)
+    {
+      /* Rebuild writer endpoints and/or update the filters they evaluate */
 
       while ((m = ddsrt_avl_lookup_succ_eq (&ddsi_prd_writers_treedef, &prd->writers, &wrguid)) != NULL)
       {
@@ -712,10 +730,29 @@ void ddsi_update_proxy_reader (struct ddsi_proxy_reader *prd, ddsi_seqno_t seq,
         wr = ddsi_entidx_lookup_writer_guid (prd->e.gv->entity_index, &wrguid);
         if (wr)
         {
+          void *filter = NULL;
+          if (content_filter_changed)
+          {
+            ddsrt_mutex_lock (&prd->e.lock);
+            filter = ddsi_content_filter_compile (prd->e.gv->content_filter_interface, wr->type, prd->content_filter);
+            ddsrt_mutex_unlock (&prd->e.lock);
+          }
           ddsrt_mutex_lock (&wr->e.lock);
-          ddsi_rebuild_writer_addrset (wr);
+          if (content_filter_changed)
+          {
+            struct ddsi_wr_prd_match *wrm;
+            if ((wrm = ddsrt_avl_lookup (&ddsi_wr_readers_treedef, &wr->readers, &prd->e.guid)) != NULL && !wrm->via_psmx)
+            {
+              ddsi_writer_content_filter_set (wr, wrm, filter);
+              filter = NULL;
+            }
+          }
+          if (addrset_changed)
+            ddsi_rebuild_writer_addrset (wr);
           ddsrt_mutex_unlock (&wr->e.lock);
-          ddsi_send_entityid_to_prd (prd, &wr->e.guid);
+          ddsi_content_filter_free (prd->e.gv->content_filter_interface, filter);
+          if (addrset_changed)
+            ddsi_send_entityid_to_prd (prd, &wr->e.guid);
         }
         wrguid = guid_next;
         ddsrt_mutex_lock (&prd->e.lock);
@@ -760,8 +797,7 @@ static void proxy_reader_set_delete_and_ack_all_messages (struct ddsi_proxy_read
       if ((m_wr = ddsrt_avl_lookup (&ddsi_wr_readers_treedef, &wr->readers, &prd->e.guid)) != NULL)
       {
         struct ddsi_whc_state whcst;
-        m_wr->seq = DDSI_MAX_SEQ_NUMBER;
-        ddsrt_avl_augment_update (&ddsi_wr_readers_treedef, m_wr);
+        ddsi_ack_tracker_update (&wr->ack_tracker, m_wr, DDSI_MAX_SEQ_NUMBER, m_wr->has_replied_to_hb);
         (void)ddsi_remove_acked_messages (wr, &whcst, &deferred_free_list);
         ddsi_writer_clear_retransmitting (wr);
       }
@@ -800,6 +836,7 @@ static void gc_delete_proxy_reader (struct ddsi_gcreq *gcreq)
 #ifdef DDS_HAS_SECURITY
   ddsi_omg_security_deregister_remote_reader (prd);
 #endif
+  ddsi_content_filter_property_free (prd->content_filter);
   proxy_endpoint_common_fini (&prd->e, &prd->c);
   ddsrt_free (prd);
 }
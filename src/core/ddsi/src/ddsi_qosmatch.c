@@ -21,18 +21,13 @@
 #include "ddsi__typelib.h"
 #include "dds/dds.h"
 
-static int is_wildcard_partition (const char *str)
-{
-  return strchr (str, '*') || strchr (str, '?');
-}
-
 static int partition_patmatch_p (const char *pat, const char *name)
 {
   /* pat may be a wildcard expression, name must not be */
-  if (!is_wildcard_partition (pat))
+  if (!ddsi_is_wildcard_partition (pat))
     /* no wildcard in pat => must equal name */
     return (strcmp (pat, name) == 0);
-  else if (is_wildcard_partition (name))
+  else if (ddsi_is_wildcard_partition (name))
     /* (we know: wildcard in pat) => wildcard in name => no match */
     return 0;
   else
@@ -165,6 +160,12 @@ bool ddsi_qos_match_mask_p (
   *reason = DDS_INVALID_QOS_POLICY_ID;
   if ((mask & DDSI_QP_TOPIC_NAME) && strcmp (rd_qos->topic_name, wr_qos->topic_name) != 0)
     return false;
+  /* Partitions first: endpoints in disjoint partitions are not supposed to
+     match, and that is not an incompatibility of any of the other policies */
+  if ((mask & DDSI_QP_PARTITION) && !partitions_match_p (rd_qos, wr_qos)) {
+    *reason = DDS_PARTITION_QOS_POLICY_ID;
+    return false;
+  }
 
   if ((mask & DDSI_QP_RELIABILITY) && rd_qos->reliability.kind > wr_qos->reliability.kind) {
     *reason = DDS_RELIABILITY_QOS_POLICY_ID;
@@ -210,10 +211,6 @@ bool ddsi_qos_match_mask_p (
     *reason = DDS_DESTINATIONORDER_QOS_POLICY_ID;
     return false;
   }
-  if ((mask & DDSI_QP_PARTITION) && !partitions_match_p (rd_qos, wr_qos)) {
-    *reason = DDS_PARTITION_QOS_POLICY_ID;
-    return false;
-  }
   if ((mask & DDSI_QP_DATA_REPRESENTATION) && !data_representation_match_p (rd_qos, wr_qos)) {
     *reason = DDS_DATA_REPRESENTATION_QOS_POLICY_ID;
     return false;
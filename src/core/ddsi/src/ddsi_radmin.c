@@ -280,11 +280,31 @@ struct ddsi_rbufpool {
   uint32_t max_rmsg_size;
   const struct ddsrt_log_cfg *logcfg;
   bool trace;
-#ifndef NDEBUG
-  /* Thread that owns this pool, so we can check that no other thread
-     is calling functions only the owner may use. */
+
+  /* State of the batch allocated by ddsi_rmsg_new_batch, only touched
+     by the owner: the rbuf containing it (NULL if none), the end of
+     the reserved area and the end of the retained part of it. */
+  struct ddsi_rbuf *batch_rbuf;
+  unsigned char *batch_end;
+  unsigned char *batch_keep;
+
+  /* Slab mode (max_cached_slabs > 0): every rbuf is exactly large
+     enough for a single rmsg of the maximum size, so a message held
+     in a delivery queue only pins its own memory.  Released slabs are
+     kept for reuse instead of being freed: the owner pushes them on
+     its private magazine ("slabs"), any other thread pushes them on a
+     lock-free stack ("returned") that the owner takes over in one go
+     when its magazine runs empty.  The magazine is limited to
+     max_cached_slabs entries, any surplus is freed. */
+  uint32_t max_cached_slabs;
+  uint32_t n_cached_slabs;
+  struct ddsi_rbuf *slabs;
+  ddsrt_atomic_voidp_t returned;
+
+  /* Thread that owns this pool, used for checking that no other thread
+     is calling functions only the owner may use, and in slab mode to
+     decide where a released slab goes. */
   ddsrt_thread_t owner_tid;
-#endif
 };
 
 static struct ddsi_rbuf *ddsi_rbuf_alloc_new (struct ddsi_rbufpool *rbp);
@@ -330,24 +350,13 @@ static uint32_t max_rmsg_size_w_hdr (uint32_t max_rmsg_size)
     + max_rmsg_size;
 }
 
-struct ddsi_rbufpool *ddsi_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size)
+static struct ddsi_rbufpool *rbufpool_new_common (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size, uint32_t max_cached_slabs)
 {
   struct ddsi_rbufpool *rbp;
 
-  assert (max_rmsg_size > 0);
-
-  /* raise rbuf_size to minimum possible considering max_rmsg_size, there is
-     no reason to bother the user with the small difference between the two
-     when he tries to configure things, and the crash is horrible when
-     rbuf_size is too small */
-  if (rbuf_size < max_rmsg_size_w_hdr (max_rmsg_size))
-    rbuf_size = max_rmsg_size_w_hdr (max_rmsg_size);
-
   if ((rbp = ddsrt_malloc (sizeof (*rbp))) == NULL)
     goto fail_rbp;
-#ifndef NDEBUG
   rbp->owner_tid = ddsrt_thread_self ();
-#endif
 
   ddsrt_mutex_init (&rbp->lock);
 
@@ -355,6 +364,13 @@ struct ddsi_rbufpool *ddsi_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uin
   rbp->max_rmsg_size = max_rmsg_size;
   rbp->logcfg = logcfg;
   rbp->trace = (logcfg->c.mask & DDS_LC_RADMIN) != 0;
+  rbp->batch_rbuf = NULL;
+  rbp->batch_end = NULL;
+  rbp->batch_keep = NULL;
+  rbp->max_cached_slabs = max_cached_slabs;
+  rbp->n_cached_slabs = 0;
+  rbp->slabs = NULL;
+  ddsrt_atomic_stvoidp (&rbp->returned, NULL);
 
 #if USE_VALGRIND
   VALGRIND_CREATE_MEMPOOL (rbp, 0, 0);
@@ -374,13 +390,35 @@ struct ddsi_rbufpool *ddsi_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uin
   return NULL;
 }
 
-void ddsi_rbufpool_setowner (UNUSED_ARG_NDEBUG (struct ddsi_rbufpool *rbp), UNUSED_ARG_NDEBUG (ddsrt_thread_t tid))
+struct ddsi_rbufpool *ddsi_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_t rbuf_size, uint32_t max_rmsg_size)
+{
+  assert (max_rmsg_size > 0);
+
+  /* raise rbuf_size to minimum possible considering max_rmsg_size, there is
+     no reason to bother the user with the small difference between the two
+     when he tries to configure things, and the crash is horrible when
+     rbuf_size is too small */
+  if (rbuf_size < max_rmsg_size_w_hdr (max_rmsg_size))
+    rbuf_size = max_rmsg_size_w_hdr (max_rmsg_size);
+  return rbufpool_new_common (logcfg, rbuf_size, max_rmsg_size, 0);
+}
+
+struct ddsi_rbufpool *ddsi_rbufpool_new_slab (const struct ddsrt_log_cfg *logcfg, uint32_t max_rmsg_size, uint32_t max_cached_slabs)
+{
+  assert (max_rmsg_size > 0);
+  assert (max_cached_slabs > 0);
+  /* aligned so that a batch of rmsgs can be laid out exactly as it would
+     be in an ordinary rbuf (see ddsi_rmsg_new_batch) */
+  return rbufpool_new_common (logcfg, align_rmsg (max_rmsg_size_w_hdr (max_rmsg_size)), max_rmsg_size, max_cached_slabs);
+}
+
+void ddsi_rbufpool_setowner (struct ddsi_rbufpool *rbp, ddsrt_thread_t tid)
 {
-#ifndef NDEBUG
   rbp->owner_tid = tid;
-#endif
 }
 
+static void rbufpool_free_slabs (struct ddsi_rbuf *rb);
+
 void ddsi_rbufpool_free (struct ddsi_rbufpool *rbp)
 {
 #if 0
@@ -391,6 +429,8 @@ void ddsi_rbufpool_free (struct ddsi_rbufpool *rbp)
   ASSERT_RBUFPOOL_OWNER (rbp);
 #endif
   ddsi_rbuf_release (rbp->current);
+  rbufpool_free_slabs (rbp->slabs);
+  rbufpool_free_slabs (ddsrt_atomic_ldvoidp (&rbp->returned));
 #if USE_VALGRIND
   VALGRIND_DESTROY_MEMPOOL (rbp);
 #endif
@@ -413,6 +453,9 @@ struct ddsi_rbuf {
      approach.  Changes would be confined rmsg_new and rmsg_free. */
   unsigned char *freeptr;
 
+  /* Link in the list of cached slabs, only meaningful while cached */
+  struct ddsi_rbuf *next_slab;
+
   /* to ensure reasonable alignment of raw[] */
   union {
     int64_t l;
@@ -424,12 +467,69 @@ struct ddsi_rbuf {
   unsigned char raw[];
 };
 
+static void rbufpool_free_slabs (struct ddsi_rbuf *rb)
+{
+  while (rb)
+  {
+    struct ddsi_rbuf *next = rb->next_slab;
+    ddsrt_free (rb);
+    rb = next;
+  }
+}
+
+static struct ddsi_rbuf *rbufpool_take_returned_slabs (struct ddsi_rbufpool *rbp)
+{
+  /* Taking the entire stack means there is no ABA problem */
+  void *head;
+  do {
+    head = ddsrt_atomic_ldvoidp (&rbp->returned);
+  } while (head != NULL && !ddsrt_atomic_casvoidp (&rbp->returned, head, NULL));
+  return head;
+}
+
+static void rbufpool_cache_slab (struct ddsi_rbufpool *rbp, struct ddsi_rbuf *rb)
+{
+  /* Only the owner touches the magazine */
+  if (rbp->n_cached_slabs >= rbp->max_cached_slabs)
+    ddsrt_free (rb);
+  else
+  {
+    rb->next_slab = rbp->slabs;
+    rbp->slabs = rb;
+    rbp->n_cached_slabs++;
+  }
+}
+
+static struct ddsi_rbuf *rbufpool_get_slab (struct ddsi_rbufpool *rbp)
+{
+  struct ddsi_rbuf *rb;
+  if (rbp->slabs == NULL)
+  {
+    rb = rbufpool_take_returned_slabs (rbp);
+    while (rb)
+    {
+      struct ddsi_rbuf *next = rb->next_slab;
+      rbufpool_cache_slab (rbp, rb);
+      rb = next;
+    }
+  }
+  if ((rb = rbp->slabs) == NULL)
+    return ddsrt_malloc (sizeof (struct ddsi_rbuf) + rbp->rbuf_size);
+  rbp->slabs = rb->next_slab;
+  rbp->n_cached_slabs--;
+  return rb;
+}
+
 static struct ddsi_rbuf *ddsi_rbuf_alloc_new (struct ddsi_rbufpool *rbp)
 {
   struct ddsi_rbuf *rb;
   ASSERT_RBUFPOOL_OWNER (rbp);
 
-  if ((rb = ddsrt_malloc (sizeof (struct ddsi_rbuf) + rbp->rbuf_size)) == NULL)
+  if (rbp->max_cached_slabs > 0)
+    rb = rbufpool_get_slab (rbp);
+  else
+    rb = ddsrt_malloc (sizeof (struct ddsi_rbuf) + rbp->rbuf_size);
+  if (rb == NULL)
     return NULL;
 #if USE_VALGRIND
   VALGRIND_MAKE_MEM_NOACCESS (rb->raw, rbp->rbuf_size);
@@ -467,7 +567,18 @@ static void ddsi_rbuf_release (struct ddsi_rbuf *rbuf)
   if (ddsrt_atomic_dec32_ov (&rbuf->n_live_rmsg_chunks) == 1)
   {
     RBPTRACE ("rbuf_release(%p) free\n", (void *) rbuf);
-    ddsrt_free (rbuf);
+    if (rbp->max_cached_slabs == 0)
+      ddsrt_free (rbuf);
+    else if (ddsrt_thread_equal (ddsrt_thread_self (), rbp->owner_tid))
+      rbufpool_cache_slab (rbp, rbuf);
+    else
+    {
+      void *head;
+      do {
+        head = ddsrt_atomic_ldvoidp (&rbp->returned);
+        rbuf->next_slab = head;
+      } while (!ddsrt_atomic_casvoidp (&rbp->returned, head, rbuf));
+    }
   }
 }
 
@@ -525,6 +636,16 @@ static void init_rmsg_chunk (struct ddsi_rmsg_chunk *chunk, struct ddsi_rbuf *rb
   ddsrt_atomic_inc32 (&rbuf->n_live_rmsg_chunks);
 }
 
+static void init_rmsg (struct ddsi_rmsg *rmsg, struct ddsi_rbufpool *rbp)
+{
+  /* Reference to this rmsg, undone by rmsg_commit(). */
+  ddsrt_atomic_st32 (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS);
+  /* Initial chunk */
+  init_rmsg_chunk (&rmsg->chunk, rbp->current);
+  rmsg->trace = rbp->trace;
+  rmsg->lastchunk = &rmsg->chunk;
+}
+
 struct ddsi_rmsg *ddsi_rmsg_new (struct ddsi_rbufpool *rbp)
 {
   /* Note: only one thread calls ddsi_rmsg_new on a pool */
@@ -535,18 +656,105 @@ struct ddsi_rmsg *ddsi_rmsg_new (struct ddsi_rbufpool *rbp)
   if (rmsg == NULL)
     return NULL;
 
-  /* Reference to this rmsg, undone by rmsg_commit(). */
-  ddsrt_atomic_st32 (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS);
-  /* Initial chunk */
-  init_rmsg_chunk (&rmsg->chunk, rbp->current);
-  rmsg->trace = rbp->trace;
-  rmsg->lastchunk = &rmsg->chunk;
+  init_rmsg (rmsg, rbp);
   /* Incrementing freeptr happens in commit(), so that discarding the
      message is really simple. */
   RBPTRACE ("rmsg_new(%p) = %p\n", (void *) rbp, (void *) rmsg);
   return rmsg;
 }
 
+static uint32_t rmsg_new_batch_slab (struct ddsi_rbufpool *rbp, uint32_t n, struct ddsi_rmsg **rmsgs)
+{
+  /* In slab mode every rmsg in the batch gets a slab of its own.  All
+     but the last are no longer current by the time they are committed,
+     and so get released to the pool when the last reference goes.  Each
+     is marked as full so that a new chunk allocated while processing
+     the batch never ends up in the same slab.  The last one is handled
+     like an ordinary batch, so it can be reused in ddsi_rmsg_batch_done
+     if it isn't retained. */
+  struct ddsi_rbuf *rb = NULL;
+  uint32_t m;
+  for (m = 0; m < n; m++)
+  {
+    rb = rbp->current;
+    if (rb->freeptr != rb->raw && (rb = ddsi_rbuf_new (rbp)) == NULL)
+      break;
+    rmsgs[m] = (struct ddsi_rmsg *) rb->raw;
+#if USE_VALGRIND
+    VALGRIND_MEMPOOL_ALLOC (rbp, rmsgs[m], rb->size);
+#endif
+    init_rmsg (rmsgs[m], rbp);
+    rb->freeptr = rb->raw + rb->size;
+  }
+  if (m > 0)
+  {
+    rbp->batch_rbuf = rbp->current;
+    rbp->batch_keep = rbp->current->raw;
+    rbp->batch_end = rbp->current->freeptr;
+  }
+  RBPTRACE ("rmsg_new_batch(%p, %"PRIu32") = %"PRIu32" slabs\n", (void *) rbp, n, m);
+  return m;
+}
+
+uint32_t ddsi_rmsg_new_batch (struct ddsi_rbufpool *rbp, uint32_t n, struct ddsi_rmsg **rmsgs)
+{
+  /* Note: only one thread calls ddsi_rmsg_new_batch on a pool
+
+     The first rmsg is allocated exactly like ddsi_rmsg_new does, the
+     others follow it at intervals of the maximum size so that each
+     can grow to the maximum while processing.  Rather than
+     incrementing freeptr in commit(), freeptr is moved past the whole
+     batch immediately, so any chunks allocated while processing the
+     batch end up beyond it, and the unused part of the batch is
+     reclaimed in ddsi_rmsg_batch_done. */
+  const uint32_t asize = align_rmsg (max_rmsg_size_w_hdr (rbp->max_rmsg_size));
+  struct ddsi_rbuf *rb;
+  unsigned char *start;
+  uint32_t m;
+  RBPTRACE ("rmsg_new_batch(%p, %"PRIu32")\n", (void *) rbp, n);
+  assert (n > 0);
+  assert (rbp->batch_rbuf == NULL);
+  if (rbp->max_cached_slabs > 0)
+    return rmsg_new_batch_slab (rbp, n, rmsgs);
+
+  if ((start = ddsi_rbuf_alloc (rbp)) == NULL)
+    return 0;
+  rb = rbp->current;
+  assert (start == rb->freeptr);
+  m = (uint32_t) (rb->raw + rb->size - start) / asize;
+  if (m == 0) /* alignment may make it not fit twice */
+    m = 1;
+  else if (m > n)
+    m = n;
+  for (uint32_t i = 0; i < m; i++)
+  {
+    rmsgs[i] = (struct ddsi_rmsg *) (start + i * asize);
+#if USE_VALGRIND
+    if (i > 0)
+      VALGRIND_MEMPOOL_ALLOC (rbp, rmsgs[i], asize);
+#endif
+    init_rmsg (rmsgs[i], rbp);
+  }
+  rbp->batch_rbuf = rb;
+  rbp->batch_keep = start;
+  rbp->batch_end = (m == 1) ? start : start + m * asize;
+  rb->freeptr = rbp->batch_end;
+  RBPTRACE ("rmsg_new_batch(%p, %"PRIu32") = %"PRIu32" @ %p\n", (void *) rbp, n, m, (void *) start);
+  return m;
+}
+
+void ddsi_rmsg_batch_done (struct ddsi_rbufpool *rbp)
+{
+  ASSERT_RBUFPOOL_OWNER (rbp);
+  assert (rbp->batch_rbuf != NULL);
+  /* If nothing was allocated beyond the batch, the space following the
+     last retained rmsg in the batch can be reused */
+  if (rbp->batch_rbuf == rbp->current && rbp->current->freeptr == rbp->batch_end)
+    rbp->current->freeptr = rbp->batch_keep;
+  RBPTRACE ("rmsg_batch_done(%p) freeptr %p\n", (void *) rbp, (void *) rbp->current->freeptr);
+  rbp->batch_rbuf = NULL;
+}
+
 void ddsi_rmsg_setsize (struct ddsi_rmsg *rmsg, uint32_t size)
 {
   uint32_t size8P = align_rmsg (size);
@@ -596,8 +804,20 @@ void ddsi_rmsg_free (struct ddsi_rmsg *rmsg)
 static void commit_rmsg_chunk (struct ddsi_rmsg_chunk *chunk)
 {
   struct ddsi_rbuf *rbuf = chunk->rbuf;
+  struct ddsi_rbufpool *rbp = rbuf->rbufpool;
+  unsigned char *endp = (unsigned char *) (chunk + 1) + chunk->u.size;
   RBUFTRACE ("commit_rmsg_chunk(%p)\n", (void *) chunk);
-  rbuf->freeptr = (unsigned char *) (chunk + 1) + chunk->u.size;
+  if (rbuf == rbp->batch_rbuf && endp <= rbp->batch_end)
+  {
+    /* freeptr is already beyond the batch, only need to track the part
+       of the batch that must be retained */
+    if (endp > rbp->batch_keep)
+      rbp->batch_keep = endp;
+  }
+  else
+  {
+    rbuf->freeptr = endp;
+  }
 }
 
 void ddsi_rmsg_commit (struct ddsi_rmsg *rmsg)
@@ -620,7 +840,8 @@ void ddsi_rmsg_commit (struct ddsi_rmsg *rmsg)
   assert (ddsrt_atomic_ld32 (&rmsg->refcount) >= RMSG_REFCOUNT_UNCOMMITTED_BIAS);
   assert (ddsrt_atomic_ld32 (&rmsg->chunk.rbuf->n_live_rmsg_chunks) > 0);
   assert (ddsrt_atomic_ld32 (&chunk->rbuf->n_live_rmsg_chunks) > 0);
-  assert (chunk->rbuf->rbufpool->current == chunk->rbuf);
+  assert (chunk->rbuf->rbufpool->current == chunk->rbuf || chunk->rbuf->rbufpool->batch_rbuf == chunk->rbuf ||
+          chunk->rbuf->rbufpool->max_cached_slabs > 0);
   if (ddsrt_atomic_sub32_nv (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS) == 0)
     ddsi_rmsg_free (rmsg);
   else
@@ -1321,6 +1542,29 @@ static int defrag_limit_samples (struct ddsi_defrag *defrag, ddsi_seqno_t seq, d
   return 1;
 }
 
+static void defrag_drop_if_size_changed (struct ddsi_defrag *defrag, const struct ddsi_rsample_info *sampleinfo, ddsi_seqno_t *max_seq)
+{
+  /* The fragments of a sample need not all be sent in the same representation: a writer
+     can retransmit a compressed sample uncompressed to a reader that can't decode it, or
+     vice versa.  Those can't be combined, but the sizes always differ, and the fragment
+     that was received last replaces the partial sample. */
+  struct ddsi_rsample *sample;
+  if (sampleinfo->seq == *max_seq)
+    sample = defrag->max_sample;
+  else if (sampleinfo->seq > *max_seq || (sample = ddsrt_avl_lookup (&defrag_sampletree_treedef, &defrag->sampletree, &sampleinfo->seq)) == NULL)
+    return;
+  if (sample->u.defrag.sampleinfo->size == sampleinfo->size)
+    return;
+  TRACE (defrag, "  size changed from %"PRIu32", dropping partial sample\n", sample->u.defrag.sampleinfo->size);
+  const bool was_max = (sample == defrag->max_sample);
+  defrag_rsample_drop (defrag, sample);
+  if (was_max)
+  {
+    defrag->max_sample = ddsrt_avl_find_max (&defrag_sampletree_treedef, &defrag->sampletree);
+    *max_seq = defrag->max_sample ? defrag->max_sample->u.defrag.seq : 0;
+  }
+}
+
 struct ddsi_rsample *ddsi_defrag_rsample (struct ddsi_defrag *defrag, struct ddsi_rdata *rdata, const struct ddsi_rsample_info *sampleinfo)
 {
   /* Takes an rdata, records it in defrag if needed and returns an
@@ -1365,6 +1609,7 @@ struct ddsi_rsample *ddsi_defrag_rsample (struct ddsi_defrag *defrag, struct dds
          (void *) defrag, (void *) rdata, rdata->min, rdata->maxp1, (void *) rdata->rmsg,
          (void *) sampleinfo, sampleinfo->seq, sampleinfo->size,
          (void *) defrag->max_sample, max_seq);
+  defrag_drop_if_size_changed (defrag, sampleinfo, &max_seq);
   /* fast path: rdata is part of message with the highest sequence
      number we're currently defragmenting, or is beyond that */
   if (sampleinfo->seq == max_seq)
@@ -1446,6 +1691,78 @@ void ddsi_defrag_notegap (struct ddsi_defrag *defrag, ddsi_seqno_t min, ddsi_seq
   defrag->max_sample = ddsrt_avl_find_max (&defrag_sampletree_treedef, &defrag->sampletree);
 }
 
+static bool defrag_have_range (const struct ddsi_rsample_defrag *dfsample, uint32_t min, uint32_t maxp1)
+{
+  /* Adjacent and overlapping intervals are always merged, so a range
+     of bytes is present only if a single interval covers it */
+  const struct ddsi_defrag_iv *iv = ddsrt_avl_lookup_pred_eq (&rsample_defrag_fragtree_treedef, &dfsample->fragtree, &min);
+  return iv != NULL && iv->maxp1 >= maxp1;
+}
+
+static void defrag_xor_range (const struct ddsi_rsample_defrag *dfsample, uint32_t min, uint32_t maxp1, unsigned char *dst)
+{
+  /* XOR bytes [min,maxp1) of the sample into dst; the fragment chain
+     may contain overlapping fragments, but the first byte of each is
+     never beyond the last byte of its predecessors in the chain */
+  const struct ddsi_defrag_iv *iv = ddsrt_avl_lookup_pred_eq (&rsample_defrag_fragtree_treedef, &dfsample->fragtree, &min);
+  uint32_t pos = min;
+  assert (iv != NULL && iv->maxp1 >= maxp1);
+  for (const struct ddsi_rdata *rdata = iv->first; rdata && pos < maxp1; rdata = rdata->nextfrag)
+  {
+    if (rdata->maxp1 <= pos)
+      continue;
+    assert (rdata->min <= pos);
+    const unsigned char *src = DDSI_RMSG_PAYLOADOFF (rdata->rmsg, DDSI_RDATA_PAYLOAD_OFF (rdata)) + (pos - rdata->min);
+    const uint32_t end = (rdata->maxp1 < maxp1) ? rdata->maxp1 : maxp1;
+    for (uint32_t i = 0; i < end - pos; i++)
+      dst[pos - min + i] ^= src[i];
+    pos = end;
+  }
+  assert (pos == maxp1);
+}
+
+bool ddsi_defrag_fec_recover (const struct ddsi_defrag *defrag, ddsi_seqno_t seq, uint32_t begin, uint32_t blocksize, uint32_t nblocks, unsigned char *parity, uint32_t paritysize, uint32_t *recovered)
+{
+  /* The parity covers blocks [begin + i*blocksize, begin + (i+1)*blocksize)
+     for i in [0,nblocks), clipped to the sample size.  If exactly one of
+     those is missing, XOR-ing all the others into the parity leaves the
+     contents of the missing one. */
+  const struct ddsi_rsample *s;
+  if ((s = ddsrt_avl_lookup (&defrag_sampletree_treedef, &defrag->sampletree, &seq)) == NULL)
+    return false;
+  const struct ddsi_rsample_defrag *dfsample = &s->u.defrag;
+  const uint32_t size = dfsample->sampleinfo->size;
+  if (blocksize == 0 || nblocks == 0 || begin >= size || (size - begin - 1) / blocksize < nblocks - 1)
+    return false;
+  if (paritysize < ((size - begin < blocksize) ? size - begin : blocksize))
+    return false;
+  uint32_t missing = UINT32_MAX;
+  for (uint32_t i = 0; i < nblocks; i++)
+  {
+    const uint32_t min = begin + i * blocksize;
+    const uint32_t maxp1 = (size - min < blocksize) ? size : min + blocksize;
+    if (!defrag_have_range (dfsample, min, maxp1))
+    {
+      if (missing != UINT32_MAX)
+        return false;
+      missing = i;
+    }
+  }
+  if (missing == UINT32_MAX)
+    return false;
+  for (uint32_t i = 0; i < nblocks; i++)
+  {
+    const uint32_t min = begin + i * blocksize;
+    const uint32_t maxp1 = (size - min < blocksize) ? size : min + blocksize;
+    if (i != missing)
+      defrag_xor_range (dfsample, min, maxp1, parity);
+  }
+  TRACE (defrag, "defrag_fec_recover(%p seq %"PRIu64" [%"PRIu32"..%"PRIu32") block %"PRIu32")\n",
+         (void *) defrag, seq, begin, begin + nblocks * blocksize, missing);
+  *recovered = missing;
+  return true;
+}
+
 enum ddsi_defrag_nackmap_result ddsi_defrag_nackmap (struct ddsi_defrag *defrag, ddsi_seqno_t seq, uint32_t maxfragnum, struct ddsi_fragment_number_set_header *map, uint32_t *mapbits, uint32_t maxsz)
 {
   struct ddsi_rsample *s;
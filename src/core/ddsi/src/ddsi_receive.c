@@ -43,6 +43,7 @@
 #include "ddsi__participant.h"
 #include "ddsi__xmsg.h"
 #include "ddsi__receive.h"
+#include "ddsi__content_filter.h"
 #include "ddsi__rhc.h"
 #include "ddsi__transmit.h"
 #include "ddsi__mcgroup.h"
@@ -57,6 +58,9 @@
 #include "ddsi__tran.h"
 #include "ddsi__vendor.h"
 #include "ddsi__hbcontrol.h"
+#include "ddsi__pacing.h"
+#include "ddsi__compression.h"
+#include "ddsi__ack_tracker.h"
 #include "ddsi__sockwaitset.h"
 
 #include "dds/cdr/dds_cdrstream.h"
@@ -677,7 +681,7 @@ struct ddsi_xmsg * ddsi_gap_info_create_gap(struct ddsi_writer *wr, struct ddsi_
   if (gi->gapstart == 0)
     return NULL;
 
-  m = ddsi_xmsg_new (wr->e.gv->xmsgpool, &wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
+  m = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
 
   ddsi_xmsg_setdst_prd (m, prd);
   ddsi_add_gap (m, wr, prd, gi->gapstart, gi->gapend, gi->gapnumbits, gi->gapbits);
@@ -726,7 +730,7 @@ static void defer_heartbeat_to_peer (struct ddsi_writer *wr, const struct ddsi_w
   ASSERT_MUTEX_HELD (&wr->e.lock);
   assert (wr->reliable);
 
-  defer_hb_state->m = ddsi_xmsg_new (wr->e.gv->xmsgpool, &wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
+  defer_hb_state->m = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
   ddsi_xmsg_setdst_prd (defer_hb_state->m, prd);
   ddsi_add_heartbeat (defer_hb_state->m, wr, whcst, hbansreq, 0, prd->e.guid.entityid, 0);
   defer_hb_state->evq = wr->evq;
@@ -757,7 +761,39 @@ static void defer_hb_state_fini (struct ddsi_domaingv * const gv, struct defer_h
   }
 }
 
-static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow, const ddsi_rtps_acknack_t *msg, ddsrt_wctime_t timestamp, ddsi_rtps_submessage_kind_t prev_smid, struct defer_hb_state *defer_hb_state)
+/* Cleaning up the WHC after an ACK costs a lot more than updating the reader's state,
+   and with many readers a single packet often contains the ACKs of many of them for the
+   same writer. So the cleanup is done only once, after the last ACK for the writer in
+   the packet. */
+struct defer_ack_state {
+  bool pending;
+  ddsi_guid_t wr_guid;
+};
+
+static void defer_ack_state_init (struct defer_ack_state *defer_ack_state)
+{
+  defer_ack_state->pending = false;
+}
+
+static void defer_ack_state_flush (struct ddsi_domaingv * const gv, struct defer_ack_state *defer_ack_state)
+{
+  struct ddsi_writer *wr;
+  if (!defer_ack_state->pending)
+    return;
+  defer_ack_state->pending = false;
+  if ((wr = ddsi_entidx_lookup_writer_guid (gv->entity_index, &defer_ack_state->wr_guid)) != NULL)
+  {
+    struct ddsi_whc_node *deferred_free_list = NULL;
+    struct ddsi_whc_state whcst;
+    ddsrt_mutex_lock (&wr->e.lock);
+    const unsigned n = ddsi_remove_acked_messages (wr, &whcst, &deferred_free_list);
+    ddsrt_mutex_unlock (&wr->e.lock);
+    ddsi_whc_free_deferred_free_list (wr->whc, deferred_free_list);
+    GVTRACE (" RM%u("PGUIDFMT")", n, PGUID (defer_ack_state->wr_guid));
+  }
+}
+
+static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow, const ddsi_rtps_acknack_t *msg, ddsrt_wctime_t timestamp, ddsi_rtps_submessage_kind_t prev_smid, struct defer_hb_state *defer_hb_state, struct defer_ack_state *defer_ack_state, bool more_submsgs)
 {
   struct ddsi_proxy_reader *prd;
   struct ddsi_wr_prd_match *rn;
@@ -827,6 +863,10 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
     return 1;
   }
 
+  /* never hold the locks of two writers at the same time */
+  if (defer_ack_state->pending && ddsi_compare_guid (&defer_ack_state->wr_guid, &wr->e.guid) != 0)
+    defer_ack_state_flush (rst->gv, defer_ack_state);
+
   ddsrt_mutex_lock (&wr->e.lock);
   if (wr->test_ignore_acknack)
   {
@@ -876,21 +916,44 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
     }
   }
 
+  /* Rate-based congestion control: any request for a retransmit other than
+     the pre-emptive one a reader sends on start-up is taken as a sign of
+     congestion, anything else as a hint that the rate may go up */
+  if (wr->pacing.rate > 0 && !is_preemptive_ack)
+  {
+    if (rst->gv->config.meas_hb_to_ack_latency)
+      ddsi_pacing_note_rtt (&wr->pacing, (int64_t) (ddsi_lat_estim_current (&rn->hb_to_ack_latency) * 1e3));
+    if (ddsi_pacing_note_acknack (&wr->pacing, &rst->gv->config, !is_pure_ack, ddsrt_time_monotonic ()))
+      RSTTRACE (" pacing-backoff(%"PRIu64")", wr->pacing.rate);
+  }
+
   /* First, the ACK part: if the AckNack advances the highest sequence
      number ack'd by the remote reader, update state & try dropping
      some messages */
   if (seqbase - 1 > rn->seq)
   {
     const uint64_t n_ack = (seqbase - 1) - rn->seq;
-    rn->seq = seqbase - 1;
-    if (rn->seq > wr->seq) {
+    ddsi_seqno_t seq = seqbase - 1;
+    if (seq > wr->seq) {
       /* Prevent a reader from ACKing future samples (is only malicious because we require
          that rn->seq <= wr->seq) */
-      rn->seq = wr->seq;
+      seq = wr->seq;
+    }
+    ddsi_ack_tracker_update (&wr->ack_tracker, rn, seq, rn->has_replied_to_hb);
+    if (more_submsgs)
+    {
+      /* there may be more ACKs for this writer in this packet */
+      defer_ack_state->pending = true;
+      defer_ack_state->wr_guid = wr->e.guid;
+      ddsi_whc_get_state (wr->whc, &whcst);
+      RSTTRACE (" ACK%"PRIu64" RM-deferred", n_ack);
+    }
+    else
+    {
+      defer_ack_state->pending = false;
+      const unsigned n = ddsi_remove_acked_messages (wr, &whcst, &deferred_free_list);
+      RSTTRACE (" ACK%"PRIu64" RM%u", n_ack, n);
     }
-    ddsrt_avl_augment_update (&ddsi_wr_readers_treedef, rn);
-    const unsigned n = ddsi_remove_acked_messages (wr, &whcst, &deferred_free_list);
-    RSTTRACE (" ACK%"PRIu64" RM%u", n_ack, n);
   }
   else
   {
@@ -903,19 +966,20 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
   if (rn->seq == DDSI_MAX_SEQ_NUMBER && prd->c.xqos->reliability.kind == DDS_RELIABILITY_RELIABLE)
   {
     ddsi_seqno_t oldest_seq;
+    ddsi_seqno_t seq;
     oldest_seq = DDSI_WHCST_ISEMPTY(&whcst) ? wr->seq : whcst.max_seq;
-    rn->has_replied_to_hb = 1; /* was temporarily cleared to ensure heartbeats went out */
-    rn->seq = seqbase - 1;
-    if (oldest_seq > rn->seq) {
+    seq = seqbase - 1;
+    if (oldest_seq > seq) {
       /* Prevent a malicious reader from lowering the min. sequence number retained in the WHC. */
-      rn->seq = oldest_seq;
+      seq = oldest_seq;
     }
-    if (rn->seq > wr->seq) {
+    if (seq > wr->seq) {
       /* Prevent a reader from ACKing future samples (is only malicious because we require
          that rn->seq <= wr->seq) */
-      rn->seq = wr->seq;
+      seq = wr->seq;
     }
-    ddsrt_avl_augment_update (&ddsi_wr_readers_treedef, rn);
+    /* has_replied_to_hb was temporarily cleared to ensure heartbeats went out */
+    ddsi_ack_tracker_update (&wr->ack_tracker, rn, seq, true);
     DDS_CLOG (DDS_LC_THROTTLE, &rst->gv->logconfig, "writer "PGUIDFMT" considering reader "PGUIDFMT" responsive again\n", PGUID (wr->e.guid), PGUID (rn->prd_guid));
   }
 
@@ -929,10 +993,7 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
   if (!rn->has_replied_to_hb && is_pure_nonhist_ack)
   {
     RSTTRACE (" setting-has-replied-to-hb");
-    rn->has_replied_to_hb = 1;
-    /* walk the whole tree to ensure all proxy readers for this writer
-       have their unack'ed info updated */
-    ddsrt_avl_augment_update (&ddsi_wr_readers_treedef, rn);
+    ddsi_ack_tracker_update (&wr->ack_tracker, rn, rn->seq, true);
   }
   if (is_preemptive_ack)
   {
@@ -1018,14 +1079,20 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
         if (!wr->retransmitting && sample.unacked)
           ddsi_writer_set_retransmitting (wr);
 
-        if (rst->gv->config.retransmit_merging != DDSI_REXMIT_MERGE_NEVER && rn->assumed_in_sync && !prd->filter)
+        if (wr->num_content_filtered_readers > 0 && !ddsi_writer_content_filter_rexmit (wr, rn, seq, sample.serdata))
+        {
+          /* Skipped because of the content filters, and so the reader never needs it */
+          ddsi_gap_info_update (rst->gv, &gi, seqbase + i);
+        }
+        else if (rst->gv->config.retransmit_merging != DDSI_REXMIT_MERGE_NEVER && rn->assumed_in_sync && !prd->filter)
         {
           /* send retransmit to all receivers, but skip if recently done */
           ddsrt_mtime_t tstamp = ddsrt_time_monotonic ();
           if (tstamp.v > sample.last_rexmit_ts.v + rst->gv->config.retransmit_merging_period)
           {
             RSTTRACE (" RX%"PRIu64, seqbase + i);
-            enqueued = (ddsi_enqueue_sample_wrlock_held (wr, seq, sample.serdata, NULL, 0) >= 0);
+            struct ddsi_serdata * const xmit_serdata = ddsi_writer_serdata_for_xmit (wr, sample.serdata, &sample.xmit_serdata, NULL);
+            enqueued = (ddsi_enqueue_sample_wrlock_held (wr, seq, xmit_serdata, NULL, 0) >= 0);
             if (enqueued)
             {
               max_seq_in_reply = seqbase + i;
@@ -1034,12 +1101,13 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
               // FIXME: now ddsi_enqueue_sample_wrlock_held limits retransmit requests of a large sample to 1 fragment
               // thus we can easily figure out how much was sent, but we shouldn't have that knowledge here:
               // it should return how much it queued instead
-              uint32_t sent = ddsi_serdata_size (sample.serdata);
+              uint32_t sent = ddsi_serdata_size (xmit_serdata);
               if (sent > wr->e.gv->config.fragment_size)
                 sent = wr->e.gv->config.fragment_size;
               wr->rexmit_bytes += sent;
               limit = (sent > limit) ? 0 : limit - sent;
             }
+            ddsi_serdata_unref (xmit_serdata);
           }
           else
           {
@@ -1056,7 +1124,8 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
           {
             /* no merging, send directed retransmit */
             RSTTRACE (" RX%"PRIu64"", seqbase + i);
-            enqueued = (ddsi_enqueue_sample_wrlock_held (wr, seq, sample.serdata, prd, 0) >= 0);
+            struct ddsi_serdata * const xmit_serdata = ddsi_writer_serdata_for_xmit (wr, sample.serdata, &sample.xmit_serdata, prd);
+            enqueued = (ddsi_enqueue_sample_wrlock_held (wr, seq, xmit_serdata, prd, 0) >= 0);
             if (enqueued)
             {
               max_seq_in_reply = seqbase + i;
@@ -1065,12 +1134,13 @@ static int handle_AckNack (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
               // FIXME: now ddsi_enqueue_sample_wrlock_held limits retransmit requests of a large sample to 1 fragment
               // thus we can easily figure out how much was sent, but we shouldn't have that knowledge here:
               // it should return how much it queued instead
-              uint32_t sent = ddsi_serdata_size (sample.serdata);
+              uint32_t sent = ddsi_serdata_size (xmit_serdata);
               if (sent > wr->e.gv->config.fragment_size)
                 sent = wr->e.gv->config.fragment_size;
               wr->rexmit_bytes += sent;
               limit = (sent > limit) ? 0 : limit - sent;
             }
+            ddsi_serdata_unref (xmit_serdata);
           }
         }
         ddsi_whc_return_sample(wr->whc, &sample, true);
@@ -1653,6 +1723,10 @@ static int handle_NackFrag (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
   }
   RSTTRACE (" "PGUIDFMT" -> "PGUIDFMT"", PGUID (src), PGUID (dst));
 
+  /* Lost fragments indicate congestion just as much as lost samples do */
+  if (wr->pacing.rate > 0 && ddsi_pacing_note_acknack (&wr->pacing, &rst->gv->config, true, ddsrt_time_monotonic ()))
+    RSTTRACE (" pacing-backoff(%"PRIu64")", wr->pacing.rate);
+
   /* Resend the requested fragments if we still have the sample, send
      a Gap if we don't have them anymore. */
   if (ddsi_whc_borrow_sample (wr->whc, seq, &sample))
@@ -1661,13 +1735,15 @@ static int handle_NackFrag (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
     assert (wr->rexmit_burst_size_limit <= UINT32_MAX - UINT16_MAX);
     uint32_t nfrags_lim = (wr->rexmit_burst_size_limit + wr->e.gv->config.fragment_size - 1) / wr->e.gv->config.fragment_size;
     bool sent = false;
+    // same representation as a directed retransmit of the full sample
+    struct ddsi_serdata * const xmit_serdata = ddsi_writer_serdata_for_xmit (wr, sample.serdata, &sample.xmit_serdata, prd);
     RSTTRACE (" scheduling requested frags ...\n");
     for (uint32_t i = 0; i < msg->fragmentNumberState.numbits && nfrags_lim > 0; i++)
     {
       if (ddsi_bitset_isset (msg->fragmentNumberState.numbits, msg->bits, i))
       {
         struct ddsi_xmsg *reply;
-        if (ddsi_create_fragment_message (wr, seq, sample.serdata, base + i, 1, prd, &reply, 0, 0) < 0)
+        if (ddsi_create_fragment_message (wr, seq, xmit_serdata, base + i, 1, prd, &reply, 0, 0) < 0)
           nfrags_lim = 0;
         else if (ddsi_qxev_msg_rexmit_wrlock_held (wr->evq, reply, 0) == DDSI_QXEV_MSG_REXMIT_DROPPED)
           nfrags_lim = 0;
@@ -1679,6 +1755,7 @@ static int handle_NackFrag (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
         }
       }
     }
+    ddsi_serdata_unref (xmit_serdata);
     if (sent && sample.unacked)
     {
       if (!wr->retransmitting)
@@ -1691,7 +1768,7 @@ static int handle_NackFrag (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
     static uint32_t zero = 0;
     struct ddsi_xmsg *m;
     RSTTRACE (" msg not available: scheduling Gap\n");
-    m = ddsi_xmsg_new (rst->gv->xmsgpool, &wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
+    m = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, 0, DDSI_XMSG_KIND_CONTROL);
     ddsi_xmsg_setdst_prd (m, prd);
     /* length-1 bitmap with the bit clear avoids the illegal case of a length-0 bitmap */
     ddsi_add_gap (m, wr, prd, seq, seq+1, 0, &zero);
@@ -1974,9 +2051,15 @@ static int handle_Gap (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow, stru
   return 1;
 }
 
-static struct ddsi_serdata *get_serdata (struct ddsi_sertype const * const type, const struct ddsi_rdata *fragchain, uint32_t sz, int justkey, unsigned statusinfo, ddsrt_wctime_t tstamp)
+static struct ddsi_serdata *get_serdata (const struct ddsi_domaingv *gv, struct ddsi_sertype const * const type, const struct ddsi_proxy_writer *pwr, const struct ddsi_rdata *fragchain, uint32_t sz, int justkey, unsigned statusinfo, ddsrt_wctime_t tstamp)
 {
-  struct ddsi_serdata *sd = ddsi_serdata_from_ser (type, justkey ? SDK_KEY : SDK_DATA, fragchain, sz);
+  /* Compressed payloads are handled here rather than in the sertype implementations so
+     that it works for all of them, but only for writers that announced they compress */
+  struct ddsi_serdata *sd;
+  if (pwr && ddsi_payload_is_compressed (pwr->compression_codecs, fragchain, sz))
+    sd = ddsi_decompress_serdata (gv, type, justkey ? SDK_KEY : SDK_DATA, fragchain, sz);
+  else
+    sd = ddsi_serdata_from_ser (type, justkey ? SDK_KEY : SDK_DATA, fragchain, sz);
   if (sd)
   {
     sd->statusinfo = statusinfo;
@@ -2025,7 +2108,7 @@ static struct ddsi_serdata *remote_make_sample (struct ddsi_tkmap_instance **tk,
                   si->data_smhdr_flags, sampleinfo->size);
       return NULL;
     }
-    sample = get_serdata (type, fragchain, sampleinfo->size, 0, statusinfo, tstamp);
+    sample = get_serdata (gv, type, sampleinfo->pwr, fragchain, sampleinfo->size, 0, statusinfo, tstamp);
   }
   else if (sampleinfo->size)
   {
@@ -2034,12 +2117,12 @@ static struct ddsi_serdata *remote_make_sample (struct ddsi_tkmap_instance **tk,
        as one would expect to receive */
     if (data_smhdr_flags & DDSI_DATA_FLAG_KEYFLAG)
     {
-      sample = get_serdata (type, fragchain, sampleinfo->size, 1, statusinfo, tstamp);
+      sample = get_serdata (gv, type, sampleinfo->pwr, fragchain, sampleinfo->size, 1, statusinfo, tstamp);
     }
     else
     {
       assert (data_smhdr_flags & DDSI_DATA_FLAG_DATAFLAG);
-      sample = get_serdata (type, fragchain, sampleinfo->size, 0, statusinfo, tstamp);
+      sample = get_serdata (gv, type, sampleinfo->pwr, fragchain, sampleinfo->size, 0, statusinfo, tstamp);
     }
   }
   else if (data_smhdr_flags & DDSI_DATA_FLAG_INLINE_QOS)
@@ -2765,6 +2848,47 @@ static int handle_DataFrag (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow,
   return 1;
 }
 
+static int handle_DataFragParity (struct ddsi_receiver_state *rst, ddsrt_etime_t tnow, struct ddsi_rmsg *rmsg, ddsi_rtps_datafrag_t *msg, size_t size, struct ddsi_rsample_info *sampleinfo, const ddsi_keyhash_t *keyhash, unsigned char *datap, struct ddsi_dqueue **deferred_wakeup, ddsi_rtps_submessage_kind_t prev_smid)
+{
+  /* Parity covers extraFlags consecutive blocks of fragmentsInSubmessage
+     fragments, the first one starting at fragmentStartingNum.  If the
+     defragmenter is missing exactly one of these blocks, the payload gets
+     replaced by the contents of that block, so that what remains is simply
+     the DataFrag of the missing block. */
+  struct ddsi_proxy_writer * const pwr = sampleinfo->pwr;
+  const uint32_t blocksize = (uint32_t) msg->fragmentSize * msg->fragmentsInSubmessage;
+  const uint32_t paritysize = (uint32_t) ((unsigned char *) msg + size - datap);
+  uint32_t block;
+  bool recovered = false;
+  RSTTRACE ("DATAFRAG_PARITY("PGUIDFMT" -> "PGUIDFMT" #%"PRIu64"/[%"PRIu32"..%"PRIu32"]*%"PRIu16,
+            PGUIDPREFIX (rst->src_guid_prefix), msg->x.writerId.u,
+            PGUIDPREFIX (rst->dst_guid_prefix), msg->x.readerId.u,
+            ddsi_from_seqno (msg->x.writerSN),
+            msg->fragmentStartingNum, (ddsi_fragment_number_t) (msg->fragmentStartingNum + msg->fragmentsInSubmessage - 1),
+            msg->x.extraFlags);
+  if (!rst->forme || pwr == NULL || msg->x.extraFlags == 0)
+  {
+    RSTTRACE (" ignored)");
+    return 1;
+  }
+  ddsrt_mutex_lock (&pwr->e.lock);
+  if (pwr->defrag)
+    recovered = ddsi_defrag_fec_recover (pwr->defrag, sampleinfo->seq, (msg->fragmentStartingNum - 1) * msg->fragmentSize, blocksize, msg->x.extraFlags, datap, paritysize, &block);
+  ddsrt_mutex_unlock (&pwr->e.lock);
+  if (!recovered)
+  {
+    RSTTRACE (" nothing to recover)");
+    return 1;
+  }
+  msg->x.smhdr.submessageId = DDSI_RTPS_SMID_DATA_FRAG;
+  msg->x.extraFlags = 0;
+  msg->fragmentStartingNum += block * msg->fragmentsInSubmessage;
+  RSTTRACE (" recovered block %"PRIu32") ", block);
+  if (msg->fragmentStartingNum == 1 && !set_sampleinfo_bswap (sampleinfo, (struct dds_cdr_header *) datap))
+    return 1;
+  return handle_DataFrag (rst, tnow, rmsg, msg, size, sampleinfo, keyhash, datap, deferred_wakeup, prev_smid);
+}
+
 struct submsg_name {
   char x[32];
 };
@@ -2788,6 +2912,7 @@ static const char *submsg_name (ddsi_rtps_submessage_kind_t id, struct submsg_na
     case DDSI_RTPS_SMID_DATA: return "DATA";
     case DDSI_RTPS_SMID_ADLINK_MSG_LEN: return "ADLINK_MSG_LEN";
     case DDSI_RTPS_SMID_ADLINK_ENTITY_ID: return "ADLINK_ENTITY_ID";
+    case DDSI_RTPS_SMID_ADLINK_DATA_FRAG_PARITY: return "ADLINK_DATA_FRAG_PARITY";
     case DDSI_RTPS_SMID_SEC_PREFIX: return "SEC_PREFIX";
     case DDSI_RTPS_SMID_SEC_BODY: return "SEC_BODY";
     case DDSI_RTPS_SMID_SEC_POSTFIX: return "SEC_POSTFIX";
@@ -2988,6 +3113,7 @@ static int handle_submsg_sequence
   struct ddsi_dqueue *deferred_wakeup = NULL;
   ddsi_rtps_submessage_kind_t prev_smid = DDSI_RTPS_SMID_PAD;
   struct defer_hb_state defer_hb_state;
+  struct defer_ack_state defer_ack_state;
 
   /* Receiver state is dynamically allocated with lifetime bound to
      the message.  Updates cause a new copy to be created if the
@@ -3018,6 +3144,7 @@ static int handle_submsg_sequence
   ts_for_latmeas = 0;
   timestamp = DDSRT_WCTIME_INVALID;
   defer_hb_state_init (&defer_hb_state);
+  defer_ack_state_init (&defer_ack_state);
   assert (ddsi_thread_is_asleep ());
   ddsi_thread_state_awake_fixed_domain (thrst);
   enum validation_result vr = (len >= sizeof (ddsi_rtps_submessage_header_t)) ? VR_NOT_UNDERSTOOD : VR_MALFORMED;
@@ -3080,7 +3207,7 @@ static int handle_submsg_sequence
     {
       case DDSI_RTPS_SMID_ACKNACK: {
         if ((vr = validate_AckNack (rst, &sm->acknack, submsg_size, byteswap)) == VR_ACCEPT)
-          handle_AckNack (rst, tnowE, &sm->acknack, ts_for_latmeas ? timestamp : DDSRT_WCTIME_INVALID, prev_smid, &defer_hb_state);
+          handle_AckNack (rst, tnowE, &sm->acknack, ts_for_latmeas ? timestamp : DDSRT_WCTIME_INVALID, prev_smid, &defer_hb_state, &defer_ack_state, submsg + submsg_size < end);
         ts_for_latmeas = 0;
         break;
       }
@@ -3154,6 +3281,28 @@ static int handle_submsg_sequence
         ts_for_latmeas = 0;
         break;
       }
+      case DDSI_RTPS_SMID_ADLINK_DATA_FRAG_PARITY: {
+        struct ddsi_rsample_info sampleinfo;
+        uint32_t datasz = 0;
+        unsigned char *datap;
+        const ddsi_keyhash_t *keyhash;
+        size_t submsg_len = submsg_size;
+        if (!ddsi_vendor_is_eclipse (rst->vendor)) {
+          // someone else's vendor-specific submessage
+          GVTRACE ("UNDEFINED(%x)", sm->smhdr.submessageId);
+        } else if ((vr = validate_DataFrag (rst, &sm->datafrag, submsg_size, byteswap, &sampleinfo, &keyhash, &datap, &datasz)) != VR_ACCEPT) {
+          // nothing to be done here if not accepted
+        } else if (!ddsi_security_decode_datafrag (rst->gv, &sampleinfo, datap, datasz, &submsg_len)) {
+          vr = VR_NOT_UNDERSTOOD;
+        } else {
+          sampleinfo.timestamp = timestamp;
+          sampleinfo.reception_timestamp = tnowWC;
+          handle_DataFragParity (rst, tnowE, rmsg, &sm->datafrag, submsg_len, &sampleinfo, keyhash, datap, &deferred_wakeup, prev_smid);
+          rst_live = 1;
+        }
+        ts_for_latmeas = 0;
+        break;
+      }
       case DDSI_RTPS_SMID_DATA: {
         struct ddsi_rsample_info sampleinfo;
         unsigned char *datap;
@@ -3223,6 +3372,7 @@ static int handle_submsg_sequence
     GVTRACE ("short (size %"PRIuSIZE" exp %p act %p)", submsg_size, (void *) submsg, (void *) end);
     vr = VR_MALFORMED;
   }
+  defer_ack_state_flush (gv, &defer_ack_state);
   ddsi_thread_state_asleep (thrst);
   assert (ddsi_thread_is_asleep ());
   defer_hb_state_fini (gv, &defer_hb_state);
@@ -3281,8 +3431,17 @@ void ddsi_handle_rtps_message (struct ddsi_thread_state * const thrst, struct dd
   handle_rtps_message (thrst, gv, conn, guidprefix, rbpool, rmsg, sz, msg, pktinfo);
 }
 
-static bool do_packet (struct ddsi_thread_state * const thrst, struct ddsi_domaingv *gv, struct ddsi_tran_conn * conn, const ddsi_guid_prefix_t *guidprefix, struct ddsi_rbufpool *rbpool)
+static void recv_stats_add (struct ddsi_recv_thread_arg *recv_thread_arg, uint32_t npackets)
+{
+  /* only the receive thread updates these, so no need for an atomic increment */
+  ddsrt_atomic_st64 (&recv_thread_arg->npackets, ddsrt_atomic_ld64 (&recv_thread_arg->npackets) + npackets);
+  ddsrt_atomic_st64 (&recv_thread_arg->nreads, ddsrt_atomic_ld64 (&recv_thread_arg->nreads) + 1);
+}
+
+static bool do_packet (struct ddsi_thread_state * const thrst, struct ddsi_recv_thread_arg *recv_thread_arg, struct ddsi_tran_conn * conn, const ddsi_guid_prefix_t *guidprefix)
 {
+  struct ddsi_domaingv * const gv = recv_thread_arg->gv;
+  struct ddsi_rbufpool * const rbpool = recv_thread_arg->rbpool;
   /* UDP max packet size is 64kB */
 
   const size_t maxsz = gv->config.rmsg_chunk_size < 65536 ? gv->config.rmsg_chunk_size : 65536;
@@ -3366,15 +3525,78 @@ static bool do_packet (struct ddsi_thread_state * const thrst, struct ddsi_domai
     sz = ddsi_conn_read (conn, buff, buff_len, true, &pktinfo);
   }
 
-  if (sz > 0 && !gv->deaf)
+  if (sz > 0)
   {
-    ddsi_rmsg_setsize (rmsg, (uint32_t) sz);
-    handle_rtps_message(thrst, gv, conn, guidprefix, rbpool, rmsg, (size_t) sz, buff, &pktinfo);
+    recv_stats_add (recv_thread_arg, 1);
+    if (!gv->deaf)
+    {
+      ddsi_rmsg_setsize (rmsg, (uint32_t) sz);
+      handle_rtps_message(thrst, gv, conn, guidprefix, rbpool, rmsg, (size_t) sz, buff, &pktinfo);
+    }
   }
   ddsi_rmsg_commit (rmsg);
   return (sz > 0);
 }
 
+static bool do_packet_batch (struct ddsi_thread_state * const thrst, struct ddsi_recv_thread_arg *recv_thread_arg, struct ddsi_tran_conn * conn, const ddsi_guid_prefix_t *guidprefix, uint32_t batch_size)
+{
+  /* Datagram-only variant of do_packet that reads multiple packets in a
+     single call, each into its own rmsg.  The rmsgs are processed in the
+     order in which the packets were received, and each is committed after
+     processing as do_packet does. */
+  struct ddsi_domaingv * const gv = recv_thread_arg->gv;
+  struct ddsi_rbufpool * const rbpool = recv_thread_arg->rbpool;
+  const size_t maxsz = gv->config.rmsg_chunk_size < 65536 ? gv->config.rmsg_chunk_size : 65536;
+  struct ddsi_rmsg *rmsgs[DDSI_TRAN_READ_MULTI_MAX];
+  struct ddsi_tran_read_msg msgs[DDSI_TRAN_READ_MULTI_MAX];
+  uint32_t n;
+  int nrecv;
+
+  assert (!conn->m_stream);
+  assert (batch_size <= DDSI_TRAN_READ_MULTI_MAX);
+  if ((n = ddsi_rmsg_new_batch (rbpool, batch_size, rmsgs)) == 0)
+    return false;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    msgs[i].buf = (unsigned char *) DDSI_RMSG_PAYLOAD (rmsgs[i]);
+    msgs[i].len = maxsz;
+  }
+
+  nrecv = ddsi_conn_read_multi (conn, msgs, n);
+  if (nrecv > 0)
+    recv_stats_add (recv_thread_arg, (uint32_t) nrecv);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (i < (uint32_t) nrecv && msgs[i].sz > 0 && !gv->deaf)
+    {
+      ddsi_rmsg_setsize (rmsgs[i], (uint32_t) msgs[i].sz);
+      handle_rtps_message (thrst, gv, conn, guidprefix, rbpool, rmsgs[i], (size_t) msgs[i].sz, msgs[i].buf, &msgs[i].pktinfo);
+    }
+    ddsi_rmsg_commit (rmsgs[i]);
+  }
+  ddsi_rmsg_batch_done (rbpool);
+  return (nrecv > 0);
+}
+
+static uint32_t recv_batch_size (const struct ddsi_domaingv *gv, const struct ddsi_tran_conn *conn)
+{
+  if (conn->m_stream || conn->m_read_multi_fn == 0)
+    return 1;
+  else if (gv->config.recv_batch_size > DDSI_TRAN_READ_MULTI_MAX)
+    return DDSI_TRAN_READ_MULTI_MAX;
+  else
+    return gv->config.recv_batch_size;
+}
+
+static bool do_packets (struct ddsi_thread_state * const thrst, struct ddsi_recv_thread_arg *recv_thread_arg, struct ddsi_tran_conn * conn, const ddsi_guid_prefix_t *guidprefix)
+{
+  const uint32_t batch_size = recv_batch_size (recv_thread_arg->gv, conn);
+  if (batch_size > 1)
+    return do_packet_batch (thrst, recv_thread_arg, conn, guidprefix, batch_size);
+  else
+    return do_packet (thrst, recv_thread_arg, conn, guidprefix);
+}
+
 struct local_participant_desc
 {
   struct ddsi_tran_conn * m_conn;
@@ -3541,6 +3763,12 @@ void ddsi_trigger_recv_threads (const struct ddsi_domaingv *gv)
     switch (gv->recv_threads[i].arg.mode)
     {
       case DDSI_RTM_SINGLE: {
+        if (gv->recv_threads[i].arg.u.single.ws != NULL)
+        {
+          GVTRACE ("ddsi_trigger_recv_threads: %"PRIu32" single %p\n", i, (void *) gv->recv_threads[i].arg.u.single.ws);
+          ddsi_sock_waitset_trigger (gv->recv_threads[i].arg.u.single.ws);
+          break;
+        }
         char buf[DDSI_LOCSTRLEN];
         char dummy = 0;
         const ddsi_locator_t *dst = gv->recv_threads[i].arg.u.single.loc;
@@ -3569,13 +3797,29 @@ uint32_t ddsi_recv_thread (void *vrecv_thread_arg)
   ddsrt_mtime_t next_thread_cputime = { 0 };
 
   ddsi_rbufpool_setowner (rbpool, ddsrt_thread_self ());
-  if (waitset == NULL)
+  if (waitset == NULL && recv_thread_arg->u.single.ws != NULL)
+  {
+    /* Single socket sharing its port with others, the waitset only
+       exists so that it can be triggered */
+    while (ddsrt_atomic_ld32 (&gv->rtps_keepgoing))
+    {
+      struct ddsi_sock_waitset_ctx *ctx;
+      LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
+      if ((ctx = ddsi_sock_waitset_wait (recv_thread_arg->u.single.ws)) != NULL)
+      {
+        struct ddsi_tran_conn *conn;
+        while (ddsi_sock_waitset_next_event (ctx, &conn) >= 0)
+          (void) do_packets (thrst, recv_thread_arg, conn, NULL);
+      }
+    }
+  }
+  else if (waitset == NULL)
   {
     struct ddsi_tran_conn *conn = recv_thread_arg->u.single.conn;
     while (ddsrt_atomic_ld32 (&gv->rtps_keepgoing))
     {
       LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
-      (void) do_packet (thrst, gv, conn, NULL, rbpool);
+      (void) do_packets (thrst, recv_thread_arg, conn, NULL);
     }
   }
   else
@@ -3653,7 +3897,7 @@ uint32_t ddsi_recv_thread (void *vrecv_thread_arg)
           else
             guid_prefix = &lps.ps[(unsigned)idx - num_fixed].guid_prefix;
           /* Process message and clean out connection if failed or closed */
-          if (!do_packet (thrst, gv, conn, guid_prefix, rbpool) && !conn->m_connless)
+          if (!do_packets (thrst, recv_thread_arg, conn, guid_prefix) && !conn->m_connless)
             ddsi_conn_free (conn);
         }
       }
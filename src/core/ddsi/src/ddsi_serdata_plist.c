@@ -236,8 +236,7 @@ static struct ddsi_serdata *serdata_plist_from_sample (const struct ddsi_sertype
 
   // FIXME: key must not require byteswapping (GUIDs are ok)
   // FIXME: rework plist stuff so it doesn't need an ddsi_xmsg
-  struct ddsi_domaingv * const gv = ddsrt_atomic_ldvoidp (&tp->c.gv);
-  struct ddsi_xmsg *mpayload = ddsi_xmsg_new (gv->xmsgpool, &ddsi_nullguid, NULL, 0, DDSI_XMSG_KIND_DATA);
+  struct ddsi_xmsg *mpayload = ddsi_xmsg_new (&ddsi_nullguid, NULL, 0, DDSI_XMSG_KIND_DATA);
   memcpy (ddsi_xmsg_append (mpayload, NULL, 4), &header, 4);
   const enum ddsi_plist_context_kind context_kind = get_plist_context_kind (tp->keyparam);
   ddsi_plist_addtomsg (mpayload, sample, ~(uint64_t)0, ~(uint64_t)0, context_kind);
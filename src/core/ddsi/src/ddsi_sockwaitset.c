@@ -25,9 +25,12 @@
 #define MODE_KQUEUE 1
 #define MODE_SELECT 2
 #define MODE_WFMEVS 3
+#define MODE_EPOLL 4
 
 #if defined __APPLE__
 #define MODE_SEL MODE_KQUEUE
+#elif defined __linux__ && !LWIP_SOCKET
+#define MODE_SEL MODE_EPOLL
 #elif defined WINCE
 #define MODE_SEL MODE_WFMEVS
 #else
@@ -493,6 +496,294 @@ int ddsi_sock_waitset_next_event (struct ddsi_sock_waitset_ctx * ctx, struct dds
   }
 }
 
+#elif MODE_SEL == MODE_EPOLL
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+/* Cap on the number of events retrieved in a single epoll_wait call: if
+   more sockets are ready, the remainder will simply be returned by the
+   next call (epoll is level-triggered by default and we use it that way,
+   because the receive thread reads a single datagram per event from a
+   blocking socket) */
+#define MAX_EVENTS_PER_WAIT 64
+
+struct ddsi_sock_waitset_ctx
+{
+  struct ddsi_sock_waitset *ws;
+  struct epoll_event *evs;
+  uint32_t nevs;
+  uint32_t evs_sz;
+  uint32_t index; /* cursor for enumerating */
+};
+
+struct entry {
+  uint32_t index;
+  int fd;
+  struct ddsi_tran_conn * conn;
+};
+
+struct ddsi_sock_waitset
+{
+  int epoll;
+  int pipe[2]; /* pipe used for triggering */
+  ddsrt_atomic_uint32_t sz;
+  struct entry *entries;
+  struct ddsi_sock_waitset_ctx ctx; /* set of descriptors being handled */
+  ddsrt_mutex_t lock; /* for add/delete/entries */
+};
+
+static int epoll_add_entry (int epfd, uint32_t slot, int fd)
+{
+  /* The slot index rather than a pointer to the entry is stored in the event
+     data because the entries array gets reallocated when it grows */
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.u32 = slot;
+  return epoll_ctl (epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static int add_entry_locked (struct ddsi_sock_waitset * ws, struct ddsi_tran_conn * conn, int fd)
+{
+  uint32_t idx, fidx, sz, n;
+  assert (fd >= 0);
+  sz = ddsrt_atomic_ld32 (&ws->sz);
+  for (idx = 0, fidx = UINT32_MAX, n = 0; idx < sz; idx++)
+  {
+    if (ws->entries[idx].fd == -1)
+      fidx = (idx < fidx) ? idx : fidx;
+    else if (ws->entries[idx].conn == conn)
+      return 0;
+    else
+      n++;
+  }
+
+  if (fidx == UINT32_MAX)
+  {
+    const uint32_t newsz = sz + WAITSET_DELTA;
+    struct entry *entries;
+    if ((entries = ddsrt_realloc_s (ws->entries, newsz * sizeof (*ws->entries))) == NULL)
+      return -1;
+    ws->entries = entries;
+    for (idx = sz; idx < newsz; idx++)
+      ws->entries[idx].fd = -1;
+    ddsrt_atomic_st32 (&ws->sz, newsz);
+    fidx = sz;
+  }
+  if (epoll_add_entry (ws->epoll, fidx, fd) == -1)
+    return -1;
+  ws->entries[fidx].conn = conn;
+  ws->entries[fidx].fd = fd;
+  ws->entries[fidx].index = n;
+  return 1;
+}
+
+struct ddsi_sock_waitset * ddsi_sock_waitset_new (void)
+{
+  const uint32_t sz = WAITSET_DELTA;
+  struct ddsi_sock_waitset * ws;
+  uint32_t i;
+  if ((ws = ddsrt_malloc_s (sizeof (*ws))) == NULL)
+    goto fail_waitset;
+  ddsrt_atomic_st32 (&ws->sz, sz);
+  if ((ws->entries = ddsrt_malloc_s (sz * sizeof (*ws->entries))) == NULL)
+    goto fail_entries;
+  for (i = 0; i < sz; i++)
+    ws->entries[i].fd = -1;
+  ws->ctx.ws = ws;
+  ws->ctx.nevs = 0;
+  ws->ctx.index = 0;
+  ws->ctx.evs_sz = sz;
+  if ((ws->ctx.evs = ddsrt_malloc_s (ws->ctx.evs_sz * sizeof (*ws->ctx.evs))) == NULL)
+    goto fail_ctx_evs;
+  if ((ws->epoll = epoll_create1 (EPOLL_CLOEXEC)) == -1)
+    goto fail_epoll;
+  if (pipe (ws->pipe) == -1)
+    goto fail_pipe;
+  if (fcntl (ws->pipe[0], F_SETFD, fcntl (ws->pipe[0], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (fcntl (ws->pipe[1], F_SETFD, fcntl (ws->pipe[1], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (add_entry_locked (ws, NULL, ws->pipe[0]) < 0)
+    goto fail_add_trigger;
+  assert (ws->entries[0].fd == ws->pipe[0]);
+  ddsrt_mutex_init (&ws->lock);
+  return ws;
+
+fail_add_trigger:
+fail_fcntl:
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+fail_pipe:
+  close (ws->epoll);
+fail_epoll:
+  ddsrt_free (ws->ctx.evs);
+fail_ctx_evs:
+  ddsrt_free (ws->entries);
+fail_entries:
+  ddsrt_free (ws);
+fail_waitset:
+  return NULL;
+}
+
+void ddsi_sock_waitset_free (struct ddsi_sock_waitset * ws)
+{
+  ddsrt_mutex_destroy (&ws->lock);
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+  close (ws->epoll);
+  ddsrt_free (ws->entries);
+  ddsrt_free (ws->ctx.evs);
+  ddsrt_free (ws);
+}
+
+void ddsi_sock_waitset_trigger (struct ddsi_sock_waitset * ws)
+{
+  char buf = 0;
+  int n;
+  n = (int)write (ws->pipe[1], &buf, 1);
+  if (n != 1)
+  {
+    DDS_WARNING("ddsi_sock_waitset_trigger: write failed on trigger pipe, errno = %d\n", errno);
+  }
+}
+
+int ddsi_sock_waitset_add (struct ddsi_sock_waitset * ws, struct ddsi_tran_conn * conn)
+{
+  int ret;
+  ddsrt_mutex_lock (&ws->lock);
+  ret = add_entry_locked (ws, conn, ddsi_conn_handle (conn));
+  ddsrt_mutex_unlock (&ws->lock);
+  return ret;
+}
+
+void ddsi_sock_waitset_purge (struct ddsi_sock_waitset * ws, unsigned index)
+{
+  /* Sockets may have been closed by the time purge is called, and their file
+     descriptors may have been reused in the meantime.  Removing them one by
+     one from the epoll set could then remove the wrong registration, so,
+     like the kqueue variant, it is simply replaced by a fresh one */
+  uint32_t i, sz;
+  ddsrt_mutex_lock (&ws->lock);
+  sz = ddsrt_atomic_ld32 (&ws->sz);
+  close (ws->epoll);
+  if ((ws->epoll = epoll_create1 (EPOLL_CLOEXEC)) == -1)
+    abort (); /* FIXME */
+  for (i = 0; i <= index && i < sz; i++)
+  {
+    assert (ws->entries[i].fd >= 0);
+    if (epoll_add_entry (ws->epoll, i, ws->entries[i].fd) == -1)
+      abort (); /* FIXME */
+  }
+  for (; i < sz; i++)
+  {
+    ws->entries[i].conn = NULL;
+    ws->entries[i].fd = -1;
+  }
+  ddsrt_mutex_unlock (&ws->lock);
+}
+
+void ddsi_sock_waitset_remove (struct ddsi_sock_waitset * ws, struct ddsi_tran_conn * conn)
+{
+  const int fd = ddsi_conn_handle (conn);
+  uint32_t i, sz;
+  assert (fd >= 0);
+  ddsrt_mutex_lock (&ws->lock);
+  sz = ddsrt_atomic_ld32 (&ws->sz);
+  for (i = 1; i < sz; i++)
+    if (ws->entries[i].fd == fd)
+      break;
+  if (i < sz)
+  {
+    /* the socket is still open (see ddsi_conn_free), but an error here is
+       harmless: a closed socket is removed from the epoll set by the kernel */
+    (void) epoll_ctl (ws->epoll, EPOLL_CTL_DEL, fd, NULL);
+    ws->entries[i].conn = NULL;
+    ws->entries[i].fd = -1;
+  }
+  ddsrt_mutex_unlock (&ws->lock);
+}
+
+struct ddsi_sock_waitset_ctx * ddsi_sock_waitset_wait (struct ddsi_sock_waitset * ws)
+{
+  /* if the array of events is smaller than the number of file descriptors in the
+     epoll set, things will still work fine, as the kernel will just return what
+     can be stored, and the set will be grown on the next call */
+  uint32_t ws_sz = ddsrt_atomic_ld32 (&ws->sz);
+  int nevs;
+  if (ws_sz > MAX_EVENTS_PER_WAIT)
+    ws_sz = MAX_EVENTS_PER_WAIT;
+  if (ws->ctx.evs_sz < ws_sz)
+  {
+    struct epoll_event *evs;
+    if ((evs = ddsrt_realloc_s (ws->ctx.evs, ws_sz * sizeof (*ws->ctx.evs))) != NULL)
+    {
+      ws->ctx.evs = evs;
+      ws->ctx.evs_sz = ws_sz;
+    }
+  }
+  nevs = epoll_wait (ws->epoll, ws->ctx.evs, (int) ws->ctx.evs_sz, -1);
+  if (nevs < 0)
+  {
+    if (errno == EINTR)
+      nevs = 0;
+    else
+    {
+      DDS_WARNING("ddsi_sock_waitset_wait: epoll_wait failed, errno = %d\n", errno);
+      return NULL;
+    }
+  }
+  ws->ctx.nevs = (uint32_t)nevs;
+  ws->ctx.index = 0;
+  return &ws->ctx;
+}
+
+int ddsi_sock_waitset_next_event (struct ddsi_sock_waitset_ctx * ctx, struct ddsi_tran_conn **conn)
+{
+  struct ddsi_sock_waitset * const ws = ctx->ws;
+  while (ctx->index < ctx->nevs)
+  {
+    const uint32_t slot = ctx->evs[ctx->index++].data.u32;
+    struct ddsi_tran_conn *c;
+    uint32_t index;
+    int fd;
+    /* entries may be reallocated, removed or purged concurrently by add/remove,
+       so look up the slot with the lock held */
+    ddsrt_mutex_lock (&ws->lock);
+    if (slot < ddsrt_atomic_ld32 (&ws->sz))
+    {
+      c = ws->entries[slot].conn;
+      index = ws->entries[slot].index;
+      fd = ws->entries[slot].fd;
+    }
+    else
+    {
+      c = NULL;
+      index = 0;
+      fd = -1;
+    }
+    ddsrt_mutex_unlock (&ws->lock);
+    if (fd == -1)
+      continue; /* removed since the event was generated */
+    else if (slot > 0)
+    {
+      *conn = c;
+      return (int)(index - 1);
+    }
+    else
+    {
+      /* trigger pipe, read & try again */
+      char dummy;
+      if (read (fd, &dummy, 1) != 1)
+        DDS_WARNING("ddsi_sock_waitset_next_event: read failed on trigger pipe, errno = %d\n", errno);
+    }
+  }
+  return -1;
+}
+
 #elif MODE_SEL == MODE_SELECT
 
 #ifdef __VXWORKS__
@@ -17,6 +17,7 @@
 #include "ddsi__entity.h"
 #include "ddsi__endpoint_match.h"
 #include "ddsi__radmin.h"
+#include "ddsi__pacing.h"
 #include "ddsi__proxy_endpoint.h"
 
 void ddsi_get_writer_stats (struct ddsi_writer *wr, uint64_t * __restrict rexmit_bytes, uint32_t * __restrict throttle_count, uint64_t * __restrict time_throttled, uint64_t * __restrict time_retransmit)
@@ -29,6 +30,33 @@ void ddsi_get_writer_stats (struct ddsi_writer *wr, uint64_t * __restrict rexmit
   ddsrt_mutex_unlock (&wr->e.lock);
 }
 
+void ddsi_get_writer_pacing_stats (struct ddsi_writer *wr, uint64_t * __restrict rate, uint64_t * __restrict achieved_rate, uint32_t * __restrict backoff_count, uint64_t * __restrict time_paced)
+{
+  ddsrt_mutex_lock (&wr->e.lock);
+  *rate = wr->pacing.rate;
+  *achieved_rate = (wr->pacing.rate > 0) ? ddsi_pacing_achieved_rate (&wr->pacing, ddsrt_time_monotonic ()) : 0;
+  *backoff_count = wr->pacing.backoff_count;
+  *time_paced = wr->pacing.time_paced;
+  ddsrt_mutex_unlock (&wr->e.lock);
+}
+
+void ddsi_get_writer_addrset_stats (struct ddsi_writer *wr, uint32_t * __restrict rebuild_count, uint32_t * __restrict update_count, uint64_t * __restrict time_addrset)
+{
+  ddsrt_mutex_lock (&wr->e.lock);
+  *rebuild_count = wr->addrset_rebuild_count;
+  *update_count = wr->addrset_update_count;
+  *time_addrset = wr->time_addrset;
+  ddsrt_mutex_unlock (&wr->e.lock);
+}
+
+void ddsi_get_writer_content_filter_stats (struct ddsi_writer *wr, uint32_t * __restrict num_filtered_readers, uint64_t * __restrict skipped)
+{
+  ddsrt_mutex_lock (&wr->e.lock);
+  *num_filtered_readers = wr->num_content_filtered_readers;
+  *skipped = wr->content_filter_skipped;
+  ddsrt_mutex_unlock (&wr->e.lock);
+}
+
 void ddsi_get_reader_stats (struct ddsi_reader *rd, uint64_t * __restrict discarded_bytes)
 {
   struct ddsi_rd_pwr_match *m;
@@ -65,3 +93,14 @@ void ddsi_get_reader_stats (struct ddsi_reader *rd, uint64_t * __restrict discar
   }
   ddsrt_mutex_unlock (&rd->e.lock);
 }
+
+void ddsi_get_recv_stats (const struct ddsi_domaingv *gv, uint64_t * __restrict packets, uint64_t * __restrict reads)
+{
+  *packets = 0;
+  *reads = 0;
+  for (uint32_t i = 0; i < gv->n_recv_threads; i++)
+  {
+    *packets += ddsrt_atomic_ld64 (&gv->recv_threads[i].arg.npackets);
+    *reads += ddsrt_atomic_ld64 (&gv->recv_threads[i].arg.nreads);
+  }
+}
@@ -27,9 +27,21 @@
 #define REFC_DELETE 0x80000000
 #define REFC_MASK   0x0fffffff
 
+/* The instances are spread over a number of independent hash tables based on the
+   most-significant bits of the serdata hash (the tables themselves use the least
+   significant bits). Each table has its own lock for adding and removing entries
+   and gets resized independently, so instances of different keys mostly don't
+   contend with each other and the tables (and thus the bucket arrays that need to
+   be garbage collected on resizing) are smaller.
+
+   This deliberately doesn't partition the instances by topic or type: instance
+   handles are shared between topics with the same key value. */
+#define TKMAP_SHARD_BITS 4
+#define TKMAP_NSHARDS (1u << TKMAP_SHARD_BITS)
+
 struct ddsi_tkmap
 {
-  struct ddsrt_chh *m_hh;
+  struct ddsrt_chh *m_hh[TKMAP_NSHARDS];
   struct ddsi_domaingv *gv;
   ddsrt_mutex_t m_lock;
   ddsrt_cond_t m_cond;
@@ -84,10 +96,16 @@ static bool dds_tk_equals_void (const void *a, const void *b)
   return dds_tk_equals (a, b);
 }
 
+static struct ddsrt_chh *tkmap_shard (const struct ddsi_tkmap *map, const struct ddsi_serdata *sd)
+{
+  return map->m_hh[sd->hash >> (32 - TKMAP_SHARD_BITS)];
+}
+
 struct ddsi_tkmap *ddsi_tkmap_new (struct ddsi_domaingv *gv)
 {
   struct ddsi_tkmap *tkmap = dds_alloc (sizeof (*tkmap));
-  tkmap->m_hh = ddsrt_chh_new (1, dds_tk_hash_void, dds_tk_equals_void, gc_buckets, tkmap);
+  for (uint32_t i = 0; i < TKMAP_NSHARDS; i++)
+    tkmap->m_hh[i] = ddsrt_chh_new (1, dds_tk_hash_void, dds_tk_equals_void, gc_buckets, tkmap);
   tkmap->gv = gv;
   ddsrt_mutex_init (&tkmap->m_lock);
   ddsrt_cond_init (&tkmap->m_cond);
@@ -103,8 +121,11 @@ static void free_tkmap_instance (void *vtk, UNUSED_ARG(void *f_arg))
 
 void ddsi_tkmap_free (struct ddsi_tkmap * map)
 {
-  ddsrt_chh_enum_unsafe (map->m_hh, free_tkmap_instance, NULL);
-  ddsrt_chh_free (map->m_hh);
+  for (uint32_t i = 0; i < TKMAP_NSHARDS; i++)
+  {
+    ddsrt_chh_enum_unsafe (map->m_hh[i], free_tkmap_instance, NULL);
+    ddsrt_chh_free (map->m_hh[i]);
+  }
   ddsrt_cond_destroy (&map->m_cond);
   ddsrt_mutex_destroy (&map->m_lock);
   dds_free (map);
@@ -116,7 +137,7 @@ uint64_t ddsi_tkmap_lookup (struct ddsi_tkmap * map, const struct ddsi_serdata *
   struct ddsi_tkmap_instance * tk;
   assert (ddsi_thread_is_awake ());
   dummy.m_sample = (struct ddsi_serdata *) sd;
-  tk = ddsrt_chh_lookup (map->m_hh, &dummy);
+  tk = ddsrt_chh_lookup (tkmap_shard (map, sd), &dummy);
   return (tk) ? tk->m_iid : DDS_HANDLE_NIL;
 }
 
@@ -124,12 +145,13 @@ struct ddsi_tkmap_instance *ddsi_tkmap_find_by_id (struct ddsi_tkmap *map, uint6
 {
   /* This is not a function that should be used liberally, as it linearly scans the key-to-iid map. */
   struct ddsrt_chh_iter it;
-  struct ddsi_tkmap_instance *tk;
+  struct ddsi_tkmap_instance *tk = NULL;
   uint32_t refc;
   assert (ddsi_thread_is_awake ());
-  for (tk = ddsrt_chh_iter_first (map->m_hh, &it); tk; tk = ddsrt_chh_iter_next (&it))
-    if (tk->m_iid == iid)
-      break;
+  for (uint32_t i = 0; i < TKMAP_NSHARDS && tk == NULL; i++)
+    for (tk = ddsrt_chh_iter_first (map->m_hh[i], &it); tk; tk = ddsrt_chh_iter_next (&it))
+      if (tk->m_iid == iid)
+        break;
   if (tk == NULL)
     /* Common case of it not existing at all */
     return NULL;
@@ -155,13 +177,14 @@ struct ddsi_tkmap_instance *ddsi_tkmap_find_by_id (struct ddsi_tkmap *map, uint6
 
 struct ddsi_tkmap_instance *ddsi_tkmap_find (struct ddsi_tkmap *map, struct ddsi_serdata *sd, const bool create)
 {
+  struct ddsrt_chh * const hh = tkmap_shard (map, sd);
   struct ddsi_tkmap_instance dummy;
   struct ddsi_tkmap_instance *tk;
 
   assert (ddsi_thread_is_awake ());
   dummy.m_sample = sd;
 retry:
-  if ((tk = ddsrt_chh_lookup(map->m_hh, &dummy)) != NULL)
+  if ((tk = ddsrt_chh_lookup(hh, &dummy)) != NULL)
   {
     uint32_t new;
     new = ddsrt_atomic_inc32_nv(&tk->m_refc);
@@ -174,7 +197,7 @@ retry:
        we can block until someone signals some entry is removed from the map if we take
        some lock & wait for some condition */
       ddsrt_mutex_lock(&map->m_lock);
-      while ((tk = ddsrt_chh_lookup(map->m_hh, &dummy)) != NULL && (ddsrt_atomic_ld32(&tk->m_refc) & REFC_DELETE))
+      while ((tk = ddsrt_chh_lookup(hh, &dummy)) != NULL && (ddsrt_atomic_ld32(&tk->m_refc) & REFC_DELETE))
         ddsrt_cond_wait(&map->m_cond, &map->m_lock);
       ddsrt_mutex_unlock(&map->m_lock);
       goto retry;
@@ -188,7 +211,7 @@ retry:
     tk->m_sample = ddsi_serdata_to_untyped (sd);
     ddsrt_atomic_st32 (&tk->m_refc, 1);
     tk->m_iid = ddsi_iid_gen ();
-    if (!ddsrt_chh_add (map->m_hh, tk))
+    if (!ddsrt_chh_add (hh, tk))
     {
       /* Lost a race from another thread, retry */
       ddsi_serdata_unref (tk->m_sample);
@@ -226,7 +249,7 @@ void ddsi_tkmap_instance_unref (struct ddsi_tkmap *map, struct ddsi_tkmap_instan
   if (new == REFC_DELETE)
   {
     /* Remove from hash table */
-    bool removed = ddsrt_chh_remove(map->m_hh, tk);
+    bool removed = ddsrt_chh_remove(tkmap_shard (map, tk->m_sample), tk);
     assert (removed);
     (void)removed;
 
@@ -36,6 +36,8 @@ extern inline int ddsi_listener_locator (struct ddsi_tran_listener * listener, d
 extern inline int ddsi_listener_listen (struct ddsi_tran_listener * listener);
 extern inline struct ddsi_tran_conn * ddsi_listener_accept (struct ddsi_tran_listener * listener);
 extern inline ssize_t ddsi_conn_read (struct ddsi_tran_conn * conn, unsigned char * buf, size_t len, bool allow_spurious, struct ddsi_network_packet_info *pktinfo);
+extern inline int ddsi_conn_read_multi (struct ddsi_tran_conn * conn, struct ddsi_tran_read_msg *msgs, uint32_t nmsgs);
+extern inline uint32_t ddsi_conn_write_multi (struct ddsi_tran_conn * conn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs, uint32_t flags);
 extern inline ssize_t ddsi_conn_write (struct ddsi_tran_conn * conn, const ddsi_locator_t *dst, const ddsi_tran_write_msgfrags_t *msgfrags, uint32_t flags);
 extern inline uint32_t ddsi_tran_get_locator_port (const struct ddsi_tran_factory *factory, const ddsi_locator_t *loc);
 extern inline void ddsi_tran_set_locator_port (const struct ddsi_tran_factory *factory, ddsi_locator_t *loc, uint32_t port);
@@ -173,6 +175,8 @@ void ddsi_conn_add_ref (struct ddsi_tran_conn * conn)
 void ddsi_factory_conn_init (const struct ddsi_tran_factory *factory, const struct ddsi_network_interface *interf, struct ddsi_tran_conn * conn)
 {
   ddsrt_atomic_st32 (&conn->m_count, 1);
+  conn->m_read_multi_fn = 0;
+  conn->m_write_multi_fn = 0;
   conn->m_connless = factory->m_connless;
   conn->m_stream = factory->m_stream;
   conn->m_factory = (struct ddsi_tran_factory *) factory;
@@ -31,6 +31,8 @@
 #include "ddsi__xevent.h"
 #include "ddsi__transmit.h"
 #include "ddsi__hbcontrol.h"
+#include "ddsi__pacing.h"
+#include "ddsi__compression.h"
 #include "ddsi__receive.h"
 #include "ddsi__lease.h"
 #include "ddsi__security_omg.h"
@@ -39,28 +41,24 @@
 #include "ddsi__endpoint_match.h"
 #include "ddsi__protocol.h"
 #include "ddsi__vendor.h"
+#include "ddsi__ack_tracker.h"
+#include "ddsi__content_filter.h"
 #include "dds__whc.h"
 
-static const struct ddsi_wr_prd_match *root_rdmatch (const struct ddsi_writer *wr)
-{
-  return ddsrt_avl_root (&ddsi_wr_readers_treedef, &wr->readers);
-}
-
 static int have_reliable_subs (const struct ddsi_writer *wr)
 {
-  if (ddsrt_avl_is_empty (&wr->readers) || root_rdmatch (wr)->min_seq == DDSI_MAX_SEQ_NUMBER)
+  if (ddsi_ack_tracker_min_seq (&wr->ack_tracker) == DDSI_MAX_SEQ_NUMBER)
     return 0;
   else
     return 1;
 }
 
-static dds_return_t ddsi_create_fragment_message_simple (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_xmsg **pmsg)
+static dds_return_t ddsi_create_fragment_message_simple (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_addrset *as, struct ddsi_xmsg **pmsg)
 {
 #define TEST_KEYHASH 0
   /* actual expected_inline_qos_size is typically 0, but always claiming 32 bytes won't make
      a difference, so no point in being precise */
   const size_t expected_inline_qos_size = /* statusinfo */ 8 + /* keyhash */ 20 + /* sentinel */ 4;
-  struct ddsi_domaingv const * const gv = wr->e.gv;
   struct ddsi_xmsg_marker sm_marker;
   unsigned char contentflag = 0;
   ddsi_rtps_data_t *data;
@@ -84,10 +82,10 @@ static dds_return_t ddsi_create_fragment_message_simple (struct ddsi_writer *wr,
   ASSERT_MUTEX_HELD (&wr->e.lock);
 
   /* INFO_TS: 12 bytes, ddsi_rtps_data_t: 24 bytes, expected inline QoS: 32 => should be single chunk */
-  if ((*pmsg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_data_t) + expected_inline_qos_size, DDSI_XMSG_KIND_DATA)) == NULL)
+  if ((*pmsg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_data_t) + expected_inline_qos_size, DDSI_XMSG_KIND_DATA)) == NULL)
     return DDS_RETCODE_OUT_OF_RESOURCES;
 
-  ddsi_xmsg_setdst_addrset (*pmsg, wr->as);
+  ddsi_xmsg_setdst_addrset (*pmsg, as);
   ddsi_xmsg_setmaxdelay (*pmsg, wr->xqos->latency_budget.duration);
   ddsi_xmsg_add_timestamp (*pmsg, serdata->timestamp);
   data = ddsi_xmsg_append (*pmsg, &sm_marker, sizeof (ddsi_rtps_data_t));
@@ -124,7 +122,7 @@ static dds_return_t ddsi_create_fragment_message_simple (struct ddsi_writer *wr,
   return 0;
 }
 
-dds_return_t ddsi_create_fragment_message (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, uint32_t fragnum, uint16_t nfrags, const struct ddsi_proxy_reader *prd, struct ddsi_xmsg **pmsg, int isnew, uint32_t advertised_fragnum)
+static dds_return_t create_fragment_message_as (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, uint32_t fragnum, uint16_t nfrags, const struct ddsi_proxy_reader *prd, struct ddsi_addrset *as, struct ddsi_xmsg **pmsg, int isnew, uint32_t advertised_fragnum)
 {
   /* We always fragment into FRAGMENT_SIZEd fragments, which are near
      the smallest allowed fragment size & can't be bothered (yet) to
@@ -164,7 +162,7 @@ dds_return_t ddsi_create_fragment_message (struct ddsi_writer *wr, ddsi_seqno_t
   fragging = (nfrags * (uint32_t) gv->config.fragment_size < size);
 
   /* INFO_TS: 12 bytes, ddsi_rtps_datafrag_t: 36 bytes, expected inline QoS: 32 => should be single chunk */
-  if ((*pmsg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_datafrag_t) + expected_inline_qos_size, xmsg_kind)) == NULL)
+  if ((*pmsg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_datafrag_t) + expected_inline_qos_size, xmsg_kind)) == NULL)
     return DDS_RETCODE_OUT_OF_RESOURCES;
 
   if (prd)
@@ -174,7 +172,7 @@ dds_return_t ddsi_create_fragment_message (struct ddsi_writer *wr, ddsi_seqno_t
   }
   else
   {
-    ddsi_xmsg_setdst_addrset (*pmsg, wr->as);
+    ddsi_xmsg_setdst_addrset (*pmsg, as);
     ddsi_xmsg_setmaxdelay (*pmsg, wr->xqos->latency_budget.duration);
   }
 
@@ -288,18 +286,95 @@ dds_return_t ddsi_create_fragment_message (struct ddsi_writer *wr, ddsi_seqno_t
   return ret;
 }
 
-static void create_HeartbeatFrag (struct ddsi_writer *wr, ddsi_seqno_t seq, unsigned fragnum, struct ddsi_proxy_reader *prd, struct ddsi_xmsg **pmsg)
+dds_return_t ddsi_create_fragment_message (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, uint32_t fragnum, uint16_t nfrags, const struct ddsi_proxy_reader *prd, struct ddsi_xmsg **pmsg, int isnew, uint32_t advertised_fragnum)
 {
+  return create_fragment_message_as (wr, seq, serdata, fragnum, nfrags, prd, wr->as, pmsg, isnew, advertised_fragnum);
+}
+
+static dds_return_t create_fragment_parity_message (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, uint32_t fragnum, uint32_t nfrags_per_block, uint32_t nblocks, struct ddsi_addrset *as, struct ddsi_xmsg **pmsg)
+{
+  /* Parity for nblocks consecutive DataFrag submessages of nfrags_per_block
+     fragments each, the first one starting at fragment fragnum (0-based).
+     The submessage is laid out as a DataFrag for the first block, including
+     timestamp and inline QoS if that is the first of the sample, so that the
+     receiver can turn it into the DataFrag of whichever block it lost.  The
+     number of blocks is stored in extraFlags, the payload is the XOR of the
+     blocks with the short last block of the sample zero-padded. */
+  const size_t expected_inline_qos_size = /* statusinfo */ 8 + /* keyhash */ 20 + /* sentinel */ 4;
   struct ddsi_domaingv const * const gv = wr->e.gv;
+  struct ddsi_xmsg_marker sm_marker;
+  ddsi_rtps_datafrag_t *frag;
+  const uint32_t size = ddsi_serdata_size (serdata);
+  const uint32_t blocksize = nfrags_per_block * (uint32_t) gv->config.fragment_size;
+  const uint32_t begin = fragnum * (uint32_t) gv->config.fragment_size;
+  const uint32_t paritysize = (size - begin < blocksize) ? size - begin : blocksize;
+  const uint32_t paritysize4 = (paritysize + 3) & ~(uint32_t) 3;
+
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  assert (serdata->kind != SDK_EMPTY);
+  assert (begin < size && 0 < nblocks && nblocks <= UINT16_MAX && nfrags_per_block <= UINT16_MAX);
+
+  if ((*pmsg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_datafrag_t) + expected_inline_qos_size + paritysize4, DDSI_XMSG_KIND_DATA)) == NULL)
+    return DDS_RETCODE_OUT_OF_RESOURCES;
+  ddsi_xmsg_setdst_addrset (*pmsg, as);
+  ddsi_xmsg_setmaxdelay (*pmsg, wr->xqos->latency_budget.duration);
+  if (fragnum == 0)
+    ddsi_xmsg_add_timestamp (*pmsg, serdata->timestamp);
+
+  frag = ddsi_xmsg_append (*pmsg, &sm_marker, sizeof (ddsi_rtps_datafrag_t));
+  ddsi_xmsg_submsg_init (*pmsg, sm_marker, DDSI_RTPS_SMID_ADLINK_DATA_FRAG_PARITY);
+  frag->x.smhdr.flags = (unsigned char) (frag->x.smhdr.flags | (serdata->kind == SDK_KEY ? DDSI_DATAFRAG_FLAG_KEYFLAG : 0));
+  frag->x.extraFlags = (uint16_t) nblocks;
+  frag->x.octetsToInlineQos = (unsigned short) ((char*) (frag+1) - ((char*) &frag->x.octetsToInlineQos + 2));
+  frag->x.readerId = ddsi_hton_entityid (ddsi_to_entityid (DDSI_ENTITYID_UNKNOWN));
+  frag->x.writerId = ddsi_hton_entityid (wr->e.guid.entityid);
+  frag->x.writerSN = ddsi_to_seqno (seq);
+  frag->fragmentStartingNum = fragnum + 1;
+  frag->fragmentsInSubmessage = (uint16_t) nfrags_per_block;
+  frag->fragmentSize = gv->config.fragment_size;
+  frag->sampleSize = size;
+
+  if (fragnum == 0)
+  {
+    if (wr->num_readers_requesting_keyhash > 0)
+      ddsi_xmsg_addpar_keyhash (*pmsg, serdata, wr->force_md5_keyhash);
+    if (serdata->statusinfo)
+      ddsi_xmsg_addpar_statusinfo (*pmsg, serdata->statusinfo);
+    if (ddsi_xmsg_addpar_sentinel_ifparam (*pmsg) > 0)
+    {
+      frag = ddsi_xmsg_submsg_from_marker (*pmsg, sm_marker);
+      frag->x.smhdr.flags |= DDSI_DATAFRAG_FLAG_INLINE_QOS;
+    }
+  }
+
+  unsigned char *parity = ddsi_xmsg_append (*pmsg, NULL, paritysize4);
+  memset (parity, 0, paritysize4);
+  for (uint32_t i = 0; i < nblocks; i++)
+  {
+    const uint32_t off = begin + i * blocksize;
+    const uint32_t len = (size - off < blocksize) ? size - off : blocksize;
+    ddsrt_iovec_t iov;
+    struct ddsi_serdata *ref = ddsi_serdata_to_ser_ref (serdata, off, len, &iov);
+    const unsigned char *src = iov.iov_base;
+    for (uint32_t j = 0; j < len; j++)
+      parity[j] ^= src[j];
+    ddsi_serdata_to_ser_unref (ref, &iov);
+  }
+  ddsi_xmsg_submsg_setnext (*pmsg, sm_marker);
+  return 0;
+}
+
+static void create_HeartbeatFrag (struct ddsi_writer *wr, ddsi_seqno_t seq, unsigned fragnum, struct ddsi_proxy_reader *prd, struct ddsi_addrset *as, struct ddsi_xmsg **pmsg)
+{
   struct ddsi_xmsg_marker sm_marker;
   ddsi_rtps_heartbeatfrag_t *hbf;
   ASSERT_MUTEX_HELD (&wr->e.lock);
-  if ((*pmsg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_heartbeatfrag_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
+  if ((*pmsg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_heartbeatfrag_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
     return; /* ignore out-of-memory: HeartbeatFrag is only advisory anyway */
   if (prd)
     ddsi_xmsg_setdst_prd (*pmsg, prd);
   else
-    ddsi_xmsg_setdst_addrset (*pmsg, wr->as);
+    ddsi_xmsg_setdst_addrset (*pmsg, as);
   hbf = ddsi_xmsg_append (*pmsg, &sm_marker, sizeof (ddsi_rtps_heartbeatfrag_t));
   ddsi_xmsg_submsg_init (*pmsg, sm_marker, DDSI_RTPS_SMID_HEARTBEAT_FRAG);
   hbf->readerId = ddsi_hton_entityid (prd ? prd->e.guid.entityid : ddsi_to_entityid (DDSI_ENTITYID_UNKNOWN));
@@ -341,7 +416,7 @@ dds_return_t ddsi_write_hb_liveliness (struct ddsi_domaingv * const gv, struct d
   else if (wr->xqos->liveliness.kind == DDS_LIVELINESS_MANUAL_BY_TOPIC && wr->lease != NULL)
     ddsi_lease_renew (wr->lease, ddsrt_time_elapsed());
 
-  if ((msg = ddsi_xmsg_new (gv->xmsgpool, &wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
+  if ((msg = ddsi_xmsg_new (&wr->e.guid, wr->c.pp, sizeof (ddsi_rtps_info_ts_t) + sizeof (ddsi_rtps_heartbeat_t), DDSI_XMSG_KIND_CONTROL)) == NULL)
     return DDS_RETCODE_OUT_OF_RESOURCES;
   ddsrt_mutex_lock (&wr->e.lock);
   ddsi_xmsg_setdst_addrset (msg, wr->as);
@@ -377,7 +452,7 @@ static int must_skip_frag (const char *frags_to_skip, unsigned frag)
 }
 #endif
 
-static void transmit_sample_lgmsg_unlocks_wr (struct ddsi_xpack *xp, struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, int isnew, uint32_t nfrags, uint32_t nfrags_lim)
+static void transmit_sample_lgmsg_unlocks_wr (struct ddsi_xpack *xp, struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, struct ddsi_addrset *as, int isnew, uint32_t nfrags, uint32_t nfrags_lim)
 {
 #if 0
   const char *frags_to_skip = getenv ("SKIPFRAGS");
@@ -389,10 +464,22 @@ static void transmit_sample_lgmsg_unlocks_wr (struct ddsi_xpack *xp, struct ddsi
     nf_in_submsg = 1;
   else if (nf_in_submsg > UINT16_MAX)
     nf_in_submsg = UINT16_MAX;
+  /* Forward error correction only makes sense if there is no other way to
+     recover from loss and the sample requires multiple DataFrags */
+  const uint32_t nf_per_block = nf_in_submsg;
+  uint32_t fec_group_size = 0, fec_group_start = 0, fec_group_n = 0;
+  if (isnew && prd == NULL && !wr->reliable && nfrags_lim == nfrags && nfrags > nf_per_block &&
+      !ddsi_omg_writer_is_submessage_protected (wr) && !ddsi_omg_writer_is_payload_protected (wr))
+  {
+    fec_group_size = wr->e.gv->config.fragment_parity_group_size;
+    if (fec_group_size > UINT16_MAX)
+      fec_group_size = UINT16_MAX;
+  }
   for (uint32_t i = 0; i < nfrags_lim; i += nf_in_submsg)
   {
     struct ddsi_xmsg *fmsg = NULL;
     struct ddsi_xmsg *hmsg = NULL;
+    struct ddsi_xmsg *pmsg = NULL;
     int ret;
 #if 0
     if (must_skip_frag (frags_to_skip, i))
@@ -406,22 +493,29 @@ static void transmit_sample_lgmsg_unlocks_wr (struct ddsi_xpack *xp, struct ddsi
        eventually we'll have to retry.  But if a packet went out and
        we haven't yet completed transmitting a fragmented message, add
        a HeartbeatFrag. */
-    ret = ddsi_create_fragment_message (wr, seq, serdata, i, (uint16_t) nf_in_submsg, prd, &fmsg, isnew, i + nf_in_submsg == nfrags_lim ? nfrags - 1 : UINT32_MAX);
+    ret = create_fragment_message_as (wr, seq, serdata, i, (uint16_t) nf_in_submsg, prd, as, &fmsg, isnew, i + nf_in_submsg == nfrags_lim ? nfrags - 1 : UINT32_MAX);
     if (ret >= 0 && i + nf_in_submsg < nfrags_lim && wr->heartbeat_xevent)
     {
       // more fragment messages to come
-      create_HeartbeatFrag (wr, seq, i + nf_in_submsg - 1, prd, &hmsg);
+      create_HeartbeatFrag (wr, seq, i + nf_in_submsg - 1, prd, as, &hmsg);
+    }
+    if (fec_group_size > 0 && (++fec_group_n == fec_group_size || i + nf_in_submsg == nfrags_lim))
+    {
+      (void) create_fragment_parity_message (wr, seq, serdata, fec_group_start, nf_per_block, fec_group_n, as, &pmsg);
+      fec_group_start = i + nf_in_submsg;
+      fec_group_n = 0;
     }
     ddsrt_mutex_unlock (&wr->e.lock);
 
     if(fmsg) ddsi_xpack_addmsg (xp, fmsg, 0);
     if(hmsg) ddsi_xpack_addmsg (xp, hmsg, 0);
+    if(pmsg) ddsi_xpack_addmsg (xp, pmsg, 0);
 
     ddsrt_mutex_lock (&wr->e.lock);
   }
 }
 
-static void transmit_sample_unlocks_wr (struct ddsi_xpack *xp, struct ddsi_writer *wr, const struct ddsi_whc_state *whcst, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, int isnew)
+static void transmit_sample_unlocks_wr (struct ddsi_xpack *xp, struct ddsi_writer *wr, const struct ddsi_whc_state *whcst, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, struct ddsi_addrset *as, int isnew)
 {
   /* on entry: &wr->e.lock held; on exit: lock no longer held */
   struct ddsi_domaingv const * const gv = wr->e.gv;
@@ -444,12 +538,12 @@ static void transmit_sample_unlocks_wr (struct ddsi_xpack *xp, struct ddsi_write
     else
       nfrags_lim = (max_burst_size + gv->config.fragment_size - 1) / gv->config.fragment_size;
 
-    transmit_sample_lgmsg_unlocks_wr (xp, wr, seq, serdata, prd, isnew, nfrags, nfrags_lim);
+    transmit_sample_lgmsg_unlocks_wr (xp, wr, seq, serdata, prd, as, isnew, nfrags, nfrags_lim);
   }
   else
   {
     struct ddsi_xmsg *fmsg;
-    if (ddsi_create_fragment_message_simple (wr, seq, serdata, &fmsg) >= 0)
+    if (ddsi_create_fragment_message_simple (wr, seq, serdata, as, &fmsg) >= 0)
       ddsi_xpack_addmsg (xp, fmsg, 0);
   }
 
@@ -471,7 +565,7 @@ void ddsi_enqueue_spdp_sample_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t
     ddsi_qxev_msg (wr->evq, msg);
 }
 
-int ddsi_enqueue_sample_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, int isnew)
+static int enqueue_sample_as_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, struct ddsi_addrset *as, int isnew)
 {
   struct ddsi_domaingv const * const gv = wr->e.gv;
   uint32_t i, sz, nfrags;
@@ -503,10 +597,10 @@ int ddsi_enqueue_sample_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t seq, s
        eventually we'll have to retry.  But if a packet went out and
        we haven't yet completed transmitting a fragmented message, add
        a HeartbeatFrag. */
-    if (ddsi_create_fragment_message (wr, seq, serdata, i, 1, prd, &fmsg, isnew, (i+1) == nfrags ? i : UINT32_MAX) >= 0)
+    if (create_fragment_message_as (wr, seq, serdata, i, 1, prd, as, &fmsg, isnew, (i+1) == nfrags ? i : UINT32_MAX) >= 0)
     {
       if (nfrags > 1 && i + 1 < nfrags)
-        create_HeartbeatFrag (wr, seq, i, prd, &hmsg);
+        create_HeartbeatFrag (wr, seq, i, prd, as, &hmsg);
     }
     if (isnew)
     {
@@ -545,6 +639,11 @@ int ddsi_enqueue_sample_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t seq, s
   return (enqueued != DDSI_QXEV_MSG_REXMIT_DROPPED) ? 0 : -1;
 }
 
+int ddsi_enqueue_sample_wrlock_held (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_proxy_reader *prd, int isnew)
+{
+  return enqueue_sample_as_wrlock_held (wr, seq, serdata, prd, wr->as, isnew);
+}
+
 static int insert_sample_in_whc (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *serdata, struct ddsi_tkmap_instance *tk)
 {
   /* returns: < 0 on error, 0 if no need to insert in whc, > 0 if inserted */
@@ -726,6 +825,49 @@ static dds_return_t throttle_writer (struct ddsi_thread_state * const thrst, str
   return result;
 }
 
+static void pace_writer (struct ddsi_thread_state * const thrst, struct ddsi_xpack *xp, struct ddsi_writer *wr, int64_t delay)
+{
+  /* Same considerations regarding the lifetime of the writer as for
+     throttle_writer: the writer can't be freed while "pacing.waiting"
+     is non-zero.  The wait is bounded by the max_blocking_time, but
+     unlike hitting the WHC high-water mark, running out of tokens is
+     not an error: the sample is sent anyway. */
+  struct ddsi_domaingv const * const gv = wr->e.gv;
+  const ddsrt_mtime_t pace_start = ddsrt_time_monotonic ();
+  if (delay > wr->xqos->reliability.max_blocking_time)
+    delay = wr->xqos->reliability.max_blocking_time;
+  const ddsrt_mtime_t abstimeout = ddsrt_mtime_add_duration (pace_start, delay);
+  ddsrt_mtime_t tnow;
+
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  GVLOG (DDS_LC_THROTTLE, "writer "PGUIDFMT" pacing %"PRId64"ns (rate %"PRIu64" B/s)\n", PGUID (wr->e.guid), delay, wr->pacing.rate);
+  wr->pacing.waiting++;
+
+  /* Anything queued up in the packer was written before this sample,
+     so it has already been paid for */
+  if (xp)
+  {
+    ddsrt_mutex_unlock (&wr->e.lock);
+    ddsi_xpack_send (xp, true);
+    ddsrt_mutex_lock (&wr->e.lock);
+  }
+
+  while (ddsrt_atomic_ld32 (&gv->rtps_keepgoing) && wr->state == WRST_OPERATIONAL && (tnow = ddsrt_time_monotonic ()).v < abstimeout.v)
+  {
+    ddsi_thread_state_asleep (thrst);
+    (void) ddsrt_cond_waitfor (&wr->throttle_cond, &wr->e.lock, abstimeout.v - tnow.v);
+    ddsi_thread_state_awake_domain_ok (thrst);
+  }
+
+  wr->pacing.waiting--;
+  wr->pacing.time_paced += (uint64_t) (ddsrt_time_monotonic ().v - pace_start.v);
+  if (wr->state != WRST_OPERATIONAL)
+  {
+    /* gc_delete_writer may be waiting */
+    ddsrt_cond_broadcast (&wr->throttle_cond);
+  }
+}
+
 static int maybe_grow_whc (struct ddsi_writer *wr)
 {
   struct ddsi_domaingv const * const gv = wr->e.gv;
@@ -812,9 +954,22 @@ prd_is_deleting:
   return r;
 }
 
+static void store_xmit_serdata_in_whc (struct ddsi_writer *wr, ddsi_seqno_t seq, struct ddsi_serdata *xmit_serdata)
+{
+  /* so that retransmits needn't compress the sample again */
+  struct ddsi_whc_borrowed_sample sample;
+  if (ddsi_whc_borrow_sample (wr->whc, seq, &sample))
+  {
+    if (sample.xmit_serdata == NULL)
+      sample.xmit_serdata = ddsi_serdata_ref (xmit_serdata);
+    ddsi_whc_return_sample (wr->whc, &sample, false);
+  }
+}
+
 static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpack *xp, struct ddsi_writer *wr, struct ddsi_serdata *serdata, struct ddsi_tkmap_instance *tk, int gc_allowed)
 {
   struct ddsi_domaingv const * const gv = wr->e.gv;
+  struct ddsi_serdata *xmit_serdata = NULL, *compressed = NULL;
   int r;
   ddsi_seqno_t seq;
   ddsrt_mtime_t tnow;
@@ -875,6 +1030,25 @@ static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpa
     }
   }
 
+  /* The WHC keeps the original, what goes out may be compressed: retransmits and late-joining
+     readers may need a different representation (see ddsi_writer_serdata_for_xmit) */
+  xmit_serdata = ddsi_writer_serdata_for_xmit (wr, serdata, &compressed, NULL);
+
+  /* Then wait for our turn if the writer is paced */
+  if (wr->pacing.rate > 0 && gc_allowed && wr->state == WRST_OPERATIONAL)
+  {
+    const int64_t delay = ddsi_pacing_take (&wr->pacing, &gv->config, ddsi_serdata_size (xmit_serdata), ddsrt_time_monotonic ());
+    if (delay > 0)
+      pace_writer (thrst, xp, wr, delay);
+  }
+
+  /* Pacing may have released the lock, matching a reader that can't decode it */
+  if (xmit_serdata != serdata && wr->num_readers_accepting_compression != wr->num_readers)
+  {
+    ddsi_serdata_unref (xmit_serdata);
+    xmit_serdata = ddsi_serdata_ref (serdata);
+  }
+
   if (wr->state != WRST_OPERATIONAL)
   {
     r = DDS_RETCODE_PRECONDITION_NOT_MET;
@@ -885,9 +1059,12 @@ static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpa
   /* Always use the current monotonic time */
   tnow = ddsrt_time_monotonic ();
   serdata->twrite = tnow;
+  xmit_serdata->twrite = tnow;
 
   seq = ++wr->seq;
-  if ((r = insert_sample_in_whc (wr, seq, serdata, tk)) < 0)
+  if ((r = insert_sample_in_whc (wr, seq, serdata, tk)) > 0 && compressed)
+    store_xmit_serdata_in_whc (wr, seq, compressed);
+  if (r < 0)
   {
     /* Failure of some kind */
     ddsrt_mutex_unlock (&wr->e.lock);
@@ -911,6 +1088,23 @@ static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpa
   }
   else
   {
+    /* With content filtering by some of the readers, the sample only goes to the
+       readers that accept it.  If none does, it is handled like a sample sent to
+       nowhere; the readers learn about it from GAPs or from the heartbeats. */
+    struct ddsi_addrset *as;
+    if (wr->num_content_filtered_readers == 0)
+      as = ddsi_ref_addrset (wr->as);
+    else if ((as = ddsi_writer_content_filter_select (wr, seq, serdata)) == NULL)
+    {
+      GVTRACE ("writer "PGUIDFMT" #%"PRIu64" rejected by all content filters\n", PGUID (wr->e.guid), seq);
+      wr->content_filter_skipped++;
+      ddsi_writer_update_seq_xmit (wr, seq);
+      if (wr->heartbeat_xevent)
+        ddsi_writer_hbcontrol_note_asyncwrite (wr, tnow);
+      ddsrt_mutex_unlock (&wr->e.lock);
+      goto drop;
+    }
+
     /* Note the subtlety of enqueueing with the lock held but
        transmitting without holding the lock. Still working on
        cleaning that up. */
@@ -924,7 +1118,7 @@ static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpa
         ddsi_whc_get_state(wr->whc, &whcst);
         whcstptr = &whcst;
       }
-      transmit_sample_unlocks_wr (xp, wr, whcstptr, seq, serdata, NULL, 1);
+      transmit_sample_unlocks_wr (xp, wr, whcstptr, seq, xmit_serdata, NULL, as, 1);
     }
     else
     {
@@ -933,12 +1127,17 @@ static int write_sample (struct ddsi_thread_state * const thrst, struct ddsi_xpa
       if (wr->e.guid.entityid.u == DDSI_ENTITYID_SPDP_BUILTIN_PARTICIPANT_WRITER)
         ddsi_enqueue_spdp_sample_wrlock_held(wr, seq, serdata, NULL);
       else
-        ddsi_enqueue_sample_wrlock_held (wr, seq, serdata, NULL, 1);
+        enqueue_sample_as_wrlock_held (wr, seq, xmit_serdata, NULL, as, 1);
       ddsrt_mutex_unlock (&wr->e.lock);
     }
+    ddsi_unref_addrset (as);
   }
 
 drop:
+  if (xmit_serdata)
+    ddsi_serdata_unref (xmit_serdata);
+  if (compressed)
+    ddsi_serdata_unref (compressed);
   /* FIXME: shouldn't I move the ddsi_serdata_unref call to the callers? */
   ddsi_serdata_unref (serdata);
   return r;
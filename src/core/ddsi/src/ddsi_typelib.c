@@ -43,6 +43,11 @@ static int ddsi_typeid_compare_dep_src (const void *typedep_a, const void *typed
 const ddsrt_avl_treedef_t ddsi_typedeps_treedef = DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_type_dep, src_avl_node), 0, ddsi_typeid_compare_src_dep, 0);
 const ddsrt_avl_treedef_t ddsi_typedeps_reverse_treedef = DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_type_dep, dep_avl_node), 0, ddsi_typeid_compare_dep_src, 0);
 
+static int ddsi_type_assignable_compare_rd_wr (const void *va, const void *vb);
+static int ddsi_type_assignable_compare_wr_rd (const void *va, const void *vb);
+const ddsrt_avl_treedef_t ddsi_type_assignable_treedef = DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_type_assignable, rd_avl_node), 0, ddsi_type_assignable_compare_rd_wr, 0);
+const ddsrt_avl_treedef_t ddsi_type_assignable_reverse_treedef = DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct ddsi_type_assignable, wr_avl_node), 0, ddsi_type_assignable_compare_wr_rd, 0);
+
 bool ddsi_typeinfo_equal (const ddsi_typeinfo_t *a, const ddsi_typeinfo_t *b, enum ddsi_type_include_deps deps)
 {
   if (a == NULL || b == NULL)
@@ -221,6 +226,88 @@ const char * ddsi_typemap_get_type_name (const ddsi_typemap_t *typemap, const dd
   return ddsi_typeobj_get_type_name_impl (type_obj);
 }
 
+static const struct DDS_XTypes_TypeObject *typemap_complete_typeobj_strip_aliases (const ddsi_typemap_t *tmap, const struct DDS_XTypes_TypeIdentifier **type_id)
+{
+  while (ddsi_typeid_is_hash_impl (*type_id))
+  {
+    const struct DDS_XTypes_TypeObject *type_obj = ddsi_typemap_typeobj (tmap, *type_id);
+    if (type_obj == NULL || type_obj->_d != DDS_XTypes_EK_COMPLETE)
+      return NULL;
+    if (type_obj->_u.complete._d != DDS_XTypes_TK_ALIAS)
+      return type_obj;
+    *type_id = &type_obj->_u.complete._u.alias_type.body.common.related_type;
+  }
+  return NULL;
+}
+
+static const uint32_t *typemap_find_struct_member (const ddsi_typemap_t *tmap, const struct DDS_XTypes_CompleteStructType *st, const uint32_t *ops, const char *name, size_t namelen, const struct DDS_XTypes_TypeIdentifier **member_type_id)
+{
+  for (uint32_t i = 0; i < st->member_seq._length; i++)
+  {
+    const struct DDS_XTypes_CompleteStructMember *m = &st->member_seq._buffer[i];
+    if (strlen (m->detail.name) == namelen && memcmp (m->detail.name, name, namelen) == 0)
+    {
+      *member_type_id = &m->common.member_type_id;
+      return dds_stream_member_adr (ops, i, m->common.member_id);
+    }
+  }
+
+  // members of the base type are accessible as if they are members of the derived type
+  const struct DDS_XTypes_TypeIdentifier *base_type_id = &st->header.base_type;
+  const struct DDS_XTypes_TypeObject *base_obj;
+  const uint32_t *base_ops;
+  if (base_type_id->_d == DDS_XTypes_TK_NONE)
+    return NULL;
+  if ((base_obj = typemap_complete_typeobj_strip_aliases (tmap, &base_type_id)) == NULL || base_obj->_u.complete._d != DDS_XTypes_TK_STRUCTURE)
+    return NULL;
+  if ((base_ops = dds_stream_base_type_ops (ops)) == NULL)
+    return NULL;
+  return typemap_find_struct_member (tmap, &base_obj->_u.complete._u.struct_type, base_ops, name, namelen, member_type_id);
+}
+
+dds_return_t ddsi_typemap_resolve_member (const ddsi_typemap_t *typemap, const ddsi_typeid_t *type_id, const uint32_t *ops, const char *name, struct dds_cdrstream_member_path *path, const struct DDS_XTypes_CompleteEnumeratedType **enum_type)
+{
+  const uint32_t * const op0 = ops;
+  const struct DDS_XTypes_TypeIdentifier *member_type_id = &type_id->x;
+  const struct DDS_XTypes_TypeObject *type_obj;
+  const uint32_t *adr;
+
+  path->n = 0;
+  *enum_type = NULL;
+  while (true)
+  {
+    const char *dot = strchr (name, '.');
+    const size_t len = (dot != NULL) ? (size_t) (dot - name) : strlen (name);
+    if ((type_obj = typemap_complete_typeobj_strip_aliases (typemap, &member_type_id)) == NULL || type_obj->_u.complete._d != DDS_XTypes_TK_STRUCTURE)
+      return DDS_RETCODE_BAD_PARAMETER;
+    if (path->n == DDS_CDRSTREAM_MEMBER_PATH_MAX)
+      return DDS_RETCODE_UNSUPPORTED;
+    if ((adr = typemap_find_struct_member (typemap, &type_obj->_u.complete._u.struct_type, ops, name, len, &member_type_id)) == NULL)
+      return DDS_RETCODE_BAD_PARAMETER;
+    path->adr[path->n++] = (uint32_t) (adr - op0);
+    if (dot == NULL)
+      break;
+    if (DDS_OP_TYPE (*adr) != DDS_OP_VAL_EXT)
+      return DDS_RETCODE_BAD_PARAMETER;
+    ops = adr + DDS_OP_ADR_JSR (adr[2]);
+    name = dot + 1;
+  }
+
+  switch (DDS_OP_TYPE (*adr))
+  {
+    case DDS_OP_VAL_BLN: case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
+      return DDS_RETCODE_OK;
+    case DDS_OP_VAL_ENU:
+      if ((type_obj = typemap_complete_typeobj_strip_aliases (typemap, &member_type_id)) != NULL && type_obj->_u.complete._d == DDS_XTypes_TK_ENUM)
+        *enum_type = &type_obj->_u.complete._u.enumerated_type;
+      return DDS_RETCODE_OK;
+    default:
+      // aggregated types, collections and bitmasks can't be compared
+      return DDS_RETCODE_UNSUPPORTED;
+  }
+}
+
 ddsi_typemap_t *ddsi_typemap_deser (const unsigned char *data, uint32_t sz)
 {
   unsigned char *data_norm;
@@ -363,6 +450,65 @@ static int ddsi_typeid_compare_dep_src (const void *typedep_a, const void *typed
   return ddsi_typeid_compare (&a->src_type_id, &b->src_type_id);
 }
 
+static int ddsi_tce_compare (const dds_type_consistency_enforcement_qospolicy_t *a, const dds_type_consistency_enforcement_qospolicy_t *b)
+{
+  if (a->kind != b->kind)
+    return (a->kind < b->kind) ? -1 : 1;
+  const bool fa[] = { a->ignore_sequence_bounds, a->ignore_string_bounds, a->ignore_member_names, a->prevent_type_widening, a->force_type_validation };
+  const bool fb[] = { b->ignore_sequence_bounds, b->ignore_string_bounds, b->ignore_member_names, b->prevent_type_widening, b->force_type_validation };
+  for (size_t i = 0; i < sizeof (fa) / sizeof (fa[0]); i++)
+    if (fa[i] != fb[i])
+      return fa[i] ? 1 : -1;
+  return 0;
+}
+
+static int ddsi_type_assignable_compare_rd_wr (const void *va, const void *vb)
+{
+  const struct ddsi_type_assignable *a = va, *b = vb;
+  int cmp;
+  if ((cmp = ddsi_typeid_compare (&a->rd_type_id, &b->rd_type_id)))
+    return cmp;
+  if ((cmp = ddsi_typeid_compare (&a->wr_type_id, &b->wr_type_id)))
+    return cmp;
+  return ddsi_tce_compare (&a->tce, &b->tce);
+}
+
+static int ddsi_type_assignable_compare_wr_rd (const void *va, const void *vb)
+{
+  const struct ddsi_type_assignable *a = va, *b = vb;
+  int cmp;
+  if ((cmp = ddsi_typeid_compare (&a->wr_type_id, &b->wr_type_id)))
+    return cmp;
+  if ((cmp = ddsi_typeid_compare (&a->rd_type_id, &b->rd_type_id)))
+    return cmp;
+  return ddsi_tce_compare (&a->tce, &b->tce);
+}
+
+static void ddsi_type_assignable_free (struct ddsi_domaingv *gv, struct ddsi_type_assignable *ta)
+{
+  ddsrt_avl_delete (&ddsi_type_assignable_treedef, &gv->type_assignable, ta);
+  ddsrt_avl_delete (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse, ta);
+  ddsi_typeid_fini (&ta->rd_type_id);
+  ddsi_typeid_fini (&ta->wr_type_id);
+  ddsrt_free (ta);
+}
+
+static void ddsi_type_assignable_purge (struct ddsi_domaingv *gv, const ddsi_typeid_t *type_id)
+{
+  /* Cached results are dropped together with the types they refer to, which limits
+     the cache to the pairs of types actually in use.  The all-zero type identifier
+     and consistency settings sort first. */
+  struct ddsi_type_assignable key, *ta;
+  memset (&key, 0, sizeof (key));
+  key.rd_type_id = *type_id;
+  while ((ta = ddsrt_avl_lookup_succ_eq (&ddsi_type_assignable_treedef, &gv->type_assignable, &key)) != NULL && !ddsi_typeid_compare (&ta->rd_type_id, type_id))
+    ddsi_type_assignable_free (gv, ta);
+  memset (&key, 0, sizeof (key));
+  key.wr_type_id = *type_id;
+  while ((ta = ddsrt_avl_lookup_succ_eq (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse, &key)) != NULL && !ddsi_typeid_compare (&ta->wr_type_id, type_id))
+    ddsi_type_assignable_free (gv, ta);
+}
+
 static void type_dep_trace (struct ddsi_domaingv *gv, const char *prefix, struct ddsi_type_dep *dep)
 {
   struct ddsi_typeid_str tistr, tistrdep;
@@ -375,6 +521,7 @@ void ddsi_type_free (struct ddsi_type *type)
   struct ddsi_type_dep key;
   memset (&key, 0, sizeof (key));
   ddsi_typeid_copy (&key.src_type_id, &type->xt.id);
+  ddsi_type_assignable_purge (gv, &key.src_type_id);
   ddsi_xt_type_fini (gv, &type->xt, true);
 
   struct ddsi_type_dep *dep;
@@ -1429,7 +1576,41 @@ bool ddsi_is_assignable_from (struct ddsi_domaingv *gv, const struct ddsi_type_p
     *rd_xt = (rd_resolved == DDS_XTypes_EK_BOTH || rd_resolved == DDS_XTypes_EK_MINIMAL) ? &rd_type_pair->minimal->xt : &rd_type_pair->complete->xt,
     *wr_xt = (wr_resolved == DDS_XTypes_EK_BOTH || wr_resolved == DDS_XTypes_EK_MINIMAL) ? &wr_type_pair->minimal->xt : &wr_type_pair->complete->xt;
   struct ddsi_non_assignability_reason reason;
-  bool assignable = ddsi_xt_is_assignable_from (gv, rd_xt, wr_xt, tce, &reason);
+  struct ddsi_type_assignable key, *ta;
+  bool assignable;
+
+  /* Checking assignability can be expensive and in a large system the same pair of
+     types is checked over and over again.  The outcome is fully determined by the
+     type identifiers and the consistency settings once the types are resolved.  The
+     key is a shallow copy and never finalized. */
+  memset (&key, 0, sizeof (key));
+  key.rd_type_id = rd_xt->id;
+  key.wr_type_id = wr_xt->id;
+  key.tce = *tce;
+  if ((ta = ddsrt_avl_lookup (&ddsi_type_assignable_treedef, &gv->type_assignable, &key)) != NULL)
+  {
+    assignable = ta->assignable;
+    ddsrt_mutex_unlock (&gv->typelib_lock);
+    if (!assignable)
+    {
+      struct ddsi_typeid_str trdstr, twrstr;
+      GVLOGDISC ("assignability check failed: rd type %s wr type %s (cached)\n",
+                 ddsi_make_typeid_str (&trdstr, &rd_xt->id), ddsi_make_typeid_str (&twrstr, &wr_xt->id));
+    }
+    return assignable;
+  }
+
+  assignable = ddsi_xt_is_assignable_from (gv, rd_xt, wr_xt, tce, &reason);
+  if (assignable || reason.code != DDSI_NONASSIGN_TYPE_UNRESOLVED)
+  {
+    ta = ddsrt_malloc (sizeof (*ta));
+    ddsi_typeid_copy (&ta->rd_type_id, &rd_xt->id);
+    ddsi_typeid_copy (&ta->wr_type_id, &wr_xt->id);
+    ta->tce = *tce;
+    ta->assignable = assignable;
+    ddsrt_avl_insert (&ddsi_type_assignable_treedef, &gv->type_assignable, ta);
+    ddsrt_avl_insert (&ddsi_type_assignable_reverse_treedef, &gv->type_assignable_reverse, ta);
+  }
   ddsrt_mutex_unlock (&gv->typelib_lock);
 
   if (!assignable)
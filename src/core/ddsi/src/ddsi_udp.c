@@ -18,6 +18,9 @@
 
 #include <assert.h>
 #include <string.h>
+#ifdef __linux__
+#include <netinet/udp.h>
+#endif
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
@@ -59,6 +62,18 @@ DDSRT_STATIC_ASSERT (DDSI_LOCATOR_UDPv4MCGEN_INDEX_MASK_BITS <= 32 - UDP_MC_ADDR
 #  endif
 #endif
 
+// UDP generic segmentation offload: the kernel splits a large datagram into
+// segments of a size given in a control message, saving a trip through the
+// network stack per packet
+#if DDSRT_HAVE_SENDMMSG && defined __linux__ && defined UDP_SEGMENT
+#  define UDP_GSO 1
+#  define UDP_GSO_MAX_SEGMENTS 64 // UDP_MAX_SEGMENTS in the kernel
+#  define UDP_GSO_MAX_SIZE 65000  // must fit in an IP datagram
+#  define UDP_GSO_MAX_IOV 256     // iovecs for all super-packets in one call
+#else
+#  define UDP_GSO 0
+#endif
+
 union addr {
   struct sockaddr_storage x;
   struct sockaddr a;
@@ -75,6 +90,10 @@ typedef struct ddsi_udp_conn {
   WSAEVENT m_sockEvent;
 #endif
   int m_diffserv;
+#if UDP_GSO
+  // largest segment size for which GSO is attempted, 0 if unavailable
+  ddsrt_atomic_uint32_t m_gso_max;
+#endif
 } *ddsi_udp_conn_t;
 
 typedef struct ddsi_udp_tran_factory {
@@ -151,21 +170,61 @@ static void translate_pktinfo (struct ddsi_network_packet_info *pktinfo, ddsrt_m
   pktinfo->if_index = 0;
 }
 
+#if PACKET_DESTINATION_INFO
+union in_pktinfo_4_6 {
+#if defined IP_PKTINFO
+  struct in_pktinfo ip4;
+#endif
+#if DDSRT_HAVE_IPV6 && defined IPV6_PKTINFO
+  struct in6_pktinfo ip6;
+#endif
+};
+#define PKTINFO_CMSG_SPACE CMSG_SPACE (sizeof (union in_pktinfo_4_6))
+#endif // PACKET_DESTINATION_INFO
+
+static void ddsi_udp_conn_received (ddsi_udp_conn_t conn, unsigned char * buf, size_t len, const union addr *src, ddsrt_msghdr_t *msghdr, ssize_t nrecv, struct ddsi_network_packet_info *pktinfo)
+{
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  if (pktinfo)
+  {
+    addr_to_loc (conn->m_base.m_factory, &pktinfo->src, src);
+    translate_pktinfo (pktinfo, msghdr, conn->m_base.m_base.m_port, src->a.sa_family == AF_INET6);
+  }
+
+  if (gv->pcap_fp)
+  {
+    union addr dest;
+    socklen_t dest_len = sizeof (dest);
+    if (ddsrt_getsockname (conn->m_sockext.sock, &dest.a, &dest_len) != DDS_RETCODE_OK)
+      memset (&dest, 0, sizeof (dest));
+    ddsi_write_pcap_received (gv, ddsrt_time_wallclock (), &src->x, &dest.x, buf, (size_t) nrecv);
+  }
+
+  /* Check for udp packet truncation */
+#if ! DDSRT_MSGHDR_FLAGS
+  const bool trunc_flag = false;
+#elif defined MSG_CTRUNC
+  const bool trunc_flag = (msghdr->msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0;
+#else
+  const bool trunc_flag = (msghdr->msg_flags & MSG_TRUNC) != 0;
+#endif
+  if ((size_t) nrecv > len || trunc_flag)
+  {
+    char addrbuf[DDSI_LOCSTRLEN];
+    ddsi_locator_t tmp;
+    addr_to_loc (conn->m_base.m_factory, &tmp, src);
+    ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
+    GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) nrecv, (int) len);
+  }
+}
+
 static ssize_t ddsi_udp_conn_read (struct ddsi_tran_conn * conn_cmn, unsigned char * buf, size_t len, bool allow_spurious, struct ddsi_network_packet_info *pktinfo)
 {
   ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
   struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
   union addr src;
 #if PACKET_DESTINATION_INFO
-  union in_pktinfo_4_6 {
-#if defined IP_PKTINFO
-    struct in_pktinfo ip4;
-#endif
-#if DDSRT_HAVE_IPV6 && defined IPV6_PKTINFO
-    struct in6_pktinfo ip6;
-#endif
-  };
-  char incmsg[CMSG_SPACE (sizeof (union in_pktinfo_4_6))];
+  char incmsg[PKTINFO_CMSG_SPACE];
 #endif // PACKET_DESTINATION_INFO
   ddsrt_iovec_t msg_iov = {
     .iov_base = (void *) buf,
@@ -200,43 +259,62 @@ static ssize_t ddsi_udp_conn_read (struct ddsi_tran_conn * conn_cmn, unsigned ch
   }
 
   assert (rc == DDS_RETCODE_OK && nrecv >= 0);
-  if (pktinfo)
+  ddsi_udp_conn_received (conn, buf, len, &src, &msghdr, nrecv, pktinfo);
+  return nrecv;
+}
+
+#if DDSRT_HAVE_RECVMMSG
+static int ddsi_udp_conn_read_multi (struct ddsi_tran_conn * conn_cmn, struct ddsi_tran_read_msg *msgs, uint32_t nmsgs)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  union addr src[DDSI_TRAN_READ_MULTI_MAX];
+#if PACKET_DESTINATION_INFO
+  char incmsg[DDSI_TRAN_READ_MULTI_MAX][PKTINFO_CMSG_SPACE];
+#endif // PACKET_DESTINATION_INFO
+  ddsrt_iovec_t msg_iov[DDSI_TRAN_READ_MULTI_MAX];
+  ddsrt_mmsghdr_t mmsghdr[DDSI_TRAN_READ_MULTI_MAX];
+  assert (nmsgs > 0 && nmsgs <= DDSI_TRAN_READ_MULTI_MAX);
+  for (uint32_t i = 0; i < nmsgs; i++)
   {
-    addr_to_loc (conn->m_base.m_factory, &pktinfo->src, &src);
-    translate_pktinfo (pktinfo, &msghdr, conn->m_base.m_base.m_port, src.a.sa_family == AF_INET6);
+    msg_iov[i].iov_base = (void *) msgs[i].buf;
+    msg_iov[i].iov_len = (ddsrt_iov_len_t) msgs[i].len;
+    memset (&mmsghdr[i], 0, sizeof (mmsghdr[i]));
+    mmsghdr[i].msg_hdr.msg_name = &src[i].x;
+    mmsghdr[i].msg_hdr.msg_namelen = (socklen_t) sizeof (src[i]);
+    mmsghdr[i].msg_hdr.msg_iov = &msg_iov[i];
+    mmsghdr[i].msg_hdr.msg_iovlen = 1;
+#if PACKET_DESTINATION_INFO
+    mmsghdr[i].msg_hdr.msg_controllen = sizeof (incmsg[i]);
+    mmsghdr[i].msg_hdr.msg_control = incmsg[i];
+#endif // PACKET_DESTINATION_INFO
   }
 
-  if (gv->pcap_fp)
+  dds_return_t rc;
+  int nrecv;
+  do {
+    rc = ddsrt_recvmmsg (&conn->m_sockext, mmsghdr, nmsgs, MSG_WAITFORONE, &nrecv);
+  } while (rc == DDS_RETCODE_INTERRUPTED);
+
+  if (rc != DDS_RETCODE_OK)
   {
-    union addr dest;
-    socklen_t dest_len = sizeof (dest);
-    if (ddsrt_getsockname (conn->m_sockext.sock, &dest.a, &dest_len) != DDS_RETCODE_OK)
-      memset (&dest, 0, sizeof (dest));
-    ddsi_write_pcap_received (gv, ddsrt_time_wallclock (), &src.x, &dest.x, buf, (size_t) nrecv);
+    if (rc != DDS_RETCODE_BAD_PARAMETER && rc != DDS_RETCODE_NO_CONNECTION)
+      GVERROR ("UDP recvmmsg sock %d: retcode %"PRId32"\n", (int) conn->m_sockext.sock, rc);
+    return -1;
   }
 
-  /* Check for udp packet truncation */
-#if ! DDSRT_MSGHDR_FLAGS
-  const bool trunc_flag = false;
-#elif defined MSG_CTRUNC
-  const bool trunc_flag = (msghdr.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0;
-#else
-  const bool trunc_flag = (msghdr.msg_flags & MSG_TRUNC) != 0;
-#endif
-  if ((size_t) nrecv > len || trunc_flag)
+  assert (nrecv > 0 && (uint32_t) nrecv <= nmsgs);
+  for (int i = 0; i < nrecv; i++)
   {
-    char addrbuf[DDSI_LOCSTRLEN];
-    ddsi_locator_t tmp;
-    addr_to_loc (conn->m_base.m_factory, &tmp, &src);
-    ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
-    GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) nrecv, (int) len);
+    msgs[i].sz = (ssize_t) mmsghdr[i].msg_len;
+    ddsi_udp_conn_received (conn, msgs[i].buf, msgs[i].len, &src[i], &mmsghdr[i].msg_hdr, msgs[i].sz, &msgs[i].pktinfo);
   }
   return nrecv;
 }
+#endif /* DDSRT_HAVE_RECVMMSG */
 
-static ssize_t ddsi_udp_conn_write (struct ddsi_tran_conn * conn_cmn, const ddsi_locator_t *dst, const ddsi_tran_write_msgfrags_t *msgfrags, uint32_t flags)
+static ssize_t ddsi_udp_conn_write_iov (ddsi_udp_conn_t conn, const ddsi_locator_t *dst, const ddsrt_iovec_t *iov, size_t niov, uint32_t flags)
 {
-  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
   struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
   dds_return_t rc;
   ssize_t nsent = -1;
@@ -247,13 +325,13 @@ static ssize_t ddsi_udp_conn_write (struct ddsi_tran_conn * conn_cmn, const ddsi
   ddsrt_mtime_t tnow = { 0 };
 #endif
   union addr dstaddr;
-  assert (msgfrags->niov <= INT_MAX);
+  assert (niov <= INT_MAX);
   ddsi_ipaddr_from_loc (&dstaddr.x, dst);
   ddsrt_msghdr_t msg = {
     .msg_name = &dstaddr.x,
     .msg_namelen = (socklen_t) ddsrt_sockaddr_get_size (&dstaddr.a),
-    .msg_iov = (ddsrt_iovec_t *) msgfrags->iov,
-    .msg_iovlen = (ddsrt_msg_iovlen_t) msgfrags->niov
+    .msg_iov = (ddsrt_iovec_t *) iov,
+    .msg_iovlen = (ddsrt_msg_iovlen_t) niov
 #if DDSRT_MSGHDR_FLAGS
     , .msg_flags = (int) flags
 #endif
@@ -314,6 +392,187 @@ static ssize_t ddsi_udp_conn_write (struct ddsi_tran_conn * conn_cmn, const ddsi
   return (rc == DDS_RETCODE_OK) ? nsent : -1;
 }
 
+static ssize_t ddsi_udp_conn_write (struct ddsi_tran_conn * conn_cmn, const ddsi_locator_t *dst, const ddsi_tran_write_msgfrags_t *msgfrags, uint32_t flags)
+{
+  return ddsi_udp_conn_write_iov ((ddsi_udp_conn_t) conn_cmn, dst, msgfrags->iov, msgfrags->niov, flags);
+}
+
+#if DDSRT_HAVE_SENDMMSG
+static uint32_t ddsi_udp_conn_write_multi_1by1 (ddsi_udp_conn_t conn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs, uint32_t flags)
+{
+  uint32_t nsent = 0;
+  for (uint32_t i = 0; i < nmsgs; i++)
+  {
+    if (ddsi_udp_conn_write_iov (conn, msgs[i].dst, msgs[i].iov, msgs[i].niov, flags) > 0)
+      nsent++;
+    flags = 0;
+  }
+  return nsent;
+}
+
+static void ddsi_udp_conn_write_pcap_multi (ddsi_udp_conn_t conn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs)
+{
+  // the packets combined into a GSO super-packet go out as separate datagrams,
+  // so every packet gets its own record
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  const ddsrt_wctime_t tnow = ddsrt_time_wallclock ();
+  union addr sa;
+  socklen_t alen = sizeof (sa);
+  if (ddsrt_getsockname (conn->m_sockext.sock, &sa.a, &alen) != DDS_RETCODE_OK)
+    memset(&sa, 0, sizeof(sa));
+  for (uint32_t i = 0; i < nmsgs; i++)
+  {
+    union addr dstaddr;
+    ddsi_ipaddr_from_loc (&dstaddr.x, msgs[i].dst);
+    const ddsrt_msghdr_t msg = {
+      .msg_name = &dstaddr.x,
+      .msg_namelen = (socklen_t) ddsrt_sockaddr_get_size (&dstaddr.a),
+      .msg_iov = (ddsrt_iovec_t *) msgs[i].iov,
+      .msg_iovlen = (ddsrt_msg_iovlen_t) msgs[i].niov
+    };
+    ddsi_write_pcap_sent (gv, tnow, &sa.x, &msg, msgs[i].len);
+  }
+}
+
+#if UDP_GSO
+static uint32_t gso_run_end (const struct ddsi_tran_write_msg *msgs, uint32_t i, uint32_t nmsgs, uint32_t gso_max, size_t iov_avail)
+{
+  // A run of packets that can be sent as a single GSO super-packet: same
+  // destination, all the same size except for the last one, which may be
+  // shorter, and within the limits of GSO and our iovec buffer
+  const size_t segsz = msgs[i].len;
+  size_t total = segsz, niov = msgs[i].niov;
+  uint32_t j = i + 1;
+  if (segsz > gso_max || niov > iov_avail)
+    return j;
+  while (j < nmsgs && j - i < UDP_GSO_MAX_SEGMENTS &&
+         msgs[j].len <= segsz && total + msgs[j].len <= UDP_GSO_MAX_SIZE &&
+         niov + msgs[j].niov <= iov_avail &&
+         memcmp (msgs[j].dst, msgs[i].dst, sizeof (*msgs[i].dst)) == 0)
+  {
+    total += msgs[j].len;
+    niov += msgs[j].niov;
+    if (msgs[j++].len < segsz)
+      break;
+  }
+  return j;
+}
+
+static void gso_failed (ddsi_udp_conn_t conn, size_t segsz, dds_return_t rc)
+{
+  // EINVAL (or EMSGSIZE) means the segment size is too large for the path
+  // MTU, anything else is taken to mean that GSO is not available at all
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  const uint32_t gso_max = ddsrt_atomic_ld32 (&conn->m_gso_max);
+  const uint32_t new_gso_max =
+    (rc == DDS_RETCODE_BAD_PARAMETER || rc == DDS_RETCODE_NOT_ENOUGH_SPACE) ? (uint32_t) segsz - 1 : 0;
+  if (new_gso_max < gso_max)
+  {
+    ddsrt_atomic_st32 (&conn->m_gso_max, new_gso_max);
+    GVLOG (DDS_LC_CONFIG, "udp: GSO failed for segment size %"PRIuSIZE" (retcode %"PRId32"), limiting to %"PRIu32"\n", segsz, rc, new_gso_max);
+  }
+}
+#endif
+
+static uint32_t ddsi_udp_conn_write_multi (struct ddsi_tran_conn * conn_cmn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs, uint32_t flags)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  union addr dstaddr[DDSI_TRAN_WRITE_MULTI_MAX];
+  ddsrt_mmsghdr_t mmsghdr[DDSI_TRAN_WRITE_MULTI_MAX];
+  // mmsghdr[k] covers msgs[first[k] .. first[k+1]-1]
+  uint32_t first[DDSI_TRAN_WRITE_MULTI_MAX + 1];
+#if UDP_GSO
+  char gso_cmsg[DDSI_TRAN_WRITE_MULTI_MAX][CMSG_SPACE (sizeof (uint16_t))];
+  ddsrt_iovec_t gso_iov[UDP_GSO_MAX_IOV];
+  size_t gso_niov = 0;
+  const uint32_t gso_max = ddsrt_atomic_ld32 (&conn->m_gso_max);
+#endif
+  uint32_t nhdr = 0, nsent = 0;
+  unsigned retry = 2;
+  int sendflags = 0;
+  assert (nmsgs <= DDSI_TRAN_WRITE_MULTI_MAX);
+  (void) flags; // only affects msg_flags, which sendmmsg ignores
+
+  for (uint32_t i = 0, j; i < nmsgs; i = j)
+  {
+    ddsrt_msghdr_t * const mh = &mmsghdr[nhdr].msg_hdr;
+    memset (&mmsghdr[nhdr], 0, sizeof (mmsghdr[nhdr]));
+    ddsi_ipaddr_from_loc (&dstaddr[nhdr].x, msgs[i].dst);
+    mh->msg_name = &dstaddr[nhdr].x;
+    mh->msg_namelen = (socklen_t) ddsrt_sockaddr_get_size (&dstaddr[nhdr].a);
+#if UDP_GSO
+    if ((j = gso_run_end (msgs, i, nmsgs, gso_max, UDP_GSO_MAX_IOV - gso_niov)) > i + 1)
+    {
+      const uint16_t segsz = (uint16_t) msgs[i].len;
+      mh->msg_iov = &gso_iov[gso_niov];
+      for (uint32_t k = i; k < j; k++)
+      {
+        memcpy (&gso_iov[gso_niov], msgs[k].iov, msgs[k].niov * sizeof (*msgs[k].iov));
+        gso_niov += msgs[k].niov;
+      }
+      mh->msg_iovlen = (ddsrt_msg_iovlen_t) (&gso_iov[gso_niov] - mh->msg_iov);
+      mh->msg_control = gso_cmsg[nhdr];
+      mh->msg_controllen = sizeof (gso_cmsg[nhdr]);
+      struct cmsghdr * const cm = CMSG_FIRSTHDR (mh);
+      cm->cmsg_level = SOL_UDP;
+      cm->cmsg_type = UDP_SEGMENT;
+      cm->cmsg_len = CMSG_LEN (sizeof (segsz));
+      memcpy (CMSG_DATA (cm), &segsz, sizeof (segsz));
+    }
+    else
+#else
+    j = i + 1;
+#endif
+    {
+      mh->msg_iov = (ddsrt_iovec_t *) msgs[i].iov;
+      mh->msg_iovlen = (ddsrt_msg_iovlen_t) msgs[i].niov;
+    }
+    first[nhdr++] = i;
+  }
+  first[nhdr] = nmsgs;
+
+#if MSG_NOSIGNAL && !LWIP_SOCKET
+  sendflags |= MSG_NOSIGNAL;
+#endif
+  for (uint32_t k = 0; k < nhdr; )
+  {
+    dds_return_t rc;
+    int n;
+    if ((rc = ddsrt_sendmmsg (conn->m_sockext.sock, &mmsghdr[k], nhdr - k, sendflags, &n)) == DDS_RETCODE_OK)
+    {
+      nsent += first[k + (uint32_t) n] - first[k];
+      if (gv->pcap_fp)
+        ddsi_udp_conn_write_pcap_multi (conn, &msgs[first[k]], first[k + (uint32_t) n] - first[k]);
+      k += (uint32_t) n;
+    }
+    else if (rc == DDS_RETCODE_INTERRUPTED || rc == DDS_RETCODE_TRY_AGAIN || (rc == DDS_RETCODE_NOT_ALLOWED && retry-- > 0))
+    {
+      // see ddsi_udp_conn_write_iov
+    }
+#if UDP_GSO
+    else if (first[k + 1] - first[k] > 1)
+    {
+      // the GSO super-packet was rejected, fall back to sending the packets individually
+      gso_failed (conn, msgs[first[k]].len, rc);
+      nsent += ddsi_udp_conn_write_multi_1by1 (conn, &msgs[first[k]], first[k + 1] - first[k], 0);
+      k++;
+    }
+#endif
+    else
+    {
+      if (rc != DDS_RETCODE_NOT_ALLOWED && rc != DDS_RETCODE_NO_CONNECTION)
+      {
+        char locbuf[DDSI_LOCSTRLEN];
+        GVERROR ("ddsi_udp_conn_write_multi to %s failed with retcode %"PRId32"\n", ddsi_locator_to_string (locbuf, sizeof (locbuf), msgs[first[k]].dst), rc);
+      }
+      k++;
+    }
+  }
+  return nsent;
+}
+#endif /* DDSRT_HAVE_SENDMMSG */
+
 static void ddsi_udp_disable_multiplexing (struct ddsi_tran_conn * conn_cmn)
 {
 #if defined _WIN32 && !defined WINCE
@@ -602,6 +861,12 @@ static dds_return_t ddsi_udp_create_conn (struct ddsi_tran_conn **conn_out, stru
       set_mc_xmit_options = false;
       purpose_str = "unicast";
       break;
+    case DDSI_TRAN_QOS_RECV_UC_SHARED:
+      reuse_addr = true;
+      bind_to_any = true;
+      set_mc_xmit_options = false;
+      purpose_str = "unicast(shared)";
+      break;
     case DDSI_TRAN_QOS_RECV_MC:
       reuse_addr = true;
       bind_to_any = true;
@@ -720,6 +985,15 @@ static dds_return_t ddsi_udp_create_conn (struct ddsi_tran_conn **conn_out, stru
   conn->m_base.m_base.m_handle_fn = ddsi_udp_conn_handle;
 
   conn->m_base.m_read_fn = ddsi_udp_conn_read;
+#if DDSRT_HAVE_RECVMMSG
+  conn->m_base.m_read_multi_fn = ddsi_udp_conn_read_multi;
+#endif
+#if DDSRT_HAVE_SENDMMSG
+  conn->m_base.m_write_multi_fn = ddsi_udp_conn_write_multi;
+#endif
+#if UDP_GSO
+  ddsrt_atomic_st32 (&conn->m_gso_max, UDP_GSO_MAX_SIZE);
+#endif
   conn->m_base.m_write_fn = ddsi_udp_conn_write;
   conn->m_base.m_disable_multiplexing_fn = ddsi_udp_disable_multiplexing;
   conn->m_base.m_locator_fn = ddsi_udp_conn_locator;
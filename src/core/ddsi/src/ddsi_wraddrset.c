@@ -192,19 +192,46 @@ static void locset_free (struct locset *ls)
   ddsrt_free (ls);
 }
 
-static struct ddsi_addrset *wras_collect_all_locs (const struct ddsi_writer *wr)
+// Iterates over the matched proxy readers that are still known, or over just
+// the one given as "only_prd" when computing the addresses needed for adding
+// a single reader
+struct wras_reader_iter {
+  const struct ddsi_writer *wr;
+  const struct ddsi_proxy_reader *only_prd;
+  ddsrt_avl_iter_t it;
+};
+
+static const struct ddsi_proxy_reader *wras_reader_iter_skip (struct wras_reader_iter *it, const struct ddsi_wr_prd_match *m)
+{
+  struct ddsi_entity_index * const gh = it->wr->e.gv->entity_index;
+  const struct ddsi_proxy_reader *prd = NULL;
+  while (m && (prd = ddsi_entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
+    m = ddsrt_avl_iter_next (&it->it);
+  return m ? prd : NULL;
+}
+
+static const struct ddsi_proxy_reader *wras_reader_iter_first (struct wras_reader_iter *it, const struct ddsi_writer *wr, const struct ddsi_proxy_reader *only_prd)
+{
+  it->wr = wr;
+  it->only_prd = only_prd;
+  if (only_prd)
+    return only_prd;
+  return wras_reader_iter_skip (it, ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it->it));
+}
+
+static const struct ddsi_proxy_reader *wras_reader_iter_next (struct wras_reader_iter *it)
+{
+  if (it->only_prd)
+    return NULL;
+  return wras_reader_iter_skip (it, ddsrt_avl_iter_next (&it->it));
+}
+
+static struct ddsi_addrset *wras_collect_all_locs (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *only_prd)
 {
-  struct ddsi_entity_index * const gh = wr->e.gv->entity_index;
   struct ddsi_addrset *all_addrs = ddsi_new_addrset ();
-  struct ddsi_wr_prd_match *m;
-  ddsrt_avl_iter_t it;
-  for (m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
-  {
-    struct ddsi_proxy_reader *prd;
-    if ((prd = ddsi_entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
-      continue;
+  struct wras_reader_iter it;
+  for (const struct ddsi_proxy_reader *prd = wras_reader_iter_first (&it, wr, only_prd); prd; prd = wras_reader_iter_next (&it))
     ddsi_copy_addrset_into_addrset (wr->e.gv, all_addrs, prd->c.as);
-  }
   if (!ddsi_addrset_empty (all_addrs))
   {
 #ifdef DDSRT_HAVE_SSM
@@ -487,27 +514,23 @@ static bool wras_cover_locatorset (struct ddsi_domaingv const * const gv, struct
   return true;
 }
 
-static bool wras_calc_cover (const struct ddsi_writer *wr, const struct locset *locs, struct cover **pcov) ddsrt_attribute_warn_unused_result;
+static bool wras_calc_cover (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *only_prd, const struct locset *locs, struct cover **pcov) ddsrt_attribute_warn_unused_result;
 
-static bool wras_calc_cover (const struct ddsi_writer *wr, const struct locset *locs, struct cover **pcov)
+static bool wras_calc_cover (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *only_prd, const struct locset *locs, struct cover **pcov)
 {
   struct ddsi_domaingv * const gv = wr->e.gv;
-  struct ddsi_entity_index * const gh = gv->entity_index;
-  ddsrt_avl_iter_t it;
+  struct wras_reader_iter it;
   const bool want_rdnames = true;
   // allocate cover matrix, it needs to be grow if there are readers requesting redundant delivery
   // (but that's rare enough to be ok with reallocating it for now)
-  struct cover *cov = cover_new ((int) wr->num_readers, locs->nlocs, want_rdnames);
+  struct cover *cov = cover_new (only_prd ? 1 : (int) wr->num_readers, locs->nlocs, want_rdnames);
   struct locset *work_locs = locset_new (locs->nlocs);
   int rdidx = 0;
   char rdletter = 'a', rddigit = '0';
-  for (struct ddsi_wr_prd_match *m = ddsrt_avl_iter_first (&ddsi_wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  for (const struct ddsi_proxy_reader *prd = wras_reader_iter_first (&it, wr, only_prd); prd; prd = wras_reader_iter_next (&it))
   {
-    struct ddsi_proxy_reader *prd;
     struct ddsi_addrset *ass[] = { NULL, NULL, NULL };
     bool increment_rdidx = true;
-    if ((prd = ddsi_entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
-      continue;
     ass[0] = prd->c.as;
 #ifdef DDSRT_HAVE_SSM
     if (prd->favours_ssm && wr->supports_ssm)
@@ -747,7 +770,7 @@ static bool is_psmx_locator (const struct ddsi_endpoint_common *local_endpoint,
   return false;
 }
 
-struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr)
+static struct ddsi_addrset *compute_writer_addrset (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *only_prd)
 {
   struct ddsi_domaingv * const gv = wr->e.gv;
   struct locset *locs;
@@ -757,7 +780,7 @@ struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr)
   // Gather all addresses, using an addrset means no need to worry about
   // duplicates. If no addresses found it is trivial.
   {
-    struct ddsi_addrset *all_addrs = wras_collect_all_locs (wr);
+    struct ddsi_addrset *all_addrs = wras_collect_all_locs (wr, only_prd);
     if (ddsi_addrset_empty (all_addrs))
       return all_addrs;
     ddsi_log_addrset (gv, DDS_LC_DISCOVERY, "setcover: all_addrs", all_addrs);
@@ -766,11 +789,12 @@ struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr)
     ddsi_unref_addrset (all_addrs);
   }
 
-  if (!wras_calc_cover (wr, locs, &covered))
+  if (!wras_calc_cover (wr, only_prd, locs, &covered))
   {
     // Addrset computation fails when some proxy reader's address can't be found in all_addrs,
     // which means its address set changed while we were working.  In that case, the change
-    // will trigger a recalculation and we can just return the old one.
+    // will trigger a recalculation and we can just return the old one.  (When adding a
+    // single reader, merging the old one with the old one is harmless.)
     //
     // FIXME: copying it is a bit excessive (a little rework and refcount manipulation suffices)
     newas = ddsi_ref_addrset (wr->as);
@@ -805,3 +829,46 @@ struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr)
   locset_free (locs);
   return newas;
 }
+
+struct ddsi_addrset *ddsi_compute_writer_addrset (const struct ddsi_writer *wr)
+{
+  return compute_writer_addrset (wr, NULL);
+}
+
+static bool wras_reader_covered (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd)
+{
+  // Readers that are reachable via one of the addresses already in use need nothing
+  // more, which is by far the most common case when many readers share a multicast
+  // address or a machine.
+  struct locset *ls = wras_flatten_locs (prd->c.as);
+  bool covered = false;
+  for (int i = 0; i < ls->nlocs && !covered; i++)
+    covered = ddsi_addrset_contains_xlocator (wr->e.gv, wr->as, &ls->locs[i]);
+  locset_free (ls);
+  return covered;
+}
+
+struct ddsi_addrset *ddsi_compute_writer_addrset_add_reader (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd)
+{
+  struct ddsi_domaingv * const gv = wr->e.gv;
+  if (!prd->redundant_networking && wras_reader_covered (wr, prd))
+  {
+    ELOGDISC (wr, "setcover: reader "PGUIDFMT" already covered\n", PGUID (prd->e.guid));
+    return ddsi_ref_addrset (wr->as);
+  }
+
+  // Cover the new reader on its own and add the result to the existing set: that
+  // may send more packets than strictly necessary until the next full computation,
+  // but it never loses a reader
+  struct ddsi_addrset *rdas = compute_writer_addrset (wr, prd);
+  struct ddsi_addrset *newas = ddsi_new_addrset ();
+  ddsi_copy_addrset_into_addrset (gv, newas, wr->as);
+  ddsi_copy_addrset_into_addrset (gv, newas, rdas);
+  ddsi_unref_addrset (rdas);
+  return newas;
+}
+
+struct ddsi_addrset *ddsi_compute_writer_addrset_reader (const struct ddsi_writer *wr, const struct ddsi_proxy_reader *prd)
+{
+  return compute_writer_addrset (wr, prd);
+}
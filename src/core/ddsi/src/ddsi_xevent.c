@@ -16,8 +16,10 @@
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/mh3.h"
 #include "dds/ddsi/ddsi_unused.h"
 #include "dds/ddsi/ddsi_domaingv.h"
+#include "ddsi__entity.h"
 #include "ddsi__log.h"
 #include "ddsi__xevent.h"
 #include "ddsi__thread.h"
@@ -25,6 +27,7 @@
 #include "ddsi__xmsg.h"
 #include "ddsi__tran.h"
 #include "ddsi__sysdeps.h"
+#include "ddsi__vendor.h"
 
 #define EVQTRACE(...) DDS_CTRACE (&evq->gv->logconfig, __VA_ARGS__)
 
@@ -485,6 +488,14 @@ void ddsi_xeventq_stop (struct ddsi_xeventq *evq)
   evq->thrst = NULL;
 }
 
+struct ddsi_xeventq *ddsi_xeventq_for_endpoint (const struct ddsi_domaingv *gv, const struct ddsi_guid *guid)
+{
+  if (gv->n_endpoint_xevents == 1 || ddsi_is_builtin_entityid (guid->entityid, DDSI_VENDORID_ECLIPSE))
+    return gv->xevents;
+  const uint32_t h = ddsrt_mh3 (guid, sizeof (*guid), 0);
+  return gv->endpoint_xevents[h % gv->n_endpoint_xevents];
+}
+
 void ddsi_xeventq_free (struct ddsi_xeventq *evq)
 {
   struct ddsi_xevent *ev;
@@ -21,13 +21,13 @@
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/random.h"
+#include "dds/ddsrt/slab.h"
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsi/ddsi_xqos.h"
 #include "dds/ddsi/ddsi_log.h"
 #include "dds/ddsi/ddsi_unused.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/ddsi_serdata.h"
-#include "dds/ddsi/ddsi_freelist.h"
 #include "ddsi__protocol.h"
 #include "ddsi__addrset.h"
 #include "ddsi__misc.h"
@@ -43,10 +43,6 @@
 #define DDSI_XMSG_MAX_ALIGN 8
 #define DDSI_XMSG_CHUNK_SIZE 128
 
-struct ddsi_xmsgpool {
-  struct ddsi_freelist freelist;
-};
-
 struct ddsi_xmsg_data {
   ddsi_rtps_info_src_t src;
   ddsi_rtps_info_dst_t dst;
@@ -65,7 +61,6 @@ enum ddsi_xmsg_dstmode {
 };
 
 struct ddsi_xmsg {
-  struct ddsi_xmsgpool *pool;
   size_t maxsz;
   size_t sz;
   int have_params;
@@ -136,6 +131,35 @@ struct ddsi_xmsg_chain {
   struct ddsi_xmsg_chain_elem *latest;
 };
 
+/* Packets held back for transmitting in a single batch, all to the
+   same destinations.  Each has its own copy of the RTPS header, the
+   iovecs of all of them are stored consecutively in "iov". */
+#define DDSI_XPACK_TRAIN_MAX DDSI_TRAN_WRITE_MULTI_MAX
+
+struct ddsi_xpack_train_pkt {
+  ddsi_rtps_header_t hdr;
+  size_t iov_off;
+  size_t niov;
+  size_t len;
+  struct ddsi_xmsg_chain msgs;
+};
+
+struct ddsi_xpack_train {
+  uint32_t npkts;
+  uint32_t call_flags;
+  enum ddsi_xmsg_dstmode dstmode;
+  union {
+    ddsi_xlocator_t loc;
+    struct ddsi_addrset *as;
+  } dstaddr;
+  size_t niov, maxniov;
+  ddsrt_iovec_t *iov;
+  uint32_t nlocs, maxnlocs;
+  ddsi_xlocator_t *locs;
+  ddsi_tran_write_msgfrags_t *msgfrags; /* for transports that don't do batches */
+  struct ddsi_xpack_train_pkt pkts[DDSI_XPACK_TRAIN_MAX];
+};
+
 struct ddsi_xpack
 {
   struct ddsi_xpack *sendq_next;
@@ -177,6 +201,8 @@ struct ddsi_xpack
 #ifdef DDS_HAS_SECURITY
   ddsi_msg_sec_info_t sec_info;
 #endif
+
+  struct ddsi_xpack_train *train; /* lazily allocated */
 };
 
 static size_t align4u (size_t x)
@@ -191,29 +217,6 @@ static size_t align4u (size_t x)
 /* We need about as many as will fit in a message; an otherwise unadorned data message is ~ 40 bytes
    for a really small sample, no key hash, no status info, and message sizes are (typically) < 64kB
    so we can expect not to need more than ~ 1600 xmsg at a time.  Powers-of-two are nicer :) */
-#define MAX_FREELIST_SIZE 2048
-
-static void ddsi_xmsg_realfree (struct ddsi_xmsg *m);
-
-struct ddsi_xmsgpool *ddsi_xmsgpool_new (void)
-{
-  struct ddsi_xmsgpool *pool;
-  pool = ddsrt_malloc (sizeof (*pool));
-  ddsi_freelist_init (&pool->freelist, MAX_FREELIST_SIZE, offsetof (struct ddsi_xmsg, link.older));
-  return pool;
-}
-
-static void ddsi_xmsg_realfree_wrap (void *elem)
-{
-  ddsi_xmsg_realfree (elem);
-}
-
-void ddsi_xmsgpool_free (struct ddsi_xmsgpool *pool)
-{
-  ddsi_freelist_fini (&pool->freelist, ddsi_xmsg_realfree_wrap);
-  ddsrt_free (pool);
-}
-
 /* XMSG ----------------------------------------------------------------
 
    All messages that are sent start out as xmsgs, which is a sequence
@@ -245,7 +248,9 @@ static void ddsi_xmsg_reinit (struct ddsi_xmsg *m, enum ddsi_xmsg_kind kind)
   memset (&m->kindspecific, 0, sizeof (m->kindspecific));
 }
 
-static struct ddsi_xmsg *ddsi_xmsg_allocnew (struct ddsi_xmsgpool *pool, size_t expected_size, enum ddsi_xmsg_kind kind)
+/* The xmsg and its data are allocated from the slab allocator: they are created and freed at
+   a high rate, usually by different threads, and the data grows by reallocating. */
+static struct ddsi_xmsg *ddsi_xmsg_allocnew (size_t expected_size, enum ddsi_xmsg_kind kind)
 {
   struct ddsi_xmsg *m;
   struct ddsi_xmsg_data *d;
@@ -253,15 +258,14 @@ static struct ddsi_xmsg *ddsi_xmsg_allocnew (struct ddsi_xmsgpool *pool, size_t
   if (expected_size == 0)
     expected_size = DDSI_XMSG_CHUNK_SIZE;
 
-  if ((m = ddsrt_malloc (sizeof (*m))) == NULL)
+  if ((m = ddsrt_slab_malloc (sizeof (*m))) == NULL)
     return NULL;
 
-  m->pool = pool;
   m->maxsz = (expected_size + DDSI_XMSG_CHUNK_SIZE - 1) & (unsigned)-DDSI_XMSG_CHUNK_SIZE;
 
-  if ((d = m->data = ddsrt_malloc (offsetof (struct ddsi_xmsg_data, payload) + m->maxsz)) == NULL)
+  if ((d = m->data = ddsrt_slab_malloc (offsetof (struct ddsi_xmsg_data, payload) + m->maxsz)) == NULL)
   {
-    ddsrt_free (m);
+    ddsrt_slab_free (m);
     return NULL;
   }
   d->src.smhdr.submessageId = DDSI_RTPS_SMID_INFO_SRC;
@@ -278,12 +282,10 @@ static struct ddsi_xmsg *ddsi_xmsg_allocnew (struct ddsi_xmsgpool *pool, size_t
   return m;
 }
 
-struct ddsi_xmsg *ddsi_xmsg_new (struct ddsi_xmsgpool *pool, const ddsi_guid_t *src_guid, struct ddsi_participant *pp, size_t expected_size, enum ddsi_xmsg_kind kind)
+struct ddsi_xmsg *ddsi_xmsg_new (const ddsi_guid_t *src_guid, struct ddsi_participant *pp, size_t expected_size, enum ddsi_xmsg_kind kind)
 {
   struct ddsi_xmsg *m;
-  if ((m = ddsi_freelist_pop (&pool->freelist)) != NULL)
-    ddsi_xmsg_reinit (m, kind);
-  else if ((m = ddsi_xmsg_allocnew (pool, expected_size, kind)) == NULL)
+  if ((m = ddsi_xmsg_allocnew (expected_size, kind)) == NULL)
     return NULL;
   m->data->src.guid_prefix = ddsi_hton_guid_prefix (src_guid->prefix);
 
@@ -304,15 +306,8 @@ struct ddsi_xmsg *ddsi_xmsg_new (struct ddsi_xmsgpool *pool, const ddsi_guid_t *
   return m;
 }
 
-static void ddsi_xmsg_realfree (struct ddsi_xmsg *m)
-{
-  ddsrt_free (m->data);
-  ddsrt_free (m);
-}
-
 void ddsi_xmsg_free (struct ddsi_xmsg *m)
 {
-  struct ddsi_xmsgpool *pool = m->pool;
   if (m->refd_payload)
     ddsi_serdata_to_ser_unref (m->refd_payload, &m->refd_payload_iov);
 #ifdef DDS_HAS_SECURITY
@@ -330,11 +325,8 @@ void ddsi_xmsg_free (struct ddsi_xmsg *m)
       ddsi_unref_addrset (m->dstaddr.all_uc.as);
       break;
   }
-  /* Only cache the smallest xmsgs; data messages store the payload by reference and are small */
-  if (m->maxsz > DDSI_XMSG_CHUNK_SIZE || !ddsi_freelist_push (&pool->freelist, m))
-  {
-    ddsi_xmsg_realfree (m);
-  }
+  ddsrt_slab_free (m->data);
+  ddsrt_slab_free (m);
 }
 
 /************************************************/
@@ -363,6 +355,7 @@ static int submsg_is_compatible (const struct ddsi_xmsg *msg, ddsi_rtps_submessa
           /* normal control stuff is ok */
           return 1;
         case DDSI_RTPS_SMID_DATA: case DDSI_RTPS_SMID_DATA_FRAG:
+        case DDSI_RTPS_SMID_ADLINK_DATA_FRAG_PARITY:
           /* but data is strictly verboten */
           return 0;
         case DDSI_RTPS_SMID_SEC_BODY:
@@ -388,6 +381,7 @@ static int submsg_is_compatible (const struct ddsi_xmsg *msg, ddsi_rtps_submessa
           /* we never generate these directly */
           return 0;
         case DDSI_RTPS_SMID_INFO_TS: case DDSI_RTPS_SMID_DATA: case DDSI_RTPS_SMID_DATA_FRAG:
+        case DDSI_RTPS_SMID_ADLINK_DATA_FRAG_PARITY:
           /* Timestamp only preceding data; data may be present just
              once for rexmits.  The readerId offset can be used to
              ensure rexmits have only one data submessages -- the test
@@ -604,7 +598,7 @@ static void *ddsi_xmsg_append_impl (struct ddsi_xmsg *m, struct ddsi_xmsg_marker
   if (m->sz + sz > m->maxsz)
   {
     size_t nmax = (m->maxsz + sz + DDSI_XMSG_CHUNK_SIZE - 1) & (size_t)-DDSI_XMSG_CHUNK_SIZE;
-    struct ddsi_xmsg_data *ndata = ddsrt_realloc (m->data, offsetof (struct ddsi_xmsg_data, payload) + nmax);
+    struct ddsi_xmsg_data *ndata = ddsrt_slab_realloc (m->data, offsetof (struct ddsi_xmsg_data, payload) + nmax);
     m->maxsz = nmax;
     m->data = ndata;
   }
@@ -1111,6 +1105,14 @@ void ddsi_xpack_free (struct ddsi_xpack *xp)
   assert (xp->included_msgs.latest == NULL);
   if (xp->msgfrags != NULL)
     ddsrt_free (xp->msgfrags);
+  if (xp->train != NULL)
+  {
+    assert (xp->train->npkts == 0);
+    ddsrt_free (xp->train->iov);
+    ddsrt_free (xp->train->locs);
+    ddsrt_free (xp->train->msgfrags);
+    ddsrt_free (xp->train);
+  }
   ddsrt_free (xp);
 }
 
@@ -1200,6 +1202,235 @@ static void ddsi_xpack_send1v (const ddsi_xlocator_t *loc, void * varg)
   (void) ddsi_xpack_send1 (loc, varg);
 }
 
+static uint32_t ddsi_xpack_train_maxpkts (const struct ddsi_domaingv *gv)
+{
+  return (gv->config.xmit_batch_size < DDSI_XPACK_TRAIN_MAX) ? gv->config.xmit_batch_size : DDSI_XPACK_TRAIN_MAX;
+}
+
+static bool ddsi_xpack_may_batch (const struct ddsi_xpack *xp)
+{
+  /* Batching is only done for datagrams in synchronous mode, and when
+     the packet doesn't get encoded (the security plugin produces a new
+     buffer for each call) */
+  struct ddsi_domaingv const * const gv = xp->gv;
+  if (gv->config.xmit_batch_size <= 1 || xp->async_mode || !gv->m_factory->m_connless)
+    return false;
+#ifdef DDS_HAS_SECURITY
+  if (xp->sec_info.use_rtps_encoding)
+    return false;
+#endif
+  return true;
+}
+
+static bool ddsi_xpack_train_accepts (const struct ddsi_xpack *xp)
+{
+  const struct ddsi_xpack_train *tr = xp->train;
+  if (tr == NULL || tr->npkts == 0)
+    return true;
+  if (tr->npkts >= ddsi_xpack_train_maxpkts (xp->gv) || tr->dstmode != xp->dstmode || tr->call_flags != xp->call_flags)
+    return false;
+  switch (xp->dstmode)
+  {
+    case NN_XMSG_DST_UNSET:
+      break;
+    case NN_XMSG_DST_ONE:
+      return memcmp (&tr->dstaddr.loc, &xp->dstaddr.loc, sizeof (tr->dstaddr.loc)) == 0;
+    case NN_XMSG_DST_ALL:
+      return tr->dstaddr.as == xp->dstaddr.all.as || ddsi_addrset_eq_onesidederr (tr->dstaddr.as, xp->dstaddr.all.as);
+    case NN_XMSG_DST_ALL_UC:
+      return tr->dstaddr.as == xp->dstaddr.all_uc.as || ddsi_addrset_eq_onesidederr (tr->dstaddr.as, xp->dstaddr.all_uc.as);
+  }
+  assert (0);
+  return false;
+}
+
+static void ddsi_xpack_train_add (struct ddsi_xpack *xp)
+{
+  /* Moves the packet in xp to the train, transferring ownership of the
+     messages and the reference to the address set, then reinitializes
+     xp for the next packet */
+  struct ddsi_xpack_train *tr;
+  struct ddsi_xpack_train_pkt *pkt;
+  assert (ddsi_xpack_train_accepts (xp));
+  assert (xp->msgfrags->niov > 0 && xp->msgfrags->iov[0].iov_base == (void *) &xp->hdr);
+  if ((tr = xp->train) == NULL)
+  {
+    tr = xp->train = ddsrt_malloc (sizeof (*tr));
+    tr->npkts = 0;
+    tr->niov = tr->maxniov = 0;
+    tr->iov = NULL;
+    tr->nlocs = tr->maxnlocs = 0;
+    tr->locs = NULL;
+    tr->msgfrags = NULL;
+  }
+  if (tr->npkts == 0)
+  {
+    tr->niov = 0;
+    tr->call_flags = xp->call_flags;
+    tr->dstmode = xp->dstmode;
+    switch (xp->dstmode)
+    {
+      case NN_XMSG_DST_UNSET: assert (0); break;
+      case NN_XMSG_DST_ONE: tr->dstaddr.loc = xp->dstaddr.loc; break;
+      case NN_XMSG_DST_ALL: tr->dstaddr.as = xp->dstaddr.all.as; break;
+      case NN_XMSG_DST_ALL_UC: tr->dstaddr.as = xp->dstaddr.all_uc.as; break;
+    }
+  }
+  else if (xp->dstmode == NN_XMSG_DST_ALL)
+    ddsi_unref_addrset (xp->dstaddr.all.as);
+  else if (xp->dstmode == NN_XMSG_DST_ALL_UC)
+    ddsi_unref_addrset (xp->dstaddr.all_uc.as);
+
+  if (tr->niov + xp->msgfrags->niov > tr->maxniov)
+  {
+    tr->maxniov = tr->niov + xp->msgfrags->niov + DDSI_XMSG_MAX_MESSAGE_IOVECS;
+    tr->iov = ddsrt_realloc (tr->iov, tr->maxniov * sizeof (*tr->iov));
+  }
+  pkt = &tr->pkts[tr->npkts++];
+  pkt->hdr = xp->hdr;
+  pkt->iov_off = tr->niov;
+  pkt->niov = xp->msgfrags->niov;
+  pkt->len = xp->msg_len.length;
+  pkt->msgs = xp->included_msgs;
+  memcpy (&tr->iov[tr->niov], xp->msgfrags->iov, pkt->niov * sizeof (*tr->iov));
+  tr->iov[tr->niov].iov_base = (void *) &pkt->hdr;
+  tr->niov += pkt->niov;
+  ddsi_xpack_reinit (xp);
+}
+
+static void ddsi_xpack_train_addloc (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct ddsi_xpack_train * const tr = varg;
+  if (tr->nlocs == tr->maxnlocs)
+  {
+    tr->maxnlocs = (tr->maxnlocs == 0) ? 8 : 2 * tr->maxnlocs;
+    tr->locs = ddsrt_realloc (tr->locs, tr->maxnlocs * sizeof (*tr->locs));
+  }
+  tr->locs[tr->nlocs++] = *loc;
+}
+
+static uint32_t ddsi_xpack_train_write (struct ddsi_xpack_train *tr, struct ddsi_tran_conn *conn, const struct ddsi_tran_write_msg *msgs, uint32_t nmsgs)
+{
+  const uint32_t flags = tr->call_flags;
+  /* as in ddsi_xpack_send1, the flags only apply to the first call */
+  tr->call_flags = 0;
+  if (conn->m_write_multi_fn)
+    return ddsi_conn_write_multi (conn, msgs, nmsgs, flags);
+  else
+  {
+    uint32_t nsent = 0;
+    if (tr->msgfrags == NULL)
+      tr->msgfrags = ddsrt_malloc (sizeof (*tr->msgfrags) + DDSI_XMSG_MAX_MESSAGE_IOVECS * sizeof (ddsrt_iovec_t));
+    for (uint32_t i = 0; i < nmsgs; i++)
+    {
+      assert (msgs[i].niov <= DDSI_XMSG_MAX_MESSAGE_IOVECS);
+      tr->msgfrags->niov = msgs[i].niov;
+      memcpy (tr->msgfrags->iov, msgs[i].iov, msgs[i].niov * sizeof (*msgs[i].iov));
+      if (ddsi_conn_write (conn, msgs[i].dst, tr->msgfrags, i == 0 ? flags : 0) > 0)
+        nsent++;
+    }
+    return nsent;
+  }
+}
+
+static void ddsi_xpack_train_send (struct ddsi_xpack *xp)
+{
+  struct ddsi_domaingv const * const gv = xp->gv;
+  struct ddsi_xpack_train * const tr = xp->train;
+  struct ddsi_tran_write_msg msgs[DDSI_TRAN_WRITE_MULTI_MAX];
+  struct ddsi_tran_conn *conn = NULL;
+  uint32_t nmsgs = 0;
+
+  if (tr == NULL || tr->npkts == 0)
+    return;
+
+  tr->nlocs = 0;
+  switch (tr->dstmode)
+  {
+    case NN_XMSG_DST_UNSET:
+      assert (0);
+      break;
+    case NN_XMSG_DST_ONE:
+      ddsi_xpack_train_addloc (&tr->dstaddr.loc, tr);
+      break;
+    case NN_XMSG_DST_ALL:
+      /* see ddsi_xpack_send_real */
+      if (tr->dstaddr.as)
+      {
+        (void) ddsi_addrset_forall_count (tr->dstaddr.as, ddsi_xpack_train_addloc, tr);
+        ddsi_unref_addrset (tr->dstaddr.as);
+      }
+      break;
+    case NN_XMSG_DST_ALL_UC:
+      if (tr->dstaddr.as)
+      {
+        (void) ddsi_addrset_forall_uc_count (tr->dstaddr.as, ddsi_xpack_train_addloc, tr);
+        ddsi_unref_addrset (tr->dstaddr.as);
+      }
+      break;
+  }
+
+  if (gv->logconfig.c.mask & DDS_LC_TRACE)
+  {
+    GVTRACE ("ddsi_xpack_send %"PRIu32" packets:", tr->npkts);
+    for (uint32_t i = 0; i < tr->npkts; i++)
+      GVTRACE (" %"PRIuSIZE, tr->pkts[i].len);
+  }
+  GVTRACE (" [");
+  for (uint32_t l = 0; l < tr->nlocs; l++)
+  {
+    const ddsi_xlocator_t * const loc = &tr->locs[l];
+    assert (loc->c.kind != DDSI_LOCATOR_KIND_PSMX);
+    if (gv->logconfig.c.mask & DDS_LC_TRACE)
+    {
+      char buf[DDSI_LOCSTRLEN];
+      GVTRACE (" %s", ddsi_xlocator_to_string (buf, sizeof(buf), loc));
+    }
+    if (gv->mute)
+    {
+      GVTRACE ("(dropped)");
+      continue;
+    }
+    if (conn != loc->conn && nmsgs > 0)
+    {
+      (void) ddsi_xpack_train_write (tr, conn, msgs, nmsgs);
+      nmsgs = 0;
+    }
+    conn = loc->conn;
+    for (uint32_t i = 0; i < tr->npkts; i++)
+    {
+      /* We drop APPROXIMATELY a fraction of xmit_lossiness * 10**(-3)
+         of all packets to be sent */
+      if (gv->config.xmit_lossiness > 0 && (ddsrt_random () % 1000) < (uint32_t) gv->config.xmit_lossiness)
+      {
+        GVTRACE ("(dropped #%"PRIu32")", i);
+        continue;
+      }
+      if (nmsgs == DDSI_TRAN_WRITE_MULTI_MAX)
+      {
+        (void) ddsi_xpack_train_write (tr, conn, msgs, nmsgs);
+        nmsgs = 0;
+      }
+      msgs[nmsgs].dst = &loc->c;
+      msgs[nmsgs].iov = &tr->iov[tr->pkts[i].iov_off];
+      msgs[nmsgs].niov = tr->pkts[i].niov;
+      msgs[nmsgs].len = tr->pkts[i].len;
+      nmsgs++;
+    }
+  }
+  if (nmsgs > 0)
+    (void) ddsi_xpack_train_write (tr, conn, msgs, nmsgs);
+  GVTRACE (" ]\n");
+
+  for (uint32_t i = 0; i < tr->npkts; i++)
+  {
+    if (tr->nlocs > 0)
+      GVLOG (DDS_LC_TRAFFIC, "traffic-xmit (%lu) %"PRIuSIZE"\n", (unsigned long) tr->nlocs, tr->pkts[i].len);
+    ddsi_xmsg_chain_release (xp->gv, &tr->pkts[i].msgs);
+  }
+  tr->npkts = 0;
+}
+
 static void ddsi_xpack_send_real (struct ddsi_xpack *xp)
 {
   struct ddsi_domaingv const * const gv = xp->gv;
@@ -1208,11 +1439,25 @@ static void ddsi_xpack_send_real (struct ddsi_xpack *xp)
 
   if (xp->msgfrags == NULL || xp->msgfrags->niov == 0)
   {
+    ddsi_xpack_train_send (xp);
     return;
   }
 
   assert (xp->dstmode != NN_XMSG_DST_UNSET);
 
+  if (ddsi_xpack_may_batch (xp))
+  {
+    /* Sending it as a train of one still gives batching of the fan-out */
+    if (!ddsi_xpack_train_accepts (xp))
+      ddsi_xpack_train_send (xp);
+    ddsi_xpack_train_add (xp);
+    ddsi_xpack_train_send (xp);
+    return;
+  }
+
+  /* Packets held back must go out first */
+  ddsi_xpack_train_send (xp);
+
   if (gv->logconfig.c.mask & DDS_LC_TRACE)
   {
     int i;
@@ -1343,6 +1588,7 @@ void ddsi_xpack_send (struct ddsi_xpack *xp, bool immediately)
       memcpy (xp1->msgfrags->iov, xp->msgfrags->iov, xp->msgfrags->niov * sizeof (*xp->msgfrags->iov));
     }
     ddsi_xpack_reinit (xp);
+    xp1->train = NULL;
     xp1->sendq_next = NULL;
     ddsrt_mutex_lock (&gv->sendq_lock);
     while (gv->sendq_length >= SENDQ_MAX)
@@ -1359,6 +1605,12 @@ void ddsi_xpack_send (struct ddsi_xpack *xp, bool immediately)
   }
 }
 
+bool ddsi_xpack_is_empty (const struct ddsi_xpack *xp)
+{
+  /* nothing in the current packet and no packets held back for batching */
+  return (xp->msgfrags == NULL || xp->msgfrags->niov == 0) && (xp->train == NULL || xp->train->npkts == 0);
+}
+
 static void copy_addressing_info (struct ddsi_xpack *xp, const struct ddsi_xmsg *m)
 {
   xp->dstmode = m->dstmode;
@@ -1449,6 +1701,23 @@ static int ddsi_xpack_mayaddmsg (const struct ddsi_xpack *xp, const struct ddsi_
   return addressing_info_eq_onesidederr (xp, m);
 }
 
+static void ddsi_xpack_send_full (struct ddsi_xpack *xp)
+{
+  /* Called when the packet can't accommodate the next message: when
+     batching, hold it back so it can be sent together with the next
+     ones, but only up to the configured number of packets */
+  if (!ddsi_xpack_may_batch (xp))
+    ddsi_xpack_send (xp, false);
+  else
+  {
+    if (!ddsi_xpack_train_accepts (xp))
+      ddsi_xpack_train_send (xp);
+    ddsi_xpack_train_add (xp);
+    if (xp->train->npkts >= ddsi_xpack_train_maxpkts (xp->gv))
+      ddsi_xpack_train_send (xp);
+  }
+}
+
 int ddsi_xpack_addmsg (struct ddsi_xpack *xp, struct ddsi_xmsg *m, const uint32_t flags)
 {
   /* Returns > 0 if pack got sent out before adding m */
@@ -1485,7 +1754,7 @@ int ddsi_xpack_addmsg (struct ddsi_xpack *xp, struct ddsi_xmsg *m, const uint32_
   if (!ddsi_xpack_mayaddmsg (xp, m, flags))
   {
     assert (xp->msgfrags->niov > 0);
-    ddsi_xpack_send (xp, false);
+    ddsi_xpack_send_full (xp);
     assert (ddsi_xpack_mayaddmsg (xp, m, flags));
     result = 1;
   }
@@ -1638,7 +1907,7 @@ int ddsi_xpack_addmsg (struct ddsi_xpack *xp, struct ddsi_xmsg *m, const uint32_
              (int) niov, sz, max_msg_size, (int) xpo_niov, xpo_sz);
     xp->msg_len.length = xpo_sz;
     xp->msgfrags->niov = xpo_niov;
-    ddsi_xpack_send (xp, false);
+    ddsi_xpack_send_full (xp);
     result = ddsi_xpack_addmsg (xp, m, flags); /* Retry on emptied xp */
   }
   else
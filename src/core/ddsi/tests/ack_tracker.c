@@ -0,0 +1,131 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/ddsrt/random.h"
+#include "dds/ddsi/ddsi_endpoint.h"
+#include "ddsi__ack_tracker.h"
+#include "ddsi__endpoint_match.h"
+#include "CUnit/Test.h"
+
+#define N_READERS 300
+
+static void check (const struct ddsi_ack_tracker *tr, const struct ddsi_wr_prd_match *ms, const bool *present, uint32_t n)
+{
+  ddsi_seqno_t min_seq = DDSI_MAX_SEQ_NUMBER, max_seq = 0;
+  bool all_replied = true;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (!present[i])
+      continue;
+    if (ms[i].seq < min_seq)
+      min_seq = ms[i].seq;
+    if (ms[i].seq < DDSI_MAX_SEQ_NUMBER && ms[i].seq > max_seq)
+      max_seq = ms[i].seq;
+    if (!ms[i].has_replied_to_hb)
+      all_replied = false;
+  }
+  uint32_t num_at_max = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (present[i] && max_seq > 0 && ms[i].seq == max_seq && ms[i].has_replied_to_hb)
+      num_at_max++;
+  }
+  CU_ASSERT_FATAL (ddsi_ack_tracker_min_seq (tr) == min_seq);
+  CU_ASSERT_FATAL (ddsi_ack_tracker_max_seq (tr) == max_seq);
+  CU_ASSERT_FATAL (ddsi_ack_tracker_num_at_max_seq (tr) == num_at_max);
+  CU_ASSERT_FATAL (ddsi_ack_tracker_all_replied (tr) == all_replied);
+}
+
+CU_Test (ddsi_ack_tracker, empty)
+{
+  struct ddsi_ack_tracker tr;
+  ddsi_ack_tracker_init (&tr);
+  CU_ASSERT (ddsi_ack_tracker_min_seq (&tr) == DDSI_MAX_SEQ_NUMBER);
+  CU_ASSERT (ddsi_ack_tracker_max_seq (&tr) == 0);
+  CU_ASSERT (ddsi_ack_tracker_num_at_max_seq (&tr) == 0);
+  CU_ASSERT (ddsi_ack_tracker_all_replied (&tr));
+
+  // best-effort readers don't count
+  struct ddsi_wr_prd_match m;
+  memset (&m, 0, sizeof (m));
+  m.seq = DDSI_MAX_SEQ_NUMBER;
+  m.has_replied_to_hb = 1;
+  ddsi_ack_tracker_insert (&tr, &m);
+  CU_ASSERT (ddsi_ack_tracker_min_seq (&tr) == DDSI_MAX_SEQ_NUMBER);
+  CU_ASSERT (ddsi_ack_tracker_max_seq (&tr) == 0);
+  CU_ASSERT (ddsi_ack_tracker_all_replied (&tr));
+  ddsi_ack_tracker_remove (&tr, &m);
+  ddsi_ack_tracker_fini (&tr);
+}
+
+CU_Test (ddsi_ack_tracker, random)
+{
+  static struct ddsi_wr_prd_match ms[N_READERS];
+  bool present[N_READERS];
+  struct ddsi_ack_tracker tr;
+  ddsrt_prng_t prng;
+  ddsrt_prng_init_simple (&prng, 12345);
+  ddsi_ack_tracker_init (&tr);
+  memset (ms, 0, sizeof (ms));
+  memset (present, 0, sizeof (present));
+
+  ddsi_seqno_t wrseq = 0;
+  for (int iter = 0; iter < 100000; iter++)
+  {
+    const uint32_t i = ddsrt_prng_random (&prng) % N_READERS;
+    const uint32_t op = ddsrt_prng_random (&prng) % 100;
+    if (op < 2)
+      wrseq += 1 + ddsrt_prng_random (&prng) % 3;
+    if (!present[i])
+    {
+      ms[i].seq = (op % 10 == 0) ? DDSI_MAX_SEQ_NUMBER : wrseq;
+      ms[i].has_replied_to_hb = (op % 3 == 0);
+      ddsi_ack_tracker_insert (&tr, &ms[i]);
+      present[i] = true;
+    }
+    else if (op < 5)
+    {
+      ddsi_ack_tracker_remove (&tr, &ms[i]);
+      present[i] = false;
+    }
+    else if (op < 8)
+    {
+      ddsi_ack_tracker_update (&tr, &ms[i], DDSI_MAX_SEQ_NUMBER, ms[i].has_replied_to_hb);
+    }
+    else if (op < 20)
+    {
+      ddsi_ack_tracker_update (&tr, &ms[i], ms[i].seq, !ms[i].has_replied_to_hb);
+    }
+    else
+    {
+      // mostly move forward, but occasionally far back as when a reader becomes responsive again
+      ddsi_seqno_t seq;
+      if (ms[i].seq == DDSI_MAX_SEQ_NUMBER || op > 95)
+        seq = ddsrt_prng_random (&prng) % (wrseq + 1);
+      else
+        seq = ms[i].seq + (wrseq - ms[i].seq) / 2;
+      ddsi_ack_tracker_update (&tr, &ms[i], seq, ms[i].has_replied_to_hb || op % 2);
+    }
+    check (&tr, ms, present, N_READERS);
+  }
+
+  for (uint32_t i = 0; i < N_READERS; i++)
+  {
+    if (present[i])
+    {
+      ddsi_ack_tracker_remove (&tr, &ms[i]);
+      present[i] = false;
+      check (&tr, ms, present, N_READERS);
+    }
+  }
+  ddsi_ack_tracker_fini (&tr);
+}
@@ -0,0 +1,110 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "ddsi__compression.h"
+#include "CUnit/Test.h"
+
+static void fill (unsigned char *buf, size_t size, uint32_t nsymbols, ddsrt_prng_t *prng)
+{
+  // a small alphabet and repeated runs give something that compresses reasonably well
+  size_t i = 0;
+  while (i < size)
+  {
+    const unsigned char c = (unsigned char) (ddsrt_prng_random (prng) % nsymbols);
+    size_t run = 1 + ddsrt_prng_random (prng) % 20;
+    while (run-- && i < size)
+      buf[i++] = c;
+  }
+}
+
+static size_t roundtrip (const unsigned char *src, size_t size)
+{
+  unsigned char *cbuf = ddsrt_malloc (ddsi_compression_lz_bound (size));
+  unsigned char *ubuf = ddsrt_malloc (size + 1);
+  const size_t csize = ddsi_compression_lz_compress (cbuf, src, size);
+  CU_ASSERT_FATAL (csize > 0 && csize <= ddsi_compression_lz_bound (size));
+  CU_ASSERT_FATAL (ddsi_compression_lz_decompress (ubuf, size, cbuf, csize));
+  CU_ASSERT_FATAL (memcmp (ubuf, src, size) == 0);
+  // the size of the output is part of the contract
+  if (size > 0)
+    CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (ubuf, size - 1, cbuf, csize));
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (ubuf, size + 1, cbuf, csize));
+  ddsrt_free (ubuf);
+  ddsrt_free (cbuf);
+  return csize;
+}
+
+CU_Test (ddsi_compression, roundtrip)
+{
+  static const size_t sizes[] = { 0, 1, 3, 4, 5, 15, 16, 17, 255, 256, 270, 4096, 65535, 65536, 65537, 300000 };
+  ddsrt_prng_t prng;
+  ddsrt_prng_init_simple (&prng, 1234);
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+  {
+    unsigned char *buf = ddsrt_malloc (sizes[i] + 1);
+    // all the same, compressible, and incompressible
+    memset (buf, 0xa5, sizes[i]);
+    const size_t csame = roundtrip (buf, sizes[i]);
+    if (sizes[i] >= 1000)
+      CU_ASSERT (csame < sizes[i] / 100);
+    fill (buf, sizes[i], 4, &prng);
+    const size_t cfill = roundtrip (buf, sizes[i]);
+    if (sizes[i] >= 1000)
+      CU_ASSERT (cfill < sizes[i] / 2);
+    for (size_t j = 0; j < sizes[i]; j++)
+      buf[j] = (unsigned char) ddsrt_prng_random (&prng);
+    (void) roundtrip (buf, sizes[i]);
+    ddsrt_free (buf);
+  }
+}
+
+CU_Test (ddsi_compression, malformed)
+{
+  unsigned char out[64];
+  // literal length beyond the end of the input
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 4, (const unsigned char[]) { 0x50, 1, 2, 3, 4 }, 5));
+  // extended literal length missing
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 15, (const unsigned char[]) { 0xf0 }, 1));
+  // truncated offset
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 8, (const unsigned char[]) { 0x10, 'a', 1 }, 3));
+  // offset 0 and offset before the start of the output
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 5, (const unsigned char[]) { 0x10, 'a', 0, 0 }, 4));
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 5, (const unsigned char[]) { 0x10, 'a', 2, 0 }, 4));
+  // match longer than the output
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, 5, (const unsigned char[]) { 0x11, 'a', 1, 0 }, 4));
+  // valid: 'a' followed by a run of 4 copies of it
+  CU_ASSERT_FATAL (ddsi_compression_lz_decompress (out, 5, (const unsigned char[]) { 0x10, 'a', 1, 0 }, 4));
+  CU_ASSERT_FATAL (memcmp (out, "aaaaa", 5) == 0);
+  // huge extended length mustn't wrap around
+  unsigned char huge[40];
+  huge[0] = 0xf0;
+  memset (huge + 1, 255, sizeof (huge) - 1);
+  CU_ASSERT_FATAL (!ddsi_compression_lz_decompress (out, sizeof (out), huge, sizeof (huge)));
+
+  // any corruption of valid data must be detected or at least not result in an out-of-bounds access
+  ddsrt_prng_t prng;
+  ddsrt_prng_init_simple (&prng, 4321);
+  unsigned char src[1000], cbuf[1100], ubuf[1000];
+  fill (src, sizeof (src), 8, &prng);
+  const size_t csize = ddsi_compression_lz_compress (cbuf, src, sizeof (src));
+  CU_ASSERT_FATAL (csize > 0);
+  for (int i = 0; i < 10000; i++)
+  {
+    unsigned char corrupt[1100];
+    memcpy (corrupt, cbuf, csize);
+    corrupt[ddsrt_prng_random (&prng) % csize] = (unsigned char) ddsrt_prng_random (&prng);
+    (void) ddsi_compression_lz_decompress (ubuf, sizeof (ubuf), corrupt, csize);
+    (void) ddsi_compression_lz_decompress (ubuf, sizeof (ubuf), corrupt, ddsrt_prng_random (&prng) % csize);
+  }
+}
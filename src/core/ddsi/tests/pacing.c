@@ -0,0 +1,126 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "dds/ddsi/ddsi_config.h"
+#include "ddsi__pacing.h"
+#include "CUnit/Test.h"
+
+static void init_config (struct ddsi_config *config)
+{
+  memset (config, 0, sizeof (*config));
+  config->pacing_max_rate = 1000000;
+  config->pacing_min_rate = 100000;
+  config->pacing_increase = 50000;
+  config->pacing_burst_size = 10000;
+  config->pacing_rtt = DDS_MSECS (10);
+}
+
+CU_Test (ddsi_pacing, disabled)
+{
+  struct ddsi_config config;
+  struct ddsi_pacing p;
+  init_config (&config);
+  ddsi_pacing_init (&p, &config, false, (ddsrt_mtime_t) { 0 });
+  CU_ASSERT_FATAL (p.rate == 0);
+  config.pacing_max_rate = 0;
+  ddsi_pacing_init (&p, &config, true, (ddsrt_mtime_t) { 0 });
+  CU_ASSERT_FATAL (p.rate == 0);
+}
+
+CU_Test (ddsi_pacing, token_bucket)
+{
+  struct ddsi_config config;
+  struct ddsi_pacing p;
+  init_config (&config);
+  ddsrt_mtime_t t = { DDS_SECS (1) };
+  ddsi_pacing_init (&p, &config, true, t);
+  CU_ASSERT_FATAL (p.rate == 1000000);
+
+  // the initial burst is free, then 1000 bytes costs 1ms at 1MB/s
+  CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 10000, t) == 0);
+  CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 1000, t) == DDS_MSECS (1));
+  // a second writer has to wait for the first one as well
+  CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 1000, t) == DDS_MSECS (2));
+  // once the debt has been paid off, sending at the rate requires no waiting
+  t.v += DDS_MSECS (2);
+  for (int i = 0; i < 100; i++)
+  {
+    t.v += DDS_MSECS (1);
+    CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 1000, t) == 0);
+  }
+  // after a long idle period, the burst size limits what may be sent immediately
+  t.v += DDS_SECS (10);
+  CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 10000, t) == 0);
+  CU_ASSERT_FATAL (ddsi_pacing_take (&p, &config, 5000, t) == DDS_MSECS (5));
+}
+
+CU_Test (ddsi_pacing, aimd)
+{
+  struct ddsi_config config;
+  struct ddsi_pacing p;
+  init_config (&config);
+  ddsrt_mtime_t t = { DDS_SECS (1) };
+  ddsi_pacing_init (&p, &config, true, t);
+
+  // at most one adjustment per round-trip time
+  t.v += DDS_MSECS (10);
+  CU_ASSERT_FATAL (ddsi_pacing_note_acknack (&p, &config, true, t));
+  CU_ASSERT_FATAL (p.rate == 500000);
+  CU_ASSERT_FATAL (!ddsi_pacing_note_acknack (&p, &config, true, t));
+  CU_ASSERT_FATAL (p.rate == 500000);
+  CU_ASSERT_FATAL (p.backoff_count == 1);
+
+  // decreases multiplicatively down to the minimum rate
+  for (int i = 0; i < 10; i++)
+  {
+    t.v += DDS_MSECS (10);
+    CU_ASSERT_FATAL (ddsi_pacing_note_acknack (&p, &config, true, t));
+  }
+  CU_ASSERT_FATAL (p.rate == 100000);
+  CU_ASSERT_FATAL (p.backoff_count == 11);
+
+  // increases additively up to the maximum rate, using the updated round-trip time
+  ddsi_pacing_note_rtt (&p, DDS_MSECS (50));
+  t.v += DDS_MSECS (10);
+  CU_ASSERT_FATAL (!ddsi_pacing_note_acknack (&p, &config, false, t));
+  CU_ASSERT_FATAL (p.rate == 100000);
+  t.v += DDS_MSECS (40);
+  CU_ASSERT_FATAL (!ddsi_pacing_note_acknack (&p, &config, false, t));
+  CU_ASSERT_FATAL (p.rate == 150000);
+  for (int i = 0; i < 100; i++)
+  {
+    t.v += DDS_MSECS (50);
+    (void) ddsi_pacing_note_acknack (&p, &config, false, t);
+  }
+  CU_ASSERT_FATAL (p.rate == 1000000);
+  CU_ASSERT_FATAL (p.backoff_count == 11);
+}
+
+CU_Test (ddsi_pacing, achieved_rate)
+{
+  struct ddsi_config config;
+  struct ddsi_pacing p;
+  init_config (&config);
+  ddsrt_mtime_t t = { DDS_SECS (1) };
+  ddsi_pacing_init (&p, &config, true, t);
+  for (int i = 0; i < 1000; i++)
+  {
+    (void) ddsi_pacing_take (&p, &config, 500, t);
+    t.v += DDS_MSECS (1);
+  }
+  (void) ddsi_pacing_take (&p, &config, 500, t);
+  CU_ASSERT_FATAL (p.achieved_rate == 500000);
+  CU_ASSERT_FATAL (ddsi_pacing_achieved_rate (&p, t) == 500000);
+  // decays once the writer stops writing
+  t.v += DDS_SECS (2);
+  CU_ASSERT_FATAL (ddsi_pacing_achieved_rate (&p, t) < 1000);
+}
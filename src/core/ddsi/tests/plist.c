@@ -22,6 +22,8 @@
 #include "ddsi__tcp.h"
 #include "ddsi__tran.h"
 #include "ddsi__vendor.h"
+#include "ddsi__protocol.h"
+#include "ddsi__content_filter.h"
 
 #include "mem_ser.h"
 
@@ -497,3 +499,55 @@ CU_Test (ddsi_plist, locator_lists_accept)
     teardown (&gv);
   }
 }
+
+CU_Test (ddsi_plist, content_filter_property)
+{
+  unsigned char plist_cf[] = {
+    HDR(DDSI_PID_CONTENT_FILTER_PROPERTY, 52),
+    SER32BE(3), 'c','f',0,0,
+    SER32BE(2), 'T',0,0,0,
+    SER32BE(7), 'D','D','S','S','Q','L',0,0,
+    SER32BE(7), 'x',' ','>',' ','%','0',0,0,
+    SER32BE(1), SER32BE(2), '5',0,0,0,
+    HDR(DDSI_PID_SENTINEL, 0)
+  };
+  const ddsi_plist_src_t src = {
+    .protocol_version = { DDSI_RTPS_MAJOR, DDSI_RTPS_MINOR },
+    .vendorid = DDSI_VENDORID_ECLIPSE,
+    .encoding = DDSI_RTPS_PL_CDR_BE,
+    .buf = plist_cf,
+    .bufsz = sizeof (plist_cf),
+    .strict = true
+  };
+  struct ddsi_domaingv gv;
+  setup (&gv, 0);
+  ddsi_plist_init_tables ();
+  char *nextafter = NULL;
+  ddsi_plist_t plist;
+  dds_return_t rc = ddsi_plist_init_frommsg (&plist, &nextafter, ~(uint64_t)0, ~(uint64_t)0, &src, &gv, DDSI_PLIST_CONTEXT_ENDPOINT);
+  CU_ASSERT_FATAL (rc == 0);
+  CU_ASSERT_FATAL (plist.present == PP_CONTENT_FILTER_PROPERTY);
+  const ddsi_content_filter_property_t *cfp = &plist.content_filter_property;
+  CU_ASSERT_STRING_EQUAL (cfp->content_filtered_topic_name, "cf");
+  CU_ASSERT_STRING_EQUAL (cfp->related_topic_name, "T");
+  CU_ASSERT_STRING_EQUAL (cfp->filter_class_name, "DDSSQL");
+  CU_ASSERT_STRING_EQUAL (cfp->filter_expression, "x > %0");
+  CU_ASSERT_FATAL (cfp->expression_parameters.n == 1);
+  CU_ASSERT_STRING_EQUAL (cfp->expression_parameters.strs[0], "5");
+
+  // copies are deep and compare equal, a different parameter value makes them different
+  ddsi_content_filter_property_t *cp = ddsi_content_filter_property_dup (cfp);
+  CU_ASSERT (cp->filter_expression != cfp->filter_expression);
+  CU_ASSERT (cp->expression_parameters.strs[0] != cfp->expression_parameters.strs[0]);
+  CU_ASSERT (ddsi_content_filter_property_equal (cp, cfp));
+  CU_ASSERT (!ddsi_content_filter_property_equal (cp, NULL));
+  CU_ASSERT (ddsi_content_filter_property_equal (NULL, NULL));
+  ddsi_content_filter_property_t tmp = *cfp;
+  char *params[] = { "6" };
+  tmp.expression_parameters.strs = params;
+  CU_ASSERT (!ddsi_content_filter_property_equal (cp, &tmp));
+  ddsi_content_filter_property_free (cp);
+
+  ddsi_plist_fini (&plist);
+  teardown (&gv);
+}
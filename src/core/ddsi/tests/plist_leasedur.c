@@ -165,7 +165,7 @@ CU_Test (ddsi_plist_leasedur, ser_spdp, .init = setup, .fini = teardown)
 {
   ddsi_guid_t guid;
   memset (&guid, 0, sizeof (guid));
-  struct ddsi_xmsg *m = ddsi_xmsg_new (gv.xmsgpool, &guid, NULL, 64, DDSI_XMSG_KIND_DATA);
+  struct ddsi_xmsg *m = ddsi_xmsg_new (&guid, NULL, 64, DDSI_XMSG_KIND_DATA);
   CU_ASSERT_FATAL (m != NULL);
   struct ddsi_xmsg_marker marker;
   void *x = ddsi_xmsg_append (m, &marker, 0);
@@ -197,7 +197,7 @@ CU_Test (ddsi_plist_leasedur, ser_others, .init = setup, .fini = teardown)
 
     ddsi_guid_t guid;
     memset (&guid, 0, sizeof (guid));
-    struct ddsi_xmsg *m = ddsi_xmsg_new (gv.xmsgpool, &guid, NULL, 64, DDSI_XMSG_KIND_DATA);
+    struct ddsi_xmsg *m = ddsi_xmsg_new (&guid, NULL, 64, DDSI_XMSG_KIND_DATA);
     CU_ASSERT_FATAL (m != NULL);
     struct ddsi_xmsg_marker marker;
     void *x = ddsi_xmsg_append (m, &marker, 0);
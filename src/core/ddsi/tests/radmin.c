@@ -160,3 +160,255 @@ CU_Test (ddsi_radmin, drop_gap_at_end, .init = setup, .fini = teardown)
   ddsi_reorder_free (reorder);
   ddsi_defrag_free (defrag);
 }
+
+#define FEC_SAMPLE_SIZE 14
+#define FEC_BLOCK_SIZE 4
+#define FEC_NBLOCKS 4
+
+static struct ddsi_rsample *insert_fragment (struct ddsi_defrag *defrag, struct ddsi_rmsg *rmsg, const struct ddsi_rsample_info *si, const unsigned char *data, uint32_t min, uint32_t maxp1)
+{
+  unsigned char *payload = ddsi_rmsg_alloc (rmsg, maxp1 - min);
+  CU_ASSERT_FATAL (payload != NULL);
+  assert (payload);
+  memcpy (payload, data, maxp1 - min);
+  struct ddsi_rdata *rdata = ddsi_rdata_new (rmsg, min, maxp1, 0, (uint32_t) (payload - DDSI_RMSG_PAYLOAD (rmsg)), 0);
+  return ddsi_defrag_rsample (defrag, rdata, si);
+}
+
+static void check_fragchain (const struct ddsi_rdata *fragchain, const unsigned char *sample, uint32_t size)
+{
+  uint32_t pos = 0;
+  for (const struct ddsi_rdata *rdata = fragchain; rdata; rdata = rdata->nextfrag)
+  {
+    if (rdata->maxp1 <= pos)
+      continue;
+    CU_ASSERT_FATAL (rdata->min <= pos);
+    const unsigned char *payload = DDSI_RMSG_PAYLOADOFF (rdata->rmsg, DDSI_RDATA_PAYLOAD_OFF (rdata));
+    CU_ASSERT_FATAL (memcmp (payload + (pos - rdata->min), sample + pos, rdata->maxp1 - pos) == 0);
+    pos = rdata->maxp1;
+  }
+  CU_ASSERT_FATAL (pos == size);
+}
+
+CU_Test (ddsi_radmin, fec_recover, .init = setup, .fini = teardown)
+{
+  // blocks [0,4), [4,8), [8,12), [12,14) with a single parity block covering all
+  unsigned char sample[FEC_SAMPLE_SIZE], parity[FEC_BLOCK_SIZE] = { 0 };
+  for (uint32_t i = 0; i < FEC_SAMPLE_SIZE; i++)
+  {
+    sample[i] = (unsigned char) (17 * i + 3);
+    parity[i % FEC_BLOCK_SIZE] ^= sample[i];
+  }
+
+  struct ddsi_rmsg *rmsg = ddsi_rmsg_new (rbpool);
+  ddsi_rmsg_setsize (rmsg, 0);
+  struct ddsi_receiver_state *rst = ddsi_rmsg_alloc (rmsg, sizeof (*rst));
+  memset (rst, 0, sizeof (*rst));
+  struct ddsi_rsample_info *si = ddsi_rmsg_alloc (rmsg, sizeof (*si));
+  memset (si, 0, sizeof (*si));
+  si->rst = rst;
+  si->size = FEC_SAMPLE_SIZE;
+  si->fragsize = FEC_BLOCK_SIZE;
+
+  for (uint32_t lost = 0; lost < FEC_NBLOCKS; lost++)
+  {
+    struct ddsi_defrag *defrag = ddsi_defrag_new (&gv.logconfig, DDSI_DEFRAG_DROP_OLDEST, 1);
+    const uint32_t last = (lost + 1) % FEC_NBLOCKS;
+    unsigned char buf[FEC_BLOCK_SIZE];
+    uint32_t block;
+    si->seq = lost + 1;
+
+    // nothing can be done while two blocks are missing
+    for (uint32_t b = 0; b < FEC_NBLOCKS; b++)
+    {
+      const uint32_t min = b * FEC_BLOCK_SIZE, maxp1 = (min + FEC_BLOCK_SIZE < FEC_SAMPLE_SIZE) ? min + FEC_BLOCK_SIZE : FEC_SAMPLE_SIZE;
+      if (b != lost && b != last)
+        CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si, sample + min, min, maxp1) == NULL);
+    }
+    memcpy (buf, parity, sizeof (buf));
+    CU_ASSERT_FATAL (!ddsi_defrag_fec_recover (defrag, si->seq, 0, FEC_BLOCK_SIZE, FEC_NBLOCKS, buf, sizeof (buf), &block));
+    CU_ASSERT_FATAL (memcmp (buf, parity, sizeof (buf)) == 0);
+
+    // with one missing it gets reconstructed, and that completes the sample
+    const uint32_t lmin = last * FEC_BLOCK_SIZE, lmaxp1 = (lmin + FEC_BLOCK_SIZE < FEC_SAMPLE_SIZE) ? lmin + FEC_BLOCK_SIZE : FEC_SAMPLE_SIZE;
+    CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si, sample + lmin, lmin, lmaxp1) == NULL);
+    CU_ASSERT_FATAL (ddsi_defrag_fec_recover (defrag, si->seq, 0, FEC_BLOCK_SIZE, FEC_NBLOCKS, buf, sizeof (buf), &block));
+    CU_ASSERT_FATAL (block == lost);
+    const uint32_t min = lost * FEC_BLOCK_SIZE, maxp1 = (min + FEC_BLOCK_SIZE < FEC_SAMPLE_SIZE) ? min + FEC_BLOCK_SIZE : FEC_SAMPLE_SIZE;
+    CU_ASSERT_FATAL (memcmp (buf, sample + min, maxp1 - min) == 0);
+    struct ddsi_rsample *rsample = insert_fragment (defrag, rmsg, si, buf, min, maxp1);
+    CU_ASSERT_FATAL (rsample != NULL);
+    assert (rsample);
+    struct ddsi_rdata *fragchain = ddsi_rsample_fragchain (rsample);
+    check_fragchain (fragchain, sample, FEC_SAMPLE_SIZE);
+    ddsi_fragchain_adjust_refcount (fragchain, 0);
+
+    // once complete, the sample is no longer in the defragmenter
+    memcpy (buf, parity, sizeof (buf));
+    CU_ASSERT_FATAL (!ddsi_defrag_fec_recover (defrag, si->seq, 0, FEC_BLOCK_SIZE, FEC_NBLOCKS, buf, sizeof (buf), &block));
+    ddsi_defrag_free (defrag);
+  }
+  ddsi_rmsg_commit (rmsg);
+}
+
+CU_Test (ddsi_radmin, defrag_size_change, .init = setup, .fini = teardown)
+{
+  // the same sample in two representations of different sizes, e.g., compressed and
+  // uncompressed, fragments of the one must not be combined with those of the other
+  unsigned char a[FEC_SAMPLE_SIZE], b[FEC_SAMPLE_SIZE - FEC_BLOCK_SIZE];
+  for (uint32_t i = 0; i < sizeof (a); i++)
+    a[i] = (unsigned char) i;
+  for (uint32_t i = 0; i < sizeof (b); i++)
+    b[i] = (unsigned char) (0x80 + i);
+
+  struct ddsi_rmsg *rmsg = ddsi_rmsg_new (rbpool);
+  ddsi_rmsg_setsize (rmsg, 0);
+  struct ddsi_receiver_state *rst = ddsi_rmsg_alloc (rmsg, sizeof (*rst));
+  memset (rst, 0, sizeof (*rst));
+  struct ddsi_rsample_info *si_a = ddsi_rmsg_alloc (rmsg, sizeof (*si_a));
+  struct ddsi_rsample_info *si_b = ddsi_rmsg_alloc (rmsg, sizeof (*si_b));
+  memset (si_a, 0, sizeof (*si_a));
+  si_a->rst = rst;
+  si_a->size = (uint32_t) sizeof (a);
+  si_a->fragsize = FEC_BLOCK_SIZE;
+  *si_b = *si_a;
+  si_b->size = (uint32_t) sizeof (b);
+
+  // first for the most recent sample (fast path), then for an older one
+  for (ddsi_seqno_t seq = 2; seq >= 1; seq--)
+  {
+    // room for a third sample, or adding a fragment to an older one evicts the oldest
+    struct ddsi_defrag *defrag = ddsi_defrag_new (&gv.logconfig, DDSI_DEFRAG_DROP_OLDEST, 3);
+    for (ddsi_seqno_t s = 1; s <= 2; s++)
+    {
+      si_a->seq = s;
+      CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si_a, a, 0, FEC_BLOCK_SIZE) == NULL);
+      CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si_a, a + FEC_BLOCK_SIZE, FEC_BLOCK_SIZE, 2 * FEC_BLOCK_SIZE) == NULL);
+    }
+
+    // the last fragment of the other representation would complete a combination of the two
+    si_b->seq = seq;
+    CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si_b, b + 2 * FEC_BLOCK_SIZE, 2 * FEC_BLOCK_SIZE, (uint32_t) sizeof (b)) == NULL);
+    CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si_b, b, 0, FEC_BLOCK_SIZE) == NULL);
+    struct ddsi_rsample *rsample = insert_fragment (defrag, rmsg, si_b, b + FEC_BLOCK_SIZE, FEC_BLOCK_SIZE, 2 * FEC_BLOCK_SIZE);
+    CU_ASSERT_FATAL (rsample != NULL);
+    assert (rsample);
+    struct ddsi_rdata *fragchain = ddsi_rsample_fragchain (rsample);
+    check_fragchain (fragchain, b, (uint32_t) sizeof (b));
+    ddsi_fragchain_adjust_refcount (fragchain, 0);
+
+    // the other sample is still being defragmented in its original representation
+    si_a->seq = 3 - seq;
+    CU_ASSERT_FATAL (insert_fragment (defrag, rmsg, si_a, a + 3 * FEC_BLOCK_SIZE, 3 * FEC_BLOCK_SIZE, (uint32_t) sizeof (a)) == NULL);
+    rsample = insert_fragment (defrag, rmsg, si_a, a + 2 * FEC_BLOCK_SIZE, 2 * FEC_BLOCK_SIZE, 3 * FEC_BLOCK_SIZE);
+    CU_ASSERT_FATAL (rsample != NULL);
+    assert (rsample);
+    fragchain = ddsi_rsample_fragchain (rsample);
+    check_fragchain (fragchain, a, (uint32_t) sizeof (a));
+    ddsi_fragchain_adjust_refcount (fragchain, 0);
+    ddsi_defrag_free (defrag);
+  }
+  ddsi_rmsg_commit (rmsg);
+}
+
+CU_Test (ddsi_radmin, rmsg_batch, .init = setup, .fini = teardown)
+{
+  struct ddsi_rmsg *rmsgs[4];
+  uint32_t n = ddsi_rmsg_new_batch (rbpool, 4, rmsgs);
+  CU_ASSERT_FATAL (n == 4);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    // each must be able to hold a full-size packet
+    if (i > 0)
+      CU_ASSERT_FATAL ((char *) rmsgs[i] >= (char *) DDSI_RMSG_PAYLOAD (rmsgs[i - 1]) + gv.config.rmsg_chunk_size);
+    ddsi_rmsg_setsize (rmsgs[i], 100);
+  }
+
+  // keep the second one alive past the commit, the third one is needed for
+  // checking that the remainder of the batch gets reused
+  struct ddsi_rdata *gap = ddsi_rdata_newgap (rmsgs[1]);
+  ddsi_fragchain_adjust_refcount (gap, 1);
+  char *third = (char *) rmsgs[2];
+  for (uint32_t i = 0; i < n; i++)
+    ddsi_rmsg_commit (rmsgs[i]);
+  ddsi_rmsg_batch_done (rbpool);
+
+  struct ddsi_rmsg *rmsg = ddsi_rmsg_new (rbpool);
+  CU_ASSERT_FATAL (rmsg != NULL);
+  CU_ASSERT ((char *) rmsg > (char *) rmsgs[1] && (char *) rmsg < third);
+  ddsi_rmsg_setsize (rmsg, 100);
+  ddsi_rmsg_commit (rmsg);
+  ddsi_fragchain_unref (gap);
+
+  // if nothing is retained, the entire batch is reused
+  n = ddsi_rmsg_new_batch (rbpool, 2, rmsgs);
+  CU_ASSERT_FATAL (n == 2);
+  char *first = (char *) rmsgs[0];
+  for (uint32_t i = 0; i < n; i++)
+    ddsi_rmsg_commit (rmsgs[i]);
+  ddsi_rmsg_batch_done (rbpool);
+  rmsg = ddsi_rmsg_new (rbpool);
+  CU_ASSERT ((char *) rmsg == first);
+  ddsi_rmsg_commit (rmsg);
+}
+
+static uint32_t unref_gap_thread (void *varg)
+{
+  ddsi_fragchain_unref (varg);
+  return 0;
+}
+
+CU_Test (ddsi_radmin, rmsg_slab, .init = setup, .fini = teardown)
+{
+  struct ddsi_rbufpool *slabpool = ddsi_rbufpool_new_slab (&gv.logconfig, gv.config.rmsg_chunk_size, 2);
+  CU_ASSERT_FATAL (slabpool != NULL);
+
+  // a message that isn't retained leaves the slab available for the next
+  struct ddsi_rmsg *a = ddsi_rmsg_new (slabpool);
+  ddsi_rmsg_setsize (a, 100);
+  ddsi_rmsg_commit (a);
+  struct ddsi_rmsg *a1 = ddsi_rmsg_new (slabpool);
+  CU_ASSERT_FATAL (a1 == a);
+  ddsi_rmsg_setsize (a1, 100);
+
+  // a retained one doesn't, and if another thread releases it, it goes back
+  // into the pool for use by the owner
+  struct ddsi_rdata *gap_a = ddsi_rdata_newgap (a1);
+  ddsi_fragchain_adjust_refcount (gap_a, 1);
+  ddsi_rmsg_commit (a1);
+  struct ddsi_rmsg *b = ddsi_rmsg_new (slabpool);
+  CU_ASSERT_FATAL (b != a);
+  ddsi_rmsg_setsize (b, 100);
+  struct ddsi_rdata *gap_b = ddsi_rdata_newgap (b);
+  ddsi_fragchain_adjust_refcount (gap_b, 1);
+  ddsi_rmsg_commit (b);
+
+  ddsrt_thread_t tid;
+  ddsrt_threadattr_t tattr;
+  ddsrt_threadattr_init (&tattr);
+  CU_ASSERT_FATAL (ddsrt_thread_create (&tid, "unref", &tattr, unref_gap_thread, gap_a) == DDS_RETCODE_OK);
+  ddsrt_thread_join (tid, NULL);
+
+  struct ddsi_rmsg *c = ddsi_rmsg_new (slabpool);
+  CU_ASSERT_FATAL (c == a);
+  ddsi_rmsg_setsize (c, 100);
+  ddsi_rmsg_commit (c);
+  ddsi_fragchain_unref (gap_b);
+
+  // batches use a slab per rmsg, and the last one gets reused if it isn't retained
+  struct ddsi_rmsg *rmsgs[3];
+  uint32_t n = ddsi_rmsg_new_batch (slabpool, 3, rmsgs);
+  CU_ASSERT_FATAL (n == 3);
+  CU_ASSERT (rmsgs[0] != rmsgs[1] && rmsgs[1] != rmsgs[2] && rmsgs[0] != rmsgs[2]);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    ddsi_rmsg_setsize (rmsgs[i], 100);
+    ddsi_rmsg_commit (rmsgs[i]);
+  }
+  ddsi_rmsg_batch_done (slabpool);
+  struct ddsi_rmsg *d = ddsi_rmsg_new (slabpool);
+  CU_ASSERT (d == rmsgs[2]);
+  ddsi_rmsg_commit (d);
+
+  ddsi_rbufpool_free (slabpool);
+}
@@ -0,0 +1,178 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+
+#include "CUnit/Theory.h"
+
+#include "dds/ddsrt/cdtors.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sockets.h"
+#include "ddsi__tran.h"
+#include "ddsi__sockwaitset.h"
+
+#define N_CONNS 20 // more than WAITSET_DELTA, so growing the set gets exercised
+
+// The socket waitset only ever calls the "handle" function on a connection, so
+// a minimal fake connection wrapping a UDP socket suffices
+struct fake_conn {
+  struct ddsi_tran_conn c;
+  ddsrt_socket_t sock;
+  struct sockaddr_in addr;
+};
+
+static struct fake_conn conns[N_CONNS];
+static ddsrt_socket_t sender;
+
+static ddsrt_socket_t fake_conn_handle (struct ddsi_tran_base *base)
+{
+  return ((struct fake_conn *) base)->sock;
+}
+
+static void setup (void)
+{
+  ddsrt_init ();
+  CU_ASSERT_FATAL (ddsrt_socket (&sender, AF_INET, SOCK_DGRAM, 0) == DDS_RETCODE_OK);
+  for (int i = 0; i < N_CONNS; i++)
+  {
+    struct fake_conn * const fc = &conns[i];
+    socklen_t addrlen = sizeof (fc->addr);
+    memset (fc, 0, sizeof (*fc));
+    fc->c.m_base.m_handle_fn = fake_conn_handle;
+    CU_ASSERT_FATAL (ddsrt_socket (&fc->sock, AF_INET, SOCK_DGRAM, 0) == DDS_RETCODE_OK);
+    fc->addr.sin_family = AF_INET;
+    fc->addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    fc->addr.sin_port = 0;
+    CU_ASSERT_FATAL (ddsrt_bind (fc->sock, (struct sockaddr *) &fc->addr, sizeof (fc->addr)) == DDS_RETCODE_OK);
+    CU_ASSERT_FATAL (ddsrt_getsockname (fc->sock, (struct sockaddr *) &fc->addr, &addrlen) == DDS_RETCODE_OK);
+  }
+}
+
+static void teardown (void)
+{
+  for (int i = 0; i < N_CONNS; i++)
+    ddsrt_close (conns[i].sock);
+  ddsrt_close (sender);
+  ddsrt_fini ();
+}
+
+static void send_to (int i)
+{
+  char buf = (char) i;
+  ssize_t sent;
+  CU_ASSERT_FATAL (ddsrt_connect (sender, (struct sockaddr *) &conns[i].addr, sizeof (conns[i].addr)) == DDS_RETCODE_OK);
+  CU_ASSERT_FATAL (ddsrt_send (sender, &buf, 1, 0, &sent) == DDS_RETCODE_OK && sent == 1);
+}
+
+static void drain (int i)
+{
+  char buf;
+  ssize_t rcvd;
+  CU_ASSERT_FATAL (ddsrt_recv (conns[i].sock, &buf, 1, 0, &rcvd) == DDS_RETCODE_OK && rcvd == 1);
+  CU_ASSERT (buf == (char) i);
+}
+
+// Waits until all connections in "expected" have been reported at least once,
+// reading the datagram each time (the receive thread does the same) and
+// checking that no unexpected ones show up.  The index is only checked if
+// requested, because removing a connection may renumber the remaining ones.
+static void check_events (struct ddsi_sock_waitset *ws, const bool expected[N_CONNS], bool check_index)
+{
+  bool seen[N_CONNS];
+  int nexp = 0, nseen = 0;
+  memset (seen, 0, sizeof (seen));
+  for (int i = 0; i < N_CONNS; i++)
+    nexp += expected[i] ? 1 : 0;
+  while (nseen < nexp)
+  {
+    struct ddsi_sock_waitset_ctx *ctx = ddsi_sock_waitset_wait (ws);
+    struct ddsi_tran_conn *conn;
+    int idx;
+    CU_ASSERT_FATAL (ctx != NULL);
+    while ((idx = ddsi_sock_waitset_next_event (ctx, &conn)) >= 0)
+    {
+      int i;
+      for (i = 0; i < N_CONNS && conn != &conns[i].c; i++)
+        ;
+      CU_ASSERT_FATAL (i < N_CONNS);
+      if (check_index)
+        CU_ASSERT_FATAL (idx == i);
+      CU_ASSERT_FATAL (expected[i]);
+      CU_ASSERT_FATAL (!seen[i]);
+      drain (i);
+      seen[i] = true;
+      nseen++;
+    }
+  }
+}
+
+CU_Test (ddsi_sockwaitset, add_wait_purge, .init = setup, .fini = teardown)
+{
+  struct ddsi_sock_waitset *ws = ddsi_sock_waitset_new ();
+  CU_ASSERT_FATAL (ws != NULL);
+  for (int i = 0; i < N_CONNS; i++)
+    CU_ASSERT_FATAL (ddsi_sock_waitset_add (ws, &conns[i].c) == 1);
+  CU_ASSERT (ddsi_sock_waitset_add (ws, &conns[0].c) == 0);
+
+  // index returned must match the order in which connections were added
+  bool expected[N_CONNS];
+  for (int i = 0; i < N_CONNS; i++)
+    expected[i] = (i % 3) == 1;
+  for (int i = 0; i < N_CONNS; i++)
+    if (expected[i])
+      send_to (i);
+  check_events (ws, expected, true);
+
+  // purging drops everything from the index onwards, data arriving on one of
+  // those must not be reported
+  ddsi_sock_waitset_purge (ws, N_CONNS / 2);
+  send_to (N_CONNS - 1);
+  memset (expected, 0, sizeof (expected));
+  expected[0] = true;
+  send_to (0);
+  check_events (ws, expected, true);
+  drain (N_CONNS - 1);
+
+  // re-adding after a purge restores the indices
+  for (int i = N_CONNS / 2; i < N_CONNS; i++)
+    CU_ASSERT_FATAL (ddsi_sock_waitset_add (ws, &conns[i].c) == 1);
+  memset (expected, 0, sizeof (expected));
+  expected[N_CONNS - 1] = true;
+  send_to (N_CONNS - 1);
+  check_events (ws, expected, true);
+  ddsi_sock_waitset_free (ws);
+}
+
+CU_Test (ddsi_sockwaitset, trigger_remove, .init = setup, .fini = teardown)
+{
+  struct ddsi_sock_waitset *ws = ddsi_sock_waitset_new ();
+  struct ddsi_sock_waitset_ctx *ctx;
+  struct ddsi_tran_conn *conn;
+  CU_ASSERT_FATAL (ws != NULL);
+  for (int i = 0; i < 2; i++)
+    CU_ASSERT_FATAL (ddsi_sock_waitset_add (ws, &conns[i].c) == 1);
+
+  // triggering results in a wakeup without events
+  ddsi_sock_waitset_trigger (ws);
+  ctx = ddsi_sock_waitset_wait (ws);
+  CU_ASSERT_FATAL (ctx != NULL);
+  CU_ASSERT (ddsi_sock_waitset_next_event (ctx, &conn) == -1);
+
+  // removed connections no longer produce events
+  ddsi_sock_waitset_remove (ws, &conns[0].c);
+  send_to (0);
+  bool expected[N_CONNS];
+  memset (expected, 0, sizeof (expected));
+  expected[1] = true;
+  send_to (1);
+  check_events (ws, expected, false);
+  drain (0);
+  ddsi_sock_waitset_free (ws);
+}
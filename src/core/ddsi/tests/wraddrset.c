@@ -112,6 +112,27 @@ static void whc_free_deferred_free_list (struct ddsi_whc *whc, struct ddsi_whc_n
   (void) whc; (void) deferred_free_list;
 }
 
+struct covered_arg {
+  const struct ddsi_addrset *wras;
+  bool covered;
+};
+
+static void covered_helper (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct covered_arg * const arg = varg;
+  if (loc->c.kind != DDSI_LOCATOR_KIND_PSMX && ddsi_addrset_contains_xlocator (&gv, arg->wras, loc))
+    arg->covered = true;
+}
+
+static bool reader_covered (const struct ddsi_writer *wr, const ddsi_guid_t *rdguid)
+{
+  struct ddsi_proxy_reader *prd = ddsi_entidx_lookup_proxy_reader_guid (gv.entity_index, rdguid);
+  struct covered_arg arg = { .wras = wr->as, .covered = false };
+  assert (prd);
+  ddsi_addrset_forall (prd->c.as, covered_helper, &arg);
+  return arg.covered;
+}
+
 static void ddsi_wraddrset_some_cases (int casenumber, int cost, bool wr_psmx, const int nrds[4])
 {
 #define UNILOC(k) { .kind = DDSI_LOCATOR_KIND_UDPv4, .address = {0,0,0,0, 0,0,0,0, 0,0,0,0, 192,16,1,k+1}, .port = 7410 }
@@ -141,7 +162,7 @@ static void ddsi_wraddrset_some_cases (int casenumber, int cost, bool wr_psmx, c
     } \
   }
   const ddsi_plist_t plist_pp[4] = { PLIST_PP(0), PLIST_PP(1), PLIST_PP(2), PLIST_PP(3) };
-  ddsi_guid_t wrppguid, rdppguid[4][3];
+  ddsi_guid_t wrppguid, rdppguid[4][3], rdguid[4][3];
 
   setup_and_start ();
   ddsi_thread_state_awake (ddsi_lookup_thread_state(), &gv);
@@ -206,7 +227,7 @@ static void ddsi_wraddrset_some_cases (int casenumber, int cost, bool wr_psmx, c
       ddsi_new_proxy_participant (&proxy_participant, &gv, &rdppguid[i][j], 0, NULL, proxypp_as, ddsi_ref_addrset (proxypp_as), &plist_pp[i], DDS_INFINITY, DDSI_VENDORID_ECLIPSE, 0, ddsrt_time_wallclock (), 1);
       assert (proxy_participant != NULL);
 
-      const ddsi_guid_t rdguid = {
+      rdguid[i][j] = (ddsi_guid_t){
         .prefix = rdppguid[i][j].prefix,
         .entityid = { .u = DDSI_ENTITYID_ALLOCSTEP | DDSI_ENTITYID_SOURCE_USER | DDSI_ENTITYID_KIND_READER_NO_KEY }
       };
@@ -227,15 +248,29 @@ static void ddsi_wraddrset_some_cases (int casenumber, int cost, bool wr_psmx, c
       }
       struct ddsi_proxy_reader *proxy_reader;
 #if DDSRT_HAVE_SSM
-      ddsi_new_proxy_reader (&proxy_reader, &gv, &rdppguid[i][j], &rdguid, rd_as, &plist_rd, ddsrt_time_wallclock (), 1, false);
+      ddsi_new_proxy_reader (&proxy_reader, &gv, &rdppguid[i][j], &rdguid[i][j], rd_as, &plist_rd, ddsrt_time_wallclock (), 1, false);
 #else
-      ddsi_new_proxy_reader (&proxy_reader, &gv, &rdppguid[i][j], &rdguid, rd_as, &plist_rd, ddsrt_time_wallclock (), 1);
+      ddsi_new_proxy_reader (&proxy_reader, &gv, &rdppguid[i][j], &rdguid[i][j], rd_as, &plist_rd, ddsrt_time_wallclock (), 1);
 #endif
       assert (proxy_reader);
       ddsi_unref_addrset (rd_as);
     }
   }
 
+  // Readers get added one by one, so the address set is typically the result of incremental
+  // updates, that must reach all readers that can't be reached via PSMX; a full computation
+  // must do so as well
+  ddsrt_mutex_lock (&wr->e.lock);
+  for (int i = 1; i < 4; i++)
+    for (int j = 0; j < nrds[i]; j++)
+      CU_ASSERT (reader_covered (wr, &rdguid[i][j]));
+  ddsi_rebuild_writer_addrset (wr);
+  CU_ASSERT (!wr->addrset_dirty);
+  for (int i = 1; i < 4; i++)
+    for (int j = 0; j < nrds[i]; j++)
+      CU_ASSERT (reader_covered (wr, &rdguid[i][j]));
+  ddsrt_mutex_unlock (&wr->e.lock);
+
   if (casenumber == 0)
     DDS_CLOG (DDS_LC_CONTENT, &gv.logconfig, "    #rd/host  cost: addresses\n");
   DDS_CLOG (DDS_LC_CONTENT, &gv.logconfig, "%2d  ", casenumber+1);
@@ -0,0 +1,265 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Benchmark comparing the type-specific serializers generated by idlc with
+// "-f type-serdes" with the interpreter of the serializer instructions.  For
+// a small keyed type and a larger type with strings and sequences it times
+// serializing, computing the serialized size, normalizing (both native and
+// byte-swapped input), deserializing and extracting the key from serialized
+// data, each of these with the generated functions and with the interpreter,
+// and reports the average time per operation.  It then compares the scalar
+// and vectorized kernels for byte-swapping and validating primitive arrays.
+//
+// Usage: cdrstream_bench [N]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/time.h"
+#include "dds/cdr/dds_cdrstream.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
+#include "CdrStreamBenchTypes.h"
+
+enum op {
+  OP_WRITE,
+  OP_GETSIZE,
+  OP_NORMALIZE,
+  OP_NORMALIZE_BSWAP,
+  OP_READ,
+  OP_EXTRACT_KEY
+};
+#define N_OPS 6
+
+static const char *opnames[N_OPS] = { "write", "getsize", "normalize", "normalize-bswap", "read", "extract-key" };
+
+static void init_small (void *vs, uint32_t i)
+{
+  CdrStreamBench_Small *s = vs;
+  s->id = (int32_t) i;
+  (void) snprintf (s->name, sizeof (s->name), "sensor-%"PRIu32, i % 1000);
+  s->timestamp = 1000000u * i;
+  s->valid = (i % 2) != 0;
+  s->flags = (int16_t) i;
+  s->pos.x = i;
+  s->pos.y = 2.0 * i;
+  s->pos.z = 3.0 * i;
+  s->speed = 0.5f * (float) i;
+}
+
+static void init_large (void *vs, uint32_t i)
+{
+  CdrStreamBench_Large *s = vs;
+  char buf[64];
+  s->id = (int32_t) i;
+  (void) snprintf (buf, sizeof (buf), "description of sample %"PRIu32, i);
+  s->descr = ddsrt_strdup (buf);
+  s->owner = ddsrt_strdup ("owner");
+  s->values._length = s->values._maximum = 16;
+  s->values._buffer = dds_alloc (16 * sizeof (*s->values._buffer));
+  s->values._release = true;
+  for (uint32_t j = 0; j < 16; j++)
+    s->values._buffer[j] = (int32_t) (i + j);
+  s->samples._length = s->samples._maximum = 32;
+  s->samples._buffer = dds_alloc (32 * sizeof (*s->samples._buffer));
+  s->samples._release = true;
+  for (uint32_t j = 0; j < 32; j++)
+    s->samples._buffer[j] = (double) i / (j + 1);
+  for (uint32_t j = 0; j < sizeof (s->payload); j++)
+    s->payload[j] = (uint8_t) (i + j);
+  s->pos.x = s->pos.y = s->pos.z = i;
+}
+
+static double run (const struct dds_cdrstream_desc *desc, enum op op, void *sample, const dds_ostream_t *data, const dds_ostreamBE_t *dataBE, uint32_t n)
+{
+  const struct dds_cdrstream_allocator *alloc = &dds_cdrstream_default_allocator;
+  void *buf = ddsrt_malloc (data->m_index);
+  dds_ostream_t os;
+  dds_istream_t is;
+  uint32_t actsz;
+  size_t sz = 0;
+  dds_ostream_init (&os, alloc, 0, data->m_xcdr_version);
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    switch (op)
+    {
+      case OP_WRITE:
+        os.m_index = 0;
+        if (!dds_stream_write_sample (&os, alloc, sample, desc))
+          abort ();
+        break;
+      case OP_GETSIZE:
+        sz += dds_stream_getsize_sample (sample, desc, data->m_xcdr_version);
+        break;
+      case OP_NORMALIZE:
+        memcpy (buf, data->m_buffer, data->m_index);
+        if (!dds_stream_normalize (buf, data->m_index, false, data->m_xcdr_version, desc, false, &actsz))
+          abort ();
+        break;
+      case OP_NORMALIZE_BSWAP:
+        memcpy (buf, dataBE->x.m_buffer, dataBE->x.m_index);
+        if (!dds_stream_normalize (buf, dataBE->x.m_index, (DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN), data->m_xcdr_version, desc, false, &actsz))
+          abort ();
+        break;
+      case OP_READ:
+        dds_istream_init (&is, data->m_index, data->m_buffer, data->m_xcdr_version);
+        dds_stream_read_sample (&is, sample, alloc, desc);
+        break;
+      case OP_EXTRACT_KEY:
+        os.m_index = 0;
+        dds_istream_init (&is, data->m_index, data->m_buffer, data->m_xcdr_version);
+        if (!dds_stream_extract_key_from_data (&is, &os, alloc, desc))
+          abort ();
+        break;
+    }
+  }
+  const dds_time_t t1 = dds_time ();
+  if (op == OP_GETSIZE && sz != (size_t) n * data->m_index)
+    abort ();
+  dds_ostream_fini (&os, alloc);
+  ddsrt_free (buf);
+  return (double) (t1 - t0) / n;
+}
+
+static void bench (const char *name, const dds_topic_descriptor_t *topic_desc, void (*init) (void *, uint32_t), uint32_t n)
+{
+  const struct dds_cdrstream_allocator *alloc = &dds_cdrstream_default_allocator;
+  struct dds_cdrstream_desc desc_gen, desc_int;
+  dds_cdrstream_desc_from_topic_desc (&desc_gen, topic_desc);
+  dds_cdrstream_desc_from_topic_desc (&desc_int, topic_desc);
+  desc_int.funcs = NULL;
+  if (desc_gen.funcs == NULL)
+  {
+    fprintf (stderr, "%s: no generated serializers\n", name);
+    exit (2);
+  }
+
+  void *sample = ddsrt_calloc (1, topic_desc->m_size);
+  init (sample, 42);
+  for (uint32_t xcdrv = DDSI_RTPS_CDR_ENC_VERSION_1; xcdrv <= DDSI_RTPS_CDR_ENC_VERSION_2; xcdrv++)
+  {
+    dds_ostream_t data;
+    dds_ostreamBE_t dataBE;
+    dds_ostream_init (&data, alloc, 0, xcdrv);
+    dds_ostreamBE_init (&dataBE, alloc, 0, xcdrv);
+    if (!dds_stream_write_sample (&data, alloc, sample, &desc_int) || !dds_stream_write_sampleBE (&dataBE, alloc, sample, &desc_int))
+      abort ();
+    for (int op = 0; op < N_OPS; op++)
+    {
+      // warm up
+      (void) run (&desc_int, (enum op) op, sample, &data, &dataBE, n / 10 + 1);
+      (void) run (&desc_gen, (enum op) op, sample, &data, &dataBE, n / 10 + 1);
+      const double t_int = run (&desc_int, (enum op) op, sample, &data, &dataBE, n);
+      const double t_gen = run (&desc_gen, (enum op) op, sample, &data, &dataBE, n);
+      printf ("%-6s %5"PRIu32" %-6s %-16s %10.1f %10.1f %8.2f\n",
+              name, data.m_index, (xcdrv == DDSI_RTPS_CDR_ENC_VERSION_1) ? "XCDR1" : "XCDR2", opnames[op],
+              t_int, t_gen, t_int / t_gen);
+      fflush (stdout);
+    }
+    dds_ostream_fini (&data, alloc);
+    dds_ostreamBE_fini (&dataBE, alloc);
+  }
+  dds_stream_free_sample (sample, alloc, desc_int.ops.ops);
+  ddsrt_free (sample);
+  dds_cdrstream_desc_fini (&desc_gen, alloc);
+  dds_cdrstream_desc_fini (&desc_int, alloc);
+}
+
+enum simd_op {
+  SOP_BSWAP4,
+  SOP_BSWAP8,
+  SOP_CLAMP_BOOL,
+  SOP_CHECK_ENUM,
+  SOP_CHECK_ENUM_BSWAP,
+  SOP_CHECK_BITMASK
+};
+#define N_SIMD_OPS 6
+#define SIMD_ARRAY_SIZE 4096
+
+static const char *simd_opnames[N_SIMD_OPS] = { "bswap-float", "bswap-double", "clamp-bool", "check-enum", "check-enum-bswap", "check-bitmask" };
+
+static double run_simd (enum simd_op op, void *buf, uint32_t n)
+{
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    switch (op)
+    {
+      case SOP_BSWAP4:
+        dds_stream_simd_bswap (buf, 4, SIMD_ARRAY_SIZE);
+        break;
+      case SOP_BSWAP8:
+        dds_stream_simd_bswap (buf, 8, SIMD_ARRAY_SIZE);
+        break;
+      case SOP_CLAMP_BOOL:
+        dds_stream_simd_clamp_bool (buf, SIMD_ARRAY_SIZE);
+        break;
+      case SOP_CHECK_ENUM:
+        if (!dds_stream_simd_check_max (buf, 4, SIMD_ARRAY_SIZE, false, UINT32_MAX - 1))
+          abort ();
+        break;
+      case SOP_CHECK_ENUM_BSWAP:
+        if (!dds_stream_simd_check_max (buf, 4, SIMD_ARRAY_SIZE, true, UINT32_MAX - 1))
+          abort ();
+        break;
+      case SOP_CHECK_BITMASK:
+        if (!dds_stream_simd_check_bitmask (buf, 4, SIMD_ARRAY_SIZE, false, 0, 0x7fffffff))
+          abort ();
+        break;
+    }
+  }
+  const dds_time_t t1 = dds_time ();
+  return (double) (t1 - t0) / n;
+}
+
+static void bench_simd (uint32_t n)
+{
+  const enum dds_stream_simd_isa isa = dds_stream_simd_get ();
+  // values that pass all checks, whether byte-swapped or not
+  uint32_t *buf = ddsrt_malloc (SIMD_ARRAY_SIZE * 8);
+  for (uint32_t i = 0; i < 2 * SIMD_ARRAY_SIZE; i++)
+    buf[i] = 0x01010101;
+  printf ("\n%-16s %5s %10s %10s %8s\n", "kernel", "size", "scalar(ns)", "simd(ns)", "speedup");
+  for (int op = 0; op < N_SIMD_OPS; op++)
+  {
+    double t[2];
+    for (int k = 0; k < 2; k++)
+    {
+      (void) dds_stream_simd_set (k == 0 ? DDS_STREAM_SIMD_SCALAR : isa);
+      (void) run_simd ((enum simd_op) op, buf, n / 10 + 1);
+      t[k] = run_simd ((enum simd_op) op, buf, n);
+    }
+    printf ("%-16s %5d %10.1f %10.1f %8.2f\n", simd_opnames[op], SIMD_ARRAY_SIZE, t[0], t[1], t[0] / t[1]);
+    fflush (stdout);
+  }
+  (void) dds_stream_simd_set (isa);
+  printf ("using %s kernels\n", dds_stream_simd_name (isa));
+  ddsrt_free (buf);
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t n = 1000000;
+  if (argc > 1 && (n = (uint32_t) atoi (argv[1])) == 0)
+  {
+    fprintf (stderr, "usage: %s [N]\n", argv[0]);
+    return 1;
+  }
+  printf ("%-6s %5s %-6s %-16s %10s %10s %8s\n", "type", "size", "xcdr", "operation", "interp(ns)", "gen(ns)", "speedup");
+  bench ("Small", &CdrStreamBench_Small_desc, init_small, n);
+  bench ("Large", &CdrStreamBench_Large_desc, init_large, n);
+  bench_simd (n / 100 + 1);
+  return 0;
+}
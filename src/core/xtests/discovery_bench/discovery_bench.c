@@ -0,0 +1,120 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Benchmark for endpoint matching as a function of the number of endpoints.
+// For each size N it creates N reader/writer pairs on a single topic, each
+// pair in a partition of its own, so that every writer matches exactly one
+// reader.  Then it measures the cost of creating (and deleting) one more
+// writer, once in an existing partition and once with a wildcard partition
+// that matches none of the readers.  The former only needs to look at the
+// readers in the same partition, the latter has to check all of them.
+//
+// Usage: discovery_bench [NWRITERS [N...]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/time.h"
+#include "DiscoveryBenchTypes.h"
+
+static dds_entity_t create_in_partition (dds_entity_t pp, dds_entity_t tp, bool reader, const char *partition)
+{
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_partition1 (qos, partition);
+  const dds_entity_t grp = reader ? dds_create_subscriber (pp, qos, NULL) : dds_create_publisher (pp, qos, NULL);
+  dds_delete_qos (qos);
+  if (grp < 0)
+    return grp;
+  return reader ? dds_create_reader (grp, tp, NULL, NULL) : dds_create_writer (grp, tp, NULL, NULL);
+}
+
+static bool check_matched (dds_entity_t wr, int32_t expected)
+{
+  const dds_return_t n = dds_get_matched_subscriptions (wr, NULL, 0);
+  if (n != expected)
+  {
+    fprintf (stderr, "writer matched %"PRId32" readers, expected %"PRId32"\n", n, expected);
+    return false;
+  }
+  return true;
+}
+
+static bool time_writer (dds_entity_t pp, dds_entity_t tp, const char *partition, int32_t expected, uint32_t nwriters, double *us)
+{
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_partition1 (qos, partition);
+  const dds_entity_t pub = dds_create_publisher (pp, qos, NULL);
+  dds_delete_qos (qos);
+  bool ok = (pub > 0);
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < nwriters && ok; i++)
+  {
+    const dds_entity_t wr = dds_create_writer (pub, tp, NULL, NULL);
+    ok = (wr > 0) && check_matched (wr, expected) && dds_delete (wr) == 0;
+  }
+  *us = (double) (dds_time () - t0) / 1e3 / nwriters;
+  dds_delete (pub);
+  return ok;
+}
+
+static bool run (uint32_t n, uint32_t nwriters, double *setup_ms, double *exact_us, double *wildcard_us)
+{
+  char name[64];
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+  {
+    fprintf (stderr, "dds_create_participant: %s\n", dds_strretcode (pp));
+    return false;
+  }
+  const dds_entity_t tp = dds_create_topic (pp, &DiscoveryBench_Msg_desc, "discovery_bench", NULL, NULL);
+  bool ok = (tp > 0);
+
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n && ok; i++)
+  {
+    (void) snprintf (name, sizeof (name), "p%"PRIu32, i);
+    ok = create_in_partition (pp, tp, true, name) > 0 && create_in_partition (pp, tp, false, name) > 0;
+  }
+  *setup_ms = (double) (dds_time () - t0) / 1e6;
+
+  if (ok)
+    ok = time_writer (pp, tp, "p0", 1, nwriters, exact_us);
+  if (ok)
+    ok = time_writer (pp, tp, "q*", 0, nwriters, wildcard_us);
+  dds_delete (pp);
+  return ok;
+}
+
+int main (int argc, char **argv)
+{
+  static const uint32_t default_sizes[] = { 100, 500, 1000, 2000, 5000 };
+  uint32_t nwriters = 100;
+
+  if (argc > 1 && (nwriters = (uint32_t) atoi (argv[1])) == 0)
+  {
+    fprintf (stderr, "usage: %s [NWRITERS [N...]]\n", argv[0]);
+    return 1;
+  }
+
+  printf ("%8s %12s %14s %14s\n", "N", "setup(ms)", "exact(us/wr)", "wildcard(us/wr)");
+  const int nn = (argc > 2) ? argc - 2 : (int) (sizeof (default_sizes) / sizeof (default_sizes[0]));
+  for (int i = 0; i < nn; i++)
+  {
+    const uint32_t n = (argc > 2) ? (uint32_t) atoi (argv[i + 2]) : default_sizes[i];
+    double setup, exact, wildcard;
+    if (!run (n, nwriters, &setup, &exact, &wildcard))
+      return 2;
+    printf ("%8"PRIu32" %12.1f %14.1f %14.1f\n", n, setup, exact, wildcard);
+    fflush (stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Micro-benchmark for the handle table: N threads each repeatedly pin and
+// unpin an entity, which is what every operation on an entity does on entry
+// and exit.  Two cases are measured: each thread using its own entity (the
+// common case of an application thread per writer) and all threads using the
+// same entity.  Meanwhile, another thread continuously creates and deletes
+// entities, so that the table changes while it is being looked up.
+//
+// Usage: handle_pin_bench [SECONDS [NTHREADS...]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/threads.h"
+#include "dds/ddsrt/time.h"
+#include "dds__handles.h"
+
+struct pinner_arg {
+  dds_entity_t entity;
+  ddsrt_atomic_uint32_t *stop;
+  uint64_t count;
+  bool failed;
+};
+
+struct churn_arg {
+  dds_entity_t participant;
+  ddsrt_atomic_uint32_t *stop;
+  uint64_t count;
+};
+
+static uint32_t pinner (void *varg)
+{
+  struct pinner_arg * const arg = varg;
+  uint64_t n = 0;
+  while (!ddsrt_atomic_ld32 (arg->stop))
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      struct dds_handle_link *link;
+      if (dds_handle_pin (arg->entity, &link) != DDS_RETCODE_OK)
+      {
+        arg->failed = true;
+        return 0;
+      }
+      dds_handle_unpin (link);
+    }
+    n += 1000;
+  }
+  arg->count = n;
+  return 0;
+}
+
+static uint32_t churner (void *varg)
+{
+  struct churn_arg * const arg = varg;
+  uint64_t n = 0;
+  while (!ddsrt_atomic_ld32 (arg->stop))
+  {
+    const dds_entity_t sub = dds_create_subscriber (arg->participant, NULL, NULL);
+    if (sub > 0 && dds_delete (sub) == DDS_RETCODE_OK)
+      n++;
+  }
+  arg->count = n;
+  return 0;
+}
+
+static bool run (dds_entity_t pp, uint32_t nthreads, bool shared, double duration, double *mpins, double *deletes)
+{
+  ddsrt_atomic_uint32_t stop = DDSRT_ATOMIC_UINT32_INIT (0);
+  struct pinner_arg *args = ddsrt_malloc (nthreads * sizeof (*args));
+  ddsrt_thread_t *tids = ddsrt_malloc (nthreads * sizeof (*tids));
+  struct churn_arg churn_arg = { .participant = pp, .stop = &stop, .count = 0 };
+  ddsrt_thread_t churn_tid;
+  ddsrt_threadattr_t tattr;
+  bool ok = true;
+
+  ddsrt_threadattr_init (&tattr);
+  for (uint32_t i = 0; i < nthreads; i++)
+  {
+    args[i].entity = (shared && i > 0) ? args[0].entity : dds_create_publisher (pp, NULL, NULL);
+    args[i].stop = &stop;
+    args[i].count = 0;
+    args[i].failed = false;
+  }
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < nthreads; i++)
+    ddsrt_thread_create (&tids[i], "pinner", &tattr, pinner, &args[i]);
+  ddsrt_thread_create (&churn_tid, "churner", &tattr, churner, &churn_arg);
+  dds_sleepfor ((dds_duration_t) (duration * 1e9));
+  ddsrt_atomic_st32 (&stop, 1);
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < nthreads; i++)
+  {
+    ddsrt_thread_join (tids[i], NULL);
+    total += args[i].count;
+    if (args[i].failed)
+      ok = false;
+  }
+  ddsrt_thread_join (churn_tid, NULL);
+  const double dt = (double) (dds_time () - t0) / 1e9;
+  for (uint32_t i = 0; i < nthreads; i++)
+  {
+    if (!shared || i == 0)
+      (void) dds_delete (args[i].entity);
+  }
+  *mpins = (double) total / dt / 1e6;
+  *deletes = (double) churn_arg.count / dt;
+  ddsrt_free (tids);
+  ddsrt_free (args);
+  return ok;
+}
+
+int main (int argc, char **argv)
+{
+  static const uint32_t default_nthreads[] = { 1, 2, 4, 8, 16, 32 };
+  double duration = 1.0;
+
+  if (argc > 1)
+    duration = atof (argv[1]);
+  if (duration <= 0.0)
+  {
+    fprintf (stderr, "usage: %s [SECONDS [NTHREADS...]]\n", argv[0]);
+    return 1;
+  }
+
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+  {
+    fprintf (stderr, "dds_create_participant: %s\n", dds_strretcode (pp));
+    return 2;
+  }
+
+  printf ("%8s %16s %16s %12s\n", "nthreads", "own(Mpins/s)", "shared(Mpins/s)", "deletes/s");
+  const int nn = (argc > 2) ? argc - 2 : (int) (sizeof (default_nthreads) / sizeof (default_nthreads[0]));
+  int rc = 0;
+  for (int i = 0; i < nn && rc == 0; i++)
+  {
+    const uint32_t n = (argc > 2) ? (uint32_t) atoi (argv[i + 2]) : default_nthreads[i];
+    double own, shared, del_own, del_shared;
+    if (n == 0)
+      continue;
+    if (!run (pp, n, false, duration, &own, &del_own) || !run (pp, n, true, duration, &shared, &del_shared))
+    {
+      fprintf (stderr, "pinning a live entity failed\n");
+      rc = 3;
+    }
+    printf ("%8"PRIu32" %16.2f %16.2f %12.0f\n", n, own, shared, (del_own + del_shared) / 2.0);
+  }
+
+  dds_delete (pp);
+  return rc;
+}
@@ -17,6 +17,8 @@
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/process.h"
 #include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/threads.h"
+#include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/random.h"
 #include "dds/ddsrt/cdtors.h"
 #include "dds/ddsi/ddsi_tkmap.h"
@@ -35,6 +37,7 @@
 #include "dds__topic.h"
 #include "dds__read.h"
 #include "dds__rhc_default.h"
+#include "dds__rhc_sharded.h"
 
 #ifdef DDS_HAS_LIFESPAN
 #include "dds/ddsi/ddsi_lifespan.h"
@@ -612,6 +615,8 @@ static void test_conditions (dds_entity_t pp, dds_entity_t tp, const int count,
   const struct ddsi_domaingv *gv = get_gv (pp);
   struct ddsi_tkmap *tkmap = gv->m_tkmap;
   struct ddsi_proxy_writer *wr[] = { mkwr (0), mkwr (1), mkwr (1) };
+  /* readers without resource limits use a sharded RHC if so configured */
+  const bool sharded = (gv->config.rhc_shards > 1);
 
   static const uint32_t stab[] = {
     DDS_READ_SAMPLE_STATE, DDS_NOT_READ_SAMPLE_STATE,
@@ -856,9 +861,17 @@ static void test_conditions (dds_entity_t pp, dds_entity_t tp, const int count,
       case 12: {
 #ifdef DDS_HAS_LIFESPAN
         ddsi_thread_state_awake_domain_ok (ddsi_lookup_thread_state ());
-        /* We can assume that rhc[k] is a dds_rhc_default at this point */
+        /* We can assume that rhc[k] is a dds_rhc_default or a dds_rhc_sharded at this point */
         for (size_t k = 0; k < nrd; k++)
-          (void) dds_rhc_default_sample_expired_cb (rhc[k], rand_texp());
+        {
+          if (!sharded)
+            (void) dds_rhc_default_sample_expired_cb (rhc[k], rand_texp());
+          else
+          {
+            for (uint32_t j = 0; j < dds_rhc_sharded_nshards (rhc[k]); j++)
+              (void) dds_rhc_default_sample_expired_cb (dds_rhc_sharded_shard (rhc[k], j), rand_texp());
+          }
+        }
         ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
 #endif
         break;
@@ -866,9 +879,17 @@ static void test_conditions (dds_entity_t pp, dds_entity_t tp, const int count,
       case 13: {
 #ifdef DDS_HAS_DEADLINE_MISSED
         ddsi_thread_state_awake_domain_ok (ddsi_lookup_thread_state ());
-        /* We can assume that rhc[k] is a dds_rhc_default at this point */
+        /* We can assume that rhc[k] is a dds_rhc_default or a dds_rhc_sharded at this point */
         for (size_t k = 0; k < nrd; k++)
-          (void) dds_rhc_default_deadline_missed_cb (rhc[k], rand_texp());
+        {
+          if (!sharded)
+            (void) dds_rhc_default_deadline_missed_cb (rhc[k], rand_texp());
+          else
+          {
+            for (uint32_t j = 0; j < dds_rhc_sharded_nshards (rhc[k]); j++)
+              (void) dds_rhc_default_deadline_missed_cb (dds_rhc_sharded_shard (rhc[k], j), rand_texp());
+          }
+        }
         ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
 #endif
         break;
@@ -902,6 +923,182 @@ static void test_conditions (dds_entity_t pp, dds_entity_t tp, const int count,
     fwr (wr[i]);
 }
 
+/* Throughput benchmark: a number of threads storing samples in distinct instances, as
+   multiple delivery threads would do, while another thread takes them, comparing the
+   default RHC with the sharded one for various numbers of shards */
+
+#define BENCH_NSTORERS 4
+#define BENCH_NKEYS 4096
+
+struct bench_arg {
+  struct ddsi_domaingv *gv;
+  struct dds_rhc *rhc;
+  struct ddsi_serdata **sd;
+  struct ddsi_tkmap_instance **tk;
+  struct ddsi_writer_info wrinfo;
+  uint32_t idx;
+  ddsrt_atomic_uint32_t *stop;
+  uint64_t count;
+};
+
+static dds_return_t bench_count_sample (void *varg, const dds_sample_info_t *si, const struct ddsi_sertype *st, struct ddsi_serdata *sd)
+{
+  (void) si; (void) st; (void) sd;
+  uint64_t *count = varg;
+  (*count)++;
+  return DDS_RETCODE_OK;
+}
+
+static uint32_t bench_storer (void *varg)
+{
+  struct bench_arg * const arg = varg;
+  struct ddsi_thread_state * const thrst = ddsi_lookup_thread_state ();
+  uint64_t n = 0;
+  uint32_t k = arg->idx;
+  while (!ddsrt_atomic_ld32 (arg->stop))
+  {
+    ddsi_thread_state_awake (thrst, arg->gv);
+    for (int i = 0; i < 1000; i++)
+    {
+      (void) dds_rhc_store (arg->rhc, &arg->wrinfo, arg->sd[k], arg->tk[k]);
+      if ((k += BENCH_NSTORERS) >= BENCH_NKEYS)
+        k = arg->idx;
+    }
+    ddsi_thread_state_asleep (thrst);
+    n += 1000;
+  }
+  arg->count = n;
+  return 0;
+}
+
+static uint32_t bench_taker (void *varg)
+{
+  struct bench_arg * const arg = varg;
+  struct ddsi_thread_state * const thrst = ddsi_lookup_thread_state ();
+  uint64_t n = 0;
+  while (!ddsrt_atomic_ld32 (arg->stop))
+  {
+    ddsi_thread_state_awake (thrst, arg->gv);
+    (void) dds_rhc_take (arg->rhc, 256, DDS_ANY_SAMPLE_STATE | DDS_ANY_VIEW_STATE | DDS_ANY_INSTANCE_STATE, 0, NULL, bench_count_sample, &n);
+    ddsi_thread_state_asleep (thrst);
+  }
+  arg->count = n;
+  return 0;
+}
+
+static void bench_run (struct ddsi_domaingv *gv, uint32_t nshards, double duration, struct ddsi_serdata **sd, struct ddsi_tkmap_instance **tk, double *mstores, double *mtakes)
+{
+  dds_qos_t rqos;
+  ddsi_xqos_init_empty (&rqos);
+  ddsi_xqos_mergein_missing (&rqos, &ddsi_default_qos_reader, ~(uint64_t)0);
+  ddsi_thread_state_awake_domain_ok (ddsi_lookup_thread_state ());
+  struct dds_rhc *rhc = (nshards <= 1) ? dds_rhc_default_new_xchecks (NULL, gv, mdtype, false) : dds_rhc_sharded_new_xchecks (NULL, gv, mdtype, nshards, false);
+  dds_rhc_set_qos (rhc, &rqos);
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+  ddsi_xqos_fini (&rqos);
+
+  ddsrt_atomic_uint32_t stop = DDSRT_ATOMIC_UINT32_INIT (0);
+  struct ddsi_proxy_writer *wr[BENCH_NSTORERS];
+  struct bench_arg args[BENCH_NSTORERS + 1];
+  ddsrt_thread_t tids[BENCH_NSTORERS + 1];
+  ddsrt_threadattr_t tattr;
+  ddsrt_threadattr_init (&tattr);
+  for (uint32_t i = 0; i <= BENCH_NSTORERS; i++)
+  {
+    args[i] = (struct bench_arg) { .gv = gv, .rhc = rhc, .sd = sd, .tk = tk, .idx = i, .stop = &stop, .count = 0 };
+    if (i < BENCH_NSTORERS)
+    {
+      wr[i] = mkwr (0);
+      args[i].wrinfo.auto_dispose = false;
+      args[i].wrinfo.guid = wr[i]->e.guid;
+      args[i].wrinfo.iid = wr[i]->e.iid;
+      args[i].wrinfo.ownership_strength = 0;
+#ifdef DDS_HAS_LIFESPAN
+      args[i].wrinfo.lifespan_exp = DDSRT_MTIME_NEVER;
+#endif
+    }
+  }
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i <= BENCH_NSTORERS; i++)
+    if (ddsrt_thread_create (&tids[i], (i < BENCH_NSTORERS) ? "storer" : "taker", &tattr, (i < BENCH_NSTORERS) ? bench_storer : bench_taker, &args[i]) != 0)
+      abort ();
+  dds_sleepfor ((dds_duration_t) (duration * 1e9));
+  ddsrt_atomic_st32 (&stop, 1);
+  uint64_t nstored = 0;
+  for (uint32_t i = 0; i <= BENCH_NSTORERS; i++)
+  {
+    (void) ddsrt_thread_join (tids[i], NULL);
+    if (i < BENCH_NSTORERS)
+      nstored += args[i].count;
+  }
+  const double dt = (double) (dds_time () - t0) / 1e9;
+  *mstores = (double) nstored / dt / 1e6;
+  *mtakes = (double) args[BENCH_NSTORERS].count / dt / 1e6;
+  frhc (rhc);
+  for (uint32_t i = 0; i < BENCH_NSTORERS; i++)
+    fwr (wr[i]);
+}
+
+static int bench_main (int argc, char **argv)
+{
+  static const uint32_t default_nshards[] = { 1, 2, 4, 8, 16 };
+  double duration = 1.0;
+  if (argc > 1)
+    duration = atof (argv[1]);
+  if (duration <= 0.0)
+  {
+    fprintf (stderr, "usage: rhc_torture bench [SECONDS [NSHARDS...]]\n");
+    return 1;
+  }
+
+  ddsrt_init ();
+  dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  dds_entity_t tp = dds_create_topic (pp, &RhcTypes_T_desc, "RhcTypes_T", NULL, NULL);
+  struct ddsi_domaingv *gv = get_gv (pp);
+  {
+    struct dds_topic *x;
+    if (dds_topic_pin (tp, &x) < 0) abort();
+    mdtype = ddsi_sertype_ref (x->m_stype);
+    dds_topic_unpin (x);
+  }
+
+  struct ddsi_serdata **sd = ddsrt_malloc (BENCH_NKEYS * sizeof (*sd));
+  struct ddsi_tkmap_instance **tk = ddsrt_malloc (BENCH_NKEYS * sizeof (*tk));
+  ddsi_thread_state_awake_domain_ok (ddsi_lookup_thread_state ());
+  for (int32_t k = 0; k < BENCH_NKEYS; k++)
+  {
+    sd[k] = mksample (k, 0);
+    tk[k] = ddsi_tkmap_lookup_instance_ref (gv->m_tkmap, sd[k]);
+  }
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+
+  printf ("%8s %16s %16s\n", "nshards", "stored(M/s)", "taken(M/s)");
+  const int nn = (argc > 2) ? argc - 2 : (int) (sizeof (default_nshards) / sizeof (default_nshards[0]));
+  for (int i = 0; i < nn; i++)
+  {
+    const uint32_t n = (argc > 2) ? (uint32_t) atoi (argv[i + 2]) : default_nshards[i];
+    double mstores, mtakes;
+    if (n == 0)
+      continue;
+    bench_run (gv, n, duration, sd, tk, &mstores, &mtakes);
+    printf ("%8"PRIu32" %16.2f %16.2f\n", n, mstores, mtakes);
+  }
+
+  ddsi_thread_state_awake_domain_ok (ddsi_lookup_thread_state ());
+  for (int32_t k = 0; k < BENCH_NKEYS; k++)
+  {
+    ddsi_tkmap_instance_unref (gv->m_tkmap, tk[k]);
+    ddsi_serdata_unref (sd[k]);
+  }
+  ddsi_thread_state_asleep (ddsi_lookup_thread_state ());
+  ddsrt_free (tk);
+  ddsrt_free (sd);
+  ddsi_sertype_unref (mdtype);
+  dds_delete (pp);
+  ddsrt_fini ();
+  return 0;
+}
+
 struct stacktracethread_arg {
   dds_time_t when;
   dds_time_t period;
@@ -935,6 +1132,9 @@ static uint32_t stacktracethread (void *varg)
 
 int main (int argc, char **argv)
 {
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    return bench_main (argc - 1, argv + 1);
+
   ddsrt_init ();
   dds_entity_t pp = dds_create_participant(DDS_DOMAIN_DEFAULT, NULL, NULL);
   dds_entity_t tp = dds_create_topic(pp, &RhcTypes_T_desc, "RhcTypes_T", NULL, NULL);
@@ -0,0 +1,214 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Micro-benchmark for the wake-up cost of the socket waitset as a function of
+// the number of sockets in it.  It compares the waitset backend selected for
+// the platform (epoll on Linux, kqueue on macOS) with a loop that does what the
+// select-based backend does: fill an fd_set with all sockets, select() and
+// scan the set for the ready ones.
+//
+// Usage: sockwaitset_bench [ITERATIONS [NSOCKS...]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/cdtors.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/sockets.h"
+#include "dds/ddsrt/time.h"
+#include "ddsi__tran.h"
+#include "ddsi__sockwaitset.h"
+
+struct fake_conn {
+  struct ddsi_tran_conn c;
+  ddsrt_socket_t sock;
+  struct sockaddr_in addr;
+};
+
+static ddsrt_socket_t fake_conn_handle (struct ddsi_tran_base *base)
+{
+  return ((struct fake_conn *) base)->sock;
+}
+
+static struct fake_conn *make_conns (uint32_t n)
+{
+  struct fake_conn *conns = ddsrt_malloc (n * sizeof (*conns));
+  for (uint32_t i = 0; i < n; i++)
+  {
+    struct fake_conn * const fc = &conns[i];
+    socklen_t addrlen = sizeof (fc->addr);
+    memset (fc, 0, sizeof (*fc));
+    fc->c.m_base.m_handle_fn = fake_conn_handle;
+    fc->addr.sin_family = AF_INET;
+    fc->addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    if (ddsrt_socket (&fc->sock, AF_INET, SOCK_DGRAM, 0) != DDS_RETCODE_OK ||
+        ddsrt_bind (fc->sock, (struct sockaddr *) &fc->addr, sizeof (fc->addr)) != DDS_RETCODE_OK ||
+        ddsrt_getsockname (fc->sock, (struct sockaddr *) &fc->addr, &addrlen) != DDS_RETCODE_OK)
+    {
+      fprintf (stderr, "failed to create socket %"PRIu32" (too many open files?)\n", i);
+      exit (2);
+    }
+  }
+  return conns;
+}
+
+static void free_conns (struct fake_conn *conns, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    ddsrt_close (conns[i].sock);
+  ddsrt_free (conns);
+}
+
+static void send_to (ddsrt_socket_t sender, const struct fake_conn *fc)
+{
+  char buf = 0;
+  ssize_t sent;
+  if (ddsrt_connect (sender, (const struct sockaddr *) &fc->addr, sizeof (fc->addr)) != DDS_RETCODE_OK ||
+      ddsrt_send (sender, &buf, 1, 0, &sent) != DDS_RETCODE_OK)
+  {
+    fprintf (stderr, "send failed\n");
+    exit (2);
+  }
+}
+
+static void drain (const struct fake_conn *fc)
+{
+  char buf;
+  ssize_t rcvd;
+  if (ddsrt_recv (fc->sock, &buf, 1, 0, &rcvd) != DDS_RETCODE_OK)
+  {
+    fprintf (stderr, "recv failed\n");
+    exit (2);
+  }
+}
+
+// Time is measured from just before blocking until the ready connection has been
+// identified, the cost of sending the datagram is excluded
+static double bench_waitset (ddsrt_socket_t sender, struct fake_conn *conns, uint32_t n, uint32_t iters, ddsrt_prng_t *prng)
+{
+  struct ddsi_sock_waitset *ws = ddsi_sock_waitset_new ();
+  int64_t tsum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    (void) ddsi_sock_waitset_add (ws, &conns[i].c);
+  for (uint32_t it = 0; it < iters; it++)
+  {
+    const uint32_t k = ddsrt_prng_random (prng) % n;
+    struct ddsi_sock_waitset_ctx *ctx;
+    struct ddsi_tran_conn *conn;
+    uint32_t found = 0;
+    send_to (sender, &conns[k]);
+    const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+    while (found == 0)
+    {
+      if ((ctx = ddsi_sock_waitset_wait (ws)) == NULL)
+        continue;
+      while (ddsi_sock_waitset_next_event (ctx, &conn) >= 0)
+      {
+        if (found++ == 0)
+          tsum += ddsrt_time_monotonic ().v - t0.v;
+        drain ((struct fake_conn *) conn);
+      }
+    }
+  }
+  ddsi_sock_waitset_free (ws);
+  return (double) tsum / iters;
+}
+
+static double bench_select (ddsrt_socket_t sender, struct fake_conn *conns, uint32_t n, uint32_t iters, ddsrt_prng_t *prng)
+{
+  int64_t tsum = 0;
+  int32_t fdmax_plus_1 = 0;
+#if !_WIN32
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (conns[i].sock >= FD_SETSIZE)
+      return -1.0;
+    if ((int32_t) conns[i].sock >= fdmax_plus_1)
+      fdmax_plus_1 = (int32_t) conns[i].sock + 1;
+  }
+#else
+  if (n >= FD_SETSIZE)
+    return -1.0;
+#endif
+  for (uint32_t it = 0; it < iters; it++)
+  {
+    const uint32_t k = ddsrt_prng_random (prng) % n;
+    uint32_t found = 0;
+    fd_set rdset;
+    send_to (sender, &conns[k]);
+    const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+    while (found == 0)
+    {
+      FD_ZERO (&rdset);
+      for (uint32_t i = 0; i < n; i++)
+        FD_SET (conns[i].sock, &rdset);
+      if (ddsrt_select (fdmax_plus_1, &rdset, NULL, NULL, DDS_INFINITY) <= 0)
+        continue;
+      for (uint32_t i = 0; i < n; i++)
+      {
+        if (FD_ISSET (conns[i].sock, &rdset))
+        {
+          if (found++ == 0)
+            tsum += ddsrt_time_monotonic ().v - t0.v;
+          drain (&conns[i]);
+        }
+      }
+    }
+  }
+  return (double) tsum / iters;
+}
+
+int main (int argc, char **argv)
+{
+  static const uint32_t default_nsocks[] = { 8, 32, 128, 512, 900 };
+  uint32_t iters = 10000;
+  ddsrt_prng_t prng;
+  ddsrt_socket_t sender;
+
+  if (argc > 1)
+    iters = (uint32_t) atoi (argv[1]);
+  if (iters == 0)
+  {
+    fprintf (stderr, "usage: %s [ITERATIONS [NSOCKS...]]\n", argv[0]);
+    return 1;
+  }
+
+  ddsrt_init ();
+  ddsrt_prng_init_simple (&prng, 314159265);
+  if (ddsrt_socket (&sender, AF_INET, SOCK_DGRAM, 0) != DDS_RETCODE_OK)
+  {
+    fprintf (stderr, "failed to create sender socket\n");
+    return 2;
+  }
+
+  printf ("%8s %14s %14s\n", "nsocks", "waitset(ns)", "select(ns)");
+  const int nn = (argc > 2) ? argc - 2 : (int) (sizeof (default_nsocks) / sizeof (default_nsocks[0]));
+  for (int i = 0; i < nn; i++)
+  {
+    const uint32_t n = (argc > 2) ? (uint32_t) atoi (argv[i + 2]) : default_nsocks[i];
+    if (n == 0)
+      continue;
+    struct fake_conn *conns = make_conns (n);
+    const double tws = bench_waitset (sender, conns, n, iters, &prng);
+    const double tsel = bench_select (sender, conns, n, iters, &prng);
+    if (tsel < 0)
+      printf ("%8"PRIu32" %14.0f %14s\n", n, tws, "n/a");
+    else
+      printf ("%8"PRIu32" %14.0f %14.0f\n", n, tws, tsel);
+    free_conns (conns, n);
+  }
+
+  ddsrt_close (sender);
+  ddsrt_fini ();
+  return 0;
+}
@@ -20,6 +20,7 @@
 #include "dds/ddsrt/bits.h"
 #include "dds/ddsrt/md5.h"
 #include "dds/ddsrt/mh3.h"
+#include "dds/ddsrt/slab.h"
 #include "dds/ddsrt/environ.h"
 #include "dds/ddsrt/threads.h"
 #include "dds/ddsrt/process.h"
@@ -89,6 +90,7 @@
 #include "dds/ddsc/dds_psmx.h"
 
 #include "dds/cdr/dds_cdrstream.h"
+#include "dds/cdr/dds_cdrstream_simd.h"
 
 #include "dds__write.h"
 #include "dds__writer.h"
@@ -180,6 +182,7 @@ int main (int argc, char **argv)
   dds_get_type_name (1, ptr, 0);
   dds_set_topic_filter_and_arg (1, 0, ptr);
   dds_set_topic_filter_extended (1, ptr);
+  dds_set_topic_filter_expression (1, ptr, 0, ptr2);
   dds_get_topic_filter_and_arg (1, ptr, ptr);
   dds_get_topic_filter_extended (1, ptr);
   dds_create_subscriber (1, ptr, ptr);
@@ -206,6 +209,8 @@ int main (int argc, char **argv)
   dds_dispose_ih_ts (1, 1, 0);
   dds_write (1, ptr);
   dds_write_flush (1);
+  dds_begin_batch ();
+  dds_end_batch ();
   dds_writecdr (1, ptr);
   dds_forwardcdr (1, ptr);
   dds_write_ts (1, ptr, 0);
@@ -496,6 +501,7 @@ int main (int argc, char **argv)
   dds_ostreamLE_fini (ptr, ptr2);
   dds_ostreamBE_init (ptr, ptr2, 0, 0);
   dds_ostreamBE_fini (ptr, ptr2);
+  dds_ostream_grow (ptr, ptr2, 0);
 
   ret_cdrs = dds_stream_normalize (ptr, 0, 0, 0, ptr2, 0, ptr3);
   (void) ret_cdrs;
@@ -519,6 +525,10 @@ int main (int argc, char **argv)
   dds_stream_read_sample (ptr, ptr2, ptr3, ptr4);
   dds_stream_free_sample (ptr, ptr2, ptr3);
   dds_stream_countops (ptr, 0, ptr2);
+  dds_stream_member_adr (ptr, 0, 0);
+  dds_stream_base_type_ops (ptr);
+  dds_stream_locate_members (ptr, ptr2, 0, ptr3, ptr4);
+  dds_stream_member_address (ptr, ptr2, ptr3);
   dds_stream_print_key (ptr, ptr2, ptr3, 0);
   dds_stream_print_sample (ptr, ptr2, ptr3, 0);
 
@@ -530,6 +540,19 @@ int main (int argc, char **argv)
   dds_cdrstream_desc_init (ptr, ptr2, 0, 0, 0, ptr3, ptr4, 0);
   dds_cdrstream_desc_fini (ptr, ptr2);
 
+  // dds_cdrstream_simd.h
+  dds_stream_simd_supported (0);
+  dds_stream_simd_get ();
+  dds_stream_simd_set (0);
+  dds_stream_simd_name (0);
+  dds_stream_simd_bswap (ptr, 0, 0);
+  dds_stream_simd_bswap_copy (ptr, ptr2, 0, 0);
+  dds_stream_simd_clamp_bool (ptr, 0);
+  ret_cdrs = dds_stream_simd_check_max (ptr, 0, 0, 0, 0);
+  (void) ret_cdrs;
+  ret_cdrs = dds_stream_simd_check_bitmask (ptr, 0, 0, 0, 0, 0);
+  (void) ret_cdrs;
+
   // dds_psmx.h
   dds_add_psmx_endpoint_to_list (ptr, ptr2);
   dds_add_psmx_topic_to_list (ptr, ptr2);
@@ -732,6 +755,7 @@ int main (int argc, char **argv)
   ddsi_typemap_fini (ptr);
   ddsi_typemap_equal (ptr, ptr);
   ddsi_typemap_get_type_name (ptr, ptr2);
+  ddsi_typemap_resolve_member (ptr, ptr2, ptr3, ptr4, ptr5, ptr6);
   ddsi_type_lookup (ptr, ptr);
   ddsi_type_compare (ptr, ptr);
   ddsi_type_ref (ptr, ptr2, ptr3);
@@ -788,6 +812,7 @@ int main (int argc, char **argv)
   (void) ddsi_xpack_new (ptr, false);
   ddsi_xpack_free (ptr);
   ddsi_xpack_send (ptr, false);
+  (void) ddsi_xpack_is_empty (ptr);
 
   // ddsi/ddsi_guid.h
   ddsi_hton_guid ((ddsi_guid_t) { 0 });
@@ -907,6 +932,13 @@ int main (int argc, char **argv)
 
   // ddsrt/mh3.h
   ddsrt_mh3 (ptr, 0, 0);
+  ddsrt_mh3_128 (ptr, 0, 0, ptr2);
+
+  // ddsrt/slab.h
+  ddsrt_slab_malloc (0);
+  ddsrt_slab_realloc (ptr, 0);
+  ddsrt_slab_free (ptr);
+  ddsrt_slab_get_stats (ptr);
 
   // ddsrt/hopscotch.h
   ddsrt_hh_new (0, ptr, ptr);
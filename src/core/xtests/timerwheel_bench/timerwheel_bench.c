@@ -0,0 +1,157 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Micro-benchmark comparing the timer wheel with the fibonacci heap it replaced for
+// lifespan and lease expiry.  For N timers with expiry times spread over 10s it
+// measures: inserting all of them, rescheduling random timers (what happens when
+// each write renews a timer), and advancing time in 1ms steps until all timers
+// have expired.
+//
+// Usage: timerwheel_bench [NTIMERS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/time.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/fibheap.h"
+#include "dds/ddsrt/timerwheel.h"
+
+#define SPREAD DDS_SECS (10)
+#define STEP DDS_MSECS (1)
+
+struct timer {
+  ddsrt_timerwheel_node_t twnode;
+  ddsrt_fibheap_node_t fhnode;
+  int64_t texp;
+};
+
+static int compare_timer (const void *va, const void *vb)
+{
+  const struct timer *a = va;
+  const struct timer *b = vb;
+  return (a->texp == b->texp) ? 0 : (a->texp < b->texp) ? -1 : 1;
+}
+
+static const ddsrt_fibheap_def_t timer_fhdef = DDSRT_FIBHEAPDEF_INITIALIZER (offsetof (struct timer, fhnode), compare_timer);
+
+struct result {
+  double insert, resched, expire; // ns per timer
+};
+
+static int64_t random_texp (ddsrt_prng_t *prng, int64_t tbase)
+{
+  return tbase + (int64_t) (ddsrt_prng_random (prng) % (uint32_t) (SPREAD / DDS_USECS (1))) * DDS_USECS (1);
+}
+
+static double nsper (dds_time_t t0, uint32_t n)
+{
+  return (double) (dds_time () - t0) / (double) n;
+}
+
+static bool run_timerwheel (struct timer *ts, uint32_t n, struct result *res)
+{
+  ddsrt_prng_t prng;
+  ddsrt_timerwheel_t tw;
+  ddsrt_prng_init_simple (&prng, 1);
+  ddsrt_timerwheel_init (&tw);
+  dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    ts[i].texp = random_texp (&prng, SPREAD);
+    (void) ddsrt_timerwheel_insert (&tw, &ts[i].twnode, ts[i].texp);
+  }
+  res->insert = nsper (t0, n);
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    struct timer * const t = &ts[ddsrt_prng_random (&prng) % n];
+    ddsrt_timerwheel_delete (&tw, &t->twnode);
+    t->texp = random_texp (&prng, SPREAD);
+    (void) ddsrt_timerwheel_insert (&tw, &t->twnode, t->texp);
+  }
+  res->resched = nsper (t0, n);
+  t0 = dds_time ();
+  uint32_t nexp = 0;
+  for (int64_t tnow = SPREAD; tnow <= 2 * SPREAD + STEP; tnow += STEP)
+  {
+    ddsrt_timerwheel_node_t *twnode;
+    while ((twnode = ddsrt_timerwheel_extract_expired (&tw, tnow)) != NULL)
+      nexp++;
+  }
+  res->expire = nsper (t0, n);
+  ddsrt_timerwheel_fini (&tw);
+  return nexp == n;
+}
+
+static bool run_fibheap (struct timer *ts, uint32_t n, struct result *res)
+{
+  ddsrt_prng_t prng;
+  ddsrt_fibheap_t fh;
+  ddsrt_prng_init_simple (&prng, 1);
+  ddsrt_fibheap_init (&timer_fhdef, &fh);
+  dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    ts[i].texp = random_texp (&prng, SPREAD);
+    ddsrt_fibheap_insert (&timer_fhdef, &fh, &ts[i]);
+  }
+  res->insert = nsper (t0, n);
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    struct timer * const t = &ts[ddsrt_prng_random (&prng) % n];
+    ddsrt_fibheap_delete (&timer_fhdef, &fh, t);
+    t->texp = random_texp (&prng, SPREAD);
+    ddsrt_fibheap_insert (&timer_fhdef, &fh, t);
+  }
+  res->resched = nsper (t0, n);
+  t0 = dds_time ();
+  uint32_t nexp = 0;
+  for (int64_t tnow = SPREAD; tnow <= 2 * SPREAD + STEP; tnow += STEP)
+  {
+    struct timer *t;
+    while ((t = ddsrt_fibheap_min (&timer_fhdef, &fh)) != NULL && t->texp <= tnow)
+    {
+      ddsrt_fibheap_extract_min (&timer_fhdef, &fh);
+      nexp++;
+    }
+  }
+  res->expire = nsper (t0, n);
+  return nexp == n;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t n = 1000000;
+  if (argc > 2 || (argc == 2 && (n = (uint32_t) atoi (argv[1])) == 0))
+  {
+    fprintf (stderr, "usage: %s [NTIMERS]\n", argv[0]);
+    return 2;
+  }
+  struct timer *ts = ddsrt_malloc (n * sizeof (*ts));
+  struct result tw, fh;
+  bool ok = run_timerwheel (ts, n, &tw);
+  ok = run_fibheap (ts, n, &fh) && ok;
+  printf ("%"PRIu32" timers, ns/timer\n", n);
+  printf ("%-12s %10s %10s %10s\n", "", "insert", "resched", "expire");
+  printf ("%-12s %10.1f %10.1f %10.1f\n", "timerwheel", tw.insert, tw.resched, tw.expire);
+  printf ("%-12s %10.1f %10.1f %10.1f\n", "fibheap", fh.insert, fh.resched, fh.expire);
+  ddsrt_free (ts);
+  if (!ok)
+  {
+    fprintf (stderr, "not all timers expired\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+// Benchmark for the cost of maintaining a writer's address set during a
+// discovery storm.  It creates a writer in one domain instance and then
+// repeatedly creates N matching readers in a second domain instance in one
+// go, followed by deleting all of them at once.  For each N it does this
+// with a full recomputation of the address set on every change (the
+// WriterAddressSetRecomputeDelay set to 0) and with the default delayed
+// recomputation, and reports the time it takes the writer to see all
+// readers appear and disappear, together with the number of full and
+// incremental address set computations and the time spent on them as
+// reported by the writer's statistics.
+//
+// Usage: wraddrset_bench [ROUNDS [N...]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/process.h"
+#include "dds/ddsrt/time.h"
+#include "WraddrsetBenchTypes.h"
+
+#define DOMAINID_PUB 0
+#define DOMAINID_SUB 1
+#define CONFIG_FMT "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Discovery><ExternalDomainId>0</ExternalDomainId></Discovery><Internal><WriterAddressSetRecomputeDelay>%s</WriterAddressSetRecomputeDelay></Internal>"
+
+struct result {
+  double match_ms;
+  double unmatch_ms;
+  uint32_t rebuilds;
+  uint32_t updates;
+  double addrset_ms;
+};
+
+static dds_entity_t create_domain (dds_domainid_t id, const char *delay)
+{
+  char config[512];
+  (void) snprintf (config, sizeof (config), CONFIG_FMT, delay);
+  char *conf = ddsrt_expand_envvars (config, id);
+  const dds_entity_t dom = dds_create_domain (id, conf);
+  ddsrt_free (conf);
+  if (dom < 0)
+    fprintf (stderr, "dds_create_domain: %s\n", dds_strretcode (dom));
+  return dom;
+}
+
+static bool wait_for_matched (dds_entity_t wr, uint32_t expected)
+{
+  const dds_time_t tend = dds_time () + DDS_SECS (20);
+  dds_publication_matched_status_t st;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &st)) == DDS_RETCODE_OK && st.current_count != expected && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (1));
+  if (rc != DDS_RETCODE_OK || st.current_count != expected)
+  {
+    fprintf (stderr, "writer matched %"PRIu32" readers, expected %"PRIu32"\n", st.current_count, expected);
+    return false;
+  }
+  return true;
+}
+
+static bool storm (dds_entity_t pp, dds_entity_t tp, dds_entity_t wr, uint32_t n, const dds_qos_t *qos, struct result *res)
+{
+  const dds_entity_t sub = dds_create_subscriber (pp, NULL, NULL);
+  bool ok = (sub > 0);
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < n && ok; i++)
+    ok = (dds_create_reader (sub, tp, qos, NULL) > 0);
+  ok = ok && wait_for_matched (wr, n);
+  const dds_time_t t1 = dds_time ();
+  // deleting the subscriber deletes all readers in one go
+  ok = ok && (dds_delete (sub) == 0);
+  ok = ok && wait_for_matched (wr, 0);
+  const dds_time_t t2 = dds_time ();
+  res->match_ms += (double) (t1 - t0) / 1e6;
+  res->unmatch_ms += (double) (t2 - t1) / 1e6;
+  return ok;
+}
+
+static bool run (uint32_t n, uint32_t rounds, const char *delay, struct result *res)
+{
+  const dds_entity_t dom_pub = create_domain (DOMAINID_PUB, delay);
+  const dds_entity_t dom_sub = create_domain (DOMAINID_SUB, delay);
+  bool ok = (dom_pub > 0 && dom_sub > 0);
+
+  char topicname[100];
+  (void) snprintf (topicname, sizeof (topicname), "wraddrset_bench_%"PRIdPID"_%"PRId64, ddsrt_getpid (), dds_time ());
+  const dds_entity_t pp_pub = ok ? dds_create_participant (DOMAINID_PUB, NULL, NULL) : 0;
+  const dds_entity_t pp_sub = ok ? dds_create_participant (DOMAINID_SUB, NULL, NULL) : 0;
+  ok = ok && pp_pub > 0 && pp_sub > 0;
+  const dds_entity_t tp_pub = ok ? dds_create_topic (pp_pub, &WraddrsetBench_Msg_desc, topicname, NULL, NULL) : 0;
+  const dds_entity_t tp_sub = ok ? dds_create_topic (pp_sub, &WraddrsetBench_Msg_desc, topicname, NULL, NULL) : 0;
+  ok = ok && tp_pub > 0 && tp_sub > 0;
+
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (1));
+  const dds_entity_t wr = ok ? dds_create_writer (pp_pub, tp_pub, qos, NULL) : 0;
+  ok = ok && wr > 0;
+
+  res->match_ms = res->unmatch_ms = 0.0;
+  for (uint32_t r = 0; r < rounds && ok; r++)
+    ok = storm (pp_sub, tp_sub, wr, n, qos, res);
+  dds_delete_qos (qos);
+
+  if (ok)
+  {
+    // give a pending delayed recomputation the opportunity to run, so that it is included
+    dds_sleepfor (DDS_MSECS (300));
+    struct dds_statistics *stat = dds_create_statistics (wr);
+    const struct dds_stat_keyvalue *rebuilds = dds_lookup_statistic (stat, "addrset_rebuild_count");
+    const struct dds_stat_keyvalue *updates = dds_lookup_statistic (stat, "addrset_update_count");
+    const struct dds_stat_keyvalue *t = dds_lookup_statistic (stat, "time_addrset");
+    res->rebuilds = rebuilds->u.u32;
+    res->updates = updates->u.u32;
+    res->addrset_ms = (double) t->u.u64 / 1e6;
+    dds_delete_statistics (stat);
+  }
+
+  if (dom_sub > 0)
+    dds_delete (dom_sub);
+  if (dom_pub > 0)
+    dds_delete (dom_pub);
+  return ok;
+}
+
+int main (int argc, char **argv)
+{
+  static const uint32_t default_sizes[] = { 100, 500, 1000 };
+  static const char *delays[] = { "0 ms", "100 ms" };
+  uint32_t rounds = 5;
+
+  if (argc > 1 && (rounds = (uint32_t) atoi (argv[1])) == 0)
+  {
+    fprintf (stderr, "usage: %s [ROUNDS [N...]]\n", argv[0]);
+    return 1;
+  }
+
+  printf ("%8s %8s %12s %12s %9s %9s %12s\n", "N", "delay", "match(ms)", "unmatch(ms)", "rebuilds", "updates", "addrset(ms)");
+  const int nn = (argc > 2) ? argc - 2 : (int) (sizeof (default_sizes) / sizeof (default_sizes[0]));
+  for (int i = 0; i < nn; i++)
+  {
+    const uint32_t n = (argc > 2) ? (uint32_t) atoi (argv[i + 2]) : default_sizes[i];
+    for (size_t j = 0; j < sizeof (delays) / sizeof (delays[0]); j++)
+    {
+      struct result res;
+      if (!run (n, rounds, delays[j], &res))
+        return 2;
+      printf ("%8"PRIu32" %8s %12.1f %12.1f %9"PRIu32" %9"PRIu32" %12.1f\n",
+              n, delays[j], res.match_ms / rounds, res.unmatch_ms / rounds, res.rebuilds, res.updates, res.addrset_ms);
+      fflush (stdout);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSRT_SLAB_H
+#define DDSRT_SLAB_H
+
+/** @file slab.h
+  A process-wide allocator for short-lived, frequently allocated blocks of memory such as
+  serialized samples and messages, that recycles blocks instead of returning them to the heap.
+
+  Requests are rounded up to one of DDSRT_SLAB_NCLASSES size classes (powers of two from
+  DDSRT_SLAB_MIN_SIZE up to DDSRT_SLAB_MAX_SIZE), larger requests are passed on to the heap.
+  Each thread keeps a small cache of free blocks per size class, so that allocating and freeing
+  normally involves no locking at all.  When a thread's cache for a class overflows, half of it
+  is moved to a shared depot, from which threads refill their caches when they run empty.  This
+  is what makes it efficient for one thread to free what another allocated, the typical case for
+  data travelling from an application thread through the network stack.  The depot is bounded,
+  the excess is returned to the heap.
+
+  Blocks can be freed and reallocated by any thread, but only with the functions in this file.
+  The caches are released when the thread terminates or, at the latest, by ddsrt_fini.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dds/export.h"
+#include "dds/ddsrt/attributes.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#define DDSRT_SLAB_MIN_SIZE_LG2 6 ///< log2 of the size of the smallest class
+#define DDSRT_SLAB_NCLASSES 11 ///< number of size classes
+#define DDSRT_SLAB_MIN_SIZE ((size_t) 1 << DDSRT_SLAB_MIN_SIZE_LG2) ///< size of the smallest class (64 B)
+#define DDSRT_SLAB_MAX_SIZE ((size_t) 1 << (DDSRT_SLAB_MIN_SIZE_LG2 + DDSRT_SLAB_NCLASSES - 1)) ///< size of the largest class (64 kB)
+
+/// @brief Usage of one size class
+typedef struct ddsrt_slab_class_stats {
+  size_t size; ///< largest request served by this class
+  uint32_t nblocks; ///< number of blocks currently allocated from the heap, whether in use or cached
+  uint32_t ndepot; ///< number of free blocks in the shared depot
+  uint64_t nheap; ///< total number of times a block had to be allocated from the heap
+} ddsrt_slab_class_stats_t;
+
+/**
+ * @brief Allocate a block of memory
+ *
+ * The block is suitably aligned for any type.
+ *
+ * @param[in] size the size of the block in bytes
+ * @returns a pointer to the block. abort() is called if not enough free memory was available.
+ */
+DDS_EXPORT void *ddsrt_slab_malloc (size_t size)
+  ddsrt_attribute_malloc
+  ddsrt_attribute_alloc_size ((1));
+
+/**
+ * @brief Change the size of a block of memory
+ *
+ * Like realloc, the contents are preserved up to the lesser of the old and new sizes, and the
+ * block may move.  A block that still fits in its size class never moves.
+ *
+ * @param[in] ptr the block to resize, may be a null pointer
+ * @param[in] size the new size in bytes
+ * @returns a pointer to the resized block. abort() is called if not enough free memory was
+ *   available.
+ */
+DDS_EXPORT void *ddsrt_slab_realloc (void *ptr, size_t size)
+  ddsrt_attribute_alloc_size ((2));
+
+/**
+ * @brief Free a block of memory allocated with @ref ddsrt_slab_malloc or @ref ddsrt_slab_realloc
+ *
+ * @param[in] ptr the block to free, may be a null pointer
+ */
+DDS_EXPORT void ddsrt_slab_free (void *ptr);
+
+/**
+ * @brief Retrieve the usage of the size classes
+ *
+ * The numbers are collected without stopping other threads and are therefore only approximately
+ * consistent with each other.  Allocations and frees served by the per-thread caches are not
+ * counted, hence a constant nheap means no heap allocations are taking place.
+ *
+ * @param[out] stats usage for each size class, in order of increasing size
+ */
+DDS_EXPORT void ddsrt_slab_get_stats (ddsrt_slab_class_stats_t stats[DDSRT_SLAB_NCLASSES]);
+
+/** @brief Initialize the shared state, called by ddsrt_init */
+void ddsrt_slab_init (void);
+
+/** @brief Release the shared state, called by ddsrt_fini */
+void ddsrt_slab_fini (void);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSRT_SLAB_H */
@@ -242,6 +242,34 @@ ddsrt_sendmsg(
   int flags,
   ssize_t *sent);
 
+#if DDSRT_HAVE_SENDMMSG
+/**
+ * @brief Send multiple messages in a single call
+ *
+ * Only available if DDSRT_HAVE_SENDMMSG is set.  Like @ref ddsrt_sendmsg, but
+ * sends up to 'vlen' messages, setting the 'msg_len' field of each one sent to
+ * the number of bytes sent.  If an error occurs after at least one message has
+ * been sent, it returns OK with the number of messages sent, and the error is
+ * returned by the next call.
+ *
+ * @param[in] sock the socket
+ * @param[in,out] msgvec array of message headers
+ * @param[in] vlen number of entries in 'msgvec'
+ * @param[in] flags flags for special options
+ * @param[out] nsent number of messages sent (> 0 if return == OK, undefined if return != OK)
+ * @return a DDS_RETCODE (OK, ERROR, and more)
+ *
+ * See @ref ddsrt_sendmsg
+ */
+dds_return_t
+ddsrt_sendmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgvec,
+  unsigned int vlen,
+  int flags,
+  int *nsent);
+#endif
+
 /**
  * @brief Receive data into a buffer
  *
@@ -292,6 +320,34 @@ ddsrt_recvmsg(
   int flags,
   ssize_t *rcvd);
 
+#if DDSRT_HAVE_RECVMMSG
+/**
+ * @brief Receive multiple messages from a socket in a single call
+ *
+ * Only available if DDSRT_HAVE_RECVMMSG is set.  Like @ref ddsrt_recvmsg, but
+ * receives up to 'vlen' messages, setting the 'msg_len' field of each received
+ * one to the number of bytes received.  Setting MSG_WAITFORONE in 'flags' makes
+ * it block until at least one message is available, and then return whatever
+ * else is available without blocking.
+ *
+ * @param[in] sockext the (extended) socket
+ * @param[in,out] msgvec array of message headers
+ * @param[in] vlen number of entries in 'msgvec'
+ * @param[in] flags flags for special options
+ * @param[out] nrcvd number of messages received (> 0 if return == OK, undefined if return != OK)
+ * @return a DDS_RETCODE (OK, ERROR, TRY_AGAIN, BAD_PARAMETER, NO_CONNECTION, INTERRUPTED, OUT_OF_RESOURCES, ILLEGAL_OPERATION)
+ *
+ * See @ref ddsrt_recvmsg
+ */
+dds_return_t
+ddsrt_recvmmsg(
+  const ddsrt_socket_ext_t *sockext,
+  ddsrt_mmsghdr_t *msgvec,
+  unsigned int vlen,
+  int flags,
+  int *nrcvd);
+#endif
+
 /**
  * @brief Get options from the socket.
  *
@@ -96,6 +96,15 @@ typedef struct msghdr ddsrt_msghdr_t;
 # define DDSRT_MSGHDR_FLAGS 1
 #endif
 
+#if DDSRT_HAVE_RECVMMSG || DDSRT_HAVE_SENDMMSG
+/* Layout-compatible with struct mmsghdr, which is only declared if _GNU_SOURCE
+   is defined */
+typedef struct ddsrt_mmsghdr {
+  ddsrt_msghdr_t msg_hdr;
+  unsigned int msg_len;
+} ddsrt_mmsghdr_t;
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,144 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef DDSRT_TIMERWHEEL_H
+#define DDSRT_TIMERWHEEL_H
+
+/** @file timerwheel.h
+  A hierarchical timer wheel keeps a set of timers such that inserting and removing a timer is O(1),
+  while still making it possible to efficiently find the timers that have expired.
+
+  Time is divided in ticks of 2^DDSRT_TIMERWHEEL_TICK_BITS ns, and the expiry time of a timer is
+  rounded up to a tick.  A timer is therefore never reported as expired before its expiry time, but
+  it may be reported up to one tick late.  There are DDSRT_TIMERWHEEL_LEVELS levels of
+  DDSRT_TIMERWHEEL_SLOTS slots each, every level covering a DDSRT_TIMERWHEEL_SLOTS times longer
+  interval than the one below it, and timers that are further in the future than the top level
+  covers are kept in a separate list.  As time progresses timers migrate ("cascade") to lower
+  levels and eventually to the list of expired timers.  Each timer moves at most once per level,
+  and empty slots are skipped using a bitmap per level.
+
+  Unlike with a heap, the earliest expiry time is not known exactly, and @ref ddsrt_timerwheel_next
+  may return a time at which no timer expires yet.  It is intended for scheduling the next check.
+
+  The wheel itself does no locking.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dds/export.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#define DDSRT_TIMERWHEEL_TICK_BITS 16 ///< log2 of the resolution in ns (~65us)
+#define DDSRT_TIMERWHEEL_SLOT_BITS 6 ///< log2 of the number of slots per level
+#define DDSRT_TIMERWHEEL_SLOTS (1u << DDSRT_TIMERWHEEL_SLOT_BITS) ///< number of slots per level
+#define DDSRT_TIMERWHEEL_LEVELS 6 ///< number of levels, covering ~52 days
+
+/// @brief A timer, to be embedded in a user node
+///
+/// The node is only valid while it is in a timer wheel, there is no need to initialize it before
+/// inserting it.
+typedef struct ddsrt_timerwheel_node {
+  struct ddsrt_timerwheel_node *next; ///< next node in the same slot
+  struct ddsrt_timerwheel_node **pprev; ///< pointer to the pointer to this node
+  uint64_t tick; ///< expiry time, rounded up to a tick
+  uint32_t slot; ///< index of the slot the node is in
+} ddsrt_timerwheel_node_t;
+
+/// @brief The timer wheel
+typedef struct ddsrt_timerwheel {
+  uint64_t now; ///< current tick, timers with an expiry tick <= now are in the expired list
+  uint32_t count; ///< number of timers in the wheel
+  uint64_t occupied[DDSRT_TIMERWHEEL_LEVELS]; ///< bitmap of non-empty slots for each level
+  ddsrt_timerwheel_node_t **slots; ///< slots, overflow and expired lists, allocated on first use
+} ddsrt_timerwheel_t;
+
+/**
+ * @brief Initialize a timer wheel
+ *
+ * @param[out] tw the timer wheel
+ */
+DDS_EXPORT void ddsrt_timerwheel_init (ddsrt_timerwheel_t *tw);
+
+/**
+ * @brief Release the resources of an empty timer wheel
+ *
+ * @param[in,out] tw the timer wheel
+ */
+DDS_EXPORT void ddsrt_timerwheel_fini (ddsrt_timerwheel_t *tw);
+
+/**
+ * @brief Checks whether the timer wheel contains any timers
+ *
+ * @param[in] tw the timer wheel
+ * @return true iff the wheel contains no timers
+ */
+DDS_EXPORT bool ddsrt_timerwheel_empty (const ddsrt_timerwheel_t *tw);
+
+/**
+ * @brief Insert a timer in O(1)
+ *
+ * @param[in,out] tw the timer wheel
+ * @param[out] node the timer, which must not already be in a timer wheel
+ * @param[in] texp expiry time in ns, 0 <= texp
+ * @return the time at which the timer will be reported as expired by @ref ddsrt_timerwheel_peek_expired
+ */
+DDS_EXPORT int64_t ddsrt_timerwheel_insert (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node, int64_t texp);
+
+/**
+ * @brief Remove a timer in O(1)
+ *
+ * Removing a timer is allowed regardless of whether it has expired.
+ *
+ * @param[in,out] tw the timer wheel
+ * @param[in,out] node the timer, which must be in the timer wheel
+ */
+DDS_EXPORT void ddsrt_timerwheel_delete (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node);
+
+/**
+ * @brief Advance the timer wheel and return an expired timer, leaving it in the wheel
+ *
+ * The caller is expected to remove it using @ref ddsrt_timerwheel_delete before calling this
+ * function again. There is no ordering between the timers that have expired.
+ *
+ * @param[in,out] tw the timer wheel
+ * @param[in] tnow the current time in ns
+ * @return an expired timer or NULL if there are none
+ */
+DDS_EXPORT ddsrt_timerwheel_node_t *ddsrt_timerwheel_peek_expired (ddsrt_timerwheel_t *tw, int64_t tnow);
+
+/**
+ * @brief Advance the timer wheel and remove and return an expired timer
+ *
+ * @param[in,out] tw the timer wheel
+ * @param[in] tnow the current time in ns
+ * @return an expired timer, no longer in the wheel, or NULL if there are none
+ */
+DDS_EXPORT ddsrt_timerwheel_node_t *ddsrt_timerwheel_extract_expired (ddsrt_timerwheel_t *tw, int64_t tnow);
+
+/**
+ * @brief Time at which the timer wheel needs to be checked for expired timers
+ *
+ * This is a lower bound for the earliest expiry time, because for timers that are in the
+ * higher levels the wheel only knows the time at which they need to move to a lower level.
+ *
+ * @param[in] tw the timer wheel
+ * @return time in ns at or before which the first timer expires, INT64_MAX if the wheel is empty
+ */
+DDS_EXPORT int64_t ddsrt_timerwheel_next (const ddsrt_timerwheel_t *tw);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSRT_TIMERWHEEL_H */
@@ -14,6 +14,7 @@
 #include "dds/ddsrt/time.h"
 #include "dds/ddsrt/random.h"
 #include "dds/ddsrt/misc.h"
+#include "dds/ddsrt/slab.h"
 
 #if _WIN32
 /* Sockets API initialization is only necessary on Microsoft Windows. The
@@ -49,6 +50,7 @@ retry:
 #endif
     ddsrt_random_init();
     ddsrt_atomics_init();
+    ddsrt_slab_init();
     ddsrt_atomic_or32(&init_status, INIT_STATUS_OK);
   } else {
     while (v > 1 && !(v & INIT_STATUS_OK)) {
@@ -83,6 +85,7 @@ void ddsrt_fini (void)
   {
     ddsrt_cond_destroy(&init_cond);
     ddsrt_mutex_destroy(&init_mutex);
+    ddsrt_slab_fini();
     ddsrt_random_fini();
     ddsrt_atomics_fini();
 #if _WIN32
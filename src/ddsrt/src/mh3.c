@@ -8,9 +8,11 @@
 //
 // SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
 
+#include <string.h>
 #include "dds/ddsrt/mh3.h"
 
 #define DDSRT_MH3_ROTL32(x,r) (((x) << (r)) | ((x) >> (32 - (r))))
+#define DDSRT_MH3_ROTL64(x,r) (((x) << (r)) | ((x) >> (64 - (r))))
 
 // Really
 // http://code.google.com/p/smhasher/source/browse/trunk/MurmurHash3.cpp,
@@ -69,3 +71,97 @@ uint32_t ddsrt_mh3 (const void *key, size_t len, uint32_t seed)
   h1 ^= h1 >> 16;
   return h1;
 }
+
+static uint64_t fmix64 (uint64_t k)
+{
+  k ^= k >> 33;
+  k *= UINT64_C (0xff51afd7ed558ccd);
+  k ^= k >> 33;
+  k *= UINT64_C (0xc4ceb9fe1a85ec53);
+  k ^= k >> 33;
+  return k;
+}
+
+// Same source, MurmurHash3_x64_128
+
+void ddsrt_mh3_128 (const void *key, size_t len, uint32_t seed, uint64_t hash[2])
+{
+  const uint8_t *data = (const uint8_t *) key;
+  const size_t nblocks = len / 16;
+  const uint64_t c1 = UINT64_C (0x87c37b91114253d5);
+  const uint64_t c2 = UINT64_C (0x4cf5ad432745937f);
+
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+
+  for (size_t i = 0; i < nblocks; i++)
+  {
+    uint64_t k1, k2;
+    memcpy (&k1, data + 16 * i, sizeof (k1));
+    memcpy (&k2, data + 16 * i + 8, sizeof (k2));
+
+    k1 *= c1;
+    k1 = DDSRT_MH3_ROTL64 (k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+
+    h1 = DDSRT_MH3_ROTL64 (h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = DDSRT_MH3_ROTL64 (k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+
+    h2 = DDSRT_MH3_ROTL64 (h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  const uint8_t *tail = data + nblocks * 16;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+  switch (len & 15)
+  {
+    case 15: k2 ^= (uint64_t) tail[14] << 48; /* FALLS THROUGH */
+    case 14: k2 ^= (uint64_t) tail[13] << 40; /* FALLS THROUGH */
+    case 13: k2 ^= (uint64_t) tail[12] << 32; /* FALLS THROUGH */
+    case 12: k2 ^= (uint64_t) tail[11] << 24; /* FALLS THROUGH */
+    case 11: k2 ^= (uint64_t) tail[10] << 16; /* FALLS THROUGH */
+    case 10: k2 ^= (uint64_t) tail[9] << 8; /* FALLS THROUGH */
+    case 9:
+      k2 ^= (uint64_t) tail[8];
+      k2 *= c2;
+      k2 = DDSRT_MH3_ROTL64 (k2, 33);
+      k2 *= c1;
+      h2 ^= k2;
+      /* FALLS THROUGH */
+    case 8: k1 ^= (uint64_t) tail[7] << 56; /* FALLS THROUGH */
+    case 7: k1 ^= (uint64_t) tail[6] << 48; /* FALLS THROUGH */
+    case 6: k1 ^= (uint64_t) tail[5] << 40; /* FALLS THROUGH */
+    case 5: k1 ^= (uint64_t) tail[4] << 32; /* FALLS THROUGH */
+    case 4: k1 ^= (uint64_t) tail[3] << 24; /* FALLS THROUGH */
+    case 3: k1 ^= (uint64_t) tail[2] << 16; /* FALLS THROUGH */
+    case 2: k1 ^= (uint64_t) tail[1] << 8; /* FALLS THROUGH */
+    case 1:
+      k1 ^= (uint64_t) tail[0];
+      k1 *= c1;
+      k1 = DDSRT_MH3_ROTL64 (k1, 31);
+      k1 *= c2;
+      h1 ^= k1;
+      /* FALLS THROUGH */
+  }
+
+  /* finalization */
+  h1 ^= (uint64_t) len;
+  h2 ^= (uint64_t) len;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64 (h1);
+  h2 = fmix64 (h2);
+  h1 += h2;
+  h2 += h1;
+  hash[0] = h1;
+  hash[1] = h2;
+}
@@ -0,0 +1,374 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <string.h>
+
+#include "dds/ddsrt/slab.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/static_assert.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/threads.h"
+
+/* Every block is preceded by a header recording its size class, which is what allows freeing
+   and reallocating without being told the size.  The header is 16 bytes to preserve the
+   alignment guaranteed by malloc. */
+#define SLAB_LARGE DDSRT_SLAB_NCLASSES
+
+union slab_hdr {
+  uint32_t cls;
+  uint64_t align[2];
+};
+
+DDSRT_STATIC_ASSERT (sizeof (union slab_hdr) == 16);
+
+/* Free blocks are linked through their (otherwise unused) contents while in the depot */
+struct slab_free {
+  struct slab_free *next;
+};
+
+/* The per-thread cache holds at most this many blocks per class, and at most 128 kB per class
+   for the larger ones; the depot at most 4 MB per class, but at least 64 blocks */
+#define SLAB_MAG_MAX 32
+#define SLAB_MAG_MIN 4
+#define SLAB_MAG_BYTES ((size_t) 128 * 1024)
+#define SLAB_DEPOT_BYTES ((size_t) 4 * 1024 * 1024)
+#define SLAB_DEPOT_MIN 64
+
+struct slab_mag {
+  uint32_t n;
+  void *x[SLAB_MAG_MAX];
+};
+
+struct slab_tcache {
+  struct slab_tcache *prev, *next; // in slab_tcaches
+  struct slab_mag mag[DDSRT_SLAB_NCLASSES];
+};
+
+struct slab_depot {
+  ddsrt_mutex_t lock;
+  struct slab_free *first;
+  uint32_t n;
+  uint32_t nblocks;
+  uint64_t nheap;
+};
+
+static struct slab_depot slab_depots[DDSRT_SLAB_NCLASSES];
+static ddsrt_atomic_uint32_t slab_initialized = DDSRT_ATOMIC_UINT32_INIT (0);
+
+/* A thread's cache is created on the first allocation or free while ddsrt is initialized, and
+   flushed to the depot when the thread terminates.  Not every thread terminates in a way that
+   runs cleanup handlers (the main thread being the obvious one), so all caches are also kept in
+   a list, and ddsrt_slab_fini frees whatever caches remain.
+
+   A thread can't be told its cache has been freed, instead each initialization starts a new
+   generation and a cache is valid only in the generation in which it was created.  Cleanup
+   handlers may still allocate and free memory after the cache has been flushed, those go
+   straight to the depot or, if ddsrt has been deinitialized in the meantime, to the heap. */
+static ddsrt_mutex_t slab_tcaches_lock;
+static struct slab_tcache *slab_tcaches;
+static ddsrt_atomic_uint32_t slab_generation = DDSRT_ATOMIC_UINT32_INIT (0);
+static ddsrt_thread_local struct slab_tcache *slab_tcache;
+static ddsrt_thread_local uint32_t slab_tcache_generation;
+static ddsrt_thread_local bool slab_tcache_cleanup_pushed;
+static ddsrt_thread_local bool slab_tcache_gone;
+
+static size_t class_size (uint32_t cls)
+{
+  return DDSRT_SLAB_MIN_SIZE << cls;
+}
+
+static uint32_t class_magsize (uint32_t cls)
+{
+  const size_t n = SLAB_MAG_BYTES / class_size (cls);
+  return (n > SLAB_MAG_MAX) ? SLAB_MAG_MAX : (n < SLAB_MAG_MIN) ? SLAB_MAG_MIN : (uint32_t) n;
+}
+
+static uint32_t class_depotsize (uint32_t cls)
+{
+  const size_t n = SLAB_DEPOT_BYTES / class_size (cls);
+  return (n < SLAB_DEPOT_MIN) ? SLAB_DEPOT_MIN : (uint32_t) n;
+}
+
+static uint32_t size_to_class (size_t size)
+{
+  if (size <= DDSRT_SLAB_MIN_SIZE)
+    return 0;
+  else if (size > DDSRT_SLAB_MAX_SIZE)
+    return SLAB_LARGE;
+  else
+  {
+    uint32_t cls = 0;
+    size_t s = (size - 1) >> DDSRT_SLAB_MIN_SIZE_LG2;
+    while (s)
+    {
+      cls++;
+      s >>= 1;
+    }
+    assert (size <= class_size (cls) && (cls == 0 || size > class_size (cls - 1)));
+    return cls;
+  }
+}
+
+static union slab_hdr *hdr_of (void *ptr)
+{
+  return (union slab_hdr *) ptr - 1;
+}
+
+void ddsrt_slab_init (void)
+{
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+  {
+    struct slab_depot * const dp = &slab_depots[i];
+    ddsrt_mutex_init (&dp->lock);
+    dp->first = NULL;
+    dp->n = 0;
+    dp->nblocks = 0;
+    dp->nheap = 0;
+  }
+  ddsrt_mutex_init (&slab_tcaches_lock);
+  slab_tcaches = NULL;
+  ddsrt_atomic_inc32 (&slab_generation);
+  ddsrt_atomic_st32 (&slab_initialized, 1);
+}
+
+void ddsrt_slab_fini (void)
+{
+  ddsrt_atomic_st32 (&slab_initialized, 0);
+  // remaining caches belong to threads that haven't terminated (yet): their blocks are
+  // returned to the heap and the generation check prevents them from using the cache
+  struct slab_tcache *tc;
+  while ((tc = slab_tcaches) != NULL)
+  {
+    slab_tcaches = tc->next;
+    for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+      for (uint32_t j = 0; j < tc->mag[i].n; j++)
+        ddsrt_free (hdr_of (tc->mag[i].x[j]));
+    ddsrt_free (tc);
+  }
+  ddsrt_mutex_destroy (&slab_tcaches_lock);
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+  {
+    struct slab_depot * const dp = &slab_depots[i];
+    struct slab_free *b;
+    while ((b = dp->first) != NULL)
+    {
+      dp->first = b->next;
+      ddsrt_free (hdr_of (b));
+    }
+    ddsrt_mutex_destroy (&dp->lock);
+  }
+}
+
+static void *heap_alloc (uint32_t cls, size_t size)
+{
+  union slab_hdr * const h = ddsrt_malloc (sizeof (*h) + size);
+  h->cls = cls;
+  return h + 1;
+}
+
+/* Moves up to want blocks from the depot into mag, returns a new block from the heap if the
+   depot is empty */
+static void *depot_get (uint32_t cls, struct slab_mag *mag, uint32_t want)
+{
+  struct slab_depot * const dp = &slab_depots[cls];
+  void *ptr;
+  ddsrt_mutex_lock (&dp->lock);
+  if (dp->first == NULL)
+  {
+    dp->nblocks++;
+    dp->nheap++;
+    ddsrt_mutex_unlock (&dp->lock);
+    return heap_alloc (cls, class_size (cls));
+  }
+  ptr = dp->first;
+  dp->first = dp->first->next;
+  dp->n--;
+  if (mag)
+  {
+    while (mag->n < want && dp->first != NULL)
+    {
+      mag->x[mag->n++] = dp->first;
+      dp->first = dp->first->next;
+      dp->n--;
+    }
+  }
+  ddsrt_mutex_unlock (&dp->lock);
+  return ptr;
+}
+
+/* Moves blocks xs[0 .. n-1] into the depot, anything that doesn't fit goes back to the heap */
+static void depot_put (uint32_t cls, void **xs, uint32_t n)
+{
+  struct slab_depot * const dp = &slab_depots[cls];
+  const uint32_t max = class_depotsize (cls);
+  uint32_t i = 0;
+  ddsrt_mutex_lock (&dp->lock);
+  for (; i < n && dp->n < max; i++)
+  {
+    struct slab_free * const b = xs[i];
+    b->next = dp->first;
+    dp->first = b;
+    dp->n++;
+  }
+  dp->nblocks -= n - i;
+  ddsrt_mutex_unlock (&dp->lock);
+  for (; i < n; i++)
+    ddsrt_free (hdr_of (xs[i]));
+}
+
+static void tcache_fini (void *varg)
+{
+  (void) varg;
+  struct slab_tcache * const tc = slab_tcache;
+  slab_tcache = NULL;
+  slab_tcache_gone = true;
+  if (tc == NULL || !ddsrt_atomic_ld32 (&slab_initialized) || slab_tcache_generation != ddsrt_atomic_ld32 (&slab_generation))
+    return;
+  ddsrt_mutex_lock (&slab_tcaches_lock);
+  if (tc->prev)
+    tc->prev->next = tc->next;
+  else
+    slab_tcaches = tc->next;
+  if (tc->next)
+    tc->next->prev = tc->prev;
+  ddsrt_mutex_unlock (&slab_tcaches_lock);
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+    depot_put (i, tc->mag[i].x, tc->mag[i].n);
+  ddsrt_free (tc);
+}
+
+static struct slab_tcache *tcache_get (void)
+{
+  if (slab_tcache_gone || !ddsrt_atomic_ld32 (&slab_initialized))
+    return NULL;
+  const uint32_t gen = ddsrt_atomic_ld32 (&slab_generation);
+  if (slab_tcache != NULL && slab_tcache_generation == gen)
+    return slab_tcache;
+  // either no cache yet, or one that has been freed by ddsrt_slab_fini
+  slab_tcache = NULL;
+  if (!slab_tcache_cleanup_pushed)
+  {
+    if (ddsrt_thread_cleanup_push (tcache_fini, NULL) != DDS_RETCODE_OK)
+      return NULL;
+    slab_tcache_cleanup_pushed = true;
+  }
+  struct slab_tcache *tc;
+  if ((tc = ddsrt_malloc_s (sizeof (*tc))) == NULL)
+    return NULL;
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+    tc->mag[i].n = 0;
+  ddsrt_mutex_lock (&slab_tcaches_lock);
+  tc->prev = NULL;
+  if ((tc->next = slab_tcaches) != NULL)
+    tc->next->prev = tc;
+  slab_tcaches = tc;
+  ddsrt_mutex_unlock (&slab_tcaches_lock);
+  slab_tcache = tc;
+  slab_tcache_generation = gen;
+  return tc;
+}
+
+void *ddsrt_slab_malloc (size_t size)
+{
+  const uint32_t cls = size_to_class (size);
+  struct slab_tcache *tc;
+  if (cls == SLAB_LARGE)
+    return heap_alloc (SLAB_LARGE, size);
+  else if ((tc = tcache_get ()) != NULL)
+  {
+    struct slab_mag * const mag = &tc->mag[cls];
+    if (mag->n > 0)
+      return mag->x[--mag->n];
+    return depot_get (cls, mag, class_magsize (cls) / 2);
+  }
+  else if (ddsrt_atomic_ld32 (&slab_initialized))
+    return depot_get (cls, NULL, 0);
+  else
+    return heap_alloc (cls, class_size (cls));
+}
+
+void ddsrt_slab_free (void *ptr)
+{
+  if (ptr == NULL)
+    return;
+  const uint32_t cls = hdr_of (ptr)->cls;
+  struct slab_tcache *tc;
+  assert (cls <= SLAB_LARGE);
+  if (cls == SLAB_LARGE)
+    ddsrt_free (hdr_of (ptr));
+  else if ((tc = tcache_get ()) != NULL)
+  {
+    struct slab_mag * const mag = &tc->mag[cls];
+    const uint32_t magsize = class_magsize (cls);
+    if (mag->n == magsize)
+    {
+      // keep the most recently freed ones, they're most likely still in the CPU cache
+      depot_put (cls, mag->x, magsize / 2);
+      memmove (mag->x, mag->x + magsize / 2, (magsize - magsize / 2) * sizeof (mag->x[0]));
+      mag->n = magsize - magsize / 2;
+    }
+    mag->x[mag->n++] = ptr;
+  }
+  else if (ddsrt_atomic_ld32 (&slab_initialized))
+    depot_put (cls, &ptr, 1);
+  else
+    ddsrt_free (hdr_of (ptr));
+}
+
+void *ddsrt_slab_realloc (void *ptr, size_t size)
+{
+  if (ptr == NULL)
+    return ddsrt_slab_malloc (size);
+  union slab_hdr * const h = hdr_of (ptr);
+  const uint32_t cls = h->cls;
+  const uint32_t ncls = size_to_class (size);
+  if (cls == SLAB_LARGE && ncls == SLAB_LARGE)
+  {
+    union slab_hdr * const nh = ddsrt_realloc (h, sizeof (*nh) + size);
+    return nh + 1;
+  }
+  else if (cls != SLAB_LARGE && ncls <= cls)
+  {
+    // shrinking to a smaller class isn't worth a copy
+    return ptr;
+  }
+  else
+  {
+    // cls < ncls (growing), or cls = SLAB_LARGE > ncls (shrinking a large block), and in the
+    // latter case there is no way of knowing the old size other than that it was larger
+    void * const nptr = ddsrt_slab_malloc (size);
+    memcpy (nptr, ptr, (cls == SLAB_LARGE) ? size : class_size (cls));
+    ddsrt_slab_free (ptr);
+    return nptr;
+  }
+}
+
+void ddsrt_slab_get_stats (ddsrt_slab_class_stats_t stats[DDSRT_SLAB_NCLASSES])
+{
+  const bool initialized = ddsrt_atomic_ld32 (&slab_initialized);
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+  {
+    struct slab_depot * const dp = &slab_depots[i];
+    stats[i].size = class_size (i);
+    if (!initialized)
+    {
+      stats[i].nblocks = stats[i].ndepot = 0;
+      stats[i].nheap = 0;
+      continue;
+    }
+    ddsrt_mutex_lock (&dp->lock);
+    stats[i].nblocks = dp->nblocks;
+    stats[i].ndepot = dp->n;
+    stats[i].nheap = dp->nheap;
+    ddsrt_mutex_unlock (&dp->lock);
+  }
+}
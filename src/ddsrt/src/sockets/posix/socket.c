@@ -8,6 +8,10 @@
 //
 // SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
 
+#if defined __linux__ && !defined _GNU_SOURCE
+#define _GNU_SOURCE /* for recvmmsg, sendmmsg */
+#endif
+
 #include <assert.h>
 #include <string.h>
 #include <unistd.h>
@@ -485,6 +489,32 @@ ddsrt_recvmsg(
   return recv_error_to_retcode(errno);
 }
 
+#if DDSRT_HAVE_RECVMMSG || DDSRT_HAVE_SENDMMSG
+DDSRT_STATIC_ASSERT (sizeof (ddsrt_mmsghdr_t) == sizeof (struct mmsghdr) &&
+                     offsetof (ddsrt_mmsghdr_t, msg_len) == offsetof (struct mmsghdr, msg_len));
+#endif
+
+#if DDSRT_HAVE_RECVMMSG
+dds_return_t
+ddsrt_recvmmsg(
+  const ddsrt_socket_ext_t *sockext,
+  ddsrt_mmsghdr_t *msgvec,
+  unsigned int vlen,
+  int flags,
+  int *nrcvd)
+{
+  int n;
+
+  if ((n = recvmmsg(sockext->sock, (struct mmsghdr *) msgvec, vlen, flags, NULL)) != -1) {
+    assert(n > 0 || vlen == 0);
+    *nrcvd = n;
+    return DDS_RETCODE_OK;
+  }
+
+  return recv_error_to_retcode(errno);
+}
+#endif
+
 static inline dds_return_t
 send_error_to_retcode(int errnum)
 {
@@ -566,6 +596,27 @@ ddsrt_sendmsg(
   return send_error_to_retcode(errno);
 }
 
+#if DDSRT_HAVE_SENDMMSG
+dds_return_t
+ddsrt_sendmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgvec,
+  unsigned int vlen,
+  int flags,
+  int *nsent)
+{
+  int n;
+
+  if ((n = sendmmsg(sock, (struct mmsghdr *) msgvec, vlen, flags)) != -1) {
+    assert(n > 0 || vlen == 0);
+    *nsent = n;
+    return DDS_RETCODE_OK;
+  }
+
+  return send_error_to_retcode(errno);
+}
+#endif
+
 dds_return_t
 ddsrt_select(
   int32_t nfds,
@@ -0,0 +1,221 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/bits.h"
+#include "dds/ddsrt/timerwheel.h"
+
+/* A timer with expiry tick E is kept at the level corresponding to the most significant
+   group of SLOT_BITS bits in which E differs from the current tick N, in the slot given by
+   the value of that group in E.  Because E > N, that slot is always after the slot of N
+   in that level, and it needs to be looked at again when N reaches the first tick of the
+   slot, at which point all groups above it are equal to those of E and the timer moves to
+   a lower level.  Timers for which E differs from N in bits above the top level are kept
+   in a separate "overflow" list that is re-inserted whenever the top level wraps around. */
+
+#define TW_SLOT_MASK ((uint64_t) DDSRT_TIMERWHEEL_SLOTS - 1)
+#define TW_NSLOTS (DDSRT_TIMERWHEEL_LEVELS * DDSRT_TIMERWHEEL_SLOTS)
+#define TW_OVERFLOW TW_NSLOTS
+#define TW_EXPIRED (TW_NSLOTS + 1)
+#define TW_TOP_BITS (DDSRT_TIMERWHEEL_LEVELS * DDSRT_TIMERWHEEL_SLOT_BITS)
+
+static uint32_t lowest_bit_set (uint64_t x)
+{
+  assert (x != 0);
+  const uint32_t lo = ddsrt_ffs32u ((uint32_t) x);
+  return (lo != 0) ? lo - 1 : ddsrt_ffs32u ((uint32_t) (x >> 32)) + 31;
+}
+
+static uint64_t tick_from_time_ceil (int64_t t)
+{
+  assert (t >= 0);
+  return ((uint64_t) t + ((UINT64_C (1) << DDSRT_TIMERWHEEL_TICK_BITS) - 1)) >> DDSRT_TIMERWHEEL_TICK_BITS;
+}
+
+static int64_t time_from_tick (uint64_t tick)
+{
+  if (tick >= ((uint64_t) INT64_MAX >> DDSRT_TIMERWHEEL_TICK_BITS))
+    return INT64_MAX;
+  return (int64_t) (tick << DDSRT_TIMERWHEEL_TICK_BITS);
+}
+
+void ddsrt_timerwheel_init (ddsrt_timerwheel_t *tw)
+{
+  tw->now = 0;
+  tw->count = 0;
+  memset (tw->occupied, 0, sizeof (tw->occupied));
+  tw->slots = NULL;
+}
+
+void ddsrt_timerwheel_fini (ddsrt_timerwheel_t *tw)
+{
+  assert (tw->count == 0);
+  ddsrt_free (tw->slots);
+}
+
+bool ddsrt_timerwheel_empty (const ddsrt_timerwheel_t *tw)
+{
+  return tw->count == 0;
+}
+
+static void push (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node, uint32_t slot)
+{
+  ddsrt_timerwheel_node_t **head = &tw->slots[slot];
+  node->slot = slot;
+  node->pprev = head;
+  if ((node->next = *head) != NULL)
+    node->next->pprev = &node->next;
+  *head = node;
+  if (slot < TW_NSLOTS)
+    tw->occupied[slot / DDSRT_TIMERWHEEL_SLOTS] |= UINT64_C (1) << (slot % DDSRT_TIMERWHEEL_SLOTS);
+}
+
+static void place (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node)
+{
+  if (node->tick <= tw->now)
+    push (tw, node, TW_EXPIRED);
+  else
+  {
+    const uint64_t diff = node->tick ^ tw->now;
+    uint32_t level = 0;
+    while (level < DDSRT_TIMERWHEEL_LEVELS && (diff >> ((level + 1) * DDSRT_TIMERWHEEL_SLOT_BITS)) != 0)
+      level++;
+    if (level == DDSRT_TIMERWHEEL_LEVELS)
+      push (tw, node, TW_OVERFLOW);
+    else
+    {
+      const uint32_t s = (uint32_t) ((node->tick >> (level * DDSRT_TIMERWHEEL_SLOT_BITS)) & TW_SLOT_MASK);
+      push (tw, node, level * DDSRT_TIMERWHEEL_SLOTS + s);
+    }
+  }
+}
+
+int64_t ddsrt_timerwheel_insert (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node, int64_t texp)
+{
+  if (tw->slots == NULL)
+    tw->slots = ddsrt_calloc (TW_NSLOTS + 2, sizeof (*tw->slots));
+  node->tick = tick_from_time_ceil (texp);
+  place (tw, node);
+  tw->count++;
+  return time_from_tick (node->tick);
+}
+
+void ddsrt_timerwheel_delete (ddsrt_timerwheel_t *tw, ddsrt_timerwheel_node_t *node)
+{
+  assert (tw->count > 0);
+  assert (node->slot <= TW_EXPIRED && *node->pprev == node);
+  if ((*node->pprev = node->next) != NULL)
+    node->next->pprev = node->pprev;
+  if (node->slot < TW_NSLOTS && tw->slots[node->slot] == NULL)
+    tw->occupied[node->slot / DDSRT_TIMERWHEEL_SLOTS] &= ~(UINT64_C (1) << (node->slot % DDSRT_TIMERWHEEL_SLOTS));
+  tw->count--;
+}
+
+static void replace_all (ddsrt_timerwheel_t *tw, uint32_t slot)
+{
+  ddsrt_timerwheel_node_t *node = tw->slots[slot];
+  tw->slots[slot] = NULL;
+  if (slot < TW_NSLOTS)
+    tw->occupied[slot / DDSRT_TIMERWHEEL_SLOTS] &= ~(UINT64_C (1) << (slot % DDSRT_TIMERWHEEL_SLOTS));
+  while (node)
+  {
+    ddsrt_timerwheel_node_t * const next = node->next;
+    place (tw, node);
+    node = next;
+  }
+}
+
+/* First tick after "now" at which something needs to happen: a slot in one of the
+   levels is reached or the top level wraps while there are timers in overflow;
+   UINT64_MAX if no such tick exists */
+static uint64_t next_event_tick (const ddsrt_timerwheel_t *tw)
+{
+  uint64_t t = UINT64_MAX;
+  for (uint32_t level = 0; level < DDSRT_TIMERWHEEL_LEVELS; level++)
+  {
+    if (tw->occupied[level] == 0)
+      continue;
+    const uint32_t shift = level * DDSRT_TIMERWHEEL_SLOT_BITS;
+    // occupied slots are always beyond the slot of "now" (see above)
+    const uint32_t s = lowest_bit_set (tw->occupied[level]);
+    assert (s > ((tw->now >> shift) & TW_SLOT_MASK));
+    const uint64_t base = (tw->now >> (shift + DDSRT_TIMERWHEEL_SLOT_BITS)) << (shift + DDSRT_TIMERWHEEL_SLOT_BITS);
+    const uint64_t c = base | ((uint64_t) s << shift);
+    if (c < t)
+      t = c;
+  }
+  if (tw->slots[TW_OVERFLOW] != NULL)
+  {
+    const uint64_t c = ((tw->now >> TW_TOP_BITS) + 1) << TW_TOP_BITS;
+    if (c < t)
+      t = c;
+  }
+  return t;
+}
+
+static void advance (ddsrt_timerwheel_t *tw, uint64_t target)
+{
+  while (tw->now < target)
+  {
+    const uint64_t c = next_event_tick (tw);
+    if (c > target)
+    {
+      tw->now = target;
+      break;
+    }
+    tw->now = c;
+    // the overflow list and higher levels first, so timers cascade all the way down
+    if ((c & ((UINT64_C (1) << TW_TOP_BITS) - 1)) == 0 && tw->slots[TW_OVERFLOW] != NULL)
+      replace_all (tw, TW_OVERFLOW);
+    for (uint32_t level = DDSRT_TIMERWHEEL_LEVELS; level-- > 0; )
+    {
+      const uint32_t shift = level * DDSRT_TIMERWHEEL_SLOT_BITS;
+      if ((c & ((UINT64_C (1) << shift) - 1)) != 0)
+        continue;
+      const uint32_t s = (uint32_t) ((c >> shift) & TW_SLOT_MASK);
+      if (tw->occupied[level] & (UINT64_C (1) << s))
+        replace_all (tw, level * DDSRT_TIMERWHEEL_SLOTS + s);
+    }
+  }
+}
+
+ddsrt_timerwheel_node_t *ddsrt_timerwheel_peek_expired (ddsrt_timerwheel_t *tw, int64_t tnow)
+{
+  if (tw->count == 0)
+    return NULL;
+  assert (tnow >= 0);
+  advance (tw, (uint64_t) tnow >> DDSRT_TIMERWHEEL_TICK_BITS);
+  return tw->slots[TW_EXPIRED];
+}
+
+ddsrt_timerwheel_node_t *ddsrt_timerwheel_extract_expired (ddsrt_timerwheel_t *tw, int64_t tnow)
+{
+  ddsrt_timerwheel_node_t *node;
+  if ((node = ddsrt_timerwheel_peek_expired (tw, tnow)) != NULL)
+    ddsrt_timerwheel_delete (tw, node);
+  return node;
+}
+
+int64_t ddsrt_timerwheel_next (const ddsrt_timerwheel_t *tw)
+{
+  if (tw->count == 0)
+    return INT64_MAX;
+  else if (tw->slots[TW_EXPIRED] != NULL)
+    return time_from_tick (tw->now);
+  else
+  {
+    const uint64_t c = next_event_tick (tw);
+    return (c == UINT64_MAX) ? INT64_MAX : time_from_tick (c);
+  }
+}
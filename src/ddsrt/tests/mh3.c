@@ -0,0 +1,62 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+#include "CUnit/Test.h"
+
+#include "dds/ddsrt/endian.h"
+#include "dds/ddsrt/mh3.h"
+
+static const char fox[] = "The quick brown fox jumps over the lazy dog";
+
+CU_Test(ddsrt_mh3, reference_32)
+{
+  CU_ASSERT_EQUAL (ddsrt_mh3 ("", 0, 0), 0);
+  CU_ASSERT_EQUAL (ddsrt_mh3 ("", 0, 1), 0x514e28b7);
+#if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN
+  CU_ASSERT_EQUAL (ddsrt_mh3 (fox, strlen (fox), 0), 0x2e4ff723);
+#endif
+}
+
+CU_Test(ddsrt_mh3, reference_128)
+{
+  uint64_t h[2];
+  ddsrt_mh3_128 ("", 0, 0, h);
+  CU_ASSERT_EQUAL (h[0], 0);
+  CU_ASSERT_EQUAL (h[1], 0);
+#if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN
+  ddsrt_mh3_128 (fox, strlen (fox), 0, h);
+  CU_ASSERT_EQUAL (h[0], UINT64_C (0xe34bbc7bbc071b6c));
+  CU_ASSERT_EQUAL (h[1], UINT64_C (0x7a433ca9c49a9347));
+#endif
+}
+
+CU_Test(ddsrt_mh3, alignment_and_length_128)
+{
+  // the hash must only depend on the contents, not on the alignment, and every
+  // length of tail must contribute to it
+  char buf[sizeof (fox) + 8];
+  uint64_t ref[2], h[2], prev[2] = { 0, 0 };
+  for (size_t len = 1; len < sizeof (fox); len++)
+  {
+    ddsrt_mh3_128 (fox, len, 42, ref);
+    CU_ASSERT (ref[0] != prev[0] || ref[1] != prev[1]);
+    for (size_t off = 1; off < 8; off++)
+    {
+      memcpy (buf + off, fox, len);
+      ddsrt_mh3_128 (buf + off, len, 42, h);
+      CU_ASSERT (h[0] == ref[0] && h[1] == ref[1]);
+    }
+    prev[0] = ref[0];
+    prev[1] = ref[1];
+  }
+  ddsrt_mh3_128 (fox, sizeof (fox) - 1, 43, h);
+  CU_ASSERT (h[0] != ref[0] || h[1] != ref[1]);
+}
@@ -0,0 +1,196 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <string.h>
+#include "CUnit/Test.h"
+
+#include "dds/ddsrt/cdtors.h"
+#include "dds/ddsrt/slab.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/threads.h"
+
+CU_Init(ddsrt_slab)
+{
+  ddsrt_init ();
+  return 0;
+}
+
+CU_Clean(ddsrt_slab)
+{
+  ddsrt_fini ();
+  return 0;
+}
+
+static uint64_t total_nheap (void)
+{
+  ddsrt_slab_class_stats_t stats[DDSRT_SLAB_NCLASSES];
+  uint64_t n = 0;
+  ddsrt_slab_get_stats (stats);
+  for (uint32_t i = 0; i < DDSRT_SLAB_NCLASSES; i++)
+    n += stats[i].nheap;
+  return n;
+}
+
+static void fill (unsigned char *p, size_t n, unsigned char seed)
+{
+  for (size_t i = 0; i < n; i++)
+    p[i] = (unsigned char) (seed + i);
+}
+
+static bool check (const unsigned char *p, size_t n, unsigned char seed)
+{
+  for (size_t i = 0; i < n; i++)
+    if (p[i] != (unsigned char) (seed + i))
+      return false;
+  return true;
+}
+
+CU_Test(ddsrt_slab, sizes)
+{
+  static const size_t sizes[] = {
+    0, 1, 63, 64, 65, 127, 128, 129, 1000, 4096, 4097,
+    DDSRT_SLAB_MAX_SIZE - 1, DDSRT_SLAB_MAX_SIZE, DDSRT_SLAB_MAX_SIZE + 1, 3 * DDSRT_SLAB_MAX_SIZE
+  };
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+  {
+    unsigned char *p = ddsrt_slab_malloc (sizes[i]);
+    CU_ASSERT_FATAL (p != NULL);
+    CU_ASSERT (((uintptr_t) p % 16) == 0);
+    fill (p, sizes[i], (unsigned char) i);
+    CU_ASSERT (check (p, sizes[i], (unsigned char) i));
+    ddsrt_slab_free (p);
+  }
+  ddsrt_slab_free (NULL);
+}
+
+CU_Test(ddsrt_slab, stats)
+{
+  ddsrt_slab_class_stats_t stats[DDSRT_SLAB_NCLASSES];
+  ddsrt_slab_get_stats (stats);
+  CU_ASSERT_EQUAL (stats[0].size, DDSRT_SLAB_MIN_SIZE);
+  CU_ASSERT_EQUAL (stats[DDSRT_SLAB_NCLASSES - 1].size, DDSRT_SLAB_MAX_SIZE);
+  const uint32_t nblocks0 = stats[2].nblocks;
+  const uint64_t nheap0 = stats[2].nheap;
+  void *p = ddsrt_slab_malloc (200);
+  ddsrt_slab_get_stats (stats);
+  CU_ASSERT (stats[2].nblocks >= nblocks0);
+  CU_ASSERT (stats[2].nheap >= nheap0);
+  // a freed block gets recycled without involving the heap
+  const uint64_t nheap1 = stats[2].nheap;
+  for (int i = 0; i < 1000; i++)
+  {
+    ddsrt_slab_free (p);
+    p = ddsrt_slab_malloc (256);
+  }
+  ddsrt_slab_free (p);
+  ddsrt_slab_get_stats (stats);
+  CU_ASSERT_EQUAL (stats[2].nheap, nheap1);
+}
+
+CU_Test(ddsrt_slab, realloc)
+{
+  unsigned char *p = ddsrt_slab_realloc (NULL, 10);
+  CU_ASSERT_FATAL (p != NULL);
+  fill (p, 10, 1);
+  size_t size = 10;
+  // grow through all classes and beyond, then shrink again
+  while (size <= 4 * DDSRT_SLAB_MAX_SIZE)
+  {
+    const size_t nsize = 2 * size + 7;
+    p = ddsrt_slab_realloc (p, nsize);
+    CU_ASSERT_FATAL (p != NULL);
+    CU_ASSERT_FATAL (check (p, size, 1));
+    fill (p, nsize, 1);
+    size = nsize;
+  }
+  while (size > 1)
+  {
+    const size_t nsize = size / 3;
+    p = ddsrt_slab_realloc (p, nsize);
+    CU_ASSERT_FATAL (p != NULL);
+    CU_ASSERT_FATAL (check (p, nsize, 1));
+    size = nsize;
+  }
+  // within a class, the block doesn't move
+  unsigned char *q = ddsrt_slab_realloc (p, 64);
+  CU_ASSERT (q == p);
+  ddsrt_slab_free (q);
+}
+
+#define XT_NBLOCKS 1000
+#define XT_ROUNDS 20
+
+struct xthread_arg {
+  ddsrt_mutex_t lock;
+  ddsrt_cond_t cond;
+  void *blocks[XT_NBLOCKS];
+  bool full;
+};
+
+static uint32_t xthread_free (void *varg)
+{
+  struct xthread_arg * const arg = varg;
+  ddsrt_mutex_lock (&arg->lock);
+  for (uint32_t r = 0; r < XT_ROUNDS; r++)
+  {
+    while (!arg->full)
+      ddsrt_cond_wait (&arg->cond, &arg->lock);
+    for (uint32_t i = 0; i < XT_NBLOCKS; i++)
+    {
+      CU_ASSERT (check (arg->blocks[i], 300, (unsigned char) i));
+      ddsrt_slab_free (arg->blocks[i]);
+    }
+    arg->full = false;
+    ddsrt_cond_broadcast (&arg->cond);
+  }
+  ddsrt_mutex_unlock (&arg->lock);
+  return 0;
+}
+
+CU_Test(ddsrt_slab, cross_thread)
+{
+  // blocks allocated in one thread and freed in another should flow back through
+  // the depot, and so once the pool is large enough (which takes a few rounds because
+  // of the blocks in the thread caches), no new blocks are needed
+  struct xthread_arg arg = { .full = false };
+  ddsrt_mutex_init (&arg.lock);
+  ddsrt_cond_init (&arg.cond);
+  ddsrt_threadattr_t attr;
+  ddsrt_thread_t tid;
+  ddsrt_threadattr_init (&attr);
+  dds_return_t rc = ddsrt_thread_create (&tid, "slabfree", &attr, xthread_free, &arg);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  uint64_t nheap_warm = 0;
+  ddsrt_mutex_lock (&arg.lock);
+  for (uint32_t r = 0; r < XT_ROUNDS; r++)
+  {
+    while (arg.full)
+      ddsrt_cond_wait (&arg.cond, &arg.lock);
+    if (r == XT_ROUNDS / 2)
+      nheap_warm = total_nheap ();
+    for (uint32_t i = 0; i < XT_NBLOCKS; i++)
+    {
+      arg.blocks[i] = ddsrt_slab_malloc (300);
+      CU_ASSERT_FATAL (arg.blocks[i] != NULL);
+      fill (arg.blocks[i], 300, (unsigned char) i);
+    }
+    arg.full = true;
+    ddsrt_cond_broadcast (&arg.cond);
+  }
+  while (arg.full)
+    ddsrt_cond_wait (&arg.cond, &arg.lock);
+  ddsrt_mutex_unlock (&arg.lock);
+  CU_ASSERT_EQUAL (total_nheap (), nheap_warm);
+  uint32_t res;
+  rc = ddsrt_thread_join (tid, &res);
+  CU_ASSERT_FATAL (rc == DDS_RETCODE_OK);
+  ddsrt_cond_destroy (&arg.cond);
+  ddsrt_mutex_destroy (&arg.lock);
+}
@@ -0,0 +1,145 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "CUnit/Test.h"
+
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/timerwheel.h"
+
+#define NTIMERS 1000
+#define TICK (INT64_C (1) << DDSRT_TIMERWHEEL_TICK_BITS)
+
+struct timer {
+  ddsrt_timerwheel_node_t node;
+  int64_t texp;
+  bool in_wheel;
+};
+
+static struct timer timers[NTIMERS];
+
+static struct timer *timer_from_node (ddsrt_timerwheel_node_t *node)
+{
+  return (struct timer *) ((char *) node - offsetof (struct timer, node));
+}
+
+// random time offset of widely varying magnitude, including ones beyond what the levels cover
+static int64_t random_delta (ddsrt_prng_t *prng)
+{
+  const uint32_t bits = ddsrt_prng_random (prng) % 56;
+  return (int64_t) (((uint64_t) ddsrt_prng_random (prng) << 32 | ddsrt_prng_random (prng)) & ((UINT64_C (1) << bits) - 1));
+}
+
+static void check_expired (ddsrt_timerwheel_t *tw, int64_t tnow)
+{
+  ddsrt_timerwheel_node_t *node;
+  while ((node = ddsrt_timerwheel_peek_expired (tw, tnow)) != NULL)
+  {
+    struct timer * const t = timer_from_node (node);
+    CU_ASSERT_FATAL (t->in_wheel);
+    // never early, and at most one tick late
+    CU_ASSERT_FATAL (t->texp <= tnow);
+    ddsrt_timerwheel_delete (tw, node);
+    t->in_wheel = false;
+  }
+  int64_t tmin = INT64_MAX;
+  for (int i = 0; i < NTIMERS; i++)
+  {
+    if (!timers[i].in_wheel)
+      continue;
+    CU_ASSERT_FATAL (timers[i].texp > tnow - TICK);
+    if (timers[i].texp < tmin)
+      tmin = timers[i].texp;
+  }
+  // the next time to look is never after the first timer expires (rounded up to a tick)
+  const int64_t tnext = ddsrt_timerwheel_next (tw);
+  CU_ASSERT_FATAL (tnext > tnow);
+  CU_ASSERT_FATAL (tmin == INT64_MAX || tnext < tmin + TICK);
+  CU_ASSERT_FATAL ((tmin == INT64_MAX) == ddsrt_timerwheel_empty (tw));
+}
+
+CU_Test (ddsrt_timerwheel, random)
+{
+  ddsrt_timerwheel_t tw;
+  ddsrt_prng_t prng;
+  ddsrt_prng_init_simple (&prng, 1234);
+  ddsrt_timerwheel_init (&tw);
+  int64_t tnow = 0;
+  for (int iter = 0; iter < 200000; iter++)
+  {
+    struct timer * const t = &timers[ddsrt_prng_random (&prng) % NTIMERS];
+    const uint32_t r = ddsrt_prng_random (&prng) % 100;
+    if (r < 50)
+    {
+      if (t->in_wheel)
+        ddsrt_timerwheel_delete (&tw, &t->node);
+      // occasionally in the past
+      t->texp = (r < 5) ? tnow - random_delta (&prng) % (tnow + 1) : tnow + random_delta (&prng);
+      const int64_t tdue = ddsrt_timerwheel_insert (&tw, &t->node, t->texp);
+      CU_ASSERT_FATAL (tdue >= t->texp && tdue < t->texp + TICK);
+      t->in_wheel = true;
+    }
+    else if (r < 70)
+    {
+      if (t->in_wheel)
+      {
+        ddsrt_timerwheel_delete (&tw, &t->node);
+        t->in_wheel = false;
+      }
+    }
+    else
+    {
+      // mostly small steps, sometimes jumping to the next timer, sometimes a big leap
+      if (r < 95)
+        tnow += random_delta (&prng) >> 20;
+      else if (r < 99)
+      {
+        const int64_t tnext = ddsrt_timerwheel_next (&tw);
+        if (tnext != INT64_MAX)
+          tnow = tnext;
+      }
+      else
+        tnow += random_delta (&prng);
+      check_expired (&tw, tnow);
+    }
+  }
+  tnow = INT64_MAX - 1;
+  check_expired (&tw, tnow);
+  for (int i = 0; i < NTIMERS; i++)
+    CU_ASSERT_FATAL (!timers[i].in_wheel);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_empty (&tw));
+  ddsrt_timerwheel_fini (&tw);
+}
+
+CU_Test (ddsrt_timerwheel, extract)
+{
+  ddsrt_timerwheel_t tw;
+  ddsrt_timerwheel_init (&tw);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_next (&tw) == INT64_MAX);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 0) == NULL);
+  const int64_t texp[] = { 3 * TICK, 1, 200 * TICK, 5000 * TICK + 1 };
+  for (int i = 0; i < 4; i++)
+  {
+    timers[i].texp = texp[i];
+    (void) ddsrt_timerwheel_insert (&tw, &timers[i].node, texp[i]);
+  }
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 0) == NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_next (&tw) == TICK);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, TICK) == &timers[1].node);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, TICK) == NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 3 * TICK - 1) == NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 3 * TICK) == &timers[0].node);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 10000 * TICK) != NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 10000 * TICK) != NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_extract_expired (&tw, 10000 * TICK) == NULL);
+  CU_ASSERT_FATAL (ddsrt_timerwheel_empty (&tw));
+  ddsrt_timerwheel_fini (&tw);
+}
@@ -25,6 +25,7 @@
 #include "idl/string.h"
 
 #include "libidlc__generator.h"
+#include "libidlc__serdes.h"
 #include "libidlc__descriptor.h"
 #include "hashid.h"
 #ifdef DDS_HAS_TYPELIB
@@ -2287,6 +2288,9 @@ static int print_flags(FILE *fp, struct descriptor *descriptor, bool type_info)
   if (fixed_size)
     vec[len++] = "DDS_TOPIC_FIXED_SIZE";
 
+  if (descriptor->flags & DDS_TOPIC_TYPE_SERDES)
+    vec[len++] = "DDS_TOPIC_TYPE_SERDES";
+
 #ifdef DDS_HAS_TYPELIB
   if (type_info)
     vec[len++] = "DDS_TOPIC_XTYPES_METADATA";
@@ -2369,6 +2373,11 @@ static int print_descriptor(FILE *fp, struct descriptor *descriptor, bool type_i
     }
   }
 
+  if (descriptor->flags & DDS_TOPIC_TYPE_SERDES) {
+    if (idl_fprintf(fp, ",\n  .m_funcs = &%1$s_cdrstream_funcs", type) < 0)
+      return -1;
+  }
+
   if (idl_fprintf(fp, "\n};\n\n") < 0)
     return -1;
 
@@ -2424,10 +2433,15 @@ static int print_cdrstream_descriptor(FILE *fp, struct descriptor *descriptor, u
   // a problem for our purpose and avoids making the output dependent on
   // platform-specific details (such as alignment)
   fmt = "  .opt_size_xcdr1 = 0,\n"
-        "  .opt_size_xcdr2 = 0\n"
-        "};\n\n";
+        "  .opt_size_xcdr2 = 0";
   if (idl_fprintf(fp, "%s", fmt) < 0)
     return -1;
+  if (descriptor->flags & DDS_TOPIC_TYPE_SERDES) {
+    if (idl_fprintf(fp, ",\n  .funcs = &%1$s_cdrstream_funcs", type) < 0)
+      return -1;
+  }
+  if (idl_fprintf(fp, "\n};\n\n") < 0)
+    return -1;
   return 0;
 }
 
@@ -2605,6 +2619,11 @@ generate_descriptor(
 
   if ((ret = generate_descriptor_impl(pstate, node, &descriptor)) < 0)
     goto err_gen;
+  bool type_serdes;
+  if ((ret = generate_serdes(pstate, generator, node, descriptor.n_keys, &type_serdes)) < 0)
+    goto err_print;
+  if (type_serdes)
+    descriptor.flags |= DDS_TOPIC_TYPE_SERDES;
   if (print_opcodes(generator->source.handle, &descriptor, &inst_count) < 0)
     { ret = IDL_RETCODE_NO_MEMORY; goto err_print; }
   if (print_keys(generator->source.handle, &descriptor, inst_count) < 0)
@@ -34,7 +34,12 @@ struct generator {
     char *export_macro;
     char *guard_macro;
     bool generate_cdrstream_desc;
+    bool generate_type_serdes;
   } config;
+  struct {
+    const void **types; /* structs for which serializers have been generated */
+    size_t count;
+  } serdes;
 };
 
 #endif /* GENERATOR_H */
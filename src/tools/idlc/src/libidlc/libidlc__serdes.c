@@ -0,0 +1,539 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "idl/heap.h"
+#include "idl/print.h"
+#include "idl/stream.h"
+#include "idl/string.h"
+#include "idl/processor.h"
+
+#include "libidlc__generator.h"
+#include "libidlc__serdes.h"
+
+/* The generated code covers the common case of final structs containing primitive
+   types, strings, arrays and sequences of primitive types and other such structs.
+   Everything else (other extensibility kinds, inheritance, optionals, unions, enums,
+   etc.) is left to the interpreter of the serializer instructions. The generated
+   functions use the inline functions from dds_cdrstream_gen.h, which are equivalent
+   to what the interpreter does for the same types. */
+
+enum serdes_kind {
+  SERDES_PRIM,
+  SERDES_BOOL,
+  SERDES_STRING,
+  SERDES_BSTRING,
+  SERDES_SEQ,
+  SERDES_STRUCT
+};
+
+struct serdes_member {
+  enum serdes_kind kind;
+  const char *name;
+  uint32_t size; /* size of (element) type, or bound + 1 for bounded strings */
+  uint32_t num; /* number of elements for arrays, 1 otherwise */
+  uint32_t bound; /* sequences: bound (0 if unbounded) */
+  bool is_bool; /* sequences: element type is boolean */
+  bool key; /* top-level key member */
+  const idl_struct_t *type; /* nested struct */
+};
+
+static uint32_t prim_size(const idl_type_spec_t *type_spec)
+{
+  switch (idl_type(type_spec)) {
+    case IDL_BOOL: case IDL_CHAR: case IDL_OCTET: case IDL_INT8: case IDL_UINT8:
+      return 1;
+    case IDL_SHORT: case IDL_USHORT: case IDL_INT16: case IDL_UINT16:
+      return 2;
+    case IDL_LONG: case IDL_ULONG: case IDL_INT32: case IDL_UINT32: case IDL_FLOAT:
+      return 4;
+    case IDL_LLONG: case IDL_ULLONG: case IDL_INT64: case IDL_UINT64: case IDL_DOUBLE:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+static bool is_supported_struct(const idl_struct_t *_struct);
+
+static bool
+get_member(const idl_member_t *member, const idl_declarator_t *declarator, struct serdes_member *m)
+{
+  const idl_type_spec_t *type_spec = idl_strip(member->type_spec, IDL_STRIP_ALIASES | IDL_STRIP_FORWARD);
+
+  memset(m, 0, sizeof(*m));
+  m->name = idl_identifier(declarator);
+  m->num = 1;
+  m->key = member->key.value;
+  if (member->optional.value || member->external.value || idl_is_alias(type_spec))
+    return false;
+  if (idl_is_array(declarator)) {
+    /* (multi-dimensional) arrays of primitives are serialized as a flat array */
+    if (!prim_size(type_spec))
+      return false;
+    m->num = idl_array_size(declarator);
+  }
+
+  if ((m->size = prim_size(type_spec)) != 0) {
+    m->kind = (idl_type(type_spec) == IDL_BOOL) ? SERDES_BOOL : SERDES_PRIM;
+  } else if (idl_is_string(type_spec)) {
+    m->kind = idl_is_bounded(type_spec) ? SERDES_BSTRING : SERDES_STRING;
+    m->size = idl_is_bounded(type_spec) ? idl_bound(type_spec) + 1 : 0;
+  } else if (idl_is_sequence(type_spec)) {
+    const idl_type_spec_t *elem_type = idl_strip(idl_type_spec(type_spec), IDL_STRIP_ALIASES | IDL_STRIP_FORWARD);
+    if (idl_is_alias(elem_type) || (m->size = prim_size(elem_type)) == 0)
+      return false;
+    m->kind = SERDES_SEQ;
+    m->bound = idl_bound(type_spec);
+    m->is_bool = (idl_type(elem_type) == IDL_BOOL);
+  } else if (idl_is_struct(type_spec)) {
+    m->kind = SERDES_STRUCT;
+    m->type = type_spec;
+    return is_supported_struct(m->type);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool is_supported_struct(const idl_struct_t *_struct)
+{
+  const idl_member_t *member;
+  const idl_declarator_t *declarator;
+  struct serdes_member m;
+
+  if (_struct->extensibility.value != IDL_FINAL || _struct->inherit_spec || _struct->keylist || idl_is_empty(_struct))
+    return false;
+  IDL_FOREACH(member, _struct->members) {
+    IDL_FOREACH(declarator, member->declarators) {
+      if (!get_member(member, declarator, &m))
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool is_generated(const struct generator *gen, const idl_struct_t *_struct)
+{
+  for (size_t i = 0; i < gen->serdes.count; i++)
+    if (gen->serdes.types[i] == _struct)
+      return true;
+  return false;
+}
+
+static idl_retcode_t add_generated(struct generator *gen, const idl_struct_t *_struct)
+{
+  const void **types;
+  if (!(types = idl_realloc(gen->serdes.types, (gen->serdes.count + 1) * sizeof(*types))))
+    return IDL_RETCODE_NO_MEMORY;
+  types[gen->serdes.count++] = _struct;
+  gen->serdes.types = types;
+  return IDL_RETCODE_OK;
+}
+
+struct serdes_iter {
+  const idl_member_t *member;
+  const idl_declarator_t *declarator;
+};
+
+/* iterate over the members of a supported struct, one per declarator */
+static bool next_member(const idl_struct_t *_struct, struct serdes_iter *it, struct serdes_member *m)
+{
+  if (it->member == NULL) {
+    it->member = _struct->members;
+    it->declarator = it->member->declarators;
+  } else if ((it->declarator = idl_next(it->declarator)) == NULL) {
+    if ((it->member = idl_next(it->member)) == NULL)
+      return false;
+    it->declarator = it->member->declarators;
+  }
+  (void)get_member(it->member, it->declarator, m);
+  return true;
+}
+
+/* the read and getsize functions for types that contain only primitives don't need all their parameters */
+static bool has_variable_size(const idl_struct_t *_struct)
+{
+  struct serdes_member m;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (m.kind != SERDES_PRIM && m.kind != SERDES_BOOL)
+      return true;
+  }
+  return false;
+}
+
+static int print_write(FILE *fp, const char *type, const idl_struct_t *_struct)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static bool %1$s_cdr_write (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const %1$s * __restrict sample)\n{\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    char *stype;
+    switch (m.kind) {
+      case SERDES_PRIM:
+        if (m.num == 1)
+          ret = idl_fprintf(fp, "  dds_stream_gen_write_prim (os, allocator, &sample->%s, %"PRIu32");\n", m.name, m.size);
+        else
+          ret = idl_fprintf(fp, "  dds_stream_gen_write_array (os, allocator, &sample->%s, %"PRIu32", %"PRIu32");\n", m.name, m.size, m.num);
+        break;
+      case SERDES_BOOL:
+        if (m.num == 1)
+          ret = idl_fprintf(fp, "  dds_stream_gen_write_bool (os, allocator, &sample->%s);\n", m.name);
+        else
+          ret = idl_fprintf(fp, "  dds_stream_gen_write_bool_array (os, allocator, &sample->%s, %"PRIu32");\n", m.name, m.num);
+        break;
+      case SERDES_STRING: case SERDES_BSTRING:
+        ret = idl_fprintf(fp, "  dds_stream_gen_write_string (os, allocator, sample->%s);\n", m.name);
+        break;
+      case SERDES_SEQ:
+        fmt = "  if (!dds_stream_gen_write_seq (os, allocator, (const dds_sequence_t *) &sample->%s, %"PRIu32", %"PRIu32", %s))\n    return false;\n";
+        ret = idl_fprintf(fp, fmt, m.name, m.size, m.bound, m.is_bool ? "true" : "false");
+        break;
+      case SERDES_STRUCT:
+        if (IDL_PRINTA(&stype, print_type, m.type) < 0)
+          return -1;
+        ret = idl_fprintf(fp, "  if (!%s_cdr_write (os, allocator, &sample->%s))\n    return false;\n", stype, m.name);
+        break;
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "  return true;\n}\n\n");
+}
+
+static int print_read(FILE *fp, const char *type, const idl_struct_t *_struct)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static void %1$s_cdr_read (dds_istream_t * __restrict is, %1$s * __restrict sample, const struct dds_cdrstream_allocator * __restrict allocator)\n{\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  if (!has_variable_size(_struct) && idl_fprintf(fp, "  (void) allocator;\n") < 0)
+    return -1;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    char *stype;
+    switch (m.kind) {
+      case SERDES_PRIM: case SERDES_BOOL:
+        if (m.num == 1)
+          ret = idl_fprintf(fp, "  dds_stream_gen_read_prim (is, &sample->%s, %"PRIu32");\n", m.name, m.size);
+        else
+          ret = idl_fprintf(fp, "  dds_stream_gen_read_array (is, &sample->%s, %"PRIu32", %"PRIu32");\n", m.name, m.size, m.num);
+        break;
+      case SERDES_STRING:
+        ret = idl_fprintf(fp, "  sample->%1$s = dds_stream_gen_read_string (is, sample->%1$s, allocator);\n", m.name);
+        break;
+      case SERDES_BSTRING:
+        ret = idl_fprintf(fp, "  dds_stream_gen_read_bstring (is, sample->%s, %"PRIu32");\n", m.name, m.size);
+        break;
+      case SERDES_SEQ:
+        ret = idl_fprintf(fp, "  dds_stream_gen_read_seq (is, (dds_sequence_t *) &sample->%s, allocator, %"PRIu32");\n", m.name, m.size);
+        break;
+      case SERDES_STRUCT:
+        if (IDL_PRINTA(&stype, print_type, m.type) < 0)
+          return -1;
+        ret = idl_fprintf(fp, "  %s_cdr_read (is, &sample->%s, allocator);\n", stype, m.name);
+        break;
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "}\n\n");
+}
+
+static int print_normalize(FILE *fp, const char *type, const idl_struct_t *_struct)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static bool %1$s_cdr_normalize (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t xcdr_version)\n{\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    char *stype;
+    switch (m.kind) {
+      case SERDES_PRIM:
+        fmt = "  if (!dds_stream_gen_normalize_array (data, off, size, bswap, xcdr_version, %"PRIu32", %"PRIu32"))\n    return false;\n";
+        ret = idl_fprintf(fp, fmt, m.size, m.num);
+        break;
+      case SERDES_BOOL:
+        ret = idl_fprintf(fp, "  if (!dds_stream_gen_normalize_bool_array (data, off, size, %"PRIu32"))\n    return false;\n", m.num);
+        break;
+      case SERDES_STRING:
+        ret = idl_fprintf(fp, "  if (!dds_stream_gen_normalize_string (data, off, size, bswap, UINT32_MAX))\n    return false;\n");
+        break;
+      case SERDES_BSTRING:
+        ret = idl_fprintf(fp, "  if (!dds_stream_gen_normalize_string (data, off, size, bswap, %"PRIu32"))\n    return false;\n", m.size);
+        break;
+      case SERDES_SEQ:
+        fmt = "  if (!dds_stream_gen_normalize_seq (data, off, size, bswap, xcdr_version, %"PRIu32", %"PRIu32", %s))\n    return false;\n";
+        ret = idl_fprintf(fp, fmt, m.size, m.bound, m.is_bool ? "true" : "false");
+        break;
+      case SERDES_STRUCT:
+        if (IDL_PRINTA(&stype, print_type, m.type) < 0)
+          return -1;
+        ret = idl_fprintf(fp, "  if (!%s_cdr_normalize (data, off, size, bswap, xcdr_version))\n    return false;\n", stype);
+        break;
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "  return true;\n}\n\n");
+}
+
+static int print_getsize(FILE *fp, const char *type, const idl_struct_t *_struct)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static void %1$s_cdr_getsize (const %1$s * __restrict sample, size_t * __restrict pos, uint32_t xcdr_version)\n{\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  if (!has_variable_size(_struct) && idl_fprintf(fp, "  (void) sample;\n") < 0)
+    return -1;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    char *stype;
+    switch (m.kind) {
+      case SERDES_PRIM: case SERDES_BOOL:
+        ret = idl_fprintf(fp, "  dds_stream_gen_getsize (pos, xcdr_version, %"PRIu32", %"PRIu32");\n", m.size, m.num);
+        break;
+      case SERDES_STRING: case SERDES_BSTRING:
+        ret = idl_fprintf(fp, "  dds_stream_gen_getsize_string (pos, xcdr_version, sample->%s);\n", m.name);
+        break;
+      case SERDES_SEQ:
+        ret = idl_fprintf(fp, "  dds_stream_gen_getsize_seq (pos, xcdr_version, (const dds_sequence_t *) &sample->%s, %"PRIu32");\n", m.name, m.size);
+        break;
+      case SERDES_STRUCT:
+        if (IDL_PRINTA(&stype, print_type, m.type) < 0)
+          return -1;
+        ret = idl_fprintf(fp, "  %s_cdr_getsize (&sample->%s, pos, xcdr_version);\n", stype, m.name);
+        break;
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "}\n\n");
+}
+
+static idl_retcode_t
+generate_struct_serdes(struct generator *gen, const idl_struct_t *_struct)
+{
+  idl_retcode_t ret;
+  FILE *fp = gen->source.handle;
+  struct serdes_member m;
+  char *type;
+
+  if (is_generated(gen, _struct))
+    return IDL_RETCODE_OK;
+
+  /* nested types first, so that no forward declarations are needed */
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (m.kind == SERDES_STRUCT && (ret = generate_struct_serdes(gen, m.type)) != IDL_RETCODE_OK)
+      return ret;
+  }
+
+  if (IDL_PRINTA(&type, print_type, _struct) < 0)
+    return IDL_RETCODE_NO_MEMORY;
+  if (print_write(fp, type, _struct) < 0 ||
+      print_read(fp, type, _struct) < 0 ||
+      print_normalize(fp, type, _struct) < 0 ||
+      print_getsize(fp, type, _struct) < 0)
+    return IDL_RETCODE_NO_MEMORY;
+  return add_generated(gen, _struct);
+}
+
+/* Keys are only handled in the generated code if all of them are top-level members
+   of a primitive or string type, otherwise the interpreter is used for the key */
+static bool
+get_keys(const idl_struct_t *_struct, uint32_t n_keys)
+{
+  struct serdes_member m;
+  uint32_t n = 0;
+  bool ok = true;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (m.key) {
+      n++;
+      if (m.num != 1 || (m.kind != SERDES_PRIM && m.kind != SERDES_BOOL && m.kind != SERDES_STRING && m.kind != SERDES_BSTRING))
+        ok = false;
+    }
+  }
+  return ok && n == n_keys && n > 0;
+}
+
+static int print_write_key(FILE *fp, const char *type, const idl_struct_t *_struct)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static bool %1$s_cdrstream_write_key (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict data)\n"
+        "{\n"
+        "  const %1$s *sample = data;\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (!m.key)
+      continue;
+    switch (m.kind) {
+      case SERDES_PRIM:
+        ret = idl_fprintf(fp, "  dds_stream_gen_write_prim (os, allocator, &sample->%s, %"PRIu32");\n", m.name, m.size);
+        break;
+      case SERDES_BOOL:
+        ret = idl_fprintf(fp, "  dds_stream_gen_write_bool (os, allocator, &sample->%s);\n", m.name);
+        break;
+      case SERDES_STRING: case SERDES_BSTRING:
+        ret = idl_fprintf(fp, "  dds_stream_gen_write_string (os, allocator, sample->%s);\n", m.name);
+        break;
+      default:
+        abort();
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "  return true;\n}\n\n");
+}
+
+static int print_skip(FILE *fp, const idl_struct_t *_struct);
+
+static int print_skip_member(FILE *fp, const struct serdes_member *m)
+{
+  switch (m->kind) {
+    case SERDES_PRIM: case SERDES_BOOL:
+      return idl_fprintf(fp, "  dds_stream_gen_skip (is, %"PRIu32", %"PRIu32");\n", m->size, m->num);
+    case SERDES_STRING: case SERDES_BSTRING:
+      return idl_fprintf(fp, "  dds_stream_gen_skip_string (is);\n");
+    case SERDES_SEQ:
+      return idl_fprintf(fp, "  dds_stream_gen_skip_seq (is, %"PRIu32");\n", m->size);
+    case SERDES_STRUCT:
+      return print_skip(fp, m->type);
+  }
+  return -1;
+}
+
+static int print_skip(FILE *fp, const idl_struct_t *_struct)
+{
+  struct serdes_member m;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (print_skip_member(fp, &m) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+static int print_extract_key(FILE *fp, const char *type, const idl_struct_t *_struct, uint32_t n_keys)
+{
+  const char *fmt;
+  struct serdes_member m;
+  fmt = "static bool %1$s_cdrstream_extract_key_from_data (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator)\n{\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  /* the input is discarded afterwards, so there is no need to read beyond the last key */
+  uint32_t n = 0;
+  int ret = 0;
+  for (struct serdes_iter it = { NULL, NULL }; next_member(_struct, &it, &m); ) {
+    if (n == n_keys)
+      break;
+    if (!m.key) {
+      ret = print_skip_member(fp, &m);
+    } else {
+      n++;
+      if (m.kind == SERDES_STRING || m.kind == SERDES_BSTRING)
+        ret = idl_fprintf(fp, "  dds_stream_gen_copy_string (is, os, allocator);\n");
+      else
+        ret = idl_fprintf(fp, "  dds_stream_gen_copy_prim (is, os, allocator, %"PRIu32");\n", m.size);
+    }
+    if (ret < 0)
+      return -1;
+  }
+  return idl_fprintf(fp, "  return true;\n}\n\n");
+}
+
+static int print_funcs(FILE *fp, const char *type, bool keys)
+{
+  const char *fmt;
+  fmt = "static bool %1$s_cdrstream_write_sample (dds_ostream_t * __restrict os, const struct dds_cdrstream_allocator * __restrict allocator, const void * __restrict data)\n"
+        "{\n"
+        "  return %1$s_cdr_write (os, allocator, data);\n"
+        "}\n\n"
+        "static void %1$s_cdrstream_read_sample (dds_istream_t * __restrict is, void * __restrict data, const struct dds_cdrstream_allocator * __restrict allocator)\n"
+        "{\n"
+        "  %1$s_cdr_read (is, data, allocator);\n"
+        "}\n\n"
+        "static bool %1$s_cdrstream_normalize (void * __restrict data, uint32_t size, bool bswap, uint32_t xcdr_version, uint32_t * __restrict actual_size)\n"
+        "{\n"
+        "  uint32_t off = 0;\n"
+        "  if (!%1$s_cdr_normalize (data, &off, size, bswap, xcdr_version))\n"
+        "    return false;\n"
+        "  *actual_size = off;\n"
+        "  return true;\n"
+        "}\n\n"
+        "static size_t %1$s_cdrstream_getsize_sample (const void * __restrict data, uint32_t xcdr_version)\n"
+        "{\n"
+        "  size_t pos = 0;\n"
+        "  %1$s_cdr_getsize (data, &pos, xcdr_version);\n"
+        "  return pos;\n"
+        "}\n\n"
+        "static const struct dds_cdrstream_funcs %1$s_cdrstream_funcs =\n"
+        "{\n"
+        "  .write_sample = %1$s_cdrstream_write_sample,\n"
+        "  .read_sample = %1$s_cdrstream_read_sample,\n"
+        "  .normalize = %1$s_cdrstream_normalize,\n"
+        "  .getsize_sample = %1$s_cdrstream_getsize_sample,\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  if (keys)
+    fmt = "  .write_key = %1$s_cdrstream_write_key,\n"
+          "  .extract_key_from_data = %1$s_cdrstream_extract_key_from_data\n"
+          "};\n\n";
+  else
+    fmt = "  .write_key = 0,\n"
+          "  .extract_key_from_data = 0\n"
+          "};\n\n";
+  return idl_fprintf(fp, fmt, type);
+}
+
+idl_retcode_t
+generate_serdes(
+  const idl_pstate_t *pstate,
+  struct generator *generator,
+  const idl_node_t *node,
+  uint32_t n_keys,
+  bool *generated)
+{
+  idl_retcode_t ret;
+  const idl_struct_t *_struct = (const idl_struct_t *)node;
+  FILE *fp = generator->source.handle;
+  char *type;
+
+  (void)pstate;
+  *generated = false;
+  if (!generator->config.generate_type_serdes || !idl_is_struct(node) || !is_supported_struct(_struct))
+    return IDL_RETCODE_OK;
+  if ((ret = generate_struct_serdes(generator, _struct)) != IDL_RETCODE_OK)
+    return ret;
+
+  if (IDL_PRINTA(&type, print_type, node) < 0)
+    return IDL_RETCODE_NO_MEMORY;
+  const bool keys = get_keys(_struct, n_keys);
+  if (keys && (print_write_key(fp, type, _struct) < 0 || print_extract_key(fp, type, _struct, n_keys) < 0))
+    return IDL_RETCODE_NO_MEMORY;
+  if (print_funcs(fp, type, keys) < 0)
+    return IDL_RETCODE_NO_MEMORY;
+  *generated = true;
+  return IDL_RETCODE_OK;
+}
@@ -0,0 +1,33 @@
+// Copyright(c) 2024 ZettaScale Technology and others
+//
+// This program and the accompanying materials are made available under the
+// terms of the Eclipse Public License v. 2.0 which is available at
+// http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+// v. 1.0 which is available at
+// http://www.eclipse.org/org/documents/edl-v10.php.
+//
+// SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+
+#ifndef SERDES_H
+#define SERDES_H
+
+#include <stdbool.h>
+#include "idl/processor.h"
+
+struct generator;
+
+/* Generates type-specific serialization functions for a topic type in the
+   source file, in the form of a "struct dds_cdrstream_funcs" named
+   <type>_cdrstream_funcs, if the type (including all nested types) can be
+   handled by the generated code. Sets "generated" to indicate whether this
+   was the case, types that can't be handled are left to the interpreter of
+   the serializer instructions. */
+idl_retcode_t
+generate_serdes(
+  const idl_pstate_t *pstate,
+  struct generator *generator,
+  const idl_node_t *node,
+  uint32_t n_keys,
+  bool *generated);
+
+#endif /* SERDES_H */